@@ -92,6 +92,10 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 // Link types
 #define INVALID -1
 
+// Next hop and path length from one node toward another (see acebot_nodes.c)
+#define PATH_TABLE(from,to) path_table[(from) * path_size + (to)]
+#define COST_TABLE(from,to) cost_table[(from) * path_size + (to)]
+
 // Node types
 #define NODE_MOVE 0
 #define NODE_LADDER 1
@@ -284,6 +288,9 @@ extern edict_t *players[MAX_CLIENTS];		// pointers to all players in the game
 
 // extern decs
 extern node_t nodes[MAX_NODES]; 
+extern int16_t *path_table;
+extern int16_t *cost_table;
+extern int path_size;
 extern item_table_t item_table[MAX_NODES]; // was MAX_EDICTS
 extern qboolean debug_mode;
 extern int numnodes;
@@ -306,11 +313,19 @@ void     ACEAI_PickLongRangeGoal(edict_t *self);
 void     ACEAI_PickShortRangeGoal(edict_t *self);
 qboolean ACEAI_FindEnemy(edict_t *self);
 void     ACEAI_ChooseWeapon(edict_t *self);
+void     ACEAI_InitWeaponPicks(void);
+extern cvar_t *ace_think_budget;
 
 // acebot_cmds.c protos
 qboolean ACECM_Commands(edict_t *ent);
 void     ACECM_Store();
 
+// acebot_compress.c protos
+int      Encode(char *filename, uint8_t *buffer, int bufsize, int version);
+int      Decode(char *filename, uint8_t *buffer, int bufsize);
+int      EncodeBuffer(uint8_t *buffer, int bufsize, uint8_t *out, int outsize);
+int      DecodeBuffer(uint8_t *in, int insize, uint8_t *buffer, int bufsize);
+
 // acebot_items.c protos
 void     ACEIT_PlayerAdded(edict_t *ent);
 void     ACEIT_PlayerRemoved(edict_t *ent);
@@ -320,6 +335,9 @@ qboolean ACEIT_ChangeWeapon (edict_t *ent, gitem_t *item);
 qboolean ACEIT_CanUseArmor (gitem_t *item, edict_t *other);
 float	 ACEIT_ItemNeed(edict_t *self, int item);
 int		 ACEIT_ClassnameToIndex(char *classname);
+void     ACEIT_ItemTaken(edict_t *ent, float delay);
+void     ACEIT_ItemRespawned(edict_t *ent);
+float    ACEIT_ItemRespawnWait(int slot);
 void     ACEIT_BuildItemNodeTable (qboolean rebuild);
 
 // acebot_movement.c protos
@@ -327,6 +345,7 @@ qboolean ACEMV_SpecialMove(edict_t *self,usercmd_t *ucmd);
 void     ACEMV_Move(edict_t *self, usercmd_t *ucmd);
 void     ACEMV_Attack (edict_t *self, usercmd_t *ucmd);
 void     ACEMV_Wander (edict_t *self, usercmd_t *ucmd);
+void     ACEMV_InitProbes(void);
 
 // acebot_nodes.c protos
 int      ACEND_FindCost(int from, int to);
@@ -338,15 +357,30 @@ void     ACEND_GrapFired(edict_t *self);
 qboolean ACEND_CheckForLadder(edict_t *self);
 void     ACEND_PathMap(edict_t *self);
 void     ACEND_InitNodes(void);
+void     ACEND_InitPathTable(void);
+void     ACEND_GrowPathTable(int count);
 void     ACEND_ShowNode(int node);
 void     ACEND_DrawPath();
 void     ACEND_ShowPath(edict_t *self, int goal_node);
 int      ACEND_AddNode(edict_t *self, int type);
 void     ACEND_UpdateNodeEdge(int from, int to);
+void     ACEND_QueueNodeEdge(int from, int to);
+void     ACEND_FoldLinks(int count);
+void     ACEND_ClearLinkQueue(void);
 void     ACEND_RemoveNodeEdge(edict_t *self, int from, int to);
 void     ACEND_ResolveAllPaths();
 void     ACEND_SaveNodes();
+void     ACEND_WaitForNodeSave(char *filename);
 void     ACEND_LoadNodes();
+void     ACEND_ResetNodeGrid(void);
+qboolean ACEND_TraceBudgetLeft(void);
+extern cvar_t *ace_compress_nodes;
+extern cvar_t *ace_map_nodes;
+extern cvar_t *ace_trace_budget;
+extern cvar_t *ace_link_budget;
+
+// acebot_navgen.c protos
+void     ACEND_GenerateNodes(void);
 
 // acebot_spawn.c protos
 //void	 ACESP_SaveBots(); // Knightmare- removed this
@@ -357,9 +391,12 @@ void     ACESP_PutClientInServer (edict_t *bot, qboolean respawn, int team);
 void     ACESP_Respawn (edict_t *self);
 edict_t *ACESP_FindFreeClient (void);
 void     ACESP_SetName(edict_t *bot, char *name, char *skin, char *team);
-void     ACESP_SpawnBot (char *team, char *name, char *skin, char *userinfo);
+edict_t *ACESP_SpawnBot (char *team, char *name, char *skin, char *userinfo);
 void     ACESP_ReAddBots();
 void     ACESP_RemoveBot(char *name);
+void     ACESP_AutoFill(void);
+extern cvar_t *ace_autofill;
+extern cvar_t *ace_autofill_msec;
 void	 safe_cprintf (edict_t *ent, int printlevel, char *fmt, ...);
 void     safe_centerprintf (edict_t *ent, char *fmt, ...);
 void     safe_bprintf (int printlevel, char *fmt, ...);
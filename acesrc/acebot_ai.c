@@ -82,19 +82,78 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "acebot.h"
 
+#define ITEM_WEIGHTS 101	// item types ACEIT_ItemNeed knows about
+
+cvar_t *ace_think_budget;
+
+static int think_framenum = -1;	// frame think_count is for
+static int think_count;			// bots that made decisions this frame
+
+///////////////////////////////////////////////////////////////////////
+// Goal selection and the enemy scan are the expensive part of a
+// think. At most ace_think_budget bots make those decisions each
+// frame, and each bot waits at least num_players / budget frames
+// between them, so the bots take turns. This keeps a server full of
+// bots that respawned together from doing everything in one frame.
+// 0 lets every bot decide every frame.
+///////////////////////////////////////////////////////////////////////
+static qboolean ACEAI_DecisionTurn(edict_t *self)
+{
+	int budget, interval;
+
+	if (!ace_think_budget || ace_think_budget->value <= 0)
+		return true;
+
+	if (think_framenum != level.framenum)
+	{
+		think_framenum = level.framenum;
+		think_count = 0;
+	}
+
+	budget = ace_think_budget->value;
+	if (think_count >= budget)
+		return false;
+
+	interval = (num_players + budget - 1) / budget;
+
+	// think_frame from an earlier map is ahead of level.framenum
+	if (self->think_frame <= level.framenum && level.framenum - self->think_frame < interval)
+		return false;
+
+	think_count++;
+	self->think_frame = level.framenum;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Is a target picked on an earlier frame still worth keeping
+///////////////////////////////////////////////////////////////////////
+static qboolean ACEAI_KeepTarget(edict_t *target)
+{
+	return (target && target->inuse && target->solid != SOLID_NOT && !target->deadflag);
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Main Think function for bot
 ///////////////////////////////////////////////////////////////////////
 void ACEAI_Think (edict_t *self)
 {
 	usercmd_t	ucmd;
+	qboolean	decide;
+
+	Prof_Begin (PROF_BOTTHINK);
 
 	// Set up client movement
 	VectorCopy(self->client->ps.viewangles,self->s.angles);
 	VectorSet (self->client->ps.pmove.delta_angles, 0, 0, 0);
 	memset (&ucmd, 0, sizeof (ucmd));
-	self->enemy = NULL;
-	self->movetarget = NULL;
+
+	// between decisions, steer on the targets picked last time
+	decide = ACEAI_DecisionTurn(self);
+	if (decide || !ACEAI_KeepTarget(self->enemy))
+		self->enemy = NULL;
+	if (decide || !ACEAI_KeepTarget(self->movetarget))
+		self->movetarget = NULL;
 	
 	// Force respawn 
 	if (self->deadflag)
@@ -103,8 +162,10 @@ void ACEAI_Think (edict_t *self)
 		ucmd.buttons = BUTTON_ATTACK;
 	}
 	
-	if(self->state == STATE_WANDER && self->wander_timeout < level.time)
-	  ACEAI_PickLongRangeGoal(self); // pick a new long range goal
+	// pick a new long range goal, or wait a frame if the node traces
+	// for this frame are used up
+	if(decide && self->state == STATE_WANDER && self->wander_timeout < level.time && ACEND_TraceBudgetLeft())
+	  ACEAI_PickLongRangeGoal(self);
 
 	// Kill the bot if completely stuck somewhere
 	if(VectorLength(self->velocity) > 37) //
@@ -117,12 +178,14 @@ void ACEAI_Think (edict_t *self)
 	}
 	
 	// Find any short range goal
-	ACEAI_PickShortRangeGoal(self);
+	if(decide)
+		ACEAI_PickShortRangeGoal(self);
 	
 	// Look for enemies
-	if(ACEAI_FindEnemy(self))
+	if(decide ? ACEAI_FindEnemy(self) : self->enemy != NULL)
 	{	
-		ACEAI_ChooseWeapon(self);
+		if(decide)
+			ACEAI_ChooseWeapon(self);
 		ACEMV_Attack (self, &ucmd);
 	}
 	else
@@ -151,8 +214,56 @@ void ACEAI_Think (edict_t *self)
 	ClientThink (self, &ucmd);
 	
 	self->nextthink = level.time + FRAMETIME;
+
+	Prof_End (PROF_BOTTHINK);
 }
 
+///////////////////////////////////////////////////////////////////////
+// How much the bot wants an item of this type, before the random
+// variation and the cost of getting there. Only depends on the type,
+// the bot's team and its inventory.
+///////////////////////////////////////////////////////////////////////
+static float ACEAI_ItemWeight(edict_t *self, int item)
+{
+	float weight;
+
+	weight = ACEIT_ItemNeed(self, item);
+
+	// If I am on team one and I have the flag for the other team....return it
+	// Knightmare- rewrote for 3Team CTF
+	//if (ctf->value && (item == ITEMLIST_FLAG2 || item == ITEMLIST_FLAG1) &&
+	//	(self->client->resp.ctf_team == CTF_TEAM1 && self->client->pers.inventory[ITEMLIST_FLAG2] ||
+	//	self->client->resp.ctf_team == CTF_TEAM2 && self->client->pers.inventory[ITEMLIST_FLAG1]))
+	if (ctf->value && (
+			(item == ITEMLIST_FLAG1 && self->client->resp.ctf_team == CTF_TEAM1 &&
+				(self->client->pers.inventory[ITEMLIST_FLAG2] || self->client->pers.inventory[ITEMLIST_FLAG3]) )
+			|| (item == ITEMLIST_FLAG2 && self->client->resp.ctf_team == CTF_TEAM2 &&
+				(self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG3]) )
+			|| (item == ITEMLIST_FLAG3 && self->client->resp.ctf_team == CTF_TEAM3 &&
+				(self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG2]) )
+		))
+		weight = 10.0;
+
+	// Knightmare- in 3Team CTF mode, make double captures a lower priority than
+	// getting back to base with the flag we already have.
+	if (ttctf->value && (
+		(self->client->resp.ctf_team == CTF_TEAM1
+			&& (self->client->pers.inventory[ITEMLIST_FLAG2] || self->client->pers.inventory[ITEMLIST_FLAG3])
+			&& (item == ITEMLIST_FLAG2 || item == ITEMLIST_FLAG3) )
+		|| (self->client->resp.ctf_team == CTF_TEAM2
+			&& (self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG3])
+			&& (item == ITEMLIST_FLAG1 || item == ITEMLIST_FLAG3) )
+		|| (self->client->resp.ctf_team == CTF_TEAM3
+			&& (self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG2])
+			&& (item == ITEMLIST_FLAG1 || item == ITEMLIST_FLAG2) )
+		))
+		weight = 6.5;
+
+	return weight;
+}
+
+#define ACE_ITEM_TIMING 2.0 // go for items due back within this many seconds
+
 ///////////////////////////////////////////////////////////////////////
 // Evaluate the best long range goal and send the bot on
 // its way. This is a good time waster, so use it sparingly. 
@@ -166,7 +277,11 @@ void ACEAI_PickLongRangeGoal(edict_t *self)
 	float weight,best_weight=0.0;
 	int current_node,goal_node;
 	edict_t *goal_ent;
-	float cost;
+	float cost, wait;
+	int item;
+	int16_t *cost_row;
+	float item_weight[ITEM_WEIGHTS];
+	qboolean weight_known[ITEM_WEIGHTS];
 	
 	// look for a target 
 	current_node = ACEND_FindClosestReachableNode(self,NODE_DENSITY,NODE_ALL);
@@ -184,56 +299,45 @@ void ACEAI_PickLongRangeGoal(edict_t *self)
 	///////////////////////////////////////////////////////
 	// Items
 	///////////////////////////////////////////////////////
+	// Many items share a type, so each type's weight is only worked
+	// out once per pick. The costs come straight from the node's row
+	// of cost_table, which is kept up to date with path_table.
+	memset(weight_known, 0, sizeof(weight_known));
+	cost_row = &COST_TABLE(current_node,0);
+
 	for (i=0; i<num_items; i++)
 	{
-		// ignore items that are not there.
-		if (!item_table[i].ent || !item_table[i].ent->inuse || item_table[i].ent->solid == SOLID_NOT)
+		// ignore items that are not there, unless they are about to be
+		wait = ACEIT_ItemRespawnWait(i);
+		if (wait < 0 || wait > ACE_ITEM_TIMING)
 			continue;
-		
-		cost = ACEND_FindCost(current_node,item_table[i].node);
+
+		node = item_table[i].node;
+		if (node < 0 || node >= numnodes)
+			continue;
+
+		cost = cost_row[node];
 		
 		if (cost == INVALID || cost < 2) // ignore invalid and very short hops
 			continue;
+
+		item = item_table[i].item;
+		if (item < 0 || item >= ITEM_WEIGHTS)
+			continue; // ACEIT_ItemNeed has no use for these
 	
-		weight = ACEIT_ItemNeed(self, item_table[i].item);
-
-		// If I am on team one and I have the flag for the other team....return it
-		// Knightmare- rewrote for 3Team CTF
-		//if (ctf->value && (item_table[i].item == ITEMLIST_FLAG2 || item_table[i].item == ITEMLIST_FLAG1) &&
-		//	(self->client->resp.ctf_team == CTF_TEAM1 && self->client->pers.inventory[ITEMLIST_FLAG2] ||
-		//	self->client->resp.ctf_team == CTF_TEAM2 && self->client->pers.inventory[ITEMLIST_FLAG1]))
-		if (ctf->value && (
-				(item_table[i].item == ITEMLIST_FLAG1 && self->client->resp.ctf_team == CTF_TEAM1 &&
-					(self->client->pers.inventory[ITEMLIST_FLAG2] || self->client->pers.inventory[ITEMLIST_FLAG3]) )
-				|| (item_table[i].item == ITEMLIST_FLAG2 && self->client->resp.ctf_team == CTF_TEAM2 &&
-					(self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG3]) )
-				|| (item_table[i].item == ITEMLIST_FLAG3 && self->client->resp.ctf_team == CTF_TEAM3 &&
-					(self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG2]) )
-			))
-			weight = 10.0;
-
-		// Knightmare- in 3Team CTF mode, make double captures a lower priority than
-		// getting back to base with the flag we already have.
-		if (ttctf->value && (
-			(self->client->resp.ctf_team == CTF_TEAM1
-				&& (self->client->pers.inventory[ITEMLIST_FLAG2] || self->client->pers.inventory[ITEMLIST_FLAG3])
-				&& (item_table[i].item == ITEMLIST_FLAG2 || item_table[i].item == ITEMLIST_FLAG3) )
-			|| (self->client->resp.ctf_team == CTF_TEAM2
-				&& (self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG3])
-				&& (item_table[i].item == ITEMLIST_FLAG1 || item_table[i].item == ITEMLIST_FLAG3) )
-			|| (self->client->resp.ctf_team == CTF_TEAM3
-				&& (self->client->pers.inventory[ITEMLIST_FLAG1] || self->client->pers.inventory[ITEMLIST_FLAG2])
-				&& (item_table[i].item == ITEMLIST_FLAG1 || item_table[i].item == ITEMLIST_FLAG2) )
-			))
-			weight = 6.5;
+		if (!weight_known[item])
+		{
+			item_weight[item] = ACEAI_ItemWeight(self, item);
+			weight_known[item] = true;
+		}
 
-		weight *= random(); // Allow random variations
+		weight = item_weight[item] * random(); // Allow random variations
 		weight /= cost; // Check against cost of getting there
 				
 		if (weight > best_weight)
 		{
 			best_weight = weight;
-			goal_node = item_table[i].node;
+			goal_node = node;
 			goal_ent = item_table[i].ent;
 		}
 	}
@@ -374,7 +478,9 @@ qboolean ACEAI_FindEnemy(edict_t *self)
 		   self->client->resp.ctf_team == players[i]->client->resp.ctf_team)
 		   continue;
 
-		if (!players[i]->deadflag && visible(self, players[i]) && gi.inPVS (self->s.origin, players[i]->s.origin))
+		// the sight cache tests the PVS before tracing, and shares the
+		// trace with the other player's own look at us
+		if (!players[i]->deadflag && AI_CachedVisible(self, players[i]))
 		{
 			self->enemy = players[i];
 			return true;
@@ -387,18 +493,146 @@ qboolean ACEAI_FindEnemy(edict_t *self)
 
 ///////////////////////////////////////////////////////////////////////
 // Hold fire with RL/BFG?
+//
+// ACEAI_ChooseWeapon asks up to three times in a row about the same
+// enemy, so the last answer is kept until either end moves or the
+// frame is over.
 ///////////////////////////////////////////////////////////////////////
 qboolean ACEAI_CheckShot(edict_t *self)
 {
+	static struct
+	{
+		edict_t *self, *enemy;
+		int framenum;
+		vec3_t start, end;
+		qboolean clear;
+	} last;
 	trace_t tr;
 
+	if (last.self == self && last.enemy == self->enemy && last.framenum == level.framenum
+		&& VectorCompare(last.start, self->s.origin) && VectorCompare(last.end, self->enemy->s.origin))
+		return last.clear;
+
 	tr = gi.trace (self->s.origin, tv(-8,-8,-8), tv(8,8,8), self->enemy->s.origin, self, MASK_OPAQUE);
-	
+
+	last.self = self;
+	last.enemy = self->enemy;
+	last.framenum = level.framenum;
+	VectorCopy(self->s.origin, last.start);
+	VectorCopy(self->enemy->s.origin, last.end);
+
 	// Blocked, do not shoot
-	if (tr.fraction != 1.0)
-		return false; 
-	
-	return true;
+	last.clear = (tr.fraction == 1.0);
+	return last.clear;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Weapon ranking. The weapons ACEAI_ChooseWeapon tries, best first,
+// with what each needs beyond being held with ammo. Which of them a
+// bot can use only changes with its inventory, so each bot keeps a
+// mask of the usable ones and, for each range band, the list of them
+// that apply there. Both are only rebuilt when the mask changes; a
+// combat think just walks the short list for its band.
+///////////////////////////////////////////////////////////////////////
+#define AW_LONG		1	// only past 300 units
+#define AW_LOB		2	// only 100 to 500 units away, on targets at or below us
+#define AW_SHOT		4	// only with a clear shot
+
+typedef struct
+{
+	int		*index;		// into itemlist
+	int		flags;
+	int		min_ammo;	// 0 for any (or none with g_select_empty)
+} aceweapon_t;
+
+static aceweapon_t ace_weapons[] =
+{
+	{&railgun_index,		0,					0},		// always favor the railgun
+	{&bfg_index,			AW_LONG|AW_SHOT,	51},
+	{&hml_index,			AW_LONG|AW_SHOT,	0},		// Knightmare added
+	{&rl_index,				AW_LONG|AW_SHOT,	0},
+	{&gl_index,				AW_LOB,				0},
+	{&hyperblaster_index,	0,					0},
+	{&chaingun_index,		0,					50},
+	{&machinegun_index,		0,					0},
+	{&sshotgun_index,		0,					0},
+	{&shotgun_index,		0,					0},
+	{&blaster_index,		0,					0}
+};
+#define ACE_WEAPONS	(sizeof(ace_weapons) / sizeof(ace_weapons[0]))
+
+enum
+{
+	BAND_CLOSE,		// up to 100
+	BAND_MID,		// up to 300
+	BAND_FAR,		// under 500
+	BAND_LONG,
+	ACE_BANDS
+};
+
+typedef struct
+{
+	int		usable;						// bit per ace_weapons entry, -1 if not built
+	int		num[ACE_BANDS];
+	byte	list[ACE_BANDS][ACE_WEAPONS];
+} aceweaponpick_t;
+
+static aceweaponpick_t *ace_picks;		// game.maxclients
+
+///////////////////////////////////////////////////////////////////////
+// Called from InitGame. The picks are sized by maxclients, so the
+// next bot to choose a weapon builds them again.
+///////////////////////////////////////////////////////////////////////
+void ACEAI_InitWeaponPicks(void)
+{
+	ace_picks = NULL;
+}
+
+// the tests ACEIT_ChangeWeapon makes, the weapon in hand always passing
+static int ACEAI_UsableWeapons(edict_t *self)
+{
+	int *inventory = self->client->pers.inventory;
+	gitem_t *item;
+	int i, ammo, usable;
+
+	usable = 0;
+	for (i = 0; i < ACE_WEAPONS; i++)
+	{
+		item = &itemlist[*ace_weapons[i].index];
+		ammo = ItemAmmoIndex(item);
+		if (ace_weapons[i].min_ammo && inventory[ammo] < ace_weapons[i].min_ammo)
+			continue;
+		if (item != self->client->pers.weapon)
+		{
+			if (!inventory[*ace_weapons[i].index])
+				continue;
+			if (ammo && !inventory[ammo] && !g_select_empty->value)
+				continue;
+		}
+		usable |= 1 << i;
+	}
+	return usable;
+}
+
+static void ACEAI_RankWeapons(aceweaponpick_t *pick, int usable)
+{
+	int i, band;
+
+	pick->usable = usable;
+	for (band = 0; band < ACE_BANDS; band++)
+	{
+		pick->num[band] = 0;
+		for (i = 0; i < ACE_WEAPONS; i++)
+		{
+			if (!(usable & (1 << i)))
+				continue;
+			if ((ace_weapons[i].flags & AW_LONG) && band < BAND_FAR)
+				continue;
+			if ((ace_weapons[i].flags & AW_LOB) && (band == BAND_CLOSE || band == BAND_LONG))
+				continue;
+			pick->list[band][pick->num[band]++] = i;
+		}
+	}
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -406,61 +640,52 @@ qboolean ACEAI_CheckShot(edict_t *self)
 ///////////////////////////////////////////////////////////////////////
 void ACEAI_ChooseWeapon(edict_t *self)
 {	
+	aceweaponpick_t *pick;
+	aceweapon_t *w;
+	gitem_t *item;
 	float range;
 	vec3_t v;
+	int i, band, usable;
 	
 	// if no enemy, then what are we doing here?
 	if(!self->enemy)
 		return;
-	
-	// always favor the railgun
-	if(ACEIT_ChangeWeapon(self,FindItem("railgun")))
-		return;
+
+	if(!ace_picks)
+	{
+		ace_picks = gi.TagMalloc(game.maxclients * sizeof(ace_picks[0]), TAG_GAME);
+		for (i = 0; i < game.maxclients; i++)
+			ace_picks[i].usable = -1;
+	}
+	pick = &ace_picks[self - g_edicts - 1];
+
+	usable = ACEAI_UsableWeapons(self);
+	if (usable != pick->usable)
+		ACEAI_RankWeapons(pick, usable);
 
 	// Base selection on distance.
 	VectorSubtract (self->s.origin, self->enemy->s.origin, v);
 	range = VectorLength(v);
-		
-	// Longer range 
-	if(range > 300)
-	{
-		// choose BFG if enough ammo
-		if(self->client->pers.inventory[ITEMLIST_CELLS] > 50)
-			if(ACEAI_CheckShot(self) && ACEIT_ChangeWeapon(self, FindItem("bfg10k")))
-				return;
+	if (range <= 100)
+		band = BAND_CLOSE;
+	else if (range <= 300)
+		band = BAND_MID;
+	else if (range < 500)
+		band = BAND_FAR;
+	else
+		band = BAND_LONG;
 
-		// Knightmare added
-		if (ACEAI_CheckShot(self) && ACEIT_ChangeWeapon(self,FindItem("homing missile launcher")))
-			return;
-		if (ACEAI_CheckShot(self) && ACEIT_ChangeWeapon(self,FindItem("rocket launcher")))
-			return;
-	}
-	
-	// Only use GL in certain ranges and only on targets at or below our level
-	if(range > 100 && range < 500 && self->enemy->s.origin[2] - 20 < self->s.origin[2])
-		if(ACEIT_ChangeWeapon(self,FindItem("grenade launcher")))
-			return;
+	for (i = 0; i < pick->num[band]; i++)
+	{
+		w = &ace_weapons[pick->list[band][i]];
+		if ((w->flags & AW_LOB) && self->enemy->s.origin[2] - 20 >= self->s.origin[2])
+			continue;
+		if ((w->flags & AW_SHOT) && !ACEAI_CheckShot(self))
+			continue;
 
-	if(ACEIT_ChangeWeapon(self,FindItem("hyperblaster")))
+		item = &itemlist[*w->index];
+		if (item != self->client->pers.weapon)
+			self->client->newweapon = item;
 		return;
-	
-	// Only use CG when ammo > 50
-	if(self->client->pers.inventory[ITEMLIST_BULLETS] >= 50)
-		if(ACEIT_ChangeWeapon(self,FindItem("chaingun")))
-			return;
-	
-	if(ACEIT_ChangeWeapon(self,FindItem("machinegun")))
-		return;
-	
-	if(ACEIT_ChangeWeapon(self,FindItem("super shotgun")))
-		return;
-	
-	if(ACEIT_ChangeWeapon(self,FindItem("shotgun")))
-   	   return;
-	
-	if(ACEIT_ChangeWeapon(self,FindItem("blaster")))
-   	   return;
-	
-	return;
-
+	}
 }
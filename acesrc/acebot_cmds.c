@@ -85,32 +85,37 @@ qboolean ACECM_Commands(edict_t *ent)
 	char	*cmd;
 	int node;
 
+	// all of these are for editing nodes
+	if(!debug_mode)
+		return false;
+
 	cmd = gi.argv(0);
 
-	if(Q_strcasecmp (cmd, "addnode") == 0 && debug_mode)
+	if(Q_strcasecmp (cmd, "addnode") == 0)
 		ent->last_node = ACEND_AddNode(ent,atoi(gi.argv(1))); 
 	
-	else if(Q_strcasecmp (cmd, "removelink") == 0 && debug_mode)
+	else if(Q_strcasecmp (cmd, "removelink") == 0)
 		ACEND_RemoveNodeEdge(ent,atoi(gi.argv(1)), atoi(gi.argv(2)));
 
-	else if(Q_strcasecmp (cmd, "addlink") == 0 && debug_mode)
+	else if(Q_strcasecmp (cmd, "addlink") == 0)
 		ACEND_UpdateNodeEdge(atoi(gi.argv(1)), atoi(gi.argv(2)));
 	
-	else if(Q_strcasecmp (cmd, "showpath") == 0 && debug_mode)
+	else if(Q_strcasecmp (cmd, "showpath") == 0)
     	ACEND_ShowPath(ent,atoi(gi.argv(1)));
 
-	else if(Q_strcasecmp (cmd, "findnode") == 0 && debug_mode)
+	else if(Q_strcasecmp (cmd, "findnode") == 0)
 	{
 		node = ACEND_FindClosestReachableNode(ent,NODE_DENSITY, NODE_ALL);
 		safe_bprintf(PRINT_MEDIUM,"node: %d type: %d x: %f y: %f z %f\n",node,nodes[node].type,nodes[node].origin[0],nodes[node].origin[1],nodes[node].origin[2]);
 	}
 
-	else if(Q_strcasecmp (cmd, "movenode") == 0 && debug_mode)
+	else if(Q_strcasecmp (cmd, "movenode") == 0)
 	{
 		node = atoi(gi.argv(1));
 		nodes[node].origin[0] = atof(gi.argv(2));
 		nodes[node].origin[1] = atof(gi.argv(3));
 		nodes[node].origin[2] = atof(gi.argv(4));
+		ACEND_ResetNodeGrid();
 		safe_bprintf(PRINT_MEDIUM,"node: %d moved to x: %f y: %f z %f\n",node, nodes[node].origin[0],nodes[node].origin[1],nodes[node].origin[2]);
 	}
 
@@ -48,19 +48,27 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 						   if match_length is greater than this */
 #define NIL			N	/* index for root of binary search trees */
 
-uint32_t
-		textsize = 0,	/* text size counter */
-		codesize = 0,	/* code size counter */
-		printcount = 0;	/* counter for reporting progress every 1K bytes */
-uint8_t
-		text_buf[N + F - 1];	/* ring buffer of size N,
+// Everything one Encode or Decode works with. Each call gets its own,
+// so a node file can be written on a worker thread while the game
+// thread compresses a save.
+typedef struct
+{
+	uint8_t	text_buf[N + F - 1];	/* ring buffer of size N,
 			with extra F-1 bytes to facilitate string comparison */
-int		match_position, match_length,  /* of longest match.  These are
+	int		match_position, match_length;  /* of longest match.  These are
 			set by the InsertNode() procedure. */
-		lson[N + 1], rson[N + 257], dad[N + 1];  /* left & right children &
+	int		lson[N + 1], rson[N + 257], dad[N + 1];  /* left & right children &
 			parents -- These constitute binary search trees. */
+	int		codesize;		/* code size counter */
+
+	// Encode and Decode work on files, EncodeBuffer and DecodeBuffer on
+	// memory. The code stream goes through PutCode/GetCode either way.
+	FILE	*code_file;		// file being written or read, NULL for memory
+	uint8_t	*code_mem;		// otherwise the memory buffer
+	int		code_mempos, code_memsize;
+} lzss_t;
 
-void InitTree(void)  /* initialize trees */
+static void InitTree(lzss_t *lz)  /* initialize trees */
 {
 	int  i;
 
@@ -72,14 +80,14 @@ void InitTree(void)  /* initialize trees */
 	   for strings that begin with character i.  These are initialized
 	   to NIL.  Note there are 256 trees. */
 
-	for (i = N + 1; i <= N + 256; i++) rson[i] = NIL;
-	for (i = 0; i < N; i++) dad[i] = NIL;
+	for (i = N + 1; i <= N + 256; i++) lz->rson[i] = NIL;
+	for (i = 0; i < N; i++) lz->dad[i] = NIL;
 }
 
-void InsertNode(int r)
+static void InsertNode(lzss_t *lz, int r)
 	/* Inserts string of length F, text_buf[r..r+F-1], into one of the
 	   trees (text_buf[r]'th tree) and returns the longest-match position
-	   and length via the global variables match_position and match_length.
+	   and length via lz->match_position and lz->match_length.
 	   If match_length = F, then removes the old node in favor of the new
 	   one, because the old one will be deleted sooner.
 	   Note r plays double role, as tree node and position in buffer. */
@@ -87,125 +95,139 @@ void InsertNode(int r)
 	int  i, p, cmp;
 	uint8_t  *key;
 
-	cmp = 1;  key = &text_buf[r];  p = N + 1 + key[0];
-	rson[r] = lson[r] = NIL;  match_length = 0;
+	cmp = 1;  key = &lz->text_buf[r];  p = N + 1 + key[0];
+	lz->rson[r] = lz->lson[r] = NIL;  lz->match_length = 0;
 	for ( ; ; ) {
 		if (cmp >= 0) {
-			if (rson[p] != NIL) p = rson[p];
-			else {  rson[p] = r;  dad[r] = p;  return;  }
+			if (lz->rson[p] != NIL) p = lz->rson[p];
+			else {  lz->rson[p] = r;  lz->dad[r] = p;  return;  }
 		} else {
-			if (lson[p] != NIL) p = lson[p];
-			else {  lson[p] = r;  dad[r] = p;  return;  }
+			if (lz->lson[p] != NIL) p = lz->lson[p];
+			else {  lz->lson[p] = r;  lz->dad[r] = p;  return;  }
 		}
 		for (i = 1; i < F; i++)
-			if ((cmp = key[i] - text_buf[p + i]) != 0)  break;
-		if (i > match_length) {
-			match_position = p;
-			if ((match_length = i) >= F)  break;
+			if ((cmp = key[i] - lz->text_buf[p + i]) != 0)  break;
+		if (i > lz->match_length) {
+			lz->match_position = p;
+			if ((lz->match_length = i) >= F)  break;
 		}
 	}
-	dad[r] = dad[p];  lson[r] = lson[p];  rson[r] = rson[p];
-	dad[lson[p]] = r;  dad[rson[p]] = r;
-	if (rson[dad[p]] == p) rson[dad[p]] = r;
-	else                   lson[dad[p]] = r;
-	dad[p] = NIL;  /* remove p */
+	lz->dad[r] = lz->dad[p];  lz->lson[r] = lz->lson[p];  lz->rson[r] = lz->rson[p];
+	lz->dad[lz->lson[p]] = r;  lz->dad[lz->rson[p]] = r;
+	if (lz->rson[lz->dad[p]] == p) lz->rson[lz->dad[p]] = r;
+	else                   lz->lson[lz->dad[p]] = r;
+	lz->dad[p] = NIL;  /* remove p */
 }
 
-void DeleteNode(int p)  /* deletes node p from tree */
+static void DeleteNode(lzss_t *lz, int p)  /* deletes node p from tree */
 {
 	int  q;
 	
-	if (dad[p] == NIL) return;  /* not in tree */
-	if (rson[p] == NIL) q = lson[p];
-	else if (lson[p] == NIL) q = rson[p];
+	if (lz->dad[p] == NIL) return;  /* not in tree */
+	if (lz->rson[p] == NIL) q = lz->lson[p];
+	else if (lz->lson[p] == NIL) q = lz->rson[p];
 	else {
-		q = lson[p];
-		if (rson[q] != NIL) {
-			do {  q = rson[q];  } while (rson[q] != NIL);
-			rson[dad[q]] = lson[q];  dad[lson[q]] = dad[q];
-			lson[q] = lson[p];  dad[lson[p]] = q;
+		q = lz->lson[p];
+		if (lz->rson[q] != NIL) {
+			do {  q = lz->rson[q];  } while (lz->rson[q] != NIL);
+			lz->rson[lz->dad[q]] = lz->lson[q];  lz->dad[lz->lson[q]] = lz->dad[q];
+			lz->lson[q] = lz->lson[p];  lz->dad[lz->lson[p]] = q;
 		}
-		rson[q] = rson[p];  dad[rson[p]] = q;
+		lz->rson[q] = lz->rson[p];  lz->dad[lz->rson[p]] = q;
 	}
-	dad[q] = dad[p];
-	if (rson[dad[p]] == p) rson[dad[p]] = q;  else lson[dad[p]] = q;
-	dad[p] = NIL;
+	lz->dad[q] = lz->dad[p];
+	if (lz->rson[lz->dad[p]] == p) lz->rson[lz->dad[p]] = q;  else lz->lson[lz->dad[p]] = q;
+	lz->dad[p] = NIL;
 }
 
-int Encode(char *filename, uint8_t *buffer, int bufsize, int version)
+static int PutCode(lzss_t *lz, int c)
+{
+	if(lz->code_file)
+	{
+		putc(c, lz->code_file);
+		return 0;
+	}
+	if(lz->code_mempos >= lz->code_memsize)
+		return -1; // out of room
+	lz->code_mem[lz->code_mempos++] = c;
+	return 0;
+}
+
+static int GetCode(lzss_t *lz)
+{
+	if(lz->code_file)
+		return getc(lz->code_file);
+	if(lz->code_mempos >= lz->code_memsize)
+		return EOF;
+	return lz->code_mem[lz->code_mempos++];
+}
+
+static int EncodeData(lzss_t *lz, uint8_t *buffer, int bufsize)
 {
 	int  i, c, len, r, s, last_match_length, code_buf_ptr;
 	uint8_t  code_buf[17], mask;
 	int bufptr = 0;
-	FILE *pOut;
-	//int version;
-	
-	pOut  = fopen(filename, "wb");
-	if(pOut == NULL)
-		return -1; // bail
 
-	//version = 2; // compressed version
+	lz->codesize = 0;
 
-	// Read version info (uneeded here, but moves file ptr)
-	fwrite(&version,sizeof(int),1,pOut); // write version
-	fwrite(&bufsize,sizeof(int),1,pOut); // write out the size of the buffer
-	
-	InitTree();  /* initialize trees */
+	InitTree(lz);  /* initialize trees */
 	code_buf[0] = 0;  /* code_buf[1..16] saves eight units of code, and
 		code_buf[0] works as eight flags, "1" representing that the unit
 		is an unencoded letter (1 byte), "0" a position-and-length pair
 		(2 bytes).  Thus, eight units require at most 16 bytes of code. */
 	code_buf_ptr = mask = 1;
 	s = 0;  r = N - F;
-	for (i = s; i < r; i++) text_buf[i] = ' ';  /* Clear the buffer with
+	for (i = s; i < r; i++) lz->text_buf[i] = ' ';  /* Clear the buffer with
 		any character that will appear often. */
 	for (len = 0; len < F &&  bufptr < bufsize; len++)
 	{	
 		c = buffer[bufptr++];
-		text_buf[r + len] = c;  /* Read F bytes into the last F bytes of
+		lz->text_buf[r + len] = c;  /* Read F bytes into the last F bytes of
 			the buffer */
 	}
-	if ((textsize = len) == 0) return -1;  /* text of size zero */
-	for (i = 1; i <= F; i++) InsertNode(r - i);  /* Insert the F strings,
+	if (len == 0)  /* text of size zero */
+		return -1;
+	for (i = 1; i <= F; i++) InsertNode(lz, r - i);  /* Insert the F strings,
 		each of which begins with one or more 'space' characters.  Note
 		the order in which these strings are inserted.  This way,
 		degenerate trees will be less likely to occur. */
-	InsertNode(r);  /* Finally, insert the whole string just read.  The
-		global variables match_length and match_position are set. */
+	InsertNode(lz, r);  /* Finally, insert the whole string just read.  The
+		match_length and match_position are set. */
 	do {
-		if (match_length > len) match_length = len;  /* match_length
+		if (lz->match_length > len) lz->match_length = len;  /* match_length
 			may be spuriously long near the end of text. */
-		if (match_length <= THRESHOLD) {
-			match_length = 1;  /* Not long enough match.  Send one byte. */
+		if (lz->match_length <= THRESHOLD) {
+			lz->match_length = 1;  /* Not long enough match.  Send one byte. */
 			code_buf[0] |= mask;  /* 'send one byte' flag */
-			code_buf[code_buf_ptr++] = text_buf[r];  /* Send uncoded. */
+			code_buf[code_buf_ptr++] = lz->text_buf[r];  /* Send uncoded. */
 		} else {
-			code_buf[code_buf_ptr++] = (uint8_t) match_position;
+			code_buf[code_buf_ptr++] = (uint8_t) lz->match_position;
 			code_buf[code_buf_ptr++] = (uint8_t)
-				(((match_position >> 4) & 0xf0)
-			  | (match_length - (THRESHOLD + 1)));  /* Send position and
+				(((lz->match_position >> 4) & 0xf0)
+			  | (lz->match_length - (THRESHOLD + 1)));  /* Send position and
 					length pair. Note match_length > THRESHOLD. */
 		}
 		if ((mask <<= 1) == 0) {  /* Shift mask left one bit. */
 			for (i = 0; i < code_buf_ptr; i++)  /* Send at most 8 units of */
-				putc(code_buf[i], pOut);     /* code together */
-			codesize += code_buf_ptr;
+				if (PutCode(lz, code_buf[i]) < 0)  /* code together */
+					return -1;
+			lz->codesize += code_buf_ptr;
 			code_buf[0] = 0;  code_buf_ptr = mask = 1;
 		}
-		last_match_length = match_length;
+		last_match_length = lz->match_length;
 		for (i = 0; i < last_match_length &&
 				bufptr < bufsize; i++) 
 		{
 			c = buffer[bufptr++];
-			DeleteNode(s);		/* Delete old strings and */
-			text_buf[s] = c;	/* read new bytes */
-			if (s < F - 1) text_buf[s + N] = c;  /* If the position is
+			DeleteNode(lz, s);		/* Delete old strings and */
+			lz->text_buf[s] = c;	/* read new bytes */
+			if (s < F - 1) lz->text_buf[s + N] = c;  /* If the position is
 				near the end of buffer, extend the buffer to make
 				string comparison easier. */
 			s = (s + 1) & (N - 1);  r = (r + 1) & (N - 1);
 				/* Since this is a ring buffer, increment the position
 				   modulo N. */
-			InsertNode(r);	/* Register the string in text_buf[r..r+F-1] */
+			InsertNode(lz, r);	/* Register the string in text_buf[r..r+F-1] */
 		}
 //		if ((textsize += i) > printcount) {
 //			printf("%12ld\r", textsize);  printcount += 1024;
@@ -213,73 +235,161 @@ int Encode(char *filename, uint8_t *buffer, int bufsize, int version)
 //				   multiples of 1024. */
 //		}
 		while (i++ < last_match_length) {	/* After the end of text, */
-			DeleteNode(s);					/* no need to read, but */
+			DeleteNode(lz, s);					/* no need to read, but */
 			s = (s + 1) & (N - 1);  r = (r + 1) & (N - 1);
-			if (--len) InsertNode(r);		/* buffer may not be empty. */
+			if (--len) InsertNode(lz, r);		/* buffer may not be empty. */
 		}
 	} while (len > 0);	/* until length of string to be processed is zero */
 	if (code_buf_ptr > 1) {		/* Send remaining code. */
-		for (i = 0; i < code_buf_ptr; i++) putc(code_buf[i], pOut);
-		codesize += code_buf_ptr;
+		for (i = 0; i < code_buf_ptr; i++)
+			if (PutCode(lz, code_buf[i]) < 0)
+				return -1;
+		lz->codesize += code_buf_ptr;
 	}
-//	printf("In : %ld bytes\n", textsize);	/* Encoding is done. */
-//	printf("Out: %ld bytes\n", codesize);
-//	printf("Out/In: %.3f\n", (double)codesize / textsize);	
+
+	return lz->codesize;
+}
+
+int Encode(char *filename, uint8_t *buffer, int bufsize, int version)
+{
+	FILE *pOut;
+	lzss_t *lz;
+	int result;
+
+	lz = (lzss_t *)malloc(sizeof(lzss_t));
+	if(lz == NULL)
+		return -1;
+
+	pOut  = fopen(filename, "wb");
+	if(pOut == NULL)
+	{
+		free(lz);
+		return -1; // bail
+	}
+
+	// Read version info (uneeded here, but moves file ptr)
+	fwrite(&version,sizeof(int),1,pOut); // write version
+	fwrite(&bufsize,sizeof(int),1,pOut); // write out the size of the buffer
+
+	lz->code_file = pOut;
+	result = EncodeData(lz, buffer, bufsize);
+
 	fclose(pOut);
+	free(lz);
 
-	return codesize;
+	return result;
 }
 
-// Be careful with your buffersize, will return an exit of -1 if failure
-int Decode(char *filename, uint8_t *buffer, int bufsize)	/* Just the reverse of Encode(). */
+// Compresses bufsize bytes into out, without the header Encode writes.
+// Returns the compressed size, or -1 if it does not fit in outsize.
+int EncodeBuffer(uint8_t *buffer, int bufsize, uint8_t *out, int outsize)
+{
+	lzss_t *lz;
+	int result;
+
+	lz = (lzss_t *)malloc(sizeof(lzss_t));
+	if(lz == NULL)
+		return -1;
+
+	lz->code_file = NULL;
+	lz->code_mem = out;
+	lz->code_mempos = 0;
+	lz->code_memsize = outsize;
+
+	result = EncodeData(lz, buffer, bufsize);
+	free(lz);
+	return result;
+}
+
+static int DecodeData(lzss_t *lz, uint8_t *buffer, int bufsize)
 {
 	int  i, j, k, r, c;
 	uint32_t  flags;
 	int bufptr=0;
-	FILE *pIn;
-	int version;
-	
-	pIn  = fopen(filename, "rb");
-	if(pIn == NULL)
-		return -1; // bail
 
-	// Read version info (uneeded here, but moves file ptr)
-	fread(&version,sizeof(int),1,pIn); // read version
-	fread(&version,sizeof(int),1,pIn); // read buffersize (not needed, so repeat into version)
-
-	
-	for (i = 0; i < N - F; i++) text_buf[i] = ' ';
+	for (i = 0; i < N - F; i++) lz->text_buf[i] = ' ';
 	r = N - F;  flags = 0;
 	for ( ; ; ) {
 		if (((flags >>= 1) & 256) == 0) {
-			if ((c = getc(pIn)) == EOF) break;
+			if ((c = GetCode(lz)) == EOF) break;
 			flags = c | 0xff00;		/* uses higher byte cleverly */
 		}							/* to count eight */
 		if (flags & 1) {
-			if ((c = getc(pIn)) == EOF) break;
-			buffer[bufptr++] = c;	
-			if(bufptr > bufsize)
+			if ((c = GetCode(lz)) == EOF) break;
+			if(bufptr >= bufsize)
 				return -1; // check for overflow
-			text_buf[r++] = c;  
+			buffer[bufptr++] = c;
+			lz->text_buf[r++] = c;  
 			r &= (N - 1);
 		} else {
-			if ((i = getc(pIn)) == EOF) break;
-			if ((j = getc(pIn)) == EOF) break;
+			if ((i = GetCode(lz)) == EOF) break;
+			if ((j = GetCode(lz)) == EOF) break;
 			i |= ((j & 0xf0) << 4);  j = (j & 0x0f) + THRESHOLD;
 			for (k = 0; k <= j; k++) {
-				c = text_buf[(i + k) & (N - 1)];
-				buffer[bufptr++] = c;
-				if(bufptr > bufsize)
+				c = lz->text_buf[(i + k) & (N - 1)];
+				if(bufptr >= bufsize)
 					return -1; // check for overflow
-				text_buf[r++] = c;  
+				buffer[bufptr++] = c;
+				lz->text_buf[r++] = c;  
 				r &= (N - 1);
 			}
 		}
 	}
 	
-	fclose(pIn);
 	return bufptr; // return uncompressed size
 }
+
+// Be careful with your buffersize, will return an exit of -1 if failure
+int Decode(char *filename, uint8_t *buffer, int bufsize)	/* Just the reverse of Encode(). */
+{
+	FILE *pIn;
+	lzss_t *lz;
+	int version;
+	int result;
+	
+	lz = (lzss_t *)malloc(sizeof(lzss_t));
+	if(lz == NULL)
+		return -1;
+
+	pIn  = fopen(filename, "rb");
+	if(pIn == NULL)
+	{
+		free(lz);
+		return -1; // bail
+	}
+
+	// Read version info (uneeded here, but moves file ptr)
+	fread(&version,sizeof(int),1,pIn); // read version
+	fread(&version,sizeof(int),1,pIn); // read buffersize (not needed, so repeat into version)
+
+	lz->code_file = pIn;
+	result = DecodeData(lz, buffer, bufsize);
+
+	fclose(pIn);
+	free(lz);
+	return result;
+}
+
+// The reverse of EncodeBuffer(). Returns the uncompressed size, or -1
+// if it does not fit in bufsize.
+int DecodeBuffer(uint8_t *in, int insize, uint8_t *buffer, int bufsize)
+{
+	lzss_t *lz;
+	int result;
+
+	lz = (lzss_t *)malloc(sizeof(lzss_t));
+	if(lz == NULL)
+		return -1;
+
+	lz->code_file = NULL;
+	lz->code_mem = in;
+	lz->code_mempos = 0;
+	lz->code_memsize = insize;
+
+	result = DecodeData(lz, buffer, bufsize);
+	free(lz);
+	return result;
+}
 /*
 // tester
 int main(int argc, char *argv[])
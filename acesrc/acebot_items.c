@@ -165,7 +165,6 @@ qboolean ACEIT_IsVisible(edict_t *self, vec3_t goal)
 qboolean ACEIT_ChangeWeapon (edict_t *ent, gitem_t *item)
 {
 	int			ammo_index;
-	gitem_t		*ammo_item;
 		
 	// see if we're already using it
 	if (item == ent->client->pers.weapon)
@@ -178,8 +177,7 @@ qboolean ACEIT_ChangeWeapon (edict_t *ent, gitem_t *item)
 	// Do we have ammo for it?
 	if (item->ammo)
 	{
-		ammo_item = FindItem(item->ammo);
-		ammo_index = ITEM_INDEX(ammo_item);
+		ammo_index = ItemAmmoIndex(item);
 		if (!ent->client->pers.inventory[ammo_index] && !g_select_empty->value)
 			return false;
 	}
@@ -217,9 +215,9 @@ qboolean ACEIT_CanUseArmor (gitem_t *item, edict_t *other)
 		return true;
 	
 	// get info on old armor
-	if (old_armor_index == ITEM_INDEX(FindItem("Jacket Armor")))
+	if (old_armor_index == jacket_armor_index)
 		oldinfo = &jacketarmor_info;
-	else if (old_armor_index == ITEM_INDEX(FindItem("Combat Armor")))
+	else if (old_armor_index == combat_armor_index)
 		oldinfo = &combatarmor_info;
 	else // (old_armor_index == body_armor_index)
 		oldinfo = &bodyarmor_info;
@@ -354,19 +352,19 @@ float ACEIT_ItemNeed(edict_t *self, int item)
 			return 0.5;
 	
 		case ITEMLIST_BODYARMOR:
-			if(ACEIT_CanUseArmor (FindItem("Body Armor"), self))
+			if(ACEIT_CanUseArmor (&itemlist[body_armor_index], self))
 				return 0.6;  
 			else
 				return 0.0;
 	
 		case ITEMLIST_COMBATARMOR:
-			if(ACEIT_CanUseArmor (FindItem("Combat Armor"), self))
+			if(ACEIT_CanUseArmor (&itemlist[combat_armor_index], self))
 				return 0.6;  
 			else
 				return 0.0;
 	
 		case ITEMLIST_JACKETARMOR:
-			if(ACEIT_CanUseArmor (FindItem("Jacket Armor"), self))
+			if(ACEIT_CanUseArmor (&itemlist[jacket_armor_index], self))
 				return 0.6;  
 			else
 				return 0.0;
@@ -423,215 +421,213 @@ float ACEIT_ItemNeed(edict_t *self, int item)
 }
 
 ///////////////////////////////////////////////////////////////////////
-// Convert a classname to its index value
+// Classname lookup
 //
-// I prefer to use integers/defines for simplicity sake. This routine
-// can lead to some slowdowns I guess, but makes the rest of the code
-// easier to deal with.
+// I prefer to use integers/defines for simplicity sake. Every edict in
+// the map is asked about when the item table is built, so the
+// classnames below are hashed the first time one is looked up rather
+// than run through a strcmp each. Platforms and teleporters live in
+// the same table with the node type they get, and no item index.
 ///////////////////////////////////////////////////////////////////////
-int ACEIT_ClassnameToIndex(char *classname)
+typedef struct
 {
-	if(strcmp(classname,"item_armor_body")==0) 
-		return ITEMLIST_BODYARMOR;
-	
-	if(strcmp(classname,"item_armor_combat")==0)
-		return ITEMLIST_COMBATARMOR;
-
-	if(strcmp(classname,"item_armor_jacket")==0)
-		return ITEMLIST_JACKETARMOR;
-	
-	if(strcmp(classname,"item_armor_shard")==0)
-		return ITEMLIST_ARMORSHARD;
-
-	// Knightmare added
-	if(strcmp(classname,"item_armor_shard_flat")==0)
-		return ITEMLIST_ARMORSHARD_FLAT;
-
-	if(strcmp(classname,"item_power_screen")==0)
-		return ITEMLIST_POWERSCREEN;
-
-	if(strcmp(classname,"item_power_shield")==0)
-		return ITEMLIST_POWERSHIELD;
-
-	if(strcmp(classname,"weapon_grapple")==0)
-		return ITEMLIST_GRAPPLE;
-
-	if(strcmp(classname,"weapon_blaster")==0)
-		return ITEMLIST_BLASTER;
-
-	if(strcmp(classname,"weapon_shotgun")==0)
-		return ITEMLIST_SHOTGUN;
-	
-	if(strcmp(classname,"weapon_supershotgun")==0)
-		return ITEMLIST_SUPERSHOTGUN;
-	
-	if(strcmp(classname,"weapon_machinegun")==0)
-		return ITEMLIST_MACHINEGUN;
-	
-	if(strcmp(classname,"weapon_chaingun")==0)
-		return ITEMLIST_CHAINGUN;
-	
-	if(strcmp(classname,"ammo_grenades")==0)
-		return ITEMLIST_GRENADES;
-
-	if(strcmp(classname,"weapon_grenadelauncher")==0)
-		return ITEMLIST_GRENADELAUNCHER;
-
-	if(strcmp(classname,"weapon_rocketlauncher")==0)
-		return ITEMLIST_ROCKETLAUNCHER;
-
-	if(strcmp(classname,"weapon_hyperblaster")==0)
-		return ITEMLIST_HYPERBLASTER;
-
-	if(strcmp(classname,"weapon_railgun")==0)
-		return ITEMLIST_RAILGUN;
-
-	if(strcmp(classname,"weapon_bfg10k")==0)
-		return ITEMLIST_BFG10K;
-
-	//if(strcmp(classname,"weapon_hml")==0)
-	//	return ITEMLIST_HML;
-
-	if(strcmp(classname,"ammo_shells")==0)
-		return ITEMLIST_SHELLS;
-	
-	if(strcmp(classname,"ammo_bullets")==0)
-		return ITEMLIST_BULLETS;
-
-	if(strcmp(classname,"ammo_cells")==0)
-		return ITEMLIST_CELLS;
-
-	if(strcmp(classname,"ammo_rockets")==0)
-		return ITEMLIST_ROCKETS;
-
-	// Knightmare added
-	if(strcmp(classname,"ammo_homing_missiles")==0)
-		return ITEMLIST_HOMINGROCKETS;
-
-	if(strcmp(classname,"ammo_slugs")==0)
-		return ITEMLIST_SLUGS;
-	
-	// Knightmare added
-	if(strcmp(classname,"ammo_fuel")==0)
-		return ITEMLIST_FUEL;
-
-	if(strcmp(classname,"item_quad")==0)
-		return ITEMLIST_QUADDAMAGE;
-
-	if(strcmp(classname,"item_invunerability")==0)
-		return ITEMLIST_INVULNERABILITY;
-
-	if(strcmp(classname,"item_silencer")==0)
-		return ITEMLIST_SILENCER;
-
-	if(strcmp(classname,"item_rebreather")==0)
-		return ITEMLIST_REBREATHER;
-
-	if(strcmp(classname,"item_enviornmentsuit")==0)
-		return ITEMLIST_ENVIRONMENTSUIT;
-
-	if(strcmp(classname,"item_ancienthead")==0)
-		return ITEMLIST_ANCIENTHEAD;
-
-	if(strcmp(classname,"item_adrenaline")==0)
-		return ITEMLIST_ADRENALINE;
-
-	if(strcmp(classname,"item_bandolier")==0)
-		return ITEMLIST_BANDOLIER;
-
-	if(strcmp(classname,"item_pack")==0)
-		return ITEMLIST_AMMOPACK;
-
-	// Knightmare added
-	if(strcmp(classname,"item_flashlight")==0)
-		return ITEMLIST_FLASHLIGHT;
-
-	if(strcmp(classname,"item_jetpack")==0)
-		return ITEMLIST_JETPACK;
-
-	if(strcmp(classname,"item_freeze")==0)
-		return ITEMLIST_STASIS;
-	//end Knightmare
-
-	if(strcmp(classname,"item_datacd")==0)
-		return ITEMLIST_DATACD;
-
-	if(strcmp(classname,"item_powercube")==0)
-		return ITEMLIST_POWERCUBE;
-
-	if(strcmp(classname,"item_pyramidkey")==0)
-		return ITEMLIST_PYRAMIDKEY;
-
-	if(strcmp(classname,"item_dataspinner")==0)
-		return ITEMLIST_DATASPINNER;
+	char *classname;
+	int item;
+	int nodetype;
+} aceclass_t;
 
-	if(strcmp(classname,"item_securitypass")==0)
-		return ITEMLIST_SECURITYPASS;
-
-	if(strcmp(classname,"item_bluekey")==0)
-		return ITEMLIST_BLUEKEY;
-
-	if(strcmp(classname,"item_redkey")==0)
-		return ITEMLIST_REDKEY;
-
-	if(strcmp(classname,"item_commandershead")==0)
-		return ITEMLIST_COMMANDERSHEAD;
+static aceclass_t ace_classes[] =
+{
+	{"item_armor_body", ITEMLIST_BODYARMOR, NODE_ITEM},
+	{"item_armor_combat", ITEMLIST_COMBATARMOR, NODE_ITEM},
+	{"item_armor_jacket", ITEMLIST_JACKETARMOR, NODE_ITEM},
+	{"item_armor_shard", ITEMLIST_ARMORSHARD, NODE_ITEM},
+	{"item_armor_shard_flat", ITEMLIST_ARMORSHARD_FLAT, NODE_ITEM},
+	{"item_power_screen", ITEMLIST_POWERSCREEN, NODE_ITEM},
+	{"item_power_shield", ITEMLIST_POWERSHIELD, NODE_ITEM},
+	{"weapon_grapple", ITEMLIST_GRAPPLE, NODE_ITEM},
+	{"weapon_blaster", ITEMLIST_BLASTER, NODE_ITEM},
+	{"weapon_shotgun", ITEMLIST_SHOTGUN, NODE_ITEM},
+	{"weapon_supershotgun", ITEMLIST_SUPERSHOTGUN, NODE_ITEM},
+	{"weapon_machinegun", ITEMLIST_MACHINEGUN, NODE_ITEM},
+	{"weapon_chaingun", ITEMLIST_CHAINGUN, NODE_ITEM},
+	{"ammo_grenades", ITEMLIST_GRENADES, NODE_ITEM},
+	{"weapon_grenadelauncher", ITEMLIST_GRENADELAUNCHER, NODE_ITEM},
+	{"weapon_rocketlauncher", ITEMLIST_ROCKETLAUNCHER, NODE_ITEM},
+	{"weapon_hyperblaster", ITEMLIST_HYPERBLASTER, NODE_ITEM},
+	{"weapon_railgun", ITEMLIST_RAILGUN, NODE_ITEM},
+	{"weapon_bfg10k", ITEMLIST_BFG10K, NODE_ITEM},
+	{"ammo_shells", ITEMLIST_SHELLS, NODE_ITEM},
+	{"ammo_bullets", ITEMLIST_BULLETS, NODE_ITEM},
+	{"ammo_cells", ITEMLIST_CELLS, NODE_ITEM},
+	{"ammo_rockets", ITEMLIST_ROCKETS, NODE_ITEM},
+	{"ammo_homing_missiles", ITEMLIST_HOMINGROCKETS, NODE_ITEM},
+	{"ammo_slugs", ITEMLIST_SLUGS, NODE_ITEM},
+	{"ammo_fuel", ITEMLIST_FUEL, NODE_ITEM},
+	{"item_quad", ITEMLIST_QUADDAMAGE, NODE_ITEM},
+	{"item_invunerability", ITEMLIST_INVULNERABILITY, NODE_ITEM},
+	{"item_silencer", ITEMLIST_SILENCER, NODE_ITEM},
+	{"item_rebreather", ITEMLIST_REBREATHER, NODE_ITEM},
+	{"item_enviornmentsuit", ITEMLIST_ENVIRONMENTSUIT, NODE_ITEM},
+	{"item_ancienthead", ITEMLIST_ANCIENTHEAD, NODE_ITEM},
+	{"item_adrenaline", ITEMLIST_ADRENALINE, NODE_ITEM},
+	{"item_bandolier", ITEMLIST_BANDOLIER, NODE_ITEM},
+	{"item_pack", ITEMLIST_AMMOPACK, NODE_ITEM},
+	{"item_flashlight", ITEMLIST_FLASHLIGHT, NODE_ITEM},
+	{"item_jetpack", ITEMLIST_JETPACK, NODE_ITEM},
+	{"item_freeze", ITEMLIST_STASIS, NODE_ITEM},
+	{"item_datacd", ITEMLIST_DATACD, NODE_ITEM},
+	{"item_powercube", ITEMLIST_POWERCUBE, NODE_ITEM},
+	{"item_pyramidkey", ITEMLIST_PYRAMIDKEY, NODE_ITEM},
+	{"item_dataspinner", ITEMLIST_DATASPINNER, NODE_ITEM},
+	{"item_securitypass", ITEMLIST_SECURITYPASS, NODE_ITEM},
+	{"item_bluekey", ITEMLIST_BLUEKEY, NODE_ITEM},
+	{"item_redkey", ITEMLIST_REDKEY, NODE_ITEM},
+	{"item_commandershead", ITEMLIST_COMMANDERSHEAD, NODE_ITEM},
+	{"item_airstrikemarker", ITEMLIST_AIRSTRIKEMARKER, NODE_ITEM},
+	{"item_health_small", ITEMLIST_HEALTH_SMALL, NODE_ITEM},
+	{"item_health", ITEMLIST_HEALTH_MEDIUM, NODE_ITEM},
+	{"item_health_large", ITEMLIST_HEALTH_LARGE, NODE_ITEM},
+	{"item_health_mega", ITEMLIST_HEALTH_MEGA, NODE_ITEM},
+	{"item_flag_team1", ITEMLIST_FLAG1, NODE_ITEM},
+	{"item_flag_team2", ITEMLIST_FLAG2, NODE_ITEM},
+	{"item_flag_team3", ITEMLIST_FLAG3, NODE_ITEM},
+	{"item_tech1", ITEMLIST_RESISTANCETECH, NODE_ITEM},
+	{"item_tech2", ITEMLIST_STRENGTHTECH, NODE_ITEM},
+	{"item_tech3", ITEMLIST_HASTETECH, NODE_ITEM},
+	{"item_tech4", ITEMLIST_REGENERATIONTECH, NODE_ITEM},
+	{"item_tech5", ITEMLIST_VAMPIRETECH, NODE_ITEM},
+	{"item_tech6", ITEMLIST_AMMOGENTECH, NODE_ITEM},
+	{"item_ammogen_pack", ITEMLIST_AMMOGENPACK, NODE_ITEM},
+	{"func_plat", INVALID, NODE_PLATFORM},
+	{"misc_teleporter", INVALID, NODE_TELEPORTER},
+	{"misc_teleporter_dest", INVALID, NODE_TELEPORTER},
+	{NULL, INVALID, 0}
+};
+
+#define ACE_CLASS_HASH 256 // must be a power of 2
+
+static int16_t ace_class_head[ACE_CLASS_HASH];
+static int16_t ace_class_next[sizeof(ace_classes) / sizeof(ace_classes[0])];
+static qboolean ace_classes_hashed;
+
+static aceclass_t *ACEIT_FindClass(char *classname)
+{
+	int i, h;
 
-	if(strcmp(classname,"item_airstrikemarker")==0)
-		return ITEMLIST_AIRSTRIKEMARKER;
+	if (!ace_classes_hashed)
+	{
+		memset(ace_class_head, INVALID, sizeof(ace_class_head));
+		for (i = 0; ace_classes[i].classname; i++)
+		{
+			h = ED_StringHash(ace_classes[i].classname) & (ACE_CLASS_HASH - 1);
+			ace_class_next[i] = ace_class_head[h];
+			ace_class_head[h] = i;
+		}
+		ace_classes_hashed = true;
+	}
 
-	//if(strcmp(classname,"item_health")==0) // ??
-	//	return ITEMLIST_HEALTH;
+	for (i = ace_class_head[ED_StringHash(classname) & (ACE_CLASS_HASH - 1)]; i != INVALID; i = ace_class_next[i])
+	{
+		if (strcmp(ace_classes[i].classname, classname) == 0)
+			return &ace_classes[i];
+	}
+	return NULL;
+}
 
-	if(strcmp(classname,"item_health_small")==0)
-		return ITEMLIST_HEALTH_SMALL;
+///////////////////////////////////////////////////////////////////////
+// Convert a classname to its index value
+///////////////////////////////////////////////////////////////////////
+int ACEIT_ClassnameToIndex(char *classname)
+{
+	aceclass_t *cls;
 
-	if(strcmp(classname,"item_health")==0)
-		return ITEMLIST_HEALTH_MEDIUM;
+	cls = ACEIT_FindClass(classname);
+	return cls ? cls->item : INVALID;
+}
 
-	if(strcmp(classname,"item_health_large")==0)
-		return ITEMLIST_HEALTH_LARGE;
-	
-	if(strcmp(classname,"item_health_mega")==0)
-		return ITEMLIST_HEALTH_MEGA;
 
-	if(strcmp(classname,"item_flag_team1")==0)
-		return ITEMLIST_FLAG1;
+///////////////////////////////////////////////////////////////////////
+// Respawn tracking
+//
+// SetRespawn and DoRespawn report here, so each entry in item_table
+// knows when its item comes back without looking at the edict. Items
+// waiting to respawn when the table is built are still entered.
+///////////////////////////////////////////////////////////////////////
+static int16_t item_slot[MAX_EDICTS];		// item_table index + 1, by edict
+static float item_respawn[MAX_NODES];		// level.time it is back, 0 if up
 
-	if(strcmp(classname,"item_flag_team2")==0)
-		return ITEMLIST_FLAG2;
+void DoRespawn(edict_t *ent);
 
-	// Knightmare added
-	if(strcmp(classname,"item_flag_team3")==0)
-		return ITEMLIST_FLAG3;
+static int ACEIT_ItemSlot(edict_t *ent)
+{
+	int n;
+
+	n = ent - g_edicts;
+	if (n < 0 || n >= MAX_EDICTS || !item_slot[n])
+		return INVALID;
+	if (item_table[item_slot[n] - 1].ent != ent)
+		return INVALID;
+	return item_slot[n] - 1;
+}
 
-	if(strcmp(classname,"item_tech1")==0)
-		return ITEMLIST_RESISTANCETECH;
+///////////////////////////////////////////////////////////////////////
+// Called from SetRespawn
+///////////////////////////////////////////////////////////////////////
+void ACEIT_ItemTaken(edict_t *ent, float delay)
+{
+	int slot;
 
-	if(strcmp(classname,"item_tech2")==0)
-		return ITEMLIST_STRENGTHTECH;
+	slot = ACEIT_ItemSlot(ent);
+	if (slot != INVALID)
+		item_respawn[slot] = level.time + delay;
+}
 
-	if(strcmp(classname,"item_tech3")==0)
-		return ITEMLIST_HASTETECH;
+///////////////////////////////////////////////////////////////////////
+// Called from DoRespawn, with the member of the team that came back
+///////////////////////////////////////////////////////////////////////
+void ACEIT_ItemRespawned(edict_t *ent)
+{
+	int slot;
 
-	if(strcmp(classname,"item_tech4")==0)
-		return ITEMLIST_REGENERATIONTECH;
+	slot = ACEIT_ItemSlot(ent);
+	if (slot != INVALID)
+		item_respawn[slot] = 0;
+}
 
-	// Knightmare added
-	if(strcmp(classname,"item_tech5")==0)
-		return ITEMLIST_VAMPIRETECH;
+///////////////////////////////////////////////////////////////////////
+// Seconds until item_table[slot] is back: 0 if it is there, -1 if it
+// is gone and not due back.
+///////////////////////////////////////////////////////////////////////
+float ACEIT_ItemRespawnWait(int slot)
+{
+	edict_t *ent;
+
+	ent = item_table[slot].ent;
+	if (!ent || !ent->inuse)
+		return -1;
+	if (ent->solid != SOLID_NOT)
+		return 0;
+	if (item_respawn[slot] > level.time)
+		return item_respawn[slot] - level.time;
+	return -1;
+}
 
-	if(strcmp(classname,"item_tech6")==0)
-		return ITEMLIST_AMMOGENTECH;
+static void ACEIT_AddToTable(edict_t *ent, int item_index)
+{
+	int n;
 
-	if(strcmp(classname,"item_ammogen_pack")==0)
-		return ITEMLIST_AMMOGENPACK;
-	// end Knightmare
+	item_table[num_items].ent = ent;
+	item_table[num_items].item = item_index;
+	item_respawn[num_items] = 0;
+	if ((ent->flags & FL_RESPAWN) && ent->solid == SOLID_NOT && ent->think == DoRespawn)
+		item_respawn[num_items] = ent->nextthink;
 
-	return INVALID;
+	n = ent - g_edicts;
+	if (n < MAX_EDICTS)
+		item_slot[n] = num_items + 1;
 }
 
-
 ///////////////////////////////////////////////////////////////////////
 // Only called once per level, when saved will not be called again
 //
@@ -644,6 +640,7 @@ int ACEIT_ClassnameToIndex(char *classname)
 void ACEIT_BuildItemNodeTable (qboolean rebuild)
 {
 	edict_t *items;
+	aceclass_t *cls;
 	int i,item_index;
 	vec3_t v,v1,v2;
 	int j;
@@ -655,6 +652,7 @@ void ACEIT_BuildItemNodeTable (qboolean rebuild)
 #endif
 	
 	num_items = 0;
+	memset(item_slot, 0, sizeof(item_slot));
 
 	// Add game items
 	//for (items = g_edicts; items < &g_edicts[globals.num_edicts]; items++)
@@ -666,34 +664,27 @@ void ACEIT_BuildItemNodeTable (qboolean rebuild)
 			continue;
 		if (!items->classname)
 			continue;
-		if (items->solid == SOLID_NOT)
-			continue;
+		if (items->solid == SOLID_NOT && !(items->flags & FL_RESPAWN))
+			continue; // taken items that come back are kept
 		
 		
 		/////////////////////////////////////////////////////////////////
 		// Items
 		/////////////////////////////////////////////////////////////////
-		item_index = ACEIT_ClassnameToIndex(items->classname);
+		cls = ACEIT_FindClass(items->classname);
+		item_index = cls ? cls->item : INVALID;
 		
 		////////////////////////////////////////////////////////////////
 		// SPECIAL NAV NODE DROPPING CODE
 		////////////////////////////////////////////////////////////////
-		// Special node dropping for platforms
-		if(strcmp(items->classname,"func_plat")==0)
+		// Special node dropping for platforms and teleporters
+		if(cls && cls->nodetype != NODE_ITEM)
 		{
 			if(!rebuild)
-				ACEND_AddNode(items,NODE_PLATFORM);
+				ACEND_AddNode(items,cls->nodetype);
 			item_index = 99; // to allow to pass the item index test
 		}
 		
-		// Special node dropping for teleporters
-		if(strcmp(items->classname,"misc_teleporter_dest")==0 || strcmp(items->classname,"misc_teleporter")==0)
-		{
-			if(!rebuild)
-				ACEND_AddNode(items,NODE_TELEPORTER);
-			item_index = 99;
-		}
-		
 		#ifdef DEBUG
 		if(item_index == INVALID)
 			fprintf(pOut,"Rejected item: %s node: %d pos: %f %f %f\n",items->classname,item_table[num_items].node,items->s.origin[0],items->s.origin[1],items->s.origin[2]);
@@ -705,8 +696,7 @@ void ACEIT_BuildItemNodeTable (qboolean rebuild)
 			continue;
 
 		// add a pointer to the item entity
-		item_table[num_items].ent = items;
-		item_table[num_items].item = item_index;
+		ACEIT_AddToTable(items, item_index);
 	
 		// If new, add nodes for items
 		if(!rebuild)
@@ -81,6 +81,151 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define STATE_UP			2
 #define STATE_DOWN			3
 
+///////////////////////////////////////////////////////////////////////
+// Movement probes
+//
+// CanMove, SpecialMove, CheckEyes and Wander feel around the bot
+// with a dozen short traces and two pointcontents a frame. Each of
+// those probes has a slot per bot, and a probe whose start and end
+// are within PROBE_EPSILON of the last one it traced, no more than
+// PROBE_FRAMES ago, gets the same answer back. A bot standing
+// against a wall or crouching under a gap stops tracing, and one
+// on the move never traces more than PROBE_COUNT times a frame.
+///////////////////////////////////////////////////////////////////////
+
+#define PROBE_EPSILON		4		// units each end can move
+#define PROBE_FRAMES		3		// before the world may have changed
+
+enum
+{
+	PROBE_MOVE,						// + MOVE_LEFT .. MOVE_BACK
+	PROBE_SPECIAL = PROBE_MOVE + 4,
+	PROBE_CROUCH,
+	PROBE_JUMP,
+	PROBE_EYES_FRONT,
+	PROBE_EYES_RIGHT,
+	PROBE_EYES_LEFT,
+	PROBE_EYES_HEIGHT,
+	PROBE_EYES_UP,
+	PROBE_WATER,					// pointcontents
+	PROBE_LAVA,
+	PROBE_COUNT
+};
+
+typedef struct
+{
+	int		framenum;				// 0 if never traced
+	vec3_t	start, end;
+	trace_t	tr;
+} aceprobe_t;
+
+static aceprobe_t (*ace_probes)[PROBE_COUNT];	// game.maxclients
+
+///////////////////////////////////////////////////////////////////////
+// Called from InitGame, next to ACEAI_InitWeaponPicks. The first
+// probe a bot makes in the new game allocates the table again.
+///////////////////////////////////////////////////////////////////////
+void ACEMV_InitProbes(void)
+{
+	ace_probes = NULL;
+}
+
+static aceprobe_t *ACEMV_FindProbe(edict_t *self, int probe, vec3_t start, vec3_t end)
+{
+	aceprobe_t *p;
+	vec3_t v;
+
+	if(!ace_probes)
+		ace_probes = gi.TagMalloc(game.maxclients * sizeof(ace_probes[0]), TAG_GAME);
+
+	p = &ace_probes[self - g_edicts - 1][probe];
+
+	// framenum from an earlier map is ahead of level.framenum
+	if(!p->framenum || p->framenum > level.framenum || level.framenum - p->framenum > PROBE_FRAMES)
+		return p;
+	if(p->tr.ent && !p->tr.ent->inuse)
+		return p;
+
+	VectorSubtract(start, p->start, v);
+	if(VectorLength(v) > PROBE_EPSILON)
+		return p;
+	VectorSubtract(end, p->end, v);
+	if(VectorLength(v) > PROBE_EPSILON)
+		return p;
+
+	return NULL; // still good
+}
+
+static trace_t ACEMV_Probe(edict_t *self, int probe, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int mask)
+{
+	aceprobe_t *p;
+
+	if(!(p = ACEMV_FindProbe(self, probe, start, end)))
+		return ace_probes[self - g_edicts - 1][probe].tr;
+
+	p->tr = gi.trace(start, mins, maxs, end, self, mask);
+	p->framenum = level.framenum;
+	VectorCopy(start, p->start);
+	VectorCopy(end, p->end);
+	return p->tr;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Two probes with the same box and mask; whichever of them need
+// tracing go out together through G_TraceBatch.
+///////////////////////////////////////////////////////////////////////
+static void ACEMV_ProbePair(edict_t *self, int probe[2], vec3_t start[2], vec3_t end[2], vec3_t mins, vec3_t maxs, int mask, trace_t tr[2])
+{
+	aceprobe_t *p[2];
+	tracerequest_t requests[2];
+	trace_t results[2];
+	int i, n;
+
+	n = 0;
+	for(i=0; i<2; i++)
+	{
+		if(!(p[i] = ACEMV_FindProbe(self, probe[i], start[i], end[i])))
+			continue;
+		requests[n].start = start[i];
+		requests[n].mins = mins;
+		requests[n].maxs = maxs;
+		requests[n].end = end[i];
+		requests[n].passent = self;
+		requests[n].contentmask = mask;
+		n++;
+	}
+	if(n)
+		G_TraceBatch(requests, results, n);
+
+	n = 0;
+	for(i=0; i<2; i++)
+	{
+		if(p[i])
+		{
+			p[i]->tr = results[n++];
+			p[i]->framenum = level.framenum;
+			VectorCopy(start[i], p[i]->start);
+			VectorCopy(end[i], p[i]->end);
+		}
+		tr[i] = ace_probes[self - g_edicts - 1][probe[i]].tr;
+	}
+}
+
+static int ACEMV_ProbeContents(edict_t *self, int probe, vec3_t point)
+{
+	aceprobe_t *p;
+
+	if(!(p = ACEMV_FindProbe(self, probe, point, point)))
+		return ace_probes[self - g_edicts - 1][probe].tr.contents;
+
+	memset(&p->tr, 0, sizeof(p->tr));
+	p->tr.contents = G_EnvContents(point);
+	p->framenum = level.framenum;
+	VectorCopy(point, p->start);
+	VectorCopy(point, p->end);
+	return p->tr.contents;
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Checks if bot can move (really just checking the ground)
 // Also, this is not a real accurate check, but does a
@@ -112,7 +257,7 @@ qboolean ACEMV_CanMove(edict_t *self, int direction)
 	VectorSet(offset, 36, 0, -400);
 	G_ProjectSource (self->s.origin, offset, forward, right, end);
 	
-	tr = gi.trace(start, NULL, NULL, end, self, MASK_OPAQUE);
+	tr = ACEMV_Probe(self, PROBE_MOVE + direction, start, NULL, NULL, end, MASK_OPAQUE);
 	
 	if((tr.fraction > 0.3 && tr.fraction != 1) || tr.contents & (CONTENTS_LAVA|CONTENTS_SLIME))
 	{
@@ -149,7 +294,7 @@ qboolean ACEMV_SpecialMove(edict_t *self, usercmd_t *ucmd)
 	// trace it
 	start[2] += 18; // so they are not jumping all the time
 	end[2] += 18;
-	tr = gi.trace (start, self->mins, self->maxs, end, self, MASK_MONSTERSOLID);
+	tr = ACEMV_Probe(self, PROBE_SPECIAL, start, self->mins, self->maxs, end, MASK_MONSTERSOLID);
 		
 	if(tr.allsolid)
 	{
@@ -160,7 +305,7 @@ qboolean ACEMV_SpecialMove(edict_t *self, usercmd_t *ucmd)
 		// Set up for crouching check
 		VectorCopy(self->maxs,top);
 		top[2] = 0.0; // crouching height
-		tr = gi.trace (start, self->mins, top, end, self, MASK_PLAYERSOLID);
+		tr = ACEMV_Probe(self, PROBE_CROUCH, start, self->mins, top, end, MASK_PLAYERSOLID);
 		
 		// Crouch
 		if(!tr.allsolid) 
@@ -173,7 +318,7 @@ qboolean ACEMV_SpecialMove(edict_t *self, usercmd_t *ucmd)
 		// Check for jump
 		start[2] += 32;
 		end[2] += 32;
-		tr = gi.trace (start, self->mins, self->maxs, end, self, MASK_MONSTERSOLID);
+		tr = ACEMV_Probe(self, PROBE_JUMP, start, self->mins, self->maxs, end, MASK_MONSTERSOLID);
 
 		if(!tr.allsolid)
 		{	
@@ -203,6 +348,9 @@ qboolean ACEMV_CheckEyes(edict_t *self, usercmd_t *ucmd)
 	vec3_t  dir,offset;
 
 	trace_t traceRight,traceLeft,traceUp, traceFront; // for eyesight
+	int eyes[2] = {PROBE_EYES_RIGHT, PROBE_EYES_LEFT};
+	vec3_t eyestart[2], eyeend[2];
+	trace_t eyetrace[2];
 
 	// Get current angle and set up "eyes"
 	VectorCopy(self->s.angles,dir);
@@ -220,7 +368,7 @@ qboolean ACEMV_CheckEyes(edict_t *self, usercmd_t *ucmd)
 	// Ladder code
 	VectorSet(offset,36,0,0); // set as high as possible
 	G_ProjectSource (self->s.origin, offset, forward, right, upend);
-	traceFront = gi.trace(self->s.origin, self->mins, self->maxs, upend, self, MASK_OPAQUE);
+	traceFront = ACEMV_Probe(self, PROBE_EYES_FRONT, self->s.origin, self->mins, self->maxs, upend, MASK_OPAQUE);
 		
 	if(traceFront.contents & 0x8000000) // using detail brush here cuz sometimes it does not pick up ladders...??
 	{
@@ -243,8 +391,13 @@ qboolean ACEMV_CheckEyes(edict_t *self, usercmd_t *ucmd)
 	//VectorSet(offset, 0, -18, 4);
 	G_ProjectSource (self->s.origin, offset, forward, right, rightstart);
 
-	traceRight = gi.trace(rightstart, NULL, NULL, focalpoint, self, MASK_OPAQUE);
-	traceLeft = gi.trace(leftstart, NULL, NULL, focalpoint, self, MASK_OPAQUE);
+	VectorCopy(rightstart, eyestart[0]);
+	VectorCopy(leftstart, eyestart[1]);
+	VectorCopy(focalpoint, eyeend[0]);
+	VectorCopy(focalpoint, eyeend[1]);
+	ACEMV_ProbePair(self, eyes, eyestart, eyeend, NULL, NULL, MASK_OPAQUE, eyetrace);
+	traceRight = eyetrace[0];
+	traceLeft = eyetrace[1];
 
 	// Wall checking code, this will degenerate progressivly so the least cost 
 	// check will be done first.
@@ -258,11 +411,11 @@ qboolean ACEMV_CheckEyes(edict_t *self, usercmd_t *ucmd)
 
 		VectorSet(offset,0,0,200); // scan for height above head
 		G_ProjectSource (self->s.origin, offset, forward, right, upend);
-		traceUp = gi.trace(upstart, NULL, NULL, upend, self, MASK_OPAQUE);
+		traceUp = ACEMV_Probe(self, PROBE_EYES_HEIGHT, upstart, NULL, NULL, upend, MASK_OPAQUE);
 			
 		VectorSet(offset,200,0,200*traceUp.fraction-5); // set as high as possible
 		G_ProjectSource (self->s.origin, offset, forward, right, upend);
-		traceUp = gi.trace(upstart, NULL, NULL, upend, self, MASK_OPAQUE);
+		traceUp = ACEMV_Probe(self, PROBE_EYES_UP, upstart, NULL, NULL, upend, MASK_OPAQUE);
 
 		// If the upper trace is not open, we need to turn.
 		if(traceUp.fraction != 1)
@@ -432,7 +585,7 @@ void ACEMV_Move(edict_t *self, usercmd_t *ucmd)
 	if(next_node_type == NODE_GRAPPLE)
 	{
 		ACEMV_ChangeBotAngle(self);
-		ACEIT_ChangeWeapon(self,FindItem("grapple"));	
+		ACEIT_ChangeWeapon(self,&itemlist[grapple_index]);	
 		ucmd->buttons = BUTTON_ATTACK;
 		return;
 	}
@@ -519,7 +672,7 @@ void ACEMV_Move(edict_t *self, usercmd_t *ucmd)
 		ACEMV_ChangeBotAngle(self);
 
 		// If the next node is not in the water, then move up to get out.
-		if(next_node_type != NODE_WATER && !(gi.pointcontents(nodes[self->next_node].origin) & MASK_WATER)) // Exit water
+		if(next_node_type != NODE_WATER && !(G_EnvContents(nodes[self->next_node].origin) & MASK_WATER)) // Exit water
 			ucmd->upmove = 400;
 		
 		ucmd->forwardmove = 300;
@@ -595,7 +748,7 @@ void ACEMV_Wander(edict_t *self, usercmd_t *ucmd)
 	VectorCopy(self->s.origin,temp);
 	temp[2]+=24;
 
-	if(gi.pointcontents (temp) & MASK_WATER)
+	if(ACEMV_ProbeContents(self, PROBE_WATER, temp) & MASK_WATER)
 	{
 		// If drowning and no node, move up
 		if(self->client->next_drown_time > 0)
@@ -615,7 +768,7 @@ void ACEMV_Wander(edict_t *self, usercmd_t *ucmd)
 	// Lava?
 	////////////////////////////////
 	temp[2]-=48;	
-	if(gi.pointcontents(temp) & (CONTENTS_LAVA|CONTENTS_SLIME))
+	if(ACEMV_ProbeContents(self, PROBE_LAVA, temp) & (CONTENTS_LAVA|CONTENTS_SLIME))
 	{
 		//	safe_bprintf(PRINT_MEDIUM,"lava jump\n");
 		self->s.angles[YAW] += random() * 360 - 180; 
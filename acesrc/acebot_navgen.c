@@ -0,0 +1,351 @@
+/*
+Copyright (C) 1998 Steve Yeager
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+///////////////////////////////////////////////////////////////////////
+//
+//  ACE - Quake II Bot
+//
+//  acebot_navgen.c - Builds a node table for the current map from
+//                    its collision data, so bots can find their way
+//                    around a map nobody has walked yet.
+//
+///////////////////////////////////////////////////////////////////////
+
+#include "../g_local.h"
+#include "acebot.h"
+
+///////////////////////////////////////////////////////////////////////
+// NODE GENERATION
+//
+// "sv acegen" throws the current nodes away and starts from the item,
+// platform and teleporter nodes ACEIT_BuildItemNodeTable drops. It
+// then walks the floor outward from every player spawn and item on a
+// NAVGEN_STEP grid, the way a player would: a step succeeds if the
+// player box fits through at step height and finds floor no more than
+// NAVGEN_DROP below. Each floor spot becomes a move (or water) node,
+// linked both ways to the spot it was reached from, or one way if the
+// step was a drop too high to climb back.
+//
+// Item, platform and teleporter nodes are then linked to the move
+// nodes they can be seen from, and teleporters to their destinations.
+// Links are written as first hops the way node files store them and
+// ACEND_ResolveAllPaths fills in the rest, after which the table is
+// saved as a normal .nod file.
+//
+// Ladders and jumps aren't found, so those still have to be learned
+// by playing. The run costs a few traces per node and happens once, at
+// the command.
+///////////////////////////////////////////////////////////////////////
+
+#define NAVGEN_STEP		96		// grid spacing, below NODE_DENSITY
+#define NAVGEN_STAIR	18		// STEPSIZE
+#define NAVGEN_DROP		64		// highest drop that is still walked
+#define NAVGEN_LINK		160		// range for linking item nodes
+#define NAVGEN_HASH		2048	// must be a power of 2
+
+static vec3_t navgen_mins = {-16, -16, -24};
+static vec3_t navgen_maxs = { 16,  16,  32};
+
+static int16_t navgen_hash[NAVGEN_HASH];	// first node in each bucket
+static int16_t navgen_next[MAX_NODES];
+static int16_t navgen_queue[MAX_NODES];
+static int navgen_links;
+static int navgen_traces;
+
+static int NavGen_Key(vec3_t origin)
+{
+	int x, y, z;
+
+	x = (int)floor(origin[0] / NAVGEN_STEP + 0.5);
+	y = (int)floor(origin[1] / NAVGEN_STEP + 0.5);
+	z = (int)floor(origin[2] / (NAVGEN_DROP / 2));
+	return (((unsigned)x * 73856093u) ^ ((unsigned)y * 19349663u) ^ ((unsigned)z * 83492791u)) & (NAVGEN_HASH - 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+// A move node already standing in the grid cell of origin, or INVALID
+///////////////////////////////////////////////////////////////////////
+static int NavGen_FindCell(vec3_t origin)
+{
+	int i;
+	vec3_t v;
+
+	for (i = navgen_hash[NavGen_Key(origin)]; i != INVALID; i = navgen_next[i])
+	{
+		VectorSubtract(nodes[i].origin, origin, v);
+		if (fabs(v[0]) < NAVGEN_STEP / 2 && fabs(v[1]) < NAVGEN_STEP / 2 && fabs(v[2]) < NAVGEN_DROP / 2)
+			return i;
+	}
+	return INVALID;
+}
+
+static trace_t NavGen_Trace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end)
+{
+	navgen_traces++;
+	return gi.trace(start, mins, maxs, end, NULL, MASK_PLAYERSOLID);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Put the player box on the floor below origin. Returns false if
+// there is none within range, or it is too steep to stand on.
+///////////////////////////////////////////////////////////////////////
+static qboolean NavGen_Floor(vec3_t origin, float range, vec3_t out)
+{
+	trace_t tr;
+	vec3_t end;
+
+	VectorCopy(origin, end);
+	end[2] -= range;
+	tr = NavGen_Trace(origin, navgen_mins, navgen_maxs, end);
+
+	if (tr.startsolid || tr.allsolid)
+		return false;
+
+	if (tr.fraction == 1.0)
+	{
+		// swimming needs no floor
+		if (gi.pointcontents(origin) & MASK_WATER)
+		{
+			VectorCopy(origin, out);
+			return true;
+		}
+		return false;
+	}
+
+	if (tr.plane.normal[2] < 0.7)
+		return false;
+
+	VectorCopy(tr.endpos, out);
+
+	VectorCopy(out, end);
+	end[2] -= 18;
+	if (gi.pointcontents(end) & (CONTENTS_LAVA|CONTENTS_SLIME))
+		return false; // no nodes in slime
+
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Walk from one floor spot to the spot dx, dy away. Returns 0 if the
+// way is blocked, 1 for a step that can be walked back, 2 for a drop
+// that can't.
+///////////////////////////////////////////////////////////////////////
+static int NavGen_Step(vec3_t from, float dx, float dy, vec3_t out)
+{
+	trace_t tr;
+	vec3_t start, end;
+
+	VectorCopy(from, start);
+	start[2] += NAVGEN_STAIR;
+	VectorCopy(start, end);
+	end[0] += dx;
+	end[1] += dy;
+
+	tr = NavGen_Trace(start, navgen_mins, navgen_maxs, end);
+	if (tr.startsolid || tr.fraction < 1.0)
+		return 0;
+
+	if (!NavGen_Floor(end, NAVGEN_STAIR + NAVGEN_DROP, out))
+		return 0;
+
+	return (from[2] - out[2] > NAVGEN_STAIR) ? 2 : 1;
+}
+
+static void NavGen_Link(int from, int to)
+{
+	if (from == to || from <= 0 || to <= 0)
+		return;
+	if (PATH_TABLE(from, to) == to)
+		return;
+	PATH_TABLE(from, to) = to;
+	navgen_links++;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Drop a move or water node on a floor spot
+///////////////////////////////////////////////////////////////////////
+static int NavGen_AddNode(vec3_t origin)
+{
+	static edict_t probe;
+	int node, h;
+
+	VectorCopy(origin, probe.s.origin);
+	node = ACEND_AddNode(&probe, (gi.pointcontents(origin) & MASK_WATER) ? NODE_WATER : NODE_MOVE);
+	if (node <= 0)
+		return INVALID; // table is full
+
+	h = NavGen_Key(nodes[node].origin);
+	navgen_next[node] = navgen_hash[h];
+	navgen_hash[h] = node;
+	return node;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Start a walk at origin, unless a node already covers it
+///////////////////////////////////////////////////////////////////////
+static void NavGen_Seed(vec3_t origin, int *tail)
+{
+	vec3_t spot;
+	int node;
+
+	if (!NavGen_Floor(origin, 128, spot))
+		return;
+	if (NavGen_FindCell(spot) != INVALID)
+		return;
+	node = NavGen_AddNode(spot);
+	if (node != INVALID)
+		navgen_queue[(*tail)++] = node;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Walk the floor outward from every seed, breadth first
+///////////////////////////////////////////////////////////////////////
+static void NavGen_Walk(void)
+{
+	static char *seeds[] = {
+		"info_player_start", "info_player_deathmatch", "info_player_coop",
+		"info_player_team1", "info_player_team2", "info_player_team3", NULL
+	};
+	static float dirs[8][2] = {
+		{1,0}, {-1,0}, {0,1}, {0,-1}, {1,1}, {1,-1}, {-1,1}, {-1,-1}
+	};
+	edict_t *ent;
+	vec3_t spot;
+	int head, tail, i, k, cur, next, step;
+
+	head = tail = 0;
+
+	for (i = 0; seeds[i]; i++)
+	{
+		for (ent = NULL; (ent = G_Find(ent, FOFS(classname), seeds[i])) != NULL; )
+			NavGen_Seed(ent->s.origin, &tail);
+	}
+	for (i = 0; i < num_items; i++)
+	{
+		if (item_table[i].ent)
+			NavGen_Seed(item_table[i].ent->s.origin, &tail);
+	}
+
+	while (head < tail)
+	{
+		cur = navgen_queue[head++];
+
+		for (k = 0; k < 8; k++)
+		{
+			step = NavGen_Step(nodes[cur].origin, dirs[k][0] * NAVGEN_STEP, dirs[k][1] * NAVGEN_STEP, spot);
+			if (!step)
+				continue;
+
+			next = NavGen_FindCell(spot);
+			if (next == INVALID)
+			{
+				next = NavGen_AddNode(spot);
+				if (next == INVALID)
+					return;
+				navgen_queue[tail++] = next;
+			}
+
+			NavGen_Link(cur, next);
+			if (step == 1)
+				NavGen_Link(next, cur);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Link the item, platform and teleporter nodes to the move nodes
+// around them, and teleporters to where they lead.
+///////////////////////////////////////////////////////////////////////
+static void NavGen_LinkSpecial(void)
+{
+	static vec3_t mins = {-15, -15, -15};
+	static vec3_t maxs = { 15,  15,  15};
+	int i, j, k, count;
+	trace_t tr;
+	vec3_t v;
+	edict_t *dest;
+
+	count = numnodes;
+	for (i = 1; i < count; i++)
+	{
+		if (nodes[i].type != NODE_ITEM && nodes[i].type != NODE_PLATFORM && nodes[i].type != NODE_TELEPORTER)
+			continue;
+
+		for (j = 1; j < count; j++)
+		{
+			if (nodes[j].type != NODE_MOVE && nodes[j].type != NODE_WATER)
+				continue;
+			VectorSubtract(nodes[j].origin, nodes[i].origin, v);
+			if (DotProduct(v, v) > NAVGEN_LINK * NAVGEN_LINK)
+				continue;
+
+			tr = NavGen_Trace(nodes[j].origin, mins, maxs, nodes[i].origin);
+			if (tr.fraction < 1.0 || tr.startsolid)
+				continue;
+
+			NavGen_Link(j, i);
+			NavGen_Link(i, j);
+		}
+	}
+
+	for (k = 0; k < num_items; k++)
+	{
+		if (!item_table[k].ent || !item_table[k].ent->target)
+			continue;
+		if (strcmp(item_table[k].ent->classname, "misc_teleporter"))
+			continue;
+		dest = G_Find(NULL, FOFS(targetname), item_table[k].ent->target);
+		if (!dest)
+			continue;
+		for (j = 0; j < num_items; j++)
+		{
+			if (item_table[j].ent == dest)
+				NavGen_Link(item_table[k].node, item_table[j].node);
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// "sv acegen"
+///////////////////////////////////////////////////////////////////////
+void ACEND_GenerateNodes(void)
+{
+	int first;
+
+	safe_bprintf(PRINT_HIGH, "ACE: Generating nodes for %s...\n", level.mapname);
+
+	ACEND_InitNodes();
+	ACEIT_BuildItemNodeTable(false);
+	first = numnodes;
+
+	memset(navgen_hash, INVALID, sizeof(navgen_hash));
+	navgen_links = 0;
+	navgen_traces = 0;
+
+	NavGen_Walk();
+	NavGen_LinkSpecial();
+
+	safe_bprintf(PRINT_HIGH, "ACE: %d item nodes, %d walked, %d links, %d traces\n",
+		first - 1, numnodes - first, navgen_links, navgen_traces);
+
+	ACEND_ResolveAllPaths();
+	ACEND_ResetNodeGrid();
+	ACEND_SaveNodes();
+}
@@ -77,9 +77,13 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "acebot.h"
 #ifdef WIN32
 #include <direct.h>
+#include <windows.h>
 #else
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
 #endif
 
 // flags
@@ -97,75 +101,400 @@ int show_path_to = -1;
 
 // array for node data
 node_t nodes[MAX_NODES]; 
-int16_t path_table[MAX_NODES][MAX_NODES];
+
+// Next-hop table, path_size x path_size, stored row by row.
+// It starts small and grows with numnodes instead of always
+// holding MAX_NODES x MAX_NODES entries.
+int16_t *path_table;
+int path_size;
+
+// Shortest path length in links for each entry of path_table.
+// Same layout; INVALID where there is no path (and on the diagonal).
+int16_t *cost_table;
+
+// With ace_map_nodes set, path_table may point into a read-only
+// mapping of the node file instead (see ACEND_MapNodeFile).
+static uint8_t *path_map;
+static int path_map_length;
+static int16_t path_scratch[MAX_NODES + 1];
+
+cvar_t *ace_map_nodes;
 
 ///////////////////////////////////////////////////////////////////////
-// NODE INFORMATION FUNCTIONS
+// PATH TABLE STORAGE
 ///////////////////////////////////////////////////////////////////////
 
 ///////////////////////////////////////////////////////////////////////
-// Determin cost of moving from one node to another
+// Map a whole file read-only. Returns NULL if it can't be.
 ///////////////////////////////////////////////////////////////////////
-int ACEND_FindCost(int from, int to)
+static uint8_t *ACEND_MapFile(char *filename, int *length)
 {
-	int curnode;
-	int cost=1; // Shortest possible is 1
+	uint8_t *base;
+#ifdef WIN32
+	HANDLE file, mapping;
+	DWORD size;
+
+	file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+	size = GetFileSize(file, NULL);
+	if (size == INVALID_FILE_SIZE || size == 0)
+	{
+		CloseHandle(file);
+		return NULL;
+	}
+	mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+	// the view keeps the mapping open
+	base = (uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!base)
+		return NULL;
+	*length = (int)size;
+#else
+	struct stat st;
+	int fd;
 
-	// If we can not get there then return invalid
-	if (path_table[from][to] == INVALID)
-		return INVALID;
+	fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+	if (fstat(fd, &st) < 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return NULL;
+	}
+	base = (uint8_t *)mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == (uint8_t *)MAP_FAILED)
+		return NULL;
+	*length = (int)st.st_size;
+#endif
+	return base;
+}
 
-	// Otherwise check the path and return the cost
-	curnode = path_table[from][to];
+static void ACEND_UnmapFile(uint8_t *base, int length)
+{
+#ifdef WIN32
+	UnmapViewOfFile(base);
+#else
+	munmap(base, length);
+#endif
+}
 
-	// Find a path (linear time, very fast)
-	while(curnode != to)
+///////////////////////////////////////////////////////////////////////
+// Give this server its own copy of a mapped path table, before the
+// first change to it. Other servers keep reading the file.
+///////////////////////////////////////////////////////////////////////
+static void ACEND_UnshareNodes(void)
+{
+	int16_t *table;
+
+	if (!path_map)
+		return;
+
+	table = (int16_t *)gi.TagMalloc(path_size * path_size * sizeof(int16_t), TAG_GAME);
+	memcpy(table, path_table, path_size * path_size * sizeof(int16_t));
+	ACEND_UnmapFile(path_map, path_map_length);
+	path_map = NULL;
+	path_table = table;
+
+	if (debug_mode)
+		debug_printf("ACE: path table copied out of the node file\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+// Let go of the path and cost tables, whether mapped or allocated
+///////////////////////////////////////////////////////////////////////
+static void ACEND_FreePathTable(void)
+{
+	if (path_map)
+		ACEND_UnmapFile(path_map, path_map_length);
+	else if (path_table)
+		gi.TagFree(path_table);
+	if (cost_table)
+		gi.TagFree(cost_table);
+	path_map = NULL;
+	path_table = NULL;
+	cost_table = NULL;
+	path_size = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Copy a table into a larger one, padding the new entries with INVALID
+///////////////////////////////////////////////////////////////////////
+static int16_t *ACEND_CopyTable(int16_t *table, int newsize)
+{
+	int16_t *newtable;
+	int i;
+
+	newtable = (int16_t *)gi.TagMalloc(newsize * newsize * sizeof(int16_t), TAG_GAME);
+	memset(newtable, INVALID, newsize * newsize * sizeof(int16_t));
+
+	if (table)
 	{
-		curnode = path_table[curnode][to];
-		if(curnode == INVALID) // something has corrupted the path abort
-			return INVALID;
-		cost++;
+		for (i = 0; i < path_size; i++)
+			memcpy(&newtable[i * newsize], &table[i * path_size], path_size * sizeof(int16_t));
+		if (path_map && table == path_table)
+		{
+			ACEND_UnmapFile(path_map, path_map_length);
+			path_map = NULL;
+		}
+		else
+			gi.TagFree(table);
 	}
-	
-	return cost;
+
+	return newtable;
 }
 
 ///////////////////////////////////////////////////////////////////////
-// Find a close node to the player within dist.
+// Make sure the path and cost tables have room for at least count
+// nodes. New entries are INVALID; existing links are kept.
+///////////////////////////////////////////////////////////////////////
+void ACEND_GrowPathTable(int count)
+{
+	int newsize;
+
+	if (count <= path_size)
+		return;
+
+	newsize = path_size ? path_size : 64;
+	while (newsize < count)
+		newsize *= 2;
+	if (newsize > MAX_NODES)
+		newsize = MAX_NODES;
+
+	path_table = ACEND_CopyTable(path_table, newsize);
+	cost_table = ACEND_CopyTable(cost_table, newsize);
+	path_size = newsize;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Called from InitGame. Unmaps a node file left mapped by the last
+// game and starts the tables over at their smallest size.
+///////////////////////////////////////////////////////////////////////
+void ACEND_InitPathTable(void)
+{
+	if (path_map)
+		ACEND_UnmapFile(path_map, path_map_length);
+	path_map = NULL;
+	path_table = NULL;
+	cost_table = NULL;
+	path_size = 0;
+	ACEND_GrowPathTable(1);
+}
+
+///////////////////////////////////////////////////////////////////////
+// NODE GRID
 //
-// Faster than looking for the closest node, but not very 
-// accurate.
+// Nodes are bucketed into NODE_DENSITY sized cells so a search only
+// looks at the cells that overlap its range. Candidates are then
+// traced nearest first, so the search stops at the first visible one
+// instead of tracing every node that beats the current best.
 ///////////////////////////////////////////////////////////////////////
-int ACEND_FindCloseReachableNode(edict_t *self, int range, int type)
+#define NODE_GRID_CELL		NODE_DENSITY
+#define NODE_GRID_HASH		1024
+
+static int16_t node_grid[NODE_GRID_HASH];	// first node in each bucket
+static int16_t node_grid_next[MAX_NODES];
+static int node_grid_count;					// nodes linked so far
+
+// scratch space for the search
+static int node_grid_mark[MAX_NODES];
+static int node_grid_stamp;
+static int16_t node_grid_list[MAX_NODES];
+static float node_grid_dist[MAX_NODES];
+
+// per frame trace budget for the node searches
+cvar_t *ace_trace_budget;
+static int node_trace_frame;
+static int node_trace_count;
+
+static int ACEND_GridHash(int x, int y, int z)
+{
+	return (((unsigned)x * 73856093u) ^ ((unsigned)y * 19349663u) ^ ((unsigned)z * 83492791u)) & (NODE_GRID_HASH - 1);
+}
+
+static int ACEND_GridCoord(float f)
+{
+	return (int)floor(f / NODE_GRID_CELL);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Throw the grid away, it is rebuilt on the next search. Call this
+// whenever existing nodes move or the node array is replaced.
+///////////////////////////////////////////////////////////////////////
+void ACEND_ResetNodeGrid(void)
+{
+	node_grid_count = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Link any nodes added since the last search. Nodes are only linked
+// once they are counted in numnodes, after ACEND_AddNode is done
+// adjusting their origin.
+///////////////////////////////////////////////////////////////////////
+static void ACEND_UpdateNodeGrid(void)
+{
+	int h;
+
+	if (node_grid_count == 0)
+		memset(node_grid, INVALID, sizeof(node_grid));
+
+	for ( ; node_grid_count < numnodes; node_grid_count++)
+	{
+		h = ACEND_GridHash(ACEND_GridCoord(nodes[node_grid_count].origin[0]),
+			ACEND_GridCoord(nodes[node_grid_count].origin[1]),
+			ACEND_GridCoord(nodes[node_grid_count].origin[2]));
+		node_grid_next[node_grid_count] = node_grid[h];
+		node_grid[h] = node_grid_count;
+	}
+}
+
+static int ACEND_NodeDistCompare(const void *a, const void *b)
 {
+	int n1 = *(const int16_t *)a;
+	int n2 = *(const int16_t *)b;
+
+	if (node_grid_dist[n1] < node_grid_dist[n2])
+		return -1;
+	if (node_grid_dist[n1] > node_grid_dist[n2])
+		return 1;
+	return n1 - n2;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Fill node_grid_list with the nodes of the given type that are
+// closer than the squared distance rng, nearest first. Returns the
+// number found.
+///////////////////////////////////////////////////////////////////////
+static int ACEND_GatherNodes(vec3_t origin, float range, float rng, int type)
+{
+	int mins[3], maxs[3];
+	int x, y, z, i, num;
 	vec3_t v;
-	int i;
-	trace_t tr;
 	float dist;
 
-	range *= range;
+	ACEND_UpdateNodeGrid();
 
-	for(i=0;i<numnodes;i++)
+	for (i = 0; i < 3; i++)
 	{
-		if(type == NODE_ALL || type == nodes[i].type) // check node type
+		mins[i] = ACEND_GridCoord(origin[i] - range);
+		maxs[i] = ACEND_GridCoord(origin[i] + range);
+	}
+
+	// different cells can share a bucket, so mark what we have seen
+	if (++node_grid_stamp == 0)
+	{
+		memset(node_grid_mark, 0, sizeof(node_grid_mark));
+		node_grid_stamp = 1;
+	}
+
+	num = 0;
+	for (x = mins[0]; x <= maxs[0]; x++)
+	for (y = mins[1]; y <= maxs[1]; y++)
+	for (z = mins[2]; z <= maxs[2]; z++)
+	{
+		for (i = node_grid[ACEND_GridHash(x, y, z)]; i != INVALID; i = node_grid_next[i])
 		{
-		
-			VectorSubtract(nodes[i].origin,self->s.origin,v); // subtract first
+			if (node_grid_mark[i] == node_grid_stamp)
+				continue;
+			node_grid_mark[i] = node_grid_stamp;
 
+			if (type != NODE_ALL && type != nodes[i].type) // check node type
+				continue;
+
+			VectorSubtract(nodes[i].origin, origin, v); // subtract first
 			dist = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
 
-			if(dist < range) // square range instead of sqrt
+			if (dist < rng) // square range instead of sqrt
 			{
-				// make sure it is visible
-				//trace = gi.trace (self->s.origin, vec3_origin, vec3_origin, nodes[i].origin, self, MASK_OPAQUE);
-				tr = gi.trace (self->s.origin, self->mins, self->maxs, nodes[i].origin, self, MASK_OPAQUE);
-
-				if(tr.fraction == 1.0)
-					return i;
+				node_grid_dist[i] = dist;
+				node_grid_list[num++] = i;
 			}
 		}
 	}
 
+	qsort(node_grid_list, num, sizeof(node_grid_list[0]), ACEND_NodeDistCompare);
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Count a trace against this frame's budget
+///////////////////////////////////////////////////////////////////////
+static trace_t ACEND_NodeTrace(vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *self)
+{
+	if (node_trace_frame != level.framenum)
+	{
+		node_trace_frame = level.framenum;
+		node_trace_count = 0;
+	}
+	node_trace_count++;
+
+	return gi.trace (start, mins, maxs, end, self, MASK_OPAQUE);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Is there budget left this frame for work that can wait, like
+// picking a new long range goal? Bots that are turned away try again
+// next frame, which staggers them when many want to think at once.
+///////////////////////////////////////////////////////////////////////
+qboolean ACEND_TraceBudgetLeft(void)
+{
+	if (!ace_trace_budget || ace_trace_budget->value <= 0)
+		return true;
+
+	if (node_trace_frame != level.framenum)
+		return true;
+
+	return (node_trace_count < ace_trace_budget->value);
+}
+
+///////////////////////////////////////////////////////////////////////
+// NODE INFORMATION FUNCTIONS
+///////////////////////////////////////////////////////////////////////
+
+///////////////////////////////////////////////////////////////////////
+// Determin cost of moving from one node to another
+///////////////////////////////////////////////////////////////////////
+int ACEND_FindCost(int from, int to)
+{
+	// If we can not get there then return invalid
+	if (PATH_TABLE(from,to) == INVALID)
+		return INVALID;
+
+	// cost_table is kept up to date with path_table, no need to walk the path
+	return COST_TABLE(from,to);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Find a close node to the player within dist.
+//
+// Faster than looking for the closest node, but not very 
+// accurate.
+///////////////////////////////////////////////////////////////////////
+int ACEND_FindCloseReachableNode(edict_t *self, int range, int type)
+{
+	int i, num;
+	trace_t tr;
+	float rng;
+
+	rng = (float)(range * range);
+
+	num = ACEND_GatherNodes(self->s.origin, range, rng, type);
+
+	for(i=0;i<num;i++)
+	{
+		// make sure it is visible
+		//trace = gi.trace (self->s.origin, vec3_origin, vec3_origin, nodes[i].origin, self, MASK_OPAQUE);
+		tr = ACEND_NodeTrace (self->s.origin, self->mins, self->maxs, nodes[node_grid_list[i]].origin, self);
+
+		if(tr.fraction == 1.0)
+			return node_grid_list[i];
+	}
+
 	return -1;
 }
 
@@ -174,11 +503,7 @@ int ACEND_FindCloseReachableNode(edict_t *self, int range, int type)
 ///////////////////////////////////////////////////////////////////////
 int ACEND_FindClosestReachableNode(edict_t *self, int range, int type)
 {
-	int i;
-	float closest = 99999;
-	float dist;
-	int node=-1;
-	vec3_t v;
+	int i, num;
 	trace_t tr;
 	float rng;
 	vec3_t maxs,mins;
@@ -196,29 +521,24 @@ int ACEND_FindClosestReachableNode(edict_t *self, int range, int type)
 		mins[2] += 18; // Stepsize
 
 	rng = (float)(range * range); // square range for distance comparison (eliminate sqrt)	
+
+	// the old linear search started with a best distance of 99999,
+	// so nothing farther than that was ever picked
+	if(rng > 99999)
+		rng = 99999;
 	
-	for(i=0;i<numnodes;i++)
-	{		
-		if(type == NODE_ALL || type == nodes[i].type) // check node type
-		{
-			VectorSubtract(nodes[i].origin, self->s.origin,v); // subtract first
+	num = ACEND_GatherNodes(self->s.origin, range, rng, type);
 
-			dist = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
-		
-			if(dist < closest && dist < rng) 
-			{
-				// make sure it is visible
-				tr = gi.trace (self->s.origin, mins, maxs, nodes[i].origin, self, MASK_OPAQUE);
-				if(tr.fraction == 1.0)
-				{
-					node = i;
-					closest = dist;
-				}
-			}
-		}
+	// nearest first, so the first visible node is the closest
+	for(i=0;i<num;i++)
+	{		
+		// make sure it is visible
+		tr = ACEND_NodeTrace (self->s.origin, mins, maxs, nodes[node_grid_list[i]].origin, self);
+		if(tr.fraction == 1.0)
+			return node_grid_list[i];
 	}
 	
-	return node;
+	return -1;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -287,10 +607,10 @@ qboolean ACEND_FollowPath(edict_t *self)
 			
 			ACEAI_PickLongRangeGoal(self); // Pick a new goal
 		}
-		else
+		else if(self->goal_node != INVALID)
 		{
 			self->current_node = self->next_node;
-			self->next_node = path_table[self->current_node][self->goal_node];
+			self->next_node = PATH_TABLE(self->current_node,self->goal_node);
 		}
 	}
 	
@@ -328,7 +648,7 @@ void ACEND_GrapFired(edict_t *self)
 			closest_node = ACEND_AddNode(self,NODE_GRAPPLE);
 			 
 			// Add an edge
-			ACEND_UpdateNodeEdge(self->owner->last_node,closest_node);
+			ACEND_QueueNodeEdge(self->owner->last_node,closest_node);
 		
 			self->owner->last_node = closest_node;
 		}
@@ -346,7 +666,7 @@ qboolean ACEND_CheckForLadder(edict_t *self)
 	int closest_node;
 
 	// If there is a ladder and we are moving up, see if we should add a ladder node
-	if (gi.pointcontents(self->s.origin) & CONTENTS_LADDER && self->velocity[2] > 0)
+	if (G_EnvContents(self->s.origin) & CONTENTS_LADDER && self->velocity[2] > 0)
 	{
 		//debug_printf("contents: %x\n",tr.contents);
 
@@ -356,14 +676,14 @@ qboolean ACEND_CheckForLadder(edict_t *self)
 			closest_node = ACEND_AddNode(self,NODE_LADDER);
 	
 			// Now add link
-		    ACEND_UpdateNodeEdge(self->last_node,closest_node);	   
+		    ACEND_QueueNodeEdge(self->last_node,closest_node);	   
 			
 			// Set current to last
 			self->last_node = closest_node;
 		}
 		else
 		{
-			ACEND_UpdateNodeEdge(self->last_node,closest_node);	   
+			ACEND_QueueNodeEdge(self->last_node,closest_node);	   
 			self->last_node = closest_node; // set visited to last
 		}
 		return true;
@@ -405,7 +725,7 @@ void ACEND_PathMap(edict_t *self)
 	////////////////////////////////////////////////////////
 	VectorCopy(self->s.origin,v);
 	v[2] -= 18;
-	if(gi.pointcontents(v) & (CONTENTS_LAVA|CONTENTS_SLIME))
+	if(G_EnvContents(v) & (CONTENTS_LAVA|CONTENTS_SLIME))
 		return; // no nodes in slime
 	
     ////////////////////////////////////////////////////////
@@ -421,7 +741,7 @@ void ACEND_PathMap(edict_t *self)
 		
 		// Now add link
 		if(self->last_node != -1)
-			ACEND_UpdateNodeEdge(self->last_node, closest_node);	   
+			ACEND_QueueNodeEdge(self->last_node, closest_node);	   
 
 		self->is_jumping = false;
 		return;
@@ -447,7 +767,7 @@ void ACEND_PathMap(edict_t *self)
 
 		// Here we want to add links
 		if(closest_node != self->last_node && self->last_node != INVALID)
-			ACEND_UpdateNodeEdge(self->last_node,closest_node);	   
+			ACEND_QueueNodeEdge(self->last_node,closest_node);	   
 
 		self->last_node = closest_node; // set visited to last
 		return;
@@ -466,11 +786,11 @@ void ACEND_PathMap(edict_t *self)
 		
 		// Now add link
 		if(self->last_node != -1)
-			ACEND_UpdateNodeEdge(self->last_node, closest_node);	   
+			ACEND_QueueNodeEdge(self->last_node, closest_node);	   
 			
 	 }
 	 else if(closest_node != self->last_node && self->last_node != INVALID)
-	 	ACEND_UpdateNodeEdge(self->last_node,closest_node);	   
+	 	ACEND_QueueNodeEdge(self->last_node,closest_node);	   
 	
 	 self->last_node = closest_node; // set visited to last
 	
@@ -484,7 +804,13 @@ void ACEND_InitNodes(void)
 	numnodes = 1;
 	numitemnodes = 1;
 	memset(nodes,0,sizeof(node_t) * MAX_NODES);
-	memset(path_table,INVALID,sizeof(int16_t)*MAX_NODES*MAX_NODES);
+
+	// start over with a small table, it grows as nodes are added
+	ACEND_FreePathTable();
+	ACEND_GrowPathTable(numnodes + 1);
+
+	ACEND_ResetNodeGrid();
+	ACEND_ClearLinkQueue();
 			
 }
 
@@ -531,7 +857,7 @@ void ACEND_DrawPath()
 	current_node = show_path_from;
 	goal_node = show_path_to;
 
-	next_node = path_table[current_node][goal_node];
+	next_node = PATH_TABLE(current_node,goal_node);
 
 	// Now set up and display the path
 	while(current_node != goal_node && current_node != -1)
@@ -542,7 +868,7 @@ void ACEND_DrawPath()
 		gi.WritePosition (nodes[next_node].origin);
 		gi.multicast (nodes[current_node].origin, MULTICAST_PVS);
 		current_node = next_node;
-		next_node = path_table[current_node][goal_node];
+		next_node = PATH_TABLE(current_node,goal_node);
 	}
 }
 
@@ -566,6 +892,9 @@ int ACEND_AddNode(edict_t *self, int type)
 	// Block if we exceed maximum
 	if (numnodes + 1 > MAX_NODES)
 		return false;
+
+	// Platforms add two nodes
+	ACEND_GrowPathTable(numnodes + 2);
 	
 	// Set location
 	VectorCopy(self->s.origin,nodes[numnodes].origin);
@@ -661,84 +990,525 @@ int ACEND_AddNode(edict_t *self, int type)
 	return numnodes-1; // return the node added
 }
 
+///////////////////////////////////////////////////////////////////////
+// SHORTEST PATHS
+//
+// path_table holds the first hop of a shortest path between every
+// pair of nodes and cost_table its length in links. Both are kept
+// exact at all times: adding a link patches only the pairs it makes
+// shorter, removing one rebuilds only the rows whose paths could have
+// used it, and ACEND_ResolveAllPaths rebuilds everything with a
+// breadth first search from each node.
+//
+// The links themselves are not stored separately. Every first hop in
+// path_table is a link out of that row's node, so the link list is
+// read back out of the table when a rebuild needs it.
+///////////////////////////////////////////////////////////////////////
+
+// scratch space for the routines below
+static int16_t path_queue[MAX_NODES + 1];
+static int16_t path_dist[MAX_NODES + 1];
+static int16_t path_rows[MAX_NODES + 1];
+
+///////////////////////////////////////////////////////////////////////
+// Collect every link into a compact list, links out of node i are
+// edges[start[i]] to edges[start[i+1]-1]. Returns the number of links.
+// Both arrays are TAG_LEVEL, the caller frees them.
+///////////////////////////////////////////////////////////////////////
+static int ACEND_BuildLinkList(int count, int **start, int16_t **edges)
+{
+	int16_t *row;
+	int i, j, next, num;
+
+	*start = (int *)gi.TagMalloc((count + 1) * sizeof(int), TAG_LEVEL);
+
+	// path_dist is used to mark hops already seen in this row
+	for (num = 0, i = 0; i < count; i++)
+	{
+		(*start)[i] = num;
+		memset(path_dist, 0, count * sizeof(int16_t));
+		row = &PATH_TABLE(i,0);
+		for (j = 0; j < count; j++)
+		{
+			next = row[j];
+			if (next != INVALID && next != i && !path_dist[next])
+			{
+				path_dist[next] = 1;
+				num++;
+			}
+		}
+	}
+	(*start)[count] = num;
+
+	*edges = (int16_t *)gi.TagMalloc((num + 1) * sizeof(int16_t), TAG_LEVEL);
+
+	for (num = 0, i = 0; i < count; i++)
+	{
+		memset(path_dist, 0, count * sizeof(int16_t));
+		row = &PATH_TABLE(i,0);
+		for (j = 0; j < count; j++)
+		{
+			next = row[j];
+			if (next != INVALID && next != i && !path_dist[next])
+			{
+				path_dist[next] = 1;
+				(*edges)[num++] = next;
+			}
+		}
+	}
+
+	return num;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Rebuild one row of the path and cost tables with a breadth first
+// search out of from. All links cost the same, so the first time a
+// node is reached is along a shortest path.
+///////////////////////////////////////////////////////////////////////
+static void ACEND_BuildPathRow(int from, int count, int *start, int16_t *edges)
+{
+	int16_t *path = &PATH_TABLE(from,0);
+	int16_t *cost = &COST_TABLE(from,0);
+	int head, tail, cur, next, e;
+
+	// a mapped table is only written if the row really changes, which
+	// it doesn't for a file that was saved resolved
+	if (path_map)
+		path = path_scratch;
+
+	memset(path, INVALID, count * sizeof(int16_t));
+	memset(cost, INVALID, count * sizeof(int16_t));
+
+	cost[from] = 0;
+	path_queue[0] = from;
+	head = 0;
+	tail = 1;
+
+	while (head < tail)
+	{
+		cur = path_queue[head++];
+		for (e = start[cur]; e < start[cur + 1]; e++)
+		{
+			next = edges[e];
+			if (cost[next] != INVALID)
+				continue;
+			cost[next] = cost[cur] + 1;
+			path[next] = (cur == from) ? next : path[cur];
+			path_queue[tail++] = next;
+		}
+	}
+
+	cost[from] = INVALID; // no path to ourselves
+
+	if (path == path_scratch && memcmp(path_scratch, &PATH_TABLE(from,0), count * sizeof(int16_t)))
+	{
+		ACEND_UnshareNodes();
+		memcpy(&PATH_TABLE(from,0), path_scratch, count * sizeof(int16_t));
+	}
+}
+
+///////////////////////////////////////////////////////////////////////
+// Number of table rows in use, including a node that is still being
+// set up (ACEND_AddNode links platform nodes before counting them).
+///////////////////////////////////////////////////////////////////////
+static int ACEND_PathCount(int a, int b)
+{
+	int count = numnodes;
+
+	if (a >= count)
+		count = a + 1;
+	if (b >= count)
+		count = b + 1;
+	return count;
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Add/Update node connections (paths)
+//
+// A new link from->to can only shorten the path i->j if it shortens
+// both i->to and from->j, so only those rows and columns are visited.
 ///////////////////////////////////////////////////////////////////////
 void ACEND_UpdateNodeEdge(int from, int to)
 {
-	int i;
+	int i, j, k, count, numtargets, hop;
+	int di, d;
 	
 	if(from == -1 || to == -1 || from == to)
 		return; // safety
 
-	// Add the link
-	path_table[from][to] = to;
+	if(from >= path_size || to >= path_size)
+		return; // not a node
+
+	if(PATH_TABLE(from,to) == to)
+		return; // already linked
+
+	ACEND_UnshareNodes();
+	count = ACEND_PathCount(from, to);
+
+	// destinations that get closer to from through the new link
+	numtargets = 0;
+	for(j=0;j<count;j++)
+	{
+		if(j == from)
+			continue;
+		d = (j == to) ? 0 : COST_TABLE(to,j);
+		if(d == INVALID)
+			continue;
+		if(COST_TABLE(from,j) == INVALID || d + 1 < COST_TABLE(from,j))
+		{
+			path_queue[numtargets] = j;
+			path_dist[numtargets] = d + 1;
+			numtargets++;
+		}
+	}
+
+	// sources that get closer to to through the new link
+	for(i=0;i<count;i++)
+	{
+		di = (i == from) ? 0 : COST_TABLE(i,from);
+		if(di == INVALID)
+			continue;
+		d = (i == to) ? 0 : COST_TABLE(i,to);
+		if(d != INVALID && d <= di + 1)
+			continue;
+
+		hop = (i == from) ? to : PATH_TABLE(i,from);
+		for(k=0;k<numtargets;k++)
+		{
+			j = path_queue[k];
+			if(j == i)
+				continue;
+			d = di + path_dist[k];
+			if(COST_TABLE(i,j) == INVALID || d < COST_TABLE(i,j))
+			{
+				COST_TABLE(i,j) = d;
+				PATH_TABLE(i,j) = hop;
+			}
+		}
+	}
 
-	// Now for the self-referencing part, linear time for each link added
-	for(i=0;i<numnodes;i++)
-        if(path_table[i][from] != INVALID) {
-            if(i == to) {
-				path_table[i][to] = INVALID; // make sure we terminate
-            } else {
-				path_table[i][to] = path_table[i][from];
-            }
-        }
 	if(debug_mode)
 		debug_printf("Link %d -> %d\n", from, to);
 }
 
+///////////////////////////////////////////////////////////////////////
+// PENDING LINKS
+//
+// Links found while players move around (ACEND_PathMap, ladders, the
+// grapple) are queued rather than patched into the tables straight
+// away. ACEND_FoldLinks adds up to ace_link_budget of them at the end
+// of each frame, so a player running through an unmapped area, who
+// can find a link every few frames, never costs more than that many
+// row and column walks in one frame. Bots can't route over a link
+// until it has been folded in, a frame or so later.
+//
+// Removing a link and saving read the whole table, so they fold
+// everything queued first. With ace_link_budget 0 links are added as
+// soon as they are found, as before.
+///////////////////////////////////////////////////////////////////////
+#define PATH_LINK_QUEUE		256		// must be a power of 2
+
+cvar_t *ace_link_budget;
+
+static int16_t link_queue[PATH_LINK_QUEUE][2];
+static int link_head;		// next link to fold
+static int link_tail;		// next free slot
+
+void ACEND_ClearLinkQueue(void)
+{
+	link_head = link_tail = 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Queue a link for ACEND_FoldLinks, or add it now if the queue is off
+///////////////////////////////////////////////////////////////////////
+void ACEND_QueueNodeEdge(int from, int to)
+{
+	int last;
+
+	if(from == -1 || to == -1 || from == to)
+		return; // safety
+
+	if (!ace_link_budget || ace_link_budget->value <= 0)
+	{
+		ACEND_UpdateNodeEdge(from, to);
+		return;
+	}
+
+	if(from < path_size && to < path_size && PATH_TABLE(from,to) == to)
+		return; // already linked
+
+	// a player going back and forth finds the same link over and over
+	if (link_tail != link_head)
+	{
+		last = (link_tail - 1) & (PATH_LINK_QUEUE - 1);
+		if (link_queue[last][0] == from && link_queue[last][1] == to)
+			return;
+	}
+
+	// full, make room by folding the oldest
+	if (((link_tail + 1) & (PATH_LINK_QUEUE - 1)) == link_head)
+		ACEND_FoldLinks(1);
+
+	link_queue[link_tail][0] = from;
+	link_queue[link_tail][1] = to;
+	link_tail = (link_tail + 1) & (PATH_LINK_QUEUE - 1);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Fold up to count queued links into the tables, all of them if
+// count is 0. Called at the end of each frame with ace_link_budget.
+///////////////////////////////////////////////////////////////////////
+void ACEND_FoldLinks(int count)
+{
+	int from, to;
+
+	while (link_head != link_tail)
+	{
+		from = link_queue[link_head][0];
+		to = link_queue[link_head][1];
+		link_head = (link_head + 1) & (PATH_LINK_QUEUE - 1);
+
+		ACEND_UpdateNodeEdge(from, to);
+
+		if (count > 0 && --count == 0)
+			break;
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////
 // Remove a node edge
+//
+// Only rows where from->to lies on a shortest path to to can have
+// routed through the link; those are searched again from scratch.
 ///////////////////////////////////////////////////////////////////////
 void ACEND_RemoveNodeEdge(edict_t *self, int from, int to)
 {
-	int i;
+	int i, count, numrows;
+	int di, d;
+	int *start;
+	int16_t *edges;
 
 	if(debug_mode) 
 		debug_printf("%s: Removing Edge %d -> %d\n", self->client->pers.netname, from, to);
-		
-	path_table[from][to] = INVALID; // set to invalid			
 
-	// Make sure this gets updated in our path array
-	for(i=0;i<numnodes;i++)
-		if(path_table[from][i] == to)
-			path_table[from][i] = INVALID;
+	// the rebuild reads every link out of the table
+	ACEND_FoldLinks(0);
+
+	if(from < 0 || to < 0 || from == to || from >= path_size || to >= path_size)
+		return; // not a link
+
+	if(PATH_TABLE(from,to) != to)
+		return; // not linked
+
+	count = ACEND_PathCount(from, to);
+
+	// rows that may route through the link
+	numrows = 0;
+	for(i=0;i<count;i++)
+	{
+		di = (i == from) ? 0 : COST_TABLE(i,from);
+		if(di == INVALID)
+			continue;
+		d = (i == to) ? 0 : COST_TABLE(i,to);
+		if(d == di + 1)
+			path_rows[numrows++] = i;
+	}
+
+	// drop the link from our own row so it is gone from the link list
+	ACEND_UnshareNodes();
+	for(i=0;i<count;i++)
+		if(PATH_TABLE(from,i) == to)
+			PATH_TABLE(from,i) = INVALID;
+
+	ACEND_BuildLinkList(count, &start, &edges);
+
+	for(i=0;i<numrows;i++)
+		ACEND_BuildPathRow(path_rows[i], count, start, edges);
+
+	gi.TagFree(edges);
+	gi.TagFree(start);
 }
 
 ///////////////////////////////////////////////////////////////////////
-// This function will resolve all paths that are incomplete
-// usually called before saving to disk
+// This function will rebuild all paths from the links in the table.
+// Called after loading, since node files only store the first hops.
 ///////////////////////////////////////////////////////////////////////
 void ACEND_ResolveAllPaths()
 {
-	int i, from, to;
-	int num=0;
+	int i, num;
+	int *start;
+	int16_t *edges;
 	
 	safe_bprintf(PRINT_HIGH,"Resolving all paths...");
 
-	for(from=0;from<numnodes;from++)
-	for(to=0;to<numnodes;to++)
+	num = ACEND_BuildLinkList(numnodes, &start, &edges);
+
+	for(i=0;i<numnodes;i++)
+		ACEND_BuildPathRow(i, numnodes, start, edges);
+
+	gi.TagFree(edges);
+	gi.TagFree(start);
+
+	safe_bprintf(PRINT_MEDIUM,"done (%d links)\n",num);
+}
+
+///////////////////////////////////////////////////////////////////////
+// Node file format
+//
+// Version 1 wrote the header, the nodes, then the path table one
+// entry at a time, which meant numnodes^2 stdio calls on every load.
+// Version 2 writes everything as one block behind a small header:
+//
+//   int            version      (NODEFILE_VERSION, plus NODEFILE_LZSS
+//                                if the payload is compressed)
+//   int            payload size (uncompressed)
+//   nodefile_t     counts and checksum of what follows
+//   node_t         nodes[numnodes]
+//   int16_t        path_table[numnodes][numnodes]
+//   item_table_t   item_table[num_items]
+//
+// The compressed form is produced by Encode() in acebot_compress.c,
+// which writes the same two leading ints. Version 1 files are still
+// read, but are never written. With ace_map_nodes set, an uncompressed
+// version 2 file is mapped rather than read (ACEND_MapNodeFile).
+///////////////////////////////////////////////////////////////////////
+#define NODEFILE_VERSION	2
+#define NODEFILE_LZSS		0x100
+
+typedef struct
+{
+	int numnodes;
+	int num_items;
+	uint32_t checksum;	// FNV-1a of everything after this header
+} nodefile_t;
+
+cvar_t *ace_compress_nodes;
+
+static uint32_t ACEND_Checksum(uint8_t *data, int size)
+{
+	uint32_t hash = 2166136261u;
+	int i;
+
+	for (i = 0; i < size; i++)
 	{
-		// update unresolved paths
-		// Not equal to itself, not equal to -1 and equal to the last link
-		if(from != to && path_table[from][to] == to)
+		hash ^= data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Background saves
+//
+// ACEND_SaveNodes only copies the tables into a buffer. A worker
+// thread checksums it, compresses it if asked, writes it next to the
+// node file and moves it over the old one. The buffer is malloc'd,
+// not TAG_LEVEL, since the level may be freed under the worker, and
+// the worker makes no gi calls. Encode keeps its coder state per call,
+// so the game thread can Decode another map's node file or compress a
+// save meanwhile. There is at most one save in flight: the next save,
+// ACEND_LoadNodes for the same map and ShutdownGame wait for it
+// (ACEND_WaitForNodeSave).
+///////////////////////////////////////////////////////////////////////
+static struct
+{
+	qboolean pending;
+	uint8_t *buffer;
+	int size;
+	char filename[MAX_QPATH];
+	char partname[MAX_QPATH + 4];
+	qboolean compress;
+	volatile qboolean done;
+	volatile qboolean ok;
+#ifdef WIN32
+	HANDLE thread;
+#else
+	pthread_t thread;
+#endif
+} nodesave;
+
+// Called on either thread, no gi calls
+static qboolean ACEND_WriteNodeFile(uint8_t *buffer, int size, qboolean compress, char *filename, char *partname)
+{
+	FILE *pOut;
+	nodefile_t *header;
+	int version = NODEFILE_VERSION;
+
+	header = (nodefile_t *)buffer;
+	header->checksum = ACEND_Checksum(buffer + sizeof(nodefile_t), size - sizeof(nodefile_t));
+
+	if (compress)
+	{
+		if (Encode(partname, buffer, size, version | NODEFILE_LZSS) < 0)
 		{
-			num++;
-
-			// Now for the self-referencing part linear time for each link added
-			for(i=0;i<numnodes;i++)
-                if(path_table[i][from] != -1) {
-                    if(i == to) {
-						path_table[i][to] = -1; // make sure we terminate
-                    } else {
-						path_table[i][to] = path_table[i][from];
-                    }
-                    
-                }
+			remove(partname);
+			return false;
 		}
 	}
+	else
+	{
+		if((pOut = fopen(partname, "wb" )) == NULL)
+			return false;
+
+		fwrite(&version,sizeof(int),1,pOut); // write version
+		fwrite(&size,sizeof(int),1,pOut); // write payload size
+		fwrite(buffer,size,1,pOut); // write payload
+		fclose(pOut);
+	}
 
-	safe_bprintf(PRINT_MEDIUM,"done (%d updated)\n",num);
+#ifdef WIN32
+	// rename won't replace a file here, and a file still mapped by
+	// another server can't be removed
+	remove(filename);
+#endif
+	if (rename(partname, filename) != 0)
+	{
+		remove(partname);
+		return false;
+	}
+	return true;
+}
+
+#ifdef WIN32
+static DWORD WINAPI ACEND_SaveWorker(LPVOID arg)
+#else
+static void *ACEND_SaveWorker(void *arg)
+#endif
+{
+	nodesave.ok = ACEND_WriteNodeFile(nodesave.buffer, nodesave.size, nodesave.compress,
+		nodesave.filename, nodesave.partname);
+	nodesave.done = true;
+	return 0;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Blocks until the save in flight is on disk. With a filename, only
+// waits if that is the file being written, but still cleans up after
+// a save that has already finished.
+///////////////////////////////////////////////////////////////////////
+void ACEND_WaitForNodeSave(char *filename)
+{
+	if (!nodesave.pending)
+		return;
+	if (filename && !nodesave.done && Q_strcasecmp(filename, nodesave.filename))
+		return;
+
+#ifdef WIN32
+	WaitForSingleObject(nodesave.thread, INFINITE);
+	CloseHandle(nodesave.thread);
+#else
+	pthread_join(nodesave.thread, NULL);
+#endif
+
+	nodesave.pending = false;
+	free(nodesave.buffer);
+	nodesave.buffer = NULL;
+
+	if (!nodesave.ok)
+		gi.dprintf("ACE: couldn't write %s\n", nodesave.filename);
+	else if (developer && developer->value)
+		gi.dprintf("ACE: wrote %s in background\n", nodesave.filename);
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -748,18 +1518,29 @@ void ACEND_ResolveAllPaths()
 // release, I took out the compressed format option. Most levels will
 // save out to a node file around 50-200k, so compression is not really
 // a big deal.
+//
+// The LZSS routines did ship in the end, so version 2 files are
+// compressed when ace_compress_nodes is set.
 ///////////////////////////////////////////////////////////////////////
 void ACEND_SaveNodes()
 {
-	FILE *pOut;
 	char tempname[MAX_QPATH] = "";
 	char filename[MAX_QPATH] = "";
 //	char filename[60];
-	int i,j;
-	int version = 1;
+	int i;
+	int size;
+	uint8_t *buffer, *p;
+	nodefile_t *header;
+	qboolean compress;
 	
-	// Resolve paths
-	ACEND_ResolveAllPaths();
+	// paths are always resolved, see ACEND_UpdateNodeEdge
+	ACEND_FoldLinks(0);
+
+	// let go of our own mapping of the file about to be replaced
+	ACEND_UnshareNodes();
+
+	// one save at a time
+	ACEND_WaitForNodeSave(NULL);
 
 	safe_bprintf(PRINT_MEDIUM,"Saving node table...");
 
@@ -772,24 +1553,195 @@ void ACEND_SaveNodes()
 	//strcat(filename,level.mapname);
 	//strcat(filename,".nod");
 
-	if((pOut = fopen(filename, "wb" )) == NULL)
-		return; // bail
-	
-	fwrite(&version,sizeof(int),1,pOut); // write version
-	fwrite(&numnodes,sizeof(int),1,pOut); // write count
-	fwrite(&num_items,sizeof(int),1,pOut); // write facts count
-	
-	fwrite(nodes,sizeof(node_t),numnodes,pOut); // write nodes
-	
+	// build the whole payload in memory
+	size = sizeof(nodefile_t) + numnodes * sizeof(node_t)
+		+ numnodes * numnodes * sizeof(int16_t)
+		+ num_items * sizeof(item_table_t);
+	buffer = (uint8_t *)malloc(size);
+	if (!buffer)
+	{
+		safe_bprintf(PRINT_MEDIUM,"failed.\n");
+		return;
+	}
+
+	header = (nodefile_t *)buffer;
+	header->numnodes = numnodes;
+	header->num_items = num_items;
+	p = buffer + sizeof(nodefile_t);
+
+	memcpy(p, nodes, numnodes * sizeof(node_t)); // nodes
+	p += numnodes * sizeof(node_t);
+
+	for(i=0;i<numnodes;i++) // path table, one row at a time
+	{
+		memcpy(p, &PATH_TABLE(i,0), numnodes * sizeof(int16_t));
+		p += numnodes * sizeof(int16_t);
+	}
+
+	memcpy(p, item_table, num_items * sizeof(item_table_t)); // fact table
+
+	// Other servers may have the file mapped (ace_map_nodes). Writing
+	// it over in place would pull it out from under them, so write a
+	// new file and move it over the old one.
+	compress = (ace_compress_nodes && ace_compress_nodes->value);
+
+	nodesave.buffer = buffer;
+	nodesave.size = size;
+	nodesave.compress = compress;
+	Q_strncpyz(nodesave.filename, filename, sizeof(nodesave.filename));
+	Com_sprintf(nodesave.partname, sizeof(nodesave.partname), "%s.tmp", filename);
+	nodesave.done = false;
+	nodesave.ok = false;
+
+#ifdef WIN32
+	nodesave.thread = CreateThread(NULL, 0, ACEND_SaveWorker, NULL, 0, NULL);
+	nodesave.pending = (nodesave.thread != NULL);
+#else
+	nodesave.pending = (pthread_create(&nodesave.thread, NULL, ACEND_SaveWorker, NULL) == 0);
+#endif
+	if (nodesave.pending)
+	{
+		safe_bprintf(PRINT_MEDIUM,"queued.\n");
+		return;
+	}
+
+	// no thread, write it here
+	nodesave.buffer = NULL;
+	i = ACEND_WriteNodeFile(buffer, size, compress, nodesave.filename, nodesave.partname);
+	free(buffer);
+	safe_bprintf(PRINT_MEDIUM, i ? "done.\n" : "failed.\n");
+}
+
+///////////////////////////////////////////////////////////////////////
+// Read a version 2 payload. pIn is positioned just past the version
+// and size ints; it is closed before returning.
+///////////////////////////////////////////////////////////////////////
+static qboolean ACEND_ReadNodeFile(FILE *pIn, char *filename, int version, int size)
+{
+	uint8_t *buffer, *p;
+	nodefile_t *header;
+	int i, expected;
+
+	if (size < (int)sizeof(nodefile_t))
+	{
+		fclose(pIn);
+		return false;
+	}
+
+	buffer = (uint8_t *)gi.TagMalloc(size, TAG_LEVEL);
+
+	if (version & NODEFILE_LZSS)
+	{
+		fclose(pIn);
+		if (Decode(filename, buffer, size) != size)
+		{
+			gi.TagFree(buffer);
+			return false;
+		}
+	}
+	else
+	{
+		i = fread(buffer, size, 1, pIn);
+		fclose(pIn);
+		if (i != 1)
+		{
+			gi.TagFree(buffer);
+			return false;
+		}
+	}
+
+	header = (nodefile_t *)buffer;
+	if (header->numnodes < 1 || header->numnodes > MAX_NODES || header->num_items < 0)
+	{
+		gi.TagFree(buffer);
+		return false;
+	}
+
+	expected = sizeof(nodefile_t) + header->numnodes * sizeof(node_t)
+		+ header->numnodes * header->numnodes * sizeof(int16_t)
+		+ header->num_items * sizeof(item_table_t);
+	if (size != expected
+		|| header->checksum != ACEND_Checksum(buffer + sizeof(nodefile_t), size - sizeof(nodefile_t)))
+	{
+		gi.TagFree(buffer);
+		return false;
+	}
+
+	numnodes = header->numnodes;
+	num_items = header->num_items;
+	p = buffer + sizeof(nodefile_t);
+
+	memcpy(nodes, p, numnodes * sizeof(node_t));
+	p += numnodes * sizeof(node_t);
+
+	ACEND_GrowPathTable(numnodes + 1);
+
 	for(i=0;i<numnodes;i++)
-		for(j=0;j<numnodes;j++)
-			fwrite(&path_table[i][j],sizeof(int16_t),1,pOut); // write count
-		
-	fwrite(item_table,sizeof(item_table_t),num_items,pOut); 		// write out the fact table
+	{
+		memcpy(&PATH_TABLE(i,0), p, numnodes * sizeof(int16_t));
+		p += numnodes * sizeof(int16_t);
+	}
 
-	fclose(pOut);
-	
-	safe_bprintf(PRINT_MEDIUM,"done.\n");
+	// Knightmare- is this needed?  It's all re-built anyway, and may cause problems.
+	// The item_table array is better left blank.
+
+	gi.TagFree(buffer);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////
+// Use an uncompressed version 2 file in place. The nodes are small and
+// are copied, but path_table points straight into a read-only mapping
+// of the file, so every server on the map shares one copy of it. The
+// first change to the table (a node learned, a link added or dropped)
+// copies it out first, see ACEND_UnshareNodes. Returns false, with the
+// tables as they were, if the file can't be mapped or isn't valid.
+///////////////////////////////////////////////////////////////////////
+static qboolean ACEND_MapNodeFile(char *filename)
+{
+	uint8_t *base;
+	int *ints;
+	nodefile_t *header;
+	int length, expected, offset;
+
+	base = ACEND_MapFile(filename, &length);
+	if (!base)
+		return false;
+
+	ints = (int *)base;
+	header = (nodefile_t *)(base + 2 * sizeof(int));
+	if (length < (int)(2 * sizeof(int) + sizeof(nodefile_t))
+		|| ints[0] != NODEFILE_VERSION || ints[1] != length - (int)(2 * sizeof(int))
+		|| header->numnodes < 1 || header->numnodes > MAX_NODES || header->num_items < 0)
+	{
+		ACEND_UnmapFile(base, length);
+		return false;
+	}
+
+	expected = sizeof(nodefile_t) + header->numnodes * sizeof(node_t)
+		+ header->numnodes * header->numnodes * sizeof(int16_t)
+		+ header->num_items * sizeof(item_table_t);
+	offset = 2 * sizeof(int) + sizeof(nodefile_t) + header->numnodes * sizeof(node_t);
+	if (ints[1] != expected || (offset & 1)
+		|| header->checksum != ACEND_Checksum(base + 2 * sizeof(int) + sizeof(nodefile_t), expected - sizeof(nodefile_t)))
+	{
+		ACEND_UnmapFile(base, length);
+		return false;
+	}
+
+	ACEND_FreePathTable();
+
+	numnodes = header->numnodes;
+	num_items = header->num_items;
+	memcpy(nodes, base + 2 * sizeof(int) + sizeof(nodefile_t), numnodes * sizeof(node_t));
+
+	path_map = base;
+	path_map_length = length;
+	path_table = (int16_t *)(base + offset);
+	path_size = numnodes;
+	cost_table = (int16_t *)gi.TagMalloc(path_size * path_size * sizeof(int16_t), TAG_GAME);
+	memset(cost_table, INVALID, path_size * path_size * sizeof(int16_t));
+	return true;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -798,11 +1750,12 @@ void ACEND_SaveNodes()
 void ACEND_LoadNodes(void)
 {
 	FILE *pIn;
-	int i,j;
+	int i;
 	char tempname[MAX_QPATH] = "";
 	char filename[MAX_QPATH] = "";
 	//char filename[60];
 	int version;
+	int size;
 
 	// Knightmare- rewote this
 	sprintf (tempname, "nav/%s.nod", level.mapname);
@@ -811,6 +1764,15 @@ void ACEND_LoadNodes(void)
 	//strcat(filename,level.mapname);
 	//strcat(filename,".nod");
 
+	// a save of this map may still be on its way to disk
+	ACEND_WaitForNodeSave(filename);
+
+	if (ace_map_nodes && ace_map_nodes->value && ACEND_MapNodeFile(filename))
+	{
+		safe_bprintf(PRINT_MEDIUM,"ACE: Mapped node table.\n");
+		goto loaded;
+	}
+
 	if((pIn = fopen(filename, "rb" )) == NULL)
     {
 		// Create item table
@@ -821,20 +1783,49 @@ void ACEND_LoadNodes(void)
 	}
 
 	// determine version
-	fread(&version,sizeof(int),1,pIn); // read version
+	if (fread(&version,sizeof(int),1,pIn) != 1) // read version
+		version = 0;
 	
-	if(version == 1) 
+	if((version & ~NODEFILE_LZSS) == NODEFILE_VERSION)
+	{
+		safe_bprintf(PRINT_MEDIUM,"ACE: Loading node table...");
+
+		if (fread(&size,sizeof(int),1,pIn) != 1)
+			size = 0;
+
+		if (!ACEND_ReadNodeFile(pIn, filename, version, size))
+		{
+			ACEND_InitNodes();
+			safe_bprintf(PRINT_MEDIUM, "bad node file, creating new one...");
+			ACEIT_BuildItemNodeTable(false);
+			safe_bprintf(PRINT_MEDIUM, "done.\n");
+			return;
+		}
+	}
+	else if(version == 1) 
 	{
 		safe_bprintf(PRINT_MEDIUM,"ACE: Loading node table...");
 
 		fread(&numnodes,sizeof(int),1,pIn); // read count
 		fread(&num_items,sizeof(int),1,pIn); // read facts count
+
+		if(numnodes < 1 || numnodes > MAX_NODES)
+		{
+			fclose(pIn);
+			ACEND_InitNodes();
+			safe_bprintf(PRINT_MEDIUM, "bad node count, creating new one...");
+			ACEIT_BuildItemNodeTable(false);
+			safe_bprintf(PRINT_MEDIUM, "done.\n");
+			return;
+		}
 		
 		fread(nodes,sizeof(node_t),numnodes,pIn);
 
+		ACEND_GrowPathTable(numnodes + 1);
+
+		// version 1 stores whole rows back to back, so read a row at a time
 		for(i=0;i<numnodes;i++)
-			for(j=0;j<numnodes;j++)
-				fread(&path_table[i][j],sizeof(int16_t),1,pIn); // write count
+			fread(&PATH_TABLE(i,0),sizeof(int16_t),numnodes,pIn);
 	
 		// Knightmare- is this needed?  It's all re-built anyway, and may cause problems.
 		// The item_table array is better left blank.
@@ -843,6 +1834,7 @@ void ACEND_LoadNodes(void)
 	}
 	else
 	{
+		fclose(pIn);
 		// Create item table
 		safe_bprintf(PRINT_MEDIUM, "ACE: No node file found, creating new one...");
 		ACEIT_BuildItemNodeTable(false);
@@ -851,6 +1843,11 @@ void ACEND_LoadNodes(void)
 	}
 	
 	safe_bprintf(PRINT_MEDIUM, "done.\n");
+
+loaded:
+	// only first hops are stored, rebuild the costs from them
+	ACEND_ResolveAllPaths();
+	ACEND_ResetNodeGrid();
 	
 	ACEIT_BuildItemNodeTable(true);
 
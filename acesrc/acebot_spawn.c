@@ -501,12 +501,11 @@ static int NUM_BOT_SKINS = 0;
 
 
 ///////////////////////////////////////////////////////////////////////
-// Set the name of the bot and update the userinfo
+// Pick a name and skin for a bot and build its userinfo
 ///////////////////////////////////////////////////////////////////////
-void ACESP_SetName(edict_t *bot, char *name, char *skin, char *team)
+static void ACESP_BuildUserinfo(int count, char *name, char *skin, char *userinfo)
 {
 	float rnd;
-	char userinfo[MAX_INFO_STRING] = "";
 	char bot_skin[MAX_INFO_STRING] = "";
 	char bot_name[MAX_INFO_STRING] = "";
 	int i, r = 0;
@@ -545,10 +544,10 @@ void ACESP_SetName(edict_t *bot, char *name, char *skin, char *team)
 					}
 			// If no more free bots in table, use a numbered name
 			if (strlen(bot_name) == 0)
-				sprintf(bot_name,"ACEBot_%d",bot->count);
+				sprintf(bot_name,"ACEBot_%d",count);
 		}
 		else
-			sprintf(bot_name,"ACEBot_%d",bot->count);
+			sprintf(bot_name,"ACEBot_%d",count);
 	}
 	else
 		strcpy(bot_name,name);
@@ -577,13 +576,22 @@ void ACESP_SetName(edict_t *bot, char *name, char *skin, char *team)
 		strcpy(bot_skin,skin);
 	
 	// initialise userinfo
-	memset (userinfo, 0, sizeof(userinfo));
+	memset (userinfo, 0, MAX_INFO_STRING);
 
 	// add bot's name/skin/hand to userinfo
 	Info_SetValueForKey (userinfo, "name", bot_name);
 	Info_SetValueForKey (userinfo, "skin", bot_skin);
 	Info_SetValueForKey (userinfo, "hand", "2"); // bot is center handed for now!
+}
 
+///////////////////////////////////////////////////////////////////////
+// Set the name of the bot and update the userinfo
+///////////////////////////////////////////////////////////////////////
+void ACESP_SetName(edict_t *bot, char *name, char *skin, char *team)
+{
+	char userinfo[MAX_INFO_STRING];
+
+	ACESP_BuildUserinfo(bot->count, name, skin, userinfo);
 	ClientConnect (bot, userinfo);
 	// Knightmare- removed this
 	//ACESP_SaveBots(); // make sure to save the bots
@@ -592,16 +600,22 @@ void ACESP_SetName(edict_t *bot, char *name, char *skin, char *team)
 ///////////////////////////////////////////////////////////////////////
 // Spawn the bot
 ///////////////////////////////////////////////////////////////////////
-void ACESP_SpawnBot (char *team, char *name, char *skin, char *userinfo)
+edict_t *ACESP_SpawnBot (char *team, char *name, char *skin, char *userinfo)
 {
 	edict_t	*bot;
+
+	if (CmdLog_Replaying ())
+	{
+		safe_bprintf (PRINT_MEDIUM, "Bots can't be added while a usercmd log plays.\n");
+		return NULL;
+	}
 	
 	bot = ACESP_FindFreeClient ();
 	
 	if (!bot)
 	{
 		safe_bprintf (PRINT_MEDIUM, "Server is full, increase Maxclients.\n");
-		return;
+		return NULL;
 	}
 
 	bot->yaw_speed = 100; // yaw speed
@@ -705,6 +719,7 @@ void ACESP_SpawnBot (char *team, char *name, char *skin, char *userinfo)
 
 	ACEAI_PickLongRangeGoal(bot); // pick a new goal
 
+	return bot;
 }
 
 ///////////////////////////////////////////////////////////////////////
@@ -754,3 +769,108 @@ void ACESP_RemoveBot(char *name)
 	//ACESP_SaveBots(); // Save them again
 }
 
+///////////////////////////////////////////////////////////////////////
+// Bot autofill
+//
+// With ace_autofill set to a number of players, ACESP_AutoFill adds
+// bots as humans leave and takes them out again as humans join, one
+// every AUTOFILL_FRAMES. It only takes out bots it added itself. With
+// ace_autofill_msec set, no bot is added while the game frame takes
+// longer than that on average (Gov_FrameMsec), and one is taken out
+// while it takes a quarter longer again.
+//
+// The next bot's name and userinfo are picked on a frame of their own
+// ahead of time, so the frame that adds it only has to connect it and
+// put it in the server.
+///////////////////////////////////////////////////////////////////////
+#define AUTOFILL_FRAMES	10
+
+cvar_t *ace_autofill;
+cvar_t *ace_autofill_msec;
+
+static qboolean	autofill_bot[MAX_CLIENTS];	// added by ACESP_AutoFill
+static char		autofill_userinfo[MAX_INFO_STRING];
+static int		autofill_wanted;			// bots to add at the next step
+static int		autofill_framenum;
+
+static int ACESP_NextBotCount(void)
+{
+	int i, count = 0;
+
+	for (i = 1; i <= game.maxclients; i++)
+		if (g_edicts[i].count > count)
+			count = g_edicts[i].count;
+	return count + 1;
+}
+
+void ACESP_AutoFill(void)
+{
+	edict_t *ent;
+	float msec, cap;
+	int i, humans, bots, others, want;
+
+	if (!ace_autofill->value || !deathmatch->value || level.intermissiontime || CmdLog_Replaying())
+		return;
+
+	// get the next bot ready on a frame of its own
+	if (autofill_wanted > 0 && !autofill_userinfo[0])
+	{
+		ACESP_BuildUserinfo(ACESP_NextBotCount(), "", "", autofill_userinfo);
+		return;
+	}
+
+	// autofill_framenum from an earlier map is ahead of level.framenum
+	if (autofill_framenum <= level.framenum && level.framenum - autofill_framenum < AUTOFILL_FRAMES)
+		return;
+	autofill_framenum = level.framenum;
+
+	humans = bots = others = 0;
+	for (i = 0; i < game.maxclients; i++)
+	{
+		ent = g_edicts + i + 1;
+		if (!ent->inuse || !ent->client || !ent->is_bot)
+			autofill_bot[i] = false;
+		if (!ent->inuse || !ent->client)
+			continue;
+		if (autofill_bot[i])
+			bots++;
+		else if (ent->is_bot)
+			others++;
+		else
+			humans++;
+	}
+
+	want = (int)ace_autofill->value - humans - others;
+	want = min(want, game.maxclients - humans - others);
+	if (want < 0)
+		want = 0;
+
+	cap = ace_autofill_msec->value;
+	msec = Gov_FrameMsec();
+	if (cap > 0 && msec > cap * 1.25)
+		want = min(want, bots - 1);
+	else if (cap > 0 && msec > cap)
+		want = min(want, bots);
+
+	if (want > bots && autofill_userinfo[0])
+	{
+		ent = ACESP_SpawnBot(NULL, NULL, NULL, autofill_userinfo);
+		autofill_userinfo[0] = 0;
+		if (ent)
+			autofill_bot[ent - g_edicts - 1] = true;
+		bots += (ent != NULL);
+	}
+	else if (want < bots)
+	{
+		for (i = game.maxclients - 1; i >= 0; i--)
+		{
+			if (!autofill_bot[i])
+				continue;
+			autofill_bot[i] = false;
+			ACESP_RemoveBot(g_edicts[i + 1].client->pers.netname);
+			bots--;
+			break;
+		}
+	}
+	autofill_wanted = want - bots;
+}
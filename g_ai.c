@@ -33,6 +33,36 @@ qboolean	enemy_vis;
 qboolean	enemy_infront;
 int			enemy_range;
 float		enemy_yaw;
+/*
+=================
+AI_SightTarget
+
+Returns what monsters should look for in place of client ent, or NULL
+if it is dead, in notarget or disguised.
+=================
+*/
+static edict_t *AI_SightTarget (edict_t *ent)
+{
+	if (!ent->inuse
+		|| ent->health <= 0
+		|| (ent->flags & (FL_NOTARGET|FL_DISGUISED) ) )
+		return NULL;
+
+	// If player is using func_monitor, make
+	// the sight_client = the fake player at the
+	// monitor currently taking the player's place.
+	// Do NOT do this for players using a
+	// target_monitor, though... in this case
+	// both player and fake player are ignored.
+	if(ent->client && ent->client->camplayer)
+	{
+		if(ent->client->spycam)
+			return ent->client->camplayer;
+		return NULL;
+	}
+	return ent;
+}
+
 /*
 =================
 AI_SetSightClient
@@ -62,30 +92,11 @@ void AI_SetSightClient (void)
 		check++;
 		if (check > game.maxclients)
 			check = 1;
-		ent = &g_edicts[check];
-		if (ent->inuse
-			&& ent->health > 0
-			&& !(ent->flags & (FL_NOTARGET|FL_DISGUISED) ) )
+		ent = AI_SightTarget (&g_edicts[check]);
+		if (ent)
 		{
-			// If player is using func_monitor, make
-			// the sight_client = the fake player at the
-			// monitor currently taking the player's place.
-			// Do NOT do this for players using a
-			// target_monitor, though... in this case
-			// both player and fake player are ignored.
-			if(ent->client && ent->client->camplayer)
-			{
-				if(ent->client->spycam)
-				{
-					level.sight_client = ent->client->camplayer;
-					return;
-				}
-			}
-			else
-			{
-				level.sight_client = ent;
-				return;		// got one
-			}
+			level.sight_client = ent;
+			return;		// got one
 		}
 		if (check == start)
 		{
@@ -95,6 +106,45 @@ void AI_SetSightClient (void)
 	}
 }
 
+/*
+=================
+AI_FindSightClient
+
+FindTarget used to only look at level.sight_client, so in coop each
+monster saw a given player one frame in game.maxclients. Every client
+is checked now, starting from sight_client so no player is favored.
+The first one the monster can see wins. If none can be seen, this is
+sight_client as before, which may still be found in a mirror.
+=================
+*/
+static edict_t *AI_FindSightClient (edict_t *self)
+{
+	edict_t	*ent;
+	int		start, check;
+
+	if (!level.sight_client)
+		return NULL;
+
+	// sight_client may be a func_monitor fake player
+	if (level.sight_client->client)
+		start = level.sight_client - g_edicts;
+	else
+		start = 1;
+
+	check = start;
+	do
+	{
+		ent = AI_SightTarget (&g_edicts[check]);
+		if (ent && AI_CachedVisible (self, ent))
+			return ent;
+		check++;
+		if (check > game.maxclients)
+			check = 1;
+	} while (check != start);
+
+	return level.sight_client;
+}
+
 //============================================================================
 
 /*
@@ -381,6 +431,59 @@ int range (edict_t *self, edict_t *other)
 	return RANGE_FAR;
 }
 
+/*
+=============
+AI_FogVisible
+
+Lazarus: Take fog into account for monsters. Called once nothing solid
+is between spot1 and spot2, sets self->monsterinfo.visibility.
+=============
+*/
+static qboolean AI_FogVisible (edict_t *self, vec3_t spot1, vec3_t spot2)
+{
+	if( (level.active_fog) && (self->svflags & SVF_MONSTER) )
+	{
+		fog_t	*pfog;
+		float	r;
+		float	dw;
+		vec3_t	v;
+
+		pfog = &level.fog;
+		VectorSubtract(spot2,spot1,v);
+		r = VectorLength(v);
+		switch(pfog->Model)
+		{
+		case 1:
+			dw = pfog->Density/10000. * r;
+			self->monsterinfo.visibility = exp( -dw );
+			break;
+		case 2:
+			dw = pfog->Density/10000. * r;
+			self->monsterinfo.visibility = exp( -dw*dw );
+			break;
+		default:
+			if((r < pfog->Near) || (pfog->Near == pfog->Far))
+				self->monsterinfo.visibility = 1.0;
+			else if(r > pfog->Far)
+				self->monsterinfo.visibility = 0.0;
+			else
+				self->monsterinfo.visibility = 1.0 - (r - pfog->Near)/(pfog->Far - pfog->Near);
+			break;
+		}
+//		if(developer->value)
+//			gi.dprintf("r=%g, vis=%g\n",r,self->monsterinfo.visibility);
+		if(self->monsterinfo.visibility < 0.05)
+			return false;
+		else
+			return true;
+	}
+	else
+	{
+		self->monsterinfo.visibility = 1.0;
+		return true;
+	}
+}
+
 /*
 =============
 visible
@@ -403,53 +506,141 @@ qboolean visible (edict_t *self, edict_t *other)
 	spot2[2] += other->viewheight;
 	trace = gi.trace (spot1, vec3_origin, vec3_origin, spot2, self, MASK_OPAQUE);
 
-	// Lazarus: Take fog into account for monsters
-
 	if ( (trace.fraction == 1.0) || (trace.ent == other))
+		return AI_FogVisible (self, spot1, spot2);
+	return false;
+}
+
+/*
+==============================================================================
+
+MONSTER SIGHT CACHE
+
+FindTarget and ai_checkattack ask every frame whether each monster can
+see a player, and ACEAI_FindEnemy and CTFSetIDView ask the same of
+every pair of players. The answer for a monster or client and a client
+is kept for SIGHT_CACHE_FRAMES frames, as long as neither eye has moved
+more than SIGHT_CACHE_MOVE units. Pairs that are not in each other's
+PVS are not traced at all. Two clients share one entry, filed under the
+lower edict, since the trace between their eyes is the same both ways.
+Fog is still worked out on every call, since it is cheap and target_fog
+can change it at any time.
+
+The cache is given a slot per edict and client the first time a monster
+looks, so deathmatch games without monsters never pay for it.
+==============================================================================
+*/
+
+#define	SIGHT_CACHE_FRAMES	3
+#define	SIGHT_CACHE_MOVE	8
+
+typedef struct
+{
+	int			framenum;	// frame of the trace + 1, 0 if never traced
+	qboolean	clear;		// nothing opaque between the two eyes
+	vec3_t		spot1;		// monster's eye
+	vec3_t		spot2;		// client's eye
+} sightcache_t;
+
+static sightcache_t	*sight_cache;
+
+/*
+=============
+AI_InitSightCache
+
+Called from InitGame. The cache is allocated on first use.
+=============
+*/
+void AI_InitSightCache (void)
+{
+	sight_cache = NULL;
+}
+
+/*
+=============
+AI_ClearSightCache
+
+Called when a level is spawned or loaded
+=============
+*/
+void AI_ClearSightCache (void)
+{
+	if (sight_cache)
+		memset (sight_cache, 0, game.maxentities * game.maxclients * sizeof(sightcache_t));
+}
+
+static qboolean AI_SightMoved (vec3_t a, vec3_t b)
+{
+	vec3_t	v;
+
+	VectorSubtract (a, b, v);
+	return (DotProduct (v, v) > SIGHT_CACHE_MOVE*SIGHT_CACHE_MOVE);
+}
+
+/*
+=============
+AI_CachedVisible
+
+Same as visible, but remembers the trace between a monster or client
+and a client
+=============
+*/
+qboolean AI_CachedVisible (edict_t *self, edict_t *other)
+{
+	sightcache_t	*sight;
+	edict_t			*a, *b;
+	vec3_t			spot1;
+	vec3_t			spot2;
+	trace_t			trace;
+	int				n;
+
+	if (!self || !other) // Knightmare- crash protect
+		return false;
+
+	n = other - g_edicts - 1;
+	if (!((self->svflags & SVF_MONSTER) || self->client) || !other->client || n < 0 || n >= game.maxclients)
+		return visible (self, other);
+
+	// between two clients, trace from the lower one
+	a = self;
+	b = other;
+	if (self->client && self > other)
 	{
-		if( (level.active_fog) && (self->svflags & SVF_MONSTER) )
-		{
-			fog_t	*pfog;
-			float	r;
-			float	dw;
-			vec3_t	v;
-
-			pfog = &level.fog;
-			VectorSubtract(spot2,spot1,v);
-			r = VectorLength(v);
-			switch(pfog->Model)
-			{
-			case 1:
-				dw = pfog->Density/10000. * r;
-				self->monsterinfo.visibility = exp( -dw );
-				break;
-			case 2:
-				dw = pfog->Density/10000. * r;
-				self->monsterinfo.visibility = exp( -dw*dw );
-				break;
-			default:
-				if((r < pfog->Near) || (pfog->Near == pfog->Far))
-					self->monsterinfo.visibility = 1.0;
-				else if(r > pfog->Far)
-					self->monsterinfo.visibility = 0.0;
-				else
-					self->monsterinfo.visibility = 1.0 - (r - pfog->Near)/(pfog->Far - pfog->Near);
-				break;
-			}
-//			if(developer->value)
-//				gi.dprintf("r=%g, vis=%g\n",r,self->monsterinfo.visibility);
-			if(self->monsterinfo.visibility < 0.05)
-				return false;
-			else
-				return true;
-		}
+		a = other;
+		b = self;
+		n = b - g_edicts - 1;
+	}
+
+	if (!sight_cache)
+		sight_cache = (sightcache_t *)gi.TagMalloc (game.maxentities * game.maxclients * sizeof(sightcache_t), TAG_GAME);
+
+	VectorCopy (a->s.origin, spot1);
+	spot1[2] += a->viewheight;
+	VectorCopy (b->s.origin, spot2);
+	spot2[2] += b->viewheight;
+
+	sight = &sight_cache[(a - g_edicts) * game.maxclients + n];
+	if (!sight->framenum
+		|| level.framenum + 1 < sight->framenum
+		|| level.framenum + 1 - sight->framenum >= SIGHT_CACHE_FRAMES
+		|| AI_SightMoved (spot1, sight->spot1)
+		|| AI_SightMoved (spot2, sight->spot2))
+	{
+		if (!gi.inPVS (spot1, spot2))
+			sight->clear = false;
 		else
 		{
-			self->monsterinfo.visibility = 1.0;
-			return true;
+			trace = gi.trace (spot1, vec3_origin, vec3_origin, spot2, a, MASK_OPAQUE);
+			sight->clear = ( (trace.fraction == 1.0) || (trace.ent == b) );
 		}
+		sight->framenum = level.framenum + 1;
+		VectorCopy (spot1, sight->spot1);
+		VectorCopy (spot2, sight->spot2);
 	}
-	return false;
+
+	if (!sight->clear)
+		return false;
+	return AI_FogVisible (self, spot1, spot2);
 }
 
 
@@ -747,7 +938,7 @@ qboolean FindTarget (edict_t *self)
 	}
 	else
 	{
-		client = level.sight_client;
+		client = AI_FindSightClient (self);
 		if (!client)
 			return false;	// no clients to get mad at
 	}
@@ -825,7 +1016,7 @@ qboolean FindTarget (edict_t *self)
 		if (client->light_level <= 5) 
 			return false;
 
-		if (!visible (self, client))
+		if (!AI_CachedVisible (self, client))
 		{
 			vec3_t	temp;
 
@@ -1302,7 +1493,7 @@ qboolean ai_checkattack (edict_t *self, float dist)
 
 // check knowledge of enemy
 
-	enemy_vis = visible(self, self->enemy);
+	enemy_vis = AI_CachedVisible(self, self->enemy);
 
 	if (enemy_vis)
 	{
@@ -1383,7 +1574,7 @@ void ai_run (edict_t *self, float dist)
 	edict_t		*tempgoal;
 	edict_t		*save;
 	qboolean	new_one;
-	edict_t		*marker;
+	trailspot_t	*marker;
 	float		d1, d2;
 	trace_t		tr;
 	vec3_t		v_forward, v_right;
@@ -1640,9 +1831,9 @@ void ai_run (edict_t *self, float dist)
 
 		if (marker)
 		{
-			VectorCopy (marker->s.origin, self->monsterinfo.last_sighting);
+			VectorCopy (marker->origin, self->monsterinfo.last_sighting);
 			self->monsterinfo.trail_time = marker->timestamp;
-			self->s.angles[YAW] = self->ideal_yaw = marker->s.angles[YAW];
+			self->s.angles[YAW] = self->ideal_yaw = marker->yaw;
 //			dprint("heading is "); dprint(ftos(self.ideal_yaw)); dprint("\n");
 
 //			debug_drawline(self.origin, self.last_sighting, 52);
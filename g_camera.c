@@ -23,6 +23,137 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "g_local.h"
 
+/*
+=====================
+CAMPLAYER POOL
+
+Looking through a func_monitor or target_monitor leaves a "camplayer"
+stand-in where the player was. Each player's stand-in is kept when the
+player stops looking, hidden the way pooled reflections are, along with
+its fake client, and handed back the next time, so flipping through
+monitors doesn't free and allocate an edict and a gclient_t each time.
+
+Pooled stand-ins stay inuse with SVF_NOCLIENT set, unlinked, and point
+at their player with target_ent. RestoreCamPlayers puts them back in
+the pool when a level is loaded.
+=====================
+*/
+
+static edict_t		*camplayer_pool[MAX_CLIENTS];
+static gclient_t	*camplayer_clients[MAX_CLIENTS];	// TAG_LEVEL like G_Malloc
+
+/*
+=================
+GetCamPlayer
+
+Returns a fresh stand-in for player, with a zeroed fake client. The
+edict is as G_Spawn would have returned it.
+=================
+*/
+edict_t *GetCamPlayer (edict_t *player)
+{
+	edict_t	*faker;
+	int		slot;
+
+	slot = player - g_edicts - 1;
+	if (slot < 0 || slot >= MAX_CLIENTS)
+	{
+		faker = G_Spawn();
+		faker->client = (gclient_t *)G_Malloc(sizeof(gclient_t));
+		memset (faker->client, 0, sizeof(gclient_t));
+		return faker;
+	}
+
+	faker = camplayer_pool[slot];
+	camplayer_pool[slot] = NULL;
+	if (faker)
+	{
+		memset (faker, 0, sizeof(*faker));
+		G_InitEdict (faker);
+	}
+	else
+		faker = G_Spawn();
+
+	if (!camplayer_clients[slot])
+		camplayer_clients[slot] = (gclient_t *)G_Malloc(sizeof(gclient_t));
+	faker->client = camplayer_clients[slot];
+	camplayer_clients[slot] = NULL;
+	memset (faker->client, 0, sizeof(gclient_t));
+	return faker;
+}
+
+/*
+=================
+PoolCamPlayer
+
+Takes back player's stand-in once player is done with it
+=================
+*/
+void PoolCamPlayer (edict_t *player, edict_t *faker)
+{
+	int		slot;
+
+	slot = player - g_edicts - 1;
+	if (slot < 0 || slot >= MAX_CLIENTS || camplayer_pool[slot])
+	{
+		G_Free(faker->client);
+		G_FreeEdict(faker);
+		return;
+	}
+
+	if (faker->client)
+	{
+		if (!camplayer_clients[slot])
+			camplayer_clients[slot] = faker->client;
+		else
+			G_Free(faker->client);
+		faker->client = NULL;
+	}
+
+	gi.unlinkentity (faker);
+	memset (&faker->s, 0, sizeof(faker->s));
+	faker->s.number   = faker - g_edicts;
+	faker->svflags    = SVF_NOCLIENT;
+	faker->solid      = SOLID_NOT;
+	faker->takedamage = DAMAGE_NO;
+	faker->movetype   = MOVETYPE_NONE;
+	faker->think      = NULL;
+	faker->nextthink  = 0;
+	faker->target_ent = player;
+	camplayer_pool[slot] = faker;
+}
+
+/*
+=================
+RestoreCamPlayers
+
+Called from G_ResetLevelCaches. Pooled stand-ins from a savegame
+or restart go back in their player's slot, and the fake clients, which
+were TAG_LEVEL memory, are forgotten.
+=================
+*/
+void RestoreCamPlayers (void)
+{
+	edict_t	*e;
+	int		i, slot;
+
+	memset (camplayer_pool, 0, sizeof(camplayer_pool));
+	memset (camplayer_clients, 0, sizeof(camplayer_clients));
+
+	for (i=game.maxclients+1; i<globals.num_edicts; i++)
+	{
+		e = &g_edicts[i];
+		if (!e->inuse || !(e->svflags & SVF_NOCLIENT) || !e->classname || strcmp(e->classname, "camplayer"))
+			continue;
+		e->client = NULL;
+		slot = e->target_ent ? (e->target_ent - g_edicts - 1) : -1;
+		if (slot < 0 || slot >= MAX_CLIENTS || camplayer_pool[slot])
+			G_FreeEdict (e);
+		else
+			camplayer_pool[slot] = e;
+	}
+}
+
 void camera_off (edict_t *ent)
 {
 	int	i;
@@ -38,8 +169,7 @@ void camera_off (edict_t *ent)
 	if(ent->client->spycam->svflags & SVF_MONSTER)
 		ent->client->spycam->svflags &= ~SVF_NOCLIENT;
 	VectorCopy(ent->client->camplayer->s.origin,ent->s.origin);
-	G_Free(ent->client->camplayer->client); 
-	G_FreeEdict (ent->client->camplayer); 
+	PoolCamPlayer (ent, ent->client->camplayer);
 
 	// set angles
 	ent->movetype = MOVETYPE_WALK;
@@ -96,7 +226,6 @@ void faker_animate(edict_t *self)
 
 void camera_on (edict_t *ent)
 {
-    gclient_t	*cl; 
 	edict_t		*faker;
 	edict_t		*monster;
 	edict_t		*camera;
@@ -120,7 +249,7 @@ void camera_on (edict_t *ent)
 	VectorCopy(ent->client->v_angle,ent->client->org_viewangles);
 
     // copy over all important player data to fake player
-	ent->client->camplayer = G_Spawn();
+	ent->client->camplayer = GetCamPlayer (ent);
 	faker = ent->client->camplayer;
 	faker->s.frame = ent->s.frame; 
 	VectorCopy (ent->s.origin, faker->s.origin); 
@@ -143,10 +272,7 @@ void camera_on (edict_t *ent)
 	faker->nextthink    = level.time + FRAMETIME;
 	VectorCopy(ent->mins,faker->mins);
 	VectorCopy(ent->maxs,faker->maxs);
-    // create a client so you can pick up items/be shot/etc while in camera
-	cl = (gclient_t *) G_Malloc(sizeof(gclient_t)); 
-	memset(cl,0,sizeof(gclient_t));
-	ent->client->camplayer->client = cl; 
+    // the client from GetCamPlayer lets you pick up items/be shot/etc while in camera
 	ent->client->camplayer->target_ent = ent;
 	gi.linkentity (faker); 
 
@@ -187,9 +313,62 @@ void camera_on (edict_t *ent)
 }
 
 
+/*
+=================
+G_MonitorCameras
+
+Fills list with the cameras monitor looks through, in map order. The
+targetname index hands these over without walking every edict.
+=================
+*/
+static edict_t	*monitor_cameras[MAX_EDICTS];
+
+static int G_MonitorCameras (edict_t *monitor)
+{
+	edict_t	*e;
+	int		num;
+
+	num = 0;
+	e = NULL;
+	while ((e = G_Find(e, FOFS(targetname), monitor->target)) != NULL && num < MAX_EDICTS)
+		monitor_cameras[num++] = e;
+	return num;
+}
+
+static qboolean G_CameraUsable (edict_t *camera)
+{
+	if (camera->deadflag == DEAD_DEAD)
+		return false;
+	// don't select "inactive" cameras
+	if (!Q_strcasecmp (camera->classname,"turret_breach") && (camera->spawnflags & 16))
+		return false;
+	return true;
+}
+
+/*
+=================
+G_CountedCamera
+
+The first of the cameras with this count, or NULL if there is none or
+it can't be used
+=================
+*/
+static edict_t *G_CountedCamera (int num, int which)
+{
+	int		i;
+
+	for (i=0; i<num; i++)
+	{
+		if (monitor_cameras[i]->count == which)
+			return G_CameraUsable(monitor_cameras[i]) ? monitor_cameras[i] : NULL;
+	}
+	return NULL;
+}
+
 edict_t *G_FindNextCamera (edict_t *camera, edict_t *monitor)
 {
 	edict_t	*next;
+	int		i, num;
 
 	if(!monitor->target) return NULL;
 
@@ -204,48 +383,21 @@ edict_t *G_FindNextCamera (edict_t *camera, edict_t *monitor)
 	// or just scan through the list of entities. If count for the first camera
 	// in the map is 0, then we'll just use the map order.
 
-	next = G_Find(NULL,FOFS(targetname),monitor->target);
-	if(!next) return NULL;
-	if(!next->count) {
-		
-		if(camera) {
-			next = camera;
-			next++;
-		} else
-			next = g_edicts;
-		
-		for ( ; next < &g_edicts[globals.num_edicts] ; next++)
+	num = G_MonitorCameras (monitor);
+	if(!num) return NULL;
+	if(!monitor_cameras[0]->count) {
+
+		// the first one after camera, then wrap around
+		for (i=0; i<num; i++)
 		{
-			if (next == camera)
-				continue;
-			if (!next->inuse)
-				continue;
-			if (next->deadflag == DEAD_DEAD)
-				continue;
-			if (!next->targetname)
-				continue;
-			// don't select "inactive" cameras
-			if (!Q_strcasecmp (next->classname,"turret_breach") && (next->spawnflags & 16))
-				continue;
-			if (!Q_strcasecmp (next->targetname, monitor->target))
+			next = monitor_cameras[i];
+			if (next > camera && G_CameraUsable(next))
 				goto found_one;
-
 		}
-		next = g_edicts;
-		for ( ; next < camera ; next++)
+		for (i=0; i<num && monitor_cameras[i] < camera; i++)
 		{
-			if (next == camera)
-				continue;
-			if (!next->inuse)
-				continue;
-			if (next->deadflag == DEAD_DEAD)
-				continue;
-			if (!next->targetname)
-				continue;
-			// don't select "inactive" cameras
-			if (!Q_strcasecmp (next->classname,"turret_breach") && (next->spawnflags & 16))
-				continue;
-			if (!Q_strcasecmp (next->targetname, monitor->target))
+			next = monitor_cameras[i];
+			if (G_CameraUsable(next))
 				goto found_one;
 		}
 	} else {
@@ -258,30 +410,13 @@ edict_t *G_FindNextCamera (edict_t *camera, edict_t *monitor)
 		else
 			which = 1;
 		start = which;
-		next = g_edicts+1;
 		while(1) {
-			if(next->targetname) {
-				if(!Q_strcasecmp(next->targetname,monitor->target)) {
-					if(next->count == which) {
-						if(!next->inuse || (next->deadflag == DEAD_DEAD) ||
-							(!Q_strcasecmp (next->classname,"turret_breach") && (next->spawnflags & 16)) )
-						{
-							next = g_edicts;
-							which++;
-							if(which > monitor->count) which=1;
-							if(which == start) return NULL;
-						} else
-							goto found_one;
-					}
-				}
-			}
-			if(next == &g_edicts[globals.num_edicts-1]) {
-				next = g_edicts;
-				which++;
-				if(which > monitor->count) which = 1;
-				if(which == start) return NULL;
-			}
-			next++;
+			next = G_CountedCamera (num, which);
+			if(next)
+				goto found_one;
+			which++;
+			if(which > monitor->count) which = 1;
+			if(which == start) return NULL;
 		}
 	}
 	return NULL;
@@ -296,6 +431,7 @@ edict_t *G_FindPrevCamera (edict_t *camera, edict_t *monitor)
 {
 	edict_t	*prev;
 	edict_t	*newcamera;
+	int		i, num;
 
 	if(!monitor->target) return NULL;
 
@@ -310,27 +446,20 @@ edict_t *G_FindPrevCamera (edict_t *camera, edict_t *monitor)
 	// or just scan through the list of entities. If count for the first camera
 	// in the map is 0, then we'll just use the map order.
 
-	prev = G_Find(NULL,FOFS(targetname),monitor->target);
-	if(!prev) return NULL;
-	if(!prev->count)
+	newcamera = NULL;
+	num = G_MonitorCameras (monitor);
+	if(!num) return NULL;
+	if(!monitor_cameras[0]->count)
 	{
-		newcamera = NULL;
-		for (prev = g_edicts ; prev < &g_edicts[globals.num_edicts] ; prev++)
+		// the last one before camera, or else the last one of all
+		for (i=0; i<num; i++)
 		{
+			prev = monitor_cameras[i];
 			if (prev == camera) {
 				if (newcamera) goto found_one;
 				continue;
 			}
-			if (!prev->inuse)
-				continue;
-			if (prev->deadflag == DEAD_DEAD)
-				continue;
-			if (!prev->targetname)
-				continue;
-			// don't select "inactive" cameras
-			if (!Q_strcasecmp (prev->classname,"turret_breach") && (prev->spawnflags & 16))
-				continue;
-			if (!Q_strcasecmp (prev->targetname, monitor->target))
+			if (G_CameraUsable(prev))
 				newcamera = prev;
 		}
 		goto found_one;
@@ -346,34 +475,13 @@ edict_t *G_FindPrevCamera (edict_t *camera, edict_t *monitor)
 		else 
 			which = monitor->count;
 		start = which;
-		prev = g_edicts+1;
 		while(1) {
-			if(prev->targetname) {
-				if(!Q_strcasecmp(prev->targetname,monitor->target)) {
-					if(prev->count == which) {
-						if(!prev->inuse || (prev->deadflag == DEAD_DEAD) ||
-							(!Q_strcasecmp (prev->classname,"turret_breach") && (prev->spawnflags & 16)))
-						{
-							prev = g_edicts;
-							which--;
-							if(which <= 0) which=monitor->count;
-							if(which == start) return NULL;
-						}
-						else
-						{
-							newcamera = prev;
-							goto found_one;
-						}
-					}
-				}
-			}
-			if(prev == &g_edicts[globals.num_edicts-1]) {
-				prev = g_edicts;
-				which--;
-				if(which <= 0) which=monitor->count;
-				if(which == start) return NULL;
-			}
-			prev++;
+			newcamera = G_CountedCamera (num, which);
+			if(newcamera)
+				goto found_one;
+			which--;
+			if(which <= 0) which=monitor->count;
+			if(which == start) return NULL;
 		}
 	}
 
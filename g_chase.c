@@ -21,6 +21,34 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "g_local.h"
 
+/*
+=================
+Chase camera placement
+
+Where the camera goes depends only on the player being chased, so the
+spot and the three traces behind it are worked out once per target
+and handed to every spectator following the same player. It is worked
+out again whenever the target's origin, view or ground changes, which
+also covers spectators switching targets between frames.
+=================
+*/
+static struct
+{
+	int			framenum;		// level.framenum + 1, 0 if never placed
+	vec3_t		origin;
+	vec3_t		v_angle;
+	qboolean	onground;
+	vec3_t		goal;
+} chase_spot[MAX_CLIENTS];
+
+static qboolean ChaseSpotValid (edict_t *targ, int n)
+{
+	return (chase_spot[n].framenum == level.framenum + 1
+		&& VectorCompare (chase_spot[n].origin, targ->s.origin)
+		&& VectorCompare (chase_spot[n].v_angle, targ->client->v_angle)
+		&& chase_spot[n].onground == (targ->groundentity != NULL));
+}
+
 void UpdateChaseCam(edict_t *ent)
 {
 	vec3_t o, ownerv, goal;
@@ -30,6 +58,7 @@ void UpdateChaseCam(edict_t *ent)
 	int i;
 	vec3_t oldgoal;
 	vec3_t angles;
+	int n;
 
 	// is our chase target gone?
 	if (!ent->client->chase_target->inuse
@@ -45,6 +74,12 @@ void UpdateChaseCam(edict_t *ent)
 
 	targ = ent->client->chase_target;
 
+	n = targ - g_edicts - 1;
+	if (n >= 0 && n < MAX_CLIENTS && ChaseSpotValid (targ, n)) {
+		VectorCopy(chase_spot[n].goal, goal);
+		goto placed;
+	}
+
 	VectorCopy(targ->s.origin, ownerv);
 	VectorCopy(ent->s.origin, oldgoal);
 
@@ -87,6 +122,15 @@ void UpdateChaseCam(edict_t *ent)
 		goal[2] += 6;
 	}
 
+	if (n >= 0 && n < MAX_CLIENTS) {
+		chase_spot[n].framenum = level.framenum + 1;
+		VectorCopy(targ->s.origin, chase_spot[n].origin);
+		VectorCopy(targ->client->v_angle, chase_spot[n].v_angle);
+		chase_spot[n].onground = (targ->groundentity != NULL);
+		VectorCopy(goal, chase_spot[n].goal);
+	}
+
+placed:
 	if (targ->deadflag)
 		ent->client->ps.pmove.pm_type = PM_DEAD;
 	else
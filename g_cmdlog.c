@@ -0,0 +1,518 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+
+/*
+==============================================================================
+
+USERCMD LOG
+
+"sv cmdlog record <file>" records the next level from its start: the
+map, the random seed, the cvars below and every usercmd that reaches
+ClientThink, bots' included, along with the frame it arrived after
+and when each client slot joined and left. Recording stops at the
+next map change or "sv cmdlog stop".
+
+"sv cmdlog play <file>" sets the recorded cvars and starts the map.
+Each slot in the log is driven as a plain client: it is connected
+with the recorded userinfo when it first joined and fed its usercmds
+before the frame they arrived before. Nobody else can connect and no
+bots can be added while a log plays, and the game is seeded the same
+way, so two builds replaying the same log see the same load. Run
+"sv profile start" first to time it.
+
+A replay is not bit-exact: recorded bots become plain clients, and
+their commands, sent from inside a frame, are replayed before the
+next one.
+
+==============================================================================
+*/
+
+qboolean ClientConnect (edict_t *ent, char *userinfo);
+void ClientBegin (edict_t *ent);
+void ClientDisconnect (edict_t *ent);
+void ClientThink (edict_t *ent, usercmd_t *ucmd);
+
+#define	CMDLOG_IDENT		(('G'<<24)+('L'<<16)+('M'<<8)+'C')	// "CMLG"
+#define	CMDLOG_VERSION		1
+
+enum
+{
+	CMDLOG_OFF,
+	CMDLOG_ARMED,		// record or play from the next SpawnEntities
+	CMDLOG_RECORDING,
+	CMDLOG_PLAYING
+};
+
+enum
+{
+	CMDLOG_CMD,			// usercmd_t
+	CMDLOG_BEGIN,		// userinfo string
+	CMDLOG_DISCONNECT
+};
+
+typedef struct
+{
+	int		ident;
+	int		version;
+	char	mapname[MAX_QPATH];
+	int		seed;
+	int		maxclients;
+	int		numcvars;
+} cmdlog_header_t;
+
+typedef struct
+{
+	char	name[32];
+	char	value[64];
+} cmdlog_cvar_t;
+
+typedef struct
+{
+	int				frame;
+	byte			type;
+	byte			slot;
+	unsigned short	size;		// bytes that follow
+} cmdlog_event_t;
+
+static char *cmdlog_cvars[] =
+{
+	"deathmatch", "coop", "ctf", "ttctf", "skill", "dmflags", "fraglimit",
+	"timelimit", "capturelimit", "sv_gravity", "sv_maxvelocity",
+	"sv_stopspeed", "g_select_empty", "tech_flags", NULL
+};
+
+static int		cmdlog_state = CMDLOG_OFF;
+static qboolean	cmdlog_play;			// what CMDLOG_ARMED will do
+static char		cmdlog_name[MAX_OSPATH];
+static FILE		*cmdlog_file;
+static int		cmdlog_events;
+static qboolean	cmdlog_joined[MAX_CLIENTS];
+
+static byte		*cmdlog_data;			// log being played
+static int		cmdlog_size;
+static int		cmdlog_pos;
+static qboolean	cmdlog_feeding;			// ClientThink call is ours
+
+static void CmdLog_FileName (char *out, int size, char *name)
+{
+	cvar_t	*game;
+
+	game = gi.cvar("game", "", 0);
+	Com_sprintf (out, size, "%s/%s", *game->string ? game->string : GAMEVERSION, name);
+}
+
+/*
+=================
+CmdLog_Stop
+
+Closes what is being recorded or played and disconnects the clients a
+replay was driving.
+=================
+*/
+static void CmdLog_Stop (void)
+{
+	edict_t	*ent;
+	int		i;
+
+	if (cmdlog_state == CMDLOG_RECORDING && cmdlog_file)
+	{
+		fclose (cmdlog_file);
+		safe_cprintf (NULL, PRINT_HIGH, "Recorded %i events to %s.\n", cmdlog_events, cmdlog_name);
+	}
+	cmdlog_file = NULL;
+
+	if (cmdlog_state == CMDLOG_PLAYING)
+	{
+		cmdlog_feeding = true;
+		for (i = 0; i < game.maxclients; i++)
+		{
+			ent = g_edicts + 1 + i;
+			if (cmdlog_joined[i] && ent->inuse)
+			{
+				ClientDisconnect (ent);
+				ent->inuse = false;
+			}
+		}
+		cmdlog_feeding = false;
+		safe_cprintf (NULL, PRINT_HIGH, "Replay of %s stopped at frame %i.\n", cmdlog_name, level.framenum);
+	}
+
+	if (cmdlog_data)
+		gi.TagFree (cmdlog_data);
+	cmdlog_data = NULL;
+	cmdlog_state = CMDLOG_OFF;
+}
+
+static void CmdLog_Write (int type, int slot, void *data, int size)
+{
+	cmdlog_event_t	ev;
+
+	ev.frame = level.framenum;
+	ev.type = type;
+	ev.slot = slot;
+	ev.size = size;
+	fwrite (&ev, sizeof(ev), 1, cmdlog_file);
+	if (size)
+		fwrite (data, size, 1, cmdlog_file);
+	cmdlog_events++;
+}
+
+static void CmdLog_StartRecording (char *mapname)
+{
+	cmdlog_header_t	header;
+	cmdlog_cvar_t	cv;
+	int				i;
+
+	cmdlog_file = fopen (cmdlog_name, "wb");
+	if (!cmdlog_file)
+	{
+		gi.dprintf ("Couldn't open %s\n", cmdlog_name);
+		cmdlog_state = CMDLOG_OFF;
+		return;
+	}
+
+	memset (&header, 0, sizeof(header));
+	header.ident = CMDLOG_IDENT;
+	header.version = CMDLOG_VERSION;
+	Q_strlcpy (header.mapname, mapname, sizeof(header.mapname));
+	header.seed = (int)time(NULL);
+	header.maxclients = game.maxclients;
+	for (i = 0; cmdlog_cvars[i]; i++)
+		;
+	header.numcvars = i;
+	fwrite (&header, sizeof(header), 1, cmdlog_file);
+
+	for (i = 0; cmdlog_cvars[i]; i++)
+	{
+		memset (&cv, 0, sizeof(cv));
+		Q_strlcpy (cv.name, cmdlog_cvars[i], sizeof(cv.name));
+		Q_strlcpy (cv.value, gi.cvar(cmdlog_cvars[i], "0", 0)->string, sizeof(cv.value));
+		fwrite (&cv, sizeof(cv), 1, cmdlog_file);
+	}
+
+	srand (header.seed);
+	memset (cmdlog_joined, 0, sizeof(cmdlog_joined));
+	cmdlog_events = 0;
+	cmdlog_state = CMDLOG_RECORDING;
+	gi.dprintf ("Recording usercmds to %s\n", cmdlog_name);
+}
+
+/*
+=================
+CmdLog_Load
+
+Reads a log for "sv cmdlog play" and sets its cvars. Returns the map
+it was recorded on, or NULL.
+=================
+*/
+static char *CmdLog_Load (void)
+{
+	static cmdlog_header_t	header;
+	cmdlog_cvar_t	*cv;
+	FILE			*f;
+	int				i;
+
+	f = fopen (cmdlog_name, "rb");
+	if (!f)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "Couldn't open %s\n", cmdlog_name);
+		return NULL;
+	}
+	fseek (f, 0, SEEK_END);
+	cmdlog_size = (int)ftell(f);
+	fseek (f, 0, SEEK_SET);
+	if (cmdlog_size < (int)sizeof(header))
+	{
+		fclose (f);
+		safe_cprintf (NULL, PRINT_HIGH, "%s is not a usercmd log\n", cmdlog_name);
+		return NULL;
+	}
+	cmdlog_data = gi.TagMalloc (cmdlog_size, TAG_GAME);
+	cmdlog_size = (int)fread (cmdlog_data, 1, cmdlog_size, f);
+	fclose (f);
+
+	memcpy (&header, cmdlog_data, sizeof(header));
+	if (header.ident != CMDLOG_IDENT || header.version != CMDLOG_VERSION
+		|| header.numcvars < 0
+		|| sizeof(header) + header.numcvars * sizeof(cmdlog_cvar_t) > (size_t)cmdlog_size)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "%s is not a usercmd log\n", cmdlog_name);
+		gi.TagFree (cmdlog_data);
+		cmdlog_data = NULL;
+		return NULL;
+	}
+	header.mapname[sizeof(header.mapname)-1] = 0;
+	if (header.maxclients > game.maxclients)
+		safe_cprintf (NULL, PRINT_HIGH, "Log was recorded with maxclients %i, clients above %i are skipped.\n",
+			header.maxclients, game.maxclients);
+
+	cv = (cmdlog_cvar_t *)(cmdlog_data + sizeof(header));
+	for (i = 0; i < header.numcvars; i++, cv++)
+	{
+		cv->name[sizeof(cv->name)-1] = 0;
+		cv->value[sizeof(cv->value)-1] = 0;
+		gi.cvar_forceset (cv->name, cv->value);
+	}
+	cmdlog_pos = (byte *)cv - cmdlog_data;
+	return header.mapname;
+}
+
+static void CmdLog_StartPlaying (void)
+{
+	cmdlog_header_t	header;
+
+	memcpy (&header, cmdlog_data, sizeof(header));
+	srand (header.seed);
+	memset (cmdlog_joined, 0, sizeof(cmdlog_joined));
+	cmdlog_state = CMDLOG_PLAYING;
+	gi.dprintf ("Replaying usercmds from %s\n", cmdlog_name);
+}
+
+/*
+=================
+CmdLog_LevelStart
+
+Called from SpawnEntities before anything is spawned
+=================
+*/
+void CmdLog_LevelStart (char *mapname)
+{
+	if (cmdlog_state == CMDLOG_RECORDING || cmdlog_state == CMDLOG_PLAYING)
+		CmdLog_Stop ();		// a log covers one level
+
+	if (cmdlog_state != CMDLOG_ARMED)
+		return;
+
+	if (cmdlog_play)
+		CmdLog_StartPlaying ();
+	else
+		CmdLog_StartRecording (mapname);
+}
+
+/*
+=================
+CmdLog_ClientThink
+
+Called at the top of ClientThink. Returns true if the command should
+be ignored, which is every command a replay didn't send.
+=================
+*/
+qboolean CmdLog_ClientThink (edict_t *ent, usercmd_t *ucmd)
+{
+	int		slot;
+
+	if (cmdlog_state == CMDLOG_PLAYING)
+		return !cmdlog_feeding;
+
+	if (cmdlog_state != CMDLOG_RECORDING)
+		return false;
+
+	slot = ent - g_edicts - 1;
+	if (slot < 0 || slot >= game.maxclients || !ent->client)
+		return false;
+
+	if (!cmdlog_joined[slot])
+	{
+		cmdlog_joined[slot] = true;
+		CmdLog_Write (CMDLOG_BEGIN, slot, ent->client->pers.userinfo, strlen(ent->client->pers.userinfo) + 1);
+	}
+	CmdLog_Write (CMDLOG_CMD, slot, ucmd, sizeof(*ucmd));
+	return false;
+}
+
+/*
+=================
+CmdLog_ClientDisconnect
+
+Called from ClientDisconnect
+=================
+*/
+void CmdLog_ClientDisconnect (edict_t *ent)
+{
+	int		slot;
+
+	if (cmdlog_state != CMDLOG_RECORDING)
+		return;
+
+	slot = ent - g_edicts - 1;
+	if (slot < 0 || slot >= game.maxclients || !cmdlog_joined[slot])
+		return;
+	cmdlog_joined[slot] = false;
+	CmdLog_Write (CMDLOG_DISCONNECT, slot, NULL, 0);
+}
+
+/*
+=================
+CmdLog_Replaying
+
+True while a log is being played, when clients can't connect and bots
+can't be added
+=================
+*/
+qboolean CmdLog_Replaying (void)
+{
+	return (cmdlog_state == CMDLOG_PLAYING && !cmdlog_feeding);
+}
+
+/*
+=================
+CmdLog_RunFrame
+
+Called at the top of G_RunFrame, before level.framenum moves on. Feeds
+everything recorded after the frame that just ran.
+=================
+*/
+void CmdLog_RunFrame (void)
+{
+	cmdlog_event_t	ev;
+	usercmd_t		ucmd;
+	edict_t			*ent;
+	char			userinfo[MAX_INFO_STRING];
+
+	if (cmdlog_state != CMDLOG_PLAYING)
+		return;
+
+	cmdlog_feeding = true;
+	while (1)
+	{
+		if (cmdlog_pos + (int)sizeof(ev) > cmdlog_size)
+		{
+			cmdlog_feeding = false;
+			safe_cprintf (NULL, PRINT_HIGH, "End of %s.\n", cmdlog_name);
+			CmdLog_Stop ();
+			return;
+		}
+		memcpy (&ev, cmdlog_data + cmdlog_pos, sizeof(ev));
+		if (ev.frame > level.framenum)
+			break;
+		if (cmdlog_pos + (int)sizeof(ev) + ev.size > cmdlog_size)
+		{
+			cmdlog_pos = cmdlog_size;
+			continue;
+		}
+		cmdlog_pos += sizeof(ev);
+
+		if (ev.slot < game.maxclients)
+		{
+			ent = g_edicts + 1 + ev.slot;
+			switch (ev.type)
+			{
+			case CMDLOG_BEGIN:
+				if (ent->inuse)
+					ClientDisconnect (ent);
+				memset (userinfo, 0, sizeof(userinfo));
+				memcpy (userinfo, cmdlog_data + cmdlog_pos, min(ev.size, sizeof(userinfo) - 1));
+				if (ClientConnect (ent, userinfo))
+				{
+					ClientBegin (ent);
+					cmdlog_joined[ev.slot] = true;
+				}
+				break;
+			case CMDLOG_CMD:
+				if (cmdlog_joined[ev.slot] && ent->inuse && ev.size == sizeof(ucmd))
+				{
+					memcpy (&ucmd, cmdlog_data + cmdlog_pos, sizeof(ucmd));
+					ClientThink (ent, &ucmd);
+				}
+				break;
+			case CMDLOG_DISCONNECT:
+				if (cmdlog_joined[ev.slot] && ent->inuse)
+				{
+					ClientDisconnect (ent);
+					ent->inuse = false;
+				}
+				cmdlog_joined[ev.slot] = false;
+				break;
+			}
+		}
+		cmdlog_pos += ev.size;
+	}
+	cmdlog_feeding = false;
+}
+
+/*
+=================
+Svcmd_CmdLog_f
+
+"sv cmdlog record <file>|play <file>|stop"
+=================
+*/
+void Svcmd_CmdLog_f (void)
+{
+	char	*cmd, *mapname;
+
+	cmd = gi.argv(2);
+	if (!Q_strcasecmp (cmd, "stop"))
+	{
+		if (cmdlog_state == CMDLOG_ARMED)
+		{
+			if (cmdlog_data)
+				gi.TagFree (cmdlog_data);
+			cmdlog_data = NULL;
+			cmdlog_state = CMDLOG_OFF;
+		}
+		else
+			CmdLog_Stop ();
+		return;
+	}
+
+	if ((Q_strcasecmp (cmd, "record") && Q_strcasecmp (cmd, "play")) || gi.argc() < 4)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "Usage: sv cmdlog record <file>|play <file>|stop\n");
+		return;
+	}
+
+	CmdLog_Stop ();
+	CmdLog_FileName (cmdlog_name, sizeof(cmdlog_name), gi.argv(3));
+
+	if (!Q_strcasecmp (cmd, "record"))
+	{
+		cmdlog_play = false;
+		cmdlog_state = CMDLOG_ARMED;
+		safe_cprintf (NULL, PRINT_HIGH, "Recording starts with the next map.\n");
+		return;
+	}
+
+	mapname = CmdLog_Load ();
+	if (!mapname)
+		return;
+	cmdlog_play = true;
+	cmdlog_state = CMDLOG_ARMED;
+	gi.AddCommandString (va("map %s\n", mapname));
+}
+
+/*
+=================
+CmdLog_Shutdown
+
+Called from ShutdownGame
+=================
+*/
+void CmdLog_Shutdown (void)
+{
+	if (cmdlog_file)
+		fclose (cmdlog_file);
+	cmdlog_file = NULL;
+	cmdlog_data = NULL;		// TAG_GAME, freed with the rest
+	cmdlog_state = CMDLOG_OFF;
+}
@@ -456,29 +456,67 @@ void ShiftItem(edict_t *ent, int direction)
 	gi.linkentity(target);
 }
 
-char *ClientTeam (edict_t *ent)
+/*
+==================
+ClientSetTeams
+
+Model and skin teams are the two halves of a client's "skin". Each is
+turned into a team number when the userinfo changes, so OnSameTeam,
+which T_Damage asks on every hit, is a compare instead of two userinfo
+lookups. Names are numbered in the order they're first seen; when the
+table fills up it starts over and every client is numbered again.
+==================
+*/
+#define	MAX_TEAM_NAMES	(MAX_CLIENTS*2 + 2)
+
+static char	team_names[MAX_TEAM_NAMES][MAX_QPATH];
+static int	num_team_names;
+
+static int TeamNumber (char *name)
 {
-	char		*p;
-	static char	value[512];
+	int		i;
 
-	value[0] = 0;
+	for (i=0 ; i<num_team_names ; i++)
+		if (!strcmp(team_names[i], name))
+			return i+1;
+	if (num_team_names == MAX_TEAM_NAMES)
+		return 0;
+	strncpy (team_names[num_team_names], name, MAX_QPATH-1);
+	return ++num_team_names;
+}
+
+void ClientSetTeams (edict_t *ent, char *userinfo)
+{
+	char	model[MAX_QPATH];
+	char	*skin;
+	edict_t	*other;
+	int		i;
 
 	if (!ent->client)
-		return value;
+		return;
 
-	strcpy(value, Info_ValueForKey (ent->client->pers.userinfo, "skin"));
-	p = strchr(value, '/');
-	if (!p)
-		return value;
+	strncpy (model, Info_ValueForKey (userinfo, "skin"), sizeof(model)-1);
+	model[sizeof(model)-1] = 0;
+	skin = strchr(model, '/');
+	if (skin)
+		*skin++ = 0;
+	else
+		skin = model;		// no '/' is the same team either way
 
-	if ((int)(dmflags->value) & DF_MODELTEAMS)
+	ent->client->pers.model_team = TeamNumber (model);
+	ent->client->pers.skin_team = TeamNumber (skin);
+	if (ent->client->pers.model_team && ent->client->pers.skin_team)
+		return;
+
+	// out of room, so forget the names nobody uses any more
+	num_team_names = 0;
+	for (i=1 ; i<=game.maxclients ; i++)
 	{
-		*p = 0;
-		return value;
+		other = g_edicts + i;
+		if (other != ent && other->inuse && other->client)
+			ClientSetTeams (other, other->client->pers.userinfo);
 	}
-
-	// if ((int)(dmflags->value) & DF_SKINTEAMS)
-	return ++p;
+	ClientSetTeams (ent, userinfo);
 }
 
 qboolean OnSameTeam (edict_t *ent1, edict_t *ent2)
@@ -492,9 +530,11 @@ qboolean OnSameTeam (edict_t *ent1, edict_t *ent2)
 	if (!((int)(dmflags->value) & (DF_MODELTEAMS | DF_SKINTEAMS)))
 		return false;
 
-	if (strcmp(ClientTeam (ent1), ClientTeam (ent2)) == 0)
-		return true;
-	return false;
+	if ((int)(dmflags->value) & DF_MODELTEAMS)
+		return (ent1->client->pers.model_team == ent2->client->pers.model_team);
+
+	// if ((int)(dmflags->value) & DF_SKINTEAMS)
+	return (ent1->client->pers.skin_team == ent2->client->pers.skin_team);
 }
 
 
@@ -1138,7 +1178,7 @@ void Cmd_WeapPrev_f (edict_t *ent)
 			continue;
 		it = &itemlist[index];
 		// skip tryin to equip weapons that are empty
-		if (!g_select_empty->value && it->ammo && ent->client->pers.inventory[ITEM_INDEX(FindItem(it->ammo))] <= 0)
+		if (!g_select_empty->value && it->ammo && ent->client->pers.inventory[ItemAmmoIndex(it)] <= 0)
 			continue;
 		if (!it->use)
 			continue;
@@ -1190,7 +1230,7 @@ void Cmd_WeapNext_f (edict_t *ent)
 			continue;
 		it = &itemlist[index];
 		// skip tryin to equip weapons that are empty
-		if (!g_select_empty->value && it->ammo && ent->client->pers.inventory[ITEM_INDEX(FindItem(it->ammo))] <= 0)
+		if (!g_select_empty->value && it->ammo && ent->client->pers.inventory[ItemAmmoIndex(it)] <= 0)
 			continue;
 		if (!it->use)
 			continue;
@@ -1912,17 +1952,215 @@ void ForcewallOff(edict_t *player)
 	G_FreeEdict(tr.ent);
 }
 
+void Cmd_TechCount_f (edict_t *ent);
+
+/*
+=================
+Client command table
+
+ClientCommand used to find most commands by comparing the name with
+each one in turn, so the commands a client sends all the time (use,
+weapnext, invuse...) went through dozens of compares first. Commands
+that only call a function are now found in a hash table built by
+InitGame. Everything else (zoom, the developer commands, chat for
+anything unknown) is still matched by the chain in ClientCommand.
+=================
+*/
+#define	CMD_INTERMISSION	1		// also works during intermission
+#define	CMD_HASH			64		// must be a power of 2
+
+typedef struct clientcmd_s
+{
+	char				*name;
+	void				(*func) (edict_t *ent);
+	int					flags;
+	struct clientcmd_s	*next;		// in the same hash bucket
+} clientcmd_t;
+
+static void Cmd_SayAll_f (edict_t *ent)		{ Cmd_Say_f (ent, false, false); }
+static void Cmd_SayTeam_f (edict_t *ent)	{ Cmd_Say_f (ent, true, false); }
+static void Cmd_InvNext_f (edict_t *ent)	{ SelectNextItem (ent, -1); }
+static void Cmd_InvPrev_f (edict_t *ent)	{ SelectPrevItem (ent, -1); }
+static void Cmd_InvNextW_f (edict_t *ent)	{ SelectNextItem (ent, IT_WEAPON); }
+static void Cmd_InvPrevW_f (edict_t *ent)	{ SelectPrevItem (ent, IT_WEAPON); }
+static void Cmd_InvNextP_f (edict_t *ent)	{ SelectNextItem (ent, IT_POWERUP); }
+static void Cmd_InvPrevP_f (edict_t *ent)	{ SelectPrevItem (ent, IT_POWERUP); }
+static void Cmd_Commands_f (edict_t *ent);
+
+static void Cmd_PlayerListAny_f (edict_t *ent)
+{
+	if (ctf->value)
+		CTFPlayerList(ent);
+	else
+		Cmd_PlayerList_f(ent);
+}
+
+// Knightmare added
+static void Cmd_CTFMenu_f (edict_t *ent)
+{
+	if (!ctf->value)
+		return;
+	if (ent->client->menu)
+		PMenu_Close(ent);
+	else {
+		if (ttctf->value)
+			TTCTFOpenJoinMenu(ent);
+		else
+			CTFOpenJoinMenu(ent);
+	}
+}
+
+#ifdef FLASHLIGHT_MOD
+#if FLASHLIGHT_USE==POWERUP_USE_ITEM
+static void Cmd_Flashlight_f (edict_t *ent)		{ Use_Flashlight_f (ent, (gitem_t *)NULL); }
+#endif
+#endif
+
+// tpp
+static void Cmd_ThirdPerson_f (edict_t *ent)
+{
+	Cmd_Chasecam_Toggle (ent);
+	tpp->value = ent->client->chasetoggle;
+}
+
+static clientcmd_t	client_cmds[] =
+{
+	{"players",		Cmd_Players_f,		CMD_INTERMISSION},
+	{"say",			Cmd_SayAll_f,		CMD_INTERMISSION},
+	{"say_team",	Cmd_SayTeam_f,		CMD_INTERMISSION},
+	{"score",		Cmd_Score_f,		CMD_INTERMISSION},
+	{"help",		Cmd_Help_f,			CMD_INTERMISSION},
+	{"commands",	Cmd_Commands_f,		CMD_INTERMISSION},
+
+	{"use",			Cmd_Use_f},
+	{"drop",		Cmd_Drop_f},
+	{"give",		Cmd_Give_f},
+	{"god",			Cmd_God_f},
+	{"notarget",	Cmd_Notarget_f},
+	{"noclip",		Cmd_Noclip_f},
+	{"inven",		Cmd_Inven_f},
+	{"invnext",		Cmd_InvNext_f},
+	{"invprev",		Cmd_InvPrev_f},
+	{"invnextw",	Cmd_InvNextW_f},
+	{"invprevw",	Cmd_InvPrevW_f},
+	{"invnextp",	Cmd_InvNextP_f},
+	{"invprevp",	Cmd_InvPrevP_f},
+	{"invuse",		Cmd_InvUse_f},
+	{"invdrop",		Cmd_InvDrop_f},
+	{"weapprev",	Cmd_WeapPrev_f},
+	{"weapnext",	Cmd_WeapNext_f},
+	{"weaplast",	Cmd_WeapLast_f},
+	{"kill",		Cmd_Kill_f},
+	{"putaway",		Cmd_PutAway_f},
+	{"wave",		Cmd_Wave_f},
+	{"playerlist",	Cmd_PlayerListAny_f},
+//ZOID
+	{"team",		CTFTeam_f},
+	{"id",			CTFID_f},
+	{"yes",			CTFVoteYes},
+	{"no",			CTFVoteNo},
+	{"ready",		CTFReady},
+	{"notready",	CTFNotReady},
+	{"ghost",		CTFGhost},
+	{"admin",		CTFAdmin},
+	{"stats",		CTFStats},
+	{"warp",		CTFWarp},
+	{"boot",		CTFBoot},
+	{"observer",	CTFObserver},
+	{"ctfmenu",		Cmd_CTFMenu_f},
+	{"techcount",	Cmd_TechCount_f},
+//ZOID
+#ifdef FLASHLIGHT_MOD
+#if FLASHLIGHT_USE==POWERUP_USE_ITEM
+	{"flashlight",	Cmd_Flashlight_f},
+#endif
+#endif
+	{"thirdperson",	Cmd_ThirdPerson_f},
+	{NULL}
+};
+
+static clientcmd_t	*client_cmd_hash[CMD_HASH];
+
+static unsigned int ClientCommandHash (char *name)
+{
+	unsigned int	hash = 0;
+	int				c;
+
+	while (*name)
+	{
+		c = *name++;
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';		// commands are matched without case
+		hash = hash * 31 + c;
+	}
+	return hash & (CMD_HASH-1);
+}
+
+/*
+=================
+G_InitClientCommands
+
+Called from InitGame
+=================
+*/
+void G_InitClientCommands (void)
+{
+	clientcmd_t		*c;
+	unsigned int	h;
+
+	memset (client_cmd_hash, 0, sizeof(client_cmd_hash));
+	for (c=client_cmds ; c->name ; c++)
+	{
+		h = ClientCommandHash (c->name);
+		c->next = client_cmd_hash[h];
+		client_cmd_hash[h] = c;
+	}
+}
+
+static clientcmd_t *ClientCommandLookup (char *name)
+{
+	clientcmd_t	*c;
+
+	for (c=client_cmd_hash[ClientCommandHash(name)] ; c ; c=c->next)
+		if (!Q_strcasecmp (c->name, name))
+			return c;
+	return NULL;
+}
+
+static void Cmd_Commands_f (edict_t *ent)
+{
+	clientcmd_t	*c;
+	char		line[80];
+	int			len;
+
+	line[0] = 0;
+	len = 0;
+	for (c=client_cmds ; c->name ; c++)
+	{
+		if (len + strlen(c->name) + 1 >= sizeof(line) - 1)
+		{
+			safe_cprintf (ent, PRINT_HIGH, "%s\n", line);
+			line[0] = 0;
+			len = 0;
+		}
+		Com_sprintf (line + len, sizeof(line) - len, "%s ", c->name);
+		len = strlen(line);
+	}
+	if (len)
+		safe_cprintf (ent, PRINT_HIGH, "%s\n", line);
+}
+
 /*
 =================
 ClientCommand
 =================
 */
-void Cmd_TechCount_f (edict_t *ent);
 
 void ClientCommand (edict_t *ent)
 {
-	char	*cmd;
-	char	*parm;
+	char		*cmd;
+	char		*parm;
+	clientcmd_t	*c;
 
 	if (!ent->client)
 		return;		// not fully in game yet
@@ -1938,147 +2176,29 @@ void ClientCommand (edict_t *ent)
 	else
 		parm = gi.argv(1);
 
-	if (Q_strcasecmp (cmd, "players") == 0)
-	{
-		Cmd_Players_f (ent);
-		return;
-	}
-	if (Q_strcasecmp (cmd, "say") == 0)
-	{
-		Cmd_Say_f (ent, false, false);
-		return;
-	}
-	if (Q_strcasecmp (cmd, "say_team") == 0)
+	c = ClientCommandLookup (cmd);
+	if (c && (c->flags & CMD_INTERMISSION))
 	{
-		Cmd_Say_f (ent, true, false);
-		return;
-	}
-	if (Q_strcasecmp (cmd, "score") == 0)
-	{
-		Cmd_Score_f (ent);
-		return;
-	}
-	if (Q_strcasecmp (cmd, "help") == 0)
-	{
-		Cmd_Help_f (ent);
+		c->func (ent);
 		return;
 	}
 
 	if (level.intermissiontime)
 		return;
 
-	if (Q_strcasecmp (cmd, "use") == 0)
-		Cmd_Use_f (ent);
-	else if (Q_strcasecmp (cmd, "drop") == 0)
-		Cmd_Drop_f (ent);
-	else if (Q_strcasecmp (cmd, "give") == 0)
-		Cmd_Give_f (ent);
-	else if (Q_strcasecmp (cmd, "god") == 0)
-		Cmd_God_f (ent);
-	else if (Q_strcasecmp (cmd, "notarget") == 0)
-		Cmd_Notarget_f (ent);
-	else if (Q_strcasecmp (cmd, "noclip") == 0)
-		Cmd_Noclip_f (ent);
-	else if (Q_strcasecmp (cmd, "inven") == 0)
-		Cmd_Inven_f (ent);
-	else if (Q_strcasecmp (cmd, "invnext") == 0)
-		SelectNextItem (ent, -1);
-	else if (Q_strcasecmp (cmd, "invprev") == 0)
-		SelectPrevItem (ent, -1);
-	else if (Q_strcasecmp (cmd, "invnextw") == 0)
-		SelectNextItem (ent, IT_WEAPON);
-	else if (Q_strcasecmp (cmd, "invprevw") == 0)
-		SelectPrevItem (ent, IT_WEAPON);
-	else if (Q_strcasecmp (cmd, "invnextp") == 0)
-		SelectNextItem (ent, IT_POWERUP);
-	else if (Q_strcasecmp (cmd, "invprevp") == 0)
-		SelectPrevItem (ent, IT_POWERUP);
-	else if (Q_strcasecmp (cmd, "invuse") == 0)
-		Cmd_InvUse_f (ent);
-	else if (Q_strcasecmp (cmd, "invdrop") == 0)
-		Cmd_InvDrop_f (ent);
-	else if (Q_strcasecmp (cmd, "weapprev") == 0)
-		Cmd_WeapPrev_f (ent);
-	else if (Q_strcasecmp (cmd, "weapnext") == 0)
-		Cmd_WeapNext_f (ent);
-	else if (Q_strcasecmp (cmd, "weaplast") == 0)
-		Cmd_WeapLast_f (ent);
-	else if (Q_strcasecmp (cmd, "kill") == 0)
-		Cmd_Kill_f (ent);
-	else if (Q_strcasecmp (cmd, "putaway") == 0)
-		Cmd_PutAway_f (ent);
-	else if (Q_strcasecmp (cmd, "wave") == 0)
-		Cmd_Wave_f (ent);
-	else if (Q_strcasecmp(cmd, "playerlist") == 0)
-	{
-		if (ctf->value)
-			CTFPlayerList(ent);
-		else
-			Cmd_PlayerList_f(ent);
-	}
-//ZOID
-	else if (Q_strcasecmp (cmd, "team") == 0)
-		CTFTeam_f (ent);
-	else if (Q_strcasecmp(cmd, "id") == 0)
-		CTFID_f (ent);
-	else if (Q_strcasecmp(cmd, "yes") == 0)
-		CTFVoteYes(ent);
-	else if (Q_strcasecmp(cmd, "no") == 0)
-		CTFVoteNo(ent);
-	else if (Q_strcasecmp(cmd, "ready") == 0)
-		CTFReady(ent);
-	else if (Q_strcasecmp(cmd, "notready") == 0)
-		CTFNotReady(ent);
-	else if (Q_strcasecmp(cmd, "ghost") == 0)
-		CTFGhost(ent);
-	else if (Q_strcasecmp(cmd, "admin") == 0)
-		CTFAdmin(ent);
-	else if (Q_strcasecmp(cmd, "stats") == 0)
-		CTFStats(ent);
-	else if (Q_strcasecmp(cmd, "warp") == 0)
-		CTFWarp(ent);
-	else if (Q_strcasecmp(cmd, "boot") == 0)
-		CTFBoot(ent);
-	else if (Q_strcasecmp(cmd, "observer") == 0)
-		CTFObserver(ent);
-	// Knightmare added
-	else if (Q_strcasecmp(cmd, "ctfmenu") == 0)
-	{
-		if (!ctf->value)
-			return;
-		if (ent->client->menu)
-			PMenu_Close(ent);
-		else {
-			if (ttctf->value)
-				TTCTFOpenJoinMenu(ent);
-			else
-				CTFOpenJoinMenu(ent);
-		}
+	if (c)
+	{
+		c->func (ent);
+		return;
 	}
-	else if (Q_strcasecmp(cmd, "techcount") == 0)
-		Cmd_TechCount_f(ent);
-
-//ZOID
-#ifdef FLASHLIGHT_MOD
-#if FLASHLIGHT_USE==POWERUP_USE_ITEM
-	else if (Q_strcasecmp (cmd, "flashlight") == 0)
-		Use_Flashlight_f (ent, (gitem_t *)NULL);
-#endif
-#endif
 
 	// ==================== fog stuff =========================
-	else if (developer->value && !Q_strcasecmp(cmd,"fog"))
+	if (developer->value && !Q_strcasecmp(cmd,"fog"))
 		Cmd_Fog_f(ent);
 	else if (developer->value && !Q_strncasecmp(cmd, "fog_", 4))
 		Cmd_Fog_f(ent);
 	// ================ end fog stuff =========================
 
-	// tpp
-	else if (Q_strcasecmp (cmd, "thirdperson") == 0) {
-		Cmd_Chasecam_Toggle (ent);
-		tpp->value = ent->client->chasetoggle;
-	}
-
 	// alternate attack mode
 	/*else if (!Q_strcasecmp(cmd,"attack2_off"))
 		Cmd_attack2_f(ent,false);
@@ -2565,8 +2685,7 @@ void ClientCommand (edict_t *ent)
 				return;
 			}
 			e = G_Spawn();
-			e->classname = (char*)gi.TagMalloc(strlen(parm)+1,TAG_LEVEL);
-			strcpy(e->classname,parm);
+			e->classname = G_LevelString(parm);
 			AngleVectors(ent->client->v_angle,forward,NULL,NULL);
 			VectorMA(ent->s.origin,128,forward,e->s.origin);
 			e->s.angles[YAW] = ent->s.angles[YAW];
@@ -2583,8 +2702,7 @@ void ClientCommand (edict_t *ent)
 				return;
 			}
 			e = G_Spawn();
-			e->classname = (char*)gi.TagMalloc(12,TAG_LEVEL);
-			strcpy(e->classname,"misc_actor");
+			e->classname = G_LevelString("misc_actor");
 			e->usermodel = gi.argv(1);
 			e->sounds = atoi(gi.argv(2));
 			e->spawnflags = SF_MONSTER_GOODGUY;
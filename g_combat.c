@@ -47,12 +47,44 @@ CanDamage
 
 Returns true if the inflictor can directly damage the target.  Used for
 explosions and melee attacks.
+
+The target's origin and four corners 15 units out are tried in turn.
+A point outside the inflictor's PVS can't be reached by a trace, so
+when none of the five is in it there is nothing to trace. The PVS is
+only trusted when the inflictor isn't inside a solid, since a trace
+that starts in one can still get out. The corners are tried nearest
+the inflictor first, which is the one most likely to be seen.
+
+When the engine can batch traces, all five go to it at once instead,
+which costs less than stopping after the first that gets through.
 ============
 */
+static qboolean CanDamage_Trace (edict_t *targ, edict_t *inflictor, vec3_t dest, trace_t *trace)
+{
+	*trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
+	return (trace->fraction == 1.0 || trace->ent == targ);
+}
+
+// corner offsets, ordered by how far they are from the inflictor's side
+static const float candamage_corners[4][2] =
+{
+	{ 1,  1}, { 1, -1}, {-1,  1}, {-1, -1}
+};
+
 qboolean CanDamage (edict_t *targ, edict_t *inflictor)
 {
+	static edict_t	*solid_inflictor;
+	static int		solid_framenum = -1;
+	static vec3_t	solid_origin;
+	static qboolean	inflictor_in_solid;
 	vec3_t	dest;
+	vec3_t	points[5];
 	trace_t	trace;
+	trace_t	traces[5];
+	tracerequest_t	requests[5];
+	qboolean	batched;
+	float	sx, sy;
+	int		i;
 
 // bmodels need special checking because their origin is 0,0,0
 	if (targ->movetype == MOVETYPE_PUSH)
@@ -66,46 +98,68 @@ qboolean CanDamage (edict_t *targ, edict_t *inflictor)
 			return true;
 		return false;
 	}
-	
-	trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, targ->s.origin, inflictor, MASK_SOLID);
-	if (trace.fraction == 1.0 || trace.ent == targ)
-		return true;
-
-	// Lazarus: This is kinda cheesy, but avoids doing goofy things in a map to make this work. If a LOS
-	//          from inflictor to targ is blocked by a func_tracktrain, AND the targ is riding/driving
-	//          the tracktrain, go ahead and hurt him.
-
-	if(trace.ent && (trace.ent->flags & FL_TRACKTRAIN) && ((trace.ent->owner == targ) || (targ->groundentity == trace.ent)) )
-		return true;
-
-	VectorCopy (targ->s.origin, dest);
-	dest[0] += 15.0;
-	dest[1] += 15.0;
-	trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-	if (trace.fraction == 1.0 || trace.ent == targ)
-		return true;
-
-	VectorCopy (targ->s.origin, dest);
-	dest[0] += 15.0;
-	dest[1] -= 15.0;
-	trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-	if (trace.fraction == 1.0 || trace.ent == targ)
-		return true;
-
-	VectorCopy (targ->s.origin, dest);
-	dest[0] -= 15.0;
-	dest[1] += 15.0;
-	trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-	if (trace.fraction == 1.0 || trace.ent == targ)
-		return true;
-
-	VectorCopy (targ->s.origin, dest);
-	dest[0] -= 15.0;
-	dest[1] -= 15.0;
-	trace = gi.trace (inflictor->s.origin, vec3_origin, vec3_origin, dest, inflictor, MASK_SOLID);
-	if (trace.fraction == 1.0 || trace.ent == targ)
-		return true;
 
+	// nearest corner first
+	sx = (inflictor->s.origin[0] >= targ->s.origin[0]) ? 15.0 : -15.0;
+	sy = (inflictor->s.origin[1] >= targ->s.origin[1]) ? 15.0 : -15.0;
+	VectorCopy (targ->s.origin, points[0]);
+	for (i = 0; i < 4; i++)
+	{
+		VectorCopy (targ->s.origin, points[i+1]);
+		points[i+1][0] += sx * candamage_corners[i][0];
+		points[i+1][1] += sy * candamage_corners[i][1];
+	}
+
+	// T_RadiusDamage asks for every target of the same explosion in turn
+	if (inflictor != solid_inflictor || level.framenum != solid_framenum || !VectorCompare (inflictor->s.origin, solid_origin))
+	{
+		solid_inflictor = inflictor;
+		solid_framenum = level.framenum;
+		VectorCopy (inflictor->s.origin, solid_origin);
+		inflictor_in_solid = (gi.pointcontents (inflictor->s.origin) & MASK_SOLID) != 0;
+	}
+	if (!inflictor_in_solid)
+	{
+		for (i = 0; i < 5; i++)
+			if (gi.inPVS (inflictor->s.origin, points[i]))
+				break;
+		if (i == 5)
+			return false;
+	}
+
+	batched = G_TraceBatchAvailable ();
+	if (batched)
+	{
+		for (i = 0; i < 5; i++)
+		{
+			requests[i].start = inflictor->s.origin;
+			requests[i].mins = vec3_origin;
+			requests[i].maxs = vec3_origin;
+			requests[i].end = points[i];
+			requests[i].passent = inflictor;
+			requests[i].contentmask = MASK_SOLID;
+		}
+		G_TraceBatch (requests, traces, 5);
+	}
+
+	for (i = 0; i < 5; i++)
+	{
+		if (batched)
+		{
+			trace = traces[i];
+			if (trace.fraction == 1.0 || trace.ent == targ)
+				return true;
+		}
+		else if (CanDamage_Trace (targ, inflictor, points[i], &trace))
+			return true;
+
+		// Lazarus: This is kinda cheesy, but avoids doing goofy things in a map to make this work. If a LOS
+		//          from inflictor to targ is blocked by a func_tracktrain, AND the targ is riding/driving
+		//          the tracktrain, go ahead and hurt him.
+
+		if(i == 0 && trace.ent && (trace.ent->flags & FL_TRACKTRAIN) && ((trace.ent->owner == targ) || (targ->groundentity == trace.ent)) )
+			return true;
+	}
 
 	return false;
 }
@@ -197,11 +251,7 @@ added color for monster blood
 */
 void SpawnDamage (int type, vec3_t origin, vec3_t normal)
 {
-	gi.WriteByte (svc_temp_entity);
-	gi.WriteByte (type);
-	gi.WritePosition (origin);
-	gi.WriteDir (normal);
-	gi.multicast (origin, MULTICAST_PVS);
+	G_TempImpact (type, origin, normal);
 
 	if(level.num_reflectors)
 		ReflectSparks(type,origin,normal);
@@ -377,6 +427,50 @@ void DefendMyFriend (edict_t *self, edict_t *enemy)
 	FoundTarget (self);
 }
 
+/*
+============
+SquadAlreadyCalled
+
+True if the dmgteam has already been called on attacker this frame, so a
+shotgun blast or a rocket's splash calls a squad once and not once per
+pellet or victim. Otherwise remembers the call and returns false.
+============
+*/
+#define	MAX_SQUAD_CALLS	32
+
+static struct
+{
+	char	*dmgteam;
+	edict_t	*attacker;
+} squad_calls[MAX_SQUAD_CALLS];
+static int	num_squad_calls;
+static int	squad_callframe = -1;
+
+static qboolean SquadAlreadyCalled (char *dmgteam, edict_t *attacker)
+{
+	int		i;
+
+	if (squad_callframe != level.framenum)
+	{
+		squad_callframe = level.framenum;
+		num_squad_calls = 0;
+	}
+
+	for (i = 0; i < num_squad_calls; i++)
+	{
+		if (squad_calls[i].attacker == attacker && !Q_strcasecmp(squad_calls[i].dmgteam, dmgteam))
+			return true;
+	}
+
+	if (num_squad_calls < MAX_SQUAD_CALLS)
+	{
+		squad_calls[num_squad_calls].dmgteam = dmgteam;
+		squad_calls[num_squad_calls].attacker = attacker;
+		num_squad_calls++;
+	}
+	return false;
+}
+
 void CallMyFriends (edict_t *targ, edict_t *attacker)
 {
 	edict_t	*teammate;
@@ -417,7 +511,11 @@ void CallMyFriends (edict_t *targ, edict_t *attacker)
 					// Either target is not a monster, or attacker is not a monster, or
 					// they're both monsters but one is AI_GOOD_GUY and the other is not,
 					// or we've turned the game into a free-for-all with a target_monsterbattle
-					teammate = G_Find(NULL,FOFS(dmgteam),targ->dmgteam);
+					// Teammates come from the dmgteam index (see G_Find).
+					if(SquadAlreadyCalled(targ->dmgteam,attacker))
+						teammate = NULL;
+					else
+						teammate = G_Find(NULL,FOFS(dmgteam),targ->dmgteam);
 					while(teammate)
 					{
 						if(teammate != targ)
@@ -786,7 +884,111 @@ qboolean CheckTeamDamage (edict_t *targ, edict_t *attacker)
 	return false;
 }
 
+static void ApplyDamage (edict_t *in_targ, edict_t *inflictor, edict_t *in_attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod);
+
+/*
+============
+T_DamageBatchBegin / T_DamageBatchEnd
+
+Between these, T_Damage only adds each hit up, per target, inflictor,
+attacker, dflags and means of death. T_DamageBatchEnd then applies each
+sum as one hit, at the point and normal of the first one, so a burst of
+pellets or bullets runs pain, blood, death and the friend calls once
+per target instead of once per hit. Nothing between the two calls may
+depend on a hit having been applied already.
+
+Batches nest; the outermost T_DamageBatchEnd applies them. Damage done
+while applying (e.g. an exploding barrel) is applied at once.
+============
+*/
+#define MAX_DAMAGE_BATCH	32
+
+typedef struct
+{
+	edict_t		*targ;
+	edict_t		*inflictor;
+	edict_t		*attacker;
+	vec3_t		dir;
+	vec3_t		point;
+	vec3_t		normal;
+	int			damage;
+	int			knockback;
+	int			dflags;
+	int			mod;
+} damagebatch_t;
+
+static damagebatch_t	damage_batch[MAX_DAMAGE_BATCH];
+static int				damage_batch_count;
+static int				damage_batch_depth;
+
+void T_DamageBatchBegin (void)
+{
+	damage_batch_depth++;
+}
+
+void T_DamageBatchEnd (void)
+{
+	damagebatch_t	batch[MAX_DAMAGE_BATCH];
+	damagebatch_t	*hit;
+	int				i, count;
+
+	if (damage_batch_depth <= 0 || --damage_batch_depth > 0)
+		return;
+
+	// copy them out first, the damage may start another batch
+	count = damage_batch_count;
+	memcpy (batch, damage_batch, count * sizeof(damagebatch_t));
+	damage_batch_count = 0;
+
+	for (i = 0, hit = batch; i < count; i++, hit++)
+		T_Damage (hit->targ, hit->inflictor, hit->attacker, hit->dir, hit->point, hit->normal, hit->damage, hit->knockback, hit->dflags, hit->mod);
+}
+
+static qboolean T_DamageBatchAdd (edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod)
+{
+	damagebatch_t	*hit;
+	int				i;
+
+	for (i = 0, hit = damage_batch; i < damage_batch_count; i++, hit++)
+	{
+		if (hit->targ == targ && hit->inflictor == inflictor && hit->attacker == attacker
+			&& hit->dflags == dflags && hit->mod == mod)
+		{
+			hit->damage += damage;
+			hit->knockback += knockback;
+			return true;
+		}
+	}
+
+	if (damage_batch_count == MAX_DAMAGE_BATCH)
+		return false;	// full, apply this one now
+
+	hit = &damage_batch[damage_batch_count++];
+	hit->targ = targ;
+	hit->inflictor = inflictor;
+	hit->attacker = attacker;
+	VectorCopy (dir, hit->dir);
+	VectorCopy (point, hit->point);
+	VectorCopy (normal, hit->normal);
+	hit->damage = damage;
+	hit->knockback = knockback;
+	hit->dflags = dflags;
+	hit->mod = mod;
+	return true;
+}
+
 void T_Damage (edict_t *in_targ, edict_t *inflictor, edict_t *in_attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod)
+{
+	if (damage_batch_depth > 0 && in_targ && in_targ->inuse && in_targ->takedamage
+		&& T_DamageBatchAdd (in_targ, inflictor, in_attacker, dir, point, normal, damage, knockback, dflags, mod))
+		return;
+
+	Prof_Begin (PROF_DAMAGE);
+	ApplyDamage (in_targ, inflictor, in_attacker, dir, point, normal, damage, knockback, dflags, mod);
+	Prof_End (PROF_DAMAGE);
+}
+
+static void ApplyDamage (edict_t *in_targ, edict_t *inflictor, edict_t *in_attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod)
 {
 	gclient_t	*client;
 	int			take;
@@ -1163,12 +1365,19 @@ Lazarus adds dmg_slope to alter the radius damage equation. (Standard Q2 = -0.5)
 void T_RadiusDamage (edict_t *inflictor, edict_t *attacker, float damage, edict_t *ignore, float radius, int mod, double dmg_slope)
 {
 	float	points;
-	edict_t	*ent = NULL;
+	edict_t	*ent;
+	edict_t	*list[MAX_EDICTS];
+	int		i, num;
 	vec3_t	v;
 	vec3_t	dir;
 
-	while ((ent = findradius(ent, inflictor->s.origin, radius)) != NULL)
+	num = G_FindRadiusBatch (inflictor->s.origin, radius, list, MAX_EDICTS);
+	for (i=0 ; i<num ; i++)
 	{
+		ent = list[i];
+		// earlier damage may have removed it
+		if (!ent->inuse)
+			continue;
 		if (ent == ignore)
 			continue;
 		if (!ent->takedamage)
@@ -38,7 +38,111 @@ void box_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf
 qboolean box_movestep (edict_t *ent, vec3_t move, qboolean relink);
 void Crane_Move_Begin (edict_t *);
 
+/*
+==============================================================================
+
+ATTACHED SOUNDS
+
+A train, crane or tracktrain with a looping sound gets a moving_speaker
+at its center, since a brush model's origin is usually nowhere near it.
+Speakers used to think every frame just to follow their owner. Now they
+sit in a list that G_UpdateAttachedSounds walks once a frame, after
+every entity has moved, so they cost no think, and gi.linkentity skips
+the ones whose owner stood still.
+
+The list is rebuilt with one scan for moving_speakers after a map or a
+saved game loads.
+
+==============================================================================
+*/
+
+static int		*attached_sounds;		// edict numbers
+static byte		*attached_flags;		// per edict, true when in the list
+static int		num_attached_sounds;
+static qboolean	attached_dirty = true;
+
+static qboolean G_IsSpeaker (edict_t *e)
+{
+	return e->inuse && e->classname && !strcmp(e->classname, "moving_speaker");
+}
+
+static void G_AddAttachedSound (int num)
+{
+	if (attached_flags[num])
+		return;
+	attached_flags[num] = true;
+	attached_sounds[num_attached_sounds++] = num;
+}
+
+static void G_RebuildAttachedSounds (void)
+{
+	int		i;
+
+	if (!attached_sounds)
+	{
+		attached_sounds = gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+		attached_flags = gi.TagMalloc (game.maxentities, TAG_GAME);
+	}
+	else
+		memset (attached_flags, 0, game.maxentities);
+	num_attached_sounds = 0;
+
+	for (i=maxclients->value+1 ; i<globals.num_edicts ; i++)
+		if (G_IsSpeaker (g_edicts + i))
+			G_AddAttachedSound (i);
+	attached_dirty = false;
+}
+
+/*
+=================
+G_InitAttachedSounds
+
+Called from InitGame. G_RebuildAttachedSounds makes a new list.
+=================
+*/
+void G_InitAttachedSounds (void)
+{
+	attached_sounds = NULL;
+	attached_flags = NULL;
+	num_attached_sounds = 0;
+	attached_dirty = true;
+}
+
+/*
+=================
+G_ResetAttachedSounds
+
+Called by SpawnEntities and ReadLevel
+=================
+*/
+void G_ResetAttachedSounds (void)
+{
+	attached_dirty = true;
+}
+
+/*
+=================
+G_AttachSpeaker
+
+Makes a moving_speaker follow its owner, keeping speaker->offset from it
+=================
+*/
+void G_AttachSpeaker (edict_t *speaker)
+{
+	speaker->think = NULL;
+	speaker->nextthink = 0;
+	if (!attached_dirty)
+		G_AddAttachedSound (speaker - g_edicts);
+}
+
+// Older saved games have their speakers thinking this
 void Moving_Speaker_Think(edict_t *speaker)
+{
+	G_AttachSpeaker (speaker);
+}
+
+// false when the owner is gone and the speaker was freed
+static qboolean Moving_Speaker_Follow(edict_t *speaker)
 {
 	qboolean moved;
 	vec3_t  offset;
@@ -48,12 +152,12 @@ void Moving_Speaker_Think(edict_t *speaker)
 	if(!owner)
 	{
 		G_FreeEdict(speaker);
-		return;
+		return false;
 	}
 	if(!owner->inuse)
 	{
 		G_FreeEdict(speaker);
-		return;
+		return false;
 	}
 	if(speaker->spawnflags & 15)
 	{
@@ -92,37 +196,95 @@ void Moving_Speaker_Think(edict_t *speaker)
 	}
 
 	VectorAdd(owner->s.origin,speaker->offset,speaker->s.origin);
-	speaker->nextthink = level.time + FRAMETIME;
 	gi.linkentity(speaker);
+	return true;
 }
 
-edict_t *CrateOnTop (edict_t *from, edict_t *ent)
+/*
+=================
+G_UpdateAttachedSounds
+
+Called by G_RunFrame once every entity has run
+=================
+*/
+void G_UpdateAttachedSounds (void)
 {
-	float maxdist;
+	edict_t	*speaker;
+	int		i, num;
 
-	if (!from)
-		from = g_edicts;
-	else
-		from++;
+	if (attached_dirty)
+		G_RebuildAttachedSounds ();
+
+	for (i=0 ; i<num_attached_sounds ; )
+	{
+		num = attached_sounds[i];
+		speaker = g_edicts + num;
+		if (!G_IsSpeaker (speaker) || !Moving_Speaker_Follow (speaker))
+		{
+			attached_flags[num] = false;
+			attached_sounds[i] = attached_sounds[--num_attached_sounds];
+			continue;
+		}
+		i++;
+	}
+}
+
+/*
+=================
+CrateOnTop
+
+Returns the next func_pushable after from (in edict order) resting on
+ent. box_touch asks this every frame a player leans on a crate, so
+rather than sweep every edict, only the solid edicts in a slab just
+over ent's top come from the area tree.
+=================
+*/
+#define	MAX_CRATES_ON_TOP	64
+
+static int CrateOrder (const void *a, const void *b)
+{
+	return (int)(*(edict_t **)a - *(edict_t **)b);
+}
 
-	for ( ; from < &g_edicts[globals.num_edicts] ; from++)
+edict_t *CrateOnTop (edict_t *from, edict_t *ent)
+{
+	edict_t	*list[MAX_CRATES_ON_TOP];
+	edict_t	*best = NULL;
+	edict_t	*e;
+	vec3_t	mins, maxs;
+	float	maxdist;
+	int		i, num;
+
+	maxdist = VectorLength(ent->velocity)*FRAMETIME + 2.0;
+	VectorCopy(ent->absmin,mins);
+	VectorCopy(ent->absmax,maxs);
+	mins[2] = ent->absmax[2] - maxdist;
+	maxs[2] = ent->absmax[2] + maxdist;
+	num = gi.BoxEdicts (mins, maxs, list, MAX_CRATES_ON_TOP, AREA_SOLID);
+	if (num > 1)
+		qsort (list, num, sizeof(list[0]), CrateOrder);
+
+	for (i=0 ; i<num ; i++)
 	{
-		if (from == ent)
+		e = list[i];
+		if (from && e <= from)
 			continue;
-		if (!from->inuse)
+		if (e == ent)
+			continue;
+		if (!e->inuse)
 			continue;
-		if (from->movetype != MOVETYPE_PUSHABLE)
+		if (e->movetype != MOVETYPE_PUSHABLE)
 			continue;
-		if (from->absmin[0] >=  ent->absmax[0]) continue;
-		if (from->absmax[0] <=  ent->absmin[0]) continue;
-		if (from->absmin[1] >=  ent->absmax[1]) continue;
-		if (from->absmax[1] <=  ent->absmin[1]) continue;
-		maxdist = VectorLength(ent->velocity)*FRAMETIME + 2.0;
-		if (fabs(from->absmin[2] - ent->absmax[2]) > maxdist) continue;
-		return from;
+		if (e->absmin[0] >=  ent->absmax[0]) continue;
+		if (e->absmax[0] <=  ent->absmin[0]) continue;
+		if (e->absmin[1] >=  ent->absmax[1]) continue;
+		if (e->absmax[1] <=  ent->absmin[1]) continue;
+		if (fabs(e->absmin[2] - ent->absmax[2]) > maxdist) continue;
+		best = e;
+		break;
 	}
 
-	return NULL;
+	return best;
 }
 
 void Cargo_Stop (edict_t *ent)
@@ -204,8 +366,13 @@ void SetSpotlightLength(edict_t *hook)
 void Cable_Think(edict_t *cable)
 {
 	SetCableLength(cable);
-	cable->nextthink = level.time + FRAMETIME;
 	gi.linkentity(cable);
+	// Lazarus: the length only changes while the hook goes up or down.
+	// Crane_Move_Done sets it one last time, and the next vertical move
+	// starts us again.
+	if(VectorCompare(cable->crane_hook->velocity,vec3_origin))
+		return;
+	cable->nextthink = level.time + FRAMETIME;
 }
 
 void crane_light_off(edict_t *light)
@@ -1409,10 +1576,9 @@ void SP_crane_hook (edict_t *self)
 		speaker->volume      = 1;
 		speaker->attenuation = self->attenuation; // was 1
 		speaker->owner       = self;
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 0;       // plays constantly
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		VectorAdd(self->absmin,self->absmax,speaker->s.origin);
 		VectorScale(speaker->s.origin,0.5,speaker->s.origin);
 		VectorSubtract(speaker->s.origin,self->s.origin,speaker->offset);
@@ -1467,10 +1633,9 @@ void SP_crane_hoist (edict_t *self)
 		speaker->volume      = 1;
 		speaker->attenuation = self->attenuation; // was 1
 		speaker->owner       = self;
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 7;       // owner must be moving to play
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		VectorAdd(self->absmin,self->absmax,speaker->s.origin);
 		VectorScale(speaker->s.origin,0.5,speaker->s.origin);
 		VectorSubtract(speaker->s.origin,self->s.origin,speaker->offset);
@@ -1530,12 +1695,11 @@ void SP_crane_beam (edict_t *self)
 		speaker->s.sound     = 0;
 		speaker->volume      = 1;
 		speaker->attenuation = self->attenuation; // was 1
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 7;       // owner must be moving to play
 		speaker->owner       = self;    // this will be changed later when we know
 		                                // controls are spawned
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		VectorAdd(self->absmin,self->absmax,speaker->s.origin);
 		VectorScale(speaker->s.origin,0.5,speaker->s.origin);
 		VectorSubtract(speaker->s.origin,self->s.origin,speaker->offset);
@@ -78,6 +78,7 @@ cvar_t *electpercentage;
 cvar_t *matchtime;
 cvar_t *matchsetuptime;
 cvar_t *matchstarttime;
+cvar_t *matchreset;
 cvar_t *admin_password;
 cvar_t *allow_admin;
 cvar_t *warp_list;
@@ -411,6 +412,159 @@ static char *tnames[] = {
 	NULL
 };
 
+static gitem_t *ctf_techitems[TECHTYPES];	// tnames[] looked up once in CTFInit
+
+/*
+==============================================================================
+
+TECH ACCOUNTING
+
+CheckNumTechs runs every frame, so the techs in circulation are counted
+as they come and go rather than by walking every edict and inventory.
+techs_loose counts item_tech edicts in the map, those hidden waiting to
+respawn included, which is what TechCount used to count. techs_held
+counts the techs in clients' inventories, with a bit per client slot
+so a client is never counted twice.
+
+SpawnTech, SpawnItem and Drop_Item add loose techs, G_FreeEdict removes
+them. CTFPickup_Tech, CTFDrop_Tech, CTFDeadDropTech and
+InitClientPersistant keep the held ones. CTFCountTechs counts afresh
+once a level is spawned or loaded.
+
+==============================================================================
+*/
+
+static int	techs_loose[TECHTYPES];
+static int	techs_held[TECHTYPES];
+static int	techs_held_by[MAX_CLIENTS];		// bit per tech type
+static int	techs_changed;					// bumped by every change to the above
+static int	techs_icon[TECHTYPES];			// imageindex, 0 until first shown
+
+static int CTFTechIndex (gitem_t *item)
+{
+	int		i;
+
+	for (i = 0; i < TECHTYPES; i++)
+		if (ctf_techitems[i] == item)
+			return i;
+	return -1;
+}
+
+static qboolean CTFIsTechEnt (edict_t *ent)
+{
+	if (!ent->item || !(ent->item->flags & IT_TECH) || !ent->classname)
+		return false;
+	// monsters and triggers hold the item they drop or need in ent->item
+	return !strcmp(ent->classname, ent->item->classname);
+}
+
+static void CTFSetTechHeld (int slot, int index, qboolean held)
+{
+	int		bit;
+
+	if (slot < 0 || slot >= MAX_CLIENTS || index < 0)
+		return;
+	bit = 1 << index;
+	if (held && !(techs_held_by[slot] & bit))
+	{
+		techs_held_by[slot] |= bit;
+		techs_held[index]++;
+		techs_changed++;
+	}
+	else if (!held && (techs_held_by[slot] & bit))
+	{
+		techs_held_by[slot] &= ~bit;
+		techs_held[index]--;
+		techs_changed++;
+	}
+}
+
+/*
+=================
+CTFTechAdded
+
+Called for each item_tech edict that enters the map
+=================
+*/
+void CTFTechAdded (edict_t *ent)
+{
+	int		index;
+
+	if (!CTFIsTechEnt(ent) || (index = CTFTechIndex(ent->item)) < 0)
+		return;
+	techs_loose[index]++;
+	techs_changed++;
+}
+
+/*
+=================
+CTFTechRemoved
+
+Called from G_FreeEdict
+=================
+*/
+void CTFTechRemoved (edict_t *ent)
+{
+	int		index;
+
+	if (!CTFIsTechEnt(ent) || (index = CTFTechIndex(ent->item)) < 0)
+		return;
+	if (techs_loose[index] > 0)
+		techs_loose[index]--;
+	techs_changed++;
+}
+
+/*
+=================
+CTFForgetTechs
+
+Called from InitClientPersistant, before the inventory is cleared
+=================
+*/
+void CTFForgetTechs (gclient_t *client)
+{
+	int		i;
+
+	for (i = 0; i < TECHTYPES; i++)
+		CTFSetTechHeld (client - game.clients, i, false);
+}
+
+/*
+=================
+CTFCountTechs
+
+Called from SpawnEntities and ReadLevel
+=================
+*/
+void CTFCountTechs (void)
+{
+	edict_t	*ent;
+	int		i, j;
+
+	memset (techs_loose, 0, sizeof(techs_loose));
+	memset (techs_held, 0, sizeof(techs_held));
+	memset (techs_held_by, 0, sizeof(techs_held_by));
+	memset (techs_icon, 0, sizeof(techs_icon));
+	techs_changed++;
+
+	for (i = game.maxclients+1, ent = g_edicts+i; i < globals.num_edicts; i++, ent++)
+	{
+		if (ent->inuse)
+			CTFTechAdded (ent);
+	}
+	for (i = 0; i < game.maxclients; i++)
+	{
+		ent = g_edicts + 1 + i;
+		if (!ent->inuse || !ent->client)
+			continue;
+		for (j = 0; j < TECHTYPES; j++)
+		{
+			if (ctf_techitems[j] && ent->client->pers.inventory[ITEM_INDEX(ctf_techitems[j])])
+				CTFSetTechHeld (i, j, true);
+		}
+	}
+}
+
 /*void stuffcmd(edict_t *ent, char *s) 	
 {
    	gi.WriteByte (11);	        
@@ -519,6 +673,7 @@ void CTFSpawn(void)
 	if (!flag3_item)
 		flag3_item = FindItemByClassname("item_flag_team3");
 	memset(&ctfgame, 0, sizeof(ctfgame));
+	CTFResetLocations();
 	CTFSetupTechSpawn();
 
 	if (competition->value > 1) {
@@ -529,6 +684,8 @@ void CTFSpawn(void)
 
 void CTFInit(void)
 {
+	int		i;
+
 	ctf = gi.cvar("ctf", "0", CVAR_SERVERINFO|CVAR_LATCH);
 	ttctf = gi.cvar("ttctf", "0", CVAR_SERVERINFO|CVAR_LATCH); // Knightmare added
 	ctf_forcejoin = gi.cvar("ctf_forcejoin", "", 0);
@@ -538,10 +695,14 @@ void CTFInit(void)
 	matchtime = gi.cvar("matchtime", "20", CVAR_SERVERINFO);
 	matchsetuptime = gi.cvar("matchsetuptime", "10", 0);
 	matchstarttime = gi.cvar("matchstarttime", "20", 0);
+	matchreset = gi.cvar("matchreset", "0", 0);
 	admin_password = gi.cvar("admin_password", "", 0);
 	allow_admin = gi.cvar("allow_admin", "1", 0);
 	warp_list = gi.cvar("warp_list", "q2ctf1 q2ctf2 q2ctf3 q2ctf4 q2ctf5", 0);
 	warn_unbalanced = gi.cvar("warn_unbalanced", "1", 0);
+
+	for (i = 0; tnames[i]; i++)
+		ctf_techitems[i] = FindItemByClassname(tnames[i]);
 }
 
 /*
@@ -683,7 +844,6 @@ int CTFOtherTeam2(int team)
 
 edict_t *SelectRandomDeathmatchSpawnPoint (void);
 edict_t *SelectFarthestDeathmatchSpawnPoint (void);
-float	PlayersRangeFromSpot (edict_t *spot);
 
 void CTFAssignSkin(edict_t *ent, char *s)
 {
@@ -794,11 +954,12 @@ to other players
 */
 edict_t *SelectCTFSpawnPoint (edict_t *ent)
 {
-	edict_t	*spot, *spot1, *spot2;
-	int		count = 0;
+	edict_t	**spots;
+	float	*ranges;
+	int		i, spot1, spot2;
+	int		count;
 	int		selection;
-	float	range, range1, range2;
-	char	*cname;
+	float	range1, range2;
 
     if (ent->client->resp.ctf_state) {
         if ( (int)(dmflags->value) & DF_SPAWN_FARTHEST) {
@@ -812,35 +973,28 @@ edict_t *SelectCTFSpawnPoint (edict_t *ent)
 
 	switch (ent->client->resp.ctf_team) {
 	case CTF_TEAM1:
-		cname = "info_player_team1";
-		break;
 	case CTF_TEAM2:
-		cname = "info_player_team2";
-		break;
 	case CTF_TEAM3: // Knightmare added
-		cname = "info_player_team3";
 		break;
 	default:
 		return SelectRandomDeathmatchSpawnPoint();
 	}
 
-	spot = NULL;
 	range1 = range2 = 99999;
-	spot1 = spot2 = NULL;
+	spot1 = spot2 = -1;
 
-	while ((spot = G_Find (spot, FOFS(classname), cname)) != NULL)
+	count = G_SpawnSpots (ent->client->resp.ctf_team, &spots, &ranges);
+	for (i = 0; i < count; i++)
 	{
-		count++;
-		range = PlayersRangeFromSpot(spot);
-		if (range < range1)
+		if (ranges[i] < range1)
 		{
-			range1 = range;
-			spot1 = spot;
+			range1 = ranges[i];
+			spot1 = i;
 		}
-		else if (range < range2)
+		else if (ranges[i] < range2)
 		{
-			range2 = range;
-			spot2 = spot;
+			range2 = ranges[i];
+			spot2 = i;
 		}
 	}
 
@@ -849,22 +1003,23 @@ edict_t *SelectCTFSpawnPoint (edict_t *ent)
 
 	if (count <= 2)
 	{
-		spot1 = spot2 = NULL;
+		spot1 = spot2 = -1;
 	}
 	else
 		count -= 2;
 
 	selection = rand() % count;
 
-	spot = NULL;
-	do
+	for (i = 0; ; i++)
 	{
-		spot = G_Find (spot, FOFS(classname), cname);
-		if (spot == spot1 || spot == spot2)
-			selection++;
-	} while(selection--);
+		if (i == spot1 || i == spot2)
+			continue;
+		if (!selection--)
+			break;
+	}
 
-	return spot;
+	G_SpawnSpotTaken (spots[i]);
+	return spots[i];
 }
 
 /*------------------------------------------------------------------------*/
@@ -1095,6 +1250,7 @@ void CTFResetFlag(int ctf_team)
 		return;
 	}
 
+	CTFFlagsChanged ();
 	ent = NULL;
 	while ((ent = G_Find (ent, FOFS(classname), c)) != NULL) {
 		if (ent->spawnflags & DROPPED_ITEM)
@@ -1134,6 +1290,7 @@ qboolean CTFPickup_Flag(edict_t *ent, edict_t *other)
 		safe_cprintf(ent, PRINT_HIGH, "Don't know what team the flag is on.\n");
 		return false;
 	}
+	CTFFlagsChanged ();
 
 	// same team, if the flag at base, check to he has the enemy flag
 	if (ctf_team == CTF_TEAM1) {
@@ -1424,6 +1581,7 @@ void CTFDeadDropFlag(edict_t *self)
 
 	if (!ctf->value)
 		return;
+	CTFFlagsChanged ();
 
 	if (self->client->pers.inventory[ITEM_INDEX(flag1_item)])
 	{
@@ -1479,6 +1637,7 @@ qboolean CTFDrop_Flag(edict_t *ent, gitem_t *item)
 	}
 	else
 	{
+		CTFFlagsChanged ();
 		if (ent->client->pers.inventory[ITEM_INDEX(flag1_item)]) 
 		{
 			dropped = Drop_Item(ent, flag1_item);
@@ -1588,6 +1747,7 @@ void CTFFlagSetup (edict_t *ent)
 	VectorCopy (tr.endpos, ent->s.origin);
 
 	gi.linkentity (ent);
+	CTFFlagsChanged ();
 
 	ent->nextthink = level.time + FRAMETIME;
 	ent->think = CTFFlagThink;
@@ -1687,7 +1847,11 @@ void CTFSetIDView(edict_t *ent)
 	trace_t	tr;
 	edict_t	*who, *best;
 	float	bd = 0, d;
-	int i;
+	int i, k, count;
+	struct {
+		float	d;
+		edict_t	*who;
+	} cone[MAX_CLIENTS];
 
 	// only check every few frames
 	if (level.time - ent->client->resp.lastidtime < 0.25)
@@ -1713,8 +1877,13 @@ void CTFSetIDView(edict_t *ent)
 		return;
 	}
 
+	// Only a player within the 0.90 cone can be picked, and the pick is
+	// the visible one nearest the crosshair. Rank the players in the
+	// cone first so loc_CanSee's traces stop at the first visible one,
+	// instead of running for every better candidate found in edict order.
 	AngleVectors(ent->client->v_angle, forward, NULL, NULL);
 	best = NULL;
+	count = 0;
 	for (i = 1; i <= maxclients->value; i++) {
 		who = g_edicts + i;
 		if (!who->inuse || who->solid == SOLID_NOT)
@@ -1722,9 +1891,22 @@ void CTFSetIDView(edict_t *ent)
 		VectorSubtract(who->s.origin, ent->s.origin, dir);
 		VectorNormalize(dir);
 		d = DotProduct(forward, dir);
-		if (d > bd && loc_CanSee(ent, who)) {
-			bd = d;
-			best = who;
+		if (d <= 0.90)
+			continue;
+		// insertion sort, highest first; equal values keep edict order
+		for (k = count; k > 0 && cone[k-1].d < d; k--)
+			cone[k] = cone[k-1];
+		cone[k].d = d;
+		cone[k].who = who;
+		count++;
+	}
+	// a clear line between the eyes, shared with the bots' own checks
+	// through the sight cache, saves the box corner traces
+	for (k = 0; k < count; k++) {
+		if ((cone[k].who->client && AI_CachedVisible(cone[k].who, ent)) || loc_CanSee(ent, cone[k].who)) {
+			bd = cone[k].d;
+			best = cone[k].who;
+			break;
 		}
 	}
 	if (bd > 0.90) {
@@ -1739,12 +1921,83 @@ void CTFSetIDView(edict_t *ent)
 	}
 }
 
+/*
+=================
+CTFUpdateFlagPics
+
+Works out the team logo of each flag for SetCTFStats:
+  flag at base
+  flag taken
+  flag dropped
+These don't depend on the viewer, and only change when a flag is
+picked up, dropped, returned or captured, each of which calls
+CTFFlagsChanged. They are worked out again on the next call after
+that instead of every frame. ClientEndServerFrames calls this before
+the stats of any client are set, since flags may have changed hands
+after a client set its stats earlier in the same frame.
+=================
+*/
+static struct
+{
+	qboolean	valid;
+	int			p1, p2, p3;
+} ctf_flagpics;
+
+/*
+=================
+CTFFlagsChanged
+
+Called wherever a flag changes hands, and when a level is spawned or
+loaded
+=================
+*/
+void CTFFlagsChanged (void)
+{
+	ctf_flagpics.valid = false;
+}
+
+static int CTFFlagPic (char *classname, gitem_t *flag, int home, int taken, int dropped)
+{
+	edict_t	*e;
+	int		i;
+
+	e = G_Find(NULL, FOFS(classname), classname);
+	if (e == NULL)
+		return home;
+
+	if (e->solid == SOLID_NOT) {
+		// not at base
+		// check if on player
+		for (i = 1; i <= maxclients->value; i++)
+			if (g_edicts[i].inuse &&
+				g_edicts[i].client->pers.inventory[ITEM_INDEX(flag)])
+				return taken; // enemy has it
+		return dropped; // default to dropped
+	}
+	if (e->spawnflags & DROPPED_ITEM)
+		return dropped; // must be dropped
+	return home;
+}
+
+void CTFUpdateFlagPics (void)
+{
+	if (ctf_flagpics.valid)
+		return;
+	ctf_flagpics.valid = true;
+	ctf_flagpics.p1 = CTFFlagPic("item_flag_team1", flag1_item, imageindex_i_ctf1, imageindex_i_ctf1t, imageindex_i_ctf1d);
+	ctf_flagpics.p2 = CTFFlagPic("item_flag_team2", flag2_item, imageindex_i_ctf2, imageindex_i_ctf2t, imageindex_i_ctf2d);
+	// Knightmare added
+	if (ttctf->value)
+		ctf_flagpics.p3 = CTFFlagPic("item_flag_team3", flag3_item, imageindex_i_ctf3, imageindex_i_ctf3t, imageindex_i_ctf3d);
+	else
+		ctf_flagpics.p3 = imageindex_i_ctf3;
+}
+
 void SetCTFStats(edict_t *ent)
 {
 	gitem_t *tech;
-	int i;
+	int i, slot;
 	int p1, p2, p3;
-	edict_t *e;
 
 	if (!ctf->value)
 		return;
@@ -1814,89 +2067,30 @@ void SetCTFStats(edict_t *ent)
 		}
 	}
 
-	// tech icon
-	i = 0;
+	// tech icon, from the techs the accounting has this client holding
 	ent->client->ps.stats[STAT_CTF_TECH] = 0;
-	while (tnames[i]) {
-		if ((tech = FindItemByClassname(tnames[i])) != NULL &&
-			ent->client->pers.inventory[ITEM_INDEX(tech)]) {
-			ent->client->ps.stats[STAT_CTF_TECH] = gi.imageindex(tech->icon);
-			break;
-		}
-		i++;
-	}
-
-	// figure out what icon to display for team logos
-	// three states:
-	//   flag at base
-	//   flag taken
-	//   flag dropped
-	p1 = imageindex_i_ctf1;
-	e = G_Find(NULL, FOFS(classname), "item_flag_team1");
-	if (e != NULL) {
-		if (e->solid == SOLID_NOT) {
-			int i;
-
-			// not at base
-			// check if on player
-			p1 = imageindex_i_ctf1d; // default to dropped
-			for (i = 1; i <= maxclients->value; i++)
-				if (g_edicts[i].inuse &&
-					g_edicts[i].client->pers.inventory[ITEM_INDEX(flag1_item)])
-				{
-					// enemy has it
-					p1 = imageindex_i_ctf1t;
-					break;
-				}
-		} else if (e->spawnflags & DROPPED_ITEM)
-			p1 = imageindex_i_ctf1d; // must be dropped
-	}
-	p2 = imageindex_i_ctf2;
-	e = G_Find(NULL, FOFS(classname), "item_flag_team2");
-	if (e != NULL)
-	{
-		if (e->solid == SOLID_NOT)
-		{
-			int i;
-
-			// not at base
-			// check if on player
-			p2 = imageindex_i_ctf2d; // default to dropped
-			for (i = 1; i <= maxclients->value; i++)
-				if (g_edicts[i].inuse &&
-					g_edicts[i].client->pers.inventory[ITEM_INDEX(flag2_item)])
-				{
-					// enemy has it
-					p2 = imageindex_i_ctf2t;
-					break;
-				}
-		} else if (e->spawnflags & DROPPED_ITEM)
-			p2 = imageindex_i_ctf2d; // must be dropped
-	}
-	// Knightmare added
-	p3 = imageindex_i_ctf3;
-	e = G_Find(NULL, FOFS(classname), "item_flag_team3");
-	if (e != NULL)
+	slot = ent->client - game.clients;
+	if (slot >= 0 && slot < MAX_CLIENTS && techs_held_by[slot])
 	{
-		if (e->solid == SOLID_NOT)
+		for (i = 0; i < TECHTYPES; i++)
 		{
-			int i;
-
-			// not at base
-			// check if on player
-			p3 = imageindex_i_ctf3d; // default to dropped
-			for (i = 1; i <= maxclients->value; i++)
-				if (g_edicts[i].inuse &&
-					g_edicts[i].client->pers.inventory[ITEM_INDEX(flag3_item)])
-				{
-					// enemy has it
-					p3 = imageindex_i_ctf3t;
-					break;
-				}
-		} else if (e->spawnflags & DROPPED_ITEM)
-			p3 = imageindex_i_ctf3d; // must be dropped
+			if (!(techs_held_by[slot] & (1 << i)))
+				continue;
+			tech = ctf_techitems[i];
+			if (!tech || !ent->client->pers.inventory[ITEM_INDEX(tech)])
+				continue;
+			if (!techs_icon[i])
+				techs_icon[i] = gi.imageindex(tech->icon);
+			ent->client->ps.stats[STAT_CTF_TECH] = techs_icon[i];
+			break;
+		}
 	}
 
+	// team logos are the same for everybody, see CTFUpdateFlagPics
+	CTFUpdateFlagPics ();
+	p1 = ctf_flagpics.p1;
+	p2 = ctf_flagpics.p2;
+	p3 = ctf_flagpics.p3;
 
 	ent->client->ps.stats[STAT_CTF_TEAM1_PIC] = p1;
 	ent->client->ps.stats[STAT_CTF_TEAM2_PIC] = p2;
@@ -2105,11 +2299,38 @@ void CTFGrappleTouch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t
 }
 
 // draw beam between grapple and self
+/*
+The client keeps a TE_GRAPPLE_CABLE beam for 200 msec and replaces it
+when the same player's next one arrives, so while neither the hook nor
+the player holding it moves or turns (hanging), the cable only needs to
+be sent every CABLE_RESEND_FRAMES frames. Other players draw the cable
+from the origin and offset that were sent, so it goes out every frame
+while either end is moving.
+*/
+#define	CABLE_RESEND_FRAMES		2
+#define	CABLE_MOVE				2
+
+static struct
+{
+	edict_t	*grapple;
+	int		framenum;
+	vec3_t	start, end;
+} cable_sent[MAX_CLIENTS];
+
+static qboolean CTFCableMoved (vec3_t a, vec3_t b)
+{
+	vec3_t	v;
+
+	VectorSubtract (a, b, v);
+	return (DotProduct (v, v) > CABLE_MOVE*CABLE_MOVE);
+}
+
 void CTFGrappleDrawCable(edict_t *self)
 {
 	vec3_t	offset, start, end, f, r;
 	vec3_t	dir;
 	float	distance;
+	int		n;
 
 	AngleVectors (self->owner->client->v_angle, f, r, NULL);
 	VectorSet(offset, 16, 16, self->owner->viewheight-8);
@@ -2154,6 +2375,21 @@ void CTFGrappleDrawCable(edict_t *self)
 	// adjust end z for end spot since the monster is currently dead
 //	end[2] = self->absmin[2] + self->size[2] / 2;
 
+	n = self->owner - g_edicts - 1;
+	if (n >= 0 && n < MAX_CLIENTS)
+	{
+		if (cable_sent[n].grapple == self
+			&& level.framenum >= cable_sent[n].framenum
+			&& level.framenum - cable_sent[n].framenum < CABLE_RESEND_FRAMES
+			&& !CTFCableMoved (start, cable_sent[n].start)
+			&& !CTFCableMoved (end, cable_sent[n].end))
+			return;		// the last one is still drawn
+		cable_sent[n].grapple = self;
+		cable_sent[n].framenum = level.framenum;
+		VectorCopy (start, cable_sent[n].start);
+		VectorCopy (end, cable_sent[n].end);
+	}
+
 	gi.WriteByte (svc_temp_entity);
 #if 1 //def USE_GRAPPLE_CABLE
 	gi.WriteByte (TE_GRAPPLE_CABLE);
@@ -2452,10 +2688,69 @@ void CTFTeam_f (edict_t *ent)
 CTFScoreboardMessage
 ==================
 */
+/*
+The CTF scoreboard is the same for every viewer and only depends on
+each client's team, score, ping, flags and whether they are solid (for
+the spectator list). It is built into ctf_scoreboard and sent again as
+it is until one of those changes.
+*/
+typedef struct
+{
+	int		inuse;
+	int		team;
+	int		score;
+	int		ping;
+	int		flags;
+	int		spectator;
+} ctfsbkey_t;
+
+static ctfsbkey_t	ctf_scoreboard_key[MAX_CLIENTS];
+static float		ctf_scoreboard_ttctf;
+static qboolean		ctf_scoreboard_valid;
+static char			ctf_scoreboard[1400];
+
+static void CTFBuildScoreboard (char *string);
+
 void CTFScoreboardMessage (edict_t *ent, edict_t *killer)
+{
+	ctfsbkey_t	key[MAX_CLIENTS];
+	edict_t		*cl_ent;
+	gclient_t	*cl;
+	int			i;
+
+	memset (key, 0, game.maxclients * sizeof(key[0]));
+	for (i=0; i<game.maxclients; i++)
+	{
+		cl_ent = g_edicts + 1 + i;
+		if (!cl_ent->inuse)
+			continue;
+		cl = &game.clients[i];
+		key[i].inuse = 1;
+		key[i].team = cl->resp.ctf_team;
+		key[i].score = cl->resp.score;
+		key[i].ping = cl->ping > 999 ? 999 : cl->ping;
+		key[i].flags = (cl->pers.inventory[ITEM_INDEX(flag1_item)] ? 1 : 0)
+			| (cl->pers.inventory[ITEM_INDEX(flag2_item)] ? 2 : 0)
+			| ((flag3_item && cl->pers.inventory[ITEM_INDEX(flag3_item)]) ? 4 : 0);
+		key[i].spectator = (cl_ent->solid == SOLID_NOT);
+	}
+
+	if (!ctf_scoreboard_valid || ctf_scoreboard_ttctf != ttctf->value
+		|| memcmp(key, ctf_scoreboard_key, game.maxclients * sizeof(key[0])))
+	{
+		memcpy (ctf_scoreboard_key, key, game.maxclients * sizeof(key[0]));
+		ctf_scoreboard_ttctf = ttctf->value;
+		CTFBuildScoreboard (ctf_scoreboard);
+		ctf_scoreboard_valid = true;
+	}
+
+	gi.WriteByte (svc_layout);
+	gi.WriteString (ctf_scoreboard);
+}
+
+static void CTFBuildScoreboard (char *string)
 {
 	char	entry[1024];
-	char	string[1400];
 	int		len;
 	int		i, j, k, n;
 	int		sorted[3][MAX_CLIENTS];
@@ -2766,9 +3061,6 @@ void CTFScoreboardMessage (edict_t *ent, edict_t *killer)
 			sprintf(string + strlen(string), "xv 168 yv %d string \"..and %d more\" ",
 			42 + (last[1]+1)*8, total[1] - last[1] - 1);
 	}
-
-	gi.WriteByte (svc_layout);
-	gi.WriteString (string);
 }
 
 /*------------------------------------------------------------------------*/
@@ -2854,7 +3146,7 @@ gitem_t *CTFWhat_Tech(edict_t *ent)
 
 	i = 0;
 	while (tnames[i]) {
-		if ((tech = FindItemByClassname(tnames[i])) != NULL &&
+		if ((tech = ctf_techitems[i]) != NULL &&
 			ent->client->pers.inventory[ITEM_INDEX(tech)]) {
 			return tech;
 		}
@@ -2870,7 +3162,7 @@ qboolean CTFPickup_Tech (edict_t *ent, edict_t *other)
 
 	i = 0;
 	while (tnames[i]) {
-		if ((tech = FindItemByClassname(tnames[i])) != NULL &&
+		if ((tech = ctf_techitems[i]) != NULL &&
 			other->client->pers.inventory[ITEM_INDEX(tech)]) {
 			CTFHasTech(other);
 			return false; // has this one
@@ -2880,6 +3172,7 @@ qboolean CTFPickup_Tech (edict_t *ent, edict_t *other)
 	
 	// client only gets one tech
 	other->client->pers.inventory[ITEM_INDEX(ent->item)]++;
+	CTFSetTechHeld (other - g_edicts - 1, CTFTechIndex(ent->item), true);
 	other->client->ctf_regentime = level.time;
 	return true;
 }
@@ -2938,6 +3231,7 @@ void CTFDrop_Tech(edict_t *ent, gitem_t *item)
 	}
 
 	ent->client->pers.inventory[ITEM_INDEX(item)] = 0;
+	CTFSetTechHeld (ent - g_edicts - 1, CTFTechIndex(item), false);
 
 	Apply_Tech_Shell(item, tech);
 }
@@ -2951,7 +3245,7 @@ void CTFDeadDropTech(edict_t *ent)
 	i = 0;
 	while (tnames[i])
 	{
-		if ((tech = FindItemByClassname(tnames[i])) != NULL &&
+		if ((tech = ctf_techitems[i]) != NULL &&
 			ent->client->pers.inventory[ITEM_INDEX(tech)])
 		{
 			dropped = Drop_Item(ent, tech);
@@ -2962,6 +3256,7 @@ void CTFDeadDropTech(edict_t *ent)
 			dropped->think = TechThink;
 			dropped->owner = NULL;
 			ent->client->pers.inventory[ITEM_INDEX(tech)] = 0;
+			CTFSetTechHeld (ent - g_edicts - 1, i, false);
 			Apply_Tech_Shell (tech, dropped);
 		}
 		i++;
@@ -2971,74 +3266,18 @@ void CTFDeadDropTech(edict_t *ent)
 //ScarFace- this function counts the number of runes in circulation
 int TechCount (void)
 {
-	gitem_t	*tech;
-	edict_t	*cl_ent;
-	edict_t	*mapent = NULL;
-	int i, j;
+	int i;
 	int count = 0;
 
-	mapent = g_edicts+1; // skip the worldspawn
-	// cycle through all ents to find techs
-	for (i = 1; i < globals.num_edicts; i++, mapent++)
-	{
-		if (!mapent->classname)
-			continue;
-
-		if (!strncmp(mapent->classname, "item_tech", 9))
-			count++;
-	}
-	//cycle through all players to find techs
-	for (i = 0; i < game.maxclients; i++)
-	{
-		cl_ent = g_edicts + 1 + i;
-		if (cl_ent->inuse)
-		{
-			j = 0;
-			while (tnames[j])
-			{
-				if ((tech = FindItemByClassname(tnames[j])) != NULL &&
-					cl_ent->client->pers.inventory[ITEM_INDEX(tech)])
-					count++;
-				j++;
-			}
-		}
-	}
+	for (i = 0; i < TECHTYPES; i++)
+		count += techs_loose[i] + techs_held[i];
 	return count;
 }
 
 int NumOfTech (int index)
 {
-	gitem_t	*tech;
-	edict_t	*cl_ent;
-	edict_t	*mapent = NULL;
-	int i;
-	int count = 0;
-	char techname [80];
-
-	mapent = g_edicts+1; // skip the worldspawn
-	// cycle through all ents to find techs
-	for (i = 1; i < globals.num_edicts; i++, mapent++)
-	{
-		if (!mapent->classname)
-			continue;
-
-		sprintf(techname, "item_tech%d", index+1);
-		if (!strcmp(mapent->classname, techname))
-			count++;
-	}
-	//cycle through all players to find techs
-	for (i = 0; i < game.maxclients; i++)
-	{
-		cl_ent = g_edicts + 1 + i;
-		if (cl_ent->inuse)
-		{
-			if ((tech = FindItemByClassname(tnames[index])) != NULL &&
-				cl_ent->client->pers.inventory[ITEM_INDEX(tech)])
-				count++;
-		}
-	}
-	//gi.dprintf ("Number of tech%d in map: %d\n", index+1, count);
-	return count;
+	//gi.dprintf ("Number of tech%d in map: %d\n", index+1, techs_loose[index] + techs_held[index]);
+	return techs_loose[index] + techs_held[index];
 }
 
 
@@ -3067,7 +3306,7 @@ void SpawnMoreTechs (int oldtechcount, int newtechcount, int numtechtypes)
 		while ( (tnames[i]) &&
 				((j < numtechtypes) || ((j < tech_max->value) && (j < newtechcount))) )
 		{
-			if (((tech = FindItemByClassname(tnames[i])) != NULL &&
+			if (((tech = ctf_techitems[i]) != NULL &&
 				 (spot = FindTechSpawn()) != NULL)
 				&& ((int)(tech_flags->value) & (0x1 << i)))
 			{
@@ -3130,6 +3369,13 @@ void RemoveTechs (int oldtechcount, int newtechcount, int numtechtypes)
 }
 
 //ScarFace- this function checks to see if we need to spawn or remove runes
+// Once the count is off and spawning or removing can't fix it (every
+// tech of the type to remove is held), it isn't tried again until a
+// client or tech cvar or one of the techs changes.
+static int	techs_tried_count = -1;
+static int	techs_tried_bits;
+static int	techs_tried_changes;
+
 void CheckNumTechs (void)
 {
 	edict_t	*cl_ent;
@@ -3173,6 +3419,11 @@ void CheckNumTechs (void)
 	if (newtechcount < numtechtypes) //leave at least 1 of each enabled tech
 		newtechcount = numtechtypes;
 	numtechs = TechCount();
+	if (newtechcount == numtechs)
+		return;
+	if (newtechcount == techs_tried_count && (int)(tech_flags->value) == techs_tried_bits &&
+		techs_changed == techs_tried_changes)
+		return;
 	if (newtechcount > numtechs)
 	{
 		//gi.dprintf ("Number of techs to spawn: %d\n", newtechcount);
@@ -3183,6 +3434,9 @@ void CheckNumTechs (void)
 		//gi.dprintf ("Number of techs to spawn: %d\n", newtechcount);
 		RemoveTechs (numtechs, newtechcount, numtechtypes);
 	}
+	techs_tried_count = newtechcount;
+	techs_tried_bits = (int)(tech_flags->value);
+	techs_tried_changes = techs_changed;
 }
 
 void SpawnTech(gitem_t *item, edict_t *spot)
@@ -3197,6 +3451,7 @@ void SpawnTech(gitem_t *item, edict_t *spot)
 	ent->item = item;
 	ent->spawnflags = DROPPED_ITEM;
 	ent->s.effects = item->world_model_flags;
+	CTFTechAdded (ent);
 
 	Apply_Tech_Shell (item, ent);
 
@@ -3241,7 +3496,7 @@ void SpawnTechs (edict_t *ent)
 	i = 0;
 	while (tnames[i])
 	{
-		if ( (tech = FindItemByClassname(tnames[i])) != NULL &&
+		if ( (tech = ctf_techitems[i]) != NULL &&
 			(spot = FindTechSpawn()) != NULL
 			&& ((int)tech_flags->value & (0x1 << i)) )
 			SpawnTech(tech, spot);
@@ -3603,32 +3858,97 @@ struct {
 };
 
 
-void CTFSay_Team_Location(edict_t *who, char *buf)
+/*
+Everything loc_names lists is an item, so what CTFSay_Team_Location
+looks for is kept as a priority per item and a list of the items in
+the level, made the first time it is needed each frame. Each player's
+last answer is reused while they stay put.
+*/
+#define	LOC_RADIUS		1024
+#define	LOC_REUSE_DIST	32
+#define	LOC_REUSE_TIME	10		// frames
+
+typedef struct
+{
+	int		framenum;		// -1 if empty
+	vec3_t	origin;
+	int		waterlevel;
+	char	text[128];
+} loccache_t;
+
+static int			loc_priority[MAX_ITEMS];	// 0 if not a landmark
+static qboolean		loc_priority_set;
+static edict_t		*loc_landmarks[MAX_EDICTS];
+static int			loc_num_landmarks;
+static int			loc_landmark_frame = -1;
+static loccache_t	loc_cache[MAX_CLIENTS];
+
+void CTFResetLocations(void)
+{
+	int		i;
+
+	loc_landmark_frame = -1;
+	for (i = 0; i < MAX_CLIENTS; i++)
+		loc_cache[i].framenum = -1;
+}
+
+static void loc_BuildLandmarks(void)
+{
+	edict_t	*e;
+	gitem_t	*item;
+	int		i;
+
+	if (!loc_priority_set) {
+		for (i = 0; loc_names[i].classname; i++)
+			if ((item = FindItemByClassname(loc_names[i].classname)) != NULL &&
+				!loc_priority[ITEM_INDEX(item)])
+				loc_priority[ITEM_INDEX(item)] = loc_names[i].priority;
+		loc_priority_set = true;
+	}
+
+	loc_num_landmarks = 0;
+	for (e = g_edicts + 1; e < &g_edicts[globals.num_edicts]; e++) {
+		if (!e->inuse || !e->item || !e->classname)
+			continue;
+		// the item has to match by classname too, as the strcmp did
+		if (!loc_priority[ITEM_INDEX(e->item)] || strcmp(e->classname, e->item->classname))
+			continue;
+		loc_landmarks[loc_num_landmarks++] = e;
+	}
+	loc_landmark_frame = level.framenum;
+}
+
+static void CTFFindLocation(edict_t *who, char *buf)
 {
 	edict_t *what = NULL;
 	edict_t *hot = NULL;
 	float hotdist = 999999, newdist;
 	vec3_t v;
 	int hotindex = 999;
-	int i;
+	int i, j, priority;
 	gitem_t *item;
 	int nearteam = -1;
 	edict_t *flag1, *flag2;
 	qboolean hotsee = false;
 	qboolean cansee;
 
-	while ((what = loc_findradius(what, who->s.origin, 1024)) != NULL) {
-		// find what in loc_classnames
-		for (i = 0; loc_names[i].classname; i++)
-			if (strcmp(what->classname, loc_names[i].classname) == 0)
-				break;
-		if (!loc_names[i].classname)
+	if (loc_landmark_frame != level.framenum)
+		loc_BuildLandmarks();
+
+	for (j = 0; j < loc_num_landmarks; j++) {
+		what = loc_landmarks[j];
+		if (!what->inuse)
+			continue;
+		for (i = 0; i < 3; i++)
+			v[i] = who->s.origin[i] - (what->s.origin[i] + (what->mins[i] + what->maxs[i])*0.5);
+		if (VectorLength(v) > LOC_RADIUS)
 			continue;
+		priority = loc_priority[ITEM_INDEX(what->item)];
 		// something we can see get priority over something we can't
 		cansee = loc_CanSee(what, who);
 		if (cansee && !hotsee) {
 			hotsee = true;
-			hotindex = loc_names[i].priority;
+			hotindex = priority;
 			hot = what;
 			VectorSubtract(what->s.origin, who->s.origin, v);
 			hotdist = VectorLength(v);
@@ -3637,15 +3957,15 @@ void CTFSay_Team_Location(edict_t *who, char *buf)
 		// if we can't see this, but we have something we can see, skip it
 		if (hotsee && !cansee)
 			continue;
-		if (hotsee && hotindex < loc_names[i].priority)
+		if (hotsee && hotindex < priority)
 			continue;
 		VectorSubtract(what->s.origin, who->s.origin, v);
 		newdist = VectorLength(v);
 		if (newdist < hotdist || 
-			(cansee && loc_names[i].priority < hotindex)) {
+			(cansee && priority < hotindex)) {
 			hot = what;
 			hotdist = newdist;
-			hotindex = i;
+			hotindex = priority;
 			hotsee = loc_CanSee(hot, who);
 		}
 	}
@@ -3658,14 +3978,22 @@ void CTFSay_Team_Location(edict_t *who, char *buf)
 	// we now have the closest item
 	// see if there's more than one in the map, if so
 	// we need to determine what team is closest
-	what = NULL;
-	while ((what = G_Find(what, FOFS(classname), hot->classname)) != NULL) {
-		if (what == hot)
+	for (j = 0; j < loc_num_landmarks; j++) {
+		what = loc_landmarks[j];
+		if (what == hot || !what->inuse || strcmp(what->classname, hot->classname))
 			continue;
 		// if we are here, there is more than one, find out if hot
 		// is closer to red flag or blue flag
-		if ((flag1 = G_Find(NULL, FOFS(classname), "item_flag_team1")) != NULL &&
-			(flag2 = G_Find(NULL, FOFS(classname), "item_flag_team2")) != NULL) {
+		flag1 = flag2 = NULL;
+		for (i = 0; i < loc_num_landmarks; i++) {
+			if (!loc_landmarks[i]->inuse)
+				continue;
+			if (!flag1 && !strcmp(loc_landmarks[i]->classname, "item_flag_team1"))
+				flag1 = loc_landmarks[i];
+			if (!flag2 && !strcmp(loc_landmarks[i]->classname, "item_flag_team2"))
+				flag2 = loc_landmarks[i];
+		}
+		if (flag1 && flag2) {
 			VectorSubtract(hot->s.origin, flag1->s.origin, v);
 			hotdist = VectorLength(v);
 			VectorSubtract(hot->s.origin, flag2->s.origin, v);
@@ -3678,10 +4006,7 @@ void CTFSay_Team_Location(edict_t *who, char *buf)
 		break;
 	}
 
-	if ((item = FindItemByClassname(hot->classname)) == NULL) {
-		strcpy(buf, "nowhere");
-		return;
-	}
+	item = hot->item;
 
 	// in water?
 	if (who->waterlevel)
@@ -3709,6 +4034,35 @@ void CTFSay_Team_Location(edict_t *who, char *buf)
 	strcat(buf, item->pickup_name);
 }
 
+void CTFSay_Team_Location(edict_t *who, char *buf)
+{
+	loccache_t	*cache;
+	vec3_t		v;
+	int			n;
+
+	n = who - g_edicts - 1;
+	if (n < 0 || n >= MAX_CLIENTS) {
+		CTFFindLocation(who, buf);
+		return;
+	}
+
+	cache = &loc_cache[n];
+	VectorSubtract(who->s.origin, cache->origin, v);
+	if (cache->framenum >= 0 && cache->framenum <= level.framenum &&
+		level.framenum - cache->framenum < LOC_REUSE_TIME &&
+		cache->waterlevel == who->waterlevel &&
+		VectorLength(v) < LOC_REUSE_DIST) {
+		strcpy(buf, cache->text);
+		return;
+	}
+
+	CTFFindLocation(who, buf);
+	Com_sprintf(cache->text, sizeof(cache->text), "%s", buf);
+	cache->framenum = level.framenum;
+	VectorCopy(who->s.origin, cache->origin);
+	cache->waterlevel = who->waterlevel;
+}
+
 void CTFSay_Team_Armor(edict_t *who, char *buf)
 {
 	gitem_t		*item;
@@ -3720,7 +4074,7 @@ void CTFSay_Team_Armor(edict_t *who, char *buf)
 	power_armor_type = PowerArmorType (who);
 	if (power_armor_type)
 	{
-		cells = who->client->pers.inventory[ITEM_INDEX(FindItem ("cells"))];
+		cells = who->client->pers.inventory[cells_index];
 		if (cells)
 			sprintf(buf+strlen(buf), "%s with %i cells ",
 				(power_armor_type == POWER_ARMOR_SCREEN) ?
@@ -3759,7 +4113,7 @@ void CTFSay_Team_Tech(edict_t *who, char *buf)
 	// see if the player has a tech powerup
 	i = 0;
 	while (tnames[i]) {
-		if ((tech = FindItemByClassname(tnames[i])) != NULL &&
+		if ((tech = ctf_techitems[i]) != NULL &&
 			who->client->pers.inventory[ITEM_INDEX(tech)]) {
 			sprintf(buf, "the %s", tech->pickup_name);
 			return;
@@ -4100,8 +4454,13 @@ void CTFStartMatch(void)
 {
 	int i;
 	edict_t *ent;
+	qboolean restarted = false;
 //	int ghost = 0;
 
+	// put the map back the way it spawned, without reloading it
+	if (matchreset->value)
+		restarted = RestartLevel();
+
 	ctfgame.match = MATCH_GAME;
 	ctfgame.matchtime = level.time + matchtime->value * 60;
 	ctfgame.countdown = false;
@@ -4115,6 +4474,12 @@ void CTFStartMatch(void)
 		if (!ent->inuse)
 			continue;
 
+		// the flags are back on their stands
+		if (restarted) {
+			ent->client->pers.inventory[ITEM_INDEX(flag1_item)] = 0;
+			ent->client->pers.inventory[ITEM_INDEX(flag2_item)] = 0;
+		}
+
 		ent->client->resp.score = 0;
 		ent->client->resp.ctf_state = 0;
 		ent->client->resp.ghost = NULL;
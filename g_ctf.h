@@ -141,12 +141,15 @@ qboolean CTFDrop_Flag(edict_t *ent, gitem_t *item);
 void CTFEffects(edict_t *player);
 void CTFCalcScores(void);
 void SetCTFStats(edict_t *ent);
+void CTFFlagsChanged (void);
+void CTFUpdateFlagPics (void);
 gitem_t *CTFWhat_Flag(edict_t *ent);
 void CTFDeadDropFlag(edict_t *self);
 void CTFScoreboardMessage (edict_t *ent, edict_t *killer);
 void CTFTeam_f (edict_t *ent);
 void CTFID_f (edict_t *ent);
 void CTFSay_Team(edict_t *who, char *msg);
+void CTFResetLocations(void);
 void CTFFlagSetup (edict_t *ent);
 void CTFResetFlag(int ctf_team);
 void CTFFragBonuses(edict_t *targ, edict_t *inflictor, edict_t *attacker);
@@ -177,6 +180,10 @@ void CTFApplyAmmogen (edict_t *attacker, edict_t *targ);
 void CTFApplyAmmogenSound(edict_t *ent);
 void CTFRespawnTech(edict_t *ent);
 void CTFResetTech(void);
+void CTFTechAdded(edict_t *ent);
+void CTFTechRemoved(edict_t *ent);
+void CTFForgetTechs(gclient_t *client);
+void CTFCountTechs(void);
 
 void CTFOpenJoinMenu(edict_t *ent);
 void TTCTFOpenJoinMenu(edict_t *ent); // Knightmare added
@@ -128,6 +128,18 @@ qboolean	InTriggerFog;
 float		last_software_frame;
 float		last_opengl_frame;
 
+// The svc_fog values last sent to the player. Fog runs every ClientThink,
+// but GLFog only sends when one of these changes, since svc_fog is
+// reliable. Fades still go out whenever they change a value by a whole
+// unit. Fog_Off (which ClientBegin calls on every level and savegame
+// load) forgets them, so the next GLFog sends again.
+static struct
+{
+	qboolean	valid;
+	int			model, density, fog_near, fog_far;
+	int			red, green, blue;
+} fog_sent;
+
 
 #define FOG_ON       1
 #define FOG_TOGGLE   2
@@ -149,6 +161,8 @@ void Fog_Off()
     if (!g_edicts || !player_ent->client || player_ent->is_bot)
         return;
     
+    fog_sent.valid = false;
+
     gi.WriteByte (svc_fog); // svc_fog = 21
     gi.WriteByte (0); // disable message, remaining paramaters are ignored
     gi.WriteByte (0); // 0, 1, or 2
@@ -365,6 +379,21 @@ void GLFog()
 	fog_green = (int)(pfog->Color[1]*255);
 	fog_blue = (int)(pfog->Color[2]*255);
 
+	if (fog_sent.valid && fog_sent.model == pfog->Model && fog_sent.density == (fog_density & 0xff)
+		&& fog_sent.fog_near == (short)fog_near && fog_sent.fog_far == (short)fog_far
+		&& fog_sent.red == (fog_red & 0xff) && fog_sent.green == (fog_green & 0xff) && fog_sent.blue == (fog_blue & 0xff))
+		return;
+
+	// compare as written, so values out of range don't cause a send every frame
+	fog_sent.valid    = true;
+	fog_sent.model    = pfog->Model;
+	fog_sent.density  = fog_density & 0xff;
+	fog_sent.fog_near = (short)fog_near;
+	fog_sent.fog_far  = (short)fog_far;
+	fog_sent.red      = fog_red & 0xff;
+	fog_sent.green    = fog_green & 0xff;
+	fog_sent.blue     = fog_blue & 0xff;
+
 	gi.WriteByte (svc_fog);			// svc_fog = 21
 	gi.WriteByte (1);				// enable message
 	gi.WriteByte (pfog->Model);	// model 0, 1, or 2
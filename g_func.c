@@ -45,11 +45,185 @@ void bob_init (edict_t *self);
 void Move_Done (edict_t *ent);
 void train_children_think (edict_t *self);
 void train_blocked (edict_t *self, edict_t *other);
+
+/*
+==============================================================================
+
+MOVEWITH GRAPH
+
+A movewith parent's children hang off its movewith_next, each child
+pointing to the next one. That chain is what gets saved, so it stays,
+but taking a child out of it used to mean scanning g_edicts for whatever
+pointed at the child.
+
+Next to the chains we keep, per edict number, the edict that links to
+it, so movewith_unlink is O(1). Everything that adds a link goes through
+movewith_link. A link that does not check out (a chain changed some other
+way, a saved game just loaded) just rebuilds the table with one scan.
+
+Each child also caches the axis set_child_movement last built for it,
+and what kind of entity it is, so riding a parent that isn't turning
+costs neither AngleVectors nor a string of classname compares.
+
+==============================================================================
+*/
+
+#define	MOVEWITH_OTHER			0
+#define	MOVEWITH_DOOR			1	// func_door and func_button
+#define	MOVEWITH_ROTATING		2
+#define	MOVEWITH_TURRET			3	// turret_breach and turret_base
+#define	MOVEWITH_DOOR_ROTATING	4
+
+typedef struct
+{
+	int		prev;					// edict linking to this one, 0 if none
+	qboolean	axis_valid;
+	vec3_t	delta_angles;			// what forward, right, up were built from
+	vec3_t	forward, right, up;
+	char	*classname;				// what kind was worked out from
+	int		kind;
+} movewith_node_t;
+
+static movewith_node_t	*movewith_nodes;
+static qboolean			movewith_dirty;
+
+static void movewith_rebuild (void)
+{
+	edict_t	*e;
+	int		i;
+
+	if (!movewith_nodes)
+		movewith_nodes = gi.TagMalloc (game.maxentities * sizeof(movewith_node_t), TAG_GAME);
+
+	for (i=0 ; i<game.maxentities ; i++)
+		movewith_nodes[i].prev = 0;
+
+	// go backwards, so the lowest numbered edict wins like the old scans
+	for (i=globals.num_edicts-1 ; i>0 ; i--)
+	{
+		e = g_edicts + i;
+		if (e->movewith_next)
+			movewith_nodes[e->movewith_next - g_edicts].prev = i;
+	}
+	movewith_dirty = false;
+}
+
+/*
+=================
+movewith_initgame
+
+Called from InitGame. The nodes are sized by maxentities, which is
+latched, and movewith_rebuild allocates them again.
+=================
+*/
+void movewith_initgame (void)
+{
+	movewith_nodes = NULL;
+	movewith_dirty = true;
+}
+
+/*
+=================
+movewith_reset
+
+The chains came from a new map or a saved game; called by SpawnEntities
+and ReadLevel
+=================
+*/
+void movewith_reset (void)
+{
+	if (movewith_nodes)
+		memset (movewith_nodes, 0, game.maxentities * sizeof(movewith_node_t));
+	movewith_dirty = true;
+}
+
+/*
+=================
+movewith_link
+
+Points prev->movewith_next at next
+=================
+*/
+void movewith_link (edict_t *prev, edict_t *next)
+{
+	prev->movewith_next = next;
+	if (next && movewith_nodes && !movewith_dirty)
+		movewith_nodes[next - g_edicts].prev = prev - g_edicts;
+}
+
+static edict_t *movewith_prev (edict_t *ent)
+{
+	int		num = ent - g_edicts;
+	int		prev;
+
+	if (!movewith_nodes || movewith_dirty)
+		movewith_rebuild ();
+	else
+	{
+		prev = movewith_nodes[num].prev;
+		if (prev && g_edicts[prev].movewith_next != ent)
+			movewith_rebuild ();
+	}
+	prev = movewith_nodes[num].prev;
+	return prev ? g_edicts + prev : NULL;
+}
+
+/*
+=================
+movewith_unlink
+
+Takes ent out of whatever movewith chain it is in, joining the entities
+on either side of it
+=================
+*/
+void movewith_unlink (edict_t *ent)
+{
+	edict_t	*prev;
+
+	if ((prev = movewith_prev (ent)) != NULL)
+		movewith_link (prev, ent->movewith_next);
+}
+
+static movewith_node_t *movewith_node (edict_t *e, vec3_t delta_angles)
+{
+	movewith_node_t	*node;
+
+	if (!movewith_nodes)
+		movewith_rebuild ();
+	node = movewith_nodes + (e - g_edicts);
+
+	if (!node->axis_valid || !VectorCompare (node->delta_angles, delta_angles))
+	{
+		VectorCopy (delta_angles, node->delta_angles);
+		AngleVectors (delta_angles, node->forward, node->right, node->up);
+		VectorNegate (node->right, node->right);
+		node->axis_valid = true;
+	}
+
+	if (node->classname != e->classname)
+	{
+		node->classname = e->classname;
+		node->kind = MOVEWITH_OTHER;
+		if (!e->classname)
+			return node;
+		if (!Q_strcasecmp(e->classname,"func_door") || !Q_strcasecmp(e->classname,"func_button"))
+			node->kind = MOVEWITH_DOOR;
+		else if (!Q_strcasecmp(e->classname,"func_rotating"))
+			node->kind = MOVEWITH_ROTATING;
+		else if (!Q_strcasecmp(e->classname,"turret_breach") || !Q_strcasecmp(e->classname,"turret_base"))
+			node->kind = MOVEWITH_TURRET;
+		else if (!Q_strcasecmp(e->classname,"func_door_rotating"))
+			node->kind = MOVEWITH_DOOR_ROTATING;
+	}
+	return node;
+}
+
 void set_child_movement(edict_t *self)
 {
 	edict_t *e;
 	edict_t	*parent;
-	vec3_t	forward, right, up;
+	movewith_node_t	*node;
+	float	*forward, *right, *up;
 	vec3_t	angles, amove;
 	vec3_t	offset;
 	vec3_t	delta_angles;
@@ -66,13 +240,15 @@ restart:
 		if(!e->inuse) break;
 
 		VectorSubtract(self->s.angles,e->parent_attach_angles,delta_angles);
-		AngleVectors(delta_angles,forward,right,up);
-		VectorNegate(right,right);
+		node = movewith_node(e,delta_angles);
+		forward = node->forward;
+		right   = node->right;
+		up      = node->up;
 
 		// remove gibbed monsters from the chain
 		if(e->svflags & SVF_MONSTER) {
 			if(e->health <= e->gib_health) {
-				parent->movewith_next = e->movewith_next;
+				movewith_link(parent, e->movewith_next);
 				e = e->movewith_next;
 				if(e)
 					goto restart;
@@ -84,7 +260,7 @@ restart:
 			is_monster = false;
 
 		// For all but func_button and func_door, move origin and match velocities
-		if(Q_strcasecmp(e->classname,"func_door") && Q_strcasecmp(e->classname,"func_button")) {
+		if(node->kind != MOVEWITH_DOOR) {
 
 			VectorMA(self->s.origin, e->movewith_offset[0], forward, e->s.origin);
 			VectorMA(e->s.origin,    e->movewith_offset[1], right,   e->s.origin);
@@ -110,7 +286,7 @@ restart:
 		VectorScale(self->avelocity,FRAMETIME,amove);
 		if(self->turn_rider) {
 			// Match angular velocities
-			if(!Q_strcasecmp(e->classname,"func_rotating")) {
+			if(node->kind == MOVEWITH_ROTATING) {
 				float	cr, sr;
 				float	cy, sy;
 				cy = cos((e->s.angles[1]-delta_angles[1])*M_PI/180);
@@ -132,11 +308,11 @@ restart:
 				// their own.
 				if( !e->do_not_rotate )
 				{
-					if(!Q_strcasecmp(e->classname,"turret_breach") || !Q_strcasecmp(e->classname,"turret_base") )
+					if(node->kind == MOVEWITH_TURRET)
 					{
 						VectorCopy(self->avelocity,e->avelocity);
 					}
-					else if(!Q_strcasecmp(e->classname,"func_door_rotating"))
+					else if(node->kind == MOVEWITH_DOOR_ROTATING)
 					{
 						VectorCopy(self->avelocity,e->avelocity);
 						VectorCopy(delta_angles,e->pos1);
@@ -175,8 +351,7 @@ restart:
 
 		// Special cases:
 		// Func_door/func_button and trigger fields
-		if( (!Q_strcasecmp(e->classname,"func_door"  )) ||
-			(!Q_strcasecmp(e->classname,"func_button"))    )
+		if(node->kind == MOVEWITH_DOOR)
 		{
 
 			VectorAdd(e->s.angles,e->org_angles,angles);
@@ -204,9 +379,7 @@ restart:
 		if(amove[YAW])
 		{
 			// Cross fingers here... move bounding boxes of doors and buttons
-			if( (!Q_strcasecmp(e->classname,"func_door"  )) ||
-				(!Q_strcasecmp(e->classname,"func_button")) ||
-				(e->solid == SOLID_TRIGGER) )
+			if( (node->kind == MOVEWITH_DOOR) || (e->solid == SOLID_TRIGGER) )
 			{
 				float		ca, sa, yaw;
 				vec3_t		p00, p01, p10, p11;
@@ -1524,7 +1697,7 @@ void movewith_init (edict_t *ent)
 		VectorCopy(child->mins,child->org_mins);
 		VectorCopy(child->maxs,child->org_maxs);
 		VectorSubtract(child->s.origin,ent->s.origin,child->movewith_offset);
-		e->movewith_next = child;
+		movewith_link(e, child);
 		e = child;
 		child = G_Find(child,FOFS(movewith),ent->targetname);
 	}
@@ -3170,10 +3343,9 @@ void SP_func_train (edict_t *self)
 		speaker->volume      = 1;
 		speaker->attenuation = self->attenuation; // was 3
 		speaker->owner       = self;
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 7;       // owner must be moving to play
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		if(VectorLength(self->s.origin))
 			VectorCopy(self->s.origin,speaker->s.origin);
 		else {
@@ -4167,10 +4339,9 @@ void SP_func_pushable (edict_t *self)
 		speaker->volume      = 1;
 		speaker->attenuation = ATTN_STATIC; // was 1
 		speaker->owner       = self;
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 11;       // owner must be moving and on ground to play
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		VectorAdd(self->absmin,self->absmax,speaker->s.origin);
 		VectorScale(speaker->s.origin,0.5,speaker->s.origin);
 		VectorSubtract(speaker->s.origin,self->s.origin,speaker->offset);
@@ -4684,7 +4855,7 @@ void SP_func_door_swinging (edict_t *self)
 		self->die = swinging_door_killed;
 
 	self->flags |= FL_REVERSIBLE;
-	strcpy(self->classname,"func_door_rotating");
+	self->classname = "func_door_rotating";	// the map's classname is interned, don't write over it
 
 	// Wait a few frames so that we're sure pathtarget has been parsed.
 	self->think = func_door_swinging_init;
@@ -59,6 +59,21 @@ int fuel_index;
 int	homing_index;
 int rl_index;
 int	hml_index;
+int	blaster_index;
+int	shotgun_index;
+int	sshotgun_index;
+int	machinegun_index;
+int	chaingun_index;
+int	gl_index;
+int	hyperblaster_index;
+int	railgun_index;
+int	bfg_index;
+int	grapple_index;
+int	jetpack_index;
+int	flashlight_index;
+
+// index of the ammo each item uses, 0 for none; filled in by InitItems
+static int	item_ammo_index[MAX_ITEMS];
 
 #define HEALTH_IGNORE_MAX	1
 #define HEALTH_TIMED		2
@@ -174,6 +189,201 @@ gitem_t	*FindItem (char *pickup_name)
 	return NULL;
 }
 
+/*
+===============
+ItemAmmoIndex
+
+The inventory slot of the ammo item uses, 0 if it uses none
+===============
+*/
+int ItemAmmoIndex (gitem_t *item)
+{
+	if (!item)
+		return 0;
+	return item_ammo_index[ITEM_INDEX(item)];
+}
+
+/*
+==============================================================================
+
+RESPAWN WHEEL
+
+A picked up item waits SOLID_NOT with its think set to DoRespawn, and
+G_RunFrame used to look at every one of them each frame until then.
+SetRespawn now also puts it in the wheel slot of the frame it is due,
+and G_RunRespawns, called before the entities run, only looks at the
+current slot. think and nextthink are still set, so saved games, CTF's
+reset and the bots' item table see what they always did; the wheel
+clears nextthink on what it fires. An item the wheel missed (frozen
+time, say) still comes back through its think.
+
+A team of items, of which one comes back at random, is read into an
+array the first time it respawns instead of counting the chain every
+time.
+
+==============================================================================
+*/
+
+#define	RESPAWN_WHEEL_SLOTS	64		// a lap is 6.4 seconds
+
+typedef struct
+{
+	int		count;
+	edict_t	*members[1];			// variable sized
+} respawnteam_t;
+
+static int				respawn_wheel[RESPAWN_WHEEL_SLOTS];	// first edict number, 0 if empty
+static int				*respawn_next;		// per edict, next in its slot
+static int				*respawn_due;		// per edict, framenum due, 0 if not queued
+static respawnteam_t	**respawn_teams;	// per team master, TAG_LEVEL
+static qboolean			respawn_dirty = true;
+
+void DoRespawn (edict_t *ent);
+
+static int RespawnFrame (float nextthink)
+{
+	int		framenum;
+
+	// the first frame G_RunThink would have run it
+	framenum = (int)((nextthink - 0.001) / FRAMETIME);
+	while (framenum*FRAMETIME + 0.001 < nextthink)
+		framenum++;
+	if (framenum <= level.framenum)
+		framenum = level.framenum + 1;
+	return framenum;
+}
+
+static void RespawnUnqueue (int num)
+{
+	int		*link;
+
+	if (!respawn_due[num])
+		return;
+	for (link = &respawn_wheel[respawn_due[num] % RESPAWN_WHEEL_SLOTS]; *link; link = &respawn_next[*link])
+	{
+		if (*link == num)
+		{
+			*link = respawn_next[num];
+			break;
+		}
+	}
+	respawn_due[num] = 0;
+}
+
+static void RespawnQueue (edict_t *ent)
+{
+	int		num = ent - g_edicts;
+	int		slot;
+
+	RespawnUnqueue (num);
+	respawn_due[num] = RespawnFrame (ent->nextthink);
+	slot = respawn_due[num] % RESPAWN_WHEEL_SLOTS;
+	respawn_next[num] = respawn_wheel[slot];
+	respawn_wheel[slot] = num;
+}
+
+static void RespawnRebuild (void)
+{
+	edict_t	*ent;
+	int		i;
+
+	if (!respawn_next)
+	{
+		respawn_next = gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+		respawn_due = gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+		respawn_teams = gi.TagMalloc (game.maxentities * sizeof(respawnteam_t *), TAG_GAME);
+	}
+	else
+	{
+		memset (respawn_due, 0, game.maxentities * sizeof(int));
+		memset (respawn_teams, 0, game.maxentities * sizeof(respawnteam_t *));
+	}
+	memset (respawn_wheel, 0, sizeof(respawn_wheel));
+	respawn_dirty = false;
+
+	for (i = maxclients->value+1, ent = g_edicts + i; i < globals.num_edicts; i++, ent++)
+	{
+		if (ent->inuse && ent->think == DoRespawn && ent->nextthink > 0)
+			RespawnQueue (ent);
+	}
+}
+
+/*
+=================
+G_ResetRespawns
+
+The level's items came from a new map, a saved game or a restart;
+called by G_ResetLevelCaches
+=================
+*/
+void G_ResetRespawns (void)
+{
+	respawn_dirty = true;
+}
+
+/*
+=================
+G_RunRespawns
+
+Respawns the items due this frame; called by G_RunFrame
+=================
+*/
+void G_RunRespawns (void)
+{
+	edict_t	*ent;
+	int		*link;
+	int		num;
+
+	if (respawn_dirty)
+		RespawnRebuild ();
+
+	link = &respawn_wheel[level.framenum % RESPAWN_WHEEL_SLOTS];
+	while ((num = *link) != 0)
+	{
+		if (respawn_due[num] > level.framenum)
+		{	// a later lap
+			link = &respawn_next[num];
+			continue;
+		}
+
+		*link = respawn_next[num];
+		respawn_due[num] = 0;
+		ent = g_edicts + num;
+		if (!ent->inuse || ent->think != DoRespawn || ent->nextthink <= 0)
+			continue;		// respawned or freed some other way
+		if (ent->nextthink > level.time + 0.001)
+		{	// put off since it was queued
+			RespawnQueue (ent);
+			continue;
+		}
+		ent->nextthink = 0;
+		DoRespawn (ent);
+	}
+}
+
+static respawnteam_t *RespawnTeam (edict_t *master)
+{
+	respawnteam_t	*team;
+	edict_t			*e;
+	int				count;
+
+	if (respawn_dirty)
+		RespawnRebuild ();
+
+	team = respawn_teams[master - g_edicts];
+	if (team)
+		return team;
+
+	for (count = 0, e = master; e; e = e->chain)
+		count++;
+	team = gi.TagMalloc (sizeof(respawnteam_t) + (count-1)*sizeof(edict_t *), TAG_LEVEL);
+	for (count = 0, e = master; e; e = e->chain)
+		team->members[count++] = e;
+	team->count = count;
+	respawn_teams[master - g_edicts] = team;
+	return team;
+}
+
 //======================================================================
 
 void DoRespawn (edict_t *ent)
@@ -181,8 +391,7 @@ void DoRespawn (edict_t *ent)
 	if (ent->team)
 	{
 		edict_t	*master;
-		int	count;
-		int choice;
+		respawnteam_t	*team;
 
 		master = ent->teammaster;
 
@@ -195,13 +404,8 @@ void DoRespawn (edict_t *ent)
 			ent = master;
 		else {
 //ZOID
-			for (count = 0, ent = master; ent; ent = ent->chain, count++)
-				;
-
-			choice = rand() % count;
-
-			for (count = 0, ent = master; count < choice; ent = ent->chain, count++)
-				;
+			team = RespawnTeam (master);
+			ent = team->members[rand() % team->count];
 		}
 	}
 
@@ -217,6 +421,10 @@ void DoRespawn (edict_t *ent)
 		ent->solid = SOLID_TRIGGER;
 	gi.linkentity (ent);
 
+// ACEBOT_ADD
+	ACEIT_ItemRespawned (ent);
+// ACEBOT_END
+
 	// send an effect
 	ent->s.event = EV_ITEM_RESPAWN;
 }
@@ -229,6 +437,11 @@ void SetRespawn (edict_t *ent, float delay)
 	ent->nextthink = level.time + delay;
 	ent->think = DoRespawn;
 	gi.linkentity (ent);
+	if (!respawn_dirty)
+		RespawnQueue (ent);
+// ACEBOT_ADD
+	ACEIT_ItemTaken (ent, delay);
+// ACEBOT_END
 }
 
 
@@ -710,7 +923,7 @@ qboolean Pickup_Ammo (edict_t *ent, edict_t *other)
 
 	if (weapon && !oldcount)
 	{
-		if (other->client->pers.weapon != ent->item && ( !deathmatch->value || other->client->pers.weapon == FindItem("blaster") || other->client->pers.weapon == FindItem("No weapon") ) )
+		if (other->client->pers.weapon != ent->item && ( !deathmatch->value || other->client->pers.weapon == &itemlist[blaster_index] || other->client->pers.weapon == &itemlist[noweapon_index] ) )
 			other->client->newweapon = ent->item;
 	}
 
@@ -1146,11 +1359,12 @@ edict_t *Drop_Item (edict_t *ent, gitem_t *item)
 	vec3_t	forward, right;
 	vec3_t	offset;
 
-	dropped = G_Spawn();
+	dropped = G_SpawnTagged("Drop_Item");
 
 	dropped->classname = item->classname;
 	dropped->item = item;
 	dropped->spawnflags = DROPPED_ITEM;
+	CTFTechAdded (dropped);
 	dropped->s.skinnum = item->world_model_skinnum; // Knightmare- skinnum specified in item table
 	dropped->s.effects = item->world_model_flags;
 	dropped->s.renderfx = RF_GLOW | RF_IR_VISIBLE;
@@ -1502,6 +1716,7 @@ void SpawnItem (edict_t *ent, gitem_t *item)
 	}
 
 	ent->item = item;
+	CTFTechAdded (ent);
 	ent->nextthink = level.time + 2 * FRAMETIME;    // items start after other solids
 	ent->think = droptofloor;
 	ent->s.skinnum = item->world_model_skinnum; //Knightmare- skinnum specified in item table
@@ -3151,6 +3366,31 @@ void SP_item_health_mega (edict_t *self)
 }
 
 
+/*
+===============
+KnownItemIndex
+
+FindItem for the table below, 0 if the item isn't built in
+===============
+*/
+static int KnownItemIndex (char *pickup_name)
+{
+	gitem_t	*it;
+
+	it = FindItem (pickup_name);
+	return it ? ITEM_INDEX(it) : 0;
+}
+
+/*
+===============
+InitItems
+
+Called by InitGame. itemlist never changes, so the indexes of the items
+the code asks for by name all the time (weapon switching, ammo checks,
+armor, the HUD) are looked up here once rather than with FindItem on
+every use. Index 0 is the empty first entry, which nobody ever holds.
+===============
+*/
 void InitItems (void)
 {
     int		i;
@@ -3164,6 +3404,50 @@ void InitItems (void)
         if (it->pickup_name)
             it->pickupHash = HashSanitized32(it->pickup_name);
     }
+
+	noweapon_index     = KnownItemIndex("No Weapon");
+	jacket_armor_index = KnownItemIndex("Jacket Armor");
+	combat_armor_index = KnownItemIndex("Combat Armor");
+	body_armor_index   = KnownItemIndex("Body Armor");
+	power_screen_index = KnownItemIndex("Power Screen");
+	power_shield_index = KnownItemIndex("Power Shield");
+	shells_index       = KnownItemIndex("shells");
+	bullets_index      = KnownItemIndex("bullets");
+	grenades_index     = KnownItemIndex("Grenades");
+	rockets_index      = KnownItemIndex("rockets");
+	cells_index        = KnownItemIndex("cells");
+	slugs_index        = KnownItemIndex("slugs");
+	fuel_index         = KnownItemIndex("fuel");
+	homing_index       = KnownItemIndex("homing missiles");
+	rl_index           = KnownItemIndex("rocket launcher");
+	hml_index          = KnownItemIndex("Homing Missile Launcher");
+	blaster_index      = KnownItemIndex("Blaster");
+	shotgun_index      = KnownItemIndex("Shotgun");
+	sshotgun_index     = KnownItemIndex("Super Shotgun");
+	machinegun_index   = KnownItemIndex("Machinegun");
+	chaingun_index     = KnownItemIndex("Chaingun");
+	gl_index           = KnownItemIndex("Grenade Launcher");
+	hyperblaster_index = KnownItemIndex("HyperBlaster");
+	railgun_index      = KnownItemIndex("Railgun");
+	bfg_index          = KnownItemIndex("BFG10K");
+	grapple_index      = KnownItemIndex("Grapple");
+	jetpack_index      = KnownItemIndex("Jetpack");
+	flashlight_index   = KnownItemIndex(FLASHLIGHT_ITEM);
+
+	memset (item_ammo_index, 0, sizeof(item_ammo_index));
+	for (i=0, it=itemlist ; i<game.num_items ; i++, it++)
+	{
+		if (it->ammo && it->ammo[0])
+			item_ammo_index[i] = KnownItemIndex(it->ammo);
+	}
+
+	Weapon_InitFrames ();
+
+	// the respawn wheel is allocated again by the first level
+	respawn_next = NULL;
+	respawn_due = NULL;
+	respawn_teams = NULL;
+	respawn_dirty = true;
 }
 
 
@@ -3185,23 +3469,6 @@ void SetItemNames (void)
 		it = &itemlist[i];
 		gi.configstring (CS_ITEMS+i, it->pickup_name);
 	}
-
-	noweapon_index     = ITEM_INDEX(FindItem("No Weapon"));
-	jacket_armor_index = ITEM_INDEX(FindItem("Jacket Armor"));
-	combat_armor_index = ITEM_INDEX(FindItem("Combat Armor"));
-	body_armor_index   = ITEM_INDEX(FindItem("Body Armor"));
-	power_screen_index = ITEM_INDEX(FindItem("Power Screen"));
-	power_shield_index = ITEM_INDEX(FindItem("Power Shield"));
-	shells_index       = ITEM_INDEX(FindItem("shells"));
-	bullets_index      = ITEM_INDEX(FindItem("bullets"));
-	grenades_index     = ITEM_INDEX(FindItem("Grenades"));
-	rockets_index      = ITEM_INDEX(FindItem("rockets"));
-	cells_index        = ITEM_INDEX(FindItem("cells"));
-	slugs_index        = ITEM_INDEX(FindItem("slugs"));
-	fuel_index         = ITEM_INDEX(FindItem("fuel"));
-	homing_index       = ITEM_INDEX(FindItem("homing missiles"));
-	rl_index           = ITEM_INDEX(FindItem("rocket launcher"));
-	hml_index          = ITEM_INDEX(FindItem("Homing Missile Launcher"));
 }
 
 /*
@@ -3213,7 +3480,7 @@ void Use_Flashlight ( edict_t *ent, gitem_t *item )
 {
 	if(!ent->client->flashlight)
 	{
-		if(ent->client->pers.inventory[ITEM_INDEX(FindItem(FLASHLIGHT_ITEM))] < level.flashlight_cost)
+		if(ent->client->pers.inventory[flashlight_index] < level.flashlight_cost)
 		{
 			safe_cprintf(ent,PRINT_HIGH,"Flashlight requires %s\n",FLASHLIGHT_ITEM);
 			return;
@@ -32,11 +32,24 @@ qboolean Jet_AvoidGround( edict_t *ent )
 
 /*Check if there is enough room above us before we change origin[2]*/
 
-	new_origin[0] = ent->s.origin[0];
-	new_origin[1] = ent->s.origin[1];
-	new_origin[2] = ent->s.origin[2] + 0.5;
-	trace = gi.trace( ent->s.origin, ent->mins, ent->maxs, new_origin, ent, MASK_PLAYERSOLID );
-	if ( (success=(trace.plane.normal[2]==0)) )
+	/*ClientThink runs for every usercmd, several per server frame, and
+	pmove usually puts us back on the same spot. Nothing that could be
+	a ceiling moves between frames, so reuse the probe from that spot.*/
+	if ( ent->client->jetpack_probe_framenum == level.framenum
+		&& VectorCompare(ent->client->jetpack_probe_origin, ent->s.origin) )
+		success = ent->client->jetpack_probe_clear;
+	else
+	{
+		new_origin[0] = ent->s.origin[0];
+		new_origin[1] = ent->s.origin[1];
+		new_origin[2] = ent->s.origin[2] + 0.5;
+		trace = gi.trace( ent->s.origin, ent->mins, ent->maxs, new_origin, ent, MASK_PLAYERSOLID );
+		success = (trace.plane.normal[2]==0);
+		ent->client->jetpack_probe_framenum = level.framenum;
+		VectorCopy( ent->s.origin, ent->client->jetpack_probe_origin );
+		ent->client->jetpack_probe_clear = success;
+	}
+	if ( success )
 		/*no ceiling?*/
 		ent->s.origin[2] += 0.5;
 		/*then make sure off ground*/
@@ -98,22 +111,24 @@ void Jet_ApplyLifting( edict_t *ent )
 		VectorCopy( new_origin, ent->s.origin );
 }
 
-/*This function applys some sparks to your jetpack*/
+/*This function applys some sparks to your jetpack, once a server frame:
+the client only sees one puff a frame however many usercmds came in*/
 
 void Jet_ApplySparks ( edict_t *ent )
 {
 	vec3_t  forward, right;
 	vec3_t  pack_pos, jet_vector;
+
+	if ( ent->client->jetpack_sparks_framenum == level.framenum )
+		return;
+	ent->client->jetpack_sparks_framenum = level.framenum;
+
 	AngleVectors(ent->client->v_angle, forward, right, NULL);
 	VectorScale (forward, -8, pack_pos);
 	VectorAdd (pack_pos, ent->s.origin, pack_pos);
 	pack_pos[2] += 6;
 	VectorScale (forward, -50, jet_vector);
-	gi.WriteByte (svc_temp_entity);
-	gi.WriteByte (TE_SPARKS);
-	gi.WritePosition (pack_pos);
-	gi.WriteDir (jet_vector);
-	gi.multicast (pack_pos, MULTICAST_PVS);
+	G_TempImpact (TE_SPARKS, pack_pos, jet_vector);
 
 	if(level.num_reflectors)
 		ReflectSparks(TE_SPARKS,pack_pos,jet_vector);
@@ -0,0 +1,275 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+
+/*
+==============================================================================
+
+LAG COMPENSATION
+
+A player aims at where the last frame they were sent showed everybody,
+which is their ping behind the server. With sv_lag_compensate set to
+the most milliseconds to make up, G_LagRecord keeps the box of every
+player and monster at the end of each of the last LAG_FRAMES frames,
+in the same 1/8 unit steps the network sends positions in.
+
+The hitscan weapons (fire_lead, fire_shotgun, fire_rail, fire_hit)
+put their traces between G_LagRewind, which puts everybody else back
+where the shooter saw them, and G_LagRestore. Their damage is applied
+after the restore, to the entities where they really are, so nothing
+dies or gibs in the past. Rewinds nest, so a shotgun blast rewinds
+once for all its pellets, and no more than LAG_REWINDS happen in one
+frame; after that, shots trace against the present as usual.
+
+An entity that moved itself while rewound (damage applied at once when
+a damage batch is full, say) is left where it went rather than put
+back, and one whose box changed keeps its new box. Bots have no ping
+and are never compensated.
+
+==============================================================================
+*/
+
+#define	LAG_FRAMES		10		// a second of history
+#define	LAG_REWINDS		64		// per frame
+
+typedef struct
+{
+	int			stamp;			// lag_stamp[] of the frame this was recorded in
+	short		origin[3];		// 1/8 units
+	short		mins[3], maxs[3];
+} lagspot_t;
+
+typedef struct
+{
+	edict_t		*ent;
+	vec3_t		origin, mins, maxs;		// where it really is
+	vec3_t		rewound[3];				// origin, mins and maxs it was given
+} lagmoved_t;
+
+static lagspot_t	*lag_history;		// game.maxentities * LAG_FRAMES
+static lagmoved_t	*lag_moved;			// game.maxentities
+static int			num_lag_moved;
+static int			lag_depth;
+static qboolean		lag_rewound;
+static int			lag_rewinds;		// this frame
+static int			lag_stamp[LAG_FRAMES];
+static float		lag_time[LAG_FRAMES];
+static int			lag_head;			// frame recorded last
+static int			lag_frames;			// frames of history kept
+static int			lag_count;
+
+static qboolean G_LagTracked (edict_t *ent)
+{
+	if (!ent->inuse || ent->solid == SOLID_NOT)
+		return false;
+	return (ent->client || (ent->svflags & SVF_MONSTER));
+}
+
+static void G_LagPack (vec3_t in, short *out)
+{
+	out[0] = (short)floor (in[0] * 8 + 0.5);
+	out[1] = (short)floor (in[1] * 8 + 0.5);
+	out[2] = (short)floor (in[2] * 8 + 0.5);
+}
+
+static void G_LagUnpack (short *in, vec3_t out)
+{
+	out[0] = in[0] * 0.125;
+	out[1] = in[1] * 0.125;
+	out[2] = in[2] * 0.125;
+}
+
+static qboolean G_LagSame (vec3_t v, short *packed)
+{
+	short	p[3];
+
+	G_LagPack (v, p);
+	return (p[0] == packed[0] && p[1] == packed[1] && p[2] == packed[2]);
+}
+
+/*
+=================
+G_LagRecord
+
+Called at the end of G_RunFrame, once everything has moved
+=================
+*/
+void G_LagRecord (void)
+{
+	lagspot_t	*spot;
+	edict_t		*ent;
+	int			i;
+
+	lag_rewinds = 0;
+	if (!sv_lag_compensate || sv_lag_compensate->value <= 0)
+	{
+		lag_frames = 0;
+		return;
+	}
+
+	if (!lag_history)
+	{
+		lag_history = gi.TagMalloc (game.maxentities * LAG_FRAMES * sizeof(lagspot_t), TAG_GAME);
+		lag_moved = gi.TagMalloc (game.maxentities * sizeof(lagmoved_t), TAG_GAME);
+	}
+
+	lag_head = (lag_head + 1) % LAG_FRAMES;
+	lag_stamp[lag_head] = ++lag_count;
+	lag_time[lag_head] = level.time;
+	if (lag_frames < LAG_FRAMES)
+		lag_frames++;
+
+	for (i=1, ent=g_edicts+i ; i<globals.num_edicts ; i++, ent++)
+	{
+		if (!G_LagTracked (ent))
+			continue;
+		spot = &lag_history[i*LAG_FRAMES + lag_head];
+		spot->stamp = lag_count;
+		G_LagPack (ent->s.origin, spot->origin);
+		G_LagPack (ent->mins, spot->mins);
+		G_LagPack (ent->maxs, spot->maxs);
+	}
+}
+
+/*
+=================
+G_LagRewind
+
+Moves every player and monster back to where shooter last saw them.
+Every call must be matched by a G_LagRestore.
+=================
+*/
+void G_LagRewind (edict_t *shooter)
+{
+	lagspot_t	*spot;
+	lagmoved_t	*moved;
+	edict_t		*ent;
+	int			i, ms, back, slot;
+
+	if (++lag_depth > 1)
+		return;			// already rewound for this shot
+	if (!lag_frames || !shooter->client || shooter->is_bot)
+		return;
+	if (lag_rewinds >= LAG_REWINDS)
+		return;
+
+	ms = min (shooter->client->ping, (int)sv_lag_compensate->value);
+	back = min ((ms + 50) / 100, lag_frames - 1);	// whole frames
+	if (back <= 0)
+		return;
+	slot = (lag_head - back + LAG_FRAMES) % LAG_FRAMES;
+	lag_rewinds++;
+
+	num_lag_moved = 0;
+	for (i=1, ent=g_edicts+i ; i<globals.num_edicts ; i++, ent++)
+	{
+		if (ent == shooter || !G_LagTracked (ent))
+			continue;
+		spot = &lag_history[i*LAG_FRAMES + slot];
+		if (spot->stamp != lag_stamp[slot])
+			continue;			// wasn't there then
+		if (ent->freetime > lag_time[slot])
+			continue;			// a different entity now
+		if (G_LagSame (ent->s.origin, spot->origin)
+			&& G_LagSame (ent->mins, spot->mins) && G_LagSame (ent->maxs, spot->maxs))
+			continue;
+
+		moved = &lag_moved[num_lag_moved++];
+		moved->ent = ent;
+		VectorCopy (ent->s.origin, moved->origin);
+		VectorCopy (ent->mins, moved->mins);
+		VectorCopy (ent->maxs, moved->maxs);
+		G_LagUnpack (spot->origin, moved->rewound[0]);
+		G_LagUnpack (spot->mins, moved->rewound[1]);
+		G_LagUnpack (spot->maxs, moved->rewound[2]);
+
+		VectorCopy (moved->rewound[0], ent->s.origin);
+		VectorCopy (moved->rewound[1], ent->mins);
+		VectorCopy (moved->rewound[2], ent->maxs);
+		gi.linkentity (ent);
+	}
+	lag_rewound = true;
+}
+
+/*
+=================
+G_LagRestore
+
+Undoes G_LagRewind
+=================
+*/
+void G_LagRestore (void)
+{
+	lagmoved_t	*moved;
+	edict_t		*ent;
+	int			i;
+
+	if (lag_depth <= 0 || --lag_depth > 0)
+		return;
+	if (!lag_rewound)
+		return;
+
+	for (i=0, moved=lag_moved ; i<num_lag_moved ; i++, moved++)
+	{
+		ent = moved->ent;
+		if (!ent->inuse || !VectorCompare (ent->s.origin, moved->rewound[0]))
+			continue;
+		VectorCopy (moved->origin, ent->s.origin);
+		if (VectorCompare (ent->mins, moved->rewound[1]) && VectorCompare (ent->maxs, moved->rewound[2]))
+		{
+			VectorCopy (moved->mins, ent->mins);
+			VectorCopy (moved->maxs, ent->maxs);
+		}
+		gi.linkentity (ent);
+	}
+	num_lag_moved = 0;
+	lag_rewound = false;
+}
+
+/*
+=================
+G_InitLagComp
+
+Called from InitGame. G_LagRecord allocates the history again.
+=================
+*/
+void G_InitLagComp (void)
+{
+	lag_history = NULL;
+	lag_moved = NULL;
+	G_LagReset ();
+}
+
+/*
+=================
+G_LagReset
+
+Forgets the history when a level is spawned or loaded
+=================
+*/
+void G_LagReset (void)
+{
+	lag_frames = 0;
+	num_lag_moved = 0;
+	lag_depth = 0;
+	lag_rewound = false;
+}
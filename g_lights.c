@@ -20,6 +20,181 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "g_local.h"
+
+/*
+==============================================================================
+
+LIGHTSTYLE QUEUE
+
+Lightstyles set with G_SetLightStyle from G_BeginLightStyles at the top
+of G_RunFrame until the end of ClientEndServerFrames are held and sent
+once then, like the temp events in g_tempent.c. A style set several
+times in a frame only sends its last value, and a style set to the
+string it already holds sends nothing. A master target_lightswitch or a
+chain of light toggles that used to send a configstring per light per
+trigger now sends each style that really changed, once.
+
+What was last sent is forgotten when a level is spawned or loaded, so
+the first value after that is always sent. Styles set outside a frame
+(SpawnEntities) go out straight away.
+
+==============================================================================
+*/
+
+typedef struct
+{
+	qboolean	known;				// sent holds what clients have
+	qboolean	queued;
+	char		sent[MAX_QPATH];
+	char		value[MAX_QPATH];
+} lightstyle_t;
+
+static lightstyle_t	lightstyles[MAX_LIGHTSTYLES];
+static lightstyle_t	spawn_lightstyles[MAX_LIGHTSTYLES];	// for RestartLevel
+static int			queued_styles[MAX_LIGHTSTYLES];
+static int			num_queued_styles;
+static qboolean		lightstyle_queueing;
+
+static void G_SendLightStyle (int style, char *value)
+{
+	lightstyle_t	*ls = &lightstyles[style];
+
+	if (ls->known && !strcmp(ls->sent, value))
+		return;
+	gi.configstring (CS_LIGHTS+style, value);
+	Q_strncpyz (ls->sent, value, sizeof(ls->sent));
+	ls->known = true;
+}
+
+/*
+=================
+G_SetLightStyle
+
+Use instead of gi.configstring(CS_LIGHTS+style, value)
+=================
+*/
+void G_SetLightStyle (int style, char *value)
+{
+	lightstyle_t	*ls;
+
+	if (style < 0 || style >= MAX_LIGHTSTYLES || strlen(value) >= MAX_QPATH)
+	{
+		if (style >= 0 && style < MAX_LIGHTSTYLES)
+			lightstyles[style].known = false;
+		gi.configstring (CS_LIGHTS+style, value);
+		return;
+	}
+
+	if (!lightstyle_queueing)
+	{
+		G_SendLightStyle (style, value);
+		return;
+	}
+
+	ls = &lightstyles[style];
+	Q_strncpyz (ls->value, value, sizeof(ls->value));
+	if (!ls->queued)
+	{
+		ls->queued = true;
+		queued_styles[num_queued_styles++] = style;
+	}
+}
+
+/*
+=================
+G_LightStyle
+
+The value style will have at the end of this frame, or NULL if that
+isn't known
+=================
+*/
+char *G_LightStyle (int style)
+{
+	lightstyle_t	*ls;
+
+	if (style < 0 || style >= MAX_LIGHTSTYLES)
+		return NULL;
+	ls = &lightstyles[style];
+	if (ls->queued)
+		return ls->value;
+	return ls->known ? ls->sent : NULL;
+}
+
+/*
+=================
+G_BeginLightStyles
+
+Called at the top of G_RunFrame
+=================
+*/
+void G_BeginLightStyles (void)
+{
+	lightstyle_queueing = true;
+}
+
+/*
+=================
+G_FlushLightStyles
+
+Called at the end of ClientEndServerFrames
+=================
+*/
+void G_FlushLightStyles (void)
+{
+	lightstyle_t	*ls;
+	int				i;
+
+	for (i=0; i<num_queued_styles; i++)
+	{
+		ls = &lightstyles[queued_styles[i]];
+		ls->queued = false;
+		G_SendLightStyle (queued_styles[i], ls->value);
+	}
+	num_queued_styles = 0;
+	lightstyle_queueing = false;
+}
+
+/*
+=================
+G_ResetLightStyles
+
+Called from SpawnEntities and ReadLevel
+=================
+*/
+void G_ResetLightStyles (void)
+{
+	memset (lightstyles, 0, sizeof(lightstyles));
+	num_queued_styles = 0;
+}
+
+/*
+=================
+G_SaveSpawnLightStyles / G_RestoreSpawnLightStyles
+
+Remember the styles the map spawned with, and set every one that has
+changed since back again
+=================
+*/
+void G_SaveSpawnLightStyles (void)
+{
+	memcpy (spawn_lightstyles, lightstyles, sizeof(lightstyles));
+}
+
+void G_RestoreSpawnLightStyles (void)
+{
+	char	*value;
+	int		i;
+
+	for (i=0; i<MAX_LIGHTSTYLES; i++)
+	{
+		if (!spawn_lightstyles[i].known)
+			continue;
+		value = G_LightStyle (i);
+		if (!value || strcmp(value, spawn_lightstyles[i].sent))
+			G_SetLightStyle (i, spawn_lightstyles[i].sent);
+	}
+}
+
 //==========================================================
 
 void Lights()
@@ -27,56 +202,56 @@ void Lights()
 	if (lights->value)
 	{
 		// 0 normal
-		gi.configstring(CS_LIGHTS+0, "m");
+		G_SetLightStyle(0, "m");
 		// 1 FLICKER (first variety)
-		gi.configstring(CS_LIGHTS+1, "mmnmmommommnonmmonqnmmo");
+		G_SetLightStyle(1, "mmnmmommommnonmmonqnmmo");
 		// 2 SLOW STRONG PULSE
-		gi.configstring(CS_LIGHTS+2, "abcdefghijklmnopqrstuvwxyzyxwvutsrqponmlkjihgfedcba");
+		G_SetLightStyle(2, "abcdefghijklmnopqrstuvwxyzyxwvutsrqponmlkjihgfedcba");
 		// 3 CANDLE (first variety)
-		gi.configstring(CS_LIGHTS+3, "mmmmmaaaaammmmmaaaaaabcdefgabcdefg");
+		G_SetLightStyle(3, "mmmmmaaaaammmmmaaaaaabcdefgabcdefg");
 		// 4 FAST STROBE
-		gi.configstring(CS_LIGHTS+4, "mamamamamama");
+		G_SetLightStyle(4, "mamamamamama");
 		// 5 GENTLE PULSE 1
-		gi.configstring(CS_LIGHTS+5,"jklmnopqrstuvwxyzyxwvutsrqponmlkj");
+		G_SetLightStyle(5,"jklmnopqrstuvwxyzyxwvutsrqponmlkj");
 		// 6 FLICKER (second variety)
-		gi.configstring(CS_LIGHTS+6, "nmonqnmomnmomomno");
+		G_SetLightStyle(6, "nmonqnmomnmomomno");
 		// 7 CANDLE (second variety)
-		gi.configstring(CS_LIGHTS+7, "mmmaaaabcdefgmmmmaaaammmaamm");
+		G_SetLightStyle(7, "mmmaaaabcdefgmmmmaaaammmaamm");
 		// 8 CANDLE (third variety)
-		gi.configstring(CS_LIGHTS+8, "mmmaaammmaaammmabcdefaaaammmmabcdefmmmaaaa");
+		G_SetLightStyle(8, "mmmaaammmaaammmabcdefaaaammmmabcdefmmmaaaa");
 		// 9 SLOW STROBE (fourth variety)
-		gi.configstring(CS_LIGHTS+9, "aaaaaaaazzzzzzzz");
+		G_SetLightStyle(9, "aaaaaaaazzzzzzzz");
 		// 10 FLUORESCENT FLICKER
-		gi.configstring(CS_LIGHTS+10, "mmamammmmammamamaaamammma");
+		G_SetLightStyle(10, "mmamammmmammamamaaamammma");
 		// 11 SLOW PULSE NOT FADE TO BLACK
-		gi.configstring(CS_LIGHTS+11, "abcdefghijklmnopqrrqponmlkjihgfedcba");
+		G_SetLightStyle(11, "abcdefghijklmnopqrrqponmlkjihgfedcba");
 	}
 	else
 	{
 		// 0 normal
-		gi.configstring(CS_LIGHTS+0, lightsmin->string);
+		G_SetLightStyle(0, lightsmin->string);
 		// 1 FLICKER (first variety)
-		gi.configstring(CS_LIGHTS+1, lightsmin->string);
+		G_SetLightStyle(1, lightsmin->string);
 		// 2 SLOW STRONG PULSE
-		gi.configstring(CS_LIGHTS+2, lightsmin->string);
+		G_SetLightStyle(2, lightsmin->string);
 		// 3 CANDLE (first variety)
-		gi.configstring(CS_LIGHTS+3, lightsmin->string);
+		G_SetLightStyle(3, lightsmin->string);
 		// 4 FAST STROBE
-		gi.configstring(CS_LIGHTS+4, lightsmin->string);
+		G_SetLightStyle(4, lightsmin->string);
 		// 5 GENTLE PULSE 1
-		gi.configstring(CS_LIGHTS+5, lightsmin->string);
+		G_SetLightStyle(5, lightsmin->string);
 		// 6 FLICKER (second variety)
-		gi.configstring(CS_LIGHTS+6, lightsmin->string);
+		G_SetLightStyle(6, lightsmin->string);
 		// 7 CANDLE (second variety)
-		gi.configstring(CS_LIGHTS+7, lightsmin->string);
+		G_SetLightStyle(7, lightsmin->string);
 		// 8 CANDLE (third variety)
-		gi.configstring(CS_LIGHTS+8, lightsmin->string);
+		G_SetLightStyle(8, lightsmin->string);
 		// 9 SLOW STROBE (fourth variety)
-		gi.configstring(CS_LIGHTS+9, lightsmin->string);
+		G_SetLightStyle(9, lightsmin->string);
 		// 10 FLUORESCENT FLICKER
-		gi.configstring(CS_LIGHTS+10,lightsmin->string);
+		G_SetLightStyle(10,lightsmin->string);
 		// 11 SLOW PULSE NOT FADE TO BLACK
-		gi.configstring(CS_LIGHTS+11,lightsmin->string);
+		G_SetLightStyle(11,lightsmin->string);
 	}
 }
 
@@ -101,6 +101,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define FL_REVOLVING            0x00100000	// Lazarus revolving door
 #define FL_ROBOT				0x00200000	// Player-controlled robot or monster. Relax yaw constraints
 #define FL_REFLECT              0x00400000	// Reflection entity
+#define FL_PROJECTILE           0x00800000	// moved by G_RunProjectiles
+#define FL_CORPSE               0x01000000	// on the corpse list, see M_AddCorpse
 
 #define FL_RESPAWN				0x80000000	// used for item respawning
 
@@ -113,7 +115,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define MELEE_DISTANCE	80
 
-#define BODY_QUEUE_SIZE		8
+#define BODY_QUEUE_SIZE		8		// default for sv_bodyque
+#define MAX_BODY_QUEUE		64
 
 typedef enum
 {
@@ -441,6 +444,7 @@ typedef struct
 
 	edict_t		*current_entity;	// entity running from G_RunFrame
 	int			body_que;			// dead bodies
+	int			body_que_size;		// sv_bodyque when the level started
 
 	int			power_cubes;		// ugly necessity for coop
 
@@ -653,6 +657,18 @@ extern	int fuel_index;
 extern	int	homing_index;
 extern	int	rl_index;
 extern	int	hml_index;
+extern	int	blaster_index;
+extern	int	shotgun_index;
+extern	int	sshotgun_index;
+extern	int	machinegun_index;
+extern	int	chaingun_index;
+extern	int	gl_index;
+extern	int	hyperblaster_index;
+extern	int	railgun_index;
+extern	int	bfg_index;
+extern	int	grapple_index;
+extern	int	jetpack_index;
+extern	int	flashlight_index;
 
 // means of death
 #define MOD_UNKNOWN			0
@@ -733,6 +749,7 @@ extern	cvar_t	*g_select_empty;
 extern	cvar_t	*dedicated;
 
 extern	cvar_t	*filterban;
+extern	cvar_t	*maxipfilters;
 
 extern	cvar_t	*sv_gravity;
 extern	cvar_t	*sv_maxvelocity;
@@ -795,6 +812,7 @@ extern	cvar_t	*lazarus_joyp;
 extern	cvar_t	*lazarus_joyy;
 extern	cvar_t	*lazarus_pitch;
 extern	cvar_t	*lazarus_yaw;
+extern	cvar_t	*lightramp_step;
 extern	cvar_t	*lights;
 extern	cvar_t	*lightsmin;
 extern	cvar_t	*m_pitch;
@@ -804,7 +822,22 @@ extern	cvar_t	*readout;
 extern	cvar_t	*rocket_strafe;
 extern	cvar_t	*rotate_distance;
 extern	cvar_t	*shift_distance;
+extern	cvar_t	*sv_async_save;
+extern	cvar_t	*sv_bodyque;
+extern	cvar_t	*sv_compress_save;
+extern	cvar_t	*sv_delta_save;
+extern	cvar_t	*sv_frame_budget;
+extern	cvar_t	*sv_gib_pool;
+extern	cvar_t	*sv_lag_compensate;
+extern	cvar_t	*sv_level_report;
+extern	cvar_t	*sv_telemetry;
+extern	cvar_t	*sv_telemetry_prefix;
+extern	cvar_t	*sv_toss_substeps;
+extern	cvar_t	*sv_trace_cache;
+extern	cvar_t	*sv_vehicle_substeps;
 extern	cvar_t	*sv_maxgibs;
+extern	cvar_t	*sv_monster_lod;
+extern	cvar_t	*sv_monster_lod_dist;
 extern  cvar_t  *tpp;			  // third person perspective
 extern	cvar_t	*tpp_auto;
 extern	cvar_t	*turn_rider;
@@ -882,6 +915,9 @@ extern	spawn_t	spawns[];
 // g_ai.c
 //
 void AI_SetSightClient (void);
+void AI_InitSightCache (void);
+void AI_ClearSightCache (void);
+qboolean AI_CachedVisible (edict_t *self, edict_t *other);
 void ai_stand (edict_t *self, float dist);
 void ai_move (edict_t *self, float dist);
 void ai_walk (edict_t *self, float dist);
@@ -902,6 +938,7 @@ qboolean ai_chicken (edict_t *ent, edict_t *badguy);
 // km_cvar.c
 //
 void lithium_defaults(void);  //init cvar defaults
+void KM_RefreshCvars (qboolean all);
 
 //
 // g_camera.c
@@ -912,6 +949,9 @@ void camera_off(edict_t *ent);
 void faker_animate(edict_t *self);
 edict_t *G_FindNextCamera (edict_t *camera, edict_t *monitor);
 edict_t *G_FindPrevCamera (edict_t *camera, edict_t *monitor);
+edict_t *GetCamPlayer (edict_t *player);
+void PoolCamPlayer (edict_t *player, edict_t *faker);
+void RestoreCamPlayers (void);
 
 //
 // g_chase.c
@@ -924,9 +964,13 @@ void GetChaseTarget(edict_t *ent);
 // g_combat.c
 //
 qboolean OnSameTeam (edict_t *ent1, edict_t *ent2);
+void ClientSetTeams (edict_t *ent, char *userinfo);
+void G_InitClientCommands (void);
 qboolean CanDamage (edict_t *targ, edict_t *inflictor);
 qboolean CheckTeamDamage (edict_t *targ, edict_t *attacker);
 void T_Damage (edict_t *targ, edict_t *inflictor, edict_t *attacker, vec3_t dir, vec3_t point, vec3_t normal, int damage, int knockback, int dflags, int mod);
+void T_DamageBatchBegin (void);
+void T_DamageBatchEnd (void);
 void T_RadiusDamage (edict_t *inflictor, edict_t *attacker, float damage, edict_t *ignore, float radius, int mod, double dmg_slope);
 void Killed (edict_t *targ, edict_t *inflictor, edict_t *attacker, int damage, vec3_t point);
 void cleanupHealTarget (edict_t *ent);
@@ -962,6 +1006,10 @@ void ShiftItem(edict_t *ent, int direction);
 void G_FindCraneParts();
 void crane_control_action(edict_t *crane, edict_t *activator, vec3_t point);
 void Moving_Speaker_Think(edict_t *ent);
+void G_AttachSpeaker (edict_t *speaker);
+void G_InitAttachedSounds (void);
+void G_ResetAttachedSounds (void);
+void G_UpdateAttachedSounds (void);
 //
 // g_fog.c
 //
@@ -990,6 +1038,10 @@ qboolean box_walkmove (edict_t *ent, float yaw, float dist);
 void button_use (edict_t *self, edict_t *other, edict_t *activator);
 void trainbutton_use (edict_t *self, edict_t *other, edict_t *activator);
 void movewith_init (edict_t *self);
+void movewith_link (edict_t *prev, edict_t *next);
+void movewith_unlink (edict_t *ent);
+void movewith_initgame (void);
+void movewith_reset (void);
 void set_child_movement(edict_t *self);
 //
 // g_items.c
@@ -1003,12 +1055,15 @@ gitem_t	*FindItemByClassname (char *classname);
 #define	ITEM_INDEX(x) ((x)-itemlist)
 edict_t *Drop_Item (edict_t *ent, gitem_t *item);
 void SetRespawn (edict_t *ent, float delay);
+void G_ResetRespawns (void);
+void G_RunRespawns (void);
 void ChangeWeapon (edict_t *ent);
 void SpawnItem (edict_t *ent, gitem_t *item);
 void Think_Weapon (edict_t *ent);
 int ArmorIndex (edict_t *ent);
 int PowerArmorType (edict_t *ent);
 gitem_t	*GetItemByIndex (int index);
+int		ItemAmmoIndex (gitem_t *item);
 qboolean Add_Ammo (edict_t *ent, gitem_t *item, int count);
 void Touch_Item (edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf);
 
@@ -1025,6 +1080,13 @@ void Jet_BecomeExplosion( edict_t *ent, int damage );
 //
 // g_lights.c
 //
+void G_SetLightStyle (int style, char *value);
+char *G_LightStyle (int style);
+void G_BeginLightStyles (void);
+void G_FlushLightStyles (void);
+void G_ResetLightStyles (void);
+void G_SaveSpawnLightStyles (void);
+void G_RestoreSpawnLightStyles (void);
 void Lights();
 void ToggleLights();
 //
@@ -1044,6 +1106,9 @@ void EndDMLevel (void);
 void ThrowHead (edict_t *self, char *gibname, int damage, int type);
 void ThrowClientHead (edict_t *self, int damage);
 void ThrowGib (edict_t *self, char *gibname, int damage, int type);
+void gib_pool_reset (void);
+void target_string_initgame (void);
+void target_string_reset (void);
 void BecomeExplosion1(edict_t *self);
 void barrel_delay (edict_t *self, edict_t *inflictor, edict_t *attacker, int damage, vec3_t point);
 void barrel_explode (edict_t *self);
@@ -1090,30 +1155,198 @@ void M_FliesOn (edict_t *self);
 void M_CheckGround (edict_t *ent);
 qboolean M_SetDeath (edict_t *ent,mmove_t **moves);
 int  PatchMonsterModel (char *model);
+void M_RemoveCorpse (edict_t *self);
+void M_ResetCorpses (void);
+int  M_Corpses (edict_t ***list);
+//
+// g_pak.c
+//
+typedef struct
+{
+	void	*dir;		// owning pak folder
+	int		pak;		// pak number, 0-9
+	int		start;		// offset in the pak file
+	int		size;		// bytes
+} pakentry_t;
+void	Pak_Init (void);
+void	Pak_Shutdown (void);
+void	Pak_GameDir (char *output, int size);
+qboolean Pak_FindFile (const char *path, const char *name, pakentry_t *entry);
+FILE	*Pak_OpenFile (pakentry_t *entry);
+byte	*Pak_LoadFile (const char *path, const char *name, int *size, int extra);
+//
+// g_profile.c
+//
+typedef enum
+{
+	PROF_FRAME,
+	PROF_PHYS_PUSH,
+	PROF_PHYS_NONE,
+	PROF_PHYS_NOCLIP,
+	PROF_PHYS_STEP,
+	PROF_PHYS_TOSS,
+	PROF_PHYS_DEBRIS,
+	PROF_PHYS_VEHICLE,
+	PROF_PHYS_CONVEYOR,
+	PROF_CLIENTTHINK,
+	PROF_ENDFRAMES,
+	PROF_REFLECT,
+	PROF_DAMAGE,
+	PROF_BOTTHINK,
+	PROF_BOTNODES,
+	PROF_NUMSECTIONS
+} profsection_t;
+extern	qboolean	prof_active;
+void	Prof_Begin (int section);
+void	Prof_End (int section);
+int		Prof_PhysSection (int movetype);
+void	Prof_BeginFrame (void);
+void	Prof_CountTrace (void);
+void	Prof_CountLink (void);
+void	Prof_CountLinkSkip (void);
+void	Prof_CountMulticast (void);
+void	Prof_CountAlloc (void);
+void	Prof_CountFree (void);
+void	Prof_Shutdown (void);
+void	Svcmd_Profile_f (void);
+double	Prof_Seconds (void);
+void	Rep_Think (edict_t *ent);
+void	Rep_CountSave (int msec);
+void	Rep_BeginLevel (float msec, qboolean loaded);
+void	Rep_EndLevel (void);
+extern	int			gov_level;
+void	Gov_BeginFrame (void);
+void	Gov_EndFrame (void);
+void	Gov_Reset (void);
+float	Gov_FrameMsec (void);
+float	Gov_Scale (void);
+float	Gov_Lifetime (float time);
+float	Gov_Interval (float time);
+qboolean Gov_SkipFrame (void);
+//
+// g_trace.c
+//
+// One trace for G_TraceBatch. A Q2VR engine that exports TraceBatch
+// defines GAME_TRACEBATCH and the same struct in game.h.
+#ifndef GAME_TRACEBATCH
+typedef struct
+{
+	float		*start;
+	float		*mins;		// NULL for a point
+	float		*maxs;
+	float		*end;
+	edict_t		*passent;
+	int			contentmask;
+} tracerequest_t;
+#endif
+void	G_InitTraceHooks (void);
+void	G_SetTraceBatch (void (*batch) (tracerequest_t *requests, trace_t *results, int count));
+qboolean G_TraceBatchAvailable (void);
+void	G_TraceBatch (tracerequest_t *requests, trace_t *results, int count);
+void	G_ClearTraceCache (void);
+void	G_ClearLinkCache (void);
+void	G_ClearContentsCache (void);
+int		G_EnvContents (vec3_t p);
+#define	WATERCACHE_MONSTER	1	// M_CatagorizePosition
+#define	WATERCACHE_SWIM		2	// SV_Physics_Step, FL_SWIM non-monsters
+qboolean G_WaterLevelKnown (edict_t *ent, int kind);
+void	G_StoreWaterLevel (edict_t *ent, int kind);
+void	G_ClearIndexCache (void);
+void	Svcmd_TraceStats_f (void);
+int		G_TraceTotal (void);
+void	G_MessageStats (int *bytes, int *sends);
+//
+// g_telemetry.c
+//
+void	Tel_BeginFrame (void);
+void	Tel_EndFrame (void);
+void	Tel_CountSave (int msec);
+void	Tel_Shutdown (void);
+//
+// g_cmdlog.c
+//
+void	CmdLog_LevelStart (char *mapname);
+qboolean CmdLog_ClientThink (edict_t *ent, usercmd_t *ucmd);
+void	CmdLog_ClientDisconnect (edict_t *ent);
+qboolean CmdLog_Replaying (void);
+void	CmdLog_RunFrame (void);
+void	CmdLog_Shutdown (void);
+void	Svcmd_CmdLog_f (void);
+//
+// g_lagcomp.c
+//
+void	G_InitLagComp (void);
+void	G_LagRecord (void);
+void	G_LagRewind (edict_t *shooter);
+void	G_LagRestore (void);
+void	G_LagReset (void);
+//
+// g_tempent.c
+//
+void	G_TempPoint (int type, vec3_t origin, multicast_t to);
+void	G_TempImpact (int type, vec3_t origin, vec3_t dir);
+void	G_TempSplash (int type, int count, vec3_t origin, vec3_t dir, int color);
+void	G_TempTrail (int type, vec3_t start, vec3_t end, vec3_t origin, multicast_t to);
+void	G_BeginMirroredTemps (void);
+void	G_EndMirroredTemps (void);
+void	G_BeginTempEvents (void);
+void	G_FlushTempEvents (void);
 //
 // g_patchplayermodels.c
 //
 int PatchPlayerModels (char *modelname);
+qboolean PatchedModel_Checked (char *outfilename);
+qboolean PatchedModel_Valid (char *outfilename, int numskins, char *skins, int skinsize);
+qboolean PatchedModel_Write (char *outfilename, dmdl_t *model, char *skins, int skinsize, byte *data, int datasize);
 //
 // g_phys.c
 //
 void SV_AddGravity (edict_t *ent);
 void G_RunEntity (edict_t *ent);
+void SV_Physics_Missile (edict_t *ent);
 //
 // g_reflect.c
 //
 void AddReflection (edict_t *ent);
+void UpdateReflectGrid (void);
 void DeleteReflection (edict_t *ent, int index);
+void InitReflections (void);
+void RestoreReflections (void);
 void ReflectExplosion (int type, vec3_t origin);
 void ReflectSparks (int type, vec3_t origin, vec3_t movedir);
 void ReflectSteam (vec3_t origin,vec3_t movedir,int count,int sounds,int speed, int wait, int nextid);
 void ReflectTrail (int type, vec3_t start, vec3_t end);
+//
+// g_save.c
+//
+void WaitForSave (void);
+void SaveLevelBaseline (void);
+void SaveLevelRestart (void);
+qboolean RestartLevel (void);
+void BeginTransitionEdicts (void);
+void WriteTransitionImage (edict_t *ent);
+qboolean OpenTransitionEdicts (void);
+void ReadTransitionEdict (edict_t *ent);
+void CloseTransitionEdicts (void);
+char *GetFunctionNameNear (byte *adr, int *offset);
 
 
 //
 // g_spawn.c
 //
 void ED_CallSpawn (edict_t *ent);
+void ED_InitSpawnTable (void);
+qboolean ED_FindSpawn (char *classname, gitem_t **item, spawn_t **spawn);
+void ED_ResetUnknownClassnames (void);
+void ED_SpawnPrototype (edict_t *ent);
+void ED_ResetSpawnPrototypes (void);
+char *ED_InternString (const char *s);
+unsigned int ED_StringHash (const char *s);
+void ED_ResetStrings (void);
+void G_ResetLevelCaches (void);
+void ED_InitFieldTable (void);
+void ED_ParseAliasData (void);
+void ED_FreeEntityAliases (void);
 void G_FindTeams();
 void Cmd_ToggleHud ();
 void Hud_On();
@@ -1127,15 +1360,19 @@ int SV_FilterPacket (char *from);
 // g_thing.c
 //
 edict_t *SpawnThing();
+void FreeThing (edict_t *self);
+void thing_pool_reset (void);
 //
 // g_tracktrain.c
 //
 void tracktrain_disengage (edict_t *train);
+void G_ResetPathTracks (void);
 //
 // g_turret.c
 //
 void turret_breach_fire(edict_t *ent);
 void turret_disengage (edict_t *ent);
+void turret_reset_targets (void);
 //
 // g_trigger.c
 //
@@ -1144,26 +1381,100 @@ typedef struct
 	char	*name;
 } entlist_t;
 qboolean HasSpawnFunction(edict_t *ent);
+void trigger_push_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf);
 int trigger_transition_ents (edict_t *changelevel, edict_t *self);
+void trans_ent_filename (char *filename);
+void G_TriggerLinkEvent (edict_t *ent);
+void trigger_switch_usetargets (edict_t *ent, edict_t *activator);
+void G_ResetTriggerWatches (void);
+extern	int	trigger_link_count;
 //
 // g_utils.c
 //
 qboolean	KillBox (edict_t *ent);
 void	G_ProjectSource (vec3_t point, vec3_t distance, vec3_t forward, vec3_t right, vec3_t result);
 edict_t *G_Find (edict_t *from, int fieldofs, char *match);
+void	G_ClearEdictIndexes (void);
+void	G_IndexEdict (edict_t *ent);
+void	G_UnindexEdict (edict_t *ent);
+void	G_RefreshEdictIndexes (void);
 edict_t *findradius (edict_t *from, vec3_t org, float rad);
+int		G_FindRadiusBatch (vec3_t org, float rad, edict_t **list, int maxcount);
+typedef struct
+{
+	edict_t		*ent;
+	float		fraction;		// where the segment enters its box
+	vec3_t		endpos;
+	vec3_t		normal;
+} segmenthit_t;
+int		G_SegmentHits (vec3_t start, vec3_t end, edict_t *passent, int contentmask, segmenthit_t *hits, int maxhits);
+void	G_ResetClientPVS (void);
+int		G_ClientsInPVS (edict_t *ent, byte *mask);
+qboolean G_ClientSeesEntity (edict_t *ent, int n);
 edict_t *G_PickTarget (char *targetname);
+edict_t *G_PickRoute (edict_t *ent);
 void	G_UseTargets (edict_t *ent, edict_t *activator);
+
+#define	DELAY_USETARGETS	0		// G_UseTargets
+#define	DELAY_USETARGET		1		// G_UseTarget, on target_ent
+#define	DELAY_SWITCH		2		// trigger_switch_usetargets
+
+typedef struct
+{
+	float		time;			// when it fires
+	int			seq;
+	int			kind;			// DELAY_*
+	edict_t		*activator;
+	edict_t		*target_ent;
+	char		*message;
+	char		*target;
+	char		*killtarget;
+	int			noise_index;
+} delayeduse_t;
+
+void	G_DelayUse (int kind, edict_t *ent, edict_t *activator, edict_t *target);
+void	G_RestoreDelayedUse (delayeduse_t *d);
+int		G_DelayedUses (delayeduse_t **list);
+void	G_RunDelayedUses (void);
+void	G_ResetDelayedUses (void);
 void	G_SetMovedir (vec3_t angles, vec3_t movedir);
 void	G_InitEdict (edict_t *e);
 edict_t	*G_Spawn (void);
+edict_t	*G_SpawnTagged (char *site);
+int		G_EdictSerial (void);
+void	G_ResetFreeEdicts (void);
+void	G_InitEdictLists (void);
+void	Svcmd_EdictStats_f (void);
+void	Svcmd_Edicts_f (void);
+void	Svcmd_PushStats_f (void);
 void	G_FreeEdict (edict_t *e);
 void	G_TouchTriggers (edict_t *ent);
+void	G_ClientTouchTriggers (edict_t *ent);
+void	G_ClearFrameTouches (void);
 void	G_TouchSolids (edict_t *ent);
 char	*G_CopyString (const char *in);
 void    *G_Malloc (int32_t size);
 void    G_Free(void * block);
 
+// fixed-size objects carved out of the level arena, see g_utils.c
+typedef struct gpool_s
+{
+	char			*name;
+	int				size;			// of one object
+	int				perchunk;		// objects carved out at a time
+	void			*free;
+	int				inuse, capacity, peak;
+	qboolean		registered;
+	struct gpool_s	*next;
+} gpool_t;
+
+void	*G_LevelAlloc (int size);
+char	*G_LevelString (const char *in);
+void	*G_PoolAlloc (gpool_t *pool);
+void	G_PoolFree (gpool_t *pool, void *p);
+void	G_ResetLevelArena (void);
+void	G_ArenaStats (void);
+
 void	stuffcmd(edict_t *ent,char *command);
 float	*tv (float x, float y, float z);
 char	*vtos (vec3_t v);
@@ -1207,6 +1518,10 @@ void fire_rail_alt (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int
 void fire_bfg (edict_t *self, vec3_t start, vec3_t dir, int damage, int speed, float damage_radius);
 qboolean AimGrenade (edict_t *launcher, vec3_t start, vec3_t target, vec_t speed, vec3_t aim);
 void Grenade_Evade (edict_t *monster);
+void G_InitProjectiles (void);
+void G_ResetProjectiles (void);
+void G_AddProjectile (edict_t *ent);
+void G_RunProjectiles (void);
 //
 // m_actor.c
 //
@@ -1244,6 +1559,8 @@ void medic_StopPatrolling(edict_t *ent);
 //
 // m_move.c
 //
+void M_InitMoveCache (void);
+void M_ClearMoveCache (void);
 qboolean M_CheckBottom (edict_t *ent);
 qboolean M_walkmove (edict_t *ent, float yaw, float dist);
 void M_MoveToGoal (edict_t *ent, float dist);
@@ -1267,6 +1584,12 @@ void player_die (edict_t *self, edict_t *inflictor, edict_t *attacker, int damag
 void respawn (edict_t *ent);
 void BeginIntermission (edict_t *targ);
 void PutClientInServer (edict_t *ent);
+float PlayersRangeFromSpot (edict_t *spot);
+#define	SPAWNSPOT_DEATHMATCH	0		// else CTF_TEAM1..CTF_TEAM3
+#define	SPAWNSPOT_TYPES			4
+int G_SpawnSpots (int type, edict_t ***spots, float **ranges);
+void G_SpawnSpotTaken (edict_t *taken);
+void G_ResetSpawnSpots (void);
 void InitClientPersistant (gclient_t *client,int style);
 void InitClientResp (gclient_t *client);
 void InitBodyQue (void);
@@ -1289,12 +1612,23 @@ void Do_Text_Display(edict_t *activator, int flags, char *message);
 //
 // p_trail.c
 //
+#define	TRAIL_LENGTH	64		// spots kept per client, must be a power of 2
+
+typedef struct
+{
+	vec3_t		origin;
+	float		timestamp;
+	float		yaw;		// heading from the spot before
+} trailspot_t;
+
 void PlayerTrail_Init (void);
-void PlayerTrail_Add (vec3_t spot);
-void PlayerTrail_New (vec3_t spot);
-edict_t *PlayerTrail_PickFirst (edict_t *self);
-edict_t *PlayerTrail_PickNext (edict_t *self);
-edict_t	*PlayerTrail_LastSpot (void);
+void PlayerTrail_Add (edict_t *ent, vec3_t spot);
+void PlayerTrail_New (edict_t *ent, vec3_t spot);
+void PlayerTrail_Update (edict_t *ent);
+trailspot_t *PlayerTrail_PickFirst (edict_t *self);
+trailspot_t *PlayerTrail_PickNext (edict_t *self);
+int PlayerTrail_Save (int n, trailspot_t *spots);
+void PlayerTrail_Restore (int n, trailspot_t *spots, int count);
 //
 // p_view.c
 //
@@ -1304,6 +1638,7 @@ void ClientEndServerFrame (edict_t *ent);
 //
 void PlayerNoise(edict_t *who, vec3_t where, int type);
 void P_ProjectSource (gclient_t *client, vec3_t point, vec3_t distance, vec3_t forward, vec3_t right, vec3_t result);
+void Weapon_InitFrames (void);
 void Weapon_Generic (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST, int FRAME_IDLE_LAST, int FRAME_DEACTIVATE_LAST, int *pause_frames, int *fire_frames, void (*fire)(edict_t *ent, qboolean altfire));
 void kick_attack (edict_t *ent);
 
@@ -1324,6 +1659,7 @@ void hintpath_start (edict_t *monster, edict_t *spot);
 void hintpath_stop (edict_t *monster);
 qboolean hintcheck_monsterlost (edict_t *monster);
 void SetupHintPaths (void);
+void RestoreHintPaths (void);
 
 float realrange (edict_t *this_one, edict_t *that);
 qboolean has_valid_enemy (edict_t *monster);
@@ -1346,6 +1682,7 @@ typedef struct
 	char		userinfo[MAX_INFO_STRING];
 	char		netname[16];
 	int			hand;
+	int			model_team, skin_team;	// numbered by ClientSetTeams
 
 	qboolean	connected;			// a loadgame will leave valid entities that
 									// just don't have a connection yet
@@ -1590,6 +1927,10 @@ struct gclient_s
 	float		jetpack_last_thrust;
 	float		jetpack_activation;
 	float		jetpack_roll;
+	int			jetpack_probe_framenum;	// Jet_AvoidGround result for this frame
+	vec3_t		jetpack_probe_origin;
+	qboolean	jetpack_probe_clear;
+	int			jetpack_sparks_framenum;	// last frame thruster sparks were sent
 #endif
 
 //ZOID
@@ -1639,12 +1980,39 @@ struct edict_s
 	// EXPECTS THE FIELDS IN THAT ORDER!
 
 	//================================
+
+	// What the per-frame sweeps over g_edicts read (G_RunFrame,
+	// G_RunEntity, findradius, G_Find, SV_Push, the reflection loop)
+	// comes first, so it shares the cache lines right after the
+	// server's part. The id fields follow, then the Lazarus, CTF and
+	// ACE blocks that only their own entities use.
+
 	entity_id	class_id;			// Lazarus: Added in lieu of doing string comparisons
 									// on classnames.
-
 	int			movetype;
 	int			oldmovetype;	// Knightmare added
 	int			flags;
+	char		*classname;
+
+	float		nextthink;
+	void		(*prethink) (edict_t *ent);
+	void		(*think)(edict_t *self);
+	void		(*postthink) (edict_t *ent); //Knightmare added
+
+	edict_t		*groundentity;
+	int			groundentity_linkcount;
+	vec3_t		velocity;
+	vec3_t		avelocity;
+	float		gravity;		// per entity gravity multiplier (1.0 is normal)
+								// use for lowgrav artifact, flares
+	int			watertype;
+	int			waterlevel;
+
+	int			health;
+	int			takedamage;
+	int			deadflag;
+
+	//================================
 
 	char		*model;
 	float		freetime;			// sv.time when the object was freed
@@ -1654,7 +2022,6 @@ struct edict_s
 	//
 	char		*message;
 	char        *key_message;   // Lazarus: used from tremor_trigger_key
-	char		*classname;
 	int			spawnflags;
 
 	float		timestamp;
@@ -1673,14 +2040,10 @@ struct edict_s
 	vec3_t		movedir;
 	vec3_t		pos1, pos2;
 
-	vec3_t		velocity;
-	vec3_t		avelocity;
 	vec3_t		old_velocity, relative_velocity, relative_avelocity; // Knightmare added
 
 	int			mass;
 	float		air_finished;
-	float		gravity;		// per entity gravity multiplier (1.0 is normal)
-								// use for lowgrav artifact, flares
 
 	edict_t		*goalentity;
 	edict_t		*movetarget;
@@ -1696,10 +2059,6 @@ struct edict_s
 	float		ideal_roll;
 	float		roll;
 
-	float		nextthink;
-	void		(*prethink) (edict_t *ent);
-	void		(*think)(edict_t *self);
-	void		(*postthink) (edict_t *ent); //Knightmare added
 	void		(*blocked)(edict_t *self, edict_t *other);	//move to moveinfo?
 	void		(*touch)(edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf);
 	void		(*use)(edict_t *self, edict_t *other, edict_t *activator);
@@ -1716,10 +2075,8 @@ struct edict_s
 	float		fly_sound_debounce_time;	//move to clientinfo
 	float		last_move_time;
 
-	int			health;
 	int			max_health;
 	int			gib_health;
-	int			deadflag;
 	int			show_hostile;
 
 	// Lazarus: health2 and mass2 are passed from jorg to makron health and mass
@@ -1731,7 +2088,6 @@ struct edict_s
 	char		*map;			// target_changelevel
 
 	int			viewheight;		// height above origin where eyesight is determined
-	int			takedamage;
 	int			dmg;
 	int			radius_dmg;
 	float		dmg_radius;
@@ -1742,8 +2098,6 @@ struct edict_s
 	edict_t		*enemy;
 	edict_t		*oldenemy;
 	edict_t		*activator;
-	edict_t		*groundentity;
-	int			groundentity_linkcount;
 	edict_t		*teamchain;
 	edict_t		*teammaster;
 
@@ -1765,8 +2119,6 @@ struct edict_s
 
 	float		teleport_time;
 
-	int			watertype;
-	int			waterlevel;
 	int			old_watertype;
 
 	vec3_t		move_origin;
@@ -1973,6 +2325,9 @@ struct edict_s
 	int last_node;
 	int tries;
 	int state;
+
+	// For the think scheduler
+	int think_frame; // last frame this bot picked goals and enemies
 // ACEBOT_END
 
 };
@@ -83,6 +83,13 @@ void lock_initialize (edict_t *lock)
 	int		n, l;
 	int		numdigits;
 	char	c;
+	char	*code;
+
+	// the combination is written into key_message, so use a copy of
+	// the (interned) one from the map, with room for game.lock_code
+	code = (char *)gi.TagMalloc (max((int)strlen(lock->key_message), 8) + 1, TAG_LEVEL);
+	strcpy (code, lock->key_message);
+	lock->key_message = code;
 
 	if(lock->spawnflags & 1 && strlen(game.lock_code) != 0)
 	{
@@ -53,6 +53,7 @@ cvar_t	*g_select_empty;
 cvar_t	*dedicated;
 
 cvar_t	*filterban;
+cvar_t	*maxipfilters;
 
 cvar_t	*sv_maxvelocity;
 cvar_t	*sv_gravity;
@@ -114,6 +115,7 @@ cvar_t	*lazarus_joyp;
 cvar_t	*lazarus_joyy;
 cvar_t	*lazarus_pitch;
 cvar_t	*lazarus_yaw;
+cvar_t	*lightramp_step;
 cvar_t	*lights;
 cvar_t	*lightsmin;
 cvar_t	*m_pitch;
@@ -123,7 +125,22 @@ cvar_t	*readout;
 cvar_t	*rocket_strafe;
 cvar_t	*rotate_distance;
 cvar_t	*shift_distance;
+cvar_t	*sv_async_save;
+cvar_t	*sv_bodyque;
+cvar_t	*sv_compress_save;
+cvar_t	*sv_delta_save;
+cvar_t	*sv_frame_budget;
+cvar_t	*sv_gib_pool;
+cvar_t	*sv_lag_compensate;
+cvar_t	*sv_level_report;
 cvar_t	*sv_maxgibs;
+cvar_t	*sv_monster_lod;
+cvar_t	*sv_monster_lod_dist;
+cvar_t	*sv_telemetry;
+cvar_t	*sv_telemetry_prefix;
+cvar_t	*sv_toss_substeps;
+cvar_t	*sv_trace_cache;
+cvar_t	*sv_vehicle_substeps;
 cvar_t	*turn_rider;
 cvar_t	*vid_ref;
 cvar_t	*zoomrate;
@@ -162,8 +179,16 @@ void ShutdownGame (void)
 	if(!dedicated->value)
 		Fog_Off();
 
+	Pak_Shutdown ();
+	Prof_Shutdown ();
+	Tel_Shutdown ();
+	CmdLog_Shutdown ();
+	WaitForSave ();
+	ACEND_WaitForNodeSave (NULL);
+
 	gi.FreeTags (TAG_LEVEL);
 	gi.FreeTags (TAG_GAME);
+	G_ResetLevelArena ();
 }
 
 
@@ -216,6 +241,10 @@ EXPORT game_export_t *GetGameAPI (game_import_t *import)
     
 #ifdef Q2VR_ENGINE_MOD
 	globals.apiversion = GAME_API_VERSION;
+#ifdef GAME_TRACEBATCH
+	// NULL from an engine that has the import but can't batch
+	G_SetTraceBatch (import->TraceBatch);
+#endif
 #else
     globals.apiversion = LEGACY_API_VERSION;
 #endif
@@ -308,6 +337,9 @@ void ClientEndServerFrames (void)
 	int		i;
 	edict_t	*ent;
 
+	if (ctf->value)
+		CTFUpdateFlagPics ();
+
 	// calc the player views now that all pushing
 	// and damage has been added
 	for (i=0 ; i<maxclients->value ; i++)
@@ -319,8 +351,10 @@ void ClientEndServerFrames (void)
 	}
 
 	//reflection stuff -- modified from psychospaz' original code
-	if (level.num_reflectors)
+	if (level.num_reflectors && !Gov_SkipFrame ())
 	{
+		Prof_Begin (PROF_REFLECT);
+		UpdateReflectGrid ();
 		ent = &g_edicts[0];
 		for (i=0 ; i<globals.num_edicts ; i++, ent++) //pointers, not as slow as you think
 		{
@@ -344,7 +378,12 @@ void ClientEndServerFrames (void)
 				continue;		
 			AddReflection(ent);	
 		}
+		Prof_End (PROF_REFLECT);
 	}
+
+	// impacts and explosions queued this frame
+	G_FlushTempEvents ();
+	G_FlushLightStyles ();
 }
 
 /*
@@ -508,6 +547,8 @@ void ExitLevel (void)
 	edict_t	*ent;
 	char	command [256];
 
+	Rep_EndLevel ();
+
 	Com_sprintf (command, sizeof(command), "gamemap \"%s\"\n", level.changemap);
 	gi.AddCommandString (command);
 	level.changemap = NULL;
@@ -527,6 +568,28 @@ void ExitLevel (void)
 
 }
 
+/*
+================
+G_EntityAtRest
+
+True for a toss, bounce or debris entity lying still on something that
+isn't a conveyor. SV_Physics_Toss and SV_Physics_Debris return without
+moving those. A push from an explosion or anything else gives it a
+velocity, and the groundentity check in G_RunFrame drops its ground
+when what it lies on moves, either of which wakes it up.
+================
+*/
+static qboolean G_EntityAtRest (edict_t *ent)
+{
+	if (ent->movetype != MOVETYPE_TOSS && ent->movetype != MOVETYPE_BOUNCE && ent->movetype != MOVETYPE_DEBRIS)
+		return false;
+	if (!ent->groundentity || !ent->groundentity->inuse || ent->groundentity->movetype == MOVETYPE_CONVEYOR)
+		return false;
+	if (!VectorCompare (ent->velocity, vec3_origin) || !VectorCompare (ent->avelocity, vec3_origin))
+		return false;
+	return true;
+}
+
 /*
 ================
 G_RunFrame
@@ -546,6 +609,9 @@ void G_RunFrame (void)
 	if (paused && deathmatch->value)
 		return;
 
+	Tel_BeginFrame ();
+	CmdLog_RunFrame ();
+
 	if(level.freeze)
 	{
 		level.freezeframes++;
@@ -556,6 +622,16 @@ void G_RunFrame (void)
 
 	level.time = level.framenum*FRAMETIME;
 
+	Prof_BeginFrame ();
+	Gov_BeginFrame ();
+	G_ClearTraceCache ();
+	G_BeginTempEvents ();
+	G_BeginLightStyles ();
+	KM_RefreshCvars (false);
+
+	// pick up any targetnames or dmgteams that changed outside of G_IndexEdict
+	G_RefreshEdictIndexes ();
+
 	// choose a client for monsters to target this frame
 	AI_SetSightClient ();
 
@@ -564,12 +640,24 @@ void G_RunFrame (void)
 	if (level.exitintermission)
 	{
 		ExitLevel ();
+		Prof_End (PROF_FRAME);
+		Tel_EndFrame ();
 		return;
 	}
 
 	if (use_techs->value || (ctf->value && !((int)dmflags->value & DF_CTF_NO_TECH)) )
 		CheckNumTechs ();
 
+	// blaster bolts and rockets in flight
+	G_RunProjectiles ();
+
+	// targets whose delay is up, and items coming back
+	if (!level.freeze)
+	{
+		G_RunDelayedUses ();
+		G_RunRespawns ();
+	}
+
 	//
 	// treat each object in turn
 	// even the world gets a chance to think
@@ -580,6 +668,10 @@ void G_RunFrame (void)
 		if (!ent->inuse)
 			continue;
 
+		// already moved by G_RunProjectiles
+		if (ent->flags & FL_PROJECTILE)
+			continue;
+
 		level.current_entity = ent;
 
 		VectorCopy (ent->s.origin, ent->s.old_origin);
@@ -603,9 +695,29 @@ void G_RunFrame (void)
 // ACEBOT_END
 		}
 
+		// Most of a map never moves and never thinks (path_corners,
+		// lights, info_notnulls, static models), and dropped items, gibs
+		// and rocks lying still don't move either. For those G_RunEntity
+		// would only find out that nextthink isn't due, so don't call it.
+		if ((ent->movetype == MOVETYPE_NONE || ent->movetype == MOVETYPE_WALK || G_EntityAtRest (ent))
+			&& !ent->prethink && !ent->postthink
+			&& (ent->nextthink <= 0 || ent->nextthink > level.time+0.001))
+			continue;
+
 		G_RunEntity (ent);
 	}
 
+	// moving_speakers follow where their owners ended up
+	G_UpdateAttachedSounds ();
+
+// ACEBOT_ADD
+	// links ACEND_PathMap found this frame
+	Prof_Begin (PROF_BOTNODES);
+	ACEND_FoldLinks (ace_link_budget->value);
+	ACESP_AutoFill ();
+	Prof_End (PROF_BOTNODES);
+// ACEBOT_END
+
 	// see if it is time to end a deathmatch
 	CheckDMRules ();
 
@@ -613,7 +725,15 @@ void G_RunFrame (void)
 	CheckNeedPass ();
 
 	// build the playerstate_t structures for all players
+	Prof_Begin (PROF_ENDFRAMES);
 	ClientEndServerFrames ();
+	Prof_End (PROF_ENDFRAMES);
+
+	// where everybody is in the frame about to be sent
+	G_LagRecord ();
 
+	Gov_EndFrame ();
+	Prof_End (PROF_FRAME);
+	Tel_EndFrame ();
 }
 
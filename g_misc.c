@@ -235,6 +235,146 @@ void gib_die (edict_t *self, edict_t *inflictor, edict_t *attacker, int damage,
 	G_FreeEdict (self);
 }
 
+/*
+=================
+gib pool
+
+ThrowGib and ThrowDebris keep what they spawn in a ring, oldest first.
+With sv_gib_pool set, throwing one more than that many frees the oldest
+one still around, so a big explosion can't use up the free edicts.
+
+A gib or chunk also costs more of the sv_maxgibs budget of its frame
+the further it is from the nearest client, and none are thrown where
+no client's PVS reaches.
+
+The entries are only remembered edicts. An entry counts as gone once
+its edict is freed or reused, which timestamp tells, since the gibs
+themselves don't use it.
+=================
+*/
+#define GIB_POOL_MAX	1024
+
+typedef struct
+{
+	edict_t		*ent;
+	float		stamp;
+} gibslot_t;
+
+static gibslot_t	gib_pool[GIB_POOL_MAX];
+static int			gib_pool_tail;		// oldest
+static int			gib_pool_count;
+static float		gib_pool_serial;
+
+void gib_pool_reset (void)
+{
+	gib_pool_tail = gib_pool_count = 0;
+}
+
+static qboolean gib_pool_alive (gibslot_t *slot)
+{
+	return slot->ent->inuse && slot->ent->timestamp == slot->stamp;
+}
+
+// drops the entries of gibs that are already gone
+static void gib_pool_compact (void)
+{
+	gibslot_t	*slot;
+	int			i, count;
+
+	count = 0;
+	for (i = 0; i < gib_pool_count; i++)
+	{
+		slot = &gib_pool[(gib_pool_tail + i) % GIB_POOL_MAX];
+		if (gib_pool_alive (slot))
+			gib_pool[(gib_pool_tail + count++) % GIB_POOL_MAX] = *slot;
+	}
+	gib_pool_count = count;
+}
+
+static void gib_pool_add (edict_t *gib)
+{
+	gibslot_t	*slot;
+	int			limit;
+
+	limit = (int)sv_gib_pool->value;
+	if (limit <= 0)
+		return;
+	if (limit > GIB_POOL_MAX)
+		limit = GIB_POOL_MAX;
+
+	if (gib_pool_count >= limit)
+		gib_pool_compact ();
+	while (gib_pool_count >= limit)
+	{
+		slot = &gib_pool[gib_pool_tail];
+		gib_pool_tail = (gib_pool_tail + 1) % GIB_POOL_MAX;
+		gib_pool_count--;
+		if (gib_pool_alive (slot) && slot->ent != gib)
+			G_FreeEdict (slot->ent);
+	}
+
+	gib_pool_serial += 1.0;
+	if (gib_pool_serial > 16000000)		// still exact as a float
+		gib_pool_serial = 1.0;
+	gib->timestamp = gib_pool_serial;
+
+	slot = &gib_pool[(gib_pool_tail + gib_pool_count) % GIB_POOL_MAX];
+	slot->ent = gib;
+	slot->stamp = gib_pool_serial;
+	gib_pool_count++;
+}
+
+/*
+=================
+gib_budget
+
+Returns false if a gib or chunk thrown at origin this frame would go
+over sv_maxgibs. Each costs 1 within 1024 units of a client, 2 within
+2048 and 4 beyond that.
+=================
+*/
+static qboolean gib_budget (vec3_t origin)
+{
+	edict_t	*e;
+	vec3_t	v;
+	float	dist, best;
+	int		i, cost;
+
+	// Lazarus: Prevent gib showers (generally due to firing BFG in a crowd) from
+	// causing SZ_GetSpace: overflow
+	if (level.framenum > lastgibframe)
+	{
+		gibsthisframe = 0;
+		lastgibframe = level.framenum;
+	}
+
+	best = -1;
+	for (i = 1; i <= game.maxclients; i++)
+	{
+		e = &g_edicts[i];
+		if (!e->inuse || !e->client)
+			continue;
+		if (!gi.inPVS (e->s.origin, origin))
+			continue;
+		VectorSubtract (e->s.origin, origin, v);
+		dist = VectorLength (v);
+		if (best < 0 || dist < best)
+			best = dist;
+	}
+	if (best < 0)
+		return false;	// nobody would see it
+
+	if (best < 1024)
+		cost = 1;
+	else if (best < 2048)
+		cost = 2;
+	else
+		cost = 4;
+
+	gibsthisframe += cost;
+	return (gibsthisframe <= sv_maxgibs->value * Gov_Scale ());
+}
+
 void ThrowGib (edict_t *self, char *gibname, int damage, int type)
 {
 	edict_t *gib;
@@ -245,18 +385,13 @@ void ThrowGib (edict_t *self, char *gibname, int damage, int type)
 	char	modelname[256];
 	char	*p;
 
-	// Lazarus: Prevent gib showers (generally due to firing BFG in a crowd) from
-	// causing SZ_GetSpace: overflow
-	if (level.framenum > lastgibframe)
-	{
-		gibsthisframe = 0;
-		lastgibframe = level.framenum;
-	}
-	gibsthisframe++;
-	if (gibsthisframe > sv_maxgibs->value)
+	VectorScale (self->size, 0.5, size);
+	VectorAdd (self->absmin, size, origin);
+	if (!gib_budget (origin))
 		return;
 
-	gib = G_Spawn();
+	gib = G_SpawnTagged("ThrowGib");
+	gib_pool_add (gib);
 
 	gib->classname = "gib";
 	//gib->classname = gi.TagMalloc (4,TAG_LEVEL);
@@ -272,12 +407,9 @@ void ThrowGib (edict_t *self, char *gibname, int damage, int type)
 	}
 
 	// Save gibname and type for level transition gibs
-	gib->key_message = (char*)gi.TagMalloc (strlen(modelname)+1,TAG_LEVEL);
-	strcpy(gib->key_message, modelname);
+	gib->key_message = G_LevelString (modelname);
 	gib->style = type;
 
-	VectorScale (self->size, 0.5, size);
-	VectorAdd (self->absmin, size, origin);
 	gib->s.origin[0] = origin[0] + crandom() * size[0];
 	gib->s.origin[1] = origin[1] + crandom() * size[1];
 	gib->s.origin[2] = origin[2] + crandom() * size[2];
@@ -305,7 +437,7 @@ void ThrowGib (edict_t *self, char *gibname, int damage, int type)
 
 	if (type == GIB_ORGANIC)
 	{
-		if (deathmatch->value && mega_gibs->value)
+		if (deathmatch->value && mega_gibs->value && gov_level < 2)
 			gib->movetype = MOVETYPE_BOUNCE;
 		else
 			gib->movetype = MOVETYPE_TOSS;
@@ -326,7 +458,7 @@ void ThrowGib (edict_t *self, char *gibname, int damage, int type)
 	gib->avelocity[2] = random()*600;
 
 	gib->think = gib_fade; //Knightmare- gib fade, was G_FreeEdict
-	gib->nextthink = level.time + 10 + random()*10;
+	gib->nextthink = level.time + Gov_Lifetime (10 + random()*10);
 
 	gib->s.renderfx |= RF_IR_VISIBLE;
 
@@ -394,8 +526,7 @@ void ThrowHead (edict_t *self, char *gibname, int damage, int type)
 	}
 
 	// Save gibname and type for level transition gibs
-	self->key_message = (char*)gi.TagMalloc (strlen(modelname)+1,TAG_LEVEL);
-	strcpy(self->key_message, modelname);
+	self->key_message = G_LevelString (modelname);
 
 	self->style = type;
 	self->s.modelindex2 = 0;
@@ -442,23 +573,13 @@ void ThrowHead (edict_t *self, char *gibname, int damage, int type)
 	self->avelocity[YAW] = crandom()*600;
 
 	self->think = gib_fade; //Knightmare- gib fade, was G_FreeEdict
-	self->nextthink = level.time + 10 + random()*10;
+	self->nextthink = level.time + Gov_Lifetime (10 + random()*10);
 
 	// Lazarus: If head owner was part of a movewith chain,
 	//          remove from the chain and repair the chain
 	//          if necessary
 	if (self->movewith)
-	{
-		edict_t	*e;
-		edict_t	*parent=NULL;
-		int		i;
-		for(i=1; i<globals.num_edicts && !parent; i++)
-		{
-			e = g_edicts + i;
-			if(e->movewith_next == self) parent=e;
-		}
-		if(parent) parent->movewith_next = self->movewith_next;
-	}
+		movewith_unlink (self);
 
 	self->s.renderfx |= RF_IR_VISIBLE;
 
@@ -544,18 +665,11 @@ void ThrowDebris (edict_t *self, char *modelname, float speed, vec3_t origin, in
 	edict_t	*chunk;
 	vec3_t	v;
 
-	// Lazarus: Prevent gib showers (generally due to firing BFG in a crowd) from
-	// causing SZ_GetSpace: overflow
-	if(level.framenum > lastgibframe)
-	{
-		gibsthisframe = 0;
-		lastgibframe = level.framenum;
-	}
-	gibsthisframe++;
-	if (gibsthisframe > sv_maxgibs->value)
+	if (!gib_budget (origin))
 		return;
 
-	chunk = G_Spawn();
+	chunk = G_SpawnTagged("ThrowDebris");
+	gib_pool_add (chunk);
 	VectorCopy (origin, chunk->s.origin);
 	gi.setmodel (chunk, modelname);
 #ifdef KMQUAKE2_ENGINE_MOD
@@ -573,7 +687,7 @@ void ThrowDebris (edict_t *self, char *modelname, float speed, vec3_t origin, in
 	chunk->avelocity[1] = random()*600;
 	chunk->avelocity[2] = random()*600;
 	chunk->think = gib_fade; //Knightmare- gib fade, was G_FreeEdict
-	chunk->nextthink = level.time + 8 + random()*10;
+	chunk->nextthink = level.time + Gov_Lifetime (8 + random()*10);
 	chunk->s.frame = 0;
 	chunk->flags = 0;
 	chunk->classname = "debris";
@@ -721,7 +835,7 @@ void path_corner_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface
 	}
 
 	if (self->target)
-		next = G_PickTarget(self->target);
+		next = G_PickRoute(self);
 	else
 		next = NULL;
 
@@ -733,7 +847,7 @@ void path_corner_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface
 		v[2] += next->mins[2];
 		v[2] -= other->mins[2];
 		VectorCopy (v, other->s.origin);
-		next = G_PickTarget(next->target);
+		next = G_PickRoute(next);
 		other->s.event = EV_OTHER_TELEPORT;
 	}
 
@@ -813,7 +927,7 @@ void point_combat_touch (edict_t *self, edict_t *other, cplane_t *plane, csurfac
 	if (self->target)
 	{
 		other->target = self->target;
-		other->goalentity = other->movetarget = G_PickTarget(other->target);
+		other->goalentity = other->movetarget = G_PickRoute(other);
 		if (!other->goalentity)
 		{
 			gi.dprintf("%s at %s target %s does not exist\n", self->classname, vtos(self->s.origin), self->target);
@@ -947,12 +1061,12 @@ void light_use (edict_t *self, edict_t *other, edict_t *activator)
 {
 	if (self->spawnflags & START_OFF)
 	{
-		gi.configstring (CS_LIGHTS+self->style, "m");
+		G_SetLightStyle (self->style, "m");
 		self->spawnflags &= ~START_OFF;
 	}
 	else
 	{
-		gi.configstring (CS_LIGHTS+self->style, "a");
+		G_SetLightStyle (self->style, "a");
 		self->spawnflags |= START_OFF;
 
 		self->count--;
@@ -977,9 +1091,9 @@ void SP_light (edict_t *self)
 	{
 		self->use = light_use;
 		if (self->spawnflags & START_OFF)
-			gi.configstring (CS_LIGHTS+self->style, "a");
+			G_SetLightStyle (self->style, "a");
 		else
-			gi.configstring (CS_LIGHTS+self->style, "m");
+			G_SetLightStyle (self->style, "m");
 	}
 }
 
@@ -2866,33 +2980,133 @@ void SP_target_character (edict_t *self)
 /*QUAKED target_string (0 0 1) (-8 -8 -8) (8 8 8)
 */
 
-void target_string_use (edict_t *self, edict_t *other, edict_t *activator)
+/*
+=================
+target_string displays
+
+A func_clock uses its target_string every second, and each use used to
+walk the whole team of target_characters and set every frame again.
+The characters of each target_string are now found once, on its first
+use after the level is spawned or loaded (the teams aren't known
+before G_FindTeams), and each keeps the glyph it was last given, so a
+use only touches the characters whose glyph changed.
+
+A character that has been freed or moved to another team makes the
+list get built again on the next use.
+=================
+*/
+typedef struct
 {
-	edict_t *e;
-	int		n, l;
-	char	c;
+	edict_t		*ent;
+	int			pos;		// index in the message
+	int			glyph;		// frame last set, -1 if none
+} stringchar_t;
 
-	l = (int)strlen(self->message);
+typedef struct
+{
+	qboolean		resolved;
+	int				num;
+	stringchar_t	*chars;		// TAG_LEVEL
+} stringdisplay_t;
+
+static stringdisplay_t	*string_displays;	// per edict
+
+/*
+=================
+target_string_initgame
+
+Called from InitGame; the first target_string used allocates the
+displays again
+=================
+*/
+void target_string_initgame (void)
+{
+	string_displays = NULL;
+}
+
+/*
+=================
+target_string_reset
+
+Called by SpawnEntities and ReadLevel, since the lists are TAG_LEVEL
+=================
+*/
+void target_string_reset (void)
+{
+	if (string_displays)
+		memset (string_displays, 0, game.maxentities * sizeof(stringdisplay_t));
+}
+
+static void target_string_resolve (edict_t *self, stringdisplay_t *disp)
+{
+	edict_t	*e;
+	int		num;
+
+	num = 0;
+	for (e = self->teammaster; e; e = e->teamchain)
+	{
+		if (e->count)
+			num++;
+	}
+
+	if (disp->chars)
+		gi.TagFree (disp->chars);
+	disp->chars = num ? gi.TagMalloc (num * sizeof(stringchar_t), TAG_LEVEL) : NULL;
+	disp->num = 0;
 	for (e = self->teammaster; e; e = e->teamchain)
 	{
 		if (!e->count)
 			continue;
-		n = e->count - 1;
-		if (n > l)
+		disp->chars[disp->num].ent = e;
+		disp->chars[disp->num].pos = e->count - 1;
+		disp->chars[disp->num].glyph = -1;
+		disp->num++;
+	}
+	disp->resolved = true;
+}
+
+static int target_string_glyph (edict_t *self, int len, int n)
+{
+	char	c;
+
+	if (n >= len)
+		return 12;
+
+	c = self->message[n];
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c == '-')
+		return 10;
+	if (c == ':')
+		return 11;
+	return 12;
+}
+
+void target_string_use (edict_t *self, edict_t *other, edict_t *activator)
+{
+	stringdisplay_t	*disp;
+	stringchar_t	*sc;
+	int				i, l, glyph;
+
+	if (!string_displays)
+		string_displays = gi.TagMalloc (game.maxentities * sizeof(stringdisplay_t), TAG_GAME);
+	disp = &string_displays[self - g_edicts];
+	if (!disp->resolved)
+		target_string_resolve (self, disp);
+
+	l = (int)strlen(self->message);
+	for (i = 0, sc = disp->chars; i < disp->num; i++, sc++)
+	{
+		glyph = target_string_glyph (self, l, sc->pos);
+		if (glyph == sc->glyph)
+			continue;
+		if (!sc->ent->inuse || sc->ent->teammaster != self->teammaster)
 		{
-			e->s.frame = 12;
+			disp->resolved = false;
 			continue;
 		}
-
-		c = self->message[n];
-		if (c >= '0' && c <= '9')
-			e->s.frame = c - '0';
-		else if (c == '-')
-			e->s.frame = 10;
-		else if (c == ':')
-			e->s.frame = 11;
-		else
-			e->s.frame = 12;
+		sc->glyph = glyph;
+		sc->ent->s.frame = glyph;
 	}
 }
 
@@ -2937,26 +3151,12 @@ void func_clock_reset (edict_t *self)
 	}
 }
 
-// Skuller's hack to fix crash on exiting biggun
-typedef struct zhead_s {
-   struct zhead_s   *prev, *next;
-   int16_t   magic;
-   int16_t   tag;         // for group free
-   int      size;
-} zhead_t;
-
+// SP_func_clock gives message CLOCK_MESSAGE_SIZE bytes, and ReadField
+// gives every string it loads 32 bytes to spare, so there is always
+// room. (This used to check the zone header behind message, but loaded
+// strings come out of the level arena now and have none.)
 void func_clock_format_countdown (edict_t *self)
 {
-	zhead_t *z = ( zhead_t * )self->message - 1;
-	int size = z->size - sizeof (zhead_t);
-
-	if (size < CLOCK_MESSAGE_SIZE) {
-		gi.TagFree (self->message);
-		self->message = (char*)gi.TagMalloc (CLOCK_MESSAGE_SIZE, TAG_LEVEL);
-		//gi.dprintf ("WARNING: func_clock_format_countdown: self->message is too small: %i\n", size);
-	} 
-	// end Skuller's hack
-
 	if (self->style == 0)
 	{
 		Com_sprintf (self->message, CLOCK_MESSAGE_SIZE, "%2i", self->health);
@@ -3573,6 +3773,7 @@ TARGET_PRECIPITATION
 #define SF_WEATHER_GRAVITY_BOUNCE 4
 #define SF_WEATHER_FIRE_ONCE      8
 #define SF_WEATHER_START_FADE     16
+#define SF_WEATHER_EMITTER        32
 #define STYLE_WEATHER_RAIN        0
 #define STYLE_WEATHER_BIGRAIN     1
 #define STYLE_WEATHER_SNOW        2
@@ -3672,7 +3873,7 @@ void spawn_precipitation(edict_t *self, vec3_t org, vec3_t dir, float speed)
 	}
 	else
 	{
-		drop = G_Spawn();
+		drop = G_SpawnTagged("spawn_precipitation");
 		if(self->style == STYLE_WEATHER_BIGRAIN)
 			drop->s.modelindex = gi.modelindex ("models/objects/drop/heavy.md2");
 		else if(self->style == STYLE_WEATHER_SNOW)
@@ -3753,6 +3954,54 @@ void spawn_precipitation(edict_t *self, vec3_t org, vec3_t dir, float speed)
 	gi.linkentity(drop);
 }
 
+/*
+=================
+precipitation_emit
+
+EMITTER mode of target_precipitation: instead of spawning r drop
+entities, send them as TE_STEAM puffs, which the client animates as
+particles on its own. Each puff stands for up to PRECIP_DROPS_PER_PUFF
+drops at a random point of the volume. The puffs cost one small
+message each, no edicts and no physics, but they don't land, so there
+are no splashes. Only rain, big rain and snow can be drawn this way;
+the others need their models and keep spawning drops.
+=================
+*/
+#define PRECIP_DROPS_PER_PUFF	8
+#define PRECIP_PARTICLES		3		// particles per drop
+
+void precipitation_emit (edict_t *self, vec3_t center, int r)
+{
+	vec3_t	org;
+	int		n, color;
+
+	if (self->style == STYLE_WEATHER_SNOW)
+		color = 15;		// white
+	else
+		color = 8;		// gray, as target_effect steam
+
+	while (r > 0)
+	{
+		n = (r < PRECIP_DROPS_PER_PUFF) ? r : PRECIP_DROPS_PER_PUFF;
+		r -= n;
+
+		VectorCopy(center, org);
+		org[0] += crandom() * (self->tright[0] - self->bleft[0])/2;
+		org[1] += crandom() * (self->tright[1] - self->bleft[1])/2;
+		org[2] += crandom() * (self->tright[2] - self->bleft[2])/2;
+
+		gi.WriteByte (svc_temp_entity);
+		gi.WriteByte (TE_STEAM);
+		gi.WriteShort (-1);		// a single puff, no id or wait
+		gi.WriteByte (n * PRECIP_PARTICLES);
+		gi.WritePosition (org);
+		gi.WriteDir (self->movedir);
+		gi.WriteByte (color);
+		gi.WriteShort ((int)self->speed);
+		gi.multicast (org, MULTICAST_PVS);
+	}
+}
+
 void target_precipitation_think (edict_t *self)
 {
 	vec3_t	center;
@@ -3760,7 +4009,6 @@ void target_precipitation_think (edict_t *self)
 	int		r, i;
 	float	u, v, z;
 	float	temp;
-	qboolean	can_see_me;
 
 	self->nextthink = level.time + FRAMETIME;
 
@@ -3777,14 +4025,7 @@ void target_precipitation_think (edict_t *self)
 	// of the player's current position, but the result (rain) IS in the
 	// PVS. In any case, this step is necessary to prevent overflows when
 	// player suddenly encounters rain.
-	can_see_me = false;
-	for(i=1; i<=game.maxclients && !can_see_me; i++)
-	{
-		if(!g_edicts[i].inuse) continue;
-		if(gi.inPVS(g_edicts[i].s.origin,self->s.origin))
-			can_see_me = true;
-	}
-	if(!can_see_me) return;
+	if(!G_ClientsInPVS(self, NULL)) return;
 
 	// Count is models/second. We accumulate a probability of a model
 	// falling this frame in ->density. Yeah its a misnomer but density isn't 
@@ -3796,11 +4037,19 @@ void target_precipitation_think (edict_t *self)
 		self->density = self->count + (temp-(float)r)*10;
 	else
 		self->density += (temp*10);
+	if(gov_level)
+		r = (int)(r * Gov_Scale() + random());
 	if(r < 1) return;
 
 	VectorAdd(self->bleft,self->tright,center);
 	VectorMA(self->s.origin,0.5,center,center);
 
+	if(self->spawnflags & SF_WEATHER_EMITTER)
+	{
+		precipitation_emit(self, center, r);
+		return;
+	}
+
 	for(i=0; i<r; i++)
 	{
 		u = crandom() * (self->tright[0] - self->bleft[0])/2;
@@ -3891,7 +4140,7 @@ void SP_target_precipitation (edict_t *ent)
 		// Knightmare- check for "models/" or "sprites/" already in path
 		if ( strncmp(ent->usermodel, "models/", 7) && strncmp(ent->usermodel, "sprites/", 8) )
 		{
-			buffer = (char*)gi.TagMalloc(strlen(ent->usermodel)+10,TAG_LEVEL);
+			buffer = (char*)G_LevelAlloc(strlen(ent->usermodel)+10);
 			if(strstr(ent->usermodel,".sp2"))
 				sprintf(buffer, "sprites/%s", ent->usermodel);
 			else
@@ -3915,6 +4164,13 @@ void SP_target_precipitation (edict_t *ent)
 	if(ent->style > STYLE_WEATHER_BIGRAIN && ent->style != STYLE_WEATHER_USER)
 		ent->spawnflags &= ~SF_WEATHER_SPLASH;
 
+	// Leaves and user models can't be particles, so they still spawn drops
+	if((ent->spawnflags & SF_WEATHER_EMITTER) && (ent->style == STYLE_WEATHER_LEAF || ent->style == STYLE_WEATHER_USER))
+	{
+		gi.dprintf("target_precipitation at %s: EMITTER only works with rain and snow\n", vtos(ent->s.origin));
+		ent->spawnflags &= ~SF_WEATHER_EMITTER;
+	}
+
 	ent->use = target_precipitation_use;
 	
 	if(!ent->count)
@@ -3971,7 +4227,6 @@ void target_fountain_think (edict_t *self)
 	int		r, i;
 	float	u, v, z;
 	float	temp;
-	qboolean	can_see_me;
 
 	if(!(self->spawnflags & SF_WEATHER_FIRE_ONCE))
 		self->nextthink = level.time + FRAMETIME;
@@ -3989,14 +4244,7 @@ void target_fountain_think (edict_t *self)
 	// of the player's current position, but the result (rain) IS in the
 	// PVS. In any case, this step is necessary to prevent overflows when
 	// player suddenly encounters rain.
-	can_see_me = false;
-	for(i=1; i<=game.maxclients && !can_see_me; i++)
-	{
-		if(!g_edicts[i].inuse) continue;
-		if(gi.inPVS(g_edicts[i].s.origin,self->s.origin))
-			can_see_me = true;
-	}
-	if(!can_see_me) return;
+	if(!G_ClientsInPVS(self, NULL)) return;
 
 	// Count is models/second. We accumulate a probability of a model
 	// falling this frame in ->density. Yeah its a misnomer but density isn't 
@@ -4008,6 +4256,8 @@ void target_fountain_think (edict_t *self)
 		self->density = self->count;
 	else
 		self->density += (temp*10);
+	if(gov_level)
+		r = (int)(r * Gov_Scale() + random());
 	if(r < 1) return;
 
 	VectorAdd(self->bleft,self->tright,center);
@@ -4105,7 +4355,7 @@ void SP_target_fountain (edict_t *ent)
 	// Knightmare- check for "models/" or "sprites/" already in path
 	if ( strncmp(ent->usermodel, "models/", 7) && strncmp(ent->usermodel, "sprites/", 8) )
 	{
-		buffer = (char*)gi.TagMalloc(strlen(ent->usermodel)+10,TAG_LEVEL);
+		buffer = (char*)G_LevelAlloc(strlen(ent->usermodel)+10);
 		if(strstr(ent->usermodel,".sp2"))
 			sprintf(buffer, "sprites/%s", ent->usermodel);
 		else
@@ -4160,7 +4410,6 @@ MISC_DEADSOLDIER MODEL PATCH
 #else
 #include <unistd.h>
 #endif
-#include "pak.h"
 
 int PatchDeadSoldier ()
 {
@@ -4171,7 +4420,6 @@ int PatchDeadSoldier ()
 	int			j;
 	char		*p;
 	FILE		*infile;
-	FILE		*outfile;
 	dmdl_t		model;				// model header
 	byte		*data;				// model data
 	int			datasize;			// model data size (bytes)
@@ -4183,12 +4431,8 @@ int PatchDeadSoldier ()
 		return 0;	// we're in baseq2
 
 	sprintf (outfilename, "%s/%s", gamedir->string,DEADSOLDIER_MODEL);
-	if ((outfile = fopen (outfilename, "rb")))
-	{
-		// output file already exists, move along
-		fclose (outfile);
+	if (PatchedModel_Checked (outfilename))
 		return 0;
-	}
 
 	for (j = 0; j < NUM_SKINS; j++)
 		memset (skins[j], 0, MAX_SKINNAME);
@@ -4211,60 +4455,48 @@ int PatchDeadSoldier ()
 	sprintf (skins[15], "players/male/viper.pcx");
 
 
+	if (PatchedModel_Valid (outfilename, NUM_SKINS, (char *)skins, NUM_SKINS * MAX_SKINNAME))
+	{
+		// output file already exists, move along
+		return 0;
+	}
+
 	// load original model
 	sprintf (infilename, "baseq2/%s", DEADSOLDIER_MODEL);
 	if ( !(infile = fopen (infilename, "rb")) )
 	{
 		// If file doesn't exist on user's hard disk, it must be in 
-		// pak0.pak
+		// a baseq2 pak file
 
-		pak_header_t	pakheader;
-		pak_item_t		pakitem;
+		pakentry_t		entry;
 		FILE			*fpak;
-		int				k, numitems;
 
-		fpak = fopen("baseq2/pak0.pak","rb");
-		if(!fpak)
+		if (!Pak_FindFile("baseq2", DEADSOLDIER_MODEL, &entry))
 		{
 			cvar_t	*cddir;
-			char	pakfile[MAX_OSPATH];
+			char	pakpath[MAX_OSPATH];
 
 			cddir = gi.cvar("cddir", "", 0);
-			sprintf(pakfile,"%s/baseq2/pak0.pak",cddir->string);
-			fpak = fopen(pakfile,"rb");
-			if(!fpak)
+			sprintf(pakpath,"%s/baseq2",cddir->string);
+			if (!Pak_FindFile(pakpath, DEADSOLDIER_MODEL, &entry))
 			{
-				gi.dprintf("PatchDeadSoldier: Cannot find pak0.pak\n");
+				gi.dprintf("PatchDeadSoldier: Could not find %s in baseq2 pak files\n",DEADSOLDIER_MODEL);
 				return 0;
 			}
 		}
-		fread(&pakheader,1,sizeof(pak_header_t),fpak);
-		numitems = pakheader.dsize/sizeof(pak_item_t);
-		fseek(fpak,pakheader.dstart,SEEK_SET);
-		data = NULL;
-		for(k=0; k<numitems && !data; k++)
+		if (!(fpak = Pak_OpenFile(&entry)))
 		{
-			fread(&pakitem,1,sizeof(pak_item_t),fpak);
-			if(!Q_strcasecmp(pakitem.name,DEADSOLDIER_MODEL))
-			{
-				fseek(fpak,pakitem.start,SEEK_SET);
-				fread(&model, sizeof(dmdl_t), 1, fpak);
-				datasize = model.ofs_end - model.ofs_skins;
-				if ( !(data = (byte*)G_Malloc (datasize)) )	// make sure freed locally
-				{
-					fclose(fpak);
-					gi.dprintf ("PatchDeadSoldier: Could not allocate memory for model\n");
-					return 0;
-				}
-				fread (data, sizeof (byte), datasize, fpak);
-			}
+			gi.dprintf("PatchDeadSoldier: Cannot open pak%d.pak\n",entry.pak);
+			return 0;
 		}
-		fclose(fpak);
-		if(!data)
+		fread(&model, sizeof(dmdl_t), 1, fpak);
+		datasize = model.ofs_end - model.ofs_skins;
+		if ( !(data = (byte*)G_Malloc (datasize)) )	// make sure freed locally
 		{
-			gi.dprintf("PatchDeadSoldier: Could not find %s in baseq2/pak0.pak\n",DEADSOLDIER_MODEL);
+			gi.dprintf ("PatchDeadSoldier: Could not allocate memory for model\n");
 			return 0;
 		}
+		fread (data, sizeof (byte), datasize, fpak);	// fpak is shared, don't close it
 	}
 	else
 	{
@@ -4306,7 +4538,8 @@ int PatchDeadSoldier ()
 
 	sprintf (outfilename, "%s/%s", gamedir->string, DEADSOLDIER_MODEL);
 	
-	if ( !(outfile = fopen (outfilename, "wb")) )
+	// the source's one skin is replaced by the new list
+	if ( !PatchedModel_Write (outfilename, &model, (char *)skins, model.num_skins*MAX_SKINNAME, data + MAX_SKINNAME, datasize - MAX_SKINNAME) )
 	{
 		// file couldn't be created for some other reason
 		gi.dprintf ("PatchDeadSoldier: Could not save %s\n", outfilename);
@@ -4314,12 +4547,6 @@ int PatchDeadSoldier ()
 		return 0;
 	}
 	
-	fwrite (&model, sizeof (dmdl_t), 1, outfile);
-	fwrite (skins, sizeof (char), model.num_skins*MAX_SKINNAME, outfile);
-	data += MAX_SKINNAME;
-	fwrite (data, sizeof (byte), datasize, outfile);
-	
-	fclose (outfile);
 	gi.dprintf ("PatchDeadSoldier: Saved %s\n", outfilename);
 	G_Free(data);
 	return 1;
@@ -29,6 +29,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #endif
 
 void InitiallyDead (edict_t *self);
+static void M_AddCorpse (edict_t *self);
 
 // Lazarus: If worldspawn CORPSE_SINK effects flag is set,
 //          monsters/actors fade out and sink into the floor
@@ -279,7 +280,7 @@ void M_CheckGround (edict_t *ent)
 }
 
 
-void M_CatagorizePosition (edict_t *ent)
+static void M_CatagorizeWater (edict_t *ent)
 {
 	vec3_t		point;
 	int			cont;
@@ -295,7 +296,7 @@ void M_CatagorizePosition (edict_t *ent)
 	point[1] = (ent->absmax[1] + ent->absmin[1])/2;
 	point[2] = ent->absmin[2] + 2;
 
-	cont = gi.pointcontents (point);
+	cont = G_EnvContents (point);
 
 	if (!(cont & MASK_WATER))
 	{
@@ -307,17 +308,25 @@ void M_CatagorizePosition (edict_t *ent)
 	ent->watertype = cont;
 	ent->waterlevel = 1;
 	point[2] += 26;
-	cont = gi.pointcontents (point);
+	cont = G_EnvContents (point);
 	if (!(cont & MASK_WATER))
 		return;
 
 	ent->waterlevel = 2;
 	point[2] += 22;
-	cont = gi.pointcontents (point);
+	cont = G_EnvContents (point);
 	if (cont & MASK_WATER)
 		ent->waterlevel = 3;
 }
 
+void M_CatagorizePosition (edict_t *ent)
+{
+	if (G_WaterLevelKnown (ent, WATERCACHE_MONSTER))
+		return;
+	M_CatagorizeWater (ent);
+	G_StoreWaterLevel (ent, WATERCACHE_MONSTER);
+}
+
 
 void M_WorldEffects (edict_t *ent)
 {
@@ -471,8 +480,8 @@ void M_SetEffects (edict_t *ent)
 
 void M_MoveFrame (edict_t *self)
 {
-	mmove_t	*move;
-	int		index;
+	mmove_t		*move;
+	mframe_t	*frame;
 
 	// Lazarus: For live monsters weaker than gladiator who aren't already running from
 	//          something, evade live grenades on the ground.
@@ -520,21 +529,81 @@ void M_MoveFrame (edict_t *self)
 		}
 	}
 
-	index = self->s.frame - move->firstframe;
-    if (move->frame[index].aifunc) {
+	// the aifunc may change currentmove, so hold on to this frame
+	frame = &move->frame[self->s.frame - move->firstframe];
+    if (frame->aifunc) {
         if (!(self->monsterinfo.aiflags & AI_HOLD_FRAME)) {
-			move->frame[index].aifunc (self, move->frame[index].dist * self->monsterinfo.scale);
+			frame->aifunc (self, frame->dist * self->monsterinfo.scale);
         } else {
-			move->frame[index].aifunc (self, 0);
+			frame->aifunc (self, 0);
         }
     }
-	if (move->frame[index].thinkfunc)
-		move->frame[index].thinkfunc (self);
+	if (frame->thinkfunc)
+		frame->thinkfunc (self);
 }
 
 
+/*
+================
+M_SkipThink
+
+With sv_monster_lod set to N above 1, a monster standing idle where
+no client can see it (outside every client's PVS and farther than
+sv_monster_lod_dist) only thinks every Nth frame. Monsters are spread
+over the N frames by entity number. It thinks again every frame as
+soon as it has an enemy, leaves its stand frames (pain, for one), a
+client comes near, or anything makes a noise or is seen that
+FindTarget would react to.
+================
+*/
+static qboolean M_SkipThink (edict_t *self)
+{
+	mmove_t	*move;
+	edict_t	*client;
+	vec3_t	v;
+	float	range;
+	int		rate, i;
+
+	rate = (int)sv_monster_lod->value;
+	if (rate <= 1)
+		return false;
+	if ((level.framenum + (int)(self - g_edicts)) % rate == 0)
+		return false;
+	if (self->enemy || self->health <= 0 || self->monsterinfo.nextframe)
+		return false;
+
+	move = self->monsterinfo.currentmove;
+	if (!move || self->s.frame < move->firstframe || self->s.frame > move->lastframe)
+		return false;
+	if (move->frame[self->s.frame - move->firstframe].aifunc != ai_stand)
+		return false;
+
+	// the same window FindTarget looks at
+	if (level.sight_entity_framenum >= level.framenum - 1
+		|| level.sound_entity_framenum >= level.framenum - 1
+		|| level.sound2_entity_framenum >= level.framenum - 1)
+		return false;
+
+	range = sv_monster_lod_dist->value;
+	for (i=1, client=g_edicts+1 ; i<=game.maxclients ; i++, client++)
+	{
+		if (!client->inuse || !client->client)
+			continue;
+		VectorSubtract (client->s.origin, self->s.origin, v);
+		if (DotProduct (v, v) < range * range)
+			return false;
+	}
+	return !G_ClientsInPVS (self, NULL);
+}
+
 void monster_think (edict_t *self)
 {
+	if (M_SkipThink (self))
+	{
+		self->nextthink = level.time + FRAMETIME;
+		return;
+	}
+
 	M_MoveFrame (self);
 	if (self->linkcount != self->monsterinfo.linkcount)
 	{
@@ -673,6 +742,8 @@ void monster_death_use (edict_t *self)
 		self->item = NULL;
 	}
 
+	M_AddCorpse (self);
+
 	if (self->deathtarget)
 		self->target = self->deathtarget;
 
@@ -682,6 +753,97 @@ void monster_death_use (edict_t *self)
 	G_UseTargets (self, self->enemy);
 }
 
+/*
+==============================================================================
+
+CORPSE REGISTRY
+
+Every monster that dies goes on this list, so medics looking for
+something to heal walk the corpses rather than every edict in 1024
+units. An entry stays until the edict is freed; a corpse that was healed
+or gibbed since is still on the list, and medic_FindDeadMonster skips it
+the same way the old radius search did. FL_CORPSE marks the edicts on
+the list.
+
+==============================================================================
+*/
+
+static edict_t	*corpses[MAX_EDICTS];
+static int		num_corpses;
+
+static void M_AddCorpse (edict_t *self)
+{
+	if (self->flags & FL_CORPSE)
+		return;
+	if (num_corpses == MAX_EDICTS)
+		return;
+	self->flags |= FL_CORPSE;
+	corpses[num_corpses++] = self;
+}
+
+/*
+=================
+M_RemoveCorpse
+
+Called from G_FreeEdict
+=================
+*/
+void M_RemoveCorpse (edict_t *self)
+{
+	int		i;
+
+	if (!(self->flags & FL_CORPSE))
+		return;
+	self->flags &= ~FL_CORPSE;
+	for (i = 0; i < num_corpses; i++)
+	{
+		if (corpses[i] == self)
+		{
+			corpses[i] = corpses[--num_corpses];
+			return;
+		}
+	}
+}
+
+/*
+=================
+M_ResetCorpses
+
+Rebuilds the list from the dead monsters in the level. Called once a
+level is spawned (transition entities included) or loaded.
+=================
+*/
+void M_ResetCorpses (void)
+{
+	edict_t	*ent;
+	int		i;
+
+	num_corpses = 0;
+	for (i = 1, ent = g_edicts + 1; i < globals.num_edicts; i++, ent++)
+	{
+		if (!ent->inuse)
+			continue;
+		ent->flags &= ~FL_CORPSE;
+		if ((ent->svflags & SVF_MONSTER) && (ent->health <= 0))
+			M_AddCorpse (ent);
+	}
+}
+
+/*
+=================
+M_Corpses
+
+Returns how many corpses there are and points list at them. The list
+changes when an edict is freed, so callers that may free one should
+copy it first.
+=================
+*/
+int M_Corpses (edict_t ***list)
+{
+	*list = corpses;
+	return num_corpses;
+}
+
 
 //============================================================================
 
@@ -706,8 +868,8 @@ qboolean monster_start (edict_t *self)
 	if (self->spawnflags & SF_MONSTER_GOODGUY) {
 		self->monsterinfo.aiflags |= AI_GOOD_GUY;
 		if(!self->dmgteam) {
-			self->dmgteam = (char*)gi.TagMalloc(8*sizeof(char), TAG_LEVEL);
-			strcpy(self->dmgteam,"player");
+			self->dmgteam = G_LevelString("player");
+			G_IndexEdict (self);
 		}
 	}
 
@@ -871,7 +1033,7 @@ void monster_start_go (edict_t *self)
 
 	if (self->target)
 	{
-		self->goalentity = self->movetarget = G_PickTarget(self->target);
+		self->goalentity = self->movetarget = G_PickRoute(self);
 		if (!self->movetarget)
 		{
 			gi.dprintf ("%s can't find target %s at %s\n", self->classname, self->target, vtos(self->s.origin));
@@ -1026,7 +1188,6 @@ void InitiallyDead (edict_t *self)
 #include <unistd.h>
 #endif
 
-#include "pak.h"
 
 int PatchMonsterModel (char *modelname)
 {
@@ -1038,7 +1199,6 @@ int PatchMonsterModel (char *modelname)
 	char		outfilename[MAX_OSPATH];
 	char		*p;
 	FILE		*infile;
-	FILE		*outfile;
 	dmdl_t		model;				// model header
 	byte		*data;				// model data
 	int			datasize;			// model data size (bytes)
@@ -1052,13 +1212,8 @@ int PatchMonsterModel (char *modelname)
 		return 0;	// we're in baseq2
 
 	sprintf (outfilename, "%s/%s", gamedir->string, modelname);
-	if ((outfile = fopen (outfilename, "rb")))
-	{
-		// output file already exists, move along
-		fclose (outfile);
-//		gi.dprintf ("PatchMonsterModel: Could not save %s, file already exists\n", outfilename);
+	if (PatchedModel_Checked (outfilename))
 		return 0;
-	}
 
 
 	numskins = 8;
@@ -1081,7 +1236,6 @@ int PatchMonsterModel (char *modelname)
 		p = strstr( skins[j], "tris.md2" );
 		if(!p)
 		{
-			fclose (outfile);
 			gi.dprintf( "Error patching %s\n",modelname);
 			return 0;
 		}
@@ -1199,60 +1353,48 @@ int PatchMonsterModel (char *modelname)
 		}
 	}
 
+	if (PatchedModel_Valid (outfilename, numskins, (char *)skins, numskins * MAX_SKINNAME))
+	{
+		// output file already exists, move along
+		return 0;
+	}
+
 	// load original model
 	sprintf (infilename, "baseq2/%s", modelname);
 	if ( !(infile = fopen (infilename, "rb")) )
 	{
 		// If file doesn't exist on user's hard disk, it must be in 
-		// pak0.pak
+		// a baseq2 pak file
 
-		pak_header_t	pakheader;
-		pak_item_t		pakitem;
+		pakentry_t		entry;
 		FILE			*fpak;
-		int				k, numitems;
 
-		fpak = fopen("baseq2/pak0.pak","rb");
-		if(!fpak)
+		if (!Pak_FindFile("baseq2", modelname, &entry))
 		{
 			cvar_t	*cddir;
-			char	pakfile[MAX_OSPATH];
+			char	pakpath[MAX_OSPATH];
 
 			cddir = gi.cvar("cddir", "", 0);
-			sprintf(pakfile,"%s/baseq2/pak0.pak",cddir->string);
-			fpak = fopen(pakfile,"rb");
-			if(!fpak)
+			sprintf(pakpath,"%s/baseq2",cddir->string);
+			if (!Pak_FindFile(pakpath, modelname, &entry))
 			{
-				gi.dprintf("PatchMonsterModel: Cannot find pak0.pak\n");
+				gi.dprintf("PatchMonsterModel: Could not find %s in baseq2 pak files\n",modelname);
 				return 0;
 			}
 		}
-		fread(&pakheader,1,sizeof(pak_header_t),fpak);
-		numitems = pakheader.dsize/sizeof(pak_item_t);
-		fseek(fpak,pakheader.dstart,SEEK_SET);
-		data = NULL;
-		for(k=0; k<numitems && !data; k++)
+		if (!(fpak = Pak_OpenFile(&entry)))
 		{
-			fread(&pakitem,1,sizeof(pak_item_t),fpak);
-			if(!Q_strcasecmp(pakitem.name,modelname))
-			{
-				fseek(fpak,pakitem.start,SEEK_SET);
-				fread(&model, sizeof(dmdl_t), 1, fpak);
-				datasize = model.ofs_end - model.ofs_skins;
-				if ( !(data = (byte*)G_Malloc (datasize)) )	// make sure freed locally
-				{
-					fclose(fpak);
-					gi.dprintf ("PatchMonsterModel: Could not allocate memory for model\n");
-					return 0;
-				}
-				fread (data, sizeof (byte), datasize, fpak);
-			}
+			gi.dprintf("PatchMonsterModel: Cannot open pak%d.pak\n",entry.pak);
+			return 0;
 		}
-		fclose(fpak);
-		if(!data)
+		fread(&model, sizeof(dmdl_t), 1, fpak);
+		datasize = model.ofs_end - model.ofs_skins;
+		if ( !(data = (byte*)G_Malloc (datasize)) )	// make sure freed locally
 		{
-			gi.dprintf("PatchMonsterModel: Could not find %s in baseq2/pak0.pak\n",modelname);
+			gi.dprintf ("PatchMonsterModel: Could not allocate memory for model\n");
 			return 0;
 		}
+		fread (data, sizeof (byte), datasize, fpak);	// fpak is shared, don't close it
 	}
 	else
 	{
@@ -1291,7 +1433,7 @@ int PatchMonsterModel (char *modelname)
 
 	sprintf (outfilename, "%s/%s", gamedir->string, modelname);
 	
-	if ( !(outfile = fopen (outfilename, "wb")) )
+	if ( !PatchedModel_Write (outfilename, &model, (char *)skins, newoffset, data, datasize) )
 	{
 		// file couldn't be created for some other reason
 		gi.dprintf ("PatchMonsterModel: Could not save %s\n", outfilename);
@@ -1299,11 +1441,6 @@ int PatchMonsterModel (char *modelname)
 		return 0;
 	}
 	
-	fwrite (&model, sizeof (dmdl_t), 1, outfile);
-	fwrite (skins, sizeof (char), newoffset, outfile);
-	fwrite (data, sizeof (byte), datasize, outfile);
-	
-	fclose (outfile);
 	gi.dprintf ("PatchMonsterModel: Saved %s\n", outfilename);
 	G_Free(data);
 	return 1;
@@ -35,27 +35,145 @@ int	hint_chains_exist;
 int	hint_chain_count;
 edict_t *hint_chain_starts[MAX_HINT_CHAINS];
 
+/*
+==============================================================================
+
+HINT_PATH GRAPH
+
+hintcheck_monsterlost used to walk every node of every chain and trace
+to each one in range, for the monster and again for its enemy. The
+chains are now also kept as arrays, built once the chains are linked:
+
+- each chain is a run of hint_nodes in order, so a node's neighbours
+  are simply the entries on either side
+- each chain has a bounding box, so chains far from the enemy are
+  skipped without a trace
+- nodes are hashed into HINT_NODE_RANGE sized grid cells, so finding
+  the nodes in range of a spot only looks at the 3x3 cells around it
+
+The arrays are TAG_LEVEL memory, rebuilt by SetupHintPaths when a map
+is spawned and by RestoreHintPaths when one is loaded.
+
+==============================================================================
+*/
+
+#define HINT_NODE_RANGE 512
+#define HINT_GRID_HASH	256		// must be a power of 2
+
+typedef struct
+{
+	float	dist;
+	int		node;
+} hintsort_t;
+
+static int			hint_node_count;
+static edict_t		**hint_nodes;		// chain by chain, in chain order
+static int			*hint_node_index;	// by edict number, -1 if not on a chain
+static int			*hint_cell_next;	// next node in the same grid cell
+static int			hint_cell_head[HINT_GRID_HASH];
+static hintsort_t	*hint_sort;			// scratch for hintcheck_monsterlost
+static hintsort_t	*hint_chain_sort;	// and for HintPath_ChainDest
+static int			hint_chain_first[MAX_HINT_CHAINS];
+static int			hint_chain_length[MAX_HINT_CHAINS];
+static vec3_t		hint_chain_mins[MAX_HINT_CHAINS];
+static vec3_t		hint_chain_maxs[MAX_HINT_CHAINS];
+
+static int HintPath_Cell (int x, int y)
+{
+	return ((x * 73856093) ^ (y * 19349663)) & (HINT_GRID_HASH - 1);
+}
+
+static int HintPath_CellCoord (float f)
+{
+	return (int)floor(f / HINT_NODE_RANGE);
+}
+
 /*
 =====================
-SetupHintPaths
+HintPath_BuildGraph
 
-Called from SpawnEntities in g_spawn.c.
-Initializes all hint_path chains in a map.
+Builds the arrays above from hint_chain_starts and the hint_chain links
 =====================
 */
-void SetupHintPaths (void)
+static void HintPath_BuildGraph (void)
 {
-	int		i, keyofs;
-	edict_t	*thisPath, *ent;
+	int		i, c, n, cell;
+	edict_t	*ent;
+
+	hint_node_count = 0;
+	hint_nodes = NULL;
+	hint_node_index = NULL;
+	hint_cell_next = NULL;
+	hint_sort = hint_chain_sort = NULL;
+	for (cell = 0; cell < HINT_GRID_HASH; cell++)
+		hint_cell_head[cell] = -1;
+
+	if (!hint_chains_exist)
+		return;
+
+	// the chains were checked for loops when they were linked
+	for (c = 0; c < hint_chain_count; c++)
+		for (ent = hint_chain_starts[c]; ent; ent = ent->hint_chain)
+			hint_node_count++;
+	if (!hint_node_count)
+		return;
+
+	hint_nodes = (edict_t **)gi.TagMalloc (hint_node_count * sizeof(edict_t *), TAG_LEVEL);
+	hint_cell_next = (int *)gi.TagMalloc (hint_node_count * sizeof(int), TAG_LEVEL);
+	hint_sort = (hintsort_t *)gi.TagMalloc (hint_node_count * sizeof(hintsort_t), TAG_LEVEL);
+	hint_chain_sort = (hintsort_t *)gi.TagMalloc (hint_node_count * sizeof(hintsort_t), TAG_LEVEL);
+	hint_node_index = (int *)gi.TagMalloc (game.maxentities * sizeof(int), TAG_LEVEL);
+	memset (hint_node_index, -1, game.maxentities * sizeof(int));
+
+	n = 0;
+	for (c = 0; c < hint_chain_count; c++)
+	{
+		hint_chain_first[c] = n;
+		VectorCopy (hint_chain_starts[c]->s.origin, hint_chain_mins[c]);
+		VectorCopy (hint_chain_starts[c]->s.origin, hint_chain_maxs[c]);
+		for (ent = hint_chain_starts[c]; ent; ent = ent->hint_chain)
+		{
+			// an end node shared by two chains belongs to the one
+			// its hint_chain_id names, as in touch_hint_path
+			if (ent->hint_chain_id == c)
+				hint_node_index[ent - g_edicts] = n;
+			for (i = 0; i < 3; i++)
+			{
+				if (ent->s.origin[i] < hint_chain_mins[c][i])
+					hint_chain_mins[c][i] = ent->s.origin[i];
+				if (ent->s.origin[i] > hint_chain_maxs[c][i])
+					hint_chain_maxs[c][i] = ent->s.origin[i];
+			}
+			cell = HintPath_Cell (HintPath_CellCoord(ent->s.origin[0]), HintPath_CellCoord(ent->s.origin[1]));
+			hint_cell_next[n] = hint_cell_head[cell];
+			hint_cell_head[cell] = n;
+			hint_nodes[n++] = ent;
+		}
+		hint_chain_length[c] = n - hint_chain_first[c];
+	}
+}
+
+/*
+=====================
+HintPath_FindStarts
+
+Fills in hint_chain_starts with the first node of each chain, in edict
+order. Returns false if the map has no hint_paths.
+=====================
+*/
+static qboolean HintPath_FindStarts (void)
+{
+	int		keyofs;
+	edict_t	*ent;
 
 	// check if there are any hint_paths in this map first
 	hint_chains_exist = 0;
+	hint_chain_count = 0;
 	keyofs = FOFS(classname);
 	ent = G_Find(NULL, keyofs, "hint_path");
-	if (!ent) return; // get outta here
+	if (!ent) return false; // get outta here
 
 	hint_chains_exist = 1;
-	hint_chain_count = 0;
 	memset (hint_chain_starts, 0, MAX_HINT_CHAINS*sizeof (edict_t *));
 	while (ent)
 	{
@@ -75,6 +193,44 @@ void SetupHintPaths (void)
 		}
 		ent = G_Find(ent, keyofs, "hint_path");
 	}
+	return true;
+}
+
+/*
+=====================
+RestoreHintPaths
+
+Called from ReadLevel. The hint_chain links are in the savegame, but
+the chain starts and the graph are not.
+=====================
+*/
+void RestoreHintPaths (void)
+{
+	hint_chains_exist = 0;
+	hint_chain_count = 0;
+	if (!deathmatch->value)
+		HintPath_FindStarts ();
+	HintPath_BuildGraph ();
+}
+
+/*
+=====================
+SetupHintPaths
+
+Called from SpawnEntities in g_spawn.c.
+Initializes all hint_path chains in a map.
+=====================
+*/
+void SetupHintPaths (void)
+{
+	int		i, keyofs;
+	edict_t	*thisPath, *ent;
+
+	if (!HintPath_FindStarts ())
+	{
+		HintPath_BuildGraph ();
+		return;
+	}
 
 	keyofs = FOFS(targetname);
 	for (i=0; i< hint_chain_count; i++)
@@ -117,6 +273,8 @@ void SetupHintPaths (void)
 			}
 		}
 	}
+
+	HintPath_BuildGraph ();
 }
 
 /*
@@ -171,233 +329,161 @@ void hintpath_stop (edict_t *monster)
 		HuntTarget (monster);
 }
 
+static int HintPath_SortByDist (const void *a, const void *b)
+{
+	float	d = ((hintsort_t *)a)->dist - ((hintsort_t *)b)->dist;
+
+	return (d < 0) ? -1 : (d > 0);
+}
+
 /*
 =====================
-hintcheck_monsterlost
+HintPath_NodesNear
 
-Has a monster look for a valid hintpath that will lead to its enemy.
-One endpoint of a valid path must be visible to the monster, and the other to the monster's enemy.
+Fills in list with the nodes closer than HINT_NODE_RANGE to ent,
+nearest first. If chain is not -1, only that chain's nodes are listed.
 =====================
 */
-#define HINT_NODE_RANGE 512
-qboolean hintcheck_monsterlost (edict_t *monster)
+static int HintPath_NodesNear (edict_t *ent, int chain, hintsort_t *list)
 {
-	edict_t		*ent;
-	edict_t		*monster_node_list, *target_node_list, *prev_node;
-	edict_t		*closest_node, *start_node, *dest_node;
-	int			i;
-	float		node_dist, closest_dist;
-	qboolean	monster_pathchains_listed[MAX_HINT_CHAINS], target_pathchains_listed[MAX_HINT_CHAINS];
-	qboolean	nodes_found = false;
-
-	// If monster is standing at post, has no enemy,
-	// or there are no hint_path chains in this map, get outta here.
-	if ((monster->monsterinfo.aiflags & AI_STAND_GROUND)
-		|| !monster->enemy || !hint_chains_exist)
-		return false;
+	int		i, x, y, dx, dy, count;
+	float	dist;
+	edict_t	*node;
 
-	monster_node_list = NULL;
-	// Create linked list of all hint_path nodes in level
-	for (i=0; i < hint_chain_count; i++)
+	count = 0;
+	if (chain >= 0)
 	{
-		ent = hint_chain_starts[i];
-		while (ent)
-		{	// Clean up previous monster_hint_chain pointers
-			if (ent->monster_hint_chain)
-				ent->monster_hint_chain = NULL;
-			if (!monster_node_list)  // add first node
-			{
-				monster_node_list = ent;
-				prev_node = ent;
-			}
-			else
+		for (i = hint_chain_first[chain]; i < hint_chain_first[chain] + hint_chain_length[chain]; i++)
+		{
+			dist = realrange (ent, hint_nodes[i]);
+			if (dist < HINT_NODE_RANGE)
 			{
-				prev_node->monster_hint_chain = ent;
-				prev_node = ent;
+				list[count].dist = dist;
+				list[count++].node = i;
 			}
-			ent = ent->hint_chain;
 		}
 	}
-	
-	// Remove inaccessible to monster nodes from monster_node_list linked list.
-	ent = monster_node_list;
-	prev_node = NULL;
-	while (ent)
+	else
 	{
-		node_dist = realrange (monster, ent);
-		if (node_dist > HINT_NODE_RANGE || !visible(monster, ent))
+		x = HintPath_CellCoord (ent->s.origin[0]);
+		y = HintPath_CellCoord (ent->s.origin[1]);
+		for (dx = -1; dx <= 1; dx++)
 		{
-			if (!prev_node)
-			{
-				edict_t *temp = ent;
-				ent = ent->monster_hint_chain;
-				temp->monster_hint_chain = NULL;
-				// Since there is no previous valid node, move start pointer up to our new position.
-				monster_node_list = ent;
-				continue;
-			}
-			else
+			for (dy = -1; dy <= 1; dy++)
 			{
-				prev_node->monster_hint_chain = ent->monster_hint_chain;
-				ent->monster_hint_chain = NULL;
-				ent = prev_node->monster_hint_chain;
-				continue;
+				for (i = hint_cell_head[HintPath_Cell(x + dx, y + dy)]; i >= 0; i = hint_cell_next[i])
+				{
+					node = hint_nodes[i];
+					// other cells can share the bucket
+					if (HintPath_CellCoord(node->s.origin[0]) != x + dx || HintPath_CellCoord(node->s.origin[1]) != y + dy)
+						continue;
+					dist = realrange (ent, node);
+					if (dist < HINT_NODE_RANGE)
+					{
+						list[count].dist = dist;
+						list[count++].node = i;
+					}
+				}
 			}
 		}
-		nodes_found = true;
-		prev_node = ent;
-		ent = ent->monster_hint_chain;
 	}
 
-	// If no hint_path nodes are accessible to the monster, get outta here.
-	if (!nodes_found) return false;
+	qsort (list, count, sizeof(hintsort_t), HintPath_SortByDist);
+	return count;
+}
 
 /*
-	We now have a linked list of all hint_path nodes accessible to the monster.
+=====================
+HintPath_ChainDest
 
-	The next step is to create a list of pathchains that the monster can access.
+Returns the node on chain closest to ent that ent can see, or NULL
+=====================
 */
+static edict_t *HintPath_ChainDest (edict_t *ent, int chain)
+{
+	int		i, count;
+	vec3_t	v;
 
-	// Go through all monster- accessible nodes to see which pathchains have nodes in the linked list.
-	for (i=0; i < hint_chain_count; i++)
-		monster_pathchains_listed[i] = false;
-	ent = monster_node_list;
-	while (ent)
-	{	// catch errors
-		if ((ent->hint_chain_id < 0) || (ent->hint_chain_id > hint_chain_count))
-			return false;
-		monster_pathchains_listed[ent->hint_chain_id] = true;
-		ent = ent->monster_hint_chain;
-	}
-
-	// Build a linked list of all nodes in the pathchains accessible to the monster.
-	// This will be used to find nodes that are accessible to the monster's enemy.
-	target_node_list = NULL;
-	prev_node = NULL;
-	for (i=0; i < hint_chain_count; i++)
+	// skip the chain without a trace if its box is out of range
+	for (i = 0; i < 3; i++)
 	{
-		if (monster_pathchains_listed[i]) // If pathchain is listed, add it to our new linked list.
-		{
-			ent = hint_chain_starts[i];
-			while (ent)
-			{
-				if (!target_node_list) // add first node
-				{
-					target_node_list = ent;
-					prev_node = ent;
-				}
-				else
-				{
-					prev_node->target_hint_chain = ent;
-					prev_node = ent;
-				}
-				ent = ent->hint_chain;
-			}
-		}
+		if (ent->s.origin[i] < hint_chain_mins[chain][i])
+			v[i] = hint_chain_mins[chain][i] - ent->s.origin[i];
+		else if (ent->s.origin[i] > hint_chain_maxs[chain][i])
+			v[i] = ent->s.origin[i] - hint_chain_maxs[chain][i];
+		else
+			v[i] = 0;
 	}
+	if (VectorLength(v) >= HINT_NODE_RANGE)
+		return NULL;
 
-	// Remove inaccessible to monster's enemy nodes from target_node_list linked list.
-	ent = target_node_list;
-	prev_node = NULL;
-	nodes_found = false;
-	while (ent)
+	count = HintPath_NodesNear (ent, chain, hint_chain_sort);
+	for (i = 0; i < count; i++)
 	{
-		node_dist = realrange (monster->enemy, ent);
-		if (node_dist > HINT_NODE_RANGE || !visible(monster->enemy, ent))
-		{
-			if (!prev_node)
-			{
-				edict_t *temp = ent;
-				ent = ent->target_hint_chain;
-				temp->target_hint_chain = NULL;
-				// Since there is no previous valid node, move start pointer up to our new position.
-				target_node_list = ent;
-				continue;
-			}
-			else
-			{
-				prev_node->target_hint_chain = ent->target_hint_chain;
-				ent->target_hint_chain = NULL;
-				ent = prev_node->target_hint_chain;
-				continue;
-			}
-		}
-		nodes_found = true;
-		prev_node = ent;
-		ent = ent->target_hint_chain;
+		if (visible(ent, hint_nodes[hint_chain_sort[i].node]))
+			return hint_nodes[hint_chain_sort[i].node];
 	}
-	
-	// If no hint_path nodes would bring us to our enemy, get outta here.
-	if (!nodes_found) return false;
+	return NULL;
+}
 
 /*
-	We now have two linked lists- one of hint_path nodes accessible to the monster, and one of hint_path nodes
-	near the monster's enemy that are accessible from nodes near the monster.
-	
-	The next step is to find the closest node near the monster that will lead it to its enemy,
+=====================
+hintcheck_monsterlost
+
+Has a monster look for a valid hintpath that will lead to its enemy.
+One endpoint of a valid path must be visible to the monster, and the other to the monster's enemy.
+
+The closest node the monster can see wins, as long as its chain passes
+near enough to the enemy. Nodes are tried nearest first, so only the
+nodes up to that one are traced, and each chain at most once for the
+enemy.
+=====================
 */
+qboolean hintcheck_monsterlost (edict_t *monster)
+{
+	edict_t		*start_node, *dest_node;
+	edict_t		*chain_dest[MAX_HINT_CHAINS];
+	qboolean	chain_checked[MAX_HINT_CHAINS];
+	int			i, c, count;
 
-	// Go through all monster's enemy-accessible nodes to see which pathchains have nodes in the linked list.
-	for (i=0; i < hint_chain_count; i++)
-		target_pathchains_listed[i] = false;
-	ent = target_node_list;
-	while (ent)
-	{	// catch errors
-		if ((ent->hint_chain_id < 0) || (ent->hint_chain_id > hint_chain_count))
-			return false;
-		target_pathchains_listed[ent->hint_chain_id] = true;
-		ent = ent->target_hint_chain;
-	}
-	
-	// Go through monster_node_list linked list to find the closest node to us
-	// that leads to the monster's enemy (on the list).
-	closest_dist = HINT_NODE_RANGE;
-	closest_node = NULL;
-	ent = monster_node_list;
-	while (ent)
-	{
-		if (target_pathchains_listed[ent->hint_chain_id])
-		{
-			node_dist = realrange(monster, ent);
-			if (node_dist < closest_dist)
-			{
-				closest_node = ent;
-				closest_dist = node_dist;
-			}
-		}
-		ent = ent->monster_hint_chain;
-	}
+	// If monster is standing at post, has no enemy,
+	// or there are no hint_path chains in this map, get outta here.
+	if ((monster->monsterinfo.aiflags & AI_STAND_GROUND)
+		|| !monster->enemy || !hint_chains_exist || !hint_node_count)
+		return false;
 
-	// If there are no nodes close enough that take us to our enemy, get outta here.
-	if (!closest_node) return false;
-	start_node = closest_node;
+	count = HintPath_NodesNear (monster, -1, hint_sort);
+	if (!count)
+		return false;
 
-	// Finally we go through target_node_list linked list to find the node closest to
-	// our target that is on the pathchain the monster will be using.
-	closest_dist = HINT_NODE_RANGE;
-	closest_node = NULL;
-	ent = target_node_list;
-	while (ent)
+	for (c = 0; c < hint_chain_count; c++)
+		chain_checked[c] = false;
+
+	for (i = 0; i < count; i++)
 	{
-		if (ent->hint_chain_id == start_node->hint_chain_id)
+		start_node = hint_nodes[hint_sort[i].node];
+		c = start_node->hint_chain_id;
+		// catch errors
+		if ((c < 0) || (c >= hint_chain_count))
+			continue;
+		if (chain_checked[c] && !chain_dest[c])
+			continue;
+		if (!visible(monster, start_node))
+			continue;
+		if (!chain_checked[c])
 		{
-			node_dist = realrange(monster->enemy, ent);
-			if (node_dist < closest_dist)
-			{
-				closest_node = ent;
-				closest_dist = node_dist;
-			}
+			chain_dest[c] = HintPath_ChainDest (monster->enemy, c);
+			chain_checked[c] = true;
 		}
-		ent = ent->target_hint_chain;
-	}
-
-	// If there is no node close enough to our enemy, get outta here.
-	if (!closest_node) return false;
-	dest_node = closest_node;
+		dest_node = chain_dest[c];
+		if (!dest_node)
+			continue;
 
-	monster->monsterinfo.goal_hint = dest_node;
-	hintpath_start (monster, start_node);
-	return true;
+		monster->monsterinfo.goal_hint = dest_node;
+		hintpath_start (monster, start_node);
+		return true;
+	}
+	return false;
 }
 
 
@@ -410,8 +496,8 @@ A monster has touched a hint_path node
 */
 void touch_hint_path (edict_t *hintpath, edict_t *monster, cplane_t *plane, csurface_t *surf)
 {
-	qboolean	parsedGoal = false;
-	edict_t		*ent, *goalPath, *nextPath = NULL;
+	edict_t		*goalPath, *nextPath = NULL;
+	int			cur, goal, first;
 
 	if (monster->monsterinfo.aiflags & AI_MEDIC_PATROL) 
 	{
@@ -439,29 +525,20 @@ void touch_hint_path (edict_t *hintpath, edict_t *monster, cplane_t *plane, csur
 	}
 
 	// get next hint_path for monster to travel to
-	ent = hint_chain_starts[hintpath->hint_chain_id];
-	while (ent)
+	cur = hint_node_index ? hint_node_index[hintpath - g_edicts] : -1;
+	if (cur >= 0)
 	{
-		// If we encounter this node first (before destination),
-		// then send monster to the next node on the chain.
-		if (hintpath == ent)
-		{
-			nextPath = ent->hint_chain;
-			break;
-		}
-
-		// If we encounter the destination node first, raise flag.
-		if (goalPath == ent) parsedGoal = true;
+		goal = goalPath ? hint_node_index[goalPath - g_edicts] : -1;
+		first = hint_chain_first[hintpath->hint_chain_id];
 
-		// If we found the destination node before the current node,
+		// If the destination node is before this one on the chain,
 		// then we are going in the opposite direction of the chain.
 		// So send the monster to the node preceeding this one.
-		if (parsedGoal && (hintpath == ent->hint_chain))
-		{
-			nextPath = ent;
-			break;
-		}
-		ent = ent->hint_chain;
+		// Otherwise send monster to the next node on the chain.
+		if (goal >= first && goal < cur)
+			nextPath = hint_nodes[cur - 1];
+		else if (cur + 1 < first + hint_chain_length[hintpath->hint_chain_id])
+			nextPath = hint_nodes[cur + 1];
 	}
 
 	// If for some reason we couldn't find the next node, get outta here.
@@ -0,0 +1,353 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+#include "pak.h"
+
+/*
+==============================================================================
+
+PAK DIRECTORY CACHE
+
+The alias script, target_text and the model patching code all need to
+find files inside pak0.pak - pak9.pak. Each of them used to open every
+pak, read its header and walk its whole directory on every call.
+
+The directory of each pak is now read once, the first time its folder
+is searched (InitGame does this for the game folder and baseq2), and
+the names are hashed. Each pak keeps one open file handle for reads
+until ShutdownGame.
+
+When one name is in several paks, the lowest-numbered pak wins. Within
+one pak, the first directory entry wins. That is the order the old loops
+searched in.
+
+==============================================================================
+*/
+
+#define	MAX_PAK_DIRS		8
+#define	MAX_PAKS_PER_DIR	10		// pak0.pak - pak9.pak
+#define	PAK_HASH_SIZE		1024	// must be a power of 2
+
+typedef struct
+{
+	FILE		*handle;		// NULL until the first read
+	int			numfiles;
+	pak_item_t	*files;
+} pakfile_t;
+
+typedef struct
+{
+	char		path[MAX_OSPATH];	// folder holding the paks
+	pakfile_t	paks[MAX_PAKS_PER_DIR];
+	int			head[PAK_HASH_SIZE];	// first entry in each bucket, -1 if empty
+	int			*next;				// next entry in the same bucket
+	int			*entries;			// pak number * 65536 + file number
+	int			numentries;
+} pakdir_t;
+
+static pakdir_t	*pakdirs[MAX_PAK_DIRS];
+static int		num_pakdirs;
+
+static int Pak_Hash (const char *s)
+{
+	unsigned int	hash = 0;
+	int				c;
+
+	// case-insensitive, to agree with Q_strcasecmp
+	while ((c = *(unsigned char *)s++) != 0)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hash = hash * 31 + c;
+	}
+	return hash & (PAK_HASH_SIZE - 1);
+}
+
+/*
+=================
+Pak_ReadDirectory
+
+Reads the directory of one pak file. Returns false if the file is
+missing or is not a pak.
+=================
+*/
+static qboolean Pak_ReadDirectory (char *filename, pakfile_t *pak)
+{
+	FILE			*f;
+	pak_header_t	pakheader;
+	int				numitems;
+
+	pak->handle = NULL;
+	pak->numfiles = 0;
+	pak->files = NULL;
+
+	if (NULL == (f = fopen(filename, "rb")))
+		return false;
+
+	if (fread(&pakheader,1,sizeof(pak_header_t),f) < sizeof(pak_header_t)
+		|| pakheader.id[0] != 'P' || pakheader.id[1] != 'A'
+		|| pakheader.id[2] != 'C' || pakheader.id[3] != 'K')
+	{
+		fclose(f);
+		return false;
+	}
+
+	numitems = pakheader.dsize/sizeof(pak_item_t);
+	if (numitems <= 0 || numitems >= 65536)
+	{
+		fclose(f);
+		return false;
+	}
+
+	pak->files = (pak_item_t *)gi.TagMalloc (numitems * sizeof(pak_item_t), TAG_GAME);
+	fseek(f,pakheader.dstart,SEEK_SET);
+	pak->numfiles = (int)fread(pak->files,sizeof(pak_item_t),numitems,f);
+	fclose(f);
+
+	return (pak->numfiles > 0);
+}
+
+/*
+=================
+Pak_IndexDir
+
+Reads the directories of all the paks in path and hashes their names
+=================
+*/
+static pakdir_t *Pak_IndexDir (const char *path)
+{
+	pakdir_t	*dir;
+	pakfile_t	*pak;
+	char		pakfile[MAX_OSPATH];
+	int			i, k, h, total;
+
+	if (num_pakdirs == MAX_PAK_DIRS)
+		return NULL;
+
+	dir = (pakdir_t *)gi.TagMalloc (sizeof(pakdir_t), TAG_GAME);
+	memset (dir, 0, sizeof(pakdir_t));
+	strncpy (dir->path, path, sizeof(dir->path)-1);
+
+	total = 0;
+	for (i=0; i<MAX_PAKS_PER_DIR; i++)
+	{
+		if (dir->path[0])
+			Com_sprintf (pakfile, sizeof(pakfile), "%s/pak%d.pak", dir->path, i);
+		else
+			Com_sprintf (pakfile, sizeof(pakfile), "pak%d.pak", i);
+		if (Pak_ReadDirectory (pakfile, &dir->paks[i]))
+			total += dir->paks[i].numfiles;
+	}
+
+	for (h=0; h<PAK_HASH_SIZE; h++)
+		dir->head[h] = -1;
+
+	if (total)
+	{
+		dir->next = (int *)gi.TagMalloc (total * sizeof(int), TAG_GAME);
+		dir->entries = (int *)gi.TagMalloc (total * sizeof(int), TAG_GAME);
+
+		// link in reverse so each chain ends up in search order
+		for (i=MAX_PAKS_PER_DIR-1; i>=0; i--)
+		{
+			pak = &dir->paks[i];
+			for (k=pak->numfiles-1; k>=0; k--)
+			{
+				pak->files[k].name[sizeof(pak->files[k].name)-1] = 0;
+				h = Pak_Hash (pak->files[k].name);
+				dir->entries[dir->numentries] = (i << 16) | k;
+				dir->next[dir->numentries] = dir->head[h];
+				dir->head[h] = dir->numentries;
+				dir->numentries++;
+			}
+		}
+	}
+
+	pakdirs[num_pakdirs++] = dir;
+	return dir;
+}
+
+static pakdir_t *Pak_GetDir (const char *path)
+{
+	int		i;
+
+	for (i=0; i<num_pakdirs; i++)
+	{
+		if (!Q_strcasecmp(pakdirs[i]->path, (char *)path))
+			return pakdirs[i];
+	}
+	return Pak_IndexDir (path);
+}
+
+/*
+=================
+Pak_GameDir
+
+Folder holding the current game's paks, basedir/gamedir (just basedir
+when no game is set).
+=================
+*/
+void Pak_GameDir (char *output, int size)
+{
+	cvar_t	*basedir, *gamedir;
+
+	basedir = gi.cvar("basedir", "", 0);
+	gamedir = gi.cvar("gamedir", "", 0);
+	if (strlen(gamedir->string))
+		Com_sprintf (output, size, "%s/%s", basedir->string, gamedir->string);
+	else
+		Com_sprintf (output, size, "%s", basedir->string);
+}
+
+/*
+=================
+Pak_Init
+
+Called from InitGame. Indexes the pak files of the game folder and
+baseq2.
+=================
+*/
+void Pak_Init (void)
+{
+	char	path[MAX_OSPATH];
+
+	num_pakdirs = 0;
+
+	Pak_GameDir (path, sizeof(path));
+	Pak_GetDir (path);
+	Pak_GetDir ("baseq2");
+}
+
+/*
+=================
+Pak_Shutdown
+
+Called from ShutdownGame
+=================
+*/
+void Pak_Shutdown (void)
+{
+	int		i, k;
+
+	for (i=0; i<num_pakdirs; i++)
+	{
+		for (k=0; k<MAX_PAKS_PER_DIR; k++)
+		{
+			if (pakdirs[i]->paks[k].handle)
+				fclose (pakdirs[i]->paks[k].handle);
+			pakdirs[i]->paks[k].handle = NULL;
+		}
+	}
+	num_pakdirs = 0;
+}
+
+/*
+=================
+Pak_FindFile
+
+Looks for name in pak0.pak - pak9.pak in the folder path. Fills in
+entry and returns true if found.
+=================
+*/
+qboolean Pak_FindFile (const char *path, const char *name, pakentry_t *entry)
+{
+	pakdir_t	*dir;
+	pak_item_t	*item;
+	int			i, p, k;
+
+	if (!(dir = Pak_GetDir(path)))
+		return false;
+
+	for (i = dir->head[Pak_Hash(name)]; i >= 0; i = dir->next[i])
+	{
+		p = dir->entries[i] >> 16;
+		k = dir->entries[i] & 0xffff;
+		item = &dir->paks[p].files[k];
+		if (!Q_strcasecmp(item->name, (char *)name))
+		{
+			if (entry)
+			{
+				entry->dir = dir;
+				entry->pak = p;
+				entry->start = item->start;
+				entry->size = item->size;
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+=================
+Pak_OpenFile
+
+Returns the pak's file handle positioned at the start of entry. The
+handle is shared, so the caller must not close it, and must read what
+it needs before the next Pak_ call.
+=================
+*/
+FILE *Pak_OpenFile (pakentry_t *entry)
+{
+	pakdir_t	*dir = (pakdir_t *)entry->dir;
+	pakfile_t	*pak = &dir->paks[entry->pak];
+	char		pakfile[MAX_OSPATH];
+
+	if (!pak->handle)
+	{
+		if (dir->path[0])
+			Com_sprintf (pakfile, sizeof(pakfile), "%s/pak%d.pak", dir->path, entry->pak);
+		else
+			Com_sprintf (pakfile, sizeof(pakfile), "pak%d.pak", entry->pak);
+		if (NULL == (pak->handle = fopen(pakfile, "rb")))
+			return NULL;
+	}
+	fseek (pak->handle, entry->start, SEEK_SET);
+	return pak->handle;
+}
+
+/*
+=================
+Pak_LoadFile
+
+Reads a whole file out of the paks in path into TAG_LEVEL memory, with
+extra zeroed bytes after it. Returns NULL if the file is not found.
+=================
+*/
+byte *Pak_LoadFile (const char *path, const char *name, int *size, int extra)
+{
+	pakentry_t	entry;
+	FILE		*f;
+	byte		*buffer;
+
+	if (!Pak_FindFile (path, name, &entry))
+		return NULL;
+	if (!(f = Pak_OpenFile (&entry)))
+		return NULL;
+
+	buffer = (byte *)gi.TagMalloc (entry.size + extra, TAG_LEVEL);
+	if (!buffer)
+		return NULL;
+	memset (buffer + entry.size, 0, extra);
+	*size = (int)fread (buffer, 1, entry.size, f);
+	return buffer;
+}
@@ -41,6 +41,135 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #define MAX_MD2SKINS	32
 #define MAX_SKINNAME	64
 
+/*
+==============================================================================
+
+PATCHED MODEL CACHE
+
+PatchPlayerModels, PatchMonsterModel and PatchDeadSoldier write copies
+of id models with extra skin slots into the moddir. Each output is
+checked once per game: the first time a model is asked for, its
+header and skin list are compared with the skins the patcher would
+write, and the file's length with the header's ofs_end. A copy that
+matches is used as it is without opening the source model; one that
+doesn't (an older skin set, or a write that was cut short) is patched
+again. After that, asking for the same model again is a lookup.
+
+New copies are written to a temporary file and renamed into place, so
+an interrupted write never leaves a broken model behind.
+
+==============================================================================
+*/
+
+#define	MAX_PATCHED_MODELS	64
+
+static char	patched_models[MAX_PATCHED_MODELS][MAX_OSPATH];
+static int	num_patched_models;
+
+/*
+=================
+PatchedModel_Checked
+
+True if outfilename was already checked or written this game
+=================
+*/
+qboolean PatchedModel_Checked (char *outfilename)
+{
+	int		i;
+
+	for (i = 0; i < num_patched_models; i++)
+		if (!Q_strcasecmp (patched_models[i], outfilename))
+			return true;
+	return false;
+}
+
+static void PatchedModel_Remember (char *outfilename)
+{
+	if (num_patched_models < MAX_PATCHED_MODELS && !PatchedModel_Checked (outfilename))
+		Q_strncpyz (patched_models[num_patched_models++], outfilename, MAX_OSPATH);
+}
+
+/*
+=================
+PatchedModel_Valid
+
+True if outfilename exists and holds exactly these skins. Remembers
+it either way.
+=================
+*/
+qboolean PatchedModel_Valid (char *outfilename, int numskins, char *skins, int skinsize)
+{
+	FILE	*f;
+	dmdl_t	model;
+	char	*stored;
+	long	length;
+	qboolean valid;
+
+	PatchedModel_Remember (outfilename);
+
+	if ( !(f = fopen (outfilename, "rb")) )
+		return false;
+
+	valid = false;
+	if ( fread (&model, sizeof(dmdl_t), 1, f) == 1
+		&& model.num_skins == numskins
+		&& model.ofs_skins == sizeof(dmdl_t)
+		&& model.ofs_end > model.ofs_skins + skinsize )
+	{
+		fseek (f, 0, SEEK_END);
+		length = ftell (f);
+		if (length == model.ofs_end)
+		{
+			stored = (char *)G_Malloc (skinsize);
+			fseek (f, model.ofs_skins, SEEK_SET);
+			if (fread (stored, 1, skinsize, f) == skinsize && !memcmp (stored, skins, skinsize))
+				valid = true;
+			G_Free (stored);
+		}
+	}
+	fclose (f);
+
+	if (!valid)
+		gi.dprintf ("%s is out of date, patching it again\n", outfilename);
+	return valid;
+}
+
+/*
+=================
+PatchedModel_Write
+
+Writes the patched header, skins and the rest of the source model
+through a temporary file
+=================
+*/
+qboolean PatchedModel_Write (char *outfilename, dmdl_t *model, char *skins, int skinsize, byte *data, int datasize)
+{
+	char	tempname[MAX_OSPATH];
+	FILE	*f;
+	qboolean ok;
+
+	PatchedModel_Remember (outfilename);
+
+	Com_sprintf (tempname, sizeof(tempname), "%s.tmp", outfilename);
+	if ( !(f = fopen (tempname, "wb")) )
+		return false;
+
+	ok = fwrite (model, sizeof (dmdl_t), 1, f) == 1;
+	ok = ok && fwrite (skins, sizeof (char), skinsize, f) == skinsize;
+	ok = ok && fwrite (data, sizeof (byte), datasize, f) == datasize;
+	if (fclose (f))
+		ok = false;
+
+	if (ok)
+	{
+		remove (outfilename);
+		ok = !rename (tempname, outfilename);
+	}
+	if (!ok)
+		remove (tempname);
+	return ok;
+}
+
 // Argh! - loads id baseq2/player models, "patches" their skin links 
 //         for misc_actor (all id skins, and slots for 10 custom 
 //         skins), and saves them to the current moddir location
@@ -54,7 +183,6 @@ int PatchPlayerModels (char *modelname)
 	char	infilename[MAX_OSPATH];
 	char	outfilename[MAX_OSPATH];
 	FILE	*infile;
-	FILE	*outfile;
 	dmdl_t	model;		// model header
 	byte	*data;		// model data
 	int		datasize;	// model data size (bytes)
@@ -66,13 +194,8 @@ int PatchPlayerModels (char *modelname)
 		return 0;	// we're in baseq2
 
 	sprintf (outfilename, "%s/players/%s/tris.md2", game->string, modelname);
-	if ((outfile = fopen (outfilename, "rb")))
-	{
-		// output file already exists, move along
-		fclose (outfile);
-//		gi.dprintf ("PatchPlayerModels: Could not save %s, file already exists\n", outfilename);
+	if (PatchedModel_Checked (outfilename))
 		return 0;
-	}
 
 	// clear skin names (just in case)
 	for (j = 0; j < MAX_MD2SKINS; j++)
@@ -127,6 +250,12 @@ int PatchPlayerModels (char *modelname)
 		sprintf( skins[j], "players/%s/custom%d.pcx", modelname, j-numskins+1);
 	numskins = 32;
 
+	if (PatchedModel_Valid (outfilename, numskins, (char *)skins, numskins * MAX_SKINNAME))
+	{
+		// output file already exists, move along
+		return 0;
+	}
+
 	// load original player model
 	sprintf (infilename, "baseq2/players/%s/tris.md2", modelname);
 	if ( !(infile = fopen (infilename, "rb")) )
@@ -161,7 +290,7 @@ int PatchPlayerModels (char *modelname)
 	_mkdir (outfilename);
 	sprintf (outfilename, "%s/players/%s/tris.md2", game->string, modelname);
 	
-	if ( !(outfile = fopen (outfilename, "wb")) )
+	if ( !PatchedModel_Write (outfilename, &model, (char *)skins, newoffset, data, datasize) )
 	{
 		// file couldn't be created for some other reason
 		gi.dprintf ("PatchPlayerModels: Could not save %s\n", outfilename);
@@ -169,11 +298,6 @@ int PatchPlayerModels (char *modelname)
 		return 0;
 	}
 	
-	fwrite (&model, sizeof (dmdl_t), 1, outfile);
-	fwrite (skins, sizeof (char), newoffset, outfile);
-	fwrite (data, sizeof (byte), datasize, outfile);
-	
-	fclose (outfile);
 	gi.dprintf ("PatchPlayerModels: Saved %s\n", outfilename);
 	G_Free(data);
 	return 1;
@@ -355,7 +355,7 @@ deadstop:
 void pendulum_rotate (edict_t *self)
 {
 	float	this_angle;
-	float	wave;
+	float	wave, coswave;
 	float	sgor;
 
 	if(!(self->spawnflags & SF_PENDULUM_STARTON))
@@ -394,9 +394,10 @@ void pendulum_rotate (edict_t *self)
 
 		sgor = sqrt( (float)sv_gravity->value / self->radius );
 		wave = sgor * (level.framenum - self->startframe) * 0.1;
-		this_angle = self->moveinfo.start_angles[ROLL] * cos(wave);
+		coswave = cos(wave);
+		this_angle = self->moveinfo.start_angles[ROLL] * coswave;
 		self->avelocity[ROLL] = -self->moveinfo.start_angles[ROLL] * sgor * sin(wave);
-		if( (self->spawnflags & SF_PENDULUM_STOPPING) && (cos(wave) > 0.0))
+		if( (self->spawnflags & SF_PENDULUM_STOPPING) && (coswave > 0.0))
 		{
 			if( ((old_velocity > 0) && (self->avelocity[ROLL] <= 0)) ||
 				((old_velocity < 0) && (self->avelocity[ROLL] >= 0))    )
@@ -205,7 +205,10 @@ qboolean SV_RunThink (edict_t *ent)
 	ent->nextthink = 0;
 	if (!ent->think)
 		gi.error ("NULL ent->think for %s",ent->classname);
-	ent->think (ent);
+	if (prof_active)
+		Rep_Think (ent);
+	else
+		ent->think (ent);
 
 	return false;
 }
@@ -797,12 +800,75 @@ pushed_t	pushed[MAX_EDICTS], *pushed_p;
 
 edict_t	*obstacle;
 
-void MoveRiders(edict_t *platform, edict_t *ignore, vec3_t move, vec3_t amove, qboolean turn)
+/*
+============
+Rider lists
+
+MoveRiders and RiderMass used to scan every edict for the riders of a
+platform, and again for the riders of each rider, so a stack of crates
+on a train cost a full scan per crate. Instead one pass links every
+edict into the list of the entity it stands on and the stack is walked
+from there, which costs one scan per call however tall it is. Lists
+keep edict order, so riders are still moved in the order they were.
+
+For RiderMass the pass also links a func_pushable under whatever a
+short trace down finds, since swimming pushables have no groundentity
+even when they sit on another one.
+============
+*/
+#define RIDER_MAX_DEPTH	32
+
+static short	rider_first[MAX_EDICTS];		// first link for each platform, -1 if none
+static short	rider_next[MAX_EDICTS*2];
+static short	rider_ent[MAX_EDICTS*2];
+
+static void RiderLink (int *links, edict_t *platform, edict_t *rider)
+{
+	int	p = platform - g_edicts;
+	int	l = (*links)++;
+
+	rider_ent[l] = rider - g_edicts;
+	rider_next[l] = rider_first[p];
+	rider_first[p] = l;
+}
+
+static void BuildRiderLists (qboolean swimming)
 {
-	int	i;
+	int		i, links;
 	edict_t	*rider;
+	trace_t	trace;
+	vec3_t	point;
+
+	memset (rider_first, -1, sizeof(rider_first));
+	links = 0;
 
-	for(i=1, rider=g_edicts+i; i<=globals.num_edicts; i++, rider++) {
+	// walk backwards so every list comes out in edict order
+	for(i=min(globals.num_edicts,MAX_EDICTS)-1; i>0; i--) {
+		rider = g_edicts+i;
+		if(!rider->inuse) continue;
+		if(swimming && rider->movetype == MOVETYPE_PUSHABLE) {
+			VectorCopy(rider->s.origin,point);
+			point[2] -= 0.25;
+			trace = gi.trace (rider->s.origin, rider->mins, rider->maxs, point, rider, MASK_MONSTERSOLID);
+			if (!trace.startsolid && !trace.allsolid && trace.plane.normal[2] >= 0.7
+				&& trace.ent && trace.ent != rider->groundentity && trace.ent != rider)
+				RiderLink (&links, trace.ent, rider);
+		}
+		if(rider->groundentity && rider->groundentity != rider)
+			RiderLink (&links, rider->groundentity, rider);
+	}
+}
+
+static void MoveRiders_r (edict_t *platform, edict_t *ignore, vec3_t move, vec3_t amove, qboolean turn, int depth)
+{
+	int		l;
+	edict_t	*rider;
+
+	if(depth > RIDER_MAX_DEPTH)
+		return;
+
+	for(l=rider_first[platform-g_edicts]; l>=0; l=rider_next[l]) {
+		rider = g_edicts+rider_ent[l];
 		if((rider->groundentity == platform) && (rider != ignore)) {
 			VectorAdd(rider->s.origin,move,rider->s.origin);
 			if (turn && (amove[YAW] != 0.)) {
@@ -832,11 +898,17 @@ void MoveRiders(edict_t *platform, edict_t *ignore, vec3_t move, vec3_t amove, q
 				gi.linkentity(rider);
 			} else {
 				// move this rider's riders
-				MoveRiders(rider,ignore,move,amove,turn);
+				MoveRiders_r(rider,ignore,move,amove,turn,depth+1);
 			}
 		}
 	}
 }
+
+void MoveRiders(edict_t *platform, edict_t *ignore, vec3_t move, vec3_t amove, qboolean turn)
+{
+	BuildRiderLists (false);
+	MoveRiders_r (platform, ignore, move, amove, turn, 0);
+}
 /*
 ============
 RealBoundingBox
@@ -905,6 +977,140 @@ void RealBoundingBox(edict_t *ent, vec3_t mins, vec3_t maxs)
 	}
 }
 
+/*
+============
+SV_PushCandidates
+
+Fills list with the entities SV_Push has to look at, in edict order, and
+returns how many there are. Instead of a sweep over every edict, the
+server's area tree is asked for whatever is linked inside the volume the
+pusher swept this move - its old box, its new box and its real bounding
+box - grown a little so riders resting on top are always included.
+Entities that are not linked anywhere can't be found this way, which is
+the same as the old "not linked in anywhere" test.
+
+The engine gives a rotated brush model a box big enough for any angle,
+so for a turning door or pendulum the old and new boxes are a cube
+around its whole reach. Those pushers pass the real boxes they had
+before and after the move instead, and the volume between those is
+grown by half the arc the farthest corner can travel, which bounds how
+far any point of the brush gets from where it started or ended.
+============
+*/
+static struct
+{
+	int		framenum;			// frame the counters below belong to
+	int		frame_pushes;		// SV_Push calls so far this frame
+	int		frame_candidates;	// entities returned by the broadphase this frame
+	int		frame_moved;		// entities actually pushed this frame
+	int		last_pushes;		// the same for the previous frame
+	int		last_candidates;
+	int		last_moved;
+	int		peak_candidates;	// most candidates in a single frame
+	int		total_pushes;
+	int		total_empty;		// pushes that found nothing in their way
+} push_stats;
+
+static int SV_EdictOrder (const void *a, const void *b)
+{
+	return (int)(*(edict_t **)a - *(edict_t **)b);
+}
+
+static float SV_RotationReach (edict_t *pusher, vec3_t amove)
+{
+	float	r, turn, extent;
+	int		i;
+
+	r = 0;
+	turn = 0;
+	for (i=0 ; i<3 ; i++)
+	{
+		extent = max(fabs(pusher->mins[i]), fabs(pusher->maxs[i]));
+		r += extent * extent;
+		turn += fabs(amove[i]);
+	}
+	return sqrt(r) * turn * (M_PI / 360.0);		// half the arc, in units
+}
+
+static int SV_PushCandidates (vec3_t mins, vec3_t maxs, vec3_t move, vec3_t realmins, vec3_t realmaxs,
+							  edict_t *pusher, vec3_t amove, vec3_t oldmins, vec3_t oldmaxs, edict_t **list)
+{
+	vec3_t	boxmins, boxmaxs;
+	float	reach;
+	int		i, num;
+
+	if (oldmins)
+	{
+		reach = SV_RotationReach (pusher, amove) + 3;	// the engine's 1 unit, and 2 for riders
+		for (i=0 ; i<3 ; i++)
+		{
+			boxmins[i] = min(oldmins[i], realmins[i]) - reach;
+			boxmaxs[i] = max(oldmaxs[i], realmaxs[i]) + reach;
+		}
+	}
+	else
+	{
+		for (i=0 ; i<3 ; i++)
+		{
+			boxmins[i] = min(min(mins[i], mins[i] - move[i]), realmins[i]) - 2;
+			boxmaxs[i] = max(max(maxs[i], maxs[i] - move[i]), realmaxs[i]) + 2;
+		}
+	}
+	num  = gi.BoxEdicts (boxmins, boxmaxs, list, MAX_EDICTS, AREA_SOLID);
+	num += gi.BoxEdicts (boxmins, boxmaxs, list + num, MAX_EDICTS - num, AREA_TRIGGERS);
+
+	// area lists come back in link order; pushes have always gone in edict order
+	if (num > 1)
+		qsort (list, num, sizeof(list[0]), SV_EdictOrder);
+
+	return num;
+}
+
+static void SV_CountPush (int candidates)
+{
+	if (push_stats.framenum != level.framenum)
+	{
+		if (push_stats.framenum == level.framenum - 1)
+		{
+			push_stats.last_pushes = push_stats.frame_pushes;
+			push_stats.last_candidates = push_stats.frame_candidates;
+			push_stats.last_moved = push_stats.frame_moved;
+		}
+		else
+			push_stats.last_pushes = push_stats.last_candidates = push_stats.last_moved = 0;
+		push_stats.frame_pushes = push_stats.frame_candidates = push_stats.frame_moved = 0;
+		push_stats.framenum = level.framenum;
+	}
+	push_stats.frame_pushes++;
+	push_stats.frame_candidates += candidates;
+	push_stats.total_pushes++;
+	if (!candidates)
+		push_stats.total_empty++;
+	if (push_stats.frame_candidates > push_stats.peak_candidates)
+		push_stats.peak_candidates = push_stats.frame_candidates;
+}
+
+/*
+=================
+Svcmd_PushStats_f
+
+"sv pushstats"
+=================
+*/
+void Svcmd_PushStats_f (void)
+{
+	qboolean	current = (push_stats.framenum == level.framenum);
+
+	safe_cprintf (NULL, PRINT_HIGH, "pushes this frame:  %i (%i candidates, %i moved)\n",
+		current ? push_stats.frame_pushes : 0, current ? push_stats.frame_candidates : 0,
+		current ? push_stats.frame_moved : 0);
+	safe_cprintf (NULL, PRINT_HIGH, "pushes last frame:  %i (%i candidates, %i moved)\n",
+		push_stats.last_pushes, push_stats.last_candidates, push_stats.last_moved);
+	safe_cprintf (NULL, PRINT_HIGH, "peak candidates:    %i/frame\n", push_stats.peak_candidates);
+	safe_cprintf (NULL, PRINT_HIGH, "pushes in total:    %i (%i with nothing in the way)\n",
+		push_stats.total_pushes, push_stats.total_empty);
+}
+
 /*
 ============
 SV_Push
@@ -915,15 +1121,17 @@ otherwise riders would continue to slide.
 */
 qboolean SV_Push (edict_t *pusher, vec3_t move, vec3_t amove)
 {
-	int			i, e;
+	int			i, e, num;
 	edict_t		*check, *block;
+	edict_t		*touch[MAX_EDICTS];
 	vec3_t		mins, maxs;
 	pushed_t	*p;
 	vec3_t		org, org2, org_check, forward, right, up;
 	vec3_t		move2={0,0,0};
 	vec3_t		move3={0,0,0};
 	vec3_t		realmins, realmaxs;
-	qboolean	turn;
+	vec3_t		oldmins, oldmaxs;
+	qboolean	turn, rotating;
 	trace_t		tr;
 
 	// clamp the move to 1/8 units, so the position will
@@ -957,6 +1165,13 @@ qboolean SV_Push (edict_t *pusher, vec3_t move, vec3_t amove)
 	VectorSubtract (vec3_origin, amove, org);
 	AngleVectors (org, forward, right, up);
 
+	// a turned brush model gets a real box before and after the move,
+	// rather than the engine's box for every angle
+	rotating = (pusher->solid == SOLID_BSP)
+		&& (!VectorCompare (pusher->s.angles, vec3_origin) || !VectorCompare (amove, vec3_origin));
+	if (rotating)
+		RealBoundingBox (pusher, oldmins, oldmaxs);
+
 // save the pusher's original position
 	pushed_p->ent = pusher;
 	VectorCopy (pusher->s.origin, pushed_p->origin);
@@ -982,10 +1197,16 @@ qboolean SV_Push (edict_t *pusher, vec3_t move, vec3_t amove)
 	//          bounding box at the current angles.
 	RealBoundingBox(pusher,realmins,realmaxs);
 
+	num = SV_PushCandidates (mins, maxs, move, realmins, realmaxs,
+		pusher, amove, rotating ? oldmins : NULL, oldmaxs, touch);
+	SV_CountPush (num);
+
 // see if any solid entities are inside the final position
-	check = g_edicts+1;
-	for (e = 1; e < globals.num_edicts; e++, check++)
+	for (e = 0; e < num; e++)
 	{
+		check = touch[e];
+		if (check == pusher)
+			continue;
 		if (!check->inuse)
 			continue;
 		if (check == pusher->owner)	// Lazarus: owner can't block us
@@ -1041,6 +1262,8 @@ qboolean SV_Push (edict_t *pusher, vec3_t move, vec3_t amove)
 
 		if ((pusher->movetype == MOVETYPE_PUSH) || (pusher->movetype == MOVETYPE_PENDULUM) || (check->groundentity == pusher))
 		{
+			push_stats.frame_moved++;
+
 			// move this entity
 			pushed_p->ent = check;
 			VectorCopy (check->s.origin, pushed_p->origin);
@@ -1423,20 +1646,192 @@ TOSS / BOUNCE
 SV_Physics_Toss
 
 Toss, bounce, and fly movement.  When onground, do nothing.
+
+With sv_toss_substeps above 1, something falling under gravity makes
+the frame's move in that many steps, adding gravity before each, so
+grenades and gibs follow the real arc rather than one that sags a
+little more every frame. Thinking still happens once a frame. While
+nothing is in the way, SV_TossClear makes all the steps with a single
+trace, so only a frame that bounces pays for the extra steps.
+Straight movers (FLY, FLYMISSILE) gain nothing from steps and always
+make one.
 =============
 */
+#define	TOSS_MAX_SUBSTEPS	4
+
+static void SV_TossMove (edict_t *ent, float frametime);
+static void SV_TossFinish (edict_t *ent, vec3_t old_origin);
+
+/*
+=============
+SV_TossClear
+
+Makes all the steps at once if the box swept along the frame's chord,
+grown by how far the arc can bow away from it, hits nothing. Returns
+false, having moved nothing, if something may be in the way.
+=============
+*/
+static qboolean SV_TossClear (edict_t *ent, int steps, float gravity)
+{
+	trace_t	trace;
+	vec3_t	vel, end, mins, maxs, old_origin;
+	float	steptime, bow;
+	int		step, mask;
+
+	steptime = FRAMETIME / steps;
+	VectorCopy (ent->velocity, vel);
+	VectorCopy (ent->s.origin, end);
+	for (step=0 ; step<steps ; step++)
+	{
+		vel[2] -= gravity * steptime;
+		if (VectorLength (vel) > sv_maxvelocity->value)
+			return false;	// SV_CheckVelocity would clip it
+		VectorMA (end, steptime, vel, end);
+	}
+
+	// the steps sag below the chord by at most g*t*t/8
+	bow = fabs(gravity) * FRAMETIME * FRAMETIME * 0.125 + 0.125;
+	VectorCopy (ent->mins, mins);
+	VectorCopy (ent->maxs, maxs);
+	mins[2] -= bow;
+	maxs[2] += bow;
+
+	if (ent->clipmask)
+		mask = ent->clipmask;
+	else
+		mask = MASK_SOLID;
+	trace = gi.trace (ent->s.origin, mins, maxs, end, ent, mask);
+	if (trace.startsolid || trace.allsolid || trace.fraction < 1)
+		return false;
+
+	VectorCopy (ent->s.origin, old_origin);
+	VectorCopy (vel, ent->velocity);
+	VectorMA (ent->s.angles, FRAMETIME, ent->avelocity, ent->s.angles);
+	VectorCopy (end, ent->s.origin);
+	gi.linkentity (ent);
+	G_TouchTriggers (ent);
+	if (!ent->inuse)
+		return true;
+
+	SV_TossFinish (ent, old_origin);
+	return true;
+}
+
 void SV_Physics_Toss (edict_t *ent)
+{
+	int		steps, step;
+	float	gravity;
+
+// regular thinking
+	SV_RunThink (ent);
+
+	steps = (int)sv_toss_substeps->value;
+	if (steps > TOSS_MAX_SUBSTEPS)
+		steps = TOSS_MAX_SUBSTEPS;
+	if (steps <= 1 || !ent->inuse || (ent->flags & FL_TEAMSLAVE)
+		|| (ent->groundentity && ent->velocity[2] <= 0)
+		|| ent->movetype == MOVETYPE_FLY || ent->movetype == MOVETYPE_FLYMISSILE
+		|| ent->movetype == MOVETYPE_VEHICLE || ent->movetype == MOVETYPE_RAIN
+		|| level.time <= ent->gravity_debounce_time)
+	{
+		SV_TossMove (ent, FRAMETIME);
+		return;
+	}
+
+	if (ent->velocity[2] > 0)
+		ent->groundentity = NULL;
+	SV_CheckVelocity (ent);
+	gravity = ent->gravity * sv_gravity->value;
+	if (SV_TossClear (ent, steps, gravity))
+		return;
+
+	for (step=0 ; step<steps ; step++)
+	{
+		SV_TossMove (ent, FRAMETIME / steps);
+		if (!ent->inuse || ent->groundentity)
+			break;
+	}
+}
+
+/*
+=============
+SV_Physics_Missile
+
+The projectile list's SV_Physics_Toss. A MOVETYPE_FLYMISSILE in
+flight, which is what nearly all of them are, needs none of the team,
+ground, conveyor, gravity and bounce handling, so it moves here with
+just the trace, the slide off steep surfaces and the water transition.
+Anything else is moved by SV_TossMove as usual.
+=============
+*/
+void SV_Physics_Missile (edict_t *ent)
 {
 	trace_t		trace;
 	vec3_t		move;
-	float		backoff;
-	edict_t		*slave;
 	qboolean	wasinwater;
 	qboolean	isinwater;
 	vec3_t		old_origin;
 
-// regular thinking
 	SV_RunThink (ent);
+	if (!ent->inuse)
+		return;
+
+	if (ent->movetype != MOVETYPE_FLYMISSILE || ent->groundentity || ent->teamchain || (ent->flags & FL_TEAMSLAVE))
+	{
+		SV_TossMove (ent, FRAMETIME);
+		return;
+	}
+
+	VectorCopy (ent->s.origin, old_origin);
+
+	SV_CheckVelocity (ent);
+
+// move angles
+	VectorMA (ent->s.angles, FRAMETIME, ent->avelocity, ent->s.angles);
+
+// move origin
+	VectorScale (ent->velocity, FRAMETIME, move);
+	trace = SV_PushEntity (ent, move);
+	if (!ent->inuse)
+		return;
+
+	if (trace.fraction < 1 )
+	{
+		// Lazarus - don't stop on steep incline
+		ClipVelocity (ent->velocity, trace.plane.normal, ent->velocity, (trace.plane.normal[2] <= 0.7) ? 1.5 : 1);
+
+	// stop if on ground
+		if (trace.plane.normal[2] > 0.7)
+		{
+			ent->groundentity = trace.ent;
+			ent->groundentity_linkcount = trace.ent->linkcount;
+			VectorCopy (vec3_origin, ent->velocity);
+			VectorCopy (vec3_origin, ent->avelocity);
+		}
+	}
+
+	// check for water transition
+	wasinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
+	ent->watertype = G_EnvContents (ent->s.origin);
+	isinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
+
+	if (isinwater)
+		ent->waterlevel = 1;
+	else
+		ent->waterlevel = 0;
+
+	if (!wasinwater && isinwater)
+		gi.positioned_sound (old_origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
+	else if (wasinwater && !isinwater)
+		gi.positioned_sound (ent->s.origin, g_edicts, CHAN_AUTO, gi.soundindex("misc/h2ohit1.wav"), 1, 1, 0);
+}
+
+static void SV_TossMove (edict_t *ent, float frametime)
+{
+	trace_t		trace;
+	vec3_t		move;
+	float		backoff;
+	vec3_t		old_origin;
 
 	// if not a team captain, so movement will be handled elsewhere
 	if ( ent->flags & FL_TEAMSLAVE)
@@ -1501,13 +1896,16 @@ void SV_Physics_Toss (edict_t *ent)
 	&& ent->movetype != MOVETYPE_FLYMISSILE
 	&& ent->movetype != MOVETYPE_VEHICLE
 	&& ent->movetype != MOVETYPE_RAIN)
-		SV_AddGravity (ent);
+	{
+		if(level.time > ent->gravity_debounce_time)
+			ent->velocity[2] -= ent->gravity * sv_gravity->value * frametime;
+	}
 
 // move angles
-	VectorMA (ent->s.angles, FRAMETIME, ent->avelocity, ent->s.angles);
+	VectorMA (ent->s.angles, frametime, ent->avelocity, ent->s.angles);
 
 // move origin
-	VectorScale (ent->velocity, FRAMETIME, move);
+	VectorScale (ent->velocity, frametime, move);
 	trace = SV_PushEntity (ent, move);
 	if (!ent->inuse)
 		return;
@@ -1547,12 +1945,28 @@ void SV_Physics_Toss (edict_t *ent)
 //			ent->touch (ent, trace.ent, &trace.plane, trace.surface);
 	}
 
+	SV_TossFinish (ent, old_origin);
+}
+
+/*
+=============
+SV_TossFinish
+
+Water transition and teamslaves, after the move
+=============
+*/
+static void SV_TossFinish (edict_t *ent, vec3_t old_origin)
+{
+	edict_t		*slave;
+	qboolean	wasinwater;
+	qboolean	isinwater;
+
 	// Lazarus: MOVETYPE_RAIN doesn't cause splash noises when touching water
 	if(ent->movetype != MOVETYPE_RAIN)
 	{
 		// check for water transition
 		wasinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
-		ent->watertype = gi.pointcontents (ent->s.origin);
+		ent->watertype = G_EnvContents (ent->s.origin);
 		isinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
 
 		if (isinwater)
@@ -1631,41 +2045,113 @@ void SV_AddRotationalFriction (edict_t *ent)
 
 #define WATER_DENSITY 0.00190735
 
-float RiderMass(edict_t *platform)
+static float RiderMass_r (edict_t *platform, int depth)
 {
 	float	mass = 0;
-	int		i;
+	int		l;
 	edict_t	*rider;
-	trace_t	trace;
-	vec3_t	point;
 
-	for(i=1, rider=g_edicts+i; i<=globals.num_edicts; i++, rider++) {
-		if(rider == platform) continue;
-		if(!rider->inuse) continue;
-		if(rider->groundentity == platform) {
-			mass += rider->mass;
-			mass += RiderMass(rider);
-		} else if (rider->movetype == MOVETYPE_PUSHABLE ) {
-			// Bah - special case for func_pushable riders. Swimming
-			// func_pushables don't really have a groundentity, even
-			// though they may be sitting on another swimming
-			// func_pushable, which is what we need to know.
-			VectorCopy(rider->s.origin,point);
-			point[2] -= 0.25;
-			trace = gi.trace (rider->s.origin, rider->mins, rider->maxs, point, rider, MASK_MONSTERSOLID);
-			if ( trace.plane.normal[2] < 0.7 && !trace.startsolid)
-				continue;
-			if (!trace.startsolid && !trace.allsolid) {
-				if(trace.ent == platform) {
-					mass += rider->mass;
-					mass += RiderMass(rider);
-				}
-			}
-		}
+	if(depth > RIDER_MAX_DEPTH)
+		return 0;
+
+	for(l=rider_first[platform-g_edicts]; l>=0; l=rider_next[l]) {
+		rider = g_edicts+rider_ent[l];
+		mass += rider->mass;
+		mass += RiderMass_r(rider,depth+1);
 	}
 	return mass;
 }
 
+float RiderMass(edict_t *platform)
+{
+	BuildRiderLists (true);
+	return RiderMass_r (platform, 0);
+}
+
+/*
+============
+Pushable riders and contacts
+
+A func_pushable carries what stands on it, and that used to be one
+edict scan per moving crate, moving only the crates directly on top.
+Whatever stood on those lost its ground when they were relinked and
+fell back onto them next frame, so a stack riding a conveyor shook and
+re-settled every frame. The stack is now moved as one piece from the
+rider lists: a rider that is carried the whole way keeps its ground
+and carries its own riders in turn.
+
+A pushable that isn't moving still touches triggers every frame, for
+trigger_mass. Each pushable remembers whether its box held any trigger
+the last time it looked; while it hasn't been relinked and no trigger
+has been linked anywhere since, one that found none doesn't look again.
+============
+*/
+typedef struct
+{
+	int			framenum;		// level.framenum + 1 of the last look
+	int			linkcount;
+	int			trigger_links;
+	qboolean	triggers;
+} pushcontact_t;
+
+static pushcontact_t	push_contact[MAX_EDICTS];
+
+static void PushableRiders_r (edict_t *platform, vec3_t move, int depth)
+{
+	int		l;
+	edict_t	*rider;
+	trace_t	tr;
+	vec3_t	end;
+
+	if(depth > RIDER_MAX_DEPTH)
+		return;
+
+	for(l=rider_first[platform-g_edicts]; l>=0; l=rider_next[l]) {
+		rider = g_edicts+rider_ent[l];
+		if(rider->groundentity != platform)
+			continue;
+		VectorAdd(rider->s.origin,move,end);
+		tr = gi.trace(rider->s.origin,rider->mins,rider->maxs,end,platform,MASK_SOLID);
+		VectorCopy(tr.endpos,rider->s.origin);
+		gi.linkentity(rider);
+		if(tr.fraction == 1.0 && !tr.startsolid) {
+			// still sitting where it was on the platform
+			rider->groundentity_linkcount = platform->linkcount;
+			PushableRiders_r(rider,move,depth+1);
+		}
+	}
+}
+
+static void SV_MovePushableRiders (edict_t *ent, vec3_t move)
+{
+	if(VectorCompare(move,vec3_origin))
+		return;
+	BuildRiderLists (false);
+	PushableRiders_r (ent, move, 0);
+}
+
+static void SV_RestingPushableTouch (edict_t *ent)
+{
+	pushcontact_t	*c;
+	edict_t			*touch[MAX_EDICTS];
+	int				n;
+
+	n = ent - g_edicts;
+	if(n >= MAX_EDICTS) {
+		G_TouchTriggers(ent);
+		return;
+	}
+	c = &push_contact[n];
+	if(c->framenum < level.framenum || c->linkcount != ent->linkcount
+		|| c->trigger_links != trigger_link_count)
+		c->triggers = gi.BoxEdicts(ent->absmin,ent->absmax,touch,MAX_EDICTS,AREA_TRIGGERS) > 0;
+	c->framenum = level.framenum + 1;
+	c->linkcount = ent->linkcount;
+	c->trigger_links = trigger_link_count;
+	if(c->triggers)
+		G_TouchTriggers(ent);
+}
+
 void SV_Physics_Step (edict_t *ent)
 {
 	qboolean	hitsound = false;
@@ -1673,10 +2159,8 @@ void SV_Physics_Step (edict_t *ent)
 	float		speed, newspeed, control;
 	float		friction;
 	edict_t		*ground;
-	edict_t     *e;
 	int         cont;
 	int			mask;
-	int         i;
 	int			oldwaterlevel;
 	vec3_t      point, end;
 	vec3_t		old_origin, move;
@@ -1714,11 +2198,12 @@ void SV_Physics_Step (edict_t *ent)
 	}
 	// If not a monster, then determine whether we're in water.
 	// (monsters take care of this in g_monster.c)
-	if (!(ent->svflags & SVF_MONSTER) && (ent->flags & FL_SWIM) ) {
+	if (!(ent->svflags & SVF_MONSTER) && (ent->flags & FL_SWIM)
+		&& !G_WaterLevelKnown (ent, WATERCACHE_SWIM)) {
 		point[0] = (ent->absmax[0] + ent->absmin[0])/2;
 		point[1] = (ent->absmax[1] + ent->absmin[1])/2;
 		point[2] = ent->absmin[2] + 1;
-		cont = gi.pointcontents (point);
+		cont = G_EnvContents (point);
 		if (!(cont & MASK_WATER)) {
 			ent->waterlevel = 0;
 			ent->watertype = 0;
@@ -1727,16 +2212,17 @@ void SV_Physics_Step (edict_t *ent)
 			ent->watertype = cont;
 			ent->waterlevel = 1;
 			point[2] = ent->absmin[2] + ent->size[2]/2;
-			cont = gi.pointcontents (point);
+			cont = G_EnvContents (point);
 			if (cont & MASK_WATER)
 			{
 				ent->waterlevel = 2;
 				point[2] = ent->absmax[2];
-				cont = gi.pointcontents (point);
+				cont = G_EnvContents (point);
 				if (cont & MASK_WATER)
 					ent->waterlevel = 3;
 			}
 		}
+		G_StoreWaterLevel (ent, WATERCACHE_SWIM);
 	}
 	
 	ground = ent->groundentity;
@@ -1986,19 +2472,10 @@ void SV_Physics_Step (edict_t *ent)
 
 		// Move func_pushable riders
 		if(ent->movetype == MOVETYPE_PUSHABLE) {
-			trace_t	tr;
 			if(ent->bounce_me == 2)
 				VectorMA(old_origin,FRAMETIME,ent->velocity,ent->s.origin);
 			VectorSubtract(ent->s.origin,old_origin,move);
-			for(i=1, e=g_edicts+i; i<globals.num_edicts; i++, e++) {
-				if(e==ent) continue;
-				if(e->groundentity == ent) {
-					VectorAdd(e->s.origin,move,end);
-					tr = gi.trace(e->s.origin,e->mins,e->maxs,end,ent,MASK_SOLID);
-					VectorCopy(tr.endpos,e->s.origin);
-					gi.linkentity(e);
-				}
-			}
+			SV_MovePushableRiders(ent,move);
 		}
 	}
 
@@ -2007,7 +2484,7 @@ void SV_Physics_Step (edict_t *ent)
 	{
 		// We run touch function for non-moving func_pushables every frame
 		// to see if they are touching, for example, a trigger_mass
-		G_TouchTriggers(ent);
+		SV_RestingPushableTouch(ent);
 		if(!ent->inuse) return;
 	}
 
@@ -2044,9 +2521,40 @@ void SV_Physics_Step (edict_t *ent)
 //
 //============
 //SV_VehicleMove
+//
+//Lazarus: Each call is held to VEHICLE_MAX_TRACES traces. Trying again
+//past riders (movewith children) used to have no limit, and a vehicle
+//carrying a few of them could bounce between them for a long time. Out
+//of traces, the vehicle keeps what it has covered this step.
 //============
 //
-#define	MAX_CLIP_PLANES	5
+#define	MAX_CLIP_PLANES		5
+#define	VEHICLE_MAX_TRACES	32
+#define	VEHICLE_MAX_IMPACTS	16
+#define	VEHICLE_MAX_SUBSTEPS	8
+
+// what the vehicle hit this frame, so sub-steps touch each only once
+static edict_t	*vehicle_impacts[VEHICLE_MAX_IMPACTS];
+static int		num_vehicle_impacts;
+static qboolean	vehicle_substepping;
+
+static void SV_VehicleImpact (edict_t *ent, trace_t *trace)
+{
+	int		i;
+
+	if (!vehicle_substepping)
+	{
+		SV_Impact (ent, trace);
+		return;
+	}
+	for (i=0 ; i<num_vehicle_impacts ; i++)
+		if (vehicle_impacts[i] == trace->ent)
+			return;
+	if (num_vehicle_impacts < VEHICLE_MAX_IMPACTS)
+		vehicle_impacts[num_vehicle_impacts++] = trace->ent;
+	SV_Impact (ent, trace);
+}
+
 int SV_VehicleMove (edict_t *ent, float time, int mask)
 {
 	edict_t		*hit;
@@ -2067,6 +2575,7 @@ int SV_VehicleMove (edict_t *ent, float time, int mask)
 	int			numplanes;
 	int			i, j;
 	int			blocked;
+	int			traces;
 
 	// Corrective stuff added for bmodels with no origin brush
 	vec3_t		mins, maxs;
@@ -2095,6 +2604,7 @@ int SV_VehicleMove (edict_t *ent, float time, int mask)
 
 	ignore = ent;
 	VectorCopy(origin,start);
+	traces = 0;
 
 	for (bumpcount=0 ; bumpcount<numbumps ; bumpcount++)
 	{
@@ -2102,6 +2612,8 @@ int SV_VehicleMove (edict_t *ent, float time, int mask)
 			end[i] = origin[i] + time_left * ent->velocity[i];
 
 retry:
+		if (traces++ == VEHICLE_MAX_TRACES)
+			break;
 		trace = gi.trace (start, mins, maxs, end, ignore, mask);
 		if(trace.ent && (trace.ent->movewith_ent == ent) )
 		{
@@ -2194,7 +2706,7 @@ not_allsolid:
 //
 // run the impact function
 //
-		SV_Impact (ent, &trace);
+		SV_VehicleImpact (ent, &trace);
 		if (!ent->inuse)
 			break;		// vehicle destroyed
 		if (!trace.ent->inuse)
@@ -2319,10 +2831,76 @@ not_allsolid:
 
 
 
+/*
+============
+SV_VehicleBox
+
+Fits the bounding box around the vehicle's footprint at its current yaw
+============
+*/
+static void SV_VehicleBox (edict_t *ent)
+{
+	float		ca, sa, yaw;
+	vec3_t		p[2][2];
+	vec3_t		mins, maxs;
+	vec3_t		s2;
+
+	if(!ent->org_size[0])
+		return;
+
+	// Adjust bounding box for yaw
+	yaw = ent->s.angles[YAW] * M_PI / 180.;
+	ca  = cos(yaw);
+	sa  = sin(yaw);
+	VectorCopy(ent->org_size,s2);
+	VectorScale(s2,0.5,s2);
+	p[0][0][0] = -s2[0]*ca + s2[1]*sa;
+	p[0][0][1] = -s2[1]*ca - s2[0]*sa;
+	p[0][1][0] =  s2[0]*ca + s2[1]*sa;
+	p[0][1][1] = -s2[1]*ca + s2[0]*sa;
+	p[1][0][0] = -s2[0]*ca - s2[1]*sa;
+	p[1][0][1] =  s2[1]*ca - s2[0]*sa;
+	p[1][1][0] =  s2[0]*ca - s2[1]*sa;
+	p[1][1][1] =  s2[1]*ca + s2[0]*sa;
+	mins[0] = min(p[0][0][0],p[0][1][0]);
+	mins[0] = min(mins[0],p[1][0][0]);
+	mins[0] = min(mins[0],p[1][1][0]);
+	mins[1] = min(p[0][0][1],p[0][1][1]);
+	mins[1] = min(mins[1],p[1][0][1]);
+	mins[1] = min(mins[1],p[1][1][1]);
+	maxs[0] = max(p[0][0][0],p[0][1][0]);
+	maxs[0] = max(maxs[0],p[1][0][0]);
+	maxs[0] = max(maxs[0],p[1][1][0]);
+	maxs[1] = max(p[0][0][1],p[0][1][1]);
+	maxs[1] = max(maxs[1],p[1][0][1]);
+	maxs[1] = max(maxs[1],p[1][1][1]);
+	ent->size[0] = maxs[0] - mins[0];
+	ent->size[1] = maxs[1] - mins[1];
+	ent->mins[0] = -ent->size[0]/2;
+	ent->mins[1] = -ent->size[1]/2;
+	ent->maxs[0] =  ent->size[0]/2;
+	ent->maxs[1] =  ent->size[1]/2;
+	gi.linkentity(ent);
+}
+
+/*
+============
+SV_Physics_Vehicle
+
+Lazarus: With sv_vehicle_substeps above 1 the frame's move is made in
+that many steps, turning and refitting the bounding box before each,
+so a vehicle turning at speed follows walls at 20 or 40 Hz. The game
+still runs at 10 Hz; vehicle_think sets speeds once a frame as before,
+triggers are touched once after the last step, and whatever the
+vehicle runs into is touched once a frame however many steps hit it.
+============
+*/
 void SV_Physics_Vehicle (edict_t *ent)
 {
 	edict_t		*ground;
 	int			mask;
+	int			steps, step;
+	float		steptime;
 
 //  see if we're on the ground
 	if (!ent->groundentity)
@@ -2333,58 +2911,43 @@ void SV_Physics_Vehicle (edict_t *ent)
 	if (ground)
 		wasonground = true;
 
-//  move angles
-	VectorMA (ent->s.angles, FRAMETIME, ent->avelocity, ent->s.angles);
-
 	if (ent->velocity[2] || ent->velocity[1] || ent->velocity[0])
 	{
-		if(ent->org_size[0])
+		steps = (int)sv_vehicle_substeps->value;
+		if (steps < 1)
+			steps = 1;
+		else if (steps > VEHICLE_MAX_SUBSTEPS)
+			steps = VEHICLE_MAX_SUBSTEPS;
+		steptime = FRAMETIME / steps;
+
+		mask = MASK_ALL;
+		num_vehicle_impacts = 0;
+		vehicle_substepping = (steps > 1);
+		for (step=0 ; step<steps ; step++)
 		{
-			float		ca, sa, yaw;
-			vec3_t		p[2][2];
-			vec3_t		mins, maxs;
-			vec3_t		s2;
-			// Adjust bounding box for yaw
-			yaw = ent->s.angles[YAW] * M_PI / 180.;
-			ca  = cos(yaw);
-			sa  = sin(yaw);
-			VectorCopy(ent->org_size,s2);
-			VectorScale(s2,0.5,s2);
-			p[0][0][0] = -s2[0]*ca + s2[1]*sa;
-			p[0][0][1] = -s2[1]*ca - s2[0]*sa;
-			p[0][1][0] =  s2[0]*ca + s2[1]*sa;
-			p[0][1][1] = -s2[1]*ca + s2[0]*sa;
-			p[1][0][0] = -s2[0]*ca - s2[1]*sa;
-			p[1][0][1] =  s2[1]*ca - s2[0]*sa;
-			p[1][1][0] =  s2[0]*ca - s2[1]*sa;
-			p[1][1][1] =  s2[1]*ca + s2[0]*sa;
-			mins[0] = min(p[0][0][0],p[0][1][0]);
-			mins[0] = min(mins[0],p[1][0][0]);
-			mins[0] = min(mins[0],p[1][1][0]);
-			mins[1] = min(p[0][0][1],p[0][1][1]);
-			mins[1] = min(mins[1],p[1][0][1]);
-			mins[1] = min(mins[1],p[1][1][1]);
-			maxs[0] = max(p[0][0][0],p[0][1][0]);
-			maxs[0] = max(maxs[0],p[1][0][0]);
-			maxs[0] = max(maxs[0],p[1][1][0]);
-			maxs[1] = max(p[0][0][1],p[0][1][1]);
-			maxs[1] = max(maxs[1],p[1][0][1]);
-			maxs[1] = max(maxs[1],p[1][1][1]);
-			ent->size[0] = maxs[0] - mins[0];
-			ent->size[1] = maxs[1] - mins[1];
-			ent->mins[0] = -ent->size[0]/2;
-			ent->mins[1] = -ent->size[1]/2;
-			ent->maxs[0] =  ent->size[0]/2;
-			ent->maxs[1] =  ent->size[1]/2;
-			gi.linkentity(ent);
+		//  move angles
+			VectorMA (ent->s.angles, steptime, ent->avelocity, ent->s.angles);
+			SV_VehicleBox (ent);
+			SV_VehicleMove (ent, steptime, mask);
+			gi.linkentity (ent);
+			if (!ent->inuse)
+				return;
+			if (!ent->velocity[2] && !ent->velocity[1] && !ent->velocity[0])
+			{
+				// stopped; finish the turn as a single step would have
+				VectorMA (ent->s.angles, steptime * (steps - step - 1), ent->avelocity, ent->s.angles);
+				break;
+			}
 		}
-		mask = MASK_ALL;
-		SV_VehicleMove (ent, FRAMETIME, mask);
-		gi.linkentity (ent);
 		G_TouchTriggers (ent);
 		if (!ent->inuse)
 			return;
 	}
+	else
+	{
+	//  move angles
+		VectorMA (ent->s.angles, FRAMETIME, ent->avelocity, ent->s.angles);
+	}
 //  regular thinking
 	SV_RunThink (ent);
 	VectorCopy(ent->velocity,ent->oldvelocity);
@@ -2556,7 +3119,7 @@ void SV_Physics_Debris (edict_t *ent)
 	
 // check for water transition
 	wasinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
-	ent->watertype = gi.pointcontents (ent->s.origin);
+	ent->watertype = G_EnvContents (ent->s.origin);
 	isinwater = (ent->watertype & MASK_WATER) != 0 ? true : false;
 
 	if (isinwater)
@@ -2634,9 +3197,14 @@ G_RunEntity
 */
 void G_RunEntity (edict_t *ent)
 {
+	int		section;
+
 	if(level.freeze && Q_strcasecmp(ent->classname,"chasecam"))
 		return;
 
+	section = Prof_PhysSection (ent->movetype);
+	Prof_Begin (section);
+
 	if (ent->prethink)
 		ent->prethink (ent);
 
@@ -2687,4 +3255,6 @@ void G_RunEntity (edict_t *ent)
 
 	if (ent->postthink)	//Knightmare added
 		ent->postthink (ent);
+
+	Prof_End (section);
 }
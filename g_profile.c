@@ -0,0 +1,1150 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#include <time.h>
+
+/*
+==============================================================================
+
+FRAME PROFILER
+
+"sv profile start" clears the history and starts timing the sections
+below; "sv profile stop" stops it. "sv profile dump [file]" prints the
+mean, median, 95th and 99th percentile and worst time of each section
+over the frames recorded, and writes every frame as one CSV row. It
+also prints what the level arena and its pools hold (g_utils.c).
+
+Each row holds everything since the previous G_RunFrame, so ClientThink
+calls the engine makes between server frames land in the row of the
+frame they follow. Times are inclusive: a T_Damage called from a
+monster's think counts in both. A section entered again while it is
+still open (T_Damage from a die function) is only timed once.
+
+While profiling, G_Trace counts each trace against the innermost open
+section, and each row also counts the linkentity and multicast calls
+made during it (g_trace.c), and the edicts spawned and freed (g_utils.c).
+
+"sv profile bench" runs frames back to back from the console instead of
+waiting for the engine, with the profiler on, and reports frames per
+second along with the usual dump:
+
+  sv profile bench frames <n>             n plain frames
+  sv profile bench explode <n> [count]    n frames, each with count
+                                          explosions (default 8) at
+                                          random spots near players
+  sv profile bench save <n>               n WriteLevel calls
+  sv profile bench math <n>               n passes of the vector math
+                                          below over random inputs
+
+The math benchmark times AngleVectors, vectoangles(2), vectoyaw(2),
+G_ProjectSource(2) and RotateAngles, the calls every monster, bot and
+mover makes each frame, and runs without touching the world.
+
+Add bots first (sv addbot) to time a deathmatch with bots. Explosions
+do real damage. Running frames this way is for measuring only: clients
+see the world jump ahead.
+
+Nothing is timed while neither the profiler nor the level report below
+is on; Prof_Begin and Prof_End return straight away.
+
+==============================================================================
+*/
+
+#define	PROF_FRAMES		1024		// frames kept for dump
+#define	PROF_STACK		32
+
+typedef struct
+{
+	int		framenum;
+	float	msec[PROF_NUMSECTIONS];
+	int		calls[PROF_NUMSECTIONS];
+	int		traces[PROF_NUMSECTIONS];
+	int		links;			// linkentity and unlinkentity calls
+	int		link_skips;		// ... of those, links with nothing changed
+	int		multicasts;
+	int		allocs;			// G_Spawn and G_FreeEdict calls
+	int		frees;
+} profframe_t;
+
+static char *prof_names[PROF_NUMSECTIONS] =
+{
+	"frame",
+	"phys_push",
+	"phys_none",
+	"phys_noclip",
+	"phys_step",
+	"phys_toss",
+	"phys_debris",
+	"phys_vehicle",
+	"phys_conveyor",
+	"clientthink",
+	"endframes",
+	"reflections",
+	"damage",
+	"botthink",
+	"botnodes"
+};
+
+qboolean			prof_active;		// the profiler or the level report is collecting
+
+static qboolean		prof_recording;		// "sv profile start" keeps rows for dump
+static qboolean		rep_collecting;		// the level report is on for this level
+
+static profframe_t	*prof_frames;		// ring of the last PROF_FRAMES frames
+static int			prof_head;			// next row to fill
+static int			prof_count;
+static profframe_t	prof_current;
+static double		prof_start[PROF_NUMSECTIONS];
+static int			prof_depth[PROF_NUMSECTIONS];
+static int			prof_stack[PROF_STACK];
+static int			prof_sp;
+
+static void Rep_AddFrame (profframe_t *frame);
+
+double Prof_Seconds (void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER			count;
+
+	if (!freq.QuadPart)
+		QueryPerformanceFrequency (&freq);
+	QueryPerformanceCounter (&count);
+	return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+}
+
+/*
+=================
+Prof_CountTrace
+
+Called by G_Trace while profiling
+=================
+*/
+void Prof_CountTrace (void)
+{
+	if (prof_sp > 0 && prof_sp <= PROF_STACK)
+		prof_current.traces[prof_stack[prof_sp-1]]++;
+	else
+		prof_current.traces[PROF_FRAME]++;
+}
+
+/*
+=================
+Prof_CountLink / Prof_CountLinkSkip / Prof_CountMulticast
+
+Called by the engine call wrappers in g_trace.c while profiling
+=================
+*/
+void Prof_CountLink (void)
+{
+	prof_current.links++;
+}
+
+void Prof_CountLinkSkip (void)
+{
+	prof_current.links++;
+	prof_current.link_skips++;
+}
+
+void Prof_CountMulticast (void)
+{
+	prof_current.multicasts++;
+}
+
+/*
+=================
+Prof_CountAlloc / Prof_CountFree
+
+Called by G_Spawn and G_FreeEdict while profiling
+=================
+*/
+void Prof_CountAlloc (void)
+{
+	prof_current.allocs++;
+}
+
+void Prof_CountFree (void)
+{
+	prof_current.frees++;
+}
+
+/*
+=================
+Prof_Begin / Prof_End
+
+Open and close a section. Every Prof_Begin needs its Prof_End, on every
+way out of the code being timed.
+=================
+*/
+void Prof_Begin (int section)
+{
+	if (!prof_active)
+		return;
+
+	if (prof_depth[section]++ == 0)
+		prof_start[section] = Prof_Seconds ();
+	prof_current.calls[section]++;
+	if (prof_sp < PROF_STACK)
+		prof_stack[prof_sp] = section;
+	prof_sp++;
+}
+
+void Prof_End (int section)
+{
+	if (!prof_active)
+		return;
+
+	if (prof_sp > 0)
+		prof_sp--;
+	if (prof_depth[section] > 0 && --prof_depth[section] == 0)
+		prof_current.msec[section] += (float)((Prof_Seconds () - prof_start[section]) * 1000.0);
+}
+
+/*
+=================
+Prof_PhysSection
+
+The section G_RunEntity times an entity of this movetype under
+=================
+*/
+int Prof_PhysSection (int movetype)
+{
+	switch (movetype)
+	{
+	case MOVETYPE_PUSH:
+	case MOVETYPE_STOP:
+	case MOVETYPE_PENDULUM:
+		return PROF_PHYS_PUSH;
+	case MOVETYPE_NOCLIP:
+		return PROF_PHYS_NOCLIP;
+	case MOVETYPE_STEP:
+	case MOVETYPE_PUSHABLE:
+		return PROF_PHYS_STEP;
+	case MOVETYPE_TOSS:
+	case MOVETYPE_BOUNCE:
+	case MOVETYPE_FLY:
+	case MOVETYPE_FLYMISSILE:
+	case MOVETYPE_RAIN:
+		return PROF_PHYS_TOSS;
+	case MOVETYPE_DEBRIS:
+		return PROF_PHYS_DEBRIS;
+	case MOVETYPE_VEHICLE:
+		return PROF_PHYS_VEHICLE;
+	case MOVETYPE_CONVEYOR:
+		return PROF_PHYS_CONVEYOR;
+	default:
+		return PROF_PHYS_NONE;
+	}
+}
+
+/*
+=================
+Prof_BeginFrame
+
+Called at the top of G_RunFrame. Files what was collected since the
+last call as one row and opens the frame section again.
+=================
+*/
+void Prof_BeginFrame (void)
+{
+	if (!prof_active)
+		return;
+
+	if (prof_current.framenum)
+	{
+		if (prof_recording)
+		{
+			prof_frames[prof_head] = prof_current;
+			prof_head = (prof_head + 1) % PROF_FRAMES;
+			if (prof_count < PROF_FRAMES)
+				prof_count++;
+		}
+		Rep_AddFrame (&prof_current);
+	}
+	memset (&prof_current, 0, sizeof(prof_current));
+	// level.framenum was just advanced; 0 marks a row with nothing in it
+	prof_current.framenum = level.framenum ? level.framenum : 1;
+	Prof_Begin (PROF_FRAME);
+}
+
+static void Prof_Start (void)
+{
+	if (!prof_frames)
+		prof_frames = gi.TagMalloc (PROF_FRAMES * sizeof(profframe_t), TAG_GAME);
+
+	prof_head = prof_count = 0;
+	prof_sp = 0;
+	memset (&prof_current, 0, sizeof(prof_current));
+	memset (prof_depth, 0, sizeof(prof_depth));
+
+	prof_recording = true;
+	prof_active = true;
+	safe_cprintf (NULL, PRINT_HIGH, "Profiling started.\n");
+}
+
+static void Prof_Stop (void)
+{
+	if (!prof_recording)
+		return;
+
+	prof_recording = false;
+	prof_active = rep_collecting;
+	safe_cprintf (NULL, PRINT_HIGH, "Profiling stopped, %i frames recorded.\n", prof_count);
+}
+
+static int Prof_CompareFloats (const void *a, const void *b)
+{
+	float	fa = *(const float *)a;
+	float	fb = *(const float *)b;
+
+	if (fa < fb)
+		return -1;
+	return (fa > fb);
+}
+
+static profframe_t *Prof_Frame (int i)
+{
+	// oldest first
+	return &prof_frames[(prof_head - prof_count + i + PROF_FRAMES) % PROF_FRAMES];
+}
+
+// filename in the game directory
+static void Prof_FilePath (char *name, int size, char *filename)
+{
+	cvar_t	*game;
+
+	game = gi.cvar("game", "", 0);
+	if (!*game->string)
+		Com_sprintf (name, size, "%s/%s", GAMEVERSION, filename);
+	else
+		Com_sprintf (name, size, "%s/%s", game->string, filename);
+}
+
+static void Prof_WriteCSV (char *filename)
+{
+	FILE		*f;
+	char		name[MAX_OSPATH];
+	profframe_t	*frame;
+	int			i, s;
+
+	Prof_FilePath (name, sizeof(name), filename);
+
+	f = fopen (name, "w");
+	if (!f)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "Couldn't open %s\n", name);
+		return;
+	}
+
+	fprintf (f, "framenum");
+	for (s=0 ; s<PROF_NUMSECTIONS ; s++)
+		fprintf (f, ",%s_msec,%s_calls,%s_traces", prof_names[s], prof_names[s], prof_names[s]);
+	fprintf (f, ",links,link_skips,multicasts,allocs,frees\n");
+
+	for (i=0 ; i<prof_count ; i++)
+	{
+		frame = Prof_Frame (i);
+		fprintf (f, "%i", frame->framenum);
+		for (s=0 ; s<PROF_NUMSECTIONS ; s++)
+			fprintf (f, ",%.4f,%i,%i", frame->msec[s], frame->calls[s], frame->traces[s]);
+		fprintf (f, ",%i,%i,%i,%i,%i\n", frame->links, frame->link_skips, frame->multicasts, frame->allocs, frame->frees);
+	}
+	fclose (f);
+	safe_cprintf (NULL, PRINT_HIGH, "Wrote %s.\n", name);
+}
+
+static void Prof_Dump (char *filename)
+{
+	float	*times;
+	double	total;
+	int		calls, traces, links, link_skips, multicasts, allocs, frees;
+	int		i, s;
+
+	if (!prof_count)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "No frames recorded.\n");
+		return;
+	}
+
+	times = gi.TagMalloc (prof_count * sizeof(float), TAG_GAME);
+
+	safe_cprintf (NULL, PRINT_HIGH, "%i frames, msec per frame:\n", prof_count);
+	safe_cprintf (NULL, PRINT_HIGH, "%-14s %8s %8s %8s %8s %8s %7s %7s\n",
+		"section", "mean", "p50", "p95", "p99", "max", "calls", "traces");
+	for (s=0 ; s<PROF_NUMSECTIONS ; s++)
+	{
+		total = 0;
+		calls = traces = 0;
+		for (i=0 ; i<prof_count ; i++)
+		{
+			times[i] = Prof_Frame(i)->msec[s];
+			total  += times[i];
+			calls  += Prof_Frame(i)->calls[s];
+			traces += Prof_Frame(i)->traces[s];
+		}
+		if (!calls && !traces)
+			continue;
+		qsort (times, prof_count, sizeof(float), Prof_CompareFloats);
+		safe_cprintf (NULL, PRINT_HIGH, "%-14s %8.3f %8.3f %8.3f %8.3f %8.3f %7i %7i\n",
+			prof_names[s], total / prof_count,
+			times[prof_count / 2], times[(prof_count * 95) / 100], times[(prof_count * 99) / 100],
+			times[prof_count - 1], calls / prof_count, traces / prof_count);
+	}
+	gi.TagFree (times);
+
+	links = link_skips = multicasts = allocs = frees = 0;
+	for (i=0 ; i<prof_count ; i++)
+	{
+		links += Prof_Frame(i)->links;
+		link_skips += Prof_Frame(i)->link_skips;
+		multicasts += Prof_Frame(i)->multicasts;
+		allocs += Prof_Frame(i)->allocs;
+		frees += Prof_Frame(i)->frees;
+	}
+	safe_cprintf (NULL, PRINT_HIGH, "links %i (%i skipped), multicasts %i, edicts spawned %i, freed %i per frame\n",
+		links / prof_count, link_skips / prof_count, multicasts / prof_count, allocs / prof_count, frees / prof_count);
+
+	G_ArenaStats ();
+	Prof_WriteCSV (filename);
+}
+
+/*
+=================
+Prof_Explode
+
+One explosion at a random spot near a random player, for the explode
+benchmark
+=================
+*/
+static void Prof_Explode (void)
+{
+	edict_t	*player, *boom;
+	vec3_t	end;
+	trace_t	tr;
+	int		i, tries;
+
+	player = NULL;
+	for (tries = 0 ; tries < 8 && !player ; tries++)
+	{
+		i = 1 + (rand() % game.maxclients);
+		if (g_edicts[i].inuse && g_edicts[i].client)
+			player = &g_edicts[i];
+	}
+	if (!player)
+		return;
+
+	VectorCopy (player->s.origin, end);
+	end[0] += crandom() * 256;
+	end[1] += crandom() * 256;
+	tr = gi.trace (player->s.origin, NULL, NULL, end, player, MASK_SHOT);
+
+	boom = G_SpawnTagged ("Prof_Explode");
+	VectorCopy (tr.endpos, boom->s.origin);
+	T_RadiusDamage (boom, world, 120, NULL, 160, MOD_EXPLOSIVE, -0.5);
+	G_TempPoint (TE_EXPLOSION1, boom->s.origin, MULTICAST_PHS);
+	G_FreeEdict (boom);
+}
+
+#define	PROF_MATH_INPUTS	1024
+
+void RotateAngles (vec3_t in, vec3_t delta, vec3_t out);
+
+/*
+=================
+Prof_BenchMath
+
+n passes of each kernel over the same random inputs, reported as
+nanoseconds per call. The results are summed so none of it can be
+optimized away.
+=================
+*/
+static void Prof_BenchMath (int n)
+{
+	static vec3_t	angles[PROF_MATH_INPUTS], vecs[PROF_MATH_INPUTS];
+	vec3_t	forward, right, up, out;
+	double	start, t[8];
+	float	sum;
+	int		i, j, k;
+	static char	*names[8] = {
+		"AngleVectors", "vectoangles", "vectoangles2", "vectoyaw",
+		"vectoyaw2", "G_ProjectSource", "G_ProjectSource2", "RotateAngles"
+	};
+
+	for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+	{
+		for (k=0 ; k<3 ; k++)
+		{
+			angles[i][k] = crandom() * 180;
+			vecs[i][k] = crandom() * 1024;
+		}
+		if (!(i & 15))
+			vecs[i][0] = vecs[i][1] = 0;	// straight up and down take their own path
+	}
+
+	sum = 0;
+	memset (t, 0, sizeof(t));
+	for (j=0 ; j<n ; j++)
+	{
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			AngleVectors (angles[i], forward, right, up);
+			sum += forward[0] + right[1] + up[2];
+		}
+		t[0] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			vectoangles (vecs[i], out);
+			sum += out[0];
+		}
+		t[1] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			vectoangles2 (vecs[i], out);
+			sum += out[0];
+		}
+		t[2] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+			sum += vectoyaw (vecs[i]);
+		t[3] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+			sum += vectoyaw2 (vecs[i]);
+		t[4] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			G_ProjectSource (vecs[i], angles[i], forward, right, out);
+			sum += out[0];
+		}
+		t[5] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			G_ProjectSource2 (vecs[i], angles[i], forward, right, up, out);
+			sum += out[0];
+		}
+		t[6] += Prof_Seconds () - start;
+
+		start = Prof_Seconds ();
+		for (i=0 ; i<PROF_MATH_INPUTS ; i++)
+		{
+			RotateAngles (angles[i], angles[(i+1) & (PROF_MATH_INPUTS-1)], out);
+			sum += out[0];
+		}
+		t[7] += Prof_Seconds () - start;
+	}
+
+	for (k=0 ; k<8 ; k++)
+		safe_cprintf (NULL, PRINT_HIGH, "%-18s %8.1f nsec/call\n",
+			names[k], t[k] * 1e9 / ((double)n * PROF_MATH_INPUTS));
+	safe_cprintf (NULL, PRINT_HIGH, "(checksum %g)\n", sum);
+}
+
+/*
+=================
+Prof_Bench
+
+"sv profile bench frames|explode|save|math <n> [count]"
+=================
+*/
+static void Prof_Bench (void)
+{
+	char	*kind, name[MAX_OSPATH];
+	cvar_t	*game;
+	double	start, t, total, worst;
+	int		n, count, i, k;
+
+	kind = gi.argv(3);
+	n = atoi (gi.argv(4));
+	if (n <= 0)
+		n = 100;
+
+	if (!Q_strcasecmp (kind, "save"))
+	{
+		game = gi.cvar("game", "", 0);
+		Com_sprintf (name, sizeof(name), "%s/bench.sav", *game->string ? game->string : GAMEVERSION);
+		total = worst = 0;
+		for (i=0 ; i<n ; i++)
+		{
+			start = Prof_Seconds ();
+			globals.WriteLevel (name);
+			t = Prof_Seconds () - start;
+			total += t;
+			if (t > worst)
+				worst = t;
+		}
+		remove (name);
+		safe_cprintf (NULL, PRINT_HIGH, "%i saves, %.3f msec mean, %.3f msec max\n",
+			n, total * 1000.0 / n, worst * 1000.0);
+		return;
+	}
+
+	if (!Q_strcasecmp (kind, "math"))
+	{
+		Prof_BenchMath (n);
+		return;
+	}
+
+	if (Q_strcasecmp (kind, "frames") && Q_strcasecmp (kind, "explode"))
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "Usage: sv profile bench frames|explode|save|math <n> [count]\n");
+		return;
+	}
+	count = (gi.argc() > 5) ? atoi (gi.argv(5)) : 8;
+
+	Prof_Start ();
+	start = Prof_Seconds ();
+	for (i=0 ; i<n ; i++)
+	{
+		if (!Q_strcasecmp (kind, "explode"))
+		{
+			for (k=0 ; k<count ; k++)
+				Prof_Explode ();
+		}
+		globals.RunFrame ();
+	}
+	t = Prof_Seconds () - start;
+	// file the last frame
+	Prof_BeginFrame ();
+	Prof_Stop ();
+
+	safe_cprintf (NULL, PRINT_HIGH, "%i frames in %.3f sec, %.1f frames/sec\n",
+		n, t, t > 0 ? n / t : 0);
+	Prof_Dump ("bench.csv");
+}
+
+/*
+=================
+Svcmd_Profile_f
+
+"sv profile start|stop|dump [file]|bench ..."
+=================
+*/
+void Svcmd_Profile_f (void)
+{
+	char	*cmd;
+
+	cmd = gi.argv(2);
+	if (!Q_strcasecmp (cmd, "start"))
+		Prof_Start ();
+	else if (!Q_strcasecmp (cmd, "stop"))
+		Prof_Stop ();
+	else if (!Q_strcasecmp (cmd, "dump"))
+		Prof_Dump ((gi.argc() > 3) ? gi.argv(3) : "profile.csv");
+	else if (!Q_strcasecmp (cmd, "bench"))
+		Prof_Bench ();
+	else
+		safe_cprintf (NULL, PRINT_HIGH, "Usage: sv profile start|stop|dump [file]|bench ...\n");
+}
+
+/*
+=================
+Prof_Shutdown
+
+Called from ShutdownGame. Forgets the history, which goes away with
+TAG_GAME.
+=================
+*/
+void Prof_Shutdown (void)
+{
+	prof_active = false;
+	prof_recording = false;
+	rep_collecting = false;
+	prof_frames = NULL;
+	prof_count = 0;
+}
+
+/*
+==============================================================================
+
+LEVEL REPORT
+
+With sv_level_report set, every level is measured from when it is
+spawned or loaded until it is left, and a summary is appended to
+perf_<mapname>.log in the game directory, so the maps in a rotation
+that need work show up without anyone running the profiler:
+
+  frame time mean, median, 95th and 99th percentile and worst
+  the most edicts the level had
+  how long spawning or loading took, and the level saves made
+  milliseconds and traces per frame for each profiler section above,
+    bot thinking and bot node upkeep among them
+  the classnames whose thinks took the most time
+
+While the report is on the profiler's sections are timed as if it were
+running, and every think is timed, which costs a clock read or three
+per think. Frame times come from the frame budget's clock below, kept
+as a histogram, so a level of any length costs the same.
+
+==============================================================================
+*/
+
+#define	REP_BUCKETS		1000		// 0.1 msec each, the last holds anything slower
+#define	REP_BUCKET_MSEC	0.1f
+#define	REP_CLASSES		256			// must be a power of 2
+#define	REP_TOP_CLASSES	10
+
+typedef struct
+{
+	char	name[32];
+	int		thinks;
+	double	msec;
+} repclass_t;
+
+static char			rep_mapname[MAX_QPATH];
+static char			*rep_how;			// "spawned" or "loaded"
+static float		rep_start_msec;
+static int			rep_frames;
+static int			rep_hist[REP_BUCKETS];
+static double		rep_total;
+static float		rep_max;
+static int			rep_peak_edicts;
+static int			rep_saves;
+static float		rep_save_total, rep_save_max;
+static double		rep_msec[PROF_NUMSECTIONS];
+static int			rep_traces[PROF_NUMSECTIONS];
+static int			rep_links, rep_link_skips, rep_multicasts, rep_allocs, rep_frees;
+static repclass_t	rep_classes[REP_CLASSES];
+static qboolean		rep_classes_full;
+
+// profiler rows, once per frame
+static void Rep_AddFrame (profframe_t *frame)
+{
+	int		s;
+
+	if (!rep_collecting)
+		return;
+	for (s=0 ; s<PROF_NUMSECTIONS ; s++)
+	{
+		rep_msec[s] += frame->msec[s];
+		rep_traces[s] += frame->traces[s];
+	}
+	rep_links += frame->links;
+	rep_link_skips += frame->link_skips;
+	rep_multicasts += frame->multicasts;
+	rep_allocs += frame->allocs;
+	rep_frees += frame->frees;
+}
+
+// whole frame times, from Gov_EndFrame
+static void Rep_CountFrame (float msec)
+{
+	int		bucket;
+
+	if (!rep_collecting)
+		return;
+	bucket = (int)(msec / REP_BUCKET_MSEC);
+	if (bucket >= REP_BUCKETS)
+		bucket = REP_BUCKETS - 1;
+	rep_hist[bucket]++;
+	rep_frames++;
+	rep_total += msec;
+	if (msec > rep_max)
+		rep_max = msec;
+	if (globals.num_edicts > rep_peak_edicts)
+		rep_peak_edicts = globals.num_edicts;
+}
+
+static repclass_t *Rep_Class (char *name)
+{
+	repclass_t		*c;
+	unsigned int	hash;
+	char			*p;
+	int				i, slot;
+
+	hash = 2166136261u;
+	for (p = name ; *p ; p++)
+		hash = (hash ^ (byte)*p) * 16777619u;
+
+	for (i=0 ; i<REP_CLASSES ; i++)
+	{
+		slot = (hash + i) & (REP_CLASSES-1);
+		c = &rep_classes[slot];
+		if (!c->name[0])
+		{
+			Q_strncpyz (c->name, name, sizeof(c->name));
+			return c;
+		}
+		if (!strncmp (c->name, name, sizeof(c->name)-1))
+			return c;
+	}
+	rep_classes_full = true;
+	return NULL;
+}
+
+/*
+=================
+Rep_Think
+
+Runs ent's think, timing it for the report if that is on. Called by
+SV_RunThink while prof_active is set.
+=================
+*/
+void Rep_Think (edict_t *ent)
+{
+	repclass_t	*c;
+	char		*name;
+	double		start;
+
+	if (!rep_collecting)
+	{
+		ent->think (ent);
+		return;
+	}
+
+	// the think may free ent
+	name = ent->classname ? ent->classname : "noclass";
+	c = Rep_Class (name);
+	start = Prof_Seconds ();
+	ent->think (ent);
+	if (c)
+	{
+		c->msec += (Prof_Seconds () - start) * 1000.0;
+		c->thinks++;
+	}
+}
+
+/*
+=================
+Rep_CountSave
+
+Milliseconds the frame thread spent writing a level
+=================
+*/
+void Rep_CountSave (int msec)
+{
+	if (!rep_collecting)
+		return;
+	rep_saves++;
+	rep_save_total += msec;
+	if (msec > rep_save_max)
+		rep_save_max = msec;
+}
+
+static float Rep_Percentile (int percent)
+{
+	int		i, count, want;
+
+	want = (rep_frames * percent) / 100;
+	for (i=0, count=0 ; i<REP_BUCKETS-1 ; i++)
+	{
+		count += rep_hist[i];
+		if (count > want)
+			return (i+1) * REP_BUCKET_MSEC;
+	}
+	return rep_max;
+}
+
+static int Rep_CompareClasses (const void *a, const void *b)
+{
+	double	ma = (*(repclass_t **)a)->msec;
+	double	mb = (*(repclass_t **)b)->msec;
+
+	if (ma > mb)
+		return -1;
+	return (ma < mb);
+}
+
+static void Rep_Write (void)
+{
+	FILE		*f;
+	char		name[MAX_OSPATH], filename[MAX_QPATH+16], date[32];
+	repclass_t	*sorted[REP_CLASSES];
+	time_t		now;
+	int			i, s, count;
+
+	Com_sprintf (filename, sizeof(filename), "perf_%s.log", rep_mapname);
+	Prof_FilePath (name, sizeof(name), filename);
+	f = fopen (name, "a");
+	if (!f)
+	{
+		gi.dprintf ("Couldn't open %s\n", name);
+		return;
+	}
+
+	now = time (NULL);
+	strftime (date, sizeof(date), "%Y-%m-%d %H:%M:%S", localtime (&now));
+	fprintf (f, "==== %s  %s  %s in %.0f ms\n", rep_mapname, date, rep_how, rep_start_msec);
+	fprintf (f, "%i frames (%.0f s), msec per frame: mean %.2f  p50 %.1f  p95 %.1f  p99 %.1f  max %.2f\n",
+		rep_frames, rep_frames * FRAMETIME, rep_total / rep_frames,
+		Rep_Percentile (50), Rep_Percentile (95), Rep_Percentile (99), rep_max);
+	fprintf (f, "peak edicts %i of %i\n", rep_peak_edicts, game.maxentities);
+	if (rep_saves)
+		fprintf (f, "level saves %i, mean %.0f ms, max %.0f ms\n",
+			rep_saves, rep_save_total / rep_saves, rep_save_max);
+
+	fprintf (f, "%-14s %10s %10s\n", "section", "msec/frame", "traces/fr");
+	for (s=0 ; s<PROF_NUMSECTIONS ; s++)
+	{
+		if (!rep_msec[s] && !rep_traces[s])
+			continue;
+		fprintf (f, "%-14s %10.3f %10.1f\n", prof_names[s],
+			rep_msec[s] / rep_frames, (float)rep_traces[s] / rep_frames);
+	}
+	fprintf (f, "links %.1f (%.1f skipped), multicasts %.1f, edicts spawned %.1f, freed %.1f per frame\n",
+		(float)rep_links / rep_frames, (float)rep_link_skips / rep_frames,
+		(float)rep_multicasts / rep_frames, (float)rep_allocs / rep_frames, (float)rep_frees / rep_frames);
+
+	count = 0;
+	for (i=0 ; i<REP_CLASSES ; i++)
+		if (rep_classes[i].thinks)
+			sorted[count++] = &rep_classes[i];
+	qsort (sorted, count, sizeof(sorted[0]), Rep_CompareClasses);
+	fprintf (f, "%-24s %10s %8s\n", "thinks", "msec/frame", "calls");
+	for (i=0 ; i<count && i<REP_TOP_CLASSES ; i++)
+		fprintf (f, "%-24s %10.3f %8i\n", sorted[i]->name, sorted[i]->msec / rep_frames, sorted[i]->thinks);
+	if (rep_classes_full)
+		fprintf (f, "(more than %i classnames, some were not counted)\n", REP_CLASSES);
+	fprintf (f, "\n");
+	fclose (f);
+}
+
+/*
+=================
+Rep_EndLevel
+
+Called from ExitLevel, and before a new level starts in case the last
+one was left some other way (a "map" command)
+=================
+*/
+void Rep_EndLevel (void)
+{
+	if (!rep_collecting)
+		return;
+	if (rep_frames)
+		Rep_Write ();
+	rep_collecting = false;
+	prof_active = prof_recording;
+}
+
+/*
+=================
+Rep_BeginLevel
+
+Called at the end of SpawnEntities and ReadLevel with how long they took
+=================
+*/
+void Rep_BeginLevel (float msec, qboolean loaded)
+{
+	Rep_EndLevel ();
+	if (!sv_level_report || !sv_level_report->value)
+		return;
+
+	Q_strncpyz (rep_mapname, level.mapname, sizeof(rep_mapname));
+	rep_how = loaded ? "loaded" : "spawned";
+	rep_start_msec = msec;
+	rep_frames = 0;
+	memset (rep_hist, 0, sizeof(rep_hist));
+	rep_total = rep_max = 0;
+	rep_peak_edicts = globals.num_edicts;
+	rep_saves = 0;
+	rep_save_total = rep_save_max = 0;
+	memset (rep_msec, 0, sizeof(rep_msec));
+	memset (rep_traces, 0, sizeof(rep_traces));
+	rep_links = rep_link_skips = rep_multicasts = rep_allocs = rep_frees = 0;
+	memset (rep_classes, 0, sizeof(rep_classes));
+	rep_classes_full = false;
+
+	if (!prof_active)
+	{	// nothing left open from before
+		memset (&prof_current, 0, sizeof(prof_current));
+		memset (prof_depth, 0, sizeof(prof_depth));
+		prof_sp = 0;
+	}
+	rep_collecting = true;
+	prof_active = true;
+}
+
+/*
+==============================================================================
+
+FRAME BUDGET
+
+Gov_BeginFrame and Gov_EndFrame time every G_RunFrame, profiling or not,
+and keep a running average of about the last second, which Gov_FrameMsec
+hands out. With sv_frame_budget set to a number of milliseconds, while
+the average is over the budget,
+gov_level goes up one step a second, to at most GOV_LEVELS; once it has
+been under three quarters of the budget for three seconds it comes down
+one step. Each change is logged.
+
+The level only takes away things nobody plays for. At each step:
+
+  Gov_Scale      fewer gibs and debris under sv_maxgibs, and fewer
+                 target_precipitation drops
+  Gov_Lifetime   gibs, debris and fading corpses go away sooner
+  Gov_Interval   looping target_effects play less often
+  Gov_SkipFrame  reflections are updated every other frame, and from
+                 level 2 mega_gibs gibs stop bouncing
+
+==============================================================================
+*/
+
+#define	GOV_LEVELS		3
+#define	GOV_RAISE		10		// frames over budget between steps up
+#define	GOV_LOWER		30		// frames under budget between steps down
+
+int				gov_level;
+
+static double	gov_start;
+static float	gov_average;
+static int		gov_frames;			// since gov_level last changed
+
+void Gov_BeginFrame (void)
+{
+	gov_start = Prof_Seconds ();
+}
+
+void Gov_EndFrame (void)
+{
+	float	msec, budget;
+
+	if (!gov_start)
+		return;
+	msec = (float)((Prof_Seconds () - gov_start) * 1000.0);
+	Rep_CountFrame (msec);
+	if (!gov_average)
+		gov_average = msec;
+	else
+		gov_average += (msec - gov_average) * 0.1f;
+
+	budget = sv_frame_budget->value;
+	if (budget <= 0)
+	{
+		if (gov_level)
+			gi.dprintf ("frame budget off, cosmetic effects back to normal\n");
+		gov_level = 0;
+		gov_frames = 0;
+		return;
+	}
+	gov_frames++;
+
+	if (gov_average > budget)
+	{
+		if (gov_level < GOV_LEVELS && gov_frames >= GOV_RAISE)
+		{
+			gov_level++;
+			gov_frames = 0;
+			gi.dprintf ("frame budget: %.1f ms average over %g, cutting cosmetic effects to level %d\n",
+				gov_average, budget, gov_level);
+		}
+	}
+	else if (gov_average < budget * 0.75f)
+	{
+		if (gov_level > 0 && gov_frames >= GOV_LOWER)
+		{
+			gov_level--;
+			gov_frames = 0;
+			gi.dprintf ("frame budget: %.1f ms average, cosmetic effects back to level %d\n",
+				gov_average, gov_level);
+		}
+	}
+	else
+		gov_frames = 0;
+}
+
+/*
+=================
+Gov_Reset
+
+Called when a level is spawned or loaded
+=================
+*/
+void Gov_Reset (void)
+{
+	gov_level = 0;
+	gov_average = 0;
+	gov_frames = 0;
+}
+
+/*
+=================
+Gov_FrameMsec
+
+Average milliseconds G_RunFrame took lately, 0 until a frame is timed
+=================
+*/
+float Gov_FrameMsec (void)
+{
+	return gov_average;
+}
+
+/*
+=================
+Gov_Scale
+
+How much of the usual cosmetic work to do, 1 down to 0.25
+=================
+*/
+float Gov_Scale (void)
+{
+	return 1.0f - 0.25f * gov_level;
+}
+
+/*
+=================
+Gov_Lifetime / Gov_Interval
+
+A lifetime cut down, and a repeat interval stretched, by Gov_Scale
+=================
+*/
+float Gov_Lifetime (float time)
+{
+	return time * Gov_Scale ();
+}
+
+float Gov_Interval (float time)
+{
+	return time / Gov_Scale ();
+}
+
+/*
+=================
+Gov_SkipFrame
+
+True on the frames optional per-frame updates should be left out
+=================
+*/
+qboolean Gov_SkipFrame (void)
+{
+	return (gov_level > 0 && (level.framenum & 1));
+}
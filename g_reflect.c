@@ -29,6 +29,80 @@ edict_t	*g_mirror[MAX_MIRRORS];
 #define SF_REFLECT_OFF    1
 #define SF_REFLECT_TOGGLE 2
 
+/*
+=====================
+REFLECTED EFFECTS
+
+Each explosion, trail, puff of steam or spray of sparks is sent again
+for every mirror it shows up in, which used to mean to everyone in the
+PVS of the copy. A copy now goes out only when some client has both
+the mirror and the mirrored spot in its PVS, and not at all for a
+mirror whose plane is more than REFLECT_CULL_DIST away. Which clients
+can see a mirror is asked once per frame.
+=====================
+*/
+
+#define REFLECT_CULL_DIST	1024
+
+static int		reflect_view_frame[MAX_MIRRORS];	// level.framenum + 1
+static byte		*reflect_viewers;					// per mirror, a bit per client
+static int		reflect_view_bytes;
+
+static qboolean ReflectTooFar (edict_t *mirror, vec3_t origin)
+{
+	float	d;
+
+	switch(mirror->style)
+	{
+		case 0:  d = origin[2] - mirror->absmax[2]; break;
+		case 1:  d = origin[2] - mirror->absmin[2]; break;
+		case 2:  d = origin[0] - mirror->absmin[0]; break;
+		case 3:  d = origin[0] - mirror->absmax[0]; break;
+		case 4:  d = origin[1] - mirror->absmin[1]; break;
+		case 5:  d = origin[1] - mirror->absmax[1]; break;
+		default: return false;
+	}
+	return (fabs(d) > REFLECT_CULL_DIST);
+}
+
+static qboolean ReflectionSeen (int m, vec3_t org)
+{
+	edict_t	*mirror, *cl;
+	byte	*bits;
+	vec3_t	center;
+	int		i;
+
+	if (!reflect_viewers)
+	{
+		reflect_view_bytes = (game.maxclients + 7) >> 3;
+		reflect_viewers = gi.TagMalloc (MAX_MIRRORS * reflect_view_bytes, TAG_GAME);
+	}
+	mirror = g_mirror[m];
+	bits = reflect_viewers + m * reflect_view_bytes;
+
+	if (reflect_view_frame[m] != level.framenum + 1)
+	{
+		memset (bits, 0, reflect_view_bytes);
+		VectorAdd (mirror->absmin, mirror->absmax, center);
+		VectorScale (center, 0.5, center);
+		for (i = 1, cl = g_edicts + 1; i <= game.maxclients; i++, cl++)
+		{
+			if (cl->inuse && cl->client && gi.inPVS (cl->s.origin, center))
+				bits[(i-1) >> 3] |= 1 << ((i-1) & 7);
+		}
+		reflect_view_frame[m] = level.framenum + 1;
+	}
+
+	for (i = 1, cl = g_edicts + 1; i <= game.maxclients; i++, cl++)
+	{
+		if (!(bits[(i-1) >> 3] & (1 << ((i-1) & 7))))
+			continue;
+		if (gi.inPVS (cl->s.origin, org))
+			return true;
+	}
+	return false;
+}
+
 void ReflectExplosion (int type, vec3_t origin)
 {
 	int		m;
@@ -38,6 +112,7 @@ void ReflectExplosion (int type, vec3_t origin)
 	if(!level.num_reflectors)
 		return;
 
+	G_BeginMirroredTemps ();
 	for(m=0; m<level.num_reflectors; m++)
 	{
 		mirror = g_mirror[m];
@@ -51,6 +126,8 @@ void ReflectExplosion (int type, vec3_t origin)
 		// 'cuz there's no way to do it right
 		if((mirror->style <= 1) && (type != TE_BFG_EXPLOSION) && (type != TE_BFG_BIGEXPLOSION))
 			continue;
+		if(ReflectTooFar(mirror,origin))
+			continue;
 
 		VectorCopy(origin,org);
 		switch(mirror->style)
@@ -68,12 +145,11 @@ void ReflectExplosion (int type, vec3_t origin)
 		if(org[1] > mirror->absmax[1]) continue;
 		if(org[2] < mirror->absmin[2]) continue;
 		if(org[2] > mirror->absmax[2]) continue;
+		if(!ReflectionSeen(m,org)) continue;
 
-		gi.WriteByte (svc_temp_entity);
-		gi.WriteByte (type);
-		gi.WritePosition (org);
-		gi.multicast (org, MULTICAST_PVS);
+		G_TempPoint (type, org, MULTICAST_PVS);
 	}
+	G_EndMirroredTemps ();
 }
 
 void ReflectTrail (int type, vec3_t start, vec3_t end)
@@ -85,6 +161,7 @@ void ReflectTrail (int type, vec3_t start, vec3_t end)
 	if(!level.num_reflectors)
 		return;
 
+	G_BeginMirroredTemps ();
 	for(m=0; m<level.num_reflectors; m++)
 	{
 		mirror = g_mirror[m];
@@ -93,6 +170,8 @@ void ReflectTrail (int type, vec3_t start, vec3_t end)
 			continue;
 		if(mirror->spawnflags & SF_REFLECT_OFF)
 			continue;
+		if(ReflectTooFar(mirror,start))
+			continue;
 
 		VectorCopy(start,p1);
 		VectorCopy(end,  p2);
@@ -132,13 +211,11 @@ void ReflectTrail (int type, vec3_t start, vec3_t end)
 
 		// If p1 is within func_reflect, we assume p2 is also. If map is constructed 
 		// properly this should always be true.
+		if(!ReflectionSeen(m,p1)) continue;
 
-		gi.WriteByte (svc_temp_entity);
-		gi.WriteByte (type);
-		gi.WritePosition (p1);
-		gi.WritePosition (p2);
-		gi.multicast (p1, MULTICAST_PVS);
+		G_TempTrail (type, p1, p2, p1, MULTICAST_PVS);
 	}
+	G_EndMirroredTemps ();
 }
 
 void ReflectSteam (vec3_t origin,vec3_t movedir,int count,int sounds,int speed, int wait, int nextid)
@@ -158,6 +235,8 @@ void ReflectSteam (vec3_t origin,vec3_t movedir,int count,int sounds,int speed,
 			continue;
 		if(mirror->spawnflags & SF_REFLECT_OFF)
 			continue;
+		if(ReflectTooFar(mirror,origin))
+			continue;
 
 		VectorCopy(origin,org);
 		VectorCopy(movedir,dir);
@@ -195,8 +274,7 @@ void ReflectSteam (vec3_t origin,vec3_t movedir,int count,int sounds,int speed,
 		if(org[2] < mirror->absmin[2]) continue;
 		if(org[2] > mirror->absmax[2]) continue;
 
-		// If p1 is within func_reflect, we assume p2 is also. If map is constructed 
-		// properly this should always be true.
+		if(!ReflectionSeen(m,org)) continue;
 
 		gi.WriteByte (svc_temp_entity);
 		gi.WriteByte (TE_STEAM);
@@ -233,6 +311,9 @@ void ReflectSparks (int type,vec3_t origin,vec3_t movedir)
 		if(mirror->style <= 1)
 			continue;
 
+		if(ReflectTooFar(mirror,origin))
+			continue;
+
 		VectorCopy(origin,org);
 		VectorCopy(movedir,dir);
 		switch(mirror->style)
@@ -268,70 +349,351 @@ void ReflectSparks (int type,vec3_t origin,vec3_t movedir)
 		if(org[1] > mirror->absmax[1]) continue;
 		if(org[2] < mirror->absmin[2]) continue;
 		if(org[2] > mirror->absmax[2]) continue;
+		if(!ReflectionSeen(m,org)) continue;
 
-		gi.WriteByte(svc_temp_entity);
-		gi.WriteByte(type);
-		gi.WritePosition(org);
-		if(type != TE_CHAINFIST_SMOKE) 
-			gi.WriteDir(dir);
-		gi.multicast(org, MULTICAST_PVS);
+		G_TempImpact (type, org, (type != TE_CHAINFIST_SMOKE) ? dir : NULL);
 
 	}
 }
 
-void DeleteReflection (edict_t *ent, int index)
+/*
+=====================
+REFLECTION POOL
+
+A player walking along a mirror gains and loses reflections all the
+time. Reflections that go away are hidden and kept for the next one
+instead of being freed, along with the fake clients made for players'
+reflections, so a steady scene never allocates.
+
+Pooled reflections stay inuse with SVF_NOCLIENT set so G_Spawn can't
+hand them out. RestoreReflections puts them back in the pool when a
+level is loaded.
+=====================
+*/
+
+#define REFLECT_POOL_SIZE	64
+
+static edict_t		*reflect_pool[REFLECT_POOL_SIZE];
+static int			reflect_pool_count;
+static gclient_t	*reflect_clients[REFLECT_POOL_SIZE];	// TAG_LEVEL like G_Malloc
+static int			reflect_client_count;
+
+static edict_t *GetReflection (void)
 {
 	edict_t	*r;
 
-	if(index < 0)
+	if (reflect_pool_count)
 	{
-		int	i;
-		for(i=0; i<6; i++)
+		r = reflect_pool[--reflect_pool_count];
+		r->svflags &= ~SVF_NOCLIENT;
+		return r;
+	}
+
+	r = G_Spawn();
+	r->movetype = MOVETYPE_NONE;
+	r->solid = SOLID_NOT;
+	r->classname = "reflection";
+	r->flags = FL_REFLECT;
+	r->takedamage = DAMAGE_NO;
+	return r;
+}
+
+static gclient_t *GetReflectionClient (void)
+{
+	gclient_t	*cl;
+
+	if (reflect_client_count)
+		cl = reflect_clients[--reflect_client_count];
+	else
+		cl = (gclient_t *)G_Malloc(sizeof(gclient_t));
+	memset (cl, 0, sizeof(gclient_t));
+	return cl;
+}
+
+static void PoolReflection (edict_t *r)
+{
+	if (r->client)
+	{
+		if (reflect_client_count < REFLECT_POOL_SIZE)
+			reflect_clients[reflect_client_count++] = r->client;
+		else
+			G_Free(r->client);
+		r->client = NULL;
+	}
+
+	if (reflect_pool_count == REFLECT_POOL_SIZE)
+	{
+		G_FreeEdict (r);
+		return;
+	}
+
+	gi.unlinkentity (r);
+	memset (&r->s, 0, sizeof(r->s));
+	r->s.number = r - g_edicts;
+	r->svflags |= SVF_NOCLIENT;
+	reflect_pool[reflect_pool_count++] = r;
+}
+
+/*
+=====================
+InitReflections
+
+Called from InitGame. The viewer masks are sized by maxclients and
+are allocated again by the first reflected effect.
+=====================
+*/
+void InitReflections (void)
+{
+	reflect_viewers = NULL;
+	reflect_view_bytes = 0;
+	memset (reflect_view_frame, 0, sizeof(reflect_view_frame));
+}
+
+/*
+=====================
+RestoreReflections
+
+Called from SpawnEntities and ReadLevel. Pooled reflections from a
+savegame go back in the pool. The fake clients were TAG_LEVEL memory,
+so they are gone, and AddReflection makes new ones as needed.
+=====================
+*/
+void RestoreReflections (void)
+{
+	int		i;
+	edict_t	*e;
+
+	reflect_pool_count = 0;
+	reflect_client_count = 0;
+	memset (reflect_view_frame, 0, sizeof(reflect_view_frame));
+
+	for (i=game.maxclients+1; i<globals.num_edicts; i++)
+	{
+		e = &g_edicts[i];
+		if (!e->inuse || !(e->flags & FL_REFLECT) || !e->classname || strcmp(e->classname, "reflection"))
+			continue;
+		e->client = NULL;
+		if (e->svflags & SVF_NOCLIENT)
+			PoolReflection (e);
+	}
+}
+
+void DeleteReflection (edict_t *ent, int index)
+{
+	int		i;
+
+	for(i=0; i<6; i++)
+	{
+		if(index >= 0 && i != index)
+			continue;
+		if(ent->reflection[i])
+			PoolReflection (ent->reflection[i]);
+		ent->reflection[i] = NULL;
+	}
+}
+
+/*
+=====================
+REFLECTION GRID
+
+Only entities close to an enabled mirror can be reflected in it. A
+mirror reflects an entity when the mirrored origin falls inside the
+mirror's brush, so each mirror has a box of origins it can reflect:
+its own box with the reflecting axis flipped about the mirror plane.
+
+Those boxes are rasterized into a coarse grid over their union, each
+cell holding a bit for every mirror whose box touches it. The grid is
+rebuilt only when a mirror moves or is toggled. AddReflection looks up
+the cell of the entity and only tests the mirrors in it.
+=====================
+*/
+
+#define REFLECT_GRID_SIZE	32		// cells along each axis
+
+typedef struct
+{
+	int				num;					// mirrors the grid was built for
+	edict_t			*mirror[MAX_MIRRORS];
+	qboolean		active[MAX_MIRRORS];
+	vec3_t			mins[MAX_MIRRORS];		// box of origins each one reflects
+	vec3_t			maxs[MAX_MIRRORS];
+	vec3_t			gridmins, gridmaxs;
+	vec3_t			cellsize;
+	unsigned short	cells[REFLECT_GRID_SIZE][REFLECT_GRID_SIZE][REFLECT_GRID_SIZE];
+} reflectgrid_t;
+
+static reflectgrid_t	reflect_grid;
+
+static void ReflectVolume (edict_t *mirror, vec3_t mins, vec3_t maxs)
+{
+	int		axis;
+	float	k;
+
+	VectorCopy (mirror->absmin, mins);
+	VectorCopy (mirror->absmax, maxs);
+
+	// the mirrored coordinate is k - origin, see AddReflection
+	switch(mirror->style)
+	{
+	case 0:  axis = 2; k = 2*mirror->absmax[2] - mirror->moveinfo.distance - 2; break;
+	case 1:  axis = 2; k = 2*mirror->absmin[2] + mirror->moveinfo.distance + 2; break;
+	case 2:  axis = 0; k = 2*mirror->absmin[0] + mirror->moveinfo.distance + 2; break;
+	case 3:  axis = 0; k = 2*mirror->absmax[0] - mirror->moveinfo.distance - 2; break;
+	case 4:  axis = 1; k = 2*mirror->absmin[1] + mirror->moveinfo.distance + 2; break;
+	case 5:  axis = 1; k = 2*mirror->absmax[1] - mirror->moveinfo.distance - 2; break;
+	default: return;
+	}
+	mins[axis] = k - mirror->absmax[axis];
+	maxs[axis] = k - mirror->absmin[axis];
+}
+
+static int ReflectCell (int axis, float f)
+{
+	int		c;
+
+	c = (int)floor((f - reflect_grid.gridmins[axis]) / reflect_grid.cellsize[axis]);
+	if (c < 0)
+		return 0;
+	if (c >= REFLECT_GRID_SIZE)
+		return REFLECT_GRID_SIZE - 1;
+	return c;
+}
+
+/*
+=====================
+UpdateReflectGrid
+
+Called from ClientEndServerFrames before the entities are reflected
+=====================
+*/
+void UpdateReflectGrid (void)
+{
+	int			m, i, x, y, z;
+	int			lo[3], hi[3];
+	qboolean	changed, active, any;
+	vec3_t		mins, maxs;
+	edict_t		*mirror;
+
+	changed = (reflect_grid.num != level.num_reflectors);
+	reflect_grid.num = level.num_reflectors;
+	for(m=0; m<level.num_reflectors; m++)
+	{
+		mirror = g_mirror[m];
+		active = (mirror->inuse && !(mirror->spawnflags & SF_REFLECT_OFF));
+		VectorClear (mins);
+		VectorClear (maxs);
+		if (active)
+			ReflectVolume (mirror, mins, maxs);
+		if (mirror != reflect_grid.mirror[m] || active != reflect_grid.active[m]
+			|| !VectorCompare(mins, reflect_grid.mins[m]) || !VectorCompare(maxs, reflect_grid.maxs[m]))
 		{
-			r = ent->reflection[i];
-			if(r)
-			{
-				if(r->client)
-					G_Free(r->client);
-				memset (r, 0, sizeof(*r));
-				r->classname = "freed";
-				r->freetime = level.time;
-				r->inuse = false;
-			}
-			ent->reflection[i] = NULL;
+			reflect_grid.mirror[m] = mirror;
+			reflect_grid.active[m] = active;
+			VectorCopy (mins, reflect_grid.mins[m]);
+			VectorCopy (maxs, reflect_grid.maxs[m]);
+			changed = true;
 		}
 	}
-	else
+	if (!changed)
+		return;
+
+	memset (reflect_grid.cells, 0, sizeof(reflect_grid.cells));
+	any = false;
+	for(m=0; m<reflect_grid.num; m++)
 	{
-		r = ent->reflection[index];
-		if(r)
+		if (!reflect_grid.active[m])
+			continue;
+		if (!any)
+		{
+			VectorCopy (reflect_grid.mins[m], reflect_grid.gridmins);
+			VectorCopy (reflect_grid.maxs[m], reflect_grid.gridmaxs);
+			any = true;
+		}
+		else
+		{
+			AddPointToBounds (reflect_grid.mins[m], reflect_grid.gridmins, reflect_grid.gridmaxs);
+			AddPointToBounds (reflect_grid.maxs[m], reflect_grid.gridmins, reflect_grid.gridmaxs);
+		}
+	}
+	if (!any)
+	{
+		// nothing gets reflected, make every lookup miss
+		VectorSet (reflect_grid.gridmins, 1, 1, 1);
+		VectorClear (reflect_grid.gridmaxs);
+		return;
+	}
+
+	for (i=0; i<3; i++)
+	{
+		// leave some room for rounding on either side
+		reflect_grid.gridmins[i] -= 1;
+		reflect_grid.gridmaxs[i] += 1;
+		reflect_grid.cellsize[i] = (reflect_grid.gridmaxs[i] - reflect_grid.gridmins[i]) / REFLECT_GRID_SIZE;
+	}
+
+	for(m=0; m<reflect_grid.num; m++)
+	{
+		if (!reflect_grid.active[m])
+			continue;
+		for (i=0; i<3; i++)
 		{
-			if(r->client)
-				G_Free(r->client);
-			memset (r, 0, sizeof(*r));
-			r->classname = "freed";
-			r->freetime = level.time;
-			r->inuse = false;
-			ent->reflection[index] = NULL;
+			lo[i] = ReflectCell (i, reflect_grid.mins[m][i] - 1);
+			hi[i] = ReflectCell (i, reflect_grid.maxs[m][i] + 1);
 		}
+		for (x=lo[0]; x<=hi[0]; x++)
+			for (y=lo[1]; y<=hi[1]; y++)
+				for (z=lo[2]; z<=hi[2]; z++)
+					reflect_grid.cells[x][y][z] |= (1 << m);
 	}
 }
 
+/*
+=====================
+ReflectMirrors
+
+Returns a bit for each mirror that might reflect something at origin
+=====================
+*/
+static int ReflectMirrors (vec3_t origin)
+{
+	int		i;
+
+	for (i=0; i<3; i++)
+	{
+		if (origin[i] < reflect_grid.gridmins[i] || origin[i] > reflect_grid.gridmaxs[i])
+			return 0;
+	}
+	return reflect_grid.cells[ReflectCell(0, origin[0])][ReflectCell(1, origin[1])][ReflectCell(2, origin[2])];
+}
+
 void AddReflection (edict_t *ent)
 {
-	gclient_t	*cl;
-	edict_t		*mirror;
-	float		roll;
-	int			i, m;
-	qboolean	is_reflected;
-	vec3_t		forward;
-	vec3_t		org;
+	edict_t			*mirror, *r;
+	float			roll;
+	int				i, m, mirrors;
+	qboolean		is_reflected, spawned, moved;
+	vec3_t			forward;
+	vec3_t			org;
+	entity_state_t	s;
+
+	mirrors = ReflectMirrors (ent->s.origin);
+	if (!mirrors)
+	{
+		for(i=0; i<6; i++)
+		{
+			if (ent->reflection[i])
+				DeleteReflection(ent,i);
+		}
+		return;
+	}
 
 	for(i=0; i<6; i++)
 	{
 		is_reflected = false;
 		for(m=0; m<level.num_reflectors && !is_reflected; m++)
 		{
+			if (!(mirrors & (1 << m)))
+				continue;
 			mirror = g_mirror[m];
 			if(!mirror->inuse)
 				continue;
@@ -359,94 +721,100 @@ void AddReflection (edict_t *ent)
 		}
 		if(is_reflected)
 		{
+			spawned = false;
 			if (!ent->reflection[i])
 			{			
-				ent->reflection[i] = G_Spawn();
+				ent->reflection[i] = GetReflection();
+				spawned = true;
 			
 				if(ent->s.effects & EF_ROTATE)
 				{
 					ent->s.effects &= ~EF_ROTATE;
 					gi.linkentity(ent);
 				}
-				ent->reflection[i]->movetype = MOVETYPE_NONE;
-				ent->reflection[i]->solid = SOLID_NOT;
-				ent->reflection[i]->classname = "reflection";
-				ent->reflection[i]->flags = FL_REFLECT;
-				ent->reflection[i]->takedamage = DAMAGE_NO;
-			}
-			if (ent->client && !ent->reflection[i]->client)
-			{
-				cl = (gclient_t *)G_Malloc(sizeof(gclient_t)); 
-				ent->reflection[i]->client = cl; 
 			}
-			if (ent->client && ent->reflection[i]->client)
+			r = ent->reflection[i];
+			if (ent->client && !r->client)
+				r->client = GetReflectionClient();
+
+			// build the new state aside, so a reflection whose
+			// source did not change is left alone
+			s = r->s;
+			if (ent->client && r->client)
 			{
 //				Lazarus: Hmm.. this crashes when loading saved game.
 //				         Not sure what use pers is anyhow?
-//				ent->reflection[i]->client->pers = ent->client->pers;
-				ent->reflection[i]->s = ent->s;
+//				r->client->pers = ent->client->pers;
+				s = ent->s;
+				s.solid = 0;	// gi.linkentity clears it for SOLID_NOT
 			}
-			ent->reflection[i]->s.number     = ent->reflection[i] - g_edicts;
-			ent->reflection[i]->s.modelindex = ent->s.modelindex;
-			ent->reflection[i]->s.modelindex2 = ent->s.modelindex2;
-			ent->reflection[i]->s.modelindex3 = ent->s.modelindex3;
-			ent->reflection[i]->s.modelindex4 = ent->s.modelindex4;
+			s.number     = r - g_edicts;
+			s.modelindex = ent->s.modelindex;
+			s.modelindex2 = ent->s.modelindex2;
+			s.modelindex3 = ent->s.modelindex3;
+			s.modelindex4 = ent->s.modelindex4;
 		#ifdef KMQUAKE2_ENGINE_MOD
-			ent->reflection[i]->s.modelindex5 = ent->s.modelindex5;
-			ent->reflection[i]->s.modelindex6 = ent->s.modelindex6;
+			s.modelindex5 = ent->s.modelindex5;
+			s.modelindex6 = ent->s.modelindex6;
 		#ifndef LOOP_SOUND_ATTENUATION
-			ent->reflection[i]->s.modelindex7 = ent->s.modelindex7;
-			ent->reflection[i]->s.modelindex8 = ent->s.modelindex8;
+			s.modelindex7 = ent->s.modelindex7;
+			s.modelindex8 = ent->s.modelindex8;
 		#endif
-			ent->reflection[i]->s.alpha = ent->s.alpha;
+			s.alpha = ent->s.alpha;
 		#endif
-			ent->reflection[i]->s.skinnum = ent->s.skinnum;
-			ent->reflection[i]->s.frame = ent->s.frame;
-			ent->reflection[i]->s.effects = ent->s.effects;
-			ent->reflection[i]->s.renderfx = ent->s.renderfx;
-			ent->reflection[i]->s.renderfx &= ~RF_IR_VISIBLE;
+			s.skinnum = ent->s.skinnum;
+			s.frame = ent->s.frame;
+			s.effects = ent->s.effects;
+			s.renderfx = ent->s.renderfx;
+			s.renderfx &= ~RF_IR_VISIBLE;
 		#ifdef KMQUAKE2_ENGINE_MOD
 			// Don't flip if left handed player model
 			if ( !(ent->s.modelindex == (MAX_MODELS-1) && hand->value == 1) )
-				ent->reflection[i]->s.renderfx |= RF_MIRRORMODEL; // Knightmare added- flip reflected models
+				s.renderfx |= RF_MIRRORMODEL; // Knightmare added- flip reflected models
 		#endif
-			VectorCopy (ent->s.angles, ent->reflection[i]->s.angles);
+			VectorCopy (ent->s.angles, s.angles);
 			switch(i)
 			{
 			case 0:
 			case 1:
-				ent->reflection[i]->s.angles[0]+=180;
-				ent->reflection[i]->s.angles[1]+=180;
-				ent->reflection[i]->s.angles[2]=360-ent->reflection[i]->s.angles[2];
+				s.angles[0]+=180;
+				s.angles[1]+=180;
+				s.angles[2]=360-s.angles[2];
 				break;
 			case 2:
 			case 3:
-				AngleVectors(ent->reflection[i]->s.angles,forward,NULL,NULL);
-				roll = ent->reflection[i]->s.angles[2];
+				AngleVectors(s.angles,forward,NULL,NULL);
+				roll = s.angles[2];
 				forward[0] = -forward[0];
-				vectoangles(forward,ent->reflection[i]->s.angles);
-				ent->reflection[i]->s.angles[2] = 360-roll;
+				vectoangles(forward,s.angles);
+				s.angles[2] = 360-roll;
 				break;
 			case 4:
 			case 5:
-				AngleVectors(ent->reflection[i]->s.angles,forward,NULL,NULL);
-				roll = ent->reflection[i]->s.angles[2];
+				AngleVectors(s.angles,forward,NULL,NULL);
+				roll = s.angles[2];
 				forward[1] = -forward[1];
-				vectoangles(forward,ent->reflection[i]->s.angles);
-				ent->reflection[i]->s.angles[2] = 360-roll;
+				vectoangles(forward,s.angles);
+				s.angles[2] = 360-roll;
 			}
 
-			VectorCopy (org, ent->reflection[i]->s.origin);
+			VectorCopy (org, s.origin);
 			if(ent->s.renderfx & RF_BEAM)
 			{
 				vec3_t	delta;
 
-				VectorSubtract(ent->reflection[i]->s.origin,ent->s.origin,delta);
-				VectorAdd(ent->s.old_origin,delta,ent->reflection[i]->s.old_origin);
+				VectorSubtract(s.origin,ent->s.origin,delta);
+				VectorAdd(ent->s.old_origin,delta,s.old_origin);
 			}
 			else
-				VectorCopy(ent->reflection[i]->s.origin, ent->reflection[i]->s.old_origin);
-			gi.linkentity (ent->reflection[i]);
+				VectorCopy(s.origin, s.old_origin);
+
+			if (!spawned && !memcmp(&s, &r->s, sizeof(s)))
+				continue;
+			moved = (spawned || !VectorCompare(s.origin, r->s.origin));
+			r->s = s;
+			if (moved)
+				gi.linkentity (r);
 		}
 		else if (ent->reflection[i])
 		{
@@ -67,6 +67,14 @@
  */
 
 #include "g_local.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
 /*
 *
 * When ever the savegame version
@@ -76,7 +84,7 @@
 * in tables/ are changed, otherwise
 * strange things may happen.
 */
-#define SAVEGAMEVER "Q2VR-1"
+#define SAVEGAMEVER "Q2VR-2"
 
 
 /*
@@ -118,9 +126,6 @@ typedef struct
 {
     char *funcStr;
     byte *funcPtr;
-#ifdef Q2VR_ENGINE_MOD
-    hash32_t funcHash;
-#endif
 } functionList_t;
 
 /*
@@ -133,11 +138,61 @@ typedef struct
 {
     char	*mmoveStr;
     mmove_t *mmovePtr;
-#ifdef Q2VR_ENGINE_MOD
-    hash32_t mmoveHash;
-#endif
 } mmoveList_t;
 
+/*
+ * Savegames are serialized into
+ * one growable memory buffer and
+ * written out with a single fwrite
+ * instead of many small ones.
+ */
+typedef struct
+{
+    byte *data;
+    int size;
+    int maxsize;
+} savebuf_t;
+
+/*
+ * Per struct list of the fields
+ * that the writer has to touch,
+ * so an edict does not walk the
+ * whole fields table.
+ */
+typedef struct
+{
+    field_t **fixup;    /* pointers turned into lengths or indexes */
+    int numfixup;
+    field_t **data;     /* fields with data following the struct */
+    int numdata;
+} savefields_t;
+
+/*
+ * Savegames and transition
+ * entities are loaded into
+ * memory whole and read from
+ * there.
+ */
+typedef struct
+{
+    byte *data;
+    int size;
+    int pos;
+} loadbuf_t;
+
+/*
+ * A level file starts with the edict
+ * size. The delta format starts with
+ * LEVELFILE_DELTA followed by the edict
+ * size, and a compressed file with
+ * LEVELFILE_LZSS followed by the size
+ * of the file it unpacks to.
+ */
+#define LEVELFILE_DELTA -2
+#define LEVELFILE_LZSS -3
+
+void InitSaveFields(void);
+
 /* ========================================================= */
 
 /*
@@ -196,22 +251,212 @@ field_t clientfields[] = {
 #include "tables/clientfields.h"
 };
 
-int funcsort(const void *func1, const void *func2) {
-    functionList_t *a = (functionList_t *)func1;
-    functionList_t *b = (functionList_t *)func2;
-    return a->funcPtr - b->funcPtr;
+/*
+ * Fields of the queued uses
+ * from G_DelayUse
+ */
+#define DUOFS(x) (int)(intptr_t)&(((delayeduse_t *)0)->x)
+
+static field_t delayfields[] = {
+    {"activator", DUOFS(activator), F_EDICT},
+    {"target_ent", DUOFS(target_ent), F_EDICT},
+    {"message", DUOFS(message), F_LSTRING},
+    {"target", DUOFS(target), F_LSTRING},
+    {"killtarget", DUOFS(killtarget), F_LSTRING},
+    
+    {NULL, 0, F_INT}
+};
+
+/*
+ * Open addressed hash tables over
+ * functionList and mmoveList, one by
+ * name for loading and one by address
+ * for saving. Both list types start
+ * with the name string followed by
+ * the pointer, which is all the tables
+ * look at.
+ *
+ * The lists stay in the order of the
+ * tables/ headers. Addresses are only
+ * known once the dll is loaded, so the
+ * tables are built the first time a
+ * savegame is written or read instead
+ * of sorting the lists in InitGame.
+ */
+typedef struct
+{
+    byte *list;
+    int stride;
+    int count;
+    qboolean byaddress;
+    uint32_t mask;
+    uint32_t *keys;     /* full hash of each slot's entry */
+    int *slots;         /* index into list, -1 if empty */
+} listhash_t;
+
+static listhash_t funcNameHash = {
+    (byte *)functionList, sizeof(functionList[0]),
+    sizeof(functionList) / sizeof(functionList[0]) - 1, false
+};
+static listhash_t funcAddressHash = {
+    (byte *)functionList, sizeof(functionList[0]),
+    sizeof(functionList) / sizeof(functionList[0]) - 1, true
+};
+static listhash_t mmoveNameHash = {
+    (byte *)mmoveList, sizeof(mmoveList[0]),
+    sizeof(mmoveList) / sizeof(mmoveList[0]) - 1, false
+};
+static listhash_t mmoveAddressHash = {
+    (byte *)mmoveList, sizeof(mmoveList[0]),
+    sizeof(mmoveList) / sizeof(mmoveList[0]) - 1, true
+};
+
+#define ListHash_String(t, i) (*(char **)((t)->list + (i) * (t)->stride))
+#define ListHash_Pointer(t, i) (*(void **)((t)->list + (i) * (t)->stride + sizeof(char *)))
+
+static uint32_t
+ListHash_StringKey(const char *s)
+{
+    uint32_t hash = 0;
+    
+    while (*s)
+    {
+        hash = hash * 31 + *(unsigned char *)s++;
+    }
+    
+    return hash;
+}
+
+static uint32_t
+ListHash_PointerKey(const void *p)
+{
+    uint32_t hash;
+    
+    /* functions and mmove_t are aligned and
+       all of them are inside this dll */
+    hash = (uint32_t)((size_t)p >> 2);
+    hash ^= hash >> 15;
+    hash *= 2654435761u;
+    hash ^= hash >> 13;
+    
+    return hash;
+}
+
+static qboolean
+ListHash_Matches(listhash_t *table, int i, const void *key)
+{
+    if (table->byaddress)
+    {
+        return ListHash_Pointer(table, i) == key;
+    }
+    
+    return !strcmp(ListHash_String(table, i), (const char *)key);
 }
 
+static uint32_t
+ListHash_Key(listhash_t *table, const void *key)
+{
+    if (table->byaddress)
+    {
+        return ListHash_PointerKey(key);
+    }
+    
+    return ListHash_StringKey((const char *)key);
+}
 
-int mmovesort(const void *mmove1, const void *mmove2) {
-    mmoveList_t *a = (mmoveList_t *)mmove1;
-    mmoveList_t *b = (mmoveList_t *)mmove2;
-    return a->mmovePtr - b->mmovePtr;
+/*
+ * When a name or an address is listed
+ * twice the first entry wins, as it
+ * did with the linear search.
+ */
+static void
+ListHash_Build(listhash_t *table)
+{
+    uint32_t hash, slot;
+    const void *key;
+    int i, size;
+    
+    size = 64;
+    
+    while (size < table->count * 2)
+    {
+        size <<= 1;
+    }
+    
+    table->mask = size - 1;
+    table->keys = gi.TagMalloc(size * sizeof(uint32_t), TAG_GAME);
+    table->slots = gi.TagMalloc(size * sizeof(int), TAG_GAME);
+    memset(table->slots, -1, size * sizeof(int));
+    
+    for (i = 0; i < table->count; i++)
+    {
+        if (table->byaddress)
+        {
+            key = ListHash_Pointer(table, i);
+        }
+        else
+        {
+            key = ListHash_String(table, i);
+        }
+    
+        hash = ListHash_Key(table, key);
+    
+        for (slot = hash & table->mask; table->slots[slot] >= 0; slot = (slot + 1) & table->mask)
+        {
+            if (table->keys[slot] == hash && ListHash_Matches(table, table->slots[slot], key))
+            {
+                break;
+            }
+        }
+    
+        if (table->slots[slot] < 0)
+        {
+            table->keys[slot] = hash;
+            table->slots[slot] = i;
+        }
+    }
 }
 
-static uint32_t funcListSize = 0;
+/*
+ * Returns the list index of key, a
+ * name or an address depending on the
+ * table, or -1 if it is not listed.
+ */
+static int
+ListHash_Find(listhash_t *table, const void *key)
+{
+    uint32_t hash, slot;
+    
+    if (!table->slots)
+    {
+        ListHash_Build(table);
+    }
+    
+    hash = ListHash_Key(table, key);
+    
+    for (slot = hash & table->mask; table->slots[slot] >= 0; slot = (slot + 1) & table->mask)
+    {
+        if (table->keys[slot] == hash && ListHash_Matches(table, table->slots[slot], key))
+        {
+            return table->slots[slot];
+        }
+    }
+    
+    return -1;
+}
 
-static uint32_t mmoveListSize = 0;
+/*
+ * Called by InitGame. Empties the
+ * tables so they are built again.
+ */
+static void
+ListHash_Reset(void)
+{
+    funcNameHash.slots = NULL;
+    funcAddressHash.slots = NULL;
+    mmoveNameHash.slots = NULL;
+    mmoveAddressHash.slots = NULL;
+}
 
 /*
 ============
@@ -220,6 +465,11 @@ InitGame
 This will be called when the dll is first loaded, which
 only happens when a new game is started or a save game
 is loaded.
+
+ShutdownGame frees all TAG_GAME memory, so the tables the
+Init functions below set up hold stale pointers from the
+last game. Those functions only drop the pointers; they
+must never free or reuse what they pointed at.
 ============
 */
 
@@ -230,34 +480,8 @@ void InitGame (void)
 	gi.dprintf ("\n==== InitGame (Lazarus) ====\n");
 	gi.dprintf("by Mr. Hyde & Mad Dog\ne-mail: rascal@vicksburg.com\n\n");
 
-#ifdef Q2VR_ENGINE_MOD
-    {
-        int i;
-        gi.dprintf("Initializing hash tables...");
-        
-        for (i = 0; mmoveList[i].mmoveStr; i++)
-        {
-            mmoveList[i].mmoveHash = Hash32(mmoveList[i].mmoveStr, strlen(mmoveList[i].mmoveStr));
-        }
-        
-        for (i = 0; functionList[i].funcStr; i++)
-        {
-            functionList[i].funcHash = Hash32(functionList[i].funcStr, strlen(functionList[i].funcStr));
-        }
-        
-        gi.dprintf(" Done!\n");
-    }
-#endif
-  
-    gi.dprintf("Sorting tables...");
-
-    funcListSize = sizeof(functionList) / sizeof(functionList[0]) - 1;
-    qsort(functionList,funcListSize, sizeof(functionList[0]), funcsort);
-
-    mmoveListSize = (sizeof(mmoveList) / sizeof(mmoveList[0])) - 1;
-    qsort(mmoveList,mmoveListSize, sizeof(mmoveList[0]), mmovesort);
-    
-    gi.dprintf(" Done!\n");
+    /* function and mmove lookups are built on first use */
+    ListHash_Reset();
     
     // Knightmare- init cvars
 	lithium_defaults();
@@ -302,6 +526,7 @@ void InitGame (void)
 	spectator_password = gi.cvar ("spectator_password", "", CVAR_USERINFO);
 	needpass = gi.cvar ("needpass", "0", CVAR_SERVERINFO);
 	filterban = gi.cvar ("filterban", "1", 0);
+	maxipfilters = gi.cvar ("maxipfilters", "1024", 0);
 
 	g_select_empty = gi.cvar ("g_select_empty", "0", CVAR_ARCHIVE);
 
@@ -343,6 +568,7 @@ void InitGame (void)
 	joy_pitchsensitivity = gi.cvar("joy_pitchsensitivity", "1", 0);
 	joy_yawsensitivity = gi.cvar("joy_yawsensitivity", "-1", 0);
 	jump_kick = gi.cvar("jump_kick", "0", CVAR_SERVERINFO|CVAR_LATCH);
+	lightramp_step = gi.cvar("lightramp_step", "1", 0);
 	lights = gi.cvar("lights", "1", 0);
 	lightsmin = gi.cvar("lightsmin", "a", CVAR_SERVERINFO);
 	m_pitch = gi.cvar("m_pitch", "0.022", 0);
@@ -354,6 +580,12 @@ void InitGame (void)
 #else
 	sv_maxgibs = gi.cvar("sv_maxgibs", "20", CVAR_SERVERINFO);
 #endif
+	// most gibs and debris chunks alive at once, 0 for no limit
+	sv_gib_pool = gi.cvar("sv_gib_pool", "256", 0);
+	// player corpses kept in deathmatch and coop, from the next map on
+	sv_bodyque = gi.cvar("sv_bodyque", va("%i", BODY_QUEUE_SIZE), 0);
+	// most ping, in ms, that hitscan weapons make up for; 0 for none
+	sv_lag_compensate = gi.cvar("sv_lag_compensate", "0", CVAR_SERVERINFO);
 	turn_rider = gi.cvar("turn_rider", "1", CVAR_CHEAT);
 	zoomrate = gi.cvar("zoomrate", "80", CVAR_ARCHIVE);
 	zoomsnap = gi.cvar("zoomsnap", "20", CVAR_ARCHIVE);
@@ -419,8 +651,37 @@ void InitGame (void)
 	bounce_bounce = gi.cvar("bounce_bounce", "0.5", 0);
 	bounce_minv   = gi.cvar("bounce_minv",   "60",  0);
 
+	// write level saves on a worker thread
+	sv_async_save = gi.cvar("sv_async_save", "0", CVAR_ARCHIVE);
+	// store level saves as changes since spawn, and pack them
+	sv_delta_save = gi.cvar("sv_delta_save", "0", CVAR_ARCHIVE);
+	sv_compress_save = gi.cvar("sv_compress_save", "0", CVAR_ARCHIVE);
+	// answer repeated traces within a frame from a cache
+	sv_trace_cache = gi.cvar("sv_trace_cache", "0", 0);
+	// split each vehicle move into this many steps
+	sv_vehicle_substeps = gi.cvar("sv_vehicle_substeps", "1", CVAR_ARCHIVE);
+	// split each falling toss or bounce move into this many steps
+	sv_toss_substeps = gi.cvar("sv_toss_substeps", "1", CVAR_ARCHIVE);
+	// idle monsters nobody can see think every this many frames
+	sv_monster_lod = gi.cvar("sv_monster_lod", "0", CVAR_ARCHIVE);
+	sv_monster_lod_dist = gi.cvar("sv_monster_lod_dist", "1024", CVAR_ARCHIVE);
+	// milliseconds a frame may take before cosmetic effects are cut back
+	sv_frame_budget = gi.cvar("sv_frame_budget", "0", CVAR_ARCHIVE);
+	// host:port to send statsd lines to once a second
+	sv_telemetry = gi.cvar("sv_telemetry", "", 0);
+	sv_telemetry_prefix = gi.cvar("sv_telemetry_prefix", "vrgame", 0);
+	// append a performance summary to perf_<mapname>.log as each level ends
+	sv_level_report = gi.cvar("sv_level_report", "0", 0);
+
 	// items
 	InitItems ();
+	ED_InitSpawnTable ();
+	ED_InitFieldTable ();
+
+	// index the pak files we search for scripts, text and models
+	Pak_Init ();
+
+	InitSaveFields ();
 
 	Com_sprintf (game.helpmessage1, sizeof(game.helpmessage1), "");
 
@@ -438,6 +699,31 @@ void InitGame (void)
     game.clients = g_clients;
 	globals.num_edicts = game.maxclients+1;
 
+	G_InitEdictLists ();
+	AI_InitSightCache ();
+	M_InitMoveCache ();
+	G_InitTraceHooks ();
+	G_InitClientCommands ();
+	G_InitProjectiles ();
+	G_InitAttachedSounds ();
+	G_InitLagComp ();
+	InitReflections ();
+	movewith_initgame ();
+	target_string_initgame ();
+
+// ACEBOT_ADD
+	ace_compress_nodes = gi.cvar("ace_compress_nodes", "0", CVAR_ARCHIVE);
+	ace_map_nodes = gi.cvar("ace_map_nodes", "0", CVAR_ARCHIVE);
+	ace_trace_budget = gi.cvar("ace_trace_budget", "64", 0);
+	ace_think_budget = gi.cvar("ace_think_budget", "8", 0);
+	ace_link_budget = gi.cvar("ace_link_budget", "8", 0);
+	ace_autofill = gi.cvar("ace_autofill", "0", 0);
+	ace_autofill_msec = gi.cvar("ace_autofill_msec", "0", 0);
+	ACEND_InitPathTable ();
+	ACEAI_InitWeaponPicks ();
+	ACEMV_InitProbes ();
+// ACEBOT_END
+
 //ZOID
 	CTFInit();
 //ZOID
@@ -454,20 +740,45 @@ void InitGame (void)
 functionList_t *
 GetFunctionByAddress(byte *adr)
 {
-    int min = 0;
-    int max = funcListSize - 1;
-    while (max >= min) {
-        int mid = floor((max - min) / 2.0) + min;
-        if (functionList[mid].funcPtr == adr)
+    int i;
+    
+    if ((i = ListHash_Find(&funcAddressHash, adr)) < 0)
+    {
+        return NULL;
+    }
+    
+    return &functionList[i];
+}
+
+/*
+ * Returns the name of the listed
+ * function closest below adr and
+ * the offset of adr into it, to
+ * report a code address. NULL if
+ * adr is below all of them.
+ */
+char *
+GetFunctionNameNear(byte *adr, int *offset)
+{
+    functionList_t *best = NULL;
+    int i;
+
+    for (i = 0; functionList[i].funcStr; i++)
+    {
+        if ((functionList[i].funcPtr <= adr) &&
+            (!best || (functionList[i].funcPtr > best->funcPtr)))
         {
-            return &functionList[mid];
-        } else if (functionList[mid].funcPtr < adr) {
-            min = mid + 1;
-        } else {
-            max = mid - 1;
+            best = &functionList[i];
         }
     }
-    return NULL;
+
+    if (!best)
+    {
+        return NULL;
+    }
+
+    *offset = (int)(adr - best->funcPtr);
+    return best->funcStr;
 }
 
 /*
@@ -481,22 +792,13 @@ byte *
 FindFunctionByName(char *name)
 {
     int i;
-#ifdef Q2VR_ENGINE_MOD
-    hash32_t nameHash = Hash32(name, strlen(name));
-#endif
-    for (i = 0; functionList[i].funcStr; i++)
+    
+    if ((i = ListHash_Find(&funcNameHash, name)) < 0)
     {
-#ifdef Q2VR_ENGINE_MOD
-        if (!HashCompare32(nameHash, functionList[i].funcHash) && !strcmp(name, functionList[i].funcStr))
-#else
-        if (!strcmp(name, functionList[i].funcStr))
-#endif
-        {
-            return functionList[i].funcPtr;
-        }
+        return NULL;
     }
     
-    return NULL;
+    return functionList[i].funcPtr;
 }
 
 /*
@@ -507,20 +809,14 @@ FindFunctionByName(char *name)
 mmoveList_t *
 GetMmoveByAddress(mmove_t *adr)
 {
-    int min = 0;
-    int max = mmoveListSize - 1;
-    while (max >= min) {
-        int mid = floor((max - min) / 2.0) + min;
-        if (mmoveList[mid].mmovePtr == adr)
-        {
-            return &mmoveList[mid];
-        } else if (mmoveList[mid].mmovePtr < adr) {
-            min = mid + 1;
-        } else {
-            max = mid - 1;
-        }
+    int i;
+    
+    if ((i = ListHash_Find(&mmoveAddressHash, adr)) < 0)
+    {
+        return NULL;
     }
-    return NULL;
+    
+    return &mmoveList[i];
 }
 
 /*
@@ -532,99 +828,492 @@ mmove_t *
 FindMmoveByName(char *name)
 {
     int i;
-#ifdef Q2VR_ENGINE_MOD
-    hash32_t nameHash = Hash32(name, strlen(name));
-#endif
-    for (i = 0; mmoveList[i].mmoveStr; i++)
+    
+    if ((i = ListHash_Find(&mmoveNameHash, name)) < 0)
     {
-#ifdef Q2VR_ENGINE_MOD
-        if (!HashCompare32(nameHash, mmoveList[i].mmoveHash) && !strcmp(name, mmoveList[i].mmoveStr))
-#else
-        if (!strcmp(name, mmoveList[i].mmoveStr))
-#endif
-        {
-            return mmoveList[i].mmovePtr;
-        }
+        return NULL;
     }
     
-    return NULL;
+    return mmoveList[i].mmovePtr;
 }
 
 
 /* ========================================================= */
 
+static savebuf_t savebuf;
+static savebuf_t packbuf;
+
+static savebuf_t transbuf;      /* trigger_transition entities */
+static loadbuf_t transload;
+static qboolean transpending;   /* transbuf is for the next map */
+static qboolean transloadfile;  /* transload came from trans.ent */
+
+static savefields_t edictSaveFields;
+static savefields_t levelSaveFields;
+static savefields_t clientSaveFields;
+static savefields_t delaySaveFields;
+
+/* spawn images for delta level saves */
+static edict_t *levelbase;          /* spawn images of the current level */
+static uint32_t *levelbasesum;      /* their checksums, 0 if the slot was empty */
+static int levelbasecount;
+static edict_t leveldelta;
+    
 /*
- * The following two functions are
- * doing the dirty work to write the
- * data generated by the functions
- * below this block into files.
+ * Makes room for len more bytes
+ * at the end of the buffer and
+ * returns a pointer to them.
  */
-void
-WriteField1(FILE *f, field_t *field, byte *base)
+static void *
+SaveBuf_Alloc(savebuf_t *buf, int len)
 {
+    byte *newdata;
+    int newsize;
     void *p;
-    int len;
-    int index;
-    functionList_t *func;
-    mmoveList_t *mmove;
     
-    if (field->flags & FFL_SPAWNTEMP)
+    if (buf->size + len > buf->maxsize)
     {
-        return;
+        newsize = buf->maxsize ? buf->maxsize * 2 : 256 * 1024;
+        
+        while (newsize < buf->size + len)
+        {
+            newsize *= 2;
+        }
+        
+        newdata = gi.TagMalloc(newsize, TAG_GAME);
+        
+        if (buf->data)
+        {
+            memcpy(newdata, buf->data, buf->size);
+            gi.TagFree(buf->data);
+        }
+        
+        buf->data = newdata;
+        buf->maxsize = newsize;
     }
     
-    p = (void *)(base + field->ofs);
+    p = buf->data + buf->size;
+    buf->size += len;
+    return p;
+}
+
+static void
+SaveBuf_Write(savebuf_t *buf, const void *data, int len)
+{
+    memcpy(SaveBuf_Alloc(buf, len), data, len);
+}
+
+/*
+ * Writes the buffer into a file
+ * with one call and empties it.
+ */
+static void
+SaveBuf_Flush(savebuf_t *buf, FILE *f)
+{
+    if (buf->size)
+    {
+        fwrite(buf->data, buf->size, 1, f);
+    }
     
-    switch (field->type)
+    buf->size = 0;
+}
+
+/*
+ * Reads len bytes from the
+ * memory behind buf.
+ */
+static void
+LoadBuf_Read(loadbuf_t *buf, void *data, int len)
+{
+    if ((len < 0) || (buf->pos + len > buf->size))
     {
-        case F_INT:
-        case F_FLOAT:
-        case F_ANGLEHACK:
-        case F_VECTOR:
-        case F_IGNORE:
-            break;
-            
-        case F_LSTRING:
-        case F_GSTRING:
-            
-            if (*(char **)p)
-            {
-                len = (int)strlen(*(char **)p) + 1;
-            }
-            else
-            {
-                len = 0;
-            }
-            
-            *(int *)p = len;
-            break;
-        case F_EDICT:
-            
-            if (*(edict_t **)p == NULL)
-            {
-                index = -1;
-            }
-            else
-            {
-                index = *(edict_t **)p - g_edicts;
-            }
-            
-            *(int *)p = index;
-            break;
-        case F_CLIENT:
-            
-            if (*(gclient_t **)p == NULL)
-            {
-                index = -1;
-            }
-            else
-            {
-                index = *(gclient_t **)p - game.clients;
-            }
-            
-            *(int *)p = index;
-            break;
-        case F_ITEM:
+        gi.error("Savegame is truncated or damaged");
+    }
+    
+    memcpy(data, buf->data + buf->pos, len);
+    buf->pos += len;
+}
+
+/*
+ * Returns the next len bytes, which
+ * must be a string with its 0. It
+ * is used in place, so it lives as
+ * long as the buffer does.
+ */
+static char *
+LoadBuf_String(loadbuf_t *buf, int len)
+{
+    char *s;
+    
+    if ((len <= 0) || (buf->pos + len > buf->size))
+    {
+        gi.error("Savegame is truncated or damaged");
+    }
+    
+    s = (char *)buf->data + buf->pos;
+    buf->pos += len;
+    
+    if (s[len - 1])
+    {
+        gi.error("Savegame is truncated or damaged");
+    }
+    
+    return s;
+}
+
+/*
+ * Reads a whole file into memory
+ * with the given tag.
+ */
+static void
+LoadBuf_LoadFile(loadbuf_t *buf, const char *filename, int tag)
+{
+    FILE *f;
+    int size;
+    
+    f = fopen(filename, "rb");
+    
+    if (!f)
+    {
+        gi.error("Couldn't open %s", filename);
+    }
+    
+    fseek(f, 0, SEEK_END);
+    size = (int)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    
+    memset(buf, 0, sizeof(*buf));
+    buf->data = gi.TagMalloc(size > 0 ? size : 1, tag);
+    buf->size = (int)fread(buf->data, 1, size, f);
+    fclose(f);
+}
+    
+/* ========================================================= */
+
+/*
+ * With sv_async_save set, WriteLevel
+ * only builds the file in memory. The
+ * buffer is handed to a worker thread
+ * that writes and closes the file while
+ * the game goes on, and the frame
+ * thread starts over with a second
+ * buffer.
+ *
+ * The file is opened before the hand
+ * over, so gi.error is only ever called
+ * from the frame thread. The worker
+ * makes no gi calls at all. Everything
+ * that saves, loads, spawns a map or
+ * frees the game memory calls
+ * WaitForSave first.
+ *
+ * WriteGame stays synchronous, since
+ * the engine copies the save files
+ * right after it returns.
+ */
+
+static savebuf_t asyncbuf;
+static FILE *asyncfile;
+static qboolean asyncpending;
+static char asyncname[MAX_OSPATH];
+static volatile int asyncwritetime;
+
+#ifdef _WIN32
+static HANDLE asyncthread;
+#else
+static pthread_t asyncthread;
+#endif
+
+static int
+Save_Milliseconds(void)
+{
+#ifdef _WIN32
+    return (int)GetTickCount();
+#else
+    struct timeval tv;
+    
+    gettimeofday(&tv, NULL);
+    return (int)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+#endif
+}
+
+/*
+ * Runs on the worker thread.
+ */
+#ifdef _WIN32
+static DWORD WINAPI
+Save_Worker(LPVOID arg)
+#else
+static void *
+Save_Worker(void *arg)
+#endif
+{
+    int start;
+    
+    start = Save_Milliseconds();
+    
+    fwrite(asyncbuf.data, asyncbuf.size, 1, asyncfile);
+    fclose(asyncfile);
+    
+    asyncwritetime = Save_Milliseconds() - start;
+    
+    return 0;
+}
+
+/*
+ * Blocks until the last background
+ * write is on disk.
+ */
+void
+WaitForSave(void)
+{
+    int start;
+    
+    if (!asyncpending)
+    {
+        return;
+    }
+    
+    start = Save_Milliseconds();
+    
+#ifdef _WIN32
+    WaitForSingleObject(asyncthread, INFINITE);
+    CloseHandle(asyncthread);
+#else
+    pthread_join(asyncthread, NULL);
+#endif
+    
+    asyncpending = false;
+    asyncfile = NULL;
+    asyncbuf.size = 0;
+    
+    if (developer && developer->value)
+    {
+        gi.dprintf("%s: write %i ms in background, waited %i ms\n",
+                asyncname, asyncwritetime, Save_Milliseconds() - start);
+    }
+}
+
+/*
+ * Writes the save buffer into f and
+ * closes it, on the worker thread
+ * when sv_async_save is set and the
+ * thread can be started.
+ */
+static void
+SaveBuf_Finish(savebuf_t *buf, FILE *f, const char *filename, int snapshottime)
+{
+    savebuf_t swap;
+    int start;
+    
+    WaitForSave();
+    
+    if (sv_async_save && sv_async_save->value)
+    {
+        swap = asyncbuf;
+        asyncbuf = *buf;
+        *buf = swap;
+        buf->size = 0;
+        
+        asyncfile = f;
+        strncpy(asyncname, filename, sizeof(asyncname) - 1);
+        asyncname[sizeof(asyncname) - 1] = 0;
+        
+#ifdef _WIN32
+        asyncthread = CreateThread(NULL, 0, Save_Worker, NULL, 0, NULL);
+        asyncpending = (asyncthread != NULL);
+#else
+        asyncpending = (pthread_create(&asyncthread, NULL, Save_Worker, NULL) == 0);
+#endif
+        
+        if (asyncpending)
+        {
+            if (developer && developer->value)
+            {
+                gi.dprintf("%s: snapshot %i ms\n", filename, snapshottime);
+            }
+            
+            Tel_CountSave(snapshottime);
+            Rep_CountSave(snapshottime);
+            return;
+        }
+        
+        /* no thread, write it here */
+        swap = asyncbuf;
+        asyncbuf = *buf;
+        *buf = swap;
+        asyncfile = NULL;
+    }
+    
+    start = Save_Milliseconds();
+    SaveBuf_Flush(buf, f);
+    fclose(f);
+    
+    if (developer && developer->value)
+    {
+        gi.dprintf("%s: snapshot %i ms, write %i ms\n", filename,
+                snapshottime, Save_Milliseconds() - start);
+    }
+    
+    Tel_CountSave(snapshottime + Save_Milliseconds() - start);
+    Rep_CountSave(snapshottime + Save_Milliseconds() - start);
+}
+
+/*
+ * Collects the fields of one
+ * table that WriteField1 and
+ * WriteField2 act on, in table
+ * order.
+ */
+static void
+BuildSaveFields(savefields_t *list, field_t *table)
+{
+    field_t *field;
+    int count;
+    
+    for (count = 0, field = table; field->name; field++)
+    {
+        count++;
+    }
+    
+    list->fixup = gi.TagMalloc((count + 1) * sizeof(field_t *), TAG_GAME);
+    list->data = gi.TagMalloc((count + 1) * sizeof(field_t *), TAG_GAME);
+    list->numfixup = 0;
+    list->numdata = 0;
+    
+    for (field = table; field->name; field++)
+    {
+        if (field->flags & FFL_SPAWNTEMP)
+        {
+            continue;
+        }
+        
+        switch (field->type)
+        {
+            case F_INT:
+            case F_FLOAT:
+            case F_ANGLEHACK:
+            case F_VECTOR:
+            case F_IGNORE:
+                break;
+            default:
+                list->fixup[list->numfixup++] = field;
+                break;
+        }
+        
+        switch (field->type)
+        {
+            case F_LSTRING:
+            case F_FUNCTION:
+            case F_MMOVE:
+                list->data[list->numdata++] = field;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+/*
+ * Called by InitGame. Empties the
+ * save buffers and sets up the
+ * save field lists.
+ */
+void
+InitSaveFields(void)
+{
+    memset(&savebuf, 0, sizeof(savebuf));
+    memset(&packbuf, 0, sizeof(packbuf));
+    memset(&transbuf, 0, sizeof(transbuf));
+    memset(&transload, 0, sizeof(transload));
+    transpending = false;
+    transloadfile = false;
+    levelbase = NULL;
+    levelbasesum = NULL;
+    levelbasecount = 0;
+    memset(&asyncbuf, 0, sizeof(asyncbuf));
+    asyncpending = false;
+    
+    BuildSaveFields(&edictSaveFields, fields);
+    BuildSaveFields(&levelSaveFields, levelfields);
+    BuildSaveFields(&clientSaveFields, clientfields);
+    BuildSaveFields(&delaySaveFields, delayfields);
+}
+
+/* ========================================================= */
+
+/*
+ * The following two functions are
+ * doing the dirty work to write the
+ * data generated by the functions
+ * below this block into files.
+ */
+void
+WriteField1(FILE *f, field_t *field, byte *base)
+{
+    void *p;
+    int len;
+    int index;
+    functionList_t *func;
+    mmoveList_t *mmove;
+    
+    if (field->flags & FFL_SPAWNTEMP)
+    {
+        return;
+    }
+    
+    p = (void *)(base + field->ofs);
+    
+    switch (field->type)
+    {
+        case F_INT:
+        case F_FLOAT:
+        case F_ANGLEHACK:
+        case F_VECTOR:
+        case F_IGNORE:
+            break;
+            
+        case F_LSTRING:
+        case F_GSTRING:
+            
+            if (*(char **)p)
+            {
+                len = (int)strlen(*(char **)p) + 1;
+            }
+            else
+            {
+                len = 0;
+            }
+            
+            *(int *)p = len;
+            break;
+        case F_EDICT:
+            
+            if (*(edict_t **)p == NULL)
+            {
+                index = -1;
+            }
+            else
+            {
+                index = *(edict_t **)p - g_edicts;
+            }
+            
+            *(int *)p = index;
+            break;
+        case F_CLIENT:
+            
+            if (*(gclient_t **)p == NULL)
+            {
+                index = -1;
+            }
+            else
+            {
+                index = *(gclient_t **)p - game.clients;
+            }
+            
+            *(int *)p = index;
+            break;
+        case F_ITEM:
             
             if (*(edict_t **)p == NULL)
             {
@@ -683,7 +1372,7 @@ WriteField1(FILE *f, field_t *field, byte *base)
 }
 
 void
-WriteField2(FILE *f, field_t *field, byte *base)
+WriteField2(savebuf_t *buf, field_t *field, byte *base)
 {
     int len;
     void *p;
@@ -704,7 +1393,7 @@ WriteField2(FILE *f, field_t *field, byte *base)
             if (*(char **)p)
             {
                 len = (int)strlen(*(char **)p) + 1;
-                fwrite(*(char **)p, len, 1, f);
+                SaveBuf_Write(buf, *(char **)p, len);
             }
             
             break;
@@ -720,7 +1409,7 @@ WriteField2(FILE *f, field_t *field, byte *base)
                 }
                 
                 len = (int)strlen(func->funcStr)+1;
-                fwrite (func->funcStr, len, 1, f);
+                SaveBuf_Write(buf, func->funcStr, len);
             }
             
             break;
@@ -735,7 +1424,7 @@ WriteField2(FILE *f, field_t *field, byte *base)
                 }
                 
                 len = (int)strlen(mmove->mmoveStr)+1;
-                fwrite (mmove->mmoveStr, len, 1, f);
+                SaveBuf_Write(buf, mmove->mmoveStr, len);
             }
             
             break;
@@ -754,12 +1443,12 @@ WriteField2(FILE *f, field_t *field, byte *base)
  * below
  */
 void
-ReadField(FILE *f, field_t *field, byte *base)
+ReadField(loadbuf_t *buf, field_t *field, byte *base)
 {
     void *p;
     int len;
     int index;
-    char funcStr[2048];
+    char *name;
     
     if (field->flags & FFL_SPAWNTEMP)
     {
@@ -786,8 +1475,9 @@ ReadField(FILE *f, field_t *field, byte *base)
             }
             else
             {
-                *(char **)p = (char*)gi.TagMalloc(32 + len, TAG_LEVEL);
-                fread(*(char **)p, len, 1, f);
+                /* the slack lets func_clock write its time in place */
+                *(char **)p = (char*)G_LevelAlloc(32 + len);
+                memcpy(*(char **)p, LoadBuf_String(buf, len), len);
             }
             
             break;
@@ -839,17 +1529,11 @@ ReadField(FILE *f, field_t *field, byte *base)
             }
             else
             {
-                if (len > sizeof(funcStr))
-                {
-                    gi.error ("ReadField: function name is longer than buffer (%i chars)",
-                              sizeof(funcStr));
-                }
-                
-                fread (funcStr, len, 1, f);
+                name = LoadBuf_String(buf, len);
                 
-                if ( !(*(byte **)p = FindFunctionByName (funcStr)) )
+                if ( !(*(byte **)p = FindFunctionByName (name)) )
                 {
-                    gi.error ("ReadField: function %s not found in table, can't load game", funcStr);
+                    gi.error ("ReadField: function %s not found in table, can't load game", name);
                 }
                 
             }
@@ -863,17 +1547,11 @@ ReadField(FILE *f, field_t *field, byte *base)
             }
             else
             {
-                if (len > sizeof(funcStr))
-                {
-                    gi.error ("ReadField: mmove name is longer than buffer (%i chars)",
-                              sizeof(funcStr));
-                }
+                name = LoadBuf_String(buf, len);
                 
-                fread (funcStr, len, 1, f);
-                
-                if ( !(*(mmove_t **)p = FindMmoveByName (funcStr)) )
+                if ( !(*(mmove_t **)p = FindMmoveByName (name)) )
                 {
-                    gi.error ("ReadField: mmove %s not found in table, can't load game", funcStr);
+                    gi.error ("ReadField: mmove %s not found in table, can't load game", name);
                 }
             }
             break;
@@ -882,55 +1560,591 @@ ReadField(FILE *f, field_t *field, byte *base)
             gi.error("ReadEdict: unknown field type");
     }
 }
-
+
+/* ========================================================= */
+
+/*
+ * Appends a struct to the buffer
+ * with its pointers changed to
+ * lengths or indexes, followed by
+ * the data they pointed to.
+ */
+static void
+WriteStruct(savebuf_t *buf, savefields_t *list, void *src, int size)
+{
+    byte *temp;
+    int i;
+    
+    /* all of the ints, floats, and vectors stay as they are */
+    temp = SaveBuf_Alloc(buf, size);
+    memcpy(temp, src, size);
+    
+    /* change the pointers to lengths or indexes, temp
+       stays valid until the buffer grows again */
+    for (i = 0; i < list->numfixup; i++)
+    {
+        WriteField1(NULL, list->fixup[i], temp);
+    }
+    
+    /* now write any allocated data following the struct */
+    for (i = 0; i < list->numdata; i++)
+    {
+        WriteField2(buf, list->data[i], (byte *)src);
+    }
+}
+
+/* ========================================================= */
+
+/*
+ * With sv_delta_save set, WriteLevel
+ * stores each entity as the runs of
+ * words that differ from its image
+ * right after SpawnEntities. ReadLevel
+ * runs after the same map was spawned
+ * again, so it can rebuild the entity
+ * from the new spawn image.
+ *
+ * The images are taken after the
+ * pointers are changed to lengths and
+ * indexes, so they compare the same
+ * way in both spawns. The data after
+ * each entity is always written in full.
+ * An entity whose slot was empty at
+ * spawn is stored against zeroes.
+ *
+ * Each entity record carries a checksum
+ * of the spawn image. A map that spawns
+ * differently the second time, e.g.
+ * because of random values, is reported
+ * with developer set.
+ */
+    
+#define EDICT_WORDS ((int)(sizeof(edict_t) / sizeof(int)))
+    
+static uint32_t
+LevelBase_Checksum(edict_t *image)
+{
+    uint32_t hash = 2166136261u;
+    byte *p = (byte *)image;
+    int i;
+    
+    for (i = 0; i < sizeof(edict_t); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    
+    /* 0 marks an empty slot */
+    return hash ? hash : 1;
+}
+    
+/*
+ * Clears the bytes of an image that
+ * say nothing about the entity: the
+ * rest of each pointer that was turned
+ * into an int, and the world links.
+ */
+static void
+LevelBase_Clean(edict_t *image)
+{
+    byte *p;
+    int i, value;
+    
+    for (i = 0; i < edictSaveFields.numfixup; i++)
+    {
+        p = (byte *)image + edictSaveFields.fixup[i]->ofs;
+        value = *(int *)p;
+        memset(p, 0, sizeof(void *));
+        *(int *)p = value;
+    }
+    
+    memset(&image->area, 0, sizeof(image->area));
+}
+
+/*
+ * Like WriteField1, but a function or
+ * mmove missing from the lists must
+ * not stop the map from loading. Any
+ * value works as long as both spawns
+ * give the same one.
+ */
+static void
+LevelBase_Field(field_t *field, byte *base)
+{
+    functionList_t *func;
+    mmoveList_t *mmove;
+    void *p;
+    
+    p = (void *)(base + field->ofs);
+    
+    if ((field->type == F_FUNCTION) && *(byte **)p)
+    {
+        func = GetFunctionByAddress(*(byte **)p);
+        *(int *)p = func ? (int)strlen(func->funcStr) + 1 : -1;
+    }
+    else if ((field->type == F_MMOVE) && *(mmove_t **)p)
+    {
+        mmove = GetMmoveByAddress(*(mmove_t **)p);
+        *(int *)p = mmove ? (int)strlen(mmove->mmoveStr) + 1 : -1;
+    }
+    else
+    {
+        WriteField1(NULL, field, base);
+    }
+}
+
+/*
+ * Called by SpawnEntities once all
+ * entities of the map are spawned,
+ * before the transition entities are
+ * added.
+ */
+void
+SaveLevelBaseline(void)
+{
+    edict_t *ent;
+    int i, k;
+    
+    if (levelbase)
+    {
+        gi.TagFree(levelbase);
+        gi.TagFree(levelbasesum);
+    }
+    
+    levelbasecount = globals.num_edicts;
+    levelbase = gi.TagMalloc(levelbasecount * sizeof(edict_t), TAG_GAME);
+    levelbasesum = gi.TagMalloc(levelbasecount * sizeof(uint32_t), TAG_GAME);
+    
+    for (i = 0; i < levelbasecount; i++)
+    {
+        ent = &g_edicts[i];
+        
+        if (!ent->inuse)
+        {
+            memset(&levelbase[i], 0, sizeof(edict_t));
+            levelbasesum[i] = 0;
+            continue;
+        }
+        
+        memcpy(&levelbase[i], ent, sizeof(edict_t));
+        
+        for (k = 0; k < edictSaveFields.numfixup; k++)
+        {
+            LevelBase_Field(edictSaveFields.fixup[k], (byte *)&levelbase[i]);
+        }
+        
+        LevelBase_Clean(&levelbase[i]);
+        levelbasesum[i] = LevelBase_Checksum(&levelbase[i]);
+    }
+}
+    
+/*
+ * Level restart
+ *
+ * In deathmatch, SpawnEntities also
+ * keeps a raw copy of every edict and
+ * of level once the map is spawned.
+ * RestartLevel copies them back over
+ * the world in place, which puts the
+ * map as it was when it started
+ * without the engine reloading and
+ * precaching it. Every pointer in the
+ * copies is still good: they point at
+ * the same slots, at code, or at level
+ * memory that lasts until the map
+ * ends.
+ *
+ * The players stay. Whatever they
+ * point at outside the client slots is let
+ * go of, and the caller respawns them.
+ * Time keeps running, so what was
+ * going to think is moved forward by
+ * however long the map has been up.
+ */
+
+static edict_t *restartedicts;
+static int restartcount;
+static level_locals_t restartlevel;
+
+/*
+ * Called by SpawnEntities right after
+ * SaveLevelBaseline.
+ */
+void
+SaveLevelRestart(void)
+{
+    restartedicts = NULL;
+    restartcount = 0;
+    
+    if (!deathmatch->value)
+    {
+        return;
+    }
+    
+    restartcount = globals.num_edicts;
+    restartedicts = gi.TagMalloc(restartcount * sizeof(edict_t), TAG_LEVEL);
+    memcpy(restartedicts, g_edicts, restartcount * sizeof(edict_t));
+    restartlevel = level;
+    G_SaveSpawnLightStyles();
+}
+
+/*
+ * ReadLevel freed the copies with the
+ * rest of the level memory.
+ */
+static void
+ForgetLevelRestart(void)
+{
+    restartedicts = NULL;
+    restartcount = 0;
+}
+
+static void
+RestartLevel_Release(byte *base, savefields_t *list)
+{
+    edict_t **p;
+    int i;
+    
+    for (i = 0; i < list->numfixup; i++)
+    {
+        if (list->fixup[i]->type != F_EDICT)
+        {
+            continue;
+        }
+        
+        p = (edict_t **)(base + list->fixup[i]->ofs);
+        
+        if (*p && (*p - g_edicts > game.maxclients))
+        {
+            *p = NULL;
+        }
+    }
+}
+
+/*
+ * Returns false if there is nothing to
+ * restart to, outside deathmatch or
+ * after a level was loaded from a save.
+ */
+qboolean
+RestartLevel(void)
+{
+    edict_t *ent;
+    float shift;
+    int i, k;
+    
+    if (!restartedicts)
+    {
+        return false;
+    }
+    
+    WaitForSave();
+    shift = level.time - restartlevel.time;
+    
+    /* the players let go of the world */
+    for (i = 1; i <= game.maxclients; i++)
+    {
+        ent = &g_edicts[i];
+        
+        if (!ent->inuse || !ent->client)
+        {
+            continue;
+        }
+        
+        CTFPlayerResetGrapple(ent);
+        RestartLevel_Release((byte *)ent, &edictSaveFields);
+        RestartLevel_Release((byte *)ent->client, &clientSaveFields);
+        
+        for (k = 0; k < 6; k++)
+        {
+            ent->reflection[k] = NULL;
+        }
+    }
+    
+    /* take the world out, then put the spawned one back */
+    for (i = game.maxclients + 1; i < globals.num_edicts; i++)
+    {
+        if (g_edicts[i].inuse)
+        {
+            gi.unlinkentity(&g_edicts[i]);
+        }
+    }
+    
+    G_ClearEdictIndexes();
+    G_ClearLinkCache();
+    
+    for (i = game.maxclients + 1; i < globals.num_edicts; i++)
+    {
+        ent = &g_edicts[i];
+        
+        if ((i >= restartcount) || !restartedicts[i].inuse)
+        {
+            memset(ent, 0, sizeof(*ent));
+            ent->classname = "freed";
+            ent->freetime = level.time;
+            continue;
+        }
+        
+        memcpy(ent, &restartedicts[i], sizeof(*ent));
+        memset(&ent->area, 0, sizeof(ent->area));
+        
+        if (ent->nextthink > 0)
+        {
+            ent->nextthink += shift;
+        }
+    }
+    
+    for (i = 0; i < globals.num_edicts; i++)
+    {
+        ent = &g_edicts[i];
+        
+        if (!ent->inuse)
+        {
+            continue;
+        }
+        
+        G_IndexEdict(ent);
+        
+        /* only what was in the world then goes back in */
+        if ((i > game.maxclients) && restartedicts[i].area.prev)
+        {
+            gi.linkentity(ent);
+        }
+    }
+    
+    /* the counters start over, the clock doesn't */
+    restartlevel.framenum = level.framenum;
+    restartlevel.time = level.time;
+    restartlevel.freeze = level.freeze;
+    restartlevel.freezeframes = level.freezeframes;
+    level = restartlevel;
+    level.current_entity = NULL;
+    level.sight_client = NULL;
+    level.sight_entity = NULL;
+    level.sound_entity = NULL;
+    level.sound2_entity = NULL;
+    level.disguise_violator = NULL;
+    
+    /* what ReadLevel sets up again once the entities are in */
+    PlayerTrail_Init();
+    G_ResetDelayedUses();
+    G_ResetLevelCaches();
+    G_RestoreSpawnLightStyles();
+    
+    gi.dprintf("Level restarted in place.\n");
+    return true;
+}
+    
+/*
+ * Appends an entity record in the
+ * delta format: the checksum of its
+ * spawn image (0 for none), the runs
+ * of differing words as start and
+ * count pairs ended by a 0 count, and
+ * then its data.
+ */
+static void
+WriteEdictDelta(savebuf_t *buf, int entnum, edict_t *ent)
+{
+    static const edict_t zero;
+    const int *cur, *base;
+    unsigned short run[2];
+    uint32_t sum;
+    int i, start, end, gap;
+    
+    memcpy(&leveldelta, ent, sizeof(edict_t));
+    
+    for (i = 0; i < edictSaveFields.numfixup; i++)
+    {
+        WriteField1(NULL, edictSaveFields.fixup[i], (byte *)&leveldelta);
+    }
+    
+    LevelBase_Clean(&leveldelta);
+    
+    if ((entnum < levelbasecount) && levelbasesum[entnum])
+    {
+        sum = levelbasesum[entnum];
+        base = (const int *)&levelbase[entnum];
+    }
+    else
+    {
+        sum = 0;
+        base = (const int *)&zero;
+    }
+    
+    SaveBuf_Write(buf, &sum, sizeof(sum));
+    
+    cur = (const int *)&leveldelta;
+    
+    for (start = 0; start < EDICT_WORDS; start = end)
+    {
+        if (cur[start] == base[start])
+        {
+            end = start + 1;
+            continue;
+        }
+        
+        /* runs separated by less than 3 equal
+           words are cheaper as one run */
+        end = start + 1;
+        
+        while (1)
+        {
+            while ((end < EDICT_WORDS) && (cur[end] != base[end]))
+            {
+                end++;
+            }
+            
+            gap = end;
+            
+            while ((gap < EDICT_WORDS) && (gap < end + 3) && (cur[gap] == base[gap]))
+            {
+                gap++;
+            }
+            
+            if ((gap < EDICT_WORDS) && (gap < end + 3))
+            {
+                end = gap;
+            }
+            else
+            {
+                break;
+            }
+        }
+        
+        run[0] = start;
+        run[1] = end - start;
+        SaveBuf_Write(buf, run, sizeof(run));
+        SaveBuf_Write(buf, cur + start, (end - start) * sizeof(int));
+    }
+    
+    run[0] = run[1] = 0;
+    SaveBuf_Write(buf, run, sizeof(run));
+    
+    /* now write any allocated data following the edict */
+    for (i = 0; i < edictSaveFields.numdata; i++)
+    {
+        WriteField2(buf, edictSaveFields.data[i], (byte *)ent);
+    }
+}
+    
+/*
+ * Packs a finished level file with
+ * LZSS. Returns false and leaves buf
+ * alone if that does not make it
+ * smaller.
+ */
+static qboolean
+SaveBuf_Compress(savebuf_t *buf, savebuf_t *packed)
+{
+    int header[2];
+    int maxsize, size;
+    
+    packed->size = 0;
+    maxsize = buf->size + buf->size / 8 + 64;
+    
+    header[0] = LEVELFILE_LZSS;
+    header[1] = buf->size;
+    SaveBuf_Write(packed, header, sizeof(header));
+    
+    SaveBuf_Alloc(packed, maxsize);
+    size = EncodeBuffer(buf->data, buf->size, packed->data + sizeof(header), maxsize);
+    
+    if ((size < 0) || (size + (int)sizeof(header) >= buf->size))
+    {
+        packed->size = 0;
+        return false;
+    }
+    
+    packed->size = size + sizeof(header);
+    return true;
+}
+    
 /* ========================================================= */
+    
+/*
+ * Write the client struct into the
+ * save buffer.
+ */
+void
+WriteClient(savebuf_t *buf, gclient_t *client)
+{
+    WriteStruct(buf, &clientSaveFields, client, sizeof(*client));
+}
 
 /*
- * Write the client struct into a file.
+ * Read the client struct from a file
  */
 void
-WriteClient(FILE *f, gclient_t *client)
+ReadClient(loadbuf_t *buf, gclient_t *client)
 {
     field_t *field;
-    gclient_t temp;
-    
-    /* all of the ints, floats, and vectors stay as they are */
-    temp = *client;
-    
-    /* change the pointers to indexes */
-    for (field = clientfields; field->name; field++)
-    {
-        WriteField1(f, field, (byte *)&temp);
-    }
     
-    /* write the block */
-    fwrite(&temp, sizeof(temp), 1, f);
+    LoadBuf_Read(buf, client, sizeof(*client));
     
-    /* now write any allocated data following the edict */
     for (field = clientfields; field->name; field++)
     {
-        WriteField2(f, field, (byte *)client);
+        ReadField(buf, field, (byte *)client);
     }
 }
 
+/* ========================================================= */
+
 /*
- * Read the client struct from a file
+ * The entities a trigger_transition
+ * carries into the next map are kept
+ * in transbuf, in the same format as
+ * save/trans.ent, and handed to
+ * LoadTransitionEnts from memory.
+ * The file is only written when the
+ * game is saved while they are still
+ * on their way, so a savegame loaded
+ * later can find them as before.
  */
 void
-ReadClient(FILE *f, gclient_t *client)
+BeginTransitionEdicts(void)
 {
-    field_t *field;
+    transbuf.size = 0;
+    transpending = true;
+}
+
+/*
+ * Appends an edict to the transition
+ * set. Called by WriteTransitionEdict.
+ */
+void
+WriteTransitionImage(edict_t *ent)
+{
+    WriteStruct(&transbuf, &edictSaveFields, ent, sizeof(*ent));
+}
+
+/*
+ * Writes the pending transition set
+ * into save/trans.ent. Called by
+ * WriteGame.
+ */
+static void
+WriteTransitionFile(void)
+{
+    char filename[_MAX_PATH];
+    FILE *f;
     
-    fread(client, sizeof(*client), 1, f);
+    trans_ent_filename(filename);
+    f = fopen(filename, "wb");
     
-    for (field = clientfields; field->name; field++)
+    if (!f)
+    {
+        gi.dprintf("Error opening %s for writing\n", filename);
+        return;
+    }
+    
+    if (transbuf.size)
     {
-        ReadField(f, field, (byte *)client);
+        fwrite(transbuf.data, transbuf.size, 1, f);
     }
+    
+    fclose(f);
 }
 
-/* ========================================================= */
-
 /*
  * Writes the game struct into
  * a file. This is called when
@@ -951,6 +2165,10 @@ WriteGame(const char *filename, qboolean autosave)
     char str_os[32];
     char str_arch[32];
     
+    /* the level file of this save must be
+       complete before the engine copies it */
+    WaitForSave();
+    
     if (!autosave)
     {
         SaveClientData();
@@ -974,21 +2192,27 @@ WriteGame(const char *filename, qboolean autosave)
     Q_strlcpy(str_os, OS, sizeof(str_os));
     Q_strlcpy(str_arch, ARCH, sizeof(str_arch));
     
-    fwrite(str_ver, sizeof(str_ver), 1, f);
-    fwrite(str_game, sizeof(str_game), 1, f);
-    fwrite(str_os, sizeof(str_os), 1, f);
-    fwrite(str_arch, sizeof(str_arch), 1, f);
+    SaveBuf_Write(&savebuf, str_ver, sizeof(str_ver));
+    SaveBuf_Write(&savebuf, str_game, sizeof(str_game));
+    SaveBuf_Write(&savebuf, str_os, sizeof(str_os));
+    SaveBuf_Write(&savebuf, str_arch, sizeof(str_arch));
     
     game.autosaved = autosave;
-    fwrite(&game, sizeof(game), 1, f);
+    SaveBuf_Write(&savebuf, &game, sizeof(game));
     game.autosaved = false;
     
     for (i = 0; i < game.maxclients; i++)
     {
-        WriteClient(f, &game.clients[i]);
+        WriteClient(&savebuf, &game.clients[i]);
     }
     
+    SaveBuf_Flush(&savebuf, f);
     fclose(f);
+    
+    if (transpending)
+    {
+        WriteTransitionFile();
+    }
 }
 
 /*
@@ -999,49 +2223,55 @@ WriteGame(const char *filename, qboolean autosave)
 void
 ReadGame(const char *filename)
 {
-    FILE *f;
+    loadbuf_t buf;
     int i;
     char str_ver[32];
     char str_game[32];
     char str_os[32];
     char str_arch[32];
     
-    f = fopen(filename, "rb");
+    WaitForSave();
     
-    if (!f)
-    {
-        gi.error("Couldn't open %s", filename);
-    }
+    /* a set still in memory belongs to
+       the game being left */
+    transpending = false;
+    
+    /* one read, then everything is parsed from memory */
+    LoadBuf_LoadFile(&buf, filename, TAG_GAME);
     
     /* Sanity checks */
-    fread(str_ver, sizeof(str_ver), 1, f);
-    fread(str_game, sizeof(str_game), 1, f);
-    fread(str_os, sizeof(str_os), 1, f);
-    fread(str_arch, sizeof(str_arch), 1, f);
+    LoadBuf_Read(&buf, str_ver, sizeof(str_ver));
+    LoadBuf_Read(&buf, str_game, sizeof(str_game));
+    LoadBuf_Read(&buf, str_os, sizeof(str_os));
+    LoadBuf_Read(&buf, str_arch, sizeof(str_arch));
+    str_ver[sizeof(str_ver) - 1] = 0;
+    str_game[sizeof(str_game) - 1] = 0;
+    str_os[sizeof(str_os) - 1] = 0;
+    str_arch[sizeof(str_arch) - 1] = 0;
     
     if (strcmp(str_ver, SAVEGAMEVER))
     {
-        fclose(f);
+        gi.TagFree(buf.data);
         gi.error("Savegame from an incompatible version.\n");
     }
     else if (strcmp(str_game, GAMEVERSION))
     {
-        fclose(f);
+        gi.TagFree(buf.data);
         gi.error("Savegame from an other game.so.\n");
     }
     else if (strcmp(str_os, OS))
     {
-        fclose(f);
+        gi.TagFree(buf.data);
         gi.error("Savegame from an other os.\n");
     }
     
     else if (strcmp(str_arch, ARCH))
     {
-        fclose(f);
+        gi.TagFree(buf.data);
         gi.error("Savegame from an other architecure.\n");
     }
     
-    fread(&game, sizeof(game), 1, f);
+    LoadBuf_Read(&buf, &game, sizeof(game));
     
 #ifdef Q2VR_ENGINE_MOD
     g_edicts = gi.TagRealloc(g_edicts, game.maxentities * sizeof(g_edicts[0]));
@@ -1061,71 +2291,63 @@ ReadGame(const char *filename)
     
     for (i = 0; i < game.maxclients; i++)
     {
-        ReadClient(f, &game.clients[i]);
+        ReadClient(&buf, &game.clients[i]);
     }
     
-    fclose(f);
+    gi.TagFree(buf.data);
 }
 
 /* ========================================================== */
 
 /*
  * Helper function to write the
- * edict into a file. Called by
- * WriteLevel.
+ * level local data into the save
+ * buffer. Called by WriteLevel.
  */
 void
-WriteEdict(FILE *f, edict_t *ent)
+WriteLevelLocals(savebuf_t *buf)
 {
-    field_t *field;
-    edict_t temp;
-    
-    /* all of the ints, floats, and vectors stay as they are */
-    temp = *ent;
-    
-    /* change the pointers to lengths or indexes */
-    for (field = fields; field->name; field++)
-    {
-        WriteField1(f, field, (byte *)&temp);
-    }
-    
-    /* write the block */
-    fwrite(&temp, sizeof(temp), 1, f);
-    
-    /* now write any allocated data following the edict */
-    for (field = fields; field->name; field++)
-    {
-        WriteField2(f, field, (byte *)ent);
-    }
+    WriteStruct(buf, &levelSaveFields, &level, sizeof(level));
 }
 
 /*
- * Helper function to write the
- * level local data into a file.
+ * Writes the spots of each
+ * client's trail, oldest first.
  * Called by WriteLevel.
  */
-void
-WriteLevelLocals(FILE *f)
+static void
+WritePlayerTrails(savebuf_t *buf)
 {
-    field_t *field;
-    level_locals_t temp;
+    trailspot_t spots[TRAIL_LENGTH];
+    int i, count;
     
-    /* all of the ints, floats, and vectors stay as they are */
-    temp = level;
+    SaveBuf_Write(buf, &game.maxclients, sizeof(game.maxclients));
     
-    /* change the pointers to lengths or indexes */
-    for (field = levelfields; field->name; field++)
+    for (i = 0; i < game.maxclients; i++)
     {
-        WriteField1(f, field, (byte *)&temp);
+        count = PlayerTrail_Save(i, spots);
+        SaveBuf_Write(buf, &count, sizeof(count));
+        SaveBuf_Write(buf, spots, count * sizeof(trailspot_t));
     }
+}
+
+/*
+ * Writes the uses still waiting
+ * on their delay. Called by
+ * WriteLevel.
+ */
+static void
+WriteDelayedUses(savebuf_t *buf)
+{
+    delayeduse_t *list;
+    int i, count;
     
-    /* write the block */
-    fwrite(&temp, sizeof(temp), 1, f);
+    count = G_DelayedUses(&list);
+    SaveBuf_Write(buf, &count, sizeof(count));
     
-    /* now write any allocated data following the edict */
-    for (field = levelfields; field->name; field++)
+    for (i = 0; i < count; i++)
     {
-        WriteField2(f, field, (byte *)&level);
+        WriteStruct(buf, &delaySaveFields, &list[i], sizeof(list[i]));
     }
 }
 
@@ -1137,9 +2359,15 @@ void
 WriteLevel(const char *filename)
 {
     int i;
+    int start;
+    qboolean delta;
     edict_t *ent;
     FILE *f;
     
+    WaitForSave();
+    
+    start = Save_Milliseconds();
+    
     f = fopen(filename, "wb");
     
     if (!f)
@@ -1147,12 +2375,20 @@ WriteLevel(const char *filename)
         gi.error("Couldn't open %s", filename);
     }
     
+    delta = (sv_delta_save && sv_delta_save->value);
+    
+    if (delta)
+    {
+        i = LEVELFILE_DELTA;
+        SaveBuf_Write(&savebuf, &i, sizeof(i));
+    }
+    
     /* write out edict size for checking */
     i = sizeof(edict_t);
-    fwrite(&i, sizeof(i), 1, f);
+    SaveBuf_Write(&savebuf, &i, sizeof(i));
     
     /* write out level_locals_t */
-    WriteLevelLocals(f);
+    WriteLevelLocals(&savebuf);
     
     /* write out all the entities */
     for (i = 0; i < globals.num_edicts; i++)
@@ -1164,35 +2400,169 @@ WriteLevel(const char *filename)
             continue;
         }
         
-        fwrite(&i, sizeof(i), 1, f);
-        WriteEdict(f, ent);
+        SaveBuf_Write(&savebuf, &i, sizeof(i));
+        
+        if (delta)
+        {
+            WriteEdictDelta(&savebuf, i, ent);
+        }
+        else
+        {
+            WriteStruct(&savebuf, &edictSaveFields, ent, sizeof(*ent));
+        }
     }
     
     i = -1;
-    fwrite(&i, sizeof(i), 1, f);
+    SaveBuf_Write(&savebuf, &i, sizeof(i));
     
-    fclose(f);
+    WritePlayerTrails(&savebuf);
+    WriteDelayedUses(&savebuf);
+    
+    if (sv_compress_save && sv_compress_save->value && SaveBuf_Compress(&savebuf, &packbuf))
+    {
+        savebuf.size = 0;
+        SaveBuf_Finish(&packbuf, f, filename, Save_Milliseconds() - start);
+    }
+    else
+    {
+        SaveBuf_Finish(&savebuf, f, filename, Save_Milliseconds() - start);
+    }
 }
 
 /* ========================================================== */
 
 /*
- * A helper function to
- * read the edict back
- * into the memory. Called
- * by ReadLevel.
+ * Reads the data following an edict
+ * whose struct is already in place.
  */
-void
-ReadEdict(FILE *f, edict_t *ent)
+static void
+ReadEdictFields(loadbuf_t *buf, edict_t *ent)
 {
     field_t *field;
     
-    fread(ent, sizeof(*ent), 1, f);
-    
     for (field = fields; field->name; field++)
     {
-        ReadField(f, field, (byte *)ent);
+        ReadField(buf, field, (byte *)ent);
+    }
+}
+    
+/*
+ * Gets the transition set ready for
+ * LoadTransitionEnts: the one built
+ * by the changelevel if there is one,
+ * save/trans.ent otherwise. Returns
+ * false when there is neither.
+ */
+qboolean
+OpenTransitionEdicts(void)
+{
+    char filename[_MAX_PATH];
+    FILE *f;
+    
+    memset(&transload, 0, sizeof(transload));
+    
+    if (transpending)
+    {
+        transload.data = transbuf.data;
+        transload.size = transbuf.size;
+        return true;
+    }
+    
+    trans_ent_filename(filename);
+    f = fopen(filename, "rb");
+    
+    if (!f)
+    {
+        return false;
+    }
+    
+    fclose(f);
+    LoadBuf_LoadFile(&transload, filename, TAG_GAME);
+    transloadfile = true;
+    return true;
+}
+
+/*
+ * Reads the next edict of the
+ * transition set. Its strings go
+ * into the level arena.
+ */
+void
+ReadTransitionEdict(edict_t *ent)
+{
+    LoadBuf_Read(&transload, ent, sizeof(*ent));
+    ReadEdictFields(&transload, ent);
+}
+
+/*
+ * Done with the transition set,
+ * which is then gone for good.
+ */
+void
+CloseTransitionEdicts(void)
+{
+    if (transloadfile)
+    {
+        gi.TagFree(transload.data);
+        transloadfile = false;
+    }
+    
+    memset(&transload, 0, sizeof(transload));
+    transbuf.size = 0;
+    transpending = false;
+}
+    
+/*
+ * Reads an entity record in the delta
+ * format back on top of the image of
+ * the same slot from SpawnEntities.
+ */
+static void
+ReadEdictDelta(loadbuf_t *buf, int entnum, edict_t *ent)
+{
+    unsigned short run[2];
+    uint32_t sum;
+    
+    LoadBuf_Read(buf, &sum, sizeof(sum));
+    
+    if (!sum)
+    {
+        memset(ent, 0, sizeof(*ent));
+    }
+    else
+    {
+        if ((entnum >= levelbasecount) || !levelbasesum[entnum])
+        {
+            gi.error("ReadLevel: entity %i was not spawned by this map", entnum);
+        }
+        
+        /* the delta only means something against the base it was taken from */
+        if (sum != levelbasesum[entnum])
+        {
+            gi.error("ReadLevel: entity %i spawned differently than when the level was saved; the map or its entity file has changed", entnum);
+        }
+        
+        memcpy(ent, &levelbase[entnum], sizeof(*ent));
+    }
+    
+    while (1)
+    {
+        LoadBuf_Read(buf, run, sizeof(run));
+        
+        if (!run[1])
+        {
+            break;
+        }
+        
+        if (run[0] + run[1] > EDICT_WORDS)
+        {
+            gi.error("ReadLevel: bad delta for entity %i", entnum);
+        }
+        
+        LoadBuf_Read(buf, (int *)ent + run[0], run[1] * sizeof(int));
     }
+    
+    ReadEdictFields(buf, ent);
 }
 
 /*
@@ -1202,18 +2572,130 @@ ReadEdict(FILE *f, edict_t *ent)
  * Called by ReadLevel.
  */
 void
-ReadLevelLocals(FILE *f)
+ReadLevelLocals(loadbuf_t *buf)
 {
     field_t *field;
     
-    fread(&level, sizeof(level), 1, f);
+    LoadBuf_Read(buf, &level, sizeof(level));
     
     for (field = levelfields; field->name; field++)
     {
-        ReadField(f, field, (byte *)&level);
+        ReadField(buf, field, (byte *)&level);
+    }
+}
+
+/*
+ * Reads back what WritePlayerTrails
+ * wrote. Level files from before the
+ * trails were saved just end here.
+ */
+static void
+ReadPlayerTrails(loadbuf_t *buf)
+{
+    trailspot_t spots[TRAIL_LENGTH];
+    int i, count, numclients;
+    
+    if (buf->pos >= buf->size)
+    {
+        return;
+    }
+    
+    LoadBuf_Read(buf, &numclients, sizeof(numclients));
+    
+    for (i = 0; i < numclients; i++)
+    {
+        LoadBuf_Read(buf, &count, sizeof(count));
+        
+        if ((count < 0) || (count > TRAIL_LENGTH))
+        {
+            gi.error("ReadLevel: bad player trail");
+        }
+        
+        LoadBuf_Read(buf, spots, count * sizeof(trailspot_t));
+        PlayerTrail_Restore(i, spots, count);
+    }
+}
+
+/*
+ * Reads back what WriteDelayedUses
+ * wrote, queued again in the same
+ * order. Older level files end
+ * before it.
+ */
+static void
+ReadDelayedUses(loadbuf_t *buf)
+{
+    delayeduse_t d;
+    field_t *field;
+    int i, count;
+    
+    if (buf->pos >= buf->size)
+    {
+        return;
+    }
+    
+    LoadBuf_Read(buf, &count, sizeof(count));
+    
+    if (count < 0)
+    {
+        gi.error("ReadLevel: bad delayed use count");
+    }
+    
+    for (i = 0; i < count; i++)
+    {
+        LoadBuf_Read(buf, &d, sizeof(d));
+        
+        for (field = delayfields; field->name; field++)
+        {
+            ReadField(buf, field, (byte *)&d);
+        }
+        
+        G_RestoreDelayedUse(&d);
     }
 }
 
+/*
+ * Loads a whole level file into
+ * TAG_LEVEL memory, unpacking it if
+ * it was compressed.
+ */
+static void
+LoadBuf_LoadLevel(loadbuf_t *buf, const char *filename)
+{
+    byte *packed;
+    int header[2];
+    
+    LoadBuf_LoadFile(buf, filename, TAG_LEVEL);
+    
+    if (buf->size < (int)sizeof(header))
+    {
+        return;
+    }
+    
+    memcpy(header, buf->data, sizeof(header));
+    
+    if (header[0] != LEVELFILE_LZSS)
+    {
+        return;
+    }
+    
+    if (header[1] <= 0)
+    {
+        gi.error("ReadLevel: %s is damaged", filename);
+    }
+    
+    packed = buf->data;
+    buf->data = gi.TagMalloc(header[1], TAG_LEVEL);
+    
+    if (DecodeBuffer(packed + sizeof(header), buf->size - sizeof(header), buf->data, header[1]) != header[1])
+    {
+        gi.error("ReadLevel: %s is damaged", filename);
+    }
+    
+    gi.TagFree(packed);
+    buf->size = header[1];
+}
+    
 /*
  * Reads a level back into the memory.
  * SpawnEntities were already called
@@ -1227,65 +2709,99 @@ void
 ReadLevel(const char *filename)
 {
     int entnum;
-    FILE *f;
+    loadbuf_t buf;
+    qboolean delta;
     int i;
     edict_t *ent;
+    double start;
     
-    f = fopen(filename, "rb");
-    
-    if (!f)
-    {
-        gi.error("Couldn't open %s", filename);
-    }
+    start = Prof_Seconds();
+    WaitForSave();
     
     /* free any dynamic memory allocated by
      loading the level  base state */
     gi.FreeTags(TAG_LEVEL);
+    ED_ResetStrings();
+    G_ResetLevelArena();
+    PlayerTrail_Init();
+    G_ResetDelayedUses();
+    G_ClearIndexCache();
+    ED_ResetSpawnPrototypes();
+    ForgetLevelRestart();
+    
+    LoadBuf_LoadLevel(&buf, filename);
     
     /* wipe all the entities */
     memset(g_edicts, 0, game.maxentities * sizeof(g_edicts[0]));
+    G_ClearEdictIndexes();
+    G_ClearLinkCache();
     globals.num_edicts = maxclients->value + 1;
     
     /* check edict size */
-    fread(&i, sizeof(i), 1, f);
+    LoadBuf_Read(&buf, &i, sizeof(i));
+    delta = (i == LEVELFILE_DELTA);
+    
+    if (delta)
+    {
+        LoadBuf_Read(&buf, &i, sizeof(i));
+    }
     
     if (i != sizeof(edict_t))
     {
-        fclose(f);
         gi.error("ReadLevel: mismatched edict size");
     }
     
     /* load the level locals */
-    ReadLevelLocals(f);
+    ReadLevelLocals(&buf);
     
     /* load all the entities */
     while (1)
     {
-        if (fread(&entnum, sizeof(entnum), 1, f) != 1)
-        {
-            fclose(f);
-            gi.error("ReadLevel: failed to read entnum");
-        }
+        LoadBuf_Read(&buf, &entnum, sizeof(entnum));
         
         if (entnum == -1)
         {
             break;
         }
         
+        if ((entnum < 0) || (entnum >= game.maxentities))
+        {
+            gi.error("ReadLevel: bad entnum %i", entnum);
+        }
+        
         if (entnum >= globals.num_edicts)
         {
             globals.num_edicts = entnum + 1;
         }
         
         ent = &g_edicts[entnum];
-        ReadEdict(f, ent);
+        
+        if (delta)
+        {
+            ReadEdictDelta(&buf, entnum, ent);
+        }
+        else
+        {
+            LoadBuf_Read(&buf, ent, sizeof(*ent));
+            ReadEdictFields(&buf, ent);
+        }
+        
+        G_IndexEdict(ent);
         
         /* let the server rebuild world links for this ent */
         memset(&ent->area, 0, sizeof(ent->area));
         gi.linkentity(ent);
     }
     
-    fclose(f);
+    ReadPlayerTrails(&buf);
+    ReadDelayedUses(&buf);
+    
+    gi.TagFree(buf.data);
+    
+    /* queue up the gaps left between loaded entities */
+    G_ResetLevelCaches();
+    G_ResetLightStyles();
+    RestoreHintPaths();
     
     /* mark all clients as unconnected */
     for (i = 0; i < maxclients->value; i++)
@@ -1314,4 +2830,6 @@ ReadLevel(const char *filename)
             }
         }
     }
+    
+    Rep_BeginLevel((float)((Prof_Seconds() - start) * 1000.0), true);
 }
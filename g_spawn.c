@@ -20,7 +20,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "g_local.h"
-#include "pak.h"
 
 void SP_item_health (edict_t *self);
 void SP_item_health_small (edict_t *self);
@@ -449,6 +448,140 @@ qboolean alias_from_pak;
 #endif
 
 
+/*
+===============
+Spawn function lookup
+
+Every entity in the map string goes through ED_CallSpawn, and
+target_spawner and friends call it at runtime too. Rather than strcmp
+against all of itemlist and spawns[] each time, both are hashed into
+one table when the game starts. Items are linked ahead of spawn
+functions and each list in its own order, so the first match is the
+same one the old linear search found.
+===============
+*/
+#define	SPAWN_HASH_SIZE		512		// must be a power of 2
+
+typedef struct
+{
+	char		*name;
+	gitem_t		*item;
+	spawn_t		*spawn;
+	int			next;
+} spawnhash_t;
+
+static spawnhash_t	*spawn_hash;
+static int			spawn_head[SPAWN_HASH_SIZE];
+
+// classnames without a spawn function that were already reported this map
+#define	MAX_UNKNOWN_CLASSNAMES	32
+static char		unknown_classnames[MAX_UNKNOWN_CLASSNAMES][64];
+static int		num_unknown_classnames;
+
+static int ED_ClassnameHash (const char *s)
+{
+	return ED_StringHash (s) & (SPAWN_HASH_SIZE - 1);
+}
+
+static void ED_LinkSpawn (int index, char *name, gitem_t *item, spawn_t *spawn)
+{
+	int		h;
+
+	h = ED_ClassnameHash (name);
+	spawn_hash[index].name = name;
+	spawn_hash[index].item = item;
+	spawn_hash[index].spawn = spawn;
+	spawn_hash[index].next = spawn_head[h];
+	spawn_head[h] = index;
+}
+
+/*
+===============
+ED_InitSpawnTable
+
+Called from InitGame, after InitItems
+===============
+*/
+void ED_InitSpawnTable (void)
+{
+	spawn_t	*s;
+	int		i, num_spawns, count;
+
+	for (num_spawns = 0 ; spawns[num_spawns].name ; num_spawns++)
+		;
+
+	spawn_hash = (spawnhash_t *)gi.TagMalloc ((game.num_items + num_spawns) * sizeof(spawnhash_t), TAG_GAME);
+	for (i = 0 ; i < SPAWN_HASH_SIZE ; i++)
+		spawn_head[i] = -1;
+
+	// link in reverse so each chain ends up in table order
+	count = 0;
+	for (i = num_spawns-1, s = spawns + i ; i >= 0 ; i--, s--)
+		ED_LinkSpawn (count++, s->name, NULL, s);
+	for (i = game.num_items-1 ; i >= 0 ; i--)
+	{
+		if (itemlist[i].classname)
+			ED_LinkSpawn (count++, itemlist[i].classname, &itemlist[i], NULL);
+	}
+	num_unknown_classnames = 0;
+}
+
+/*
+===============
+ED_FindSpawn
+
+Returns true if classname has an item or spawn function, and fills in
+whichever of item/spawn applies (the other is set to NULL).
+===============
+*/
+qboolean ED_FindSpawn (char *classname, gitem_t **item, spawn_t **spawn)
+{
+	int		i;
+
+	for (i = spawn_head[ED_ClassnameHash(classname)] ; i >= 0 ; i = spawn_hash[i].next)
+	{
+		if (spawn_hash[i].name == classname || !strcmp(spawn_hash[i].name, classname))
+		{
+			if (item)
+				*item = spawn_hash[i].item;
+			if (spawn)
+				*spawn = spawn_hash[i].spawn;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+===============
+ED_ResetUnknownClassnames
+
+Called from SpawnEntities so each map reports its own missing classnames
+===============
+*/
+void ED_ResetUnknownClassnames (void)
+{
+	num_unknown_classnames = 0;
+}
+
+static qboolean ED_UnknownClassnameSeen (char *classname)
+{
+	int		i;
+
+	for (i = 0 ; i < num_unknown_classnames ; i++)
+	{
+		if (!strcmp(unknown_classnames[i], classname))
+			return true;
+	}
+	if (num_unknown_classnames < MAX_UNKNOWN_CLASSNAMES)
+	{
+		strncpy (unknown_classnames[num_unknown_classnames], classname, sizeof(unknown_classnames[0])-1);
+		unknown_classnames[num_unknown_classnames][sizeof(unknown_classnames[0])-1] = 0;
+		num_unknown_classnames++;
+	}
+	return false;
+}
+
 /*
 ===============
 ED_CallSpawn
@@ -460,7 +593,6 @@ void ED_CallSpawn (edict_t *ent)
 {
 	spawn_t	*s;
 	gitem_t	*item;
-	int		i;
 
 	// Lazarus: if this fails, edict is freed.
 
@@ -475,29 +607,384 @@ void ED_CallSpawn (edict_t *ent)
 	//          before G_SetMoveDir wipes 'em out
 	VectorCopy(ent->s.angles, ent->org_angles);
 
-	// check item spawn functions
-	for (i=0,item=itemlist ; i<game.num_items ; i++,item++)
+	if (ED_FindSpawn (ent->classname, &item, &s))
 	{
-		if (!item->classname)
-			continue;
-		if (!strcmp(item->classname, ent->classname))
-		{	// found it
+		// check item spawn functions
+		if (item)
 			SpawnItem (ent, item);
-			return;
-		}
+		// check normal spawn functions
+		else
+			s->spawn (ent);
+		return;
 	}
 
-	// check normal spawn functions
-	for (s=spawns ; s->name ; s++)
+	if (!ED_UnknownClassnameSeen (ent->classname))
+		gi.dprintf ("%s doesn't have a spawn function\n", ent->classname);
+	G_FreeEdict(ent);
+}
+
+/*
+==============================================================================
+
+SPAWN PROTOTYPES
+
+A target_spawner fires the same classname from the same spot over and
+over, and each time ED_CallSpawn ran the whole spawn function again,
+with every gi.modelindex and gi.soundindex lookup in it. With
+ED_SpawnPrototype the spawn function runs the first time only, and the
+edict it built is kept for the level. Later spawns with the same
+classname, spawnflags, flags, origin and angles copy that image into
+the new edict and fix it up:
+
+- edict pointers back at the first edict point at the new one
+- think and debounce times move up by how long ago the image was taken
+- a monster picks its own starting frame, as monster_start does
+- level.total_monsters, total_goals and total_secrets go up by what
+  the first spawn added
+
+Only monsters and items are kept, and only when the spawn function
+spawned and freed nothing else and left no pointers at other edicts.
+Anything else goes through ED_CallSpawn every time, as before.
+
+==============================================================================
+*/
+#define	MAX_SPAWN_PROTOS	32
+
+typedef struct
+{
+	char		*classname;
+	int			spawnflags;
+	int			flags;
+	vec3_t		origin;
+	vec3_t		angles;
+	edict_t		*image;			// NULL if this key can't be copied
+	edict_t		*self;			// the edict the image was taken from
+	float		time;			// level.time the image was taken
+	qboolean	linked;
+	int			monsters, goals, secrets;
+} spawnproto_t;
+
+static spawnproto_t	spawn_protos[MAX_SPAWN_PROTOS];
+static int			num_spawn_protos;
+
+// the times a spawn function sets from level.time
+static int	spawn_proto_times[] = {
+	FOFS(nextthink),
+	FOFS(air_finished),
+	FOFS(touch_debounce_time),
+	FOFS(pain_debounce_time),
+	FOFS(damage_debounce_time),
+	FOFS(fly_sound_debounce_time),
+	FOFS(teleport_time)
+};
+
+/*
+===============
+ED_ResetSpawnPrototypes
+
+The images are level memory; called when a level is spawned or loaded
+===============
+*/
+void ED_ResetSpawnPrototypes (void)
+{
+	num_spawn_protos = 0;
+}
+
+static spawnproto_t *ED_FindPrototype (edict_t *ent)
+{
+	spawnproto_t	*p;
+	int				i;
+
+	for (i = 0, p = spawn_protos ; i < num_spawn_protos ; i++, p++)
 	{
-		if (!strcmp(s->name, ent->classname))
-		{	// found it
-			s->spawn (ent);
-			return;
-		}
+		if (p->spawnflags != ent->spawnflags || p->flags != ent->flags)
+			continue;
+		if (!VectorCompare (p->origin, ent->s.origin) || !VectorCompare (p->angles, ent->s.angles))
+			continue;
+		if (p->classname == ent->classname || !strcmp(p->classname, ent->classname))
+			return p;
 	}
-	gi.dprintf ("%s doesn't have a spawn function\n", ent->classname);
-	G_FreeEdict(ent);
+	return NULL;
+}
+
+static qboolean ED_PrototypeSafe (edict_t *ent)
+{
+	field_t	*f;
+	edict_t	*other;
+
+	if (!(ent->svflags & SVF_MONSTER) && !ent->item)
+		return false;
+
+	for (f = fields ; f->name ; f++)
+	{
+		if (f->type != F_EDICT || (f->flags & FFL_SPAWNTEMP))
+			continue;
+		other = *(edict_t **)((byte *)ent + f->ofs);
+		if (other && other != ent && other != world)
+			return false;
+	}
+	return true;
+}
+
+static void ED_CopyPrototype (spawnproto_t *p, edict_t *ent)
+{
+	field_t	*f;
+	edict_t	**other;
+	mmove_t	*move;
+	float	freetime, shift, *t;
+	int		i;
+
+	freetime = ent->freetime;
+	memcpy (ent, p->image, sizeof(edict_t));
+	memset (&ent->area, 0, sizeof(ent->area));
+	ent->s.number = ent - g_edicts;
+	ent->freetime = freetime;
+
+	for (f = fields ; f->name ; f++)
+	{
+		if (f->type != F_EDICT || (f->flags & FFL_SPAWNTEMP))
+			continue;
+		other = (edict_t **)((byte *)ent + f->ofs);
+		if (*other == p->self)
+			*other = ent;
+	}
+
+	shift = level.time - p->time;
+	for (i = 0 ; i < sizeof(spawn_proto_times)/sizeof(spawn_proto_times[0]) ; i++)
+	{
+		t = (float *)((byte *)ent + spawn_proto_times[i]);
+		if (*t > 0 && *t >= p->time)
+			*t += shift;
+	}
+
+	move = ent->monsterinfo.currentmove;
+	if ((ent->svflags & SVF_MONSTER) && move
+		&& ent->s.frame >= move->firstframe && ent->s.frame <= move->lastframe)
+		ent->s.frame = move->firstframe + (rand() % (move->lastframe - move->firstframe + 1));
+
+	level.total_monsters += p->monsters;
+	level.total_goals += p->goals;
+	level.total_secrets += p->secrets;
+
+	G_IndexEdict (ent);
+	if (p->linked)
+		gi.linkentity (ent);
+}
+
+/*
+===============
+ED_SpawnPrototype
+
+ED_CallSpawn for runtime spawners. Like ED_CallSpawn, the edict is freed
+if the spawn fails.
+===============
+*/
+void ED_SpawnPrototype (edict_t *ent)
+{
+	spawnproto_t	*p;
+	int				serial, monsters, goals, secrets;
+
+	if (!ent->classname)
+	{
+		ED_CallSpawn (ent);
+		return;
+	}
+
+	p = ED_FindPrototype (ent);
+	if (p && p->image)
+	{
+		ED_CopyPrototype (p, ent);
+		return;
+	}
+	if (p || num_spawn_protos == MAX_SPAWN_PROTOS)
+	{
+		ED_CallSpawn (ent);
+		return;
+	}
+
+	// the key is what the spawner set, before the spawn function changes it
+	p = &spawn_protos[num_spawn_protos++];
+	p->classname = ent->classname;
+	p->spawnflags = ent->spawnflags;
+	p->flags = ent->flags;
+	VectorCopy (ent->s.origin, p->origin);
+	VectorCopy (ent->s.angles, p->angles);
+	p->image = NULL;
+
+	serial = G_EdictSerial ();
+	monsters = level.total_monsters;
+	goals = level.total_goals;
+	secrets = level.total_secrets;
+
+	ED_CallSpawn (ent);
+
+	if (!ent->inuse || G_EdictSerial () != serial || !ED_PrototypeSafe (ent))
+		return;
+
+	p->image = gi.TagMalloc (sizeof(edict_t), TAG_LEVEL);
+	memcpy (p->image, ent, sizeof(edict_t));
+	p->self = ent;
+	p->time = level.time;
+	p->linked = (ent->area.prev != NULL);
+	p->monsters = level.total_monsters - monsters;
+	p->goals = level.total_goals - goals;
+	p->secrets = level.total_secrets - secrets;
+}
+
+/*
+==============================================================================
+
+STRING INTERNING
+
+Every string key an entity file sets goes through ED_NewString, and a
+map spells the same few hundred classnames, targetnames and models
+thousands of times. Identical strings are stored once, for the level,
+in TAG_LEVEL blocks, each with its case-insensitive hash and length.
+G_Find and the spawn table can then match two entities' keys by
+pointer, and ED_StringHash hands back the stored hash instead of
+walking the string again.
+
+Interned strings are shared, so they must never be written to or
+freed. An entity that needs to change one gets its own copy first, as
+target_lock does.
+
+Savegames write the text, so loaded levels get plain copies again.
+ED_ResetStrings forgets the table whenever TAG_LEVEL is freed.
+
+==============================================================================
+*/
+
+#define	INTERN_HASH_SIZE	1024		// must be a power of 2
+#define	INTERN_BLOCK_SIZE	16384
+
+typedef struct internstr_s
+{
+	struct internstr_s	*next;
+	char				*string;		// points at data, to tell an interned string from the middle of one
+	unsigned int		hash;
+	int					length;
+	char				data[4];
+} internstr_t;
+
+typedef struct internblock_s
+{
+	struct internblock_s	*next;
+	int						size, used;
+} internblock_t;
+
+static internstr_t		*intern_head[INTERN_HASH_SIZE];
+static internblock_t	*intern_blocks;
+
+static unsigned int ED_ComputeHash (const char *s)
+{
+	unsigned int	hash = 0;
+	int				c;
+
+	// case-insensitive, to agree with Q_strcasecmp
+	while ((c = *(unsigned char *)s++) != 0)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hash = hash * 31 + c;
+	}
+	return hash;
+}
+
+static internstr_t *ED_InternedString (const char *s)
+{
+	internblock_t	*b;
+	internstr_t		*is;
+	byte			*start;
+
+	for (b = intern_blocks ; b ; b = b->next)
+	{
+		start = (byte *)(b + 1);
+		if ((byte *)s < start + (size_t)&((internstr_t *)0)->data || (byte *)s >= start + b->used)
+			continue;
+		is = (internstr_t *)((byte *)s - (size_t)&((internstr_t *)0)->data);
+		return (is->string == s) ? is : NULL;
+	}
+	return NULL;
+}
+
+static void *ED_InternAlloc (int size)
+{
+	internblock_t	*b;
+	void			*p;
+
+	size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	b = intern_blocks;
+	if (!b || b->used + size > b->size)
+	{
+		b = gi.TagMalloc (sizeof(internblock_t) + max(size, INTERN_BLOCK_SIZE), TAG_LEVEL);
+		b->size = max(size, INTERN_BLOCK_SIZE);
+		b->used = 0;
+		b->next = intern_blocks;
+		intern_blocks = b;
+	}
+	p = (byte *)(b + 1) + b->used;
+	b->used += size;
+	return p;
+}
+
+/*
+=============
+ED_InternString
+
+The level's one copy of s
+=============
+*/
+char *ED_InternString (const char *s)
+{
+	internstr_t		*is;
+	unsigned int	hash;
+	int				length;
+
+	hash = ED_ComputeHash (s);
+	length = (int)strlen(s);
+	for (is = intern_head[hash & (INTERN_HASH_SIZE-1)] ; is ; is = is->next)
+	{
+		if (is->hash == hash && is->length == length && !strcmp(is->string, s))
+			return is->string;
+	}
+
+	is = ED_InternAlloc ((int)(size_t)&((internstr_t *)0)->data + length + 1);
+	is->string = is->data;
+	is->hash = hash;
+	is->length = length;
+	memcpy (is->data, s, length + 1);
+	is->next = intern_head[hash & (INTERN_HASH_SIZE-1)];
+	intern_head[hash & (INTERN_HASH_SIZE-1)] = is;
+	return is->string;
+}
+
+/*
+=============
+ED_StringHash
+
+Case-insensitive hash of s, stored if s is interned
+=============
+*/
+unsigned int ED_StringHash (const char *s)
+{
+	internstr_t	*is;
+
+	if ((is = ED_InternedString (s)) != NULL)
+		return is->hash;
+	return ED_ComputeHash (s);
+}
+
+/*
+=============
+ED_ResetStrings
+
+Called wherever TAG_LEVEL is freed
+=============
+*/
+void ED_ResetStrings (void)
+{
+	memset (intern_head, 0, sizeof(intern_head));
+	intern_blocks = NULL;
 }
 
 /*
@@ -507,12 +994,16 @@ ED_NewString
 */
 char *ED_NewString (char *string)
 {
+	static char	buffer[MAX_STRING_CHARS];
 	char	*newb, *new_p;
 	int		i,l;
 	
 	l = (int)strlen(string) + 1;
 
-	newb = (char*)gi.TagMalloc (l, TAG_LEVEL);
+	if (l <= sizeof(buffer))
+		newb = buffer;
+	else
+		newb = (char*)G_LevelAlloc (l);
 
 	new_p = newb;
 
@@ -529,13 +1020,74 @@ char *ED_NewString (char *string)
 		else
 			*new_p++ = string[i];
 	}
-	
+
+	if (newb == buffer)
+		return ED_InternString (buffer);
 	return newb;
 }
 
 
 
 
+/*
+===============
+Field lookup
+
+fields[] has hundreds of Lazarus keys, and ED_ParseField is called for
+every key/value pair of every entity. The spawnable fields are hashed
+case-insensitively at startup, keeping table order within a chain so
+the first matching field still wins.
+===============
+*/
+#define	FIELD_HASH_SIZE		1024	// must be a power of 2
+
+static int	field_head[FIELD_HASH_SIZE];
+static int	*field_next;
+
+static int ED_FieldHash (const char *s)
+{
+	unsigned int	hash = 0;
+	int				c;
+
+	// case-insensitive, to agree with Q_strcasecmp
+	while ((c = *(unsigned char *)s++) != 0)
+	{
+		if (c >= 'A' && c <= 'Z')
+			c += 'a' - 'A';
+		hash = hash * 31 + c;
+	}
+	return hash & (FIELD_HASH_SIZE - 1);
+}
+
+/*
+===============
+ED_InitFieldTable
+
+Called from InitGame
+===============
+*/
+void ED_InitFieldTable (void)
+{
+	int		i, h, num_fields;
+
+	for (num_fields = 0 ; fields[num_fields].name ; num_fields++)
+		;
+
+	field_next = (int *)gi.TagMalloc (num_fields * sizeof(int), TAG_GAME);
+	for (i = 0 ; i < FIELD_HASH_SIZE ; i++)
+		field_head[i] = -1;
+
+	// link in reverse so each chain ends up in table order
+	for (i = num_fields-1 ; i >= 0 ; i--)
+	{
+		if (fields[i].flags & FFL_NOSPAWN)
+			continue;
+		h = ED_FieldHash (fields[i].name);
+		field_next[i] = field_head[h];
+		field_head[h] = i;
+	}
+}
+
 /*
 ===============
 ED_ParseField
@@ -550,10 +1102,12 @@ void ED_ParseField (char *key, char *value, edict_t *ent)
 	byte	*b;
 	float	v;
 	vec3_t	vec;
+	int		i;
 
-	for (f=fields ; f->name ; f++)
+	for (i = field_head[ED_FieldHash(key)] ; i >= 0 ; i = field_next[i])
 	{
-		if (!(f->flags & FFL_NOSPAWN) && !Q_strcasecmp(f->name, key))
+		f = &fields[i];
+		if (!Q_strcasecmp(f->name, key))
 		{	// found it
 			if (f->flags & FFL_SPAWNTEMP)
 				b = (byte *)&st;
@@ -564,6 +1118,8 @@ void ED_ParseField (char *key, char *value, edict_t *ent)
 			{
 			case F_LSTRING:
 				*(char **)(b+f->ofs) = ED_NewString (value);
+				if (b == (byte *)ent && (f->ofs == FOFS(targetname) || f->ofs == FOFS(dmgteam)))
+					G_IndexEdict (ent);
 				break;
 			case F_VECTOR:
 				sscanf (value, "%f %f %f", &vec[0], &vec[1], &vec[2]);
@@ -661,62 +1217,13 @@ qboolean LoadAliasFile (char *name)
 	// If file doesn't exist on hard disk, it must be in a pak file
 	if (!alias_data)
 	{
-		cvar_t			*basedir, *gamedir;
-		char			filename[256];
-		char			pakfile[256];
-		char			textname[128];
-		int				i, k, num, numitems;
-		qboolean		in_pak = false;
-		FILE			*fpak;
-		pak_header_t	pakheader;
-		pak_item_t		pakitem;
-
-		basedir = gi.cvar("basedir", "", 0);
-		gamedir = gi.cvar("gamedir", "", 0);
-		strcpy(filename,basedir->string);
-		sprintf(textname, name);
-
-		if(strlen(gamedir->string))
-			strcpy(filename,gamedir->string);
+		char	pakpath[MAX_OSPATH];
+
 		// check all pakfiles in current gamedir
-		for (i=0; i<10; i++)
-		{
-			sprintf(pakfile,"%s/pak%d.pak",filename,i);
-			if (NULL != (fpak = fopen(pakfile, "rb")))
-			{
-				num=fread(&pakheader,1,sizeof(pak_header_t),fpak);
-				if(num >= sizeof(pak_header_t))
-				{
-					if (pakheader.id[0] == 'P' &&
-						pakheader.id[1] == 'A' &&
-						pakheader.id[2] == 'C' &&
-						pakheader.id[3] == 'K'   )
-					{
-						numitems = pakheader.dsize/sizeof(pak_item_t);
-						fseek(fpak,pakheader.dstart,SEEK_SET);
-						for(k=0; k<numitems && !in_pak; k++)
-						{
-							fread(&pakitem,1,sizeof(pak_item_t),fpak);
-							if (!Q_strcasecmp(pakitem.name,textname))
-							{
-								in_pak = true;
-								fseek(fpak,pakitem.start,SEEK_SET);
-								alias_data = gi.TagMalloc(pakitem.size + 1, TAG_LEVEL);
-								if (!alias_data) {
-									fclose(fpak);
-									gi.dprintf("LoadAliasData: Memory allocation failure for entalias.dat\n");
-									return false;
-								}
-								alias_data_size = fread(alias_data,1,pakitem.size,fpak);
-								alias_data[pakitem.size] = 0; // put end marker
-								alias_from_pak = true;
-							}
-						}
-					}
-				}
-				fclose(fpak);
-			}
-		}
+		Pak_GameDir (pakpath, sizeof(pakpath));
+		alias_data = (char *)Pak_LoadFile (pakpath, name, &alias_data_size, 1); // put end marker
+		if (alias_data)
+			alias_from_pak = true;
 	}
 
 	if (!alias_data)
@@ -726,6 +1233,219 @@ qboolean LoadAliasFile (char *name)
 }
 #endif
 
+/*
+====================
+Parsed alias script
+
+The alias script used to be re-tokenised from the top for every entity
+in the map. It is now parsed once after loading into one entry per
+classname, each holding its key/value pairs, and looked up by hash.
+Only the first definition of a classname is used, as before.
+====================
+*/
+typedef struct
+{
+	char		*classname;
+	char		**pairs;		// key, value, key, value...
+	int			numpairs;
+	qboolean	complete;		// false if the definition was cut short by an error
+	int			next;			// next alias in the same hash chain
+} entalias_t;
+
+static entalias_t	*entaliases;
+static int			num_entaliases;
+static char			**entalias_pairs;
+static int			entalias_head[SPAWN_HASH_SIZE];
+
+static entalias_t *ED_FindEntityAlias (char *classname)
+{
+	int		i;
+
+	if (!entaliases)
+		return NULL;
+
+	for (i = entalias_head[ED_ClassnameHash(classname)] ; i >= 0 ; i = entaliases[i].next)
+	{
+		if (!strcmp(entaliases[i].classname, classname))
+			return &entaliases[i];
+	}
+	return NULL;
+}
+
+static entalias_t *ED_AddEntityAlias (char *classname, char **pairs)
+{
+	entalias_t	*alias;
+	int			h;
+
+	alias = &entaliases[num_entaliases];
+	alias->classname = G_CopyString (classname);
+	alias->pairs = pairs;
+	alias->numpairs = 0;
+	alias->complete = false;
+
+	// keep only the first definition of each classname reachable
+	if (ED_FindEntityAlias (classname))
+		alias->next = -1;
+	else
+	{
+		h = ED_ClassnameHash (classname);
+		alias->next = entalias_head[h];
+		entalias_head[h] = num_entaliases;
+	}
+	num_entaliases++;
+	return alias;
+}
+
+/*
+====================
+ED_FreeEntityAliases
+====================
+*/
+void ED_FreeEntityAliases (void)
+{
+	int		i;
+
+	if (entaliases)
+	{
+		for (i = 0 ; i < num_entaliases ; i++)
+			gi.TagFree (entaliases[i].classname);
+		for (i = 0 ; entalias_pairs[i] ; i++)
+			gi.TagFree (entalias_pairs[i]);
+		gi.TagFree (entalias_pairs);
+		gi.TagFree (entaliases);
+	}
+	entaliases = NULL;
+	entalias_pairs = NULL;
+	num_entaliases = 0;
+}
+
+/*
+====================
+ED_ParseAliasData
+
+Builds the alias list from alias_data, then unloads alias_data
+====================
+*/
+void ED_ParseAliasData (void)
+{
+	char		*data, *end, *token = NULL;
+	char		classname[256];
+	entalias_t	*alias;
+	int			numtokens, numpairs, i;
+	qboolean	have_token;
+
+	// anything left from the last map went with its TAG_LEVEL memory
+	entaliases = NULL;
+	entalias_pairs = NULL;
+	num_entaliases = 0;
+
+	if (!alias_data) // If no alias file was loaded, don't bother
+		return;
+
+	end = alias_data + alias_data_size;
+
+	// count tokens to size the lists, every entry and pair uses at least one
+	numtokens = 0;
+	for (data = alias_data ; data && data < end ; numtokens++)
+		COM_Parse (&data);
+
+	entaliases = (entalias_t *)gi.TagMalloc ((numtokens + 1) * sizeof(entalias_t), TAG_LEVEL);
+	entalias_pairs = (char **)gi.TagMalloc ((numtokens + 1) * sizeof(char *), TAG_LEVEL);
+	for (i = 0 ; i < SPAWN_HASH_SIZE ; i++)
+		entalias_head[i] = -1;
+
+	numpairs = 0;
+	have_token = false;
+	data = alias_data;
+	while (data < end)
+	{
+		// classname, outside of any braces
+		if (!have_token)
+		{
+			token = COM_Parse (&data);
+			if (!data)
+				break;
+		}
+		have_token = false;
+		if (token[0] == '}')
+		{
+			gi.dprintf ("ED_ParseAliasData: closing brace without matching opening brace\n");
+			break;
+		}
+		if (token[0] == '{')
+		{	// skip a definition with no classname
+			while (data < end)
+			{
+				token = COM_Parse (&data);
+				if (!data || token[0] == '}')
+					break;
+			}
+			if (!data)
+				break;
+			continue;
+		}
+		strncpy (classname, token, sizeof(classname)-1);
+		classname[sizeof(classname)-1] = 0;
+		alias = ED_AddEntityAlias (classname, entalias_pairs + numpairs);
+
+		// get the opening curly brace
+		token = COM_Parse (&data);
+		if (!data) {
+			gi.dprintf ("ED_ParseAliasData: unexpected EOF\n");
+			break;
+		}
+		if (token[0] != '{') {
+			gi.dprintf ("ED_ParseAliasData: found %s when expecting {\n", token);
+			have_token = true; // this could be the next classname
+			continue;
+		}
+
+		// go through all the dictionary pairs
+		while (data < end)
+		{
+		// parse key
+			token = COM_Parse (&data);
+			if (!data) {
+				gi.dprintf ("ED_ParseAliasData: EOF without closing brace\n");
+				break;
+			}
+			if (token[0] == '}') {
+				alias->complete = true;
+				break;
+			}
+			entalias_pairs[numpairs] = G_CopyString (token);
+
+		// parse value
+			token = COM_Parse (&data);
+			if (!data) {
+				gi.TagFree (entalias_pairs[numpairs]);
+				gi.dprintf ("ED_ParseAliasData: EOF without closing brace\n");
+				break;
+			}
+			if (token[0] == '}') {
+				gi.TagFree (entalias_pairs[numpairs]);
+				gi.dprintf ("ED_ParseAliasData: closing brace without data\n");
+				break;
+			}
+			entalias_pairs[numpairs+1] = G_CopyString (token);
+			numpairs += 2;
+			alias->numpairs++;
+		}
+		if (!data)
+			break;
+	}
+	entalias_pairs[numpairs] = NULL;
+
+	// Knightmare- unload the alias script file
+#ifdef KMQUAKE2_ENGINE_MOD // use new engine function instead
+	gi.FreeFile(alias_data);
+#else
+	gi.TagFree(alias_data);
+#endif
+	alias_data = NULL;
+	alias_data_size = 0;
+}
+
 /*
 ====================
 LoadAliasData
@@ -748,6 +1468,8 @@ void LoadAliasData (void)
 		if (!LoadAliasFile("ext_data/entalias.def"))
 			LoadAliasFile("scripts/entalias.dat");
 #endif
+
+	ED_ParseAliasData ();
 }
 
 /*
@@ -762,19 +1484,17 @@ Returns true if an alias was loaded for the given entity.
 */
 qboolean ED_ParseEntityAlias (char *data, edict_t *ent)
 {
-	qboolean	classname_found, alias_found, alias_loaded;
+	qboolean	classname_found, alias_loaded;
 	char		*search_data;
 	char		*search_token;
 	char		entclassname[256];
-	char		keyname[256];
-	int			braceLevel;
+	entalias_t	*alias;
+	int			i;
 
 	classname_found = false;
-	alias_found	= false;
 	alias_loaded = false;
-	braceLevel = 0;
 
-	if (!alias_data) // If no alias file was loaded, don't bother
+	if (!num_entaliases) // If no alias file was loaded, don't bother
 		return false;
 
 	search_data = data;  // copy entity data postion
@@ -798,73 +1518,26 @@ qboolean ED_ParseEntityAlias (char *data, edict_t *ent)
 		// if we've found the classname, exit loop
 		if (classname_found) {
 			strncpy (entclassname, search_token, sizeof(entclassname)-1);
+			entclassname[sizeof(entclassname)-1] = 0;
 			break;
 		}
 	}
-	// then search the entalias.def file for that classname
+	// then look up the alias for that classname and load its fields
 	if (classname_found)
 	{
-		search_data = alias_data;	// copy alias data postion
- 		while (search_data < (alias_data + alias_data_size))
+		alias = ED_FindEntityAlias (entclassname);
+		if (!alias)
+			return false;
+
+		for (i = 0 ; i < alias->numpairs ; i++)
 		{
-			search_token = COM_Parse (&search_data);
-			if (!search_data)
-				return false;
-			if (!search_token)
-				break;
-			// see if we're inside the braces of an alias definition
-			if (search_token[0] == '{') braceLevel++;
-			else if (search_token[0] == '}') braceLevel--;
-			if (braceLevel < 0) {
-				gi.dprintf ("ED_ParseEntityAlias: closing brace without matching opening brace\n");
-				return false;
-			}
-			// matching classname must be outside braces
-			if (!strcmp(search_token, entclassname) && (braceLevel == 0)) {
-				//gi.dprintf ("Alias for %s found in alias script file.\n", search_token);
-				alias_found = true;
-				break;
-			}
-		}
-		// then if that classname is found, load the fields from that alias
-		if (alias_found)
-		{	// get the opening curly brace
-			search_token = COM_Parse (&search_data);
-			if (!search_data) {
-				gi.dprintf ("ED_ParseEntityAlias: unexpected EOF\n");
-				return false;
-			}
-			if (search_token[0] != '{') {
-				gi.dprintf ("ED_ParseEntityAlias: found %s when expecting {\n", search_token);
-				return false;
-			}
-			// go through all the dictionary pairs
-			while (search_data < (alias_data + alias_data_size))
-			{	
-			// parse key
-				search_token = COM_Parse (&search_data);
-				if (!search_data) {
-					gi.dprintf ("ED_ParseEntityAlias: EOF without closing brace\n");
-					return false;
-				}
-				if (search_token[0] == '}')
-					break;
-				strncpy (keyname, search_token, sizeof(keyname)-1);
-				
-			// parse value	
-				search_token = COM_Parse (&search_data);
-				if (!search_data) {
-					gi.dprintf ("ED_ParseEntityAlias: EOF without closing brace\n");
-					return false;
-				}
-				if (search_token[0] == '}') {
-					gi.dprintf ("ED_ParseEntityAlias: closing brace without data\n");
-					return false;
-				}
-				ED_ParseField (keyname, search_token, ent);
-				alias_loaded = true;
-			}
+			ED_ParseField (alias->pairs[i*2], alias->pairs[i*2+1], ent);
+			alias_loaded = true;
 		}
+
+		// a broken definition never counted as loaded
+		if (!alias->complete)
+			return false;
 	}
 	return alias_loaded;
 }
@@ -946,13 +1619,42 @@ Chain together all entities with a matching team field.
 
 All but the first will have the FL_TEAMSLAVE flag set.
 All but the last will have the teamchain field set to the next one
+
+The first of each team is the master, and every later entity with the
+same team joins its chain in edict order. That used to be a scan of the
+rest of the edicts for every master; teams are now looked up by name in
+a hash table as the edicts go by, which takes one pass. When a master
+already has a chain from an earlier call, new members go on the end
+of it rather than replacing it.
 ================
 */
+typedef struct
+{
+	edict_t	*master;
+	edict_t	*last;
+} teamslot_t;
+
+static unsigned int G_TeamHash (char *team)
+{
+	unsigned int	hash = 2166136261u;
+
+	while (*team)
+		hash = (hash ^ (byte)*team++) * 16777619u;
+	return hash;
+}
+
 void G_FindTeams (void)
 {
-	edict_t	*e, *e2, *chain;
-	int		i, j;
-	int		c, c2;
+	edict_t		*e;
+	teamslot_t	*table, *slot;
+	int			i, n, size;
+	unsigned int	h;
+	int			c, c2;
+
+	for (size=64 ; size < globals.num_edicts*2 ; size<<=1)
+		;
+	table = gi.TagMalloc (size * sizeof(teamslot_t), TAG_LEVEL);
+	memset (table, 0, size * sizeof(teamslot_t));
 
 	c = 0;
 	c2 = 0;
@@ -964,6 +1666,24 @@ void G_FindTeams (void)
 			continue;
 		if (e->flags & FL_TEAMSLAVE)
 			continue;
+
+		for (h=G_TeamHash(e->team) ; ; h++)
+		{
+			slot = &table[h & (size-1)];
+			if (!slot->master || !strcmp(slot->master->team, e->team))
+				break;
+		}
+
+		if (slot->master)
+		{
+			c2++;
+			slot->last->teamchain = e;
+			e->teammaster = slot->master;
+			slot->last = e;
+			e->flags |= FL_TEAMSLAVE;
+			continue;
+		}
+
 		// Lazarus: some entities may have psuedo-teams that shouldn't be handled here
 		if (e->classname && !Q_strcasecmp(e->classname,"target_change"))
 			continue;
@@ -971,44 +1691,35 @@ void G_FindTeams (void)
 			continue;
 		if (e->classname && !Q_strcasecmp(e->classname,"target_clone"))
 			continue;
-		chain = e;
+		slot->master = slot->last = e;
 		e->teammaster = e;
 		c++;
 		c2++;
-		for (j=i+1, e2=e+1 ; j < globals.num_edicts ; j++,e2++)
+
+		// called again after target_change or target_clone gave out
+		// new teams, so keep the chain this master already has
+		for (n=0 ; n<globals.num_edicts && slot->last->teamchain ; n++)
 		{
-			if (!e2->inuse)
-				continue;
-			if (!e2->team)
-				continue;
-			if (e2->flags & FL_TEAMSLAVE)
-				continue;
-			if (!strcmp(e->team, e2->team))
-			{
-				c2++;
-				chain->teamchain = e2;
-				e2->teammaster = e;
-				chain = e2;
-				e2->flags |= FL_TEAMSLAVE;
-			}
+			if (slot->last->teamchain->teammaster != e)
+				break;
+			slot->last = slot->last->teamchain;
+			c2++;
 		}
 	}
 
+	gi.TagFree (table);
+
 	if(level.time < 2)
 		gi.dprintf ("%i teams with %i entities\n", c, c2);
 }
 
-void trans_ent_filename (char *);
-void ReadEdict (FILE *f, edict_t *ent);
 void LoadTransitionEnts()
 {
 	if(developer->value)
 		gi.dprintf("==== LoadTransitionEnts ====\n");
 	if(game.transition_ents)
 	{
-		char		t_file[_MAX_PATH];
 		int			i, j;
-		FILE		*f;
 		vec3_t		v_spawn;
 		edict_t		*ent;
 		edict_t		*spawn;
@@ -1027,16 +1738,17 @@ void LoadTransitionEnts()
 				spawn = G_Find(spawn,FOFS(targetname),game.spawnpoint);
 			}
 		}
-		trans_ent_filename (t_file);
-		f = fopen(t_file,"rb");
-		if(!f)
-			gi.error("LoadTransitionEnts: Cannot open %s\n",t_file);
+		// Nothing to bring over (a savegame that was made without the
+		// file), so just carry on. ReadLevel replaces these edicts anyway.
+		if(!OpenTransitionEdicts())
+			gi.dprintf("LoadTransitionEnts: no transition entities\n");
 		else
 		{
 			for(i=0; i<game.transition_ents; i++)
 			{
 				ent = G_Spawn();
-				ReadEdict(f,ent);
+				ReadTransitionEdict(ent);
+				G_IndexEdict(ent);
 				// Correction for monsters with health EXACTLY 0
 				// If we don't do this, spawn function will bring
 				// 'em back to life
@@ -1076,7 +1788,7 @@ void LoadTransitionEnts()
 				}
 				ent->s.renderfx |= RF_IR_VISIBLE;
 			}
-			fclose(f);
+			CloseTransitionEdicts();
 		}
 	}
 }
@@ -1084,6 +1796,46 @@ void LoadTransitionEnts()
 
 //===================================================
 
+/*
+==============
+G_ResetLevelCaches
+
+Throws out what the game keeps about the level outside the entities
+and rebuilds what is worked out from them. Called by SpawnEntities
+before the map is parsed, and by ReadLevel and RestartLevel once the
+entities are back.
+==============
+*/
+void G_ResetLevelCaches (void)
+{
+	G_ResetFreeEdicts ();
+	AI_ClearSightCache ();
+	M_ClearMoveCache ();
+	G_ClearTraceCache ();
+	G_ClearContentsCache ();
+	movewith_reset ();
+	G_ResetAttachedSounds ();
+	gib_pool_reset ();
+	thing_pool_reset ();
+	target_string_reset ();
+	G_ResetProjectiles ();
+	G_ClearFrameTouches ();
+	G_ResetTriggerWatches ();
+	G_ResetRespawns ();
+	G_ResetClientPVS ();
+	G_LagReset ();
+	Gov_Reset ();
+	G_ResetSpawnSpots ();
+	G_ResetPathTracks ();
+	turret_reset_targets ();
+	M_ResetCorpses ();
+	CTFCountTechs ();
+	CTFFlagsChanged ();
+	RestoreCamPlayers ();
+	RestoreReflections ();
+	Text_ResetCache ();
+}
+
 /*
 ==============
 SpawnEntities
@@ -1102,7 +1854,10 @@ void SpawnEntities (char *mapname, char *entities, char *spawnpoint)
 	extern int	max_modelindex;
 	extern int	max_soundindex;
 	extern int	lastgibframe;
+	double		start;
+	int			reseed;
 
+	start = Prof_Seconds ();
 	if (developer->value)
 		gi.dprintf("====== SpawnEntities ========\n");
 	skill_level = floor (skill->value);
@@ -1113,12 +1868,28 @@ void SpawnEntities (char *mapname, char *entities, char *spawnpoint)
 	if (skill->value != skill_level)
 		gi.cvar_forceset("skill", va("%f", skill_level));
 
+	// ends a usercmd log from the last level, or starts one armed for this
+	CmdLog_LevelStart (mapname);
+
 	SaveClientData ();
 
+	// the level we just left may still be going to disk
+	WaitForSave ();
+
 	gi.FreeTags (TAG_LEVEL);
+	ED_ResetStrings ();
+	G_ResetLevelArena ();
 
 	memset (&level, 0, sizeof(level));
 	memset (g_edicts, 0, game.maxentities * sizeof (g_edicts[0]));
+	G_ClearEdictIndexes ();
+	G_ClearLinkCache ();
+	G_ResetLevelCaches ();
+	G_ClearIndexCache ();
+	G_ResetDelayedUses ();
+	G_ResetLightStyles ();
+	ED_ResetUnknownClassnames ();
+	ED_ResetSpawnPrototypes ();
 	// Lazarus: these are used to track model and sound indices
 	//          in g_main.c:
 	max_modelindex = 0;
@@ -1141,6 +1912,11 @@ void SpawnEntities (char *mapname, char *entities, char *spawnpoint)
 	LoadAliasData();
 	//gi.dprintf ("Size of alias data: %i\n", alias_data_size);
 
+	// the spawn images below have to come out the same when a save of
+	// this level is loaded, so the map spawns from a fixed seed
+	reseed = rand ();
+	srand (ED_StringHash (level.mapname));
+
 // parse ents
 	while (1)
 	{
@@ -1154,7 +1930,7 @@ void SpawnEntities (char *mapname, char *entities, char *spawnpoint)
 		if (!ent)
 			ent = g_edicts;
 		else
-			ent = G_Spawn ();
+			ent = G_SpawnTagged ("SpawnEntities");
 		entities = ED_ParseEdict (entities, ent);
 
 		// yet another map hack
@@ -1218,17 +1994,8 @@ removeflags:
 		ent->s.renderfx |= RF_IR_VISIBLE; // ir goggles flag
 	}	
 
-	// Knightmare- unload the alias script file
-	if (alias_data) { // If no alias file was loaded, don't bother
-#ifdef KMQUAKE2_ENGINE_MOD // use new engine function instead
-		gi.FreeFile(alias_data);
-#else
-		if (alias_from_pak)
-			gi.TagFree(alias_data);
-		else
-			G_Free(&alias_data);
-#endif
-	}
+	// Knightmare- unload the alias script
+	ED_FreeEntityAliases ();
 
 	// Knightmare- unload the replacement entity data
 /*	if (newents) // If no alias file was loaded, don't bother
@@ -1310,11 +2077,21 @@ removeflags:
 
 	} */
 
+	// spawn images for delta level saves, without the transition ents
+	SaveLevelBaseline ();
+	SaveLevelRestart ();
+	srand (reseed);
+
 	if(game.transition_ents)
 		LoadTransitionEnts();
 
+	M_ResetCorpses ();
+	CTFCountTechs ();
+	CTFFlagsChanged ();
+
 	actor_files();
 
+	Rep_BeginLevel ((float)((Prof_Seconds () - start) * 1000.0), false);
 }
 
 
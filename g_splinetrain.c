@@ -30,15 +30,73 @@ void Move_Calc (edict_t *ent, vec3_t dest, void(*func)(edict_t*));
 void train_blocked (edict_t *self, edict_t *other);
 void train_die (edict_t *self, edict_t *inflictor, edict_t *attacker, int damage, vec3_t point);
 
+/*
+=================
+Spline segments
+
+The control points of the segment a train is on only depend on the two
+path_corners at its ends, but train_spline_calc used to rebuild them
+(two AngleVectors and a sqrt) every frame. They are kept per train here
+and only rebuilt when the train starts a new segment or either end has
+moved or turned since (path_corners can movewith).
+=================
+*/
+typedef struct
+{
+	vec3_t	p1, p2, a1, a2;		// ends the control points were built from
+	vec3_t	c1, c2;
+	float	s;
+	qboolean	valid;
+} splineseg_t;
+
+static splineseg_t	spline_segs[MAX_EDICTS];
+
+static splineseg_t *train_spline_segment (edict_t *train, vec3_t p1, vec3_t p2, vec3_t a1, vec3_t a2)
+{
+	splineseg_t	*seg;
+	vec3_t		v1, v2; // direction vectors
+	vec3_t		d;
+
+	seg = &spline_segs[train - g_edicts];
+	if (seg->valid && VectorCompare(seg->p1, p1) && VectorCompare(seg->p2, p2)
+		&& VectorCompare(seg->a1, a1) && VectorCompare(seg->a2, a2))
+		return seg;
+
+	// Beziers need two control-points to define the shape of the curve.
+	// These can be created from the available data.  They are offset a
+	// specific distance from the endpoints (path_*s), in the direction
+	// of the endpoints' angle vectors (the 2nd control-point is offset in
+	// the opposite direction).  The distance used is a fraction of the total
+	// distance between the endpoints, ensuring it's scaled proportionally.
+	// The factor of 0.4 is simply based on experimentation, as a value that
+	// yields nice even curves.
+
+	AngleVectors(a1, v1, NULL, NULL);
+	AngleVectors(a2, v2, NULL, NULL);
+
+	VectorSubtract(p2, p1, d);
+	seg->s = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) * 0.4;
+
+	VectorMA(p1,  seg->s, v1, seg->c1);
+	VectorMA(p2, -seg->s, v2, seg->c2);
+
+	VectorCopy(p1, seg->p1);
+	VectorCopy(p2, seg->p2);
+	VectorCopy(a1, seg->a1);
+	VectorCopy(a2, seg->a2);
+	seg->valid = true;
+	return seg;
+}
+
 void train_spline_calc (edict_t *train, vec3_t p1, vec3_t p2, vec3_t a1, vec3_t a2, float m)
 {
 	/* p1, p2  =  origins of path_* ents
 	   a1, a2  =  angles from path_* ents
 	   m       =  decimal position along curve */
 
-	vec3_t v1, v2; // direction vectors
-	vec3_t c1, c2; // control-point coords
-	vec3_t d, v;   // temps
+	splineseg_t	*seg;
+	float	*c1, *c2; // control-point coords
+	vec3_t v;      // temps
 	float  s;      // vector scale
 	vec3_t p, a;   // final computed position & angles for mover
 	// these greatly simplify/speed up equations
@@ -52,23 +110,10 @@ void train_spline_calc (edict_t *train, vec3_t p1, vec3_t p2, vec3_t a1, vec3_t
 	float m2n_3 = m2 * n * 3;
 	float mn_2  = m * n * 2;
 
-	// Beziers need two control-points to define the shape of the curve.
-	// These can be created from the available data.  They are offset a
-	// specific distance from the endpoints (path_*s), in the direction
-	// of the endpoints' angle vectors (the 2nd control-point is offset in
-	// the opposite direction).  The distance used is a fraction of the total
-	// distance between the endpoints, ensuring it's scaled proportionally.
-	// The factor of 0.4 is simply based on experimentation, as a value that
-	// yields nice even curves.
-
-	AngleVectors(a1, v1, NULL, NULL);
-	AngleVectors(a2, v2, NULL, NULL);
-
-	VectorSubtract(p2, p1, d);
-	s = sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) * 0.4;
-
-	VectorMA(p1,  s, v1, c1);
-	VectorMA(p2, -s, v2, c2);
+	seg = train_spline_segment (train, p1, p2, a1, a2);
+	c1 = seg->c1;
+	c2 = seg->c2;
+	s  = seg->s;
 
 	// cubic interpolation of the four points
 	// gives the position along the curve
@@ -439,10 +484,9 @@ void SP_func_train_spline (edict_t *self)
 		speaker->volume      = 1;
 		speaker->attenuation = self->attenuation; // was 1
 		speaker->owner       = self;
-		speaker->think       = Moving_Speaker_Think;
-		speaker->nextthink   = level.time + 2*FRAMETIME;
 		speaker->spawnflags  = 7;       // owner must be moving to play
 		self->speaker        = speaker;
+		G_AttachSpeaker (speaker);
 		if(VectorLength(self->s.origin))
 			VectorCopy(self->s.origin,speaker->s.origin);
 		else {
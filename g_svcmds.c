@@ -48,12 +48,20 @@ Prints the current list of filters.
 writeip
 Dumps "addip <ip>" commands to listip.cfg so it can be execed at a later date.  The filter lists are not saved and restored by default, because I beleive it would cause too much confusion.
 
+loadip [file]
+Reads a file written by writeip (listip.cfg by default) straight into the list, which is much quicker than execing a long one.
+
 filterban <0 or 1>
 
 If 1 (the default), then ip addresses matching the current list will be prohibited from entering the game.  This is the default setting.
 
 If 0, then only addresses matching the list will be allowed.  This lets you easily set up a private game, or a game that only allows players from your local network.
 
+maxipfilters <count>
+
+How many filters the list may hold (1024 by default).
+
+Each octet of a filter either matches exactly or matches anything, so there are only 16 possible masks. The filters are kept in a hash set keyed on mask and address, and checking a connection probes it once for each mask in use instead of walking the whole list. Both are malloc'd rather than TAG_GAME, so the list outlives a game the way the old fixed array did.
 
 ==============================================================================
 */
@@ -64,10 +72,17 @@ typedef struct
 	uint32_t	compare;
 } ipfilter_t;
 
-#define	MAX_IPFILTERS	1024
+#define	MAX_IPFILTERS	1024		// default for maxipfilters
+#define	IPFILTER_MASKS	16			// one bit per octet that must match
+
+static ipfilter_t	*ipfilters;		// in the order they were added
+static int			numipfilters;
+static int			maxipfilters_alloc;
 
-ipfilter_t	ipfilters[MAX_IPFILTERS];
-int			numipfilters;
+static int			*ipfilter_hash;	// indexes into ipfilters, -1 for empty
+static int			ipfilter_hashsize;	// a power of 2, at least twice maxipfilters_alloc
+
+static int			ipfilter_maskcount[IPFILTER_MASKS];
 
 /*
 =================
@@ -96,7 +111,7 @@ static qboolean StringToFilter (char *s, ipfilter_t *f)
 		}
 		
 		j = 0;
-		while (*s >= '0' && *s <= '9')
+		while (*s >= '0' && *s <= '9' && j < sizeof(num)-1)
 		{
 			num[j++] = *s++;
 		}
@@ -116,6 +131,138 @@ static qboolean StringToFilter (char *s, ipfilter_t *f)
 	return true;
 }
 
+static int IPFilter_MaskIndex (uint32_t mask)
+{
+	byte	*m = (byte *)&mask;
+
+	return (m[0] ? 1 : 0) | (m[1] ? 2 : 0) | (m[2] ? 4 : 0) | (m[3] ? 8 : 0);
+}
+
+static uint32_t IPFilter_MaskFromIndex (int index)
+{
+	byte	m[4];
+
+	m[0] = (index & 1) ? 255 : 0;
+	m[1] = (index & 2) ? 255 : 0;
+	m[2] = (index & 4) ? 255 : 0;
+	m[3] = (index & 8) ? 255 : 0;
+	return *(uint32_t *)m;
+}
+
+static unsigned int IPFilter_Hash (uint32_t mask, uint32_t compare)
+{
+	unsigned int	hash;
+
+	hash = (compare ^ (mask * 2654435761u)) * 2654435761u;
+	return (hash ^ (hash >> 15)) & (ipfilter_hashsize - 1);
+}
+
+/*
+=================
+IPFilter_Find
+
+Index of the filter with exactly this mask and compare, or -1
+=================
+*/
+static int IPFilter_Find (uint32_t mask, uint32_t compare)
+{
+	unsigned int	slot;
+	int				i;
+
+	if (!ipfilter_hashsize)
+		return -1;
+
+	for (slot = IPFilter_Hash (mask, compare) ; (i = ipfilter_hash[slot]) >= 0 ; slot = (slot+1) & (ipfilter_hashsize-1))
+	{
+		if (ipfilters[i].mask == mask && ipfilters[i].compare == compare)
+			return i;
+	}
+	return -1;
+}
+
+static void IPFilter_Link (int index)
+{
+	unsigned int	slot;
+
+	slot = IPFilter_Hash (ipfilters[index].mask, ipfilters[index].compare);
+	while (ipfilter_hash[slot] >= 0)
+		slot = (slot+1) & (ipfilter_hashsize-1);
+	ipfilter_hash[slot] = index;
+	ipfilter_maskcount[IPFilter_MaskIndex (ipfilters[index].mask)]++;
+}
+
+static void IPFilter_Rehash (void)
+{
+	int		i;
+
+	for (i=0 ; i<ipfilter_hashsize ; i++)
+		ipfilter_hash[i] = -1;
+	memset (ipfilter_maskcount, 0, sizeof(ipfilter_maskcount));
+	for (i=0 ; i<numipfilters ; i++)
+		IPFilter_Link (i);
+}
+
+/*
+=================
+IPFilter_Reserve
+
+Makes room for count filters, up to maxipfilters
+=================
+*/
+static qboolean IPFilter_Reserve (int count)
+{
+	ipfilter_t	*list;
+	int			limit, size;
+
+	if (count <= maxipfilters_alloc)
+		return true;
+
+	limit = (maxipfilters && maxipfilters->value > 0) ? (int)maxipfilters->value : MAX_IPFILTERS;
+	if (count > limit)
+		return false;
+
+	size = maxipfilters_alloc ? maxipfilters_alloc : 64;
+	while (size < count)
+		size *= 2;
+	if (size > limit)
+		size = limit;
+
+	list = (ipfilter_t *)realloc (ipfilters, size * sizeof(ipfilter_t));
+	if (!list)
+		return false;
+	ipfilters = list;
+	maxipfilters_alloc = size;
+
+	free (ipfilter_hash);
+	for (ipfilter_hashsize = 64 ; ipfilter_hashsize < size*2 ; ipfilter_hashsize *= 2)
+		;
+	ipfilter_hash = (int *)malloc (ipfilter_hashsize * sizeof(int));
+	if (!ipfilter_hash)
+		gi.error ("IPFilter_Reserve: couldn't allocate %i hash slots", ipfilter_hashsize);
+	IPFilter_Rehash ();
+	return true;
+}
+
+/*
+=================
+IPFilter_Add
+
+Adds f unless it is already in the list. False if the list is full.
+=================
+*/
+static qboolean IPFilter_Add (ipfilter_t *f)
+{
+	if (IPFilter_Find (f->mask, f->compare) >= 0)
+		return true;
+	if (!IPFilter_Reserve (numipfilters + 1))
+		return false;
+
+	ipfilters[numipfilters] = *f;
+	IPFilter_Link (numipfilters);
+	numipfilters++;
+	return true;
+}
+
 /*
 =================
 SV_FilterPacket
@@ -124,12 +271,13 @@ SV_FilterPacket
 int SV_FilterPacket (char *from)
 {
 	int		i;
-	uint32_t	in;
+	uint32_t	in, mask;
 	byte m[4];
 	char *p;
 
 	i = 0;
 	p = from;
+	m[0] = m[1] = m[2] = m[3] = 0;
 	while (*p && i < 4) {
 		m[i] = 0;
 		while (*p >= '0' && *p <= '9') {
@@ -143,9 +291,14 @@ int SV_FilterPacket (char *from)
 	
 	in = *(uint32_t *)m;
 
-	for (i=0 ; i<numipfilters ; i++)
-		if ( (in & ipfilters[i].mask) == ipfilters[i].compare)
+	for (i=0 ; i<IPFILTER_MASKS ; i++)
+	{
+		if (!ipfilter_maskcount[i])
+			continue;
+		mask = IPFilter_MaskFromIndex (i);
+		if (IPFilter_Find (mask, in & mask) >= 0)
 			return (int)filterban->value;
+	}
 
 	return (int)!filterban->value;
 }
@@ -158,28 +311,18 @@ SV_AddIP_f
 */
 void SVCmd_AddIP_f (void)
 {
-	int		i;
-	
+	ipfilter_t	f;
+
 	if (gi.argc() < 3) {
 		safe_cprintf(NULL, PRINT_HIGH, "Usage:  addip <ip-mask>\n");
 		return;
 	}
 
-	for (i=0 ; i<numipfilters ; i++)
-		if (ipfilters[i].compare == 0xffffffff)
-			break;		// free spot
-	if (i == numipfilters)
-	{
-		if (numipfilters == MAX_IPFILTERS)
-		{
-			safe_cprintf (NULL, PRINT_HIGH, "IP filter list is full\n");
-			return;
-		}
-		numipfilters++;
-	}
-	
-	if (!StringToFilter (gi.argv(2), &ipfilters[i]))
-		ipfilters[i].compare = 0xffffffff;
+	if (!StringToFilter (gi.argv(2), &f))
+		return;
+
+	if (!IPFilter_Add (&f))
+		safe_cprintf (NULL, PRINT_HIGH, "IP filter list is full\n");
 }
 
 /*
@@ -200,16 +343,16 @@ void SVCmd_RemoveIP_f (void)
 	if (!StringToFilter (gi.argv(2), &f))
 		return;
 
-	for (i=0 ; i<numipfilters ; i++)
-		if (ipfilters[i].mask == f.mask
-		&& ipfilters[i].compare == f.compare)
-		{
-			for (j=i+1 ; j<numipfilters ; j++)
-				ipfilters[j-1] = ipfilters[j];
-			numipfilters--;
-			safe_cprintf (NULL, PRINT_HIGH, "Removed.\n");
-			return;
-		}
+	i = IPFilter_Find (f.mask, f.compare);
+	if (i >= 0)
+	{
+		for (j=i+1 ; j<numipfilters ; j++)
+			ipfilters[j-1] = ipfilters[j];
+		numipfilters--;
+		IPFilter_Rehash ();
+		safe_cprintf (NULL, PRINT_HIGH, "Removed.\n");
+		return;
+	}
 	safe_cprintf (NULL, PRINT_HIGH, "Didn't find %s.\n", gi.argv(2));
 }
 
@@ -231,6 +374,18 @@ void SVCmd_ListIP_f (void)
 	}
 }
 
+static void SVCmd_IPFileName (char *name, int size, char *filename)
+{
+	cvar_t	*game;
+
+	game = gi.cvar("game", "", 0);
+
+	if (!*game->string)
+		Com_sprintf (name, size, "%s/%s", GAMEVERSION, filename);
+	else
+		Com_sprintf (name, size, "%s/%s", game->string, filename);
+}
+
 /*
 =================
 SV_WriteIP_f
@@ -242,14 +397,8 @@ void SVCmd_WriteIP_f (void)
 	char	name[MAX_OSPATH];
 	byte	b[4];
 	int		i;
-	cvar_t	*game;
-
-	game = gi.cvar("game", "", 0);
 
-	if (!*game->string)
-		sprintf (name, "%s/listip.cfg", GAMEVERSION);
-	else
-		sprintf (name, "%s/listip.cfg", game->string);
+	SVCmd_IPFileName (name, sizeof(name), "listip.cfg");
 
 	safe_cprintf (NULL, PRINT_HIGH, "Writing %s.\n", name);
 
@@ -271,6 +420,67 @@ void SVCmd_WriteIP_f (void)
 	fclose (f);
 }
 
+/*
+=================
+SV_LoadIP_f
+
+"sv loadip [file]" reads the lines writeip writes without going
+through the command buffer
+=================
+*/
+void SVCmd_LoadIP_f (void)
+{
+	FILE		*f;
+	char		name[MAX_OSPATH];
+	char		line[256];
+	char		*p, *addr;
+	ipfilter_t	filter;
+	int			added, before;
+
+	SVCmd_IPFileName (name, sizeof(name), (gi.argc() > 2) ? gi.argv(2) : "listip.cfg");
+
+	f = fopen (name, "r");
+	if (!f)
+	{
+		safe_cprintf (NULL, PRINT_HIGH, "Couldn't open %s\n", name);
+		return;
+	}
+
+	before = numipfilters;
+	added = 0;
+	while (fgets (line, sizeof(line), f))
+	{
+		for (p = line ; *p == ' ' || *p == '\t' ; p++)
+			;
+		if (!Q_strncasecmp (p, "set filterban ", 14))
+		{
+			gi.cvar_set ("filterban", va("%i", atoi(p + 14)));
+			continue;
+		}
+		if (!Q_strncasecmp (p, "sv ", 3))
+			p += 3;
+		if (Q_strncasecmp (p, "addip ", 6))
+			continue;
+		for (addr = p + 6 ; *addr == ' ' || *addr == '\t' ; addr++)
+			;
+		for (p = addr ; *p && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n' ; p++)
+			;
+		*p = 0;
+
+		if (!StringToFilter (addr, &filter))
+			continue;
+		if (!IPFilter_Add (&filter))
+		{
+			safe_cprintf (NULL, PRINT_HIGH, "IP filter list is full\n");
+			break;
+		}
+		added++;
+	}
+	fclose (f);
+
+	safe_cprintf (NULL, PRINT_HIGH, "Read %i filters from %s, %i new.\n", added, name, numipfilters - before);
+}
+
 /*
 =================
 ServerCommand
@@ -295,6 +505,25 @@ void	ServerCommand (void)
 		SVCmd_ListIP_f ();
 	else if (Q_strcasecmp (cmd, "writeip") == 0)
 		SVCmd_WriteIP_f ();
+	else if (Q_strcasecmp (cmd, "loadip") == 0)
+		SVCmd_LoadIP_f ();
+	else if (Q_strcasecmp (cmd, "edictstats") == 0)
+		Svcmd_EdictStats_f ();
+	else if (Q_strcasecmp (cmd, "edicts") == 0)
+		Svcmd_Edicts_f ();
+	else if (Q_strcasecmp (cmd, "restartlevel") == 0)
+	{
+		if (!RestartLevel ())
+			safe_cprintf (NULL, PRINT_HIGH, "No restart image for this level.\n");
+	}
+	else if (Q_strcasecmp (cmd, "pushstats") == 0)
+		Svcmd_PushStats_f ();
+	else if (Q_strcasecmp (cmd, "profile") == 0)
+		Svcmd_Profile_f ();
+	else if (Q_strcasecmp (cmd, "tracestats") == 0)
+		Svcmd_TraceStats_f ();
+	else if (Q_strcasecmp (cmd, "cmdlog") == 0)
+		Svcmd_CmdLog_f ();
 
 // ACEBOT_ADD
 	else if(Q_strcasecmp (cmd, "acedebug") == 0)
@@ -328,6 +557,9 @@ void	ServerCommand (void)
 	// Node saving
 	else if(Q_strcasecmp (cmd, "savenodes") == 0)
     	ACEND_SaveNodes();
+	// Node generation
+	else if(Q_strcasecmp (cmd, "acegen") == 0)
+		ACEND_GenerateNodes();
 // ACEBOT_END
 	// Knightmare added- DM pause
     else if(Q_strcasecmp (cmd, "dmpause") == 0)
@@ -134,13 +134,12 @@ void SP_target_speaker (edict_t *ent)
 		//      via trigger_transition
 		if (!strstr (st.noise, ".wav"))
 		{
-			ent->message = (char*)gi.TagMalloc(strlen(st.noise)+5,TAG_LEVEL);
+			ent->message = (char*)G_LevelAlloc(strlen(st.noise)+5);
 			sprintf(ent->message,"%s.wav", st.noise);
 		}
 		else
 		{
-			ent->message = (char*)gi.TagMalloc(strlen(st.noise)+1,TAG_LEVEL);
-			strcpy(ent->message,st.noise);
+			ent->message = G_LevelString(st.noise);
 		}
 	}
 	ent->class_id = ENTITY_TARGET_SPEAKER;
@@ -526,12 +525,12 @@ void use_target_changelevel (edict_t *self, edict_t *other, edict_t *activator)
 			}
 			//Knightmare- always have null weapon
 			if (!deathmatch->value)
-				activator->client->pers.inventory[ITEM_INDEX(FindItem("No Weapon"))] = 1;
+				activator->client->pers.inventory[noweapon_index] = 1;
 			// Switch to blaster
-			if ( activator->client->pers.inventory[ITEM_INDEX(FindItem("blaster"))] )
-				activator->client->newweapon = FindItem ("blaster");
+			if ( activator->client->pers.inventory[blaster_index] )
+				activator->client->newweapon = &itemlist[blaster_index];
 			else
-				activator->client->newweapon = FindItem ("No Weapon");
+				activator->client->newweapon = &itemlist[noweapon_index];
 			ChangeWeapon(activator);
 			activator->client->pers.health = activator->health = 100;
 		}
@@ -633,19 +632,17 @@ For gibs:
 	will just be dropped
 */
 
-void ED_CallSpawn (edict_t *ent);
-
 void use_target_spawner (edict_t *self, edict_t *other, edict_t *activator)
 {
 	edict_t	*ent;
 
-	ent = G_Spawn();
+	ent = G_SpawnTagged("target_spawner");
 	ent->classname = self->target;
 	ent->spawnflags = self->spawnflags;
 	ent->flags = self->flags;
 	VectorCopy (self->s.origin, ent->s.origin);
 	VectorCopy (self->s.angles, ent->s.angles);
-	ED_CallSpawn (ent);
+	ED_SpawnPrototype (ent);
 
 	if (ent && ent->inuse) // catch spawn failure
 	{
@@ -1427,6 +1424,7 @@ message		two letters; starting lightlevel and ending lightlevel
 void target_lightramp_think (edict_t *self)
 {
 	char	style[2];
+	char	*current;
 
 	if(self->spawnflags & LIGHTRAMP_CUSTOM) {
 		if(self->movedir[2] > 0)
@@ -1438,7 +1436,15 @@ void target_lightramp_think (edict_t *self)
 		style[0] = 'a' + self->movedir[0] + (level.time - self->timestamp) / FRAMETIME * self->movedir[2];
 	}
 	style[1] = 0;
-	gi.configstring (CS_LIGHTS+self->enemy->style, style);
+
+	// With lightramp_step above 1, a plain ramp only sends a letter that many
+	// steps from the last one sent, and always its last letter
+	current = NULL;
+	if (!(self->spawnflags & LIGHTRAMP_CUSTOM) && (lightramp_step->value > 1) &&
+		((level.time - self->timestamp) < self->speed))
+		current = G_LightStyle (self->enemy->style);
+	if (!current || !current[0] || current[1] || (abs(style[0] - current[0]) >= lightramp_step->value))
+		G_SetLightStyle (self->enemy->style, style);
 
 	if(self->spawnflags & LIGHTRAMP_CUSTOM) {
 		if((self->movedir[0] <= self->movedir[1]) ||
@@ -1602,7 +1608,8 @@ void target_earthquake_think (edict_t *self)
 		self->last_move_time = level.time + 0.5;
 	}
 
-	for (i=1, e=g_edicts+i; i < globals.num_edicts; i++,e++)
+	// only clients get shaken, and they all live in the first slots
+	for (i=1, e=g_edicts+i; i <= game.maxclients; i++,e++)
 	{
 		if (!e->inuse)
 			continue;
@@ -2004,7 +2011,7 @@ void ThrowRock (edict_t *self, char *modelname, float speed, vec3_t origin, vec3
 	edict_t	*chunk;
 	vec_t	var = speed/5;
 
-	chunk = G_Spawn();
+	chunk = G_SpawnTagged("ThrowRock");
 	VectorCopy (origin, chunk->s.origin);
 	gi.setmodel (chunk, modelname);
 	VectorCopy(size,chunk->maxs);
@@ -2237,13 +2244,7 @@ moving in (movedir) direction.
 //=========================================================================
 void target_effect_splash (edict_t *self, edict_t *activator)
 {
-	gi.WriteByte(svc_temp_entity);
-	gi.WriteByte(self->style);
-	gi.WriteByte(self->count);
-	gi.WritePosition(self->s.origin);
-	gi.WriteDir(self->movedir);
-	gi.WriteByte(self->sounds);
-	gi.multicast(self->s.origin, MULTICAST_PVS);
+	G_TempSplash (self->style, self->count, self->s.origin, self->movedir, self->sounds);
 }
 
 //======================================================
@@ -2339,12 +2340,7 @@ Broadcasts to all in Potentially Visible Set from vector (origin)
 //======================================================
 void target_effect_sparks (edict_t *self, edict_t *activator)
 {
-	gi.WriteByte(svc_temp_entity);
-	gi.WriteByte(self->style);
-	gi.WritePosition(self->s.origin);
-	if(self->style != TE_CHAINFIST_SMOKE) 
-		gi.WriteDir(self->movedir);
-	gi.multicast(self->s.origin, MULTICAST_PVS);
+	G_TempImpact (self->style, self->s.origin, (self->style != TE_CHAINFIST_SMOKE) ? self->movedir : NULL);
 
 	if(level.num_reflectors)
 		ReflectSparks(self->style,self->s.origin,self->movedir);
@@ -2377,10 +2373,7 @@ Potentially Hearable set from vector (origin)
 //==============================================================================
 void target_effect_explosion (edict_t *self, edict_t *activator)
 {
-	gi.WriteByte(svc_temp_entity);
-	gi.WriteByte(self->style);
-	gi.WritePosition(self->s.origin);
-	gi.multicast(self->s.origin, MULTICAST_PHS);
+	G_TempPoint (self->style, self->s.origin, MULTICAST_PHS);
 
 	if (level.num_reflectors)
 		ReflectExplosion (self->style, self->s.origin);
@@ -2451,7 +2444,7 @@ void target_effect_use(edict_t *self, edict_t *other, edict_t *activator)
 void target_effect_think(edict_t *self)
 {
 	self->play(self,NULL);
-	self->nextthink = level.time + self->wait;
+	self->nextthink = level.time + Gov_Interval(self->wait);
 }
 //===============================================================================
 void SP_target_effect (edict_t *self)
@@ -2600,78 +2593,163 @@ void SP_target_effect (edict_t *self)
 #define ATTRACTOR_SINGLE     32
 #define ATTRACTOR_PATHTARGET 64
 
+// A monster's origin can sit this far from the middle of its box, which
+// is what G_FindRadiusBatch measures from
+#define ATTRACTOR_SLOP        128
+// Sight to a monster is retraced every few frames, and no more than
+// ATTRACTOR_TRACES of those per attractor per frame. Players are always
+// traced, so they can duck out of sight.
+#define ATTRACTOR_SIGHT_FRAMES 3
+#define ATTRACTOR_TRACES       8
+
+typedef struct
+{
+	short	attractor;
+	qboolean visible;
+	int		framenum;		// level.framenum + 1 of the trace, 0 if none
+} attractsight_t;
+
+static attractsight_t	attractor_sight[MAX_EDICTS];
+
+/*
+=================
+attractor_candidates
+
+Fills list, in edict order, with the living players and/or monsters a
+PLAYER or MONSTER attractor might pull this frame. With a distance set,
+monsters come from the area tree around the attractor instead of a
+sweep over every edict. num_targets is only ever tested for zero, and
+is non-zero if anything the attractor could pull is still alive.
+=================
+*/
+static int attractor_candidates (edict_t *self, edict_t **list, int *num_targets)
+{
+	edict_t	*ent;
+	int		i, num, count = 0;
+	qboolean radius;
+
+	if(self->spawnflags & ATTRACTOR_PLAYER) {
+		for(i=1, ent=&g_edicts[i]; i<=game.maxclients; i++, ent++) {
+			if(!ent->inuse) continue;
+			if(ent->health <= 0) continue;
+			list[count++] = ent;
+		}
+	}
+	*num_targets = count;
+	if(!(self->spawnflags & ATTRACTOR_MONSTER))
+		return count;
+
+	radius = (self->moveinfo.distance < 8192);
+	if(radius)
+		num = G_FindRadiusBatch(self->s.origin, self->moveinfo.distance + ATTRACTOR_SLOP, list+count, MAX_EDICTS-count);
+	else
+		num = 0;
+	for(i=0; i<num; i++) {
+		ent = list[count+i];
+		if(!(ent->svflags & SVF_MONSTER)) continue;
+		if(ent->health <= 0) continue;
+		if(ent->client && (self->spawnflags & ATTRACTOR_PLAYER)) continue;
+		list[count++] = ent;
+	}
+	*num_targets = count;
+	if(radius && count)
+		return count;
+
+	for(i=1, ent=&g_edicts[i]; i<globals.num_edicts; i++, ent++) {
+		if(!ent->inuse) continue;
+		if(ent->health <= 0) continue;
+		if(!(ent->svflags & SVF_MONSTER)) continue;
+		if(ent->client && (self->spawnflags & ATTRACTOR_PLAYER)) continue;
+		if(radius) {
+			// only need to know one is left somewhere
+			*num_targets = 1;
+			break;
+		}
+		list[count++] = ent;
+	}
+	if(!radius)
+		*num_targets = count;
+	return count;
+}
+
+/*
+=================
+attractor_sees
+
+SIGHT check from the attractor to end, remembered per target for a few
+frames. budget is how many more traces this think may make; a monster
+past the budget keeps its last answer, or is out of sight if it has
+none yet.
+=================
+*/
+static qboolean attractor_sees (edict_t *self, edict_t *target, vec3_t end, int *budget)
+{
+	attractsight_t	*memo = &attractor_sight[target - g_edicts];
+	trace_t			tr;
+	qboolean		known;
+
+	if(!target->client) {
+		known = (memo->attractor == self - g_edicts) && memo->framenum && (memo->framenum <= level.framenum + 1);
+		if(known && (level.framenum + 1 - memo->framenum < ATTRACTOR_SIGHT_FRAMES))
+			return memo->visible;
+		if(*budget <= 0)
+			return known ? memo->visible : false;
+		(*budget)--;
+	}
+	tr = gi.trace(self->s.origin,vec3_origin,vec3_origin,end,NULL,MASK_OPAQUE | MASK_SHOT);
+	memo->attractor = self - g_edicts;
+	memo->visible   = (tr.ent == target);
+	memo->framenum  = level.framenum + 1;
+	return memo->visible;
+}
+
 void target_attractor_think_single (edict_t *self)
 {
 	edict_t	*ent, *target, *previous_target;
-	trace_t	tr;
 	vec3_t	dir, targ_org;
 	vec_t	dist, speed;
 	vec_t	best_dist;
 	vec3_t	forward, right;
-	int		i;
+	int		i, num, budget;
 	int		num_targets = 0;
+	edict_t	*list[MAX_EDICTS];
 	
 	if(!self->spawnflags & ATTRACTOR_ON) return;
 
 	previous_target = self->target_ent;
 	target      = NULL;
 	best_dist   = 8192;
+	budget      = ATTRACTOR_TRACES;
 
-	if(self->spawnflags & ATTRACTOR_PLAYER) {
-		for(i=1, ent=&g_edicts[i]; i<=game.maxclients; i++, ent++) {
-			if(!ent->inuse) continue;
-			if(ent->health <= 0) continue;
-			num_targets++;
+	if(self->spawnflags & (ATTRACTOR_PLAYER | ATTRACTOR_MONSTER)) {
+		num = attractor_candidates(self, list, &num_targets);
+		for(i=0; i<num; i++) {
+			ent = list[i];
 			VectorSubtract(self->s.origin,ent->s.origin,dir);
 			dist = VectorLength(dir);
 			if(dist > self->moveinfo.distance) continue;
+			if(dist >= best_dist) continue;
 			if(self->spawnflags & ATTRACTOR_SIGHT) {
-				tr = gi.trace(self->s.origin,vec3_origin,vec3_origin,ent->s.origin,NULL,MASK_OPAQUE | MASK_SHOT);
-				if(tr.ent != ent) continue;
-			}
-			if(dist < best_dist) {
-				best_dist = dist;
-				target = ent;
-			}
-		}
-	}
-	if(self->spawnflags & ATTRACTOR_MONSTER) {
-		for(i=1, ent=&g_edicts[i]; i<=globals.num_edicts; i++, ent++) {
-			if(!ent->inuse) continue;
-			if(ent->health <= 0) continue;
-			if(!(ent->svflags & SVF_MONSTER)) continue;
-			num_targets++;
-			VectorSubtract(self->s.origin,ent->s.origin,dir);
-			dist = VectorLength(dir);
-			if(dist > self->moveinfo.distance) continue;
-			if(self->spawnflags & ATTRACTOR_SIGHT) {
-				tr = gi.trace(self->s.origin,vec3_origin,vec3_origin,ent->s.origin,NULL,MASK_OPAQUE | MASK_SHOT);
-				if(tr.ent != ent) continue;
-			}
-			if(dist < best_dist) {
-				best_dist = dist;
-				target = ent;
+				if(!attractor_sees(self, ent, ent->s.origin, &budget)) continue;
 			}
+			best_dist = dist;
+			target = ent;
 		}
 	}
 	if(!(self->spawnflags & (ATTRACTOR_PLAYER | ATTRACTOR_MONSTER))) {
-		ent = G_Find(NULL,FOFS(targetname),self->target);
-		while(ent) {
+		for(ent = G_Find(NULL,FOFS(targetname),self->target); ent; ent = G_Find(ent,FOFS(targetname),self->target)) {
 			if(!ent->inuse) continue;
 			num_targets++;
 			VectorAdd(ent->s.origin,ent->origin_offset,targ_org);
 			VectorSubtract(self->s.origin,targ_org,dir);
 			dist = VectorLength(dir);
 			if(dist > self->moveinfo.distance) continue;
+			if(dist >= best_dist) continue;
 			if(self->spawnflags & ATTRACTOR_SIGHT) {
-				tr = gi.trace(self->s.origin,vec3_origin,vec3_origin,targ_org,NULL,MASK_OPAQUE | MASK_SHOT);
-				if(tr.ent != ent) continue;
-			}
-			if(dist < best_dist) {
-				best_dist = dist;
-				target = ent;
+				if(!attractor_sees(self, ent, targ_org, &budget)) continue;
 			}
-			ent = G_Find(ent,FOFS(targetname),self->target);
+			best_dist = dist;
+			target = ent;
 		}
 	}
 	self->target_ent = target;
@@ -2794,13 +2872,13 @@ void target_attractor_think_single (edict_t *self)
 void target_attractor_think(edict_t *self)
 {
 	edict_t	*ent, *target;
-	trace_t	tr;
 	vec3_t	dir, targ_org;
 	vec_t	dist, speed;
 	vec3_t	forward, right;
 	int		i;
-	int		ent_start;
+	int		n, num, budget;
 	int		num_targets = 0;
+	edict_t	*list[MAX_EDICTS];
 
 	if(!self->spawnflags & ATTRACTOR_ON) return;
 
@@ -2811,46 +2889,37 @@ void target_attractor_think(edict_t *self)
 			self->moveinfo.speed = max(self->speed, self->moveinfo.speed + self->accel);
 	}
 
-	target = NULL;
-	ent_start = 1;
-	while(true)
+	// gather everything to pull first, so it takes one pass however
+	// many there are
+	if(self->spawnflags & (ATTRACTOR_PLAYER | ATTRACTOR_MONSTER))
+		num = attractor_candidates(self, list, &num_targets);
+	else {
+		num = 0;
+		for(ent = G_Find(NULL,FOFS(targetname),self->target); ent && num < MAX_EDICTS; ent = G_Find(ent,FOFS(targetname),self->target)) {
+			if(!ent->inuse) continue;
+			if( ((ent->client) || (ent->svflags & SVF_MONSTER)) && (ent->health <= 0)) continue;
+			list[num++] = ent;
+		}
+		num_targets = num;
+	}
+
+	budget = ATTRACTOR_TRACES;
+	for(n=0; n<num; n++)
 	{
-		if(self->spawnflags & (ATTRACTOR_PLAYER | ATTRACTOR_MONSTER))
-		{
-			target = NULL;
-			for(i=ent_start, ent=&g_edicts[ent_start];i<globals.num_edicts && !target; i++, ent++)
-			{
-				if((self->spawnflags & ATTRACTOR_PLAYER) && ent->client && ent->inuse)
-				{
-					target = ent;
-					ent_start = i+1;
-					continue;
-				}
-				if((self->spawnflags & ATTRACTOR_MONSTER) && (ent->svflags & SVF_MONSTER) && (ent->inuse))
-				{
-					target = ent;
-					ent_start = i+1;
-				}
-			}
-		} else
-			target = G_Find(target,FOFS(targetname),self->target);
-		if(!target) break;
+		target = list[n];
 		if(!target->inuse) continue;
-		if( ((target->client) || (target->svflags & SVF_MONSTER)) && (target->health <= 0)) continue;
-		num_targets++;
-		
+
 		VectorAdd(target->s.origin,target->origin_offset,targ_org);
 		VectorSubtract(self->s.origin,targ_org,dir);
 		dist = VectorLength(dir);
 
-		if(self->spawnflags & ATTRACTOR_SIGHT) {
-			tr = gi.trace(self->s.origin,vec3_origin,vec3_origin,target->s.origin,NULL,MASK_OPAQUE | MASK_SHOT);
-			if(tr.ent != target) continue;
-		}
-
 		if(readout->value) gi.dprintf("distance=%g, pull speed=%g\n",dist,self->moveinfo.speed);
 		if(dist > self->moveinfo.distance)
 			continue;
+
+		if(self->spawnflags & ATTRACTOR_SIGHT) {
+			if(!attractor_sees(self, target, target->s.origin, &budget)) continue;
+		}
 		
 		if((self->pathtarget) && (self->spawnflags & ATTRACTOR_PATHTARGET))
 		{
@@ -3074,8 +3143,7 @@ void target_monitor_off (edict_t *self)
 	}
 	faker = player->client->camplayer;
 	VectorCopy(faker->s.origin,player->s.origin);
-	G_Free(faker->client); 
-	G_FreeEdict (faker); 
+	PoolCamPlayer (player, faker);
 	player->client->ps.pmove.origin[0] = player->s.origin[0]*8;
 	player->client->ps.pmove.origin[1] = player->s.origin[1]*8;
 	player->client->ps.pmove.origin[2] = player->s.origin[2]*8;
@@ -3185,7 +3253,6 @@ void use_target_monitor (edict_t *self, edict_t *other, edict_t *activator)
 	int			i;
 	edict_t		*faker;
 	edict_t		*monster;
-	gclient_t	*cl;
 
 	if (!activator->client)
 		return;
@@ -3214,7 +3281,7 @@ void use_target_monitor (edict_t *self, edict_t *other, edict_t *activator)
 	VectorCopy(activator->client->v_angle,activator->client->org_viewangles);
 
 	// create a fake player to stand in real player's position
-	faker = activator->client->camplayer = G_Spawn();
+	faker = activator->client->camplayer = GetCamPlayer (activator);
 	faker->s.frame = activator->s.frame; 
 	VectorCopy (activator->s.origin, faker->s.origin); 
 	VectorCopy (activator->velocity, faker->velocity); 
@@ -3238,9 +3305,7 @@ void use_target_monitor (edict_t *self, edict_t *other, edict_t *activator)
 	faker->nextthink    = level.time + FRAMETIME;
 	VectorCopy(activator->mins,faker->mins);
 	VectorCopy(activator->maxs,faker->maxs);
-    // create a client so you can pick up items/be shot/etc while in camera
-	cl = (gclient_t *) G_Malloc(sizeof(gclient_t)); 
-	faker->client = cl; 
+    // the client from GetCamPlayer lets you pick up items/be shot/etc while in camera
 	faker->target_ent = activator;
 	gi.linkentity (faker); 
 
@@ -3524,7 +3589,7 @@ void SP_target_animation (edict_t *self)
 			self->framenumbers = 1;
 	}
 	self->use = target_animation_use;
-	move = (mmove_t*)gi.TagMalloc(sizeof(mmove_t), TAG_LEVEL);
+	move = (mmove_t*)G_LevelAlloc(sizeof(mmove_t));
 	self->monsterinfo.currentmove = move;
 }
 
@@ -3601,7 +3666,7 @@ void target_failure_fade_lights (edict_t *self)
 
 	lightvalue[0] = values[self->flags];
 	lightvalue[1] = 0;
-	gi.configstring(CS_LIGHTS+0, lightvalue);
+	G_SetLightStyle(0, lightvalue);
 	if(self->flags)
 	{
 		self->flags--;
@@ -3698,12 +3763,15 @@ void use_target_change (edict_t *self, edict_t *other, edict_t *activator)
 	while(target_ent)
 	{
 		if(newtarget && strlen(newtarget))
-			target_ent->target = G_CopyString(newtarget);
+			target_ent->target = G_LevelString(newtarget);
 		if(self->newtargetname && strlen(self->newtargetname))
-			target_ent->targetname = G_CopyString(self->newtargetname);
+		{
+			target_ent->targetname = G_LevelString(self->newtargetname);
+			G_IndexEdict(target_ent);
+		}
 		if(self->team && strlen(self->team))
 		{
-			target_ent->team = G_CopyString(self->team);
+			target_ent->team = G_LevelString(self->team);
 			newteams++;
 		}
 		if(VectorLength(self->s.angles))
@@ -3713,13 +3781,13 @@ void use_target_change (edict_t *self, edict_t *other, edict_t *activator)
 				G_SetMovedir (target_ent->s.angles, target_ent->movedir);
 		}
 		if(self->deathtarget && strlen(self->deathtarget))
-			target_ent->deathtarget = G_CopyString(self->deathtarget);
+			target_ent->deathtarget = G_LevelString(self->deathtarget);
 		if(self->pathtarget && strlen(self->pathtarget))
-			target_ent->pathtarget = G_CopyString(self->pathtarget);
+			target_ent->pathtarget = G_LevelString(self->pathtarget);
 		if(self->killtarget && strlen(self->killtarget))
-			target_ent->killtarget = G_CopyString(self->killtarget);
+			target_ent->killtarget = G_LevelString(self->killtarget);
 		if(self->message && strlen(self->message))
-			target_ent->message = G_CopyString(self->message);
+			target_ent->message = G_CopyString(self->message);	// func_clock reallocates its message
 		if(self->delay > 0)
 			target_ent->delay = self->delay;
 		if(self->dmg > 0)
@@ -3794,16 +3862,7 @@ void SP_target_change (edict_t *self)
 
 void movewith_detach (edict_t *child)
 {
-	edict_t	*e;
-	edict_t	*parent=NULL;
-	int		i;
-				
-	for(i=1; i<globals.num_edicts && !parent; i++) {
-		e = g_edicts + i;
-		if(e->movewith_next == child) parent=e;
-	}
-	if(parent) parent->movewith_next = child->movewith_next;
-		
+	movewith_unlink (child);
 	child->movewith_next = NULL;
 	child->movewith = NULL;
 	child->movetype = child->org_movetype;
@@ -3864,7 +3923,7 @@ void use_target_movewith (edict_t *self, edict_t *other, edict_t *activator)
 					previous = e;
 					e = previous->movewith_next;
 				}
-				previous->movewith_next = target;
+				movewith_link (previous, target);
 				gi.linkentity(target);
 			}
 			target = G_Find(target,FOFS(targetname),self->target);
@@ -4000,8 +4059,7 @@ void SP_target_sky (edict_t *self)
 		G_FreeEdict(self);
 		return;
 	}
-	self->pathtarget = (char*)gi.TagMalloc(strlen(st.sky)+1,TAG_LEVEL);
-	strcpy(self->pathtarget,st.sky);
+	self->pathtarget = G_LevelString(st.sky);
 	self->use = use_target_sky;
 }
 
@@ -4072,9 +4130,8 @@ void clone (edict_t *self, edict_t *other, edict_t *activator)
 	parent = G_Find(NULL,FOFS(targetname),self->source);
 	if(!parent)
 		return;
-	child = G_Spawn();
-	child->classname = (char*)gi.TagMalloc(strlen(parent->classname)+1,TAG_LEVEL);
-	strcpy(child->classname,parent->classname);
+	child = G_SpawnTagged("target_clone");
+	child->classname = G_LevelString(parent->classname);
 	child->s.modelindex = parent->s.modelindex;
 	VectorCopy(self->s.origin,child->s.origin);
 	child->svflags    = parent->svflags;
@@ -4083,21 +4140,24 @@ void clone (edict_t *self, edict_t *other, edict_t *activator)
 	VectorCopy(parent->size,child->size);
 
 	if(self->newtargetname && strlen(self->newtargetname))
-		child->targetname = G_CopyString(self->newtargetname);
+	{
+		child->targetname = G_LevelString(self->newtargetname);
+		G_IndexEdict(child);
+	}
 	if(self->team && strlen(self->team))
 	{
-		child->team = G_CopyString(self->team);
+		child->team = G_LevelString(self->team);
 		newteams++;
 	}
 	if(self->target && strlen(self->target))
-		child->target = G_CopyString(self->target);
+		child->target = G_LevelString(self->target);
 
 	if(parent->deathtarget && strlen(parent->deathtarget))
-		child->deathtarget = G_CopyString(parent->deathtarget);
+		child->deathtarget = G_LevelString(parent->deathtarget);
 	if(parent->destroytarget && strlen(parent->destroytarget))
-		child->destroytarget = G_CopyString(parent->destroytarget);
+		child->destroytarget = G_LevelString(parent->destroytarget);
 	if(parent->killtarget && strlen(parent->killtarget))
-		child->killtarget = G_CopyString(parent->killtarget);
+		child->killtarget = G_LevelString(parent->killtarget);
 
 	child->solid        = parent->solid;
 	child->clipmask     = parent->clipmask;
@@ -4264,10 +4324,9 @@ void clone (edict_t *self, edict_t *other, edict_t *activator)
 			speaker->volume      = 1;
 			speaker->attenuation = child->attenuation; // was 1
 			speaker->owner       = child;
-			speaker->think       = Moving_Speaker_Think;
-			speaker->nextthink   = level.time + 2*FRAMETIME;
 			speaker->spawnflags  = 7;       // owner must be moving to play
 			child->speaker        = speaker;
+			G_AttachSpeaker (speaker);
 			if(VectorLength(child->s.origin))
 				VectorCopy(child->s.origin,speaker->s.origin);
 			else {
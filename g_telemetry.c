@@ -0,0 +1,476 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include "g_local.h"
+
+/*
+==============================================================================
+
+TELEMETRY
+
+With sv_telemetry set to "host:port", a worker thread sends statsd
+gauge lines over UDP once a second, each named sv_telemetry_prefix
+followed by:
+
+  frame.mean, frame.p50, frame.p95, frame.p99, frame.max
+                      G_RunFrame milliseconds over the second
+  frames              frames run in the second
+  edicts, edicts_inuse
+                      num_edicts, and how many of those are in use
+  clients, bots       players in the game, and how many are bots
+  traces              traces in the second
+  reliable_bytes, reliable_sends
+                      reliable gi.unicast traffic in the second (menus,
+                      fog, the HUD layouts)
+  saves, save.max     level saves in the second, and the most
+                      milliseconds the frame thread spent on one
+  dropped             seconds lost because the worker fell behind
+
+The frame thread only times itself and, once a second, fills in the
+next telrecord_t of a fixed ring. It never allocates, blocks or makes
+a system call other than the clock. The ring has one writer and one
+reader: the frame thread only moves tel_head and the worker only moves
+tel_tail, each after a barrier, so neither side takes a lock. When the
+ring is full the second is dropped and counted in the next one.
+
+The worker resolves the address, formats the lines and sends them on
+a non-blocking socket, so a dead collector costs nothing. Changing
+sv_telemetry stops the worker and starts a new one; clearing it stops
+it.
+
+==============================================================================
+*/
+
+#define	TEL_RING		16			// seconds queued for the worker
+#define	TEL_SAMPLES		64			// frame times kept per second
+#define	TEL_PACKET		1400
+
+#ifdef _WIN32
+#define	TEL_BARRIER()	MemoryBarrier()
+#else
+#define	TEL_BARRIER()	__sync_synchronize()
+#endif
+
+typedef struct
+{
+	int		frames;
+	float	mean, p50, p95, p99, max;
+	int		num_edicts, edicts_inuse;
+	int		clients, bots;
+	int		traces;
+	int		reliable_bytes, reliable_sends;
+	int		saves;
+	float	save_max;
+	int		dropped;
+} telrecord_t;
+
+static telrecord_t	tel_ring[TEL_RING];
+static volatile int	tel_head;			// next record the frame thread fills
+static volatile int	tel_tail;			// next record the worker sends
+static volatile int	tel_quit;
+
+static qboolean		tel_running;
+static char			tel_address[MAX_QPATH];
+static char			tel_prefix[MAX_QPATH];
+
+#ifdef _WIN32
+static HANDLE		tel_thread;
+#else
+static pthread_t	tel_thread;
+#endif
+
+// the second being collected, frame thread only
+static double		tel_frame_start;
+static double		tel_second_start;
+static float		tel_msec[TEL_SAMPLES];
+static int			tel_frames;
+static float		tel_total;
+static float		tel_max;
+static int			tel_saves;
+static float		tel_save_max;
+static int			tel_dropped;
+static int			tel_last_traces;
+static int			tel_last_bytes;
+static int			tel_last_sends;
+
+/*
+==============================================================================
+
+WORKER THREAD
+
+==============================================================================
+*/
+
+static int Tel_Print (char *out, int size, char *fmt, ...)
+{
+	va_list	argptr;
+	int		len;
+
+	if (size <= 0)
+		return 0;
+	va_start (argptr, fmt);
+	len = Q_vsnprintf (out, size, fmt, argptr);
+	va_end (argptr);
+	if (len < 0 || len >= size)
+	{
+		*out = 0;
+		return 0;
+	}
+	return len;
+}
+
+static void Tel_Sleep (int msec)
+{
+#ifdef _WIN32
+	Sleep (msec);
+#else
+	struct timespec	ts;
+
+	ts.tv_sec = msec / 1000;
+	ts.tv_nsec = (msec % 1000) * 1000000L;
+	nanosleep (&ts, NULL);
+#endif
+}
+
+// one gauge line, or nothing if it doesn't fit
+static int Tel_Line (char *out, int size, char *name, float value)
+{
+	return Tel_Print (out, size, "%s.%s:%g|g\n", tel_prefix, name, value);
+}
+
+static int Tel_Format (telrecord_t *r, char *out, int size)
+{
+	int		len;
+
+	len = 0;
+	len += Tel_Line (out + len, size - len, "frame.mean", r->mean);
+	len += Tel_Line (out + len, size - len, "frame.p50", r->p50);
+	len += Tel_Line (out + len, size - len, "frame.p95", r->p95);
+	len += Tel_Line (out + len, size - len, "frame.p99", r->p99);
+	len += Tel_Line (out + len, size - len, "frame.max", r->max);
+	len += Tel_Line (out + len, size - len, "frames", r->frames);
+	len += Tel_Line (out + len, size - len, "edicts", r->num_edicts);
+	len += Tel_Line (out + len, size - len, "edicts_inuse", r->edicts_inuse);
+	len += Tel_Line (out + len, size - len, "clients", r->clients);
+	len += Tel_Line (out + len, size - len, "bots", r->bots);
+	len += Tel_Line (out + len, size - len, "traces", r->traces);
+	len += Tel_Line (out + len, size - len, "reliable_bytes", r->reliable_bytes);
+	len += Tel_Line (out + len, size - len, "reliable_sends", r->reliable_sends);
+	len += Tel_Line (out + len, size - len, "saves", r->saves);
+	len += Tel_Line (out + len, size - len, "save.max", r->save_max);
+	len += Tel_Line (out + len, size - len, "dropped", r->dropped);
+	return len;
+}
+
+// splits "host:port" and looks the host up; false if it can't be used
+static qboolean Tel_Resolve (struct sockaddr_in *addr)
+{
+	struct addrinfo	hints, *res;
+	char			host[MAX_QPATH], *port;
+
+	Q_strncpyz (host, tel_address, sizeof(host));
+	port = strrchr (host, ':');
+	if (!port || !port[1])
+		return false;
+	*port++ = 0;
+
+	memset (&hints, 0, sizeof(hints));
+	hints.ai_family = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo (host, port, &hints, &res) != 0 || !res)
+		return false;
+	memcpy (addr, res->ai_addr, sizeof(*addr));
+	freeaddrinfo (res);
+	return true;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI Tel_Worker (LPVOID arg)
+#else
+static void *Tel_Worker (void *arg)
+#endif
+{
+	struct sockaddr_in	addr;
+	char				packet[TEL_PACKET];
+	int					len;
+#ifdef _WIN32
+	SOCKET				sock;
+	u_long				nonblocking = 1;
+	WSADATA				wsa;
+
+	if (WSAStartup (MAKEWORD(2, 2), &wsa) != 0)
+		return 0;
+	sock = INVALID_SOCKET;
+	if (Tel_Resolve (&addr))
+		sock = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock != INVALID_SOCKET)
+		ioctlsocket (sock, FIONBIO, &nonblocking);
+#else
+	int					sock;
+
+	sock = -1;
+	if (Tel_Resolve (&addr))
+		sock = socket (AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock >= 0)
+		fcntl (sock, F_SETFL, fcntl (sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+
+	while (!tel_quit)
+	{
+		while (tel_tail != tel_head)
+		{
+			TEL_BARRIER ();
+			len = Tel_Format (&tel_ring[tel_tail % TEL_RING], packet, sizeof(packet));
+			TEL_BARRIER ();
+			tel_tail++;
+#ifdef _WIN32
+			if (sock != INVALID_SOCKET && len > 0)
+#else
+			if (sock >= 0 && len > 0)
+#endif
+				sendto (sock, packet, len, 0, (struct sockaddr *)&addr, sizeof(addr));
+		}
+		Tel_Sleep (50);
+	}
+
+#ifdef _WIN32
+	if (sock != INVALID_SOCKET)
+		closesocket (sock);
+	WSACleanup ();
+#else
+	if (sock >= 0)
+		close (sock);
+#endif
+	return 0;
+}
+
+static void Tel_Stop (void)
+{
+	if (!tel_running)
+		return;
+	tel_quit = 1;
+#ifdef _WIN32
+	WaitForSingleObject (tel_thread, INFINITE);
+	CloseHandle (tel_thread);
+#else
+	pthread_join (tel_thread, NULL);
+#endif
+	tel_running = false;
+}
+
+static void Tel_Start (void)
+{
+	Q_strncpyz (tel_address, sv_telemetry->string, sizeof(tel_address));
+	Q_strncpyz (tel_prefix, *sv_telemetry_prefix->string ? sv_telemetry_prefix->string : "vrgame", sizeof(tel_prefix));
+	tel_head = tel_tail = 0;
+	tel_quit = 0;
+
+#ifdef _WIN32
+	tel_thread = CreateThread (NULL, 0, Tel_Worker, NULL, 0, NULL);
+	tel_running = (tel_thread != NULL);
+#else
+	tel_running = (pthread_create (&tel_thread, NULL, Tel_Worker, NULL) == 0);
+#endif
+	if (tel_running)
+		gi.dprintf ("Telemetry to %s\n", tel_address);
+	else
+		gi.dprintf ("Telemetry: couldn't start the worker thread\n");
+}
+
+/*
+==============================================================================
+
+FRAME THREAD
+
+==============================================================================
+*/
+
+static void Tel_Flush (double now)
+{
+	telrecord_t	*r;
+	float		v;
+	edict_t		*e;
+	int			i, j, traces, bytes, sends;
+
+	traces = G_TraceTotal ();
+	G_MessageStats (&bytes, &sends);
+
+	if (tel_head - tel_tail >= TEL_RING)
+	{
+		tel_dropped++;
+		goto next;
+	}
+	r = &tel_ring[tel_head % TEL_RING];
+	memset (r, 0, sizeof(*r));
+
+	// a second holds about ten frames, so insertion sort does
+	for (i=1 ; i<tel_frames && i<TEL_SAMPLES ; i++)
+	{
+		v = tel_msec[i];
+		for (j=i ; j>0 && tel_msec[j-1] > v ; j--)
+			tel_msec[j] = tel_msec[j-1];
+		tel_msec[j] = v;
+	}
+	j = (tel_frames < TEL_SAMPLES) ? tel_frames : TEL_SAMPLES;
+	r->frames = tel_frames;
+	if (j)
+	{
+		r->mean = tel_total / tel_frames;
+		r->p50 = tel_msec[(j - 1) * 50 / 100];
+		r->p95 = tel_msec[(j - 1) * 95 / 100];
+		r->p99 = tel_msec[(j - 1) * 99 / 100];
+		r->max = tel_max;
+	}
+
+	r->num_edicts = globals.num_edicts;
+	for (i=0, e=g_edicts ; i<globals.num_edicts ; i++, e++)
+	{
+		if (!e->inuse)
+			continue;
+		r->edicts_inuse++;
+		if (i >= 1 && i <= game.maxclients && e->client)
+		{
+			r->clients++;
+			if (e->is_bot)
+				r->bots++;
+		}
+	}
+
+	// "sv tracestats reset" can take the total back down
+	r->traces = (traces >= tel_last_traces) ? traces - tel_last_traces : traces;
+	r->reliable_bytes = bytes - tel_last_bytes;
+	r->reliable_sends = sends - tel_last_sends;
+	r->saves = tel_saves;
+	r->save_max = tel_save_max;
+	r->dropped = tel_dropped;
+	tel_dropped = 0;
+
+	TEL_BARRIER ();
+	tel_head++;
+
+next:
+	tel_last_traces = traces;
+	tel_last_bytes = bytes;
+	tel_last_sends = sends;
+	tel_frames = 0;
+	tel_total = tel_max = 0;
+	tel_saves = 0;
+	tel_save_max = 0;
+	tel_second_start = now;
+}
+
+/*
+=================
+Tel_BeginFrame / Tel_EndFrame
+
+Called around all of G_RunFrame
+=================
+*/
+void Tel_BeginFrame (void)
+{
+	if (sv_telemetry->modified)
+	{
+		sv_telemetry->modified = false;
+		sv_telemetry_prefix->modified = false;
+		Tel_Stop ();
+		if (*sv_telemetry->string)
+			Tel_Start ();
+		tel_second_start = 0;
+	}
+	if (!tel_running)
+		return;
+	tel_frame_start = Prof_Seconds ();
+}
+
+void Tel_EndFrame (void)
+{
+	double	now;
+	float	msec;
+
+	if (!tel_running || !tel_frame_start)
+		return;
+
+	now = Prof_Seconds ();
+	msec = (float)((now - tel_frame_start) * 1000.0);
+	tel_frame_start = 0;
+
+	if (tel_frames < TEL_SAMPLES)
+		tel_msec[tel_frames] = msec;
+	tel_frames++;
+	tel_total += msec;
+	if (msec > tel_max)
+		tel_max = msec;
+
+	if (!tel_second_start)
+	{
+		// first frame since starting; begin a fresh second
+		G_MessageStats (&tel_last_bytes, &tel_last_sends);
+		tel_last_traces = G_TraceTotal ();
+		tel_frames = 0;
+		tel_total = tel_max = 0;
+		tel_second_start = now;
+	}
+	else if (now - tel_second_start >= 1.0)
+		Tel_Flush (now);
+}
+
+/*
+=================
+Tel_CountSave
+
+Milliseconds the frame thread spent writing a level
+=================
+*/
+void Tel_CountSave (int msec)
+{
+	tel_saves++;
+	if (msec > tel_save_max)
+		tel_save_max = msec;
+}
+
+/*
+=================
+Tel_Shutdown
+
+Called from ShutdownGame
+=================
+*/
+void Tel_Shutdown (void)
+{
+	Tel_Stop ();
+	if (sv_telemetry)
+		sv_telemetry->modified = true;		// start again with the next game
+}
@@ -0,0 +1,380 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+
+/*
+==============================================================================
+
+TEMP EVENT QUEUE
+
+Impacts, splashes, explosions and trails sent through the functions
+below are held from G_BeginTempEvents at the top of G_RunFrame until
+ClientEndServerFrames, and multicast then. The engine only sends
+datagrams after the frame, so holding them costs no latency.
+
+A spark, puff, blood spurt or splash that lands within TEMP_MERGE_DIST
+of one of the same kind already queued this frame, facing about the
+same way, is dropped: a shotgun blast into a wall, or the same burst
+seen again in a func_reflect, would otherwise send a dozen copies of
+what draws as one puff. Those are also dropped when no client has the
+spot in its PVS, which is where MULTICAST_PVS would have sent them.
+
+Explosions and trails are queued but never merged or dropped, except
+for the copies func_reflect sends (between G_BeginMirroredTemps and
+G_EndMirroredTemps): one landing on the same spot as an effect already
+queued, which overlapping mirrors produce, is dropped. Anything sent
+outside a frame (ClientThink) or once the queue is full goes out
+straight away, as before.
+
+==============================================================================
+*/
+
+#define	TEMP_MAX_EVENTS		256
+#define	TEMP_MERGE_DIST		8
+#define	TEMP_MERGE_DOT		0.9
+
+typedef enum
+{
+	TEMP_POINT,			// type, origin
+	TEMP_IMPACT,		// type, origin, dir
+	TEMP_SPLASH,		// type, count, origin, dir, color
+	TEMP_TRAIL			// type, start, end
+} tempform_t;
+
+typedef struct
+{
+	tempform_t	form;
+	int			type;
+	int			count;
+	int			color;
+	qboolean	hasdir;
+	vec3_t		origin;
+	vec3_t		end;
+	vec3_t		dir;
+	vec3_t		multicast_origin;
+	multicast_t	to;
+} tempevent_t;
+
+static tempevent_t	temp_events[TEMP_MAX_EVENTS];
+static int			num_temp_events;
+static qboolean		temp_queueing;
+static qboolean		temp_mirrored;		// func_reflect copies being sent
+
+static void G_WriteTempEvent (tempevent_t *ev)
+{
+	gi.WriteByte (svc_temp_entity);
+	gi.WriteByte (ev->type);
+	switch (ev->form)
+	{
+	case TEMP_POINT:
+		gi.WritePosition (ev->origin);
+		break;
+	case TEMP_IMPACT:
+		gi.WritePosition (ev->origin);
+		if (ev->hasdir)
+			gi.WriteDir (ev->dir);
+		break;
+	case TEMP_SPLASH:
+		gi.WriteByte (ev->count);
+		gi.WritePosition (ev->origin);
+		gi.WriteDir (ev->dir);
+		gi.WriteByte (ev->color);
+		break;
+	case TEMP_TRAIL:
+		gi.WritePosition (ev->origin);
+		gi.WritePosition (ev->end);
+		break;
+	}
+	gi.multicast (ev->multicast_origin, ev->to);
+}
+
+/*
+=================
+G_TempCosmetic
+
+True for the effects that only draw particles, which are the ones that
+may be merged or dropped
+=================
+*/
+static qboolean G_TempCosmetic (tempevent_t *ev)
+{
+	if (ev->form != TEMP_IMPACT && ev->form != TEMP_SPLASH)
+		return false;
+
+	switch (ev->type)
+	{
+	case TE_GUNSHOT:
+	case TE_BLOOD:
+	case TE_BLASTER:
+	case TE_SHOTGUN:
+	case TE_SPARKS:
+	case TE_SCREEN_SPARKS:
+	case TE_SHIELD_SPARKS:
+	case TE_BULLET_SPARKS:
+	case TE_GREENBLOOD:
+	case TE_BLASTER2:
+	case TE_MOREBLOOD:
+	case TE_HEATBEAM_SPARKS:
+	case TE_ELECTRIC_SPARKS:
+	case TE_SPLASH:
+	case TE_LASER_SPARKS:
+	case TE_WELDING_SPARKS:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static qboolean G_TempSeen (vec3_t origin)
+{
+	edict_t	*e;
+	int		i;
+
+	for (i = 1; i <= game.maxclients; i++)
+	{
+		e = &g_edicts[i];
+		if (!e->inuse || !e->client)
+			continue;
+		if (gi.inPVS (e->s.origin, origin))
+			return true;
+	}
+	return false;
+}
+
+static qboolean G_TempMerged (tempevent_t *ev)
+{
+	tempevent_t	*q;
+	vec3_t		v;
+	int			i;
+
+	for (i = 0, q = temp_events; i < num_temp_events; i++, q++)
+	{
+		if (q->form != ev->form || q->type != ev->type || q->to != ev->to)
+			continue;
+		if (q->form == TEMP_SPLASH && q->color != ev->color)
+			continue;
+		VectorSubtract (q->origin, ev->origin, v);
+		if (DotProduct (v, v) > TEMP_MERGE_DIST*TEMP_MERGE_DIST)
+			continue;
+		if (q->hasdir != ev->hasdir)
+			continue;
+		if (q->hasdir && DotProduct (q->dir, ev->dir) < TEMP_MERGE_DOT)
+			continue;
+		if (q->form == TEMP_SPLASH)
+			q->count = (q->count + ev->count > 255) ? 255 : q->count + ev->count;
+		return true;
+	}
+	return false;
+}
+
+// a mirrored explosion or trail the same as one already queued
+static qboolean G_TempRepeated (tempevent_t *ev)
+{
+	tempevent_t	*q;
+	vec3_t		v;
+	int			i;
+
+	for (i = 0, q = temp_events; i < num_temp_events; i++, q++)
+	{
+		if (q->form != ev->form || q->type != ev->type || q->to != ev->to)
+			continue;
+		VectorSubtract (q->origin, ev->origin, v);
+		if (DotProduct (v, v) > TEMP_MERGE_DIST*TEMP_MERGE_DIST)
+			continue;
+		if (q->form == TEMP_TRAIL)
+		{
+			VectorSubtract (q->end, ev->end, v);
+			if (DotProduct (v, v) > TEMP_MERGE_DIST*TEMP_MERGE_DIST)
+				continue;
+		}
+		return true;
+	}
+	return false;
+}
+
+static void G_QueueTempEvent (tempevent_t *ev)
+{
+	if (!temp_queueing)
+	{
+		G_WriteTempEvent (ev);
+		return;
+	}
+
+	if (G_TempCosmetic (ev))
+	{
+		if (G_TempMerged (ev))
+			return;
+	}
+	else if (temp_mirrored && G_TempRepeated (ev))
+		return;
+
+	if (num_temp_events == TEMP_MAX_EVENTS)
+	{
+		G_WriteTempEvent (ev);
+		return;
+	}
+	temp_events[num_temp_events++] = *ev;
+}
+
+/*
+=================
+G_TempPoint
+
+An effect at a point, an explosion mostly
+=================
+*/
+void G_TempPoint (int type, vec3_t origin, multicast_t to)
+{
+	tempevent_t	ev;
+
+	memset (&ev, 0, sizeof(ev));
+	ev.form = TEMP_POINT;
+	ev.type = type;
+	VectorCopy (origin, ev.origin);
+	VectorCopy (origin, ev.multicast_origin);
+	ev.to = to;
+	G_QueueTempEvent (&ev);
+}
+
+/*
+=================
+G_TempImpact
+
+Sparks, puffs and blood where something was hit, sent to the PVS. dir
+is NULL for the few types that have none (TE_CHAINFIST_SMOKE).
+=================
+*/
+void G_TempImpact (int type, vec3_t origin, vec3_t dir)
+{
+	tempevent_t	ev;
+
+	memset (&ev, 0, sizeof(ev));
+	ev.form = TEMP_IMPACT;
+	ev.type = type;
+	VectorCopy (origin, ev.origin);
+	VectorCopy (origin, ev.multicast_origin);
+	if (dir)
+	{
+		ev.hasdir = true;
+		VectorCopy (dir, ev.dir);
+	}
+	ev.to = MULTICAST_PVS;
+	G_QueueTempEvent (&ev);
+}
+
+/*
+=================
+G_TempSplash
+
+TE_SPLASH, TE_LASER_SPARKS and the like, sent to the PVS
+=================
+*/
+void G_TempSplash (int type, int count, vec3_t origin, vec3_t dir, int color)
+{
+	tempevent_t	ev;
+
+	memset (&ev, 0, sizeof(ev));
+	ev.form = TEMP_SPLASH;
+	ev.type = type;
+	ev.count = count;
+	ev.color = color;
+	ev.hasdir = true;
+	VectorCopy (origin, ev.origin);
+	VectorCopy (dir, ev.dir);
+	VectorCopy (origin, ev.multicast_origin);
+	ev.to = MULTICAST_PVS;
+	G_QueueTempEvent (&ev);
+}
+
+/*
+=================
+G_TempTrail
+
+A trail from start to end, multicast from origin
+=================
+*/
+void G_TempTrail (int type, vec3_t start, vec3_t end, vec3_t origin, multicast_t to)
+{
+	tempevent_t	ev;
+
+	memset (&ev, 0, sizeof(ev));
+	ev.form = TEMP_TRAIL;
+	ev.type = type;
+	VectorCopy (start, ev.origin);
+	VectorCopy (end, ev.end);
+	VectorCopy (origin, ev.multicast_origin);
+	ev.to = to;
+	G_QueueTempEvent (&ev);
+}
+
+/*
+=================
+G_BeginMirroredTemps / G_EndMirroredTemps
+
+Around the effects g_reflect.c sends for func_reflects
+=================
+*/
+void G_BeginMirroredTemps (void)
+{
+	temp_mirrored = true;
+}
+
+void G_EndMirroredTemps (void)
+{
+	temp_mirrored = false;
+}
+
+/*
+=================
+G_BeginTempEvents
+
+Called at the top of G_RunFrame
+=================
+*/
+void G_BeginTempEvents (void)
+{
+	num_temp_events = 0;
+	temp_queueing = true;
+}
+
+/*
+=================
+G_FlushTempEvents
+
+Called at the end of ClientEndServerFrames. Sends what was queued this
+frame and goes back to sending straight away until the next frame.
+=================
+*/
+void G_FlushTempEvents (void)
+{
+	tempevent_t	*ev;
+	int			i;
+
+	for (i = 0, ev = temp_events; i < num_temp_events; i++, ev++)
+	{
+		if (G_TempCosmetic (ev) && !G_TempSeen (ev->multicast_origin))
+			continue;
+		G_WriteTempEvent (ev);
+	}
+	num_temp_events = 0;
+	temp_queueing = false;
+}
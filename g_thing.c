@@ -24,22 +24,95 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 qboolean has_valid_enemy (edict_t *self);
 void HuntTarget (edict_t *self);
 
+/*
+=================
+Thing pool
+
+Things are the markers monsters and actors are sent to (cover spots,
+grenade dodges, a leader's last position, a vehicle's seat). Scripted
+scenes make and drop them all the time. Those dropped by the thinks
+and touches here go back in a pool, left free but not queued for
+G_Spawn, and SpawnThing takes them from there before asking for a new
+slot. A free thing has no model and was never sent, so it can be used
+again at once, without waiting out a freetime. Should the last-ditch
+scan in G_Spawn take one first, it is simply skipped.
+=================
+*/
+#define THING_POOL_SIZE		32
+
+static edict_t	*thing_pool[THING_POOL_SIZE];
+static int		thing_pool_count;
+
+/*
+=================
+thing_pool_reset
+
+Called when a level is spawned, loaded or restarted. Pooled things
+are just free slots to a savegame.
+=================
+*/
+void thing_pool_reset (void)
+{
+	thing_pool_count = 0;
+}
+
 edict_t *SpawnThing()
 {
 	edict_t	*thing;
-	thing = G_Spawn();
-	thing->classname = (char*)gi.TagMalloc(6,TAG_LEVEL);
-	strcpy(thing->classname,"thing");
+
+	thing = NULL;
+	while (thing_pool_count > 0)
+	{
+		thing = thing_pool[--thing_pool_count];
+		if (!thing->inuse)
+		{
+			G_InitEdict (thing);
+			break;
+		}
+		thing = NULL;
+	}
+	if (!thing)
+		thing = G_Spawn();
+	thing->classname = G_LevelString("thing");
 	return thing;
 }
 
+/*
+=================
+FreeThing
+
+G_FreeEdict for a thing, which keeps the slot in the pool
+=================
+*/
+void FreeThing (edict_t *self)
+{
+	int		i;
+
+	for (i=0 ; i<6 ; i++)
+		if (self->reflection[i])
+			break;
+	if (thing_pool_count == THING_POOL_SIZE || i < 6 || self->movewith || self->flash)
+	{
+		G_FreeEdict (self);
+		return;
+	}
+
+	gi.unlinkentity (self);
+	G_UnindexEdict (self);
+	memset (self, 0, sizeof(*self));
+	self->classname = "freed";
+	self->freetime = level.time;
+	self->inuse = false;
+	thing_pool[thing_pool_count++] = self;
+}
+
 void thing_restore_leader (edict_t *self)
 {
 	edict_t	*monster;
 	monster = self->target_ent;
 	if(!monster || !monster->inuse)
 	{
-		G_FreeEdict(self);
+		FreeThing(self);
 		return;
 	}
 	if(monster->monsterinfo.old_leader && monster->monsterinfo.old_leader->inuse)
@@ -60,7 +133,7 @@ void thing_restore_leader (edict_t *self)
 	monster->vehicle = NULL;
 	monster->monsterinfo.aiflags &= ~(AI_CHASE_THING | AI_SEEK_COVER | AI_EVADE_GRENADE);
 	gi.linkentity(monster);
-	G_FreeEdict(self);
+	FreeThing(self);
 }
 void thing_think (edict_t *self)
 {
@@ -91,7 +164,7 @@ void thing_think (edict_t *self)
 	}
 	if(!monster || !monster->inuse || (monster->health <= 0))
 	{
-		G_FreeEdict(self);
+		FreeThing(self);
 		return;
 	}
 	if(monster->goalentity == self)
@@ -125,7 +198,7 @@ void thing_think (edict_t *self)
 	monster->vehicle = NULL;
 	monster->monsterinfo.aiflags &= ~(AI_CHASE_THING | AI_SEEK_COVER | AI_EVADE_GRENADE);
 
-	G_FreeEdict(self);
+	FreeThing(self);
 	if (has_valid_enemy(monster))
 	{
 		monster->monsterinfo.pausetime = 0;
@@ -155,7 +228,7 @@ void thing_think_pause(edict_t *self)
 	monster = self->target_ent;
 	if(!monster || !monster->inuse)
 	{
-		G_FreeEdict(self);
+		FreeThing(self);
 		return;
 	}
 	if(has_valid_enemy(monster))
@@ -183,7 +256,7 @@ void thing_grenade_boom (edict_t *self)
 	edict_t	*monster;
 
 	monster = self->target_ent;
-	G_FreeEdict(self);
+	FreeThing(self);
 	if(!monster || !monster->inuse || (monster->health <= 0))
 		return;
 	monster->monsterinfo.aiflags &= ~(AI_CHASE_THING | AI_EVADE_GRENADE | AI_STAND_GROUND);
@@ -198,7 +271,7 @@ void thing_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *su
 		return;
 	if(other->health <= 0)
 	{
-		G_FreeEdict(self);
+		FreeThing(self);
 		return;
 	}
 	self->touch = NULL;
@@ -284,7 +357,7 @@ void thing_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *su
 			other->monsterinfo.aiflags &= ~(AI_CHASE_THING | AI_EVADE_GRENADE);
 			other->monsterinfo.stand (other);
 		}
-		G_FreeEdict(self);
+		FreeThing(self);
 		return;
 	}
 	self->touch_debounce_time = 0;
@@ -0,0 +1,971 @@
+/*
+Copyright (C) 1997-2001 Id Software, Inc.
+Copyright (C) 2000-2002 Mr. Hyde and Mad Dog
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+
+#include "g_local.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#pragma intrinsic(_ReturnAddress)
+#define	TRACE_CALLER()	_ReturnAddress()
+#else
+#define	TRACE_CALLER()	__builtin_return_address(0)
+#endif
+
+/*
+==============================================================================
+
+TRACE ACCOUNTING AND CACHE
+
+InitGame points gi.trace, gi.linkentity, gi.unlinkentity and
+gi.multicast at the wrappers below (and the index functions at the
+cache after them, and the message functions at the byte counts after
+that), so every trace in the game goes
+through G_Trace. While profiling, links and multicasts are counted
+too. Links that would change nothing are skipped (see the link cache).
+
+G_Trace counts calls per call site (the return address, which
+"sv tracestats" turns back into the nearest function in the save
+tables) and remembers the last few hundred queries. A query identical
+to one already made (same start, end, mins, maxs, passent and mask)
+since anything was last linked or unlinked is a duplicate. With
+sv_trace_cache set, duplicates are answered from the cache instead of
+running the engine's trace again.
+
+Anything that moves is relinked before its next trace in all but a few
+places, but a handful of spots move an entity and trace before the
+relink (SV_Push testing pushed entities is one), and the engine reads
+s.origin live. So the cache is off by default; duplicates are counted
+either way, which shows what turning it on would save.
+
+==============================================================================
+*/
+
+#define	TRACE_CACHE_SIZE	256		// must be a power of 2
+#define	TRACE_SITES			1024	// must be a power of 2
+#define	TRACE_TOP_SITES		16
+
+typedef struct
+{
+	vec3_t		start, end, mins, maxs;
+	edict_t		*passent;
+	int			mask;
+} tracekey_t;
+
+typedef struct
+{
+	int			generation;		// 0 if empty
+	tracekey_t	key;
+	trace_t		result;
+} tracecache_t;
+
+typedef struct
+{
+	void		*caller;
+	int			calls;
+	int			duplicates;
+} tracesite_t;
+
+static trace_t	(*trace_engine) (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passent, int contentmask);
+static void		(*trace_linkentity) (edict_t *ent);
+static void		(*trace_unlinkentity) (edict_t *ent);
+static void		(*trace_multicast) (vec3_t origin, multicast_t to);
+
+static tracecache_t	trace_cache[TRACE_CACHE_SIZE];
+static int			trace_generation = 1;
+static tracesite_t	trace_sites[TRACE_SITES];
+static qboolean		trace_sites_full;
+
+static struct
+{
+	int		framenum;
+	int		frame_calls;
+	int		frame_duplicates;
+	int		last_calls;
+	int		last_duplicates;
+	int		total_calls;
+	int		total_duplicates;
+	int		total_hits;			// duplicates answered from the cache
+	int		frames;
+	int		contents_calls;		// G_EnvContents
+	int		contents_hits;		// ... answered without the engine
+	int		water_calls;		// G_WaterLevelKnown
+	int		water_hits;
+} trace_stats;
+
+static struct
+{
+	void	(*WriteChar) (int c);
+	void	(*WriteByte) (int c);
+	void	(*WriteShort) (int c);
+	void	(*WriteLong) (int c);
+	void	(*WriteFloat) (float f);
+	void	(*WriteString) (char *s);
+	void	(*WritePosition) (vec3_t pos);
+	void	(*WriteDir) (vec3_t pos);
+	void	(*WriteAngle) (float f);
+	void	(*unicast) (edict_t *ent, qboolean reliable);
+} msg_engine;
+
+static int		msg_pending;		// bytes written since the last send
+
+static struct
+{
+	int		reliable_bytes;
+	int		reliable_sends;
+} msg_stats;
+
+static void G_BrushModelMoved (edict_t *ent);
+static void G_InitWaterCache (void);
+
+/*
+=================
+Link cache
+
+Plenty of thinks relink an entity every frame whether it moved or not
+(trigger_inside, reflections, lasers, beams). What the engine works out
+from a link depends on the origin, angles, bounds, solid and
+SVF_DEADMONSTER, so the values each entity was last linked with are
+kept, and a link that changes none of them is dropped. Clients are
+always linked: the engine links them itself, and target_precipitation
+counts on the player's linkcount going up every frame.
+=================
+*/
+typedef struct
+{
+	qboolean	linked;
+	vec3_t		origin, angles;
+	vec3_t		mins, maxs;
+	vec3_t		absmin, absmax;		// as the engine left them
+	int			solid;
+	int			s_solid;
+	int			deadmonster;		// svflags & SVF_DEADMONSTER
+} linkcache_t;
+
+static linkcache_t	*link_cache;		// game.maxentities
+
+static qboolean G_LinkUnchanged (edict_t *ent, linkcache_t *l)
+{
+	return l->linked && ent->inuse && !ent->client
+		&& l->solid == ent->solid && l->s_solid == ent->s.solid
+		&& l->deadmonster == (ent->svflags & SVF_DEADMONSTER)
+		&& VectorCompare (l->origin, ent->s.origin)
+		&& VectorCompare (l->angles, ent->s.angles)
+		&& VectorCompare (l->mins, ent->mins)
+		&& VectorCompare (l->maxs, ent->maxs)
+		&& VectorCompare (l->absmin, ent->absmin)
+		&& VectorCompare (l->absmax, ent->absmax);
+}
+
+static void G_StoreLink (edict_t *ent, linkcache_t *l)
+{
+	l->linked = ent->inuse;
+	l->solid = ent->solid;
+	l->s_solid = ent->s.solid;
+	l->deadmonster = ent->svflags & SVF_DEADMONSTER;
+	VectorCopy (ent->s.origin, l->origin);
+	VectorCopy (ent->s.angles, l->angles);
+	VectorCopy (ent->mins, l->mins);
+	VectorCopy (ent->maxs, l->maxs);
+	VectorCopy (ent->absmin, l->absmin);
+	VectorCopy (ent->absmax, l->absmax);
+}
+
+/*
+=================
+G_ClearLinkCache
+
+Called when a level is spawned or loaded
+=================
+*/
+void G_ClearLinkCache (void)
+{
+	if (link_cache)
+		memset (link_cache, 0, game.maxentities * sizeof(linkcache_t));
+}
+
+static void G_LinkEntity (edict_t *ent)
+{
+	linkcache_t	*l;
+
+	if (!link_cache)
+		link_cache = gi.TagMalloc (game.maxentities * sizeof(linkcache_t), TAG_GAME);
+	l = &link_cache[ent - g_edicts];
+	if (G_LinkUnchanged (ent, l))
+	{
+		if (prof_active)
+			Prof_CountLinkSkip ();
+		return;
+	}
+
+	trace_generation++;
+	G_BrushModelMoved (ent);
+	if (prof_active)
+		Prof_CountLink ();
+	G_TriggerLinkEvent (ent);
+	trace_linkentity (ent);
+	G_TriggerLinkEvent (ent);
+	G_StoreLink (ent, l);
+}
+
+static void G_UnlinkEntity (edict_t *ent)
+{
+	if (link_cache)
+		link_cache[ent - g_edicts].linked = false;
+	trace_generation++;
+	G_BrushModelMoved (ent);
+	if (prof_active)
+		Prof_CountLink ();
+	G_TriggerLinkEvent (ent);
+	trace_unlinkentity (ent);
+}
+
+static void G_Multicast (vec3_t origin, multicast_t to)
+{
+	if (prof_active)
+		Prof_CountMulticast ();
+	msg_pending = 0;
+	trace_multicast (origin, to);
+}
+
+/*
+==============================================================================
+
+MESSAGE BYTES
+
+The gi.Write functions are counted into msg_pending, which the next
+gi.unicast adds to msg_stats if it is reliable and then forgets, as
+does gi.multicast. Positions are counted as three shorts. Telemetry
+reads the totals with G_MessageStats.
+
+==============================================================================
+*/
+
+static void G_WriteChar (int c)
+{
+	msg_pending += 1;
+	msg_engine.WriteChar (c);
+}
+
+static void G_WriteByte (int c)
+{
+	msg_pending += 1;
+	msg_engine.WriteByte (c);
+}
+
+static void G_WriteShort (int c)
+{
+	msg_pending += 2;
+	msg_engine.WriteShort (c);
+}
+
+static void G_WriteLong (int c)
+{
+	msg_pending += 4;
+	msg_engine.WriteLong (c);
+}
+
+static void G_WriteFloat (float f)
+{
+	msg_pending += 4;
+	msg_engine.WriteFloat (f);
+}
+
+static void G_WriteString (char *s)
+{
+	msg_pending += (s ? strlen (s) : 0) + 1;
+	msg_engine.WriteString (s);
+}
+
+static void G_WritePosition (vec3_t pos)
+{
+	msg_pending += 6;
+	msg_engine.WritePosition (pos);
+}
+
+static void G_WriteDir (vec3_t dir)
+{
+	msg_pending += 1;
+	msg_engine.WriteDir (dir);
+}
+
+static void G_WriteAngle (float f)
+{
+	msg_pending += 1;
+	msg_engine.WriteAngle (f);
+}
+
+static void G_Unicast (edict_t *ent, qboolean reliable)
+{
+	if (reliable)
+	{
+		msg_stats.reliable_bytes += msg_pending;
+		msg_stats.reliable_sends++;
+	}
+	msg_pending = 0;
+	msg_engine.unicast (ent, reliable);
+}
+
+/*
+=================
+G_MessageStats
+
+Reliable unicast bytes and sends since the game started
+=================
+*/
+void G_MessageStats (int *bytes, int *sends)
+{
+	*bytes = msg_stats.reliable_bytes;
+	*sends = msg_stats.reliable_sends;
+}
+
+/*
+=================
+G_TraceTotal
+
+Traces since the game started, or since "sv tracestats reset"
+=================
+*/
+int G_TraceTotal (void)
+{
+	return trace_stats.total_calls;
+}
+
+/*
+==============================================================================
+
+CONFIGSTRING INDEX CACHE
+
+gi.soundindex, gi.modelindex and gi.imageindex look a name up by
+comparing it with each configstring of its kind in turn, and a lot of
+the game asks them at run time with the same literal every time: the
+HUD every frame, weapon and water sounds, gibs and debris. InitGame
+points them at G_SoundIndex and friends, which remember what the engine
+answered in a hash table. A name's index never changes while a map is
+up, so the table only has to be forgotten when a level is spawned or
+loaded (the engine restores the saved configstrings before ReadLevel).
+
+==============================================================================
+*/
+#define	INDEX_CACHE_SIZE	1024	// must be a power of 2
+#define	INDEX_PROBES		8
+
+enum { INDEX_SOUND, INDEX_MODEL, INDEX_IMAGE, NUM_INDEX_KINDS };
+
+typedef struct
+{
+	int		generation;		// 0 if empty
+	int		kind;
+	int		index;
+	char	name[MAX_QPATH];
+} indexcache_t;
+
+static int			(*index_engine[NUM_INDEX_KINDS]) (char *name);
+static indexcache_t	index_cache[INDEX_CACHE_SIZE];
+static int			index_generation = 1;
+
+static int G_CachedIndex (int kind, char *name)
+{
+	indexcache_t	*entry;
+	unsigned int	hash, slot;
+	char			*s;
+	int				probes;
+
+	if (!name || !name[0] || strlen(name) >= MAX_QPATH)
+		return index_engine[kind] (name);
+
+	hash = 2166136261u ^ kind;
+	for (s=name ; *s ; s++)
+		hash = (hash ^ (byte)*s) * 16777619u;
+
+	for (probes=0 ; probes<INDEX_PROBES ; probes++)
+	{
+		slot = (hash + probes) & (INDEX_CACHE_SIZE-1);
+		entry = &index_cache[slot];
+		if (entry->generation != index_generation)
+		{
+			entry->index = index_engine[kind] (name);
+			entry->kind = kind;
+			strcpy (entry->name, name);
+			entry->generation = index_generation;
+			return entry->index;
+		}
+		if (entry->kind == kind && !strcmp(entry->name, name))
+			return entry->index;
+	}
+	return index_engine[kind] (name);		// neighbourhood full
+}
+
+static int G_SoundIndex (char *name)
+{
+	return G_CachedIndex (INDEX_SOUND, name);
+}
+
+static int G_ModelIndex (char *name)
+{
+	return G_CachedIndex (INDEX_MODEL, name);
+}
+
+static int G_ImageIndex (char *name)
+{
+	return G_CachedIndex (INDEX_IMAGE, name);
+}
+
+/*
+=================
+G_ClearIndexCache
+
+Called when a level is spawned or loaded
+=================
+*/
+void G_ClearIndexCache (void)
+{
+	index_generation++;
+}
+
+static unsigned int G_TraceHash (tracekey_t *key)
+{
+	unsigned int	*p = (unsigned int *)key;
+	unsigned int	hash = 2166136261u;
+	int				i;
+
+	for (i=0 ; i<12 ; i++)		// start, end, mins, maxs
+		hash = (hash ^ p[i]) * 16777619u;
+	hash ^= (unsigned int)(size_t)key->passent >> 2;
+	hash ^= key->mask * 2654435761u;
+	return hash ^ (hash >> 16);
+}
+
+static void G_CountTraceSite (void *caller, qboolean duplicate)
+{
+	unsigned int	slot;
+	int				probes;
+
+	slot = ((unsigned int)((size_t)caller >> 2) * 2654435761u) & (TRACE_SITES-1);
+	for (probes=0 ; probes<TRACE_SITES ; probes++, slot = (slot+1) & (TRACE_SITES-1))
+	{
+		if (trace_sites[slot].caller == caller)
+			break;
+		if (!trace_sites[slot].caller)
+		{
+			trace_sites[slot].caller = caller;
+			break;
+		}
+	}
+	if (probes == TRACE_SITES)
+	{
+		trace_sites_full = true;
+		return;
+	}
+	trace_sites[slot].calls++;
+	if (duplicate)
+		trace_sites[slot].duplicates++;
+}
+
+static void G_TraceKey (tracekey_t *key, vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passent, int contentmask)
+{
+	memset (key, 0, sizeof(*key));
+	VectorCopy (start, key->start);
+	VectorCopy (end, key->end);
+	if (mins)
+		VectorCopy (mins, key->mins);
+	if (maxs)
+		VectorCopy (maxs, key->maxs);
+	key->passent = passent;
+	key->mask = contentmask;
+}
+
+/*
+=================
+G_TraceLookup
+
+Counts one trace for caller and returns its cache entry. Sets *hit if
+the entry already holds the answer and sv_trace_cache lets it be used.
+=================
+*/
+static tracecache_t *G_TraceLookup (tracekey_t *key, void *caller, qboolean *hit)
+{
+	tracecache_t	*entry;
+	qboolean		duplicate;
+
+	if (prof_active)
+		Prof_CountTrace ();
+
+	entry = &trace_cache[G_TraceHash(key) & (TRACE_CACHE_SIZE-1)];
+	duplicate = (entry->generation == trace_generation) && !memcmp(&entry->key, key, sizeof(*key));
+
+	trace_stats.frame_calls++;
+	trace_stats.total_calls++;
+	if (duplicate)
+	{
+		trace_stats.frame_duplicates++;
+		trace_stats.total_duplicates++;
+	}
+	G_CountTraceSite (caller, duplicate);
+
+	*hit = duplicate && sv_trace_cache && sv_trace_cache->value;
+	if (*hit)
+		trace_stats.total_hits++;
+	return entry;
+}
+
+static void G_TraceStore (tracecache_t *entry, tracekey_t *key, trace_t *result)
+{
+	entry->result = *result;
+	entry->key = *key;
+	entry->generation = trace_generation;
+}
+
+static trace_t G_Trace (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, edict_t *passent, int contentmask)
+{
+	tracekey_t		key;
+	tracecache_t	*entry;
+	trace_t			result;
+	qboolean		hit;
+
+	G_TraceKey (&key, start, mins, maxs, end, passent, contentmask);
+	entry = G_TraceLookup (&key, TRACE_CALLER(), &hit);
+	if (hit)
+		return entry->result;
+
+	result = trace_engine (start, mins, maxs, end, passent, contentmask);
+	G_TraceStore (entry, &key, &result);
+	return result;
+}
+
+/*
+==============================================================================
+
+BATCHED TRACES
+
+G_TraceBatch runs a set of traces that don't depend on each other:
+shotgun pellets, the points CanDamage tries, a bot's eye probes. A Q2VR
+engine built with the TraceBatch import hands it over at GetGameAPI
+time, and then all of the set that isn't answered by the trace cache
+goes to the engine in one call, which can spread it over threads or
+run it while the world is warm in cache. Without it each one goes to
+gi.trace in turn, as before.
+
+Every trace in a batch is counted and cached like one from G_Trace, and
+charged to whoever called G_TraceBatch.
+
+==============================================================================
+*/
+
+#define	MAX_TRACE_BATCH		32
+
+static void		(*trace_batch_engine) (tracerequest_t *requests, trace_t *results, int count);
+
+/*
+=================
+G_SetTraceBatch
+
+Called from GetGameAPI with the engine's TraceBatch, or NULL
+=================
+*/
+void G_SetTraceBatch (void (*batch) (tracerequest_t *requests, trace_t *results, int count))
+{
+	trace_batch_engine = batch;
+}
+
+qboolean G_TraceBatchAvailable (void)
+{
+	return (trace_batch_engine != NULL);
+}
+
+/*
+=================
+G_TraceBatch
+
+Fills results[i] with the trace described by requests[i]
+=================
+*/
+void G_TraceBatch (tracerequest_t *requests, trace_t *results, int count)
+{
+	tracerequest_t	misses[MAX_TRACE_BATCH];
+	trace_t			missed[MAX_TRACE_BATCH];
+	tracekey_t		keys[MAX_TRACE_BATCH];
+	tracecache_t	*entries[MAX_TRACE_BATCH];
+	int				index[MAX_TRACE_BATCH];
+	tracerequest_t	*req;
+	void			*caller;
+	qboolean		hit;
+	int				i, n, num;
+
+	caller = TRACE_CALLER();
+	for ( ; count > 0 ; requests += n, results += n, count -= n)
+	{
+		n = min(count, MAX_TRACE_BATCH);
+		num = 0;
+		for (i=0, req=requests ; i<n ; i++, req++)
+		{
+			G_TraceKey (&keys[num], req->start, req->mins, req->maxs, req->end, req->passent, req->contentmask);
+			entries[num] = G_TraceLookup (&keys[num], caller, &hit);
+			if (hit)
+			{
+				results[i] = entries[num]->result;
+				continue;
+			}
+			misses[num] = *req;
+			index[num] = i;
+			num++;
+		}
+
+		if (!num)
+			continue;
+		if (trace_batch_engine)
+			trace_batch_engine (misses, missed, num);
+		else
+		{
+			for (i=0, req=misses ; i<num ; i++, req++)
+				missed[i] = trace_engine (req->start, req->mins, req->maxs, req->end, req->passent, req->contentmask);
+		}
+
+		for (i=0 ; i<num ; i++)
+		{
+			results[index[i]] = missed[i];
+			G_TraceStore (entries[i], &keys[i], &missed[i]);
+		}
+	}
+}
+
+/*
+=================
+G_InitTraceHooks
+
+Called from InitGame
+=================
+*/
+void G_InitTraceHooks (void)
+{
+	if (gi.trace != G_Trace)
+	{
+		trace_engine = gi.trace;
+		gi.trace = G_Trace;
+	}
+	if (gi.linkentity != G_LinkEntity)
+	{
+		trace_linkentity = gi.linkentity;
+		gi.linkentity = G_LinkEntity;
+	}
+	if (gi.unlinkentity != G_UnlinkEntity)
+	{
+		trace_unlinkentity = gi.unlinkentity;
+		gi.unlinkentity = G_UnlinkEntity;
+	}
+	if (gi.multicast != G_Multicast)
+	{
+		trace_multicast = gi.multicast;
+		gi.multicast = G_Multicast;
+	}
+	if (gi.soundindex != G_SoundIndex)
+	{
+		index_engine[INDEX_SOUND] = gi.soundindex;
+		gi.soundindex = G_SoundIndex;
+	}
+	if (gi.modelindex != G_ModelIndex)
+	{
+		index_engine[INDEX_MODEL] = gi.modelindex;
+		gi.modelindex = G_ModelIndex;
+	}
+	if (gi.imageindex != G_ImageIndex)
+	{
+		index_engine[INDEX_IMAGE] = gi.imageindex;
+		gi.imageindex = G_ImageIndex;
+	}
+	if (gi.unicast != G_Unicast)
+	{
+		msg_engine.WriteChar = gi.WriteChar;
+		msg_engine.WriteByte = gi.WriteByte;
+		msg_engine.WriteShort = gi.WriteShort;
+		msg_engine.WriteLong = gi.WriteLong;
+		msg_engine.WriteFloat = gi.WriteFloat;
+		msg_engine.WriteString = gi.WriteString;
+		msg_engine.WritePosition = gi.WritePosition;
+		msg_engine.WriteDir = gi.WriteDir;
+		msg_engine.WriteAngle = gi.WriteAngle;
+		msg_engine.unicast = gi.unicast;
+		gi.WriteChar = G_WriteChar;
+		gi.WriteByte = G_WriteByte;
+		gi.WriteShort = G_WriteShort;
+		gi.WriteLong = G_WriteLong;
+		gi.WriteFloat = G_WriteFloat;
+		gi.WriteString = G_WriteString;
+		gi.WritePosition = G_WritePosition;
+		gi.WriteDir = G_WriteDir;
+		gi.WriteAngle = G_WriteAngle;
+		gi.unicast = G_Unicast;
+	}
+	link_cache = NULL;
+	G_InitWaterCache ();
+	G_ClearIndexCache ();
+	G_ClearTraceCache ();
+}
+
+/*
+==============================================================================
+
+CONTENTS CACHE
+
+Water levels, drowning, lava and the view blend ask gi.pointcontents
+at a few heights for every player, monster and bot, every frame. What
+they want is the world and the brush models (water that moves, say);
+the only thing other entities add is CONTENTS_MONSTER for a point
+inside a bounding box. G_EnvContents returns the contents without
+that bit, and remembers the last few hundred points, to 1/8 of a unit,
+until the next frame or until a brush model is linked or unlinked.
+
+G_WaterLevelKnown keeps each entity's waterlevel and watertype from
+one frame to the next. They are worked out again only once the entity
+has moved up or down, its box has changed height, it has been linked
+into different clusters (the closest the game can see to leaves), or
+a brush model has moved.
+
+==============================================================================
+*/
+
+#define	CONTENTS_CACHE_SIZE		256		// must be a power of 2
+
+typedef struct
+{
+	int			generation;		// contents_frame when stored, 0 if empty
+	int			point[3];		// 1/8 units
+	int			contents;
+} contentscache_t;
+
+typedef struct
+{
+	int			generation;		// contents_world when stored, 0 if empty
+	int			kind;
+	float		bottom, top;
+	int			num_clusters, cluster, headnode, areanum;
+	int			waterlevel, watertype;
+} watercache_t;
+
+static contentscache_t	contents_cache[CONTENTS_CACHE_SIZE];
+static int				contents_frame = 1;
+static watercache_t		*water_cache;		// game.maxentities
+static int				contents_world = 1;
+
+static void G_BrushModelMoved (edict_t *ent)
+{
+	if (ent->solid == SOLID_BSP || (ent->model && ent->model[0] == '*'))
+	{
+		contents_frame++;
+		contents_world++;
+	}
+}
+
+/*
+=================
+G_EnvContents
+
+gi.pointcontents without CONTENTS_MONSTER
+=================
+*/
+int G_EnvContents (vec3_t p)
+{
+	contentscache_t	*entry;
+	int				q[3];
+	unsigned int	h;
+
+	q[0] = (int)floor (p[0] * 8 + 0.5);
+	q[1] = (int)floor (p[1] * 8 + 0.5);
+	q[2] = (int)floor (p[2] * 8 + 0.5);
+	h = ((unsigned)q[0] * 73856093u) ^ ((unsigned)q[1] * 19349663u) ^ ((unsigned)q[2] * 83492791u);
+	entry = &contents_cache[h & (CONTENTS_CACHE_SIZE-1)];
+
+	trace_stats.contents_calls++;
+	if (entry->generation == contents_frame
+		&& entry->point[0] == q[0] && entry->point[1] == q[1] && entry->point[2] == q[2])
+	{
+		trace_stats.contents_hits++;
+		return entry->contents;
+	}
+
+	entry->contents = gi.pointcontents (p) & ~CONTENTS_MONSTER;
+	entry->generation = contents_frame;
+	VectorCopy (q, entry->point);
+	return entry->contents;
+}
+
+static void G_InitWaterCache (void)
+{
+	water_cache = NULL;
+}
+
+static watercache_t *G_WaterCacheSlot (edict_t *ent)
+{
+	int		num;
+
+	num = ent - g_edicts;
+	if (num < 0 || num >= game.maxentities)
+		return NULL;
+	if (!water_cache)
+		water_cache = gi.TagMalloc (game.maxentities * sizeof(watercache_t), TAG_GAME);
+	return &water_cache[num];
+}
+
+static qboolean G_WaterCacheMatches (watercache_t *w, edict_t *ent, int kind)
+{
+	if (w->generation != contents_world || w->kind != kind)
+		return false;
+	if (w->bottom != ent->absmin[2] || w->top != ent->absmax[2])
+		return false;
+	if (w->num_clusters != ent->num_clusters || w->areanum != ent->areanum)
+		return false;
+	if (ent->num_clusters == -1)
+		return (w->headnode == ent->headnode);
+	return (ent->num_clusters == 0 || w->cluster == ent->clusternums[0]);
+}
+
+/*
+=================
+G_WaterLevelKnown
+
+True, with ent->waterlevel and watertype set, if they can't have
+changed since G_StoreWaterLevel was last called for ent with the same
+kind (one per way of working them out)
+=================
+*/
+qboolean G_WaterLevelKnown (edict_t *ent, int kind)
+{
+	watercache_t	*w;
+
+	trace_stats.water_calls++;
+	w = G_WaterCacheSlot (ent);
+	if (!w || !ent->inuse || !G_WaterCacheMatches (w, ent, kind))
+		return false;
+
+	trace_stats.water_hits++;
+	ent->waterlevel = w->waterlevel;
+	ent->watertype = w->watertype;
+	return true;
+}
+
+void G_StoreWaterLevel (edict_t *ent, int kind)
+{
+	watercache_t	*w;
+
+	w = G_WaterCacheSlot (ent);
+	if (!w)
+		return;
+	w->generation = contents_world;
+	w->kind = kind;
+	w->bottom = ent->absmin[2];
+	w->top = ent->absmax[2];
+	w->num_clusters = ent->num_clusters;
+	w->cluster = (ent->num_clusters > 0) ? ent->clusternums[0] : 0;
+	w->headnode = ent->headnode;
+	w->areanum = ent->areanum;
+	w->waterlevel = ent->waterlevel;
+	w->watertype = ent->watertype;
+}
+
+/*
+=================
+G_ClearContentsCache
+
+Called when a level is spawned, loaded or restarted
+=================
+*/
+void G_ClearContentsCache (void)
+{
+	contents_frame++;
+	contents_world++;
+}
+
+/*
+=================
+G_ClearTraceCache
+
+Forgets every remembered trace. Called at the top of each frame, since
+the engine moves clients between frames, and when a level is spawned
+or loaded.
+=================
+*/
+void G_ClearTraceCache (void)
+{
+	trace_generation++;
+	contents_frame++;
+	if (trace_stats.framenum != level.framenum)
+	{
+		trace_stats.last_calls = trace_stats.frame_calls;
+		trace_stats.last_duplicates = trace_stats.frame_duplicates;
+		trace_stats.frame_calls = trace_stats.frame_duplicates = 0;
+		trace_stats.framenum = level.framenum;
+		trace_stats.frames++;
+	}
+}
+
+static int G_CompareTraceSites (const void *a, const void *b)
+{
+	return (*(tracesite_t **)b)->calls - (*(tracesite_t **)a)->calls;
+}
+
+/*
+=================
+Svcmd_TraceStats_f
+
+"sv tracestats [reset]"
+=================
+*/
+void Svcmd_TraceStats_f (void)
+{
+	tracesite_t	*sorted[TRACE_SITES];
+	char		*name;
+	int			i, count, offset;
+
+	if (!Q_strcasecmp (gi.argv(2), "reset"))
+	{
+		memset (&trace_stats, 0, sizeof(trace_stats));
+		memset (trace_sites, 0, sizeof(trace_sites));
+		trace_sites_full = false;
+		safe_cprintf (NULL, PRINT_HIGH, "Trace counts cleared.\n");
+		return;
+	}
+
+	safe_cprintf (NULL, PRINT_HIGH, "traces last frame: %i (%i duplicates)\n",
+		trace_stats.last_calls, trace_stats.last_duplicates);
+	safe_cprintf (NULL, PRINT_HIGH, "traces in total:   %i (%i avg/frame)\n",
+		trace_stats.total_calls, trace_stats.frames ? trace_stats.total_calls / trace_stats.frames : trace_stats.total_calls);
+	safe_cprintf (NULL, PRINT_HIGH, "duplicates:        %i (%i answered by sv_trace_cache)\n",
+		trace_stats.total_duplicates, trace_stats.total_hits);
+	safe_cprintf (NULL, PRINT_HIGH, "contents:          %i (%i cached), water levels %i (%i cached)\n",
+		trace_stats.contents_calls, trace_stats.contents_hits, trace_stats.water_calls, trace_stats.water_hits);
+
+	count = 0;
+	for (i=0 ; i<TRACE_SITES ; i++)
+		if (trace_sites[i].caller)
+			sorted[count++] = &trace_sites[i];
+	qsort (sorted, count, sizeof(sorted[0]), G_CompareTraceSites);
+
+	safe_cprintf (NULL, PRINT_HIGH, "%8s %8s  caller\n", "calls", "dups");
+	for (i=0 ; i<count && i<TRACE_TOP_SITES ; i++)
+	{
+		name = GetFunctionNameNear ((byte *)sorted[i]->caller, &offset);
+		if (name)
+			safe_cprintf (NULL, PRINT_HIGH, "%8i %8i  %s+0x%x\n", sorted[i]->calls, sorted[i]->duplicates, name, offset);
+		else
+			safe_cprintf (NULL, PRINT_HIGH, "%8i %8i  %p\n", sorted[i]->calls, sorted[i]->duplicates, sorted[i]->caller);
+	}
+	if (trace_sites_full)
+		safe_cprintf (NULL, PRINT_HIGH, "(more than %i call sites, some were not counted)\n", TRACE_SITES);
+}
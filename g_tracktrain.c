@@ -141,6 +141,62 @@ void path_track_use (edict_t *self, edict_t *other, edict_t *activator)
 	}
 }
 
+/*
+=================
+path_track list
+
+NextPathTrack looks for the path_tracks that target the one a train is
+on whenever the direct links don't lead anywhere, which used to mean a
+walk over every edict, several times a frame from LookAhead. The
+path_tracks are kept on this list in edict order instead, so that walk
+only sees path_tracks and finds the same one first.
+
+The list does not hold target or target2, which path_track_use swaps
+at will; only which edicts are path_tracks. Entries freed since are
+skipped by the inuse and classname tests NextPathTrack already makes.
+=================
+*/
+static edict_t	*path_tracks[MAX_EDICTS];
+static int		num_path_tracks;
+
+static void path_track_add (edict_t *self)
+{
+	int		i, j;
+
+	for (i = num_path_tracks; i > 0 && path_tracks[i-1] >= self; i--)
+	{
+		if (path_tracks[i-1] == self)
+			return;
+	}
+	if (num_path_tracks == MAX_EDICTS)
+		return;
+	for (j = num_path_tracks; j > i; j--)
+		path_tracks[j] = path_tracks[j-1];
+	path_tracks[i] = self;
+	num_path_tracks++;
+}
+
+/*
+=================
+G_ResetPathTracks
+
+Rebuilds the list from the edicts in the level. Called when a level
+is spawned or loaded.
+=================
+*/
+void G_ResetPathTracks (void)
+{
+	edict_t	*e;
+	int		i;
+
+	num_path_tracks = 0;
+	for (i = 1, e = g_edicts + 1; i < globals.num_edicts; i++, e++)
+	{
+		if (e->inuse && e->classname && !Q_strcasecmp(e->classname, "path_track"))
+			path_tracks[num_path_tracks++] = e;
+	}
+}
+
 void SP_path_track (edict_t *self)
 {
 	if (!self->targetname)
@@ -159,6 +215,7 @@ void SP_path_track (edict_t *self)
 	self->svflags |= SVF_NOCLIENT;
 	if(!self->count) self->count = -1;
 	gi.linkentity (self);
+	path_track_add (self);
 }
 
 /* ============================================================
@@ -1235,9 +1292,9 @@ edict_t *NextPathTrack(edict_t *train, edict_t *path)
 				// the current path_track
 				edict_t	*e;
 				int		i;
-				for(i=maxclients->value; i<globals.num_edicts && !next; i++)
+				for(i=0; i<num_path_tracks && !next; i++)
 				{
-					e = &g_edicts[i];
+					e = path_tracks[i];
 					if(!e->inuse)
 						continue;
 					if(e==path)
@@ -1364,9 +1421,9 @@ edict_t *NextPathTrack(edict_t *train, edict_t *path)
 		{	// Check for path_tracks that target (or target2) this path_track.
 			edict_t	*e;
 			int		i;
-			for(i=maxclients->value; i<globals.num_edicts && !next; i++)
+			for(i=0; i<num_path_tracks && !next; i++)
 			{
-				e = &g_edicts[i];
+				e = path_tracks[i];
 				if(!e->inuse)
 					continue;
 				if(e==path)
@@ -1970,7 +2027,7 @@ void SP_func_tracktrain (edict_t *self)
 	{
 		if(self->sounds > 9)
 			self->sounds = 9;
-		self->source = (char*)gi.TagMalloc(10,TAG_LEVEL);
+		self->source = (char*)G_LevelAlloc(10);
 		sprintf(self->source,"train/%d/",self->sounds);
 		gi.soundindex(va("%sspeed1.wav",self->source));
 		gi.soundindex(va("%sspeed2.wav",self->source));
@@ -2030,7 +2087,7 @@ void find_tracktrain (edict_t *self)
 	train->sounds = self->sounds;
 	if(train->sounds > 0)
 	{
-		train->source = (char*)gi.TagMalloc(10,TAG_LEVEL);
+		train->source = (char*)G_LevelAlloc(10);
 		sprintf(train->source,"train/%d/",train->sounds);
 	}
 	if(train->moveinfo.state && (train->sounds > 0)) {
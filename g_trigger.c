@@ -859,6 +859,103 @@ void SP_trigger_mass (edict_t *self)
 	gi.setmodel (self, self->model);
 	gi.linkentity (self);
 }
+//=======================================================================================
+// Watched volumes - trigger_inside and trigger_scales only change their minds when
+// something is linked or unlinked inside them (a trigger_scales also watches the
+// space above it, where a stack on the scale lives). G_LinkEntity and
+// G_UnlinkEntity hand every link to G_TriggerLinkEvent, which wakes any idle
+// watcher the entity was or is now inside. A watcher that finds nothing to do goes
+// idle (nextthink 0) instead of looking again next frame, so a puzzle room that
+// nobody is in costs nothing. Watchers that don't fit in the table keep polling.
+//=======================================================================================
+#define MAX_TRIGGER_WATCH	64
+
+static edict_t	*trigger_watch[MAX_TRIGGER_WATCH];
+int				trigger_link_count;		// links and unlinks of triggers, ever
+static int		num_trigger_watch;
+
+void trigger_inside_think (edict_t *self);
+void trigger_scales_think (edict_t *self);
+
+static qboolean IsTriggerWatch (edict_t *ent)
+{
+	return ent->inuse && (ent->think == trigger_inside_think || ent->think == trigger_scales_think);
+}
+
+static qboolean TriggerWatched (edict_t *self)
+{
+	int	i;
+
+	for (i=0 ; i<num_trigger_watch ; i++)
+		if (trigger_watch[i] == self)
+			return true;
+	if (num_trigger_watch == MAX_TRIGGER_WATCH)
+		return false;
+	trigger_watch[num_trigger_watch++] = self;
+	return true;
+}
+
+/*
+=================
+G_TriggerLinkEvent
+
+Called for every entity just before and just after it is linked or
+unlinked
+=================
+*/
+void G_TriggerLinkEvent (edict_t *ent)
+{
+	edict_t	*w;
+	int		i;
+
+	if (ent->solid == SOLID_TRIGGER)
+		trigger_link_count++;
+
+	for (i=0 ; i<num_trigger_watch ; i++)
+	{
+		w = trigger_watch[i];
+		if (!IsTriggerWatch (w))
+		{
+			trigger_watch[i--] = trigger_watch[--num_trigger_watch];
+			continue;
+		}
+		if (w->nextthink > 0)
+			continue;		// will look anyway
+		if (w != ent)
+		{
+			if (ent->absmin[0] > w->absmax[0] || ent->absmax[0] < w->absmin[0])
+				continue;
+			if (ent->absmin[1] > w->absmax[1] || ent->absmax[1] < w->absmin[1])
+				continue;
+			if (ent->absmax[2] < w->absmin[2])
+				continue;
+			if (ent->absmin[2] > w->absmax[2] && w->think != trigger_scales_think)
+				continue;
+		}
+		w->nextthink = level.time;
+	}
+}
+
+/*
+=================
+G_ResetTriggerWatches
+
+Called when a level is spawned or loaded
+=================
+*/
+void G_ResetTriggerWatches (void)
+{
+	edict_t	*e;
+	int		i;
+
+	num_trigger_watch = 0;
+	for (i=1, e=g_edicts+i ; i<globals.num_edicts ; i++, e++)
+	{
+		if (IsTriggerWatch (e))
+			TriggerWatched (e);
+	}
+}
+
 //=======================================================================================
 // TRIGGER_INSIDE - triggers its targets when the bounding box for its pathtarget is
 //                  completely inside the trigger field
@@ -890,11 +987,12 @@ void trigger_inside_think (edict_t *self)
 			self->nextthink = level.time + FRAMETIME;
 			self->think = G_FreeEdict;
 		}
-		gi.linkentity(self);
 		return;
 	}
-	self->nextthink = level.time + FRAMETIME;
-	gi.linkentity(self);
+	if (TriggerWatched (self))
+		self->nextthink = 0;
+	else
+		self->nextthink = level.time + FRAMETIME;
 }
 void SP_trigger_inside (edict_t *self)
 {
@@ -920,6 +1018,7 @@ void SP_trigger_inside (edict_t *self)
 	gi.setmodel (self,self->model);
 	self->think     = trigger_inside_think;
 	self->nextthink = level.time + 1.0;
+	TriggerWatched (self);
 	gi.linkentity(self);
 }
 //==================================================================================
@@ -985,8 +1084,10 @@ void trigger_scales_think (edict_t *self)
 				e->s.frame = ( weight % (int)pow(10.0,num) ) / ( pow(10.0,num-1) );
 		}
 	}
-	self->nextthink = level.time + FRAMETIME;
-	gi.linkentity(self);
+	if (TriggerWatched (self))
+		self->nextthink = 0;
+	else
+		self->nextthink = level.time + FRAMETIME;
 }
 
 void SP_trigger_scales (edict_t *self)
@@ -1007,6 +1108,7 @@ void SP_trigger_scales (edict_t *self)
 	self->think     = trigger_scales_think;
 	self->nextthink = level.time + 1.0;
 	self->mass = 0;
+	TriggerWatched (self);
 	gi.linkentity(self);
 }
 //======================================================================================
@@ -1166,7 +1268,6 @@ void SP_trigger_bbox (edict_t *ent)
 
 void trigger_look_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf)
 {
-	trace_t	tr;
 	vec_t	dist;
 	vec3_t	dir, forward, left, up, end, start;
 
@@ -1188,13 +1289,12 @@ void trigger_look_touch (edict_t *self, edict_t *other, cplane_t *plane, csurfac
 		edict_t	*target;
 		int		num_triggered=0;
 		edict_t	*what;
-		vec3_t	endpos;
 
+		what = LookingAt(other,0,NULL,NULL);
 		target = G_Find(NULL,FOFS(targetname),self->target);
-		while(target && !num_triggered)
+		while(target && what && !num_triggered)
 		{
-			what = LookingAt(other,0,endpos,NULL);
-			if(target->inuse && (LookingAt(other,0,NULL,NULL) == target))
+			if(target->inuse && (what == target))
 			{
 				num_triggered++;
 				self->activator = other;
@@ -1230,8 +1330,6 @@ void trigger_look_touch (edict_t *self, edict_t *other, cplane_t *plane, csurfac
 		dist = VectorLength(dir);
 		VectorMA(start,dist,forward,end);
 		
-		tr = gi.trace(start,vec3_origin,vec3_origin,end,other,MASK_OPAQUE);
-		
 		// See if we're looking at origin, within bleft, tright
 		// FIXME: The following is more or less accurate if the
 		// bleft-tright box is roughly a cube. If it's considerably
@@ -1403,34 +1501,14 @@ void SP_trigger_speaker (edict_t *self)
 // moved from one map to another when a target_changelevel with the same
 // targetname is fired. Brush models may NOT be moved.
 //==============================================================================
-void WriteEdict (FILE *f, edict_t *ent);
-
 qboolean HasSpawnFunction(edict_t *ent)
 {
-	spawn_t	*s;
-	gitem_t	*item;
-	int		i;
-
 	if(!ent->classname)
 		return false;
 
-	// check item spawn functions
-	for (i=0,item=itemlist ; i<game.num_items ; i++,item++)
-	{
-		if (!item->classname)
-			continue;
-		if (!strcmp(item->classname, ent->classname))
-			return true;
-	}
-	// check normal spawn functions
-	for (s=spawns ; s->name ; s++)
-	{
-		if (!strcmp(s->name, ent->classname))
-			return true;
-	}
-	return false;
+	return ED_FindSpawn(ent->classname, NULL, NULL);
 }
-void WriteTransitionEdict (FILE *f, edict_t *changelevel, edict_t *ent)
+void WriteTransitionEdict (edict_t *changelevel, edict_t *ent)
 {
 	byte		*temp;
 	edict_t		e;
@@ -1521,7 +1599,7 @@ void WriteTransitionEdict (FILE *f, edict_t *changelevel, edict_t *ent)
 	   (e.svflags & SVF_GIB) )
 	   //(e.health <= e.gib_health) )
 		e.classname = "gibhead";
-	WriteEdict(f,&e);
+	WriteTransitionImage(&e);
 }
 
 entlist_t DoNotMove[] = {
@@ -1574,21 +1652,15 @@ void trans_ent_filename (char *filename)
 
 int trigger_transition_ents (edict_t *changelevel, edict_t *self)
 {
-	char		t_file[_MAX_PATH];
 	int			i, j;
 	int			total=0;
 	qboolean	nogo;
 	edict_t		*ent;
 	entlist_t	*p;
-	FILE		*f;
 
-	trans_ent_filename(t_file);
-	f = fopen(t_file,"wb");
-	if(!f)
-	{
-		gi.dprintf("Error opening %s for writing\n",t_file);
-		return 0;
-	}
+	// Entities are handed to the next map in memory; WriteGame puts
+	// them in save/trans.ent if the game is saved before they arrive
+	BeginTransitionEdicts();
 	// First scan entities for brush models that SHOULD change levels, e.g. func_tracktrain,
 	// which had better have a partner train in the next map... or we'll bitch loudly
 	for(i=game.maxclients+1; i<globals.num_edicts; i++)
@@ -1607,12 +1679,10 @@ int trigger_transition_ents (edict_t *changelevel, edict_t *self)
 			edict_t	*e;
 
 			e = G_Spawn();
-			e->classname = (char*)gi.TagMalloc(17,TAG_LEVEL);
-			strcpy(e->classname,"info_train_start");
-			e->targetname = (char*)gi.TagMalloc(strlen(ent->targetname)+1,TAG_LEVEL);
-			strcpy(e->targetname,ent->targetname);
-			e->target = (char*)gi.TagMalloc(strlen(ent->target)+1,TAG_LEVEL);
-			strcpy(e->target,ent->target);
+			e->classname = G_LevelString("info_train_start");
+			e->targetname = G_LevelString(ent->targetname);
+			G_IndexEdict(e);
+			e->target = G_LevelString(ent->target);
 			e->spawnflags = ent->spawnflags;
 			VectorCopy(ent->s.origin,e->s.origin);
 			VectorCopy(ent->s.angles,e->s.angles);
@@ -1671,7 +1741,7 @@ int trigger_transition_ents (edict_t *changelevel, edict_t *self)
 			ent->owner_id = -(ent->owner - g_edicts);
 		else
 			ent->owner_id = 0;
-		WriteTransitionEdict(f,changelevel,ent);
+		WriteTransitionEdict(changelevel,ent);
 		gi.unlinkentity(ent);
 		ent->inuse = false;
 	}
@@ -1706,13 +1776,11 @@ int trigger_transition_ents (edict_t *changelevel, edict_t *self)
 		if(!ent->owner_id) continue;
 		total++;
 		ent->id = total;
-		WriteTransitionEdict(f,changelevel,ent);
+		WriteTransitionEdict(changelevel,ent);
 		gi.unlinkentity(ent);
 		ent->inuse = false;
 	}
 
-	fflush(f);
-	fclose(f);
 	return total;
 }
 
@@ -1818,18 +1886,10 @@ void trigger_switch_usetargets (edict_t *ent, edict_t *activator)
 //
 	if (ent->delay)
 	{
-	// create a temp object to fire at a later time
-		t = G_Spawn();
-		t->classname = "DelayedUse";
-		t->nextthink = level.time + ent->delay;
-		t->think = trigger_switch_delay;
-		t->activator = activator;
+	// queue it to fire at a later time
 		if (!activator)
 			gi.dprintf ("Delay with no activator\n");
-		t->message = ent->message;
-		t->target = ent->target;
-		t->killtarget = ent->killtarget;
-		t->noise_index = ent->noise_index;
+		G_DelayUse (DELAY_SWITCH, ent, activator, NULL);
 		return;
 	}
 	
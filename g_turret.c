@@ -74,16 +74,17 @@ edict_t	*TurretTarget(edict_t *self)
 		if (who->solid == SOLID_NOT)
 			continue;
 		VectorMA(who->absmin,0.5,who->size,end);
-		tr = gi.trace (start, vec3_origin, vec3_origin, end, self, MASK_OPAQUE);
-		if(tr.fraction < 1.0)
-			continue;
 		VectorSubtract(end, self->s.origin, dir);
 		VectorNormalize(dir);
 		d = DotProduct(forward, dir);
-		if (d > bd) {
-			bd = d;
-			best = who;
-		}
+		// Lazarus: only trace to those that would be picked
+		if (d <= bd || d <= 0.90)
+			continue;
+		tr = gi.trace (start, vec3_origin, vec3_origin, end, self, MASK_OPAQUE);
+		if(tr.fraction < 1.0)
+			continue;
+		bd = d;
+		best = who;
 	}
 	if (bd > 0.90)
 		return best;
@@ -668,6 +669,165 @@ void turret_turn (edict_t *self)
 	}
 }
 
+/*
+=================
+Turret targets
+
+Every tracking turret used to sweep all edicts for monsters and again
+for clients each frame, and trace to each one in its PVS. The monsters
+and clients worth a look are now gathered once a frame and shared by
+all turrets. Each turret then sorts the ones in its PVS and arc by
+distance and traces nearest first, stopping at the first it can hit,
+which is the one the old nearest-hit search settled on.
+
+The lists hold candidates only. Entries are tested again at use, since
+a turret earlier in the frame may have killed or freed them.
+=================
+*/
+typedef struct
+{
+	edict_t	*ent;
+	float	dist;
+} turretcand_t;
+
+static edict_t		*turret_monsters[MAX_EDICTS];
+static edict_t		*turret_clients[MAX_EDICTS];
+static int			num_turret_monsters, num_turret_clients;
+static int			turret_listframe = -1;
+static turretcand_t	turret_cands[MAX_EDICTS];
+
+/*
+=================
+turret_reset_targets
+
+Called when a level is spawned or loaded
+=================
+*/
+void turret_reset_targets (void)
+{
+	turret_listframe = -1;
+	num_turret_monsters = num_turret_clients = 0;
+}
+
+static void turret_build_targets (void)
+{
+	edict_t	*gomer;
+	int		i;
+
+	if (turret_listframe == level.framenum)
+		return;
+	turret_listframe = level.framenum;
+	num_turret_monsters = num_turret_clients = 0;
+
+	for (i=1, gomer=g_edicts+1; i<globals.num_edicts; i++, gomer++)
+	{
+		if (!gomer->inuse)
+			continue;
+		if (gomer->svflags & SVF_NOCLIENT)
+			continue;
+		if (gomer->health < gomer->gib_health)
+			continue;
+		if ((gomer->svflags & SVF_MONSTER) && (i > maxclients->value))
+			turret_monsters[num_turret_monsters++] = gomer;
+		if (gomer->client && !(gomer->flags & FL_NOTARGET))
+			turret_clients[num_turret_clients++] = gomer;
+	}
+}
+
+static int turret_compare_cands (const void *a, const void *b)
+{
+	const turretcand_t	*ca = (const turretcand_t *)a;
+	const turretcand_t	*cb = (const turretcand_t *)b;
+
+	if (ca->dist < cb->dist)
+		return -1;
+	if (ca->dist > cb->dist)
+		return 1;
+	// same distance: the earlier edict, as the old sweep would have kept
+	return (int)(ca->ent - cb->ent);
+}
+
+/*
+=================
+turret_hunt
+
+Picks from list the nearest target under best_dist that is in the
+turret's PVS and arc and that a trace from the barrel reaches. Makes it
+the turret's enemy and lowers best_dist to its distance.
+=================
+*/
+static void turret_hunt (edict_t *self, edict_t **list, int count, qboolean monsters,
+						 float *best_dist, qboolean yaw_restrict, float yaw_r)
+{
+	edict_t	*gomer;
+	trace_t	tr;
+	vec3_t	target, dir, f, t_start, angles;
+	float	dist, yaw_0 = 0;
+	int		i, num;
+
+	num = 0;
+	for (i=0; i<count; i++)
+	{
+		gomer = list[i];
+		if(monsters)
+		{
+			if(gomer == self->enemy) continue; // no need to re-check this guy
+			if(!gomer->inuse) continue;
+			if(!(gomer->svflags & SVF_MONSTER)) continue;
+			if(gomer->health < gomer->gib_health) continue;
+			if(gomer->svflags & SVF_NOCLIENT) continue;
+		}
+		else
+		{
+			if(!gomer->inuse) continue;
+			if(!gomer->client) continue;
+			if(gomer->svflags & SVF_NOCLIENT) continue;
+			if(gomer->health < gomer->gib_health) continue;
+			if(gomer->flags & FL_NOTARGET) continue;
+		}
+		if(!gi.inPVS(self->s.origin,gomer->s.origin)) continue;
+		VectorMA(gomer->absmin,0.5,gomer->size,target);
+		VectorSubtract(target,self->s.origin,dir);
+		dist = VectorLength(dir);
+		if(dist >= *best_dist) continue;
+		vectoangles(dir,angles);
+		AnglesNormalize(angles);
+		if ( yaw_restrict )
+		{
+			yaw_0  = angles[YAW] - self->pos1[YAW];
+			if(yaw_0 < 0)
+				yaw_0 += 360;
+		}
+		if( (angles[PITCH] > self->pos1[PITCH]) || (angles[PITCH] < self->pos2[PITCH]) ||
+			( yaw_restrict && (yaw_0 > yaw_r) ) )
+			continue;
+		turret_cands[num].ent = gomer;
+		turret_cands[num].dist = dist;
+		num++;
+	}
+
+	if (num > 1)
+		qsort (turret_cands, num, sizeof(turret_cands[0]), turret_compare_cands);
+
+	for (i=0; i<num; i++)
+	{
+		gomer = turret_cands[i].ent;
+		VectorMA(gomer->absmin,0.5,gomer->size,target);
+		VectorCopy(self->s.origin,t_start);
+		VectorSubtract(target,self->s.origin,dir);
+		VectorCopy(dir,f);
+		VectorNormalize(f);
+		VectorMA(t_start,self->teammaster->base_radius,f,t_start);
+		tr = gi.trace(t_start,vec3_origin,vec3_origin,target,self,MASK_SHOT);
+		if(tr.ent == gomer)
+		{
+			self->enemy = gomer;
+			*best_dist = turret_cands[i].dist;
+			return;
+		}
+	}
+}
+
 void turret_breach_think (edict_t *self)
 {
 	edict_t		*ent;
@@ -843,9 +1003,7 @@ void turret_breach_think (edict_t *self)
 		// TRACK - automated turret
 		float	reaction_time;
 		vec3_t	f, forward, right, up, start, t_start;
-		edict_t	*gomer;
 		float	best_dist = 8192;
-		float	dist;
 
 		if(self->viewer && level.time < self->touch_debounce_time)
 			return;
@@ -908,43 +1066,9 @@ void turret_breach_think (edict_t *self)
 		}
 			
 		// hunt for monster
-		if(!remote_monster) {
-			for(i=maxclients->value+1; i<globals.num_edicts; i++) {
-				gomer = g_edicts + i;
-				if(gomer == self->enemy) continue; // no need to re-check this guy
-				if(!gomer->inuse) continue;
-				if(!(gomer->svflags & SVF_MONSTER)) continue;
-				if(gomer->health < gomer->gib_health) continue;
-				if(gomer->svflags & SVF_NOCLIENT) continue;
-				if(!gi.inPVS(self->s.origin,gomer->s.origin)) continue;
-				VectorMA(gomer->absmin,0.5,gomer->size,target);
-				VectorCopy(self->s.origin,t_start);
-				VectorSubtract(target,self->s.origin,dir);
-				VectorCopy(dir,f);
-				VectorNormalize(f);
-				VectorMA(t_start,self->teammaster->base_radius,f,t_start);
-				tr = gi.trace(t_start,vec3_origin,vec3_origin,target,self,MASK_SHOT);
-				if(tr.ent == gomer) {
-					vectoangles(dir,angles);
-					AnglesNormalize(angles);
-					if ( yaw_restrict )
-					{
-						yaw_0  = angles[YAW] - self->pos1[YAW];
-						if(yaw_0 < 0)
-							yaw_0 += 360;
-					}
-					if( (angles[PITCH] <= self->pos1[PITCH]) && (angles[PITCH] >= self->pos2[PITCH]) &&
-						( !yaw_restrict || (yaw_0 <= yaw_r) )
-						) {
-						dist = VectorLength(dir);
-						if(dist < best_dist) {
-							self->enemy = gomer;
-							best_dist = dist;
-						}
-					}
-				}
-			}
-		}
+		turret_build_targets ();
+		if(!remote_monster)
+			turret_hunt (self, turret_monsters, num_turret_monsters, true, &best_dist, yaw_restrict, yaw_r);
 		// for weapon-firing turrets, if GOODGUY is set and we already have an enemy, we're
 		// done.
 		if( (self->sounds >= 0) && (self->spawnflags & SF_TURRET_GOODGUY) && self->enemy)
@@ -957,41 +1081,7 @@ void turret_breach_think (edict_t *self)
 
 		// hunt for closest player - hunt ALL entities since
 		// we want to view fake players using camera
-		for(i=1; i<globals.num_edicts; i++) {
-			gomer = g_edicts + i;
-			if(!gomer->inuse) continue;
-			if(!gomer->client) continue;
-			if(gomer->svflags & SVF_NOCLIENT) continue;
-			if(gomer->health < gomer->gib_health) continue;
-			if(gomer->flags & FL_NOTARGET) continue;
-			if(!gi.inPVS(self->s.origin,gomer->s.origin)) continue;
-			VectorMA(gomer->absmin,0.5,gomer->size,target);
-
-			VectorCopy(self->s.origin,t_start);
-			VectorSubtract(target,self->s.origin,dir);
-			VectorCopy(dir,f);
-			VectorNormalize(f);
-			VectorMA(t_start,self->teammaster->base_radius,f,t_start);
-			tr = gi.trace(t_start,vec3_origin,vec3_origin,target,self,MASK_SHOT);
-			if(tr.ent == gomer) {
-				vectoangles(dir,angles);
-				AnglesNormalize(angles);
-				if ( yaw_restrict )
-				{
-					yaw_0  = angles[YAW] - self->pos1[YAW];
-					if(yaw_0 < 0)
-						yaw_0 += 360;
-				}
-				if( (angles[PITCH] <= self->pos1[PITCH]) && (angles[PITCH] >= self->pos2[PITCH]) &&
-					( !yaw_restrict || (yaw_0 <= yaw_r) ) ) {
-					dist = VectorLength(dir);
-					if(dist < best_dist) {
-						self->enemy = gomer;
-						best_dist = dist;
-					}
-				}
-			}
-		}
+		turret_hunt (self, turret_clients, num_turret_clients, false, &best_dist, yaw_restrict, yaw_r);
 
 good_enemy:
 		if(self->enemy)
@@ -38,6 +38,249 @@ void G_ProjectSource2 (vec3_t point, vec3_t distance, vec3_t forward, vec3_t rig
 	result[2] = point[2] + forward[2] * distance[0] + right[2] * distance[1] + up[2] * distance[2];
 }
 
+/*
+=============
+Edict field indexes
+
+Lazarus maps routinely have well over a thousand entities, and every
+trigger chain goes through G_Find (..., FOFS(targetname), ...), as does
+every hit on a monster on a dmgteam through CallMyFriends. Edicts with a
+targetname or dmgteam are kept in hash buckets sorted by edict number,
+one set of buckets per field, so a search only walks the edicts sharing
+a bucket and still returns them in the same order a full scan would.
+
+The indexes are kept current by ED_ParseField, G_FreeEdict and the
+save/load code. Anything that swaps one of the pointers behind our back
+is caught by G_RefreshEdictIndexes at the start of the next frame; until
+then a search may miss the edict, but never returns one whose field no
+longer matches.
+=============
+*/
+#define	FIELDINDEX_HASH_SIZE	1024	// must be a power of 2
+
+typedef struct
+{
+	int		fieldofs;
+	int		head[FIELDINDEX_HASH_SIZE];	// first edict number in each bucket, -1 if empty
+	int		*next;		// next edict number in the same bucket, -1 at end
+	int		*bucket;	// bucket the edict is linked into, -1 if not indexed
+	char	**key;		// string pointer the edict was indexed with
+} fieldindex_t;
+
+#define	NUM_FIELDINDEXES	2
+
+static fieldindex_t	fieldindexes[NUM_FIELDINDEXES] =
+{
+	{FOFS(targetname)},
+	{FOFS(dmgteam)}
+};
+static int		fi_size;
+static int		fi_serial;		// goes up whenever an edict is filed or unfiled
+
+#define	FI_FIELD(ent,fi)	(*(char **)((byte *)(ent) + (fi)->fieldofs))
+
+static int G_FieldIndexHash (const char *s)
+{
+	// case-insensitive, to agree with Q_strcasecmp
+	return ED_StringHash (s) & (FIELDINDEX_HASH_SIZE - 1);
+}
+
+static fieldindex_t *G_FieldIndex (int fieldofs)
+{
+	int		i;
+
+	if (!fi_size)
+		return NULL;
+	for (i=0 ; i<NUM_FIELDINDEXES ; i++)
+		if (fieldindexes[i].fieldofs == fieldofs)
+			return &fieldindexes[i];
+	return NULL;
+}
+
+/*
+=============
+G_ClearEdictIndexes
+
+Empties the indexes, (re)allocating them if game.maxentities has grown.
+Called whenever g_edicts is wiped.
+=============
+*/
+void G_ClearEdictIndexes (void)
+{
+	fieldindex_t	*fi;
+	int				i, j;
+
+	for (j=0, fi=fieldindexes ; j<NUM_FIELDINDEXES ; j++, fi++)
+	{
+		if (fi_size < game.maxentities)
+		{
+			if (fi->next)
+			{
+				gi.TagFree (fi->next);
+				gi.TagFree (fi->bucket);
+				gi.TagFree (fi->key);
+			}
+			fi->next   = (int *)gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+			fi->bucket = (int *)gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+			fi->key    = (char **)gi.TagMalloc (game.maxentities * sizeof(char *), TAG_GAME);
+		}
+
+		for (i=0 ; i<FIELDINDEX_HASH_SIZE ; i++)
+			fi->head[i] = -1;
+		for (i=0 ; i<game.maxentities ; i++)
+		{
+			fi->next[i] = -1;
+			fi->bucket[i] = -1;
+			fi->key[i] = NULL;
+		}
+	}
+	if (fi_size < game.maxentities)
+		fi_size = game.maxentities;
+	fi_serial++;
+}
+
+static void G_UnindexField (fieldindex_t *fi, int num)
+{
+	int		*link;
+
+	if (fi->bucket[num] < 0)
+		return;
+
+	fi_serial++;
+	for (link = &fi->head[fi->bucket[num]] ; *link >= 0 ; link = &fi->next[*link])
+	{
+		if (*link == num)
+		{
+			*link = fi->next[num];
+			break;
+		}
+	}
+	fi->next[num] = -1;
+	fi->bucket[num] = -1;
+	fi->key[num] = NULL;
+}
+
+static void G_IndexField (fieldindex_t *fi, edict_t *ent, int num)
+{
+	char	*value;
+	int		bucket, *link;
+
+	G_UnindexField (fi, num);
+	value = FI_FIELD(ent, fi);
+	if (!value)
+		return;
+
+	// keep buckets sorted by edict number so G_Find order is unchanged
+	bucket = G_FieldIndexHash (value);
+	for (link = &fi->head[bucket] ; *link >= 0 && *link < num ; link = &fi->next[*link])
+		;
+	fi->next[num] = *link;
+	*link = num;
+	fi->bucket[num] = bucket;
+	fi->key[num] = value;
+	fi_serial++;
+}
+
+/*
+=============
+G_UnindexEdict
+=============
+*/
+void G_UnindexEdict (edict_t *ent)
+{
+	int		num, j;
+
+	num = ent - g_edicts;
+	if (num < 0 || num >= fi_size)
+		return;
+
+	for (j=0 ; j<NUM_FIELDINDEXES ; j++)
+		G_UnindexField (&fieldindexes[j], num);
+}
+
+/*
+=============
+G_IndexEdict
+
+(Re)files ent under its current targetname and dmgteam. Call this after
+changing either.
+=============
+*/
+void G_IndexEdict (edict_t *ent)
+{
+	int		num, j;
+
+	num = ent - g_edicts;
+	if (num < 0 || num >= fi_size)
+		return;
+
+	for (j=0 ; j<NUM_FIELDINDEXES ; j++)
+		G_IndexField (&fieldindexes[j], ent, num);
+}
+
+/*
+=============
+G_RefreshEdictIndexes
+
+Cheap pointer sweep that picks up fields changed without a call to
+G_IndexEdict, and drops edicts that were freed by a memset.
+=============
+*/
+void G_RefreshEdictIndexes (void)
+{
+	fieldindex_t	*fi;
+	edict_t			*ent;
+	char			*value;
+	int				i, j;
+
+	for (i=0, ent=g_edicts ; i<globals.num_edicts && i<fi_size ; i++, ent++)
+	{
+		for (j=0, fi=fieldindexes ; j<NUM_FIELDINDEXES ; j++, fi++)
+		{
+			value = ent->inuse ? FI_FIELD(ent, fi) : NULL;
+			if (value != fi->key[i])
+			{
+				if (value)
+					G_IndexField (fi, ent, i);
+				else
+					G_UnindexField (fi, i);
+			}
+		}
+	}
+}
+
+/*
+=============
+G_FindIndexed
+
+G_Find for an indexed field
+=============
+*/
+static edict_t *G_FindIndexed (fieldindex_t *fi, edict_t *from, char *match)
+{
+	int		num, start;
+	edict_t	*ent;
+	char	*value;
+
+	start = from ? (from - g_edicts) + 1 : 0;
+
+	for (num = fi->head[G_FieldIndexHash(match)] ; num >= 0 ; num = fi->next[num])
+	{
+		if (num < start)
+			continue;
+		if (num >= globals.num_edicts)
+			break;
+		ent = &g_edicts[num];
+		if (!ent->inuse)
+			continue;
+		value = FI_FIELD(ent, fi);
+		if (value && (value == match || !Q_strcasecmp (value, match)))
+			return ent;
+	}
+
+	return NULL;
+}
+
 /*
 =============
 G_Find
@@ -52,7 +295,11 @@ NULL will be returned if the end of the list is reached.
 */
 edict_t *G_Find (edict_t *from, int fieldofs, char *match)
 {
-	char	*s;
+	fieldindex_t	*fi;
+	char			*s;
+
+	if (match && (fi = G_FieldIndex (fieldofs)) != NULL)
+		return G_FindIndexed (fi, from, match);
 
 	if (!from)
 		from = g_edicts;
@@ -66,7 +313,8 @@ edict_t *G_Find (edict_t *from, int fieldofs, char *match)
 		s = *(char **) ((byte *)from + fieldofs);
 		if (!s)
 			continue;
-		if (!Q_strcasecmp (s, match))
+		// interned keys match by pointer
+		if (s == match || !Q_strcasecmp (s, match))
 			return from;
 	}
 
@@ -109,6 +357,175 @@ edict_t *findradius (edict_t *from, vec3_t org, float rad)
 }
 
 
+/*
+=================
+G_FindRadiusBatch
+
+Fills list with every entity findradius (NULL..., org, rad) would walk
+through, in the same edict order, and returns how many were found.
+Candidates come from the server's area tree with gi.BoxEdicts rather
+than a sweep over every edict, and distances are compared squared.
+
+Entities in the list may be freed by the caller while it processes
+earlier entries, so check inuse before touching them.
+=================
+*/
+static int G_EdictOrder (const void *a, const void *b)
+{
+	return (int)(*(edict_t **)a - *(edict_t **)b);
+}
+
+int G_FindRadiusBatch (vec3_t org, float rad, edict_t **list, int maxcount)
+{
+	vec3_t	mins, maxs, eorg;
+	int		i, j, num, count;
+	float	rad2;
+	edict_t	*ent;
+
+	for (j=0 ; j<3 ; j++)
+	{
+		mins[j] = org[j] - rad;
+		maxs[j] = org[j] + rad;
+	}
+	num  = gi.BoxEdicts (mins, maxs, list, maxcount, AREA_SOLID);
+	num += gi.BoxEdicts (mins, maxs, list + num, maxcount - num, AREA_TRIGGERS);
+
+	rad2 = rad * rad;
+	count = 0;
+	for (i=0 ; i<num ; i++)
+	{
+		ent = list[i];
+		if (!ent->inuse)
+			continue;
+		if (ent->solid == SOLID_NOT)
+			continue;
+		for (j=0 ; j<3 ; j++)
+			eorg[j] = org[j] - (ent->s.origin[j] + (ent->mins[j] + ent->maxs[j])*0.5);
+		if (DotProduct(eorg, eorg) > rad2)
+			continue;
+		list[count++] = ent;
+	}
+
+	// area lists come back in link order; callers expect edict order
+	if (count > 1)
+		qsort (list, count, sizeof(list[0]), G_EdictOrder);
+
+	return count;
+}
+
+
+/*
+=================
+G_SegmentHits
+
+Fills hits with every SOLID_BBOX entity a point trace from start to end
+would run into if it went straight through each one, nearest first,
+and returns how many there are. passent and what it owns (or is owned
+by) are left out, as gi.trace does; contentmask says whether monsters
+and dead monsters count. One that start is already inside is hit at
+fraction 0.
+
+Candidates come from the area tree along the segment's bounds, and each
+box is clipped against the segment directly. The world and brush models
+aren't looked at, so end should already be where a trace that ignores
+boxes stops.
+=================
+*/
+static int G_SegmentHitOrder (const void *a, const void *b)
+{
+	float	d = ((segmenthit_t *)a)->fraction - ((segmenthit_t *)b)->fraction;
+
+	if (d < 0)
+		return -1;
+	return (d > 0);
+}
+
+int G_SegmentHits (vec3_t start, vec3_t end, edict_t *passent, int contentmask, segmenthit_t *hits, int maxhits)
+{
+	edict_t		*list[MAX_EDICTS];
+	edict_t		*ent;
+	vec3_t		mins, maxs, dir;
+	float		enter, leave, t0, t1, d;
+	int			i, j, num, count, axis;
+
+	for (j=0 ; j<3 ; j++)
+	{
+		mins[j] = min(start[j], end[j]);
+		maxs[j] = max(start[j], end[j]);
+	}
+	VectorSubtract (end, start, dir);
+	num = gi.BoxEdicts (mins, maxs, list, MAX_EDICTS, AREA_SOLID);
+
+	count = 0;
+	for (i=0 ; i<num && count<maxhits ; i++)
+	{
+		ent = list[i];
+		if (!ent->inuse || ent->solid != SOLID_BBOX)
+			continue;
+		if (passent && (ent == passent || ent->owner == passent || passent->owner == ent))
+			continue;
+		if (!(contentmask & ((ent->svflags & SVF_DEADMONSTER) ? CONTENTS_DEADMONSTER : CONTENTS_MONSTER)))
+			continue;
+
+		// slab test against origin + mins/maxs, which is the box the
+		// engine clips against
+		enter = 0;
+		leave = 1;
+		axis = -1;
+		for (j=0 ; j<3 ; j++)
+		{
+			mins[j] = ent->s.origin[j] + ent->mins[j];
+			maxs[j] = ent->s.origin[j] + ent->maxs[j];
+			if (dir[j] == 0)
+			{
+				if (start[j] < mins[j] || start[j] > maxs[j])
+					break;
+				continue;
+			}
+			d = 1.0 / dir[j];
+			t0 = (mins[j] - start[j]) * d;
+			t1 = (maxs[j] - start[j]) * d;
+			if (t0 > t1)
+			{
+				d = t0;
+				t0 = t1;
+				t1 = d;
+			}
+			if (t0 > enter)
+			{
+				enter = t0;
+				axis = j;
+			}
+			if (t1 < leave)
+				leave = t1;
+			if (enter > leave)
+				break;
+		}
+		if (j < 3)
+			continue;
+
+		hits[count].ent = ent;
+		hits[count].fraction = enter;
+		VectorMA (start, enter, dir, hits[count].endpos);
+		VectorClear (hits[count].normal);
+		if (axis >= 0)
+			hits[count].normal[axis] = (dir[axis] > 0) ? -1 : 1;
+		else
+		{
+			// started inside it
+			VectorNormalize2 (dir, hits[count].normal);
+			VectorInverse (hits[count].normal);
+		}
+		count++;
+	}
+
+	if (count > 1)
+		qsort (hits, count, sizeof(hits[0]), G_SegmentHitOrder);
+
+	return count;
+}
+
+
 /*
 =============
 G_PickTarget
@@ -147,14 +564,285 @@ edict_t *G_PickTarget (char *targetname)
 
 	if (!num_choices)
 	{
-		gi.dprintf("G_PickTarget: target %s not found\n", targetname);
-		return NULL;
+		gi.dprintf("G_PickTarget: target %s not found\n", targetname);
+		return NULL;
+	}
+
+	return choice[rand() % num_choices];
+}
+
+
+
+/*
+=============
+G_PickRoute
+
+G_PickTarget (ent->target) for the waypoints misc_actor and monsters
+walk: path_corner, target_actor, point_combat and the walker itself.
+What a waypoint's target names is looked up once and kept in a table
+indexed by edict number, as long as no targetname anywhere has been
+filed or unfiled since and ent->target is still the same string. Each
+pick after that is only a random index into the list.
+=============
+*/
+typedef struct
+{
+	int		serial;			// fi_serial when looked up, 0 if never
+	char	*target;
+	int		num;
+	edict_t	*choice[MAXCHOICES];
+} route_t;
+
+static route_t	*routes;		// game.maxentities
+
+edict_t *G_PickRoute (edict_t *ent)
+{
+	route_t	*route;
+	edict_t	*e;
+	int		num, i;
+
+	if (!ent->target)
+	{
+		gi.dprintf("G_PickTarget called with NULL targetname\n");
+		return NULL;
+	}
+
+	num = ent - g_edicts;
+	if (!routes)
+		routes = (route_t *)gi.TagMalloc (game.maxentities * sizeof(route_t), TAG_GAME);
+	route = &routes[num];
+
+	for (i=0 ; i<route->num ; i++)
+		if (!route->choice[i]->inuse)
+			break;
+	if (route->serial != fi_serial || route->target != ent->target || i < route->num)
+	{
+		route->serial = fi_serial;
+		route->target = ent->target;
+		route->num = 0;
+		for (e = G_Find (NULL, FOFS(targetname), ent->target) ; e && route->num < MAXCHOICES ; e = G_Find (e, FOFS(targetname), ent->target))
+			route->choice[route->num++] = e;
+	}
+
+	if (!route->num)
+	{
+		gi.dprintf("G_PickTarget: target %s not found\n", ent->target);
+		return NULL;
+	}
+
+	return route->choice[rand() % route->num];
+}
+
+
+/*
+==============================================================================
+
+DELAYED USES
+
+An entity with a delay used to spawn a "DelayedUse" edict to fire its
+targets later, and relay-heavy maps could have hundreds of them coming
+and going, each one a G_Spawn and a slot left waiting out its freetime.
+Now the use is put on a queue (a heap on fire time, so the next one due
+is always on top) and fired by G_RunFrame just before the entities run.
+
+What gets fired still needs an edict to be "other" to the targets' use
+functions, so one DelayedUse edict without a think is kept for the level
+and given each use's fields in turn. The queue is saved with the level.
+The Think_Delay functions stay for DelayedUse edicts in older saves.
+
+==============================================================================
+*/
+#define	DELAYED_USES_MIN	64
+
+static delayeduse_t	*delayed_uses;		// TAG_LEVEL heap
+static int			num_delayed_uses;
+static int			max_delayed_uses;
+static int			delayed_use_seq;
+static edict_t		*delayed_use_proxy;
+
+static qboolean DelayedUseBefore (delayeduse_t *a, delayeduse_t *b)
+{
+	if (a->time != b->time)
+		return a->time < b->time;
+	return a->seq < b->seq;		// in the order they were queued
+}
+
+static void DelayedUsePush (delayeduse_t *d)
+{
+	delayeduse_t	*grown, swap;
+	int				i, parent;
+
+	if (num_delayed_uses == max_delayed_uses)
+	{
+		max_delayed_uses = max_delayed_uses ? max_delayed_uses * 2 : DELAYED_USES_MIN;
+		grown = gi.TagMalloc (max_delayed_uses * sizeof(delayeduse_t), TAG_LEVEL);
+		if (num_delayed_uses)
+			memcpy (grown, delayed_uses, num_delayed_uses * sizeof(delayeduse_t));
+		if (delayed_uses)
+			gi.TagFree (delayed_uses);
+		delayed_uses = grown;
+	}
+
+	i = num_delayed_uses++;
+	delayed_uses[i] = *d;
+	while (i > 0)
+	{
+		parent = (i - 1) / 2;
+		if (!DelayedUseBefore (&delayed_uses[i], &delayed_uses[parent]))
+			break;
+		swap = delayed_uses[i];
+		delayed_uses[i] = delayed_uses[parent];
+		delayed_uses[parent] = swap;
+		i = parent;
+	}
+}
+
+static void DelayedUsePop (delayeduse_t *out)
+{
+	delayeduse_t	swap;
+	int				i, child;
+
+	*out = delayed_uses[0];
+	delayed_uses[0] = delayed_uses[--num_delayed_uses];
+	i = 0;
+	while ((child = 2*i + 1) < num_delayed_uses)
+	{
+		if (child + 1 < num_delayed_uses && DelayedUseBefore (&delayed_uses[child+1], &delayed_uses[child]))
+			child++;
+		if (!DelayedUseBefore (&delayed_uses[child], &delayed_uses[i]))
+			break;
+		swap = delayed_uses[i];
+		delayed_uses[i] = delayed_uses[child];
+		delayed_uses[child] = swap;
+		i = child;
+	}
+}
+
+static edict_t *DelayedUseProxy (void)
+{
+	edict_t	*e;
+	int		i;
+
+	e = delayed_use_proxy;
+	if (e && e->inuse && !e->think && e->classname && !strcmp(e->classname, "DelayedUse"))
+		return e;
+
+	// a loaded level brings its own
+	for (i=maxclients->value+1, e=g_edicts+i ; i<globals.num_edicts ; i++, e++)
+		if (e->inuse && !e->think && e->classname && !strcmp(e->classname, "DelayedUse"))
+			break;
+	if (i == globals.num_edicts)
+	{
+		e = G_Spawn ();
+		e->classname = "DelayedUse";
+		e->svflags |= SVF_NOCLIENT;
+	}
+	delayed_use_proxy = e;
+	return e;
+}
+
+/*
+=================
+G_DelayUse
+
+Queues a use of ent's targets for ent->delay seconds from now
+=================
+*/
+void G_DelayUse (int kind, edict_t *ent, edict_t *activator, edict_t *target)
+{
+	delayeduse_t	d;
+
+	memset (&d, 0, sizeof(d));
+	d.time = level.time + ent->delay;
+	d.kind = kind;
+	d.activator = activator;
+	d.target_ent = target;
+	d.message = ent->message;
+	d.target = ent->target;
+	d.killtarget = ent->killtarget;
+	d.noise_index = ent->noise_index;
+	G_RestoreDelayedUse (&d);
+}
+
+/*
+=================
+G_RestoreDelayedUse
+
+Puts a use back on the queue, as ReadLevel does with saved ones
+=================
+*/
+void G_RestoreDelayedUse (delayeduse_t *d)
+{
+	d->seq = delayed_use_seq++;
+	DelayedUsePush (d);
+}
+
+/*
+=================
+G_DelayedUses
+
+The queue as it stands, for WriteLevel
+=================
+*/
+int G_DelayedUses (delayeduse_t **list)
+{
+	*list = delayed_uses;
+	return num_delayed_uses;
+}
+
+/*
+=================
+G_RunDelayedUses
+
+Fires every use that is due. Called each frame by G_RunFrame.
+=================
+*/
+void G_RunDelayedUses (void)
+{
+	delayeduse_t	d;
+	edict_t			*t;
+
+	while (num_delayed_uses && delayed_uses[0].time <= level.time + 0.001)
+	{
+		DelayedUsePop (&d);
+		t = DelayedUseProxy ();
+		t->activator = d.activator;
+		t->target_ent = d.target_ent;
+		t->message = d.message;
+		t->target = d.target;
+		t->killtarget = d.killtarget;
+		t->noise_index = d.noise_index;
+		switch (d.kind)
+		{
+		case DELAY_USETARGET:
+			G_UseTarget (t, t->activator, t->target_ent);
+			break;
+		case DELAY_SWITCH:
+			trigger_switch_usetargets (t, t->activator);
+			break;
+		default:
+			G_UseTargets (t, t->activator);
+			break;
+		}
 	}
-
-	return choice[rand() % num_choices];
 }
 
+/*
+=================
+G_ResetDelayedUses
 
+Empties the queue when a level is spawned or loaded. The heap is
+TAG_LEVEL memory, already freed by then.
+=================
+*/
+void G_ResetDelayedUses (void)
+{
+	delayed_uses = NULL;
+	num_delayed_uses = 0;
+	max_delayed_uses = 0;
+	delayed_use_seq = 0;
+	delayed_use_proxy = NULL;
+}
 
 void Think_Delay (edict_t *ent)
 {
@@ -187,18 +875,10 @@ void G_UseTargets (edict_t *ent, edict_t *activator)
 //
 	if (ent->delay)
 	{
-	// create a temp object to fire at a later time
-		t = G_Spawn();
-		t->classname = "DelayedUse";
-		t->nextthink = level.time + ent->delay;
-		t->think = Think_Delay;
-		t->activator = activator;
+	// queue it to fire at a later time
 		if (!activator)
 			gi.dprintf ("Think_Delay with no activator\n");
-		t->message = ent->message;
-		t->target = ent->target;
-		t->killtarget = ent->killtarget;
-		t->noise_index = ent->noise_index;
+		G_DelayUse (DELAY_USETARGETS, ent, activator, NULL);
 		return;
 	}
 	
@@ -454,46 +1134,645 @@ void vectoangles2 (vec3_t value1, vec3_t angles)
 		else if (value1[1] > 0)
 			yaw = 90;
 		else
-			yaw = 270;
+			yaw = 270;
+
+		if (yaw < 0)
+			yaw += 360;
+
+		forward = sqrt (value1[0]*value1[0] + value1[1]*value1[1]);
+		pitch = (atan2(value1[2], forward) * 180 / M_PI);
+		if (pitch < 0)
+			pitch += 360;
+	}
+
+	angles[PITCH] = -pitch;
+	angles[YAW] = yaw;
+	angles[ROLL] = 0;
+}
+
+char *G_CopyString (const char *in)
+{
+	char	*out;
+	out = (char*)gi.TagMalloc ((int)strlen(in)+1, TAG_LEVEL);
+	strcpy (out, in);
+	return out;
+}
+
+void *G_Malloc( int32_t size )
+{
+    return gi.TagMalloc(size, TAG_LEVEL);
+}
+
+void G_Free(void *block ) {
+    gi.TagFree(block);
+}
+
+/*
+==============================================================================
+
+LEVEL ARENA
+
+Strings and structs that live until the map changes and are never freed
+one by one come from G_LevelAlloc, which hands out the next bytes of a
+large TAG_LEVEL block instead of making a zone allocation, with its
+header, for each. G_ResetLevelArena forgets the blocks wherever
+TAG_LEVEL is freed, which frees them.
+
+Small objects of one size that come and go during a level (menu and
+text handles) come from a gpool_t instead, carved out of the arena and
+handed back to the pool's free list by G_PoolFree, so their slots are
+reused. A pool is emptied along with the arena.
+
+Neither may be passed to G_Free or gi.TagFree. "sv profile dump" reports
+what they hold.
+
+==============================================================================
+*/
+
+#define	LEVEL_ARENA_BLOCK	65536
+
+typedef struct arenablock_s
+{
+	struct arenablock_s	*next;
+	int					size, used;
+} arenablock_t;
+
+static arenablock_t	*arena_blocks;
+static gpool_t		*arena_pools;		// every pool that has been used
+
+static struct
+{
+	int		allocs;
+	int		bytes;			// handed out
+	int		blocks;
+	int		size;			// in blocks
+	int		peak;			// most size in any level
+} arena_stats;
+
+/*
+=============
+G_LevelAlloc
+
+Zeroed memory that lasts until the next map change
+=============
+*/
+void *G_LevelAlloc (int size)
+{
+	arenablock_t	*b;
+	void			*p;
+
+	size = (size + sizeof(void *) - 1) & ~(int)(sizeof(void *) - 1);
+	b = arena_blocks;
+	if (!b || b->used + size > b->size)
+	{
+		b = (arenablock_t *)gi.TagMalloc (sizeof(arenablock_t) + max(size, LEVEL_ARENA_BLOCK), TAG_LEVEL);
+		b->size = max(size, LEVEL_ARENA_BLOCK);
+		b->used = 0;
+		b->next = arena_blocks;
+		arena_blocks = b;
+
+		arena_stats.blocks++;
+		arena_stats.size += b->size;
+		if (arena_stats.size > arena_stats.peak)
+			arena_stats.peak = arena_stats.size;
+	}
+	p = (byte *)(b + 1) + b->used;
+	b->used += size;
+	arena_stats.allocs++;
+	arena_stats.bytes += size;
+	memset (p, 0, size);	// TagMalloc zeroes too
+	return p;
+}
+
+/*
+=============
+G_LevelString
+
+G_CopyString for strings that are never freed
+=============
+*/
+char *G_LevelString (const char *in)
+{
+	char	*out;
+
+	out = (char *)G_LevelAlloc ((int)strlen(in)+1);
+	strcpy (out, in);
+	return out;
+}
+
+/*
+=============
+G_PoolAlloc
+=============
+*/
+void *G_PoolAlloc (gpool_t *pool)
+{
+	void	**slot;
+	byte	*chunk;
+	int		size, i;
+
+	if (!pool->registered)
+	{
+		pool->registered = true;
+		pool->next = arena_pools;
+		arena_pools = pool;
+	}
+
+	if (!pool->free)
+	{
+		size = (pool->size + sizeof(void *) - 1) & ~(int)(sizeof(void *) - 1);
+		chunk = (byte *)G_LevelAlloc (size * pool->perchunk);
+		for (i = pool->perchunk - 1 ; i >= 0 ; i--)
+		{
+			slot = (void **)(chunk + i * size);
+			*slot = pool->free;
+			pool->free = slot;
+		}
+		pool->capacity += pool->perchunk;
+	}
+
+	slot = (void **)pool->free;
+	pool->free = *slot;
+	memset (slot, 0, pool->size);
+	if (++pool->inuse > pool->peak)
+		pool->peak = pool->inuse;
+	return slot;
+}
+
+/*
+=============
+G_PoolFree
+=============
+*/
+void G_PoolFree (gpool_t *pool, void *p)
+{
+	if (!p)
+		return;
+	*(void **)p = pool->free;
+	pool->free = p;
+	pool->inuse--;
+}
+
+/*
+=============
+G_ResetLevelArena
+
+Called wherever TAG_LEVEL is freed
+=============
+*/
+void G_ResetLevelArena (void)
+{
+	gpool_t	*pool;
+
+	arena_blocks = NULL;
+	arena_stats.allocs = arena_stats.bytes = 0;
+	arena_stats.blocks = arena_stats.size = 0;
+
+	for (pool = arena_pools ; pool ; pool = pool->next)
+	{
+		pool->free = NULL;
+		pool->inuse = pool->capacity = 0;
+	}
+}
+
+/*
+=============
+G_ArenaStats
+
+Printed by "sv profile dump"
+=============
+*/
+void G_ArenaStats (void)
+{
+	gpool_t	*pool;
+
+	safe_cprintf (NULL, PRINT_HIGH, "level arena: %i allocations, %i bytes in %i blocks of %i (peak %i)\n",
+		arena_stats.allocs, arena_stats.bytes, arena_stats.blocks, arena_stats.size, arena_stats.peak);
+	for (pool = arena_pools ; pool ; pool = pool->next)
+		safe_cprintf (NULL, PRINT_HIGH, "  %-14s %4i in use of %4i (peak %i)\n",
+			pool->name, pool->inuse, pool->capacity, pool->peak);
+}
+
+void G_InitEdict (edict_t *e)
+{
+	e->inuse = true;
+	e->classname = "noclass";
+	e->gravity = 1.0;
+	e->s.number = e - g_edicts;
+	e->org_movetype = -1;
+}
+
+/*
+=================
+Free edict queue
+
+Freed edicts go on the back of a FIFO along with nothing else - the
+freetime is already in the edict. Since level.time only moves forward,
+the front of the queue is always the slot that was freed longest ago,
+so G_Spawn only has to look at one slot instead of scanning them all.
+=================
+*/
+static int		*edict_freelist;	// ring buffer of edict numbers
+static byte		*edict_queued;		// per edict: already in edict_freelist
+static int		edict_freehead;
+static int		edict_freecount;
+static int		edict_freesize;
+
+static struct
+{
+	int		framenum;			// frame the counters below belong to
+	int		frame_allocs;		// allocations so far this frame
+	int		last_allocs;		// allocations during the previous frame
+	int		peak_allocs;		// most allocations in a single frame
+	int		total_allocs;
+	int		frame_frees;
+	int		last_frees;
+	int		total_frees;
+	int		new_slots;			// allocations that had to grow num_edicts
+	int		high_water;			// largest num_edicts seen this level
+	int		peak_free;			// deepest the free queue has been
+} edict_stats;
+
+/*
+=================
+Edict lifetimes
+
+Every G_Spawn notes the level.time it happened at and the site it was
+called from, given by G_SpawnTagged; plain G_Spawn calls are one
+"untagged" site. Every G_FreeEdict of an edict in use adds how long it
+lived to the count kept for its classname, which is only known by then.
+Classnames are matched by pointer before strcmp, so the common case of
+a string constant costs one hash. Both tables are cleared with the rest
+of edict_stats and hold only pointers to strings that last the level.
+"sv edicts" prints them.
+=================
+*/
+#define	EDICT_CLASSES	256		// must be a power of 2
+#define	EDICT_SITES		64
+
+typedef struct
+{
+	char	*name;
+	int		frees;
+	float	lifetime;			// seconds, summed over frees
+	int		live;				// only filled in by Svcmd_Edicts_f
+} edictclass_t;
+
+typedef struct
+{
+	char	*name;
+	int		allocs;
+	int		frees;
+	int		live;
+} edictsite_t;
+
+static edictclass_t	edict_classes[EDICT_CLASSES];
+static int			num_edict_classes;
+static edictsite_t	edict_sites[EDICT_SITES];		// 0 is "untagged"
+static int			num_edict_sites;
+static float		*edict_born;		// per edict: level.time of its G_Spawn
+static byte			*edict_site;		// per edict: index in edict_sites
+
+static edictclass_t *G_EdictClass (char *name)
+{
+	edictclass_t	*c;
+	unsigned int	h;
+	char			*s;
+	int				i;
+
+	if (!name)
+		name = "noclass";
+	h = 2166136261u;
+	for (s = name ; *s ; s++)
+		h = (h ^ (byte)*s) * 16777619u;
+
+	for (i=0 ; i<EDICT_CLASSES ; i++)
+	{
+		c = &edict_classes[(h + i) & (EDICT_CLASSES-1)];
+		if (!c->name)
+		{
+			// keep a quarter free so misses stay short
+			if (num_edict_classes >= EDICT_CLASSES - EDICT_CLASSES/4)
+				return NULL;
+			c->name = name;
+			num_edict_classes++;
+			return c;
+		}
+		if (c->name == name || !strcmp (c->name, name))
+			return c;
+	}
+	return NULL;
+}
+
+static int G_EdictSite (char *site)
+{
+	int		i;
+
+	if (!site)
+		return 0;
+	for (i=1 ; i<num_edict_sites ; i++)
+		if (edict_sites[i].name == site || !strcmp (edict_sites[i].name, site))
+			return i;
+	if (num_edict_sites == EDICT_SITES)
+		return 0;
+	edict_sites[num_edict_sites].name = site;
+	return num_edict_sites++;
+}
+
+static void G_EdictStatsFrame (void)
+{
+	if (edict_stats.framenum == level.framenum)
+		return;
+	if (edict_stats.framenum == level.framenum - 1)
+	{
+		edict_stats.last_allocs = edict_stats.frame_allocs;
+		edict_stats.last_frees = edict_stats.frame_frees;
+	}
+	else
+		edict_stats.last_allocs = edict_stats.last_frees = 0;
+	edict_stats.frame_allocs = edict_stats.frame_frees = 0;
+	edict_stats.framenum = level.framenum;
+}
+
+static void G_ClearEdictLifetimes (void)
+{
+	int		i;
+
+	memset (edict_classes, 0, sizeof(edict_classes));
+	num_edict_classes = 0;
+	memset (edict_sites, 0, sizeof(edict_sites));
+	edict_sites[0].name = "untagged";
+	num_edict_sites = 1;
+
+	// nothing is known about edicts loaded from a save
+	for (i=0 ; i<edict_freesize ; i++)
+	{
+		edict_born[i] = level.time;
+		edict_site[i] = 0;
+	}
+}
+
+// called with ed still holding what is about to be cleared
+static void G_CountEdictFree (edict_t *ed)
+{
+	edictclass_t	*c;
+	int				num;
+
+	num = ed - g_edicts;
+	if (!ed->inuse || !edict_born || num >= edict_freesize)
+		return;
+	if (prof_active)
+		Prof_CountFree ();
+
+	G_EdictStatsFrame ();
+	edict_stats.frame_frees++;
+	edict_stats.total_frees++;
+	edict_sites[edict_site[num]].frees++;
+
+	c = G_EdictClass (ed->classname);
+	if (c)
+	{
+		c->frees++;
+		c->lifetime += level.time - edict_born[num];
+	}
+}
+
+static void G_QueueFreeEdict (edict_t *ed)
+{
+	int		num;
+
+	num = ed - g_edicts;
+	if (!edict_freelist || num <= game.maxclients || num >= edict_freesize)
+		return;
+	// G_FreeEdict on an already free edict is common and harmless,
+	// but the slot must not be handed out twice
+	if (edict_queued[num])
+		return;
+
+	edict_freelist[(edict_freehead + edict_freecount) % edict_freesize] = num;
+	edict_freecount++;
+	edict_queued[num] = 1;
+	if (edict_freecount > edict_stats.peak_free)
+		edict_stats.peak_free = edict_freecount;
+}
+
+static void G_PopFreeEdict (void)
+{
+	edict_queued[edict_freelist[edict_freehead]] = 0;
+	edict_freehead = (edict_freehead + 1) % edict_freesize;
+	edict_freecount--;
+}
+
+/*
+=================
+G_ResetFreeEdicts
+
+Rebuilds the free queue from the current contents of g_edicts.
+Called after the edict array is wiped or loaded from a savegame.
+=================
+*/
+void G_ResetFreeEdicts (void)
+{
+	int		i;
+
+	if (edict_freesize < game.maxentities)
+	{
+		if (edict_freelist)
+		{
+			gi.TagFree (edict_freelist);
+			gi.TagFree (edict_queued);
+			gi.TagFree (edict_born);
+			gi.TagFree (edict_site);
+		}
+		edict_freesize = game.maxentities;
+		edict_freelist = (int *)gi.TagMalloc (edict_freesize * sizeof(int), TAG_GAME);
+		edict_queued   = (byte *)gi.TagMalloc (edict_freesize, TAG_GAME);
+		edict_born     = (float *)gi.TagMalloc (edict_freesize * sizeof(float), TAG_GAME);
+		edict_site     = (byte *)gi.TagMalloc (edict_freesize, TAG_GAME);
+	}
+	memset (edict_queued, 0, edict_freesize);
+	edict_freehead = edict_freecount = 0;
+	memset (&edict_stats, 0, sizeof(edict_stats));
+	G_ClearEdictLifetimes ();
+
+	for (i=game.maxclients+1 ; i<globals.num_edicts ; i++)
+	{
+		if (!g_edicts[i].inuse)
+			G_QueueFreeEdict (&g_edicts[i]);
+	}
+	edict_stats.high_water = globals.num_edicts;
+}
+
+static void G_CountEdictAlloc (void)
+{
+	G_EdictStatsFrame ();
+	edict_stats.frame_allocs++;
+	edict_stats.total_allocs++;
+	if (edict_stats.frame_allocs > edict_stats.peak_allocs)
+		edict_stats.peak_allocs = edict_stats.frame_allocs;
+}
+
+/*
+=================
+G_EdictSerial
+
+Changes whenever an edict is spawned or freed, so a caller can tell
+whether a piece of code did either
+=================
+*/
+int G_EdictSerial (void)
+{
+	return edict_stats.total_allocs + edict_stats.total_frees;
+}
+
+/*
+=================
+Svcmd_EdictStats_f
+
+"sv edictstats"
+=================
+*/
+void Svcmd_EdictStats_f (void)
+{
+	int		i, inuse;
+
+	inuse = 0;
+	for (i=0 ; i<globals.num_edicts ; i++)
+		if (g_edicts[i].inuse)
+			inuse++;
+
+	safe_cprintf (NULL, PRINT_HIGH, "edicts in use:     %i\n", inuse);
+	safe_cprintf (NULL, PRINT_HIGH, "num_edicts:        %i (high water %i, max %i)\n",
+		globals.num_edicts, edict_stats.high_water, game.maxentities);
+	safe_cprintf (NULL, PRINT_HIGH, "free queue depth:  %i (peak %i)\n", edict_freecount, edict_stats.peak_free);
+	safe_cprintf (NULL, PRINT_HIGH, "allocs this frame: %i\n",
+		(edict_stats.framenum == level.framenum) ? edict_stats.frame_allocs : 0);
+	safe_cprintf (NULL, PRINT_HIGH, "allocs last frame: %i (peak %i/frame)\n", edict_stats.last_allocs, edict_stats.peak_allocs);
+	safe_cprintf (NULL, PRINT_HIGH, "allocs this level: %i (%i avg/frame, %i new slots)\n", edict_stats.total_allocs,
+		level.framenum ? edict_stats.total_allocs / level.framenum : edict_stats.total_allocs, edict_stats.new_slots);
+	safe_cprintf (NULL, PRINT_HIGH, "frees this frame:  %i, last frame %i, this level %i\n",
+		(edict_stats.framenum == level.framenum) ? edict_stats.frame_frees : 0,
+		edict_stats.last_frees, edict_stats.total_frees);
+}
+
+static int G_CompareEdictClasses (const void *a, const void *b)
+{
+	const edictclass_t	*x = *(const edictclass_t **)a;
+	const edictclass_t	*y = *(const edictclass_t **)b;
+
+	if (x->live != y->live)
+		return y->live - x->live;
+	return y->frees - x->frees;
+}
+
+static int G_CompareEdictSites (const void *a, const void *b)
+{
+	const edictsite_t	*x = *(const edictsite_t **)a;
+	const edictsite_t	*y = *(const edictsite_t **)b;
+
+	if (x->live != y->live)
+		return y->live - x->live;
+	return y->allocs - x->allocs;
+}
+
+/*
+=================
+Svcmd_Edicts_f
+
+"sv edicts [count]": the edictstats summary, then the classnames with
+the most edicts in use and the G_SpawnTagged sites that made the most
+of them, count of each (default 16).
+=================
+*/
+void Svcmd_Edicts_f (void)
+{
+	edictclass_t	*classes[EDICT_CLASSES], *c;
+	edictsite_t		*sites[EDICT_SITES];
+	edict_t			*e;
+	int				i, n, count, untracked;
+
+	Svcmd_EdictStats_f ();
+	if (!edict_born)
+		return;
+
+	count = (gi.argc() > 2) ? atoi (gi.argv(2)) : 16;
+	if (count <= 0)
+		count = 16;
+
+	for (i=0 ; i<EDICT_CLASSES ; i++)
+		edict_classes[i].live = 0;
+	for (i=0 ; i<num_edict_sites ; i++)
+		edict_sites[i].live = 0;
+
+	untracked = 0;
+	for (i=1, e=g_edicts+1 ; i<globals.num_edicts ; i++, e++)
+	{
+		if (!e->inuse)
+			continue;
+		c = G_EdictClass (e->classname);
+		if (c)
+			c->live++;
+		else
+			untracked++;
+		edict_sites[edict_site[i]].live++;
+	}
 
-		if (yaw < 0)
-			yaw += 360;
+	for (i=n=0 ; i<EDICT_CLASSES ; i++)
+		if (edict_classes[i].name)
+			classes[n++] = &edict_classes[i];
+	qsort (classes, n, sizeof(classes[0]), G_CompareEdictClasses);
 
-		forward = sqrt (value1[0]*value1[0] + value1[1]*value1[1]);
-		pitch = (atan2(value1[2], forward) * 180 / M_PI);
-		if (pitch < 0)
-			pitch += 360;
+	safe_cprintf (NULL, PRINT_HIGH, "\n%-24s %5s %6s %8s\n", "classname", "live", "freed", "lifetime");
+	for (i=0 ; i<n && i<count ; i++)
+	{
+		c = classes[i];
+		if (c->frees)
+			safe_cprintf (NULL, PRINT_HIGH, "%-24.24s %5i %6i %7.1fs\n", c->name, c->live, c->frees, c->lifetime / c->frees);
+		else
+			safe_cprintf (NULL, PRINT_HIGH, "%-24.24s %5i %6i %8s\n", c->name, c->live, c->frees, "-");
 	}
+	if (untracked)
+		safe_cprintf (NULL, PRINT_HIGH, "%i in use under classnames past the first %i\n", untracked, num_edict_classes);
 
-	angles[PITCH] = -pitch;
-	angles[YAW] = yaw;
-	angles[ROLL] = 0;
-}
+	for (i=0 ; i<num_edict_sites ; i++)
+		sites[i] = &edict_sites[i];
+	qsort (sites, num_edict_sites, sizeof(sites[0]), G_CompareEdictSites);
 
-char *G_CopyString (const char *in)
-{
-	char	*out;
-	out = (char*)gi.TagMalloc ((int)strlen(in)+1, TAG_LEVEL);
-	strcpy (out, in);
-	return out;
+	safe_cprintf (NULL, PRINT_HIGH, "\n%-24s %5s %6s %6s\n", "spawned by", "live", "allocs", "freed");
+	for (i=0 ; i<num_edict_sites && i<count ; i++)
+		safe_cprintf (NULL, PRINT_HIGH, "%-24.24s %5i %6i %6i\n", sites[i]->name, sites[i]->live, sites[i]->allocs, sites[i]->frees);
 }
 
-void *G_Malloc( int32_t size )
-{
-    return gi.TagMalloc(size, TAG_LEVEL);
-}
+static void G_InitClientPVS (void);
 
-void G_Free(void *block ) {
-    gi.TagFree(block);
-}
+/*
+=================
+G_InitEdictLists
 
-void G_InitEdict (edict_t *e)
+Called from InitGame once g_edicts exists. Sets up the field indexes
+and the free queue, and drops the G_PickRoute table and the client
+PVS cache.
+=================
+*/
+void G_InitEdictLists (void)
 {
-	e->inuse = true;
-	e->classname = "noclass";
-	e->gravity = 1.0;
-	e->s.number = e - g_edicts;
-	e->org_movetype = -1;
+	int		j;
+
+	for (j=0 ; j<NUM_FIELDINDEXES ; j++)
+	{
+		fieldindexes[j].next = fieldindexes[j].bucket = NULL;
+		fieldindexes[j].key = NULL;
+	}
+	fi_size = 0;
+	G_ClearEdictIndexes ();
+
+	edict_freelist = NULL;
+	edict_queued = NULL;
+	edict_freesize = 0;
+	G_ResetFreeEdicts ();
+
+	routes = NULL;
+	G_InitClientPVS ();
 }
 
 /*
@@ -507,27 +1786,54 @@ instead of being removed and recreated, which can cause interpolated
 angles and bad trails.
 =================
 */
-edict_t *G_Spawn (void)
+static edict_t *G_AllocEdict (void)
 {
 	int			i;
 	edict_t		*e;
 
-	e = &g_edicts[(int)maxclients->value+1];
-	for ( i=maxclients->value+1 ; i<globals.num_edicts ; i++, e++)
+
+	// the front of the queue was freed before anything behind it,
+	// so if it is too fresh there is no point looking further
+	while (edict_freecount > 0)
 	{
+		e = &g_edicts[edict_freelist[edict_freehead]];
+		if (e->inuse)
+		{
+			G_PopFreeEdict ();
+			continue;
+		}
 		// the first couple seconds of server time can involve a lot of
 		// freeing and allocating, so relax the replacement policy
-		if (!e->inuse && ( e->freetime < 2 || level.time - e->freetime > 0.5 ) )
+		if (e->freetime < 2 || level.time - e->freetime > 0.5)
 		{
+			G_PopFreeEdict ();
 			G_InitEdict (e);
 			return e;
 		}
+		break;
 	}
 
-	if (i == game.maxentities)
+	if (globals.num_edicts == game.maxentities)
+	{
+		// out of fresh slots; fall back to the old full scan in case
+		// a slot was freed without going through G_FreeEdict
+		e = &g_edicts[(int)maxclients->value+1];
+		for ( i=maxclients->value+1 ; i<globals.num_edicts ; i++, e++)
+		{
+			if (!e->inuse && ( e->freetime < 2 || level.time - e->freetime > 0.5 ) )
+			{
+				G_InitEdict (e);
+				return e;
+			}
+		}
 		gi.error ("ED_Alloc: no free edicts");
+	}
 
+	e = &g_edicts[globals.num_edicts];
 	globals.num_edicts++;
+	edict_stats.new_slots++;
+	if (globals.num_edicts > edict_stats.high_water)
+		edict_stats.high_water = globals.num_edicts;
 
 	if(developer->value && readout->value)
 		gi.dprintf("num_edicts = %d\n",globals.num_edicts);
@@ -536,6 +1842,39 @@ edict_t *G_Spawn (void)
 	return e;
 }
 
+/*
+=================
+G_SpawnTagged
+
+G_Spawn, counting the edict against site (a string constant naming the
+caller) in "sv edicts"
+=================
+*/
+edict_t *G_SpawnTagged (char *site)
+{
+	edict_t		*e;
+	int			num;
+
+	G_CountEdictAlloc ();
+	if (prof_active)
+		Prof_CountAlloc ();
+
+	e = G_AllocEdict ();
+	num = e - g_edicts;
+	if (edict_born && num < edict_freesize)
+	{
+		edict_born[num] = level.time;
+		edict_site[num] = G_EdictSite (site);
+		edict_sites[edict_site[num]].allocs++;
+	}
+	return e;
+}
+
+edict_t *G_Spawn (void)
+{
+	return G_SpawnTagged (NULL);
+}
+
 /*
 =================
 G_FreeEdict
@@ -547,23 +1886,14 @@ void G_FreeEdict (edict_t *ed)
 {
 	// Lazarus - if part of a movewith chain, remove from
 	// the chain and repair broken links
-	if(ed->movewith) {
-		edict_t	*e;
-		edict_t	*parent=NULL;
-		int		i;
-
-		for(i=1; i<globals.num_edicts && !parent; i++) {
-			e = g_edicts + i;
-			if(e->movewith_next == ed) parent=e;
-		}
-		if(parent) parent->movewith_next = ed->movewith_next;
-	}
+	if(ed->movewith)
+		movewith_unlink (ed);
 
 	gi.unlinkentity (ed);		// unlink from world
 
 	// Lazarus: In SP we no longer reserve slots for bodyque's
 	if (deathmatch->value || coop->value) {
-		if ((ed - g_edicts) <= (maxclients->value + BODY_QUEUE_SIZE))
+		if ((ed - g_edicts) <= (maxclients->value + level.body_que_size))
 		{
 //			gi.dprintf("tried to free special edict\n");
 			return;
@@ -578,20 +1908,28 @@ void G_FreeEdict (edict_t *ed)
 	// Lazarus: actor muzzle flash
 	if (ed->flash)
 	{
+		G_CountEdictFree (ed->flash);
 		memset (ed->flash, 0, sizeof(*ed));
 		ed->flash->classname = "freed";
 		ed->flash->freetime  = level.time;
 		ed->flash->inuse     = false;
+		G_QueueFreeEdict (ed->flash);
 	}
 
 	// Lazarus: reflections
 	if (!(ed->flags & FL_REFLECT))
 		DeleteReflection(ed,-1);
 
+	G_UnindexEdict (ed);
+	M_RemoveCorpse (ed);
+	CTFTechRemoved (ed);
+
+	G_CountEdictFree (ed);
 	memset (ed, 0, sizeof(*ed));
 	ed->classname = "freed";
 	ed->freetime = level.time;
 	ed->inuse = false;
+	G_QueueFreeEdict (ed);
 }
 
 /*
@@ -600,7 +1938,36 @@ G_TouchTriggers
 
 ============
 */
-void	G_TouchTriggers (edict_t *ent)
+#define	MAX_FRAME_TOUCHES	32
+
+typedef struct
+{
+	int		framenum;
+	int		count;
+	edict_t	*hit[MAX_FRAME_TOUCHES];
+} frametouch_t;
+
+static frametouch_t	frame_touches[MAX_CLIENTS];
+
+// Returns false if hit already touched the client owning ft this frame
+static qboolean G_FirstTouchThisFrame (frametouch_t *ft, edict_t *hit)
+{
+	int		i;
+
+	if (ft->framenum != level.framenum)
+	{
+		ft->framenum = level.framenum;
+		ft->count = 0;
+	}
+	for (i=0 ; i<ft->count ; i++)
+		if (ft->hit[i] == hit)
+			return false;
+	if (ft->count < MAX_FRAME_TOUCHES)
+		ft->hit[ft->count++] = hit;
+	return true;
+}
+
+static void G_DoTouchTriggers (edict_t *ent, frametouch_t *ft)
 {
 	int			i, num;
 	edict_t		*touch[MAX_EDICTS], *hit;
@@ -627,10 +1994,52 @@ void	G_TouchTriggers (edict_t *ent)
 			continue;
 		if (ent->client && ent->client->spycam && !(hit->svflags & SVF_TRIGGER_CAMOWNER))
 			continue;
+		// trigger_push has to keep setting the velocity
+		if (ft && hit->touch != trigger_push_touch && !G_FirstTouchThisFrame (ft, hit))
+			continue;
 		hit->touch (hit, ent, NULL, NULL);
 	}
 }
 
+void	G_TouchTriggers (edict_t *ent)
+{
+	G_DoTouchTriggers (ent, NULL);
+}
+
+/*
+============
+G_ClientTouchTriggers
+
+G_TouchTriggers for ClientThink, which runs for every usercmd and so
+several times a frame for a high rate client. Each trigger touches the
+client only the first time in a frame.
+============
+*/
+void G_ClientTouchTriggers (edict_t *ent)
+{
+	int		n;
+
+	n = ent - g_edicts - 1;
+	if (n < 0 || n >= MAX_CLIENTS)
+	{
+		G_DoTouchTriggers (ent, NULL);
+		return;
+	}
+	G_DoTouchTriggers (ent, &frame_touches[n]);
+}
+
+/*
+============
+G_ClearFrameTouches
+
+Called when a level is spawned or loaded, since framenum starts over
+============
+*/
+void G_ClearFrameTouches (void)
+{
+	memset (frame_touches, 0, sizeof(frame_touches));
+}
+
 /*
 ============
 G_TouchSolids
@@ -664,6 +2073,137 @@ void	G_TouchSolids (edict_t *ent)
 
 
 
+/*
+==============================================================================
+
+CLIENT PVS
+
+Culling asks whether any client has an entity in its PVS, which means a
+gi.inPVS per client, for every entity asking, every frame. The game
+can't read the vis data, but the engine leaves each linked entity's
+clusters in clusternums: an entity sitting in a single cluster is seen
+by a client sitting in that same cluster without asking. The rest is
+asked once per client, and the answer kept on the entity as a mask of
+clients for the rest of the frame.
+
+==============================================================================
+*/
+
+typedef struct
+{
+	int		framenum;			// level.framenum + 1, 0 if nothing cached
+	vec3_t	origin;
+	int		count;
+} clientpvs_t;
+
+static clientpvs_t	*client_pvs;		// per edict
+static byte			*client_pvs_masks;	// per edict, client_pvs_bytes each
+static int			client_pvs_bytes;
+
+// sized by maxclients, which may be different in the next game
+static void G_InitClientPVS (void)
+{
+	client_pvs = NULL;
+	client_pvs_masks = NULL;
+	client_pvs_bytes = 0;
+}
+
+/*
+=================
+G_ResetClientPVS
+
+Called by SpawnEntities and ReadLevel, since level.framenum starts over
+=================
+*/
+void G_ResetClientPVS (void)
+{
+	if (client_pvs)
+		memset (client_pvs, 0, game.maxentities * sizeof(clientpvs_t));
+}
+
+// both linked, each with its origin inside a box that is all in one cluster
+static qboolean G_SameCluster (edict_t *a, edict_t *b)
+{
+	int		i;
+
+	if (!a->area.prev || !b->area.prev)
+		return false;
+	if (a->num_clusters != 1 || b->num_clusters != 1 || a->clusternums[0] != b->clusternums[0])
+		return false;
+	for (i = 0; i < 3; i++)
+	{
+		if (a->s.origin[i] < a->absmin[i] || a->s.origin[i] > a->absmax[i])
+			return false;
+		if (b->s.origin[i] < b->absmin[i] || b->s.origin[i] > b->absmax[i])
+			return false;
+	}
+	return true;
+}
+
+/*
+=================
+G_ClientsInPVS
+
+How many clients have ent's origin in their PVS. mask, if not NULL, gets
+a bit for each of them (client n is bit n-1).
+=================
+*/
+int G_ClientsInPVS (edict_t *ent, byte *mask)
+{
+	clientpvs_t	*cache;
+	byte		*bits;
+	edict_t		*cl;
+	int			i;
+
+	if (!client_pvs)
+	{
+		client_pvs_bytes = (game.maxclients + 7) >> 3;
+		client_pvs = gi.TagMalloc (game.maxentities * sizeof(clientpvs_t), TAG_GAME);
+		client_pvs_masks = gi.TagMalloc (game.maxentities * client_pvs_bytes, TAG_GAME);
+	}
+	cache = client_pvs + (ent - g_edicts);
+	bits = client_pvs_masks + (ent - g_edicts) * client_pvs_bytes;
+
+	if (cache->framenum != level.framenum + 1 || !VectorCompare (cache->origin, ent->s.origin))
+	{
+		memset (bits, 0, client_pvs_bytes);
+		cache->count = 0;
+		for (i = 1, cl = g_edicts + 1; i <= game.maxclients; i++, cl++)
+		{
+			if (!cl->inuse || !cl->client)
+				continue;
+			if (G_SameCluster (ent, cl) || gi.inPVS (cl->s.origin, ent->s.origin))
+			{
+				bits[(i-1) >> 3] |= 1 << ((i-1) & 7);
+				cache->count++;
+			}
+		}
+		cache->framenum = level.framenum + 1;
+		VectorCopy (ent->s.origin, cache->origin);
+	}
+
+	if (mask)
+		memcpy (mask, bits, client_pvs_bytes);
+	return cache->count;
+}
+
+/*
+=================
+G_ClientSeesEntity
+
+Whether client n (1 based) has ent's origin in its PVS
+=================
+*/
+qboolean G_ClientSeesEntity (edict_t *ent, int n)
+{
+	byte	*bits;
+
+	if (!G_ClientsInPVS (ent, NULL))
+		return false;
+	bits = client_pvs_masks + (ent - g_edicts) * client_pvs_bytes;
+	return (bits[(n-1) >> 3] & (1 << ((n-1) & 7))) != 0;
+}
+
 /*
 ==============================================================================
 
@@ -757,44 +2297,40 @@ float AtLeast(float x, float dx)
 	return xx;
 }
 
-edict_t	*LookingAt(edict_t *ent, int filter, vec3_t endpos, float *range)
+/*
+=================
+LookingAt
+
+What a client is looking at, for the commands that act on it and for
+triggers and buttons that fire on a look. Touch functions ask every
+frame, and a trigger_look can ask several times in one touch, so the
+answer is remembered per client until the frame, the view ray or the
+filter changes. A miss still makes its sound on every call.
+=================
+*/
+typedef struct
+{
+	int			framenum;		// level.framenum + 1, 0 if empty
+	int			filter;
+	edict_t		*ignore;
+	vec3_t		start, forward;
+	edict_t		*who;			// NULL for a miss
+	vec3_t		endpos;
+	float		range;
+} gaze_t;
+
+static gaze_t	client_gaze[MAX_CLIENTS];
+
+static edict_t *LookingAtRay (edict_t *ent, int filter, vec3_t start, vec3_t forward, edict_t *ignore, vec3_t endpos, float *range)
 {
 	edict_t		*who;
 	edict_t		*trigger[MAX_EDICTS];
-	edict_t		*ignore;
 	trace_t		tr;
 	vec_t		r;
-	vec3_t      end, forward, start;
+	vec3_t      end;
 	vec3_t		dir, entp, mins, maxs;
 	int			i, num;
 
-	if(!ent->client)
-	{
-		if(endpos) VectorClear(endpos);
-		if(range) *range = 0;
-		return NULL;
-	}
-	VectorClear(end);
-	if (ent->client->chasetoggle)
-	{
-		AngleVectors(ent->client->v_angle, forward, NULL, NULL);
-		VectorCopy(ent->client->chasecam->s.origin,start);
-		ignore = ent->client->chasecam;
-	}
-	else if(ent->client->spycam)
-	{
-		AngleVectors(ent->client->ps.viewangles, forward, NULL, NULL);
-		VectorCopy(ent->s.origin,start);
-		ignore = ent->client->spycam;
-	}
-	else
-	{
-		AngleVectors(ent->client->v_angle, forward, NULL, NULL);
-		VectorCopy(ent->s.origin, start);
-		start[2] += ent->viewheight;
-		ignore = ent;
-	}
-
 	VectorMA(start, 8192, forward, end);
 	
 	/* First check for looking directly at a pickup item */
@@ -821,55 +2357,84 @@ edict_t	*LookingAt(edict_t *ent, int filter, vec3_t endpos, float *range)
 		if(entp[0] > who->s.origin[0] + 17) continue;
 		if(entp[1] > who->s.origin[1] + 17) continue;
 		if(entp[2] > who->s.origin[2] + 17) continue;
-		if(endpos)
-			VectorCopy(who->s.origin,endpos);
-		if (range)
-			*range = r;
+		VectorCopy(who->s.origin,endpos);
+		*range = r;
 		return who;
 	}
 
 	tr = gi.trace (start, NULL, NULL, end, ignore, MASK_SHOT);
 	if (tr.fraction == 1.0)
+		return NULL;	// too far away
+	if(!tr.ent)
+		return NULL;	// no hit
+	if(!tr.ent->classname)
+		return NULL;	// should never happen
+	if((strstr(tr.ent->classname,"func_") != NULL) && (filter & LOOKAT_NOBRUSHMODELS))
+		return NULL;	// don't hit on brush models
+	if((Q_strcasecmp(tr.ent->classname,"worldspawn") == 0) && (filter & LOOKAT_NOWORLD))
+		return NULL;	// world brush
+
+	VectorCopy(tr.endpos,endpos);
+	VectorSubtract(tr.endpos,start,dir);
+	*range = VectorLength(dir);
+	return tr.ent;
+}
+
+edict_t	*LookingAt(edict_t *ent, int filter, vec3_t endpos, float *range)
+{
+	gaze_t		*gaze;
+	edict_t		*ignore;
+	vec3_t      forward, start;
+
+	if(!ent->client)
 	{
-		// too far away
-		gi.sound (ent, CHAN_AUTO, gi.soundindex ("misc/talk1.wav"), 1, ATTN_NORM, 0);
+		if(endpos) VectorClear(endpos);
+		if(range) *range = 0;
 		return NULL;
 	}
-	if(!tr.ent)
+	if (ent->client->chasetoggle)
 	{
-		// no hit
-		gi.sound (ent, CHAN_AUTO, gi.soundindex ("misc/talk1.wav"), 1, ATTN_NORM, 0);
-		return NULL;
+		AngleVectors(ent->client->v_angle, forward, NULL, NULL);
+		VectorCopy(ent->client->chasecam->s.origin,start);
+		ignore = ent->client->chasecam;
 	}
-	if(!tr.ent->classname)
+	else if(ent->client->spycam)
 	{
-		// should never happen
-		gi.sound (ent, CHAN_AUTO, gi.soundindex ("misc/talk1.wav"), 1, ATTN_NORM, 0);
-		return NULL;
+		AngleVectors(ent->client->ps.viewangles, forward, NULL, NULL);
+		VectorCopy(ent->s.origin,start);
+		ignore = ent->client->spycam;
+	}
+	else
+	{
+		AngleVectors(ent->client->v_angle, forward, NULL, NULL);
+		VectorCopy(ent->s.origin, start);
+		start[2] += ent->viewheight;
+		ignore = ent;
 	}
 
-	if((strstr(tr.ent->classname,"func_") != NULL) && (filter & LOOKAT_NOBRUSHMODELS))
+	gaze = &client_gaze[(ent - g_edicts - 1) % MAX_CLIENTS];
+	if (gaze->framenum != level.framenum + 1 || gaze->filter != filter || gaze->ignore != ignore
+		|| !VectorCompare(gaze->start, start) || !VectorCompare(gaze->forward, forward)
+		|| (gaze->who && !gaze->who->inuse))
 	{
-		// don't hit on brush models
-		gi.sound (ent, CHAN_AUTO, gi.soundindex ("misc/talk1.wav"), 1, ATTN_NORM, 0);
-		return NULL;
+		gaze->framenum = level.framenum + 1;
+		gaze->filter = filter;
+		gaze->ignore = ignore;
+		VectorCopy(start, gaze->start);
+		VectorCopy(forward, gaze->forward);
+		gaze->who = LookingAtRay(ent, filter, start, forward, ignore, gaze->endpos, &gaze->range);
 	}
-	if((Q_strcasecmp(tr.ent->classname,"worldspawn") == 0) && (filter & LOOKAT_NOWORLD))
+
+	if(!gaze->who)
 	{
-		// world brush
 		gi.sound (ent, CHAN_AUTO, gi.soundindex ("misc/talk1.wav"), 1, ATTN_NORM, 0);
 		return NULL;
 	}
-	if(endpos) {
-		endpos[0] = tr.endpos[0];
-		endpos[1] = tr.endpos[1];
-		endpos[2] = tr.endpos[2];
-	}
-	if(range) {
-		VectorSubtract(tr.endpos,start,start);
-		*range = VectorLength(start);
-	}
-	return tr.ent;
+	if(endpos)
+		VectorCopy(gaze->endpos, endpos);
+	if(range)
+		*range = gaze->range;
+	return gaze->who;
 }
 
 void GameDirRelativePath(char *filename, char *output)
@@ -903,19 +2468,10 @@ void G_UseTarget (edict_t *ent, edict_t *activator, edict_t *target)
 //
 	if (ent->delay)
 	{
-	// create a temp object to fire at a later time
-		t = G_Spawn();
-		t->classname = "DelayedUse";
-		t->nextthink = level.time + ent->delay;
-		t->think = Think_Delay_Single;
-		t->activator = activator;
-		t->target_ent = target;
+	// queue it to fire at a later time
 		if (!activator)
 			gi.dprintf ("Think_Delay_Single with no activator\n");
-		t->message = ent->message;
-		t->target = ent->target;
-		t->killtarget = ent->killtarget;
-		t->noise_index = ent->noise_index;
+		G_DelayUse (DELAY_USETARGET, ent, activator, target);
 		return;
 	}
 	
@@ -22,6 +22,147 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "g_local.h"
 
 
+/*
+==============================================================================
+
+PROJECTILE LIST
+
+fire_blaster and fire_rocket add what they fire here, marked
+FL_PROJECTILE. G_RunFrame moves them all with G_RunProjectiles in one
+pass before the other entities and skips them in its own loop. They
+are still ordinary, networked edicts; only their moving is different.
+
+A projectile that stops being a free flying missile, lands, or gets a
+prethink or postthink, leaves the list and is run by G_RunEntity again.
+An entry whose edict was freed (and maybe reused by something else)
+just drops out when it is reached.
+
+projectile_slot tells which entry an edict has, so nothing is listed
+twice when a freed projectile's edict is fired again.
+
+==============================================================================
+*/
+
+static edict_t	**projectile_list;
+static int		*projectile_slot;		// per edict, index into projectile_list + 1
+static int		num_projectiles;
+
+/*
+=================
+G_InitProjectiles
+
+Called from InitGame. The list is allocated by the first level.
+=================
+*/
+void G_InitProjectiles (void)
+{
+	projectile_list = NULL;
+	projectile_slot = NULL;
+	num_projectiles = 0;
+}
+
+/*
+=================
+G_ResetProjectiles
+
+Called when a level is spawned, with nothing to find, or loaded, when
+the list is rebuilt from the FL_PROJECTILE flags that were saved.
+=================
+*/
+void G_ResetProjectiles (void)
+{
+	edict_t	*e;
+	int		i;
+
+	if (!projectile_list)
+	{
+		projectile_list = gi.TagMalloc (game.maxentities * sizeof(edict_t *), TAG_GAME);
+		projectile_slot = gi.TagMalloc (game.maxentities * sizeof(int), TAG_GAME);
+	}
+	memset (projectile_slot, 0, game.maxentities * sizeof(int));
+	num_projectiles = 0;
+
+	for (i=1, e=g_edicts+1 ; i<globals.num_edicts ; i++, e++)
+		if (e->inuse && (e->flags & FL_PROJECTILE))
+		{
+			e->flags &= ~FL_PROJECTILE;
+			G_AddProjectile (e);
+		}
+}
+
+void G_AddProjectile (edict_t *ent)
+{
+	int		num = ent - g_edicts;
+	int		slot;
+
+	if (!projectile_list)
+		G_ResetProjectiles ();
+
+	ent->flags |= FL_PROJECTILE;
+	slot = projectile_slot[num] - 1;
+	if (slot >= 0 && slot < num_projectiles && projectile_list[slot] == ent)
+		return;		// already listed, from before its edict was freed
+
+	projectile_list[num_projectiles] = ent;
+	projectile_slot[num] = ++num_projectiles;
+}
+
+static void G_RemoveProjectile (int slot)
+{
+	edict_t	*ent = projectile_list[slot];
+
+	projectile_slot[ent - g_edicts] = 0;
+	if (ent->inuse)
+		ent->flags &= ~FL_PROJECTILE;
+
+	num_projectiles--;
+	if (slot < num_projectiles)
+	{
+		projectile_list[slot] = projectile_list[num_projectiles];
+		projectile_slot[projectile_list[slot] - g_edicts] = slot + 1;
+	}
+}
+
+/*
+=================
+G_RunProjectiles
+
+Called from G_RunFrame before the other entities are run
+=================
+*/
+void G_RunProjectiles (void)
+{
+	edict_t	*ent;
+	int		i;
+
+	if (!num_projectiles || level.freeze)
+		return;
+
+	Prof_Begin (PROF_PHYS_TOSS);
+	for (i=0 ; i<num_projectiles ; )
+	{
+		ent = projectile_list[i];
+		if (!ent->inuse || !(ent->flags & FL_PROJECTILE))
+		{
+			G_RemoveProjectile (i);
+			continue;
+		}
+		if (ent->movetype != MOVETYPE_FLYMISSILE || ent->groundentity || ent->prethink || ent->postthink)
+		{
+			// G_RunFrame's loop, which comes next, runs it from now on
+			G_RemoveProjectile (i);
+			continue;
+		}
+
+		level.current_entity = ent;
+		VectorCopy (ent->s.origin, ent->s.old_origin);
+		SV_Physics_Missile (ent);
+		i++;
+	}
+	Prof_End (PROF_PHYS_TOSS);
+}
+
+
 /*
 =================
 check_dodge
@@ -97,7 +238,9 @@ qboolean fire_hit (edict_t *self, vec3_t aim, int damage, int kick)
 
 	VectorMA (self->s.origin, range, dir, point);
 
+	G_LagRewind (self);
 	tr = gi.trace (self->s.origin, NULL, NULL, point, self, MASK_SHOT);
+	G_LagRestore ();
 	if (tr.fraction < 1)
 	{
 		if (!tr.ent->takedamage)
@@ -132,97 +275,188 @@ qboolean fire_hit (edict_t *self, vec3_t aim, int damage, int kick)
 
 /*
 =================
-fire_lead
+fire_lead_aim
 
-This is an internal support routine used for bullet/pellet based weapons.
+Picks where one bullet from start along forward goes, spread by up to
+hspread and vspread. Returns the content mask to trace it with.
 =================
 */
-void fire_lead (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+static int fire_lead_aim (vec3_t start, vec3_t forward, vec3_t right, vec3_t up, qboolean start_in_water, int hspread, int vspread, vec3_t end)
 {
-	trace_t		tr;
-	vec3_t		dir;
-	vec3_t		forward, right, up;
-	vec3_t		end;
 	float		r;
 	float		u;
-	vec3_t		water_start;
-	qboolean	water = false;
-	int			content_mask = MASK_SHOT | MASK_WATER;
 
-	tr = gi.trace (self->s.origin, NULL, NULL, start, self, MASK_SHOT);
-	if (!(tr.fraction < 1.0))
-	{
-		vectoangles (aimdir, dir);
-		AngleVectors (dir, forward, right, up);
+	r = crandom()*hspread;
+	u = crandom()*vspread;
+	VectorMA (start, 8192, forward, end);
+	VectorMA (end, r, right, end);
+	VectorMA (end, u, up, end);
 
-		r = crandom()*hspread;
-		u = crandom()*vspread;
-		VectorMA (start, 8192, forward, end);
-		VectorMA (end, r, right, end);
-		VectorMA (end, u, up, end);
+	if (start_in_water)
+		return MASK_SHOT;
+	return MASK_SHOT | MASK_WATER;
+}
 
-		if (gi.pointcontents (start) & MASK_WATER)
-		{
-			water = true;
-			VectorCopy (start, water_start);
-			content_mask &= ~MASK_WATER;
-		}
+/*
+=================
+fire_lead_water
+
+Takes the trace of a bullet aimed at end by fire_lead_aim, and changes
+its course if it entered water. Returns true if the bullet went through
+water, with water_start set to where it went in.
+=================
+*/
+static qboolean fire_lead_water (edict_t *self, vec3_t start, vec3_t end, qboolean start_in_water, int hspread, int vspread, trace_t *tr, vec3_t water_start)
+{
+	vec3_t		dir;
+	qboolean	water = false;
 
-		tr = gi.trace (start, NULL, NULL, end, self, content_mask);
+	if (start_in_water)
+	{
+		water = true;
+		VectorCopy (start, water_start);
+	}
 
-		// see if we hit water
-		if (tr.contents & MASK_WATER)
-		{
-			int		color;
+	// see if we hit water
+	if (tr->contents & MASK_WATER)
+	{
+		int		color;
+		float	r;
+		float	u;
+		vec3_t	wforward, wright, wup;
 
-			water = true;
-			VectorCopy (tr.endpos, water_start);
+		water = true;
+		VectorCopy (tr->endpos, water_start);
 
-			if (!VectorCompare (start, tr.endpos))
+		if (!VectorCompare (start, tr->endpos))
+		{
+			if (tr->ent->svflags & SVF_MUD)
+				color = SPLASH_BROWN_WATER;
+			else if (tr->contents & CONTENTS_WATER)
 			{
-				if (tr.ent->svflags & SVF_MUD)
+				if (strcmp(tr->surface->name, "*brwater") == 0)
 					color = SPLASH_BROWN_WATER;
-				else if (tr.contents & CONTENTS_WATER)
-				{
-					if (strcmp(tr.surface->name, "*brwater") == 0)
-						color = SPLASH_BROWN_WATER;
-					else
-						color = SPLASH_BLUE_WATER;
-				}
-				else if (tr.contents & CONTENTS_SLIME)
-					color = SPLASH_SLIME;
-				else if (tr.contents & CONTENTS_LAVA)
-					color = SPLASH_LAVA;
 				else
-					color = SPLASH_UNKNOWN;
-
-				if (color != SPLASH_UNKNOWN)
-				{
-					gi.WriteByte (svc_temp_entity);
-					gi.WriteByte (TE_SPLASH);
-					gi.WriteByte (8);
-					gi.WritePosition (tr.endpos);
-					gi.WriteDir (tr.plane.normal);
-					gi.WriteByte (color);
-					gi.multicast (tr.endpos, MULTICAST_PVS);
-				}
+					color = SPLASH_BLUE_WATER;
+			}
+			else if (tr->contents & CONTENTS_SLIME)
+				color = SPLASH_SLIME;
+			else if (tr->contents & CONTENTS_LAVA)
+				color = SPLASH_LAVA;
+			else
+				color = SPLASH_UNKNOWN;
 
-				// change bullet's course when it enters water
-				VectorSubtract (end, start, dir);
-				vectoangles (dir, dir);
-				AngleVectors (dir, forward, right, up);
-				r = crandom()*hspread*2;
-				u = crandom()*vspread*2;
-				VectorMA (water_start, 8192, forward, end);
-				VectorMA (end, r, right, end);
-				VectorMA (end, u, up, end);
+			if (color != SPLASH_UNKNOWN)
+			{
+				G_TempSplash (TE_SPLASH, 8, tr->endpos, tr->plane.normal, color);
 			}
 
-			// re-trace ignoring water this time
-			tr = gi.trace (water_start, NULL, NULL, end, self, MASK_SHOT);
+			// change bullet's course when it enters water
+			VectorSubtract (end, start, dir);
+			vectoangles (dir, dir);
+			AngleVectors (dir, wforward, wright, wup);
+			r = crandom()*hspread*2;
+			u = crandom()*vspread*2;
+			VectorMA (water_start, 8192, wforward, end);
+			VectorMA (end, r, wright, end);
+			VectorMA (end, u, wup, end);
 		}
+
+		// re-trace ignoring water this time
+		*tr = gi.trace (water_start, NULL, NULL, end, self, MASK_SHOT);
 	}
 
+	return water;
+}
+
+/*
+=================
+fire_lead_trace
+
+Traces one bullet: fire_lead_aim, the trace, then fire_lead_water
+=================
+*/
+static qboolean fire_lead_trace (edict_t *self, vec3_t start, vec3_t forward, vec3_t right, vec3_t up, qboolean start_in_water, int hspread, int vspread, trace_t *tr, vec3_t water_start)
+{
+	vec3_t		end;
+	int			content_mask;
+
+	content_mask = fire_lead_aim (start, forward, right, up, start_in_water, hspread, vspread, end);
+	*tr = gi.trace (start, NULL, NULL, end, self, content_mask);
+	return fire_lead_water (self, start, end, start_in_water, hspread, vspread, tr, water_start);
+}
+
+/*
+=================
+fire_lead_impact
+
+The gun puff of a bullet that hit something that takes no damage
+=================
+*/
+static void fire_lead_impact (trace_t *tr, int te_impact)
+{
+	G_TempImpact (te_impact, tr->endpos, tr->plane.normal);
+
+	if(level.num_reflectors)
+		ReflectSparks(te_impact,tr->endpos,tr->plane.normal);
+}
+
+/*
+=================
+fire_lead_bubbles
+
+Bubble trail of a bullet that went through water
+=================
+*/
+static void fire_lead_bubbles (trace_t *tr, vec3_t water_start)
+{
+	vec3_t	dir;
+	vec3_t	pos;
+
+	VectorSubtract (tr->endpos, water_start, dir);
+	VectorNormalize (dir);
+	VectorMA (tr->endpos, -2, dir, pos);
+	if (gi.pointcontents (pos) & MASK_WATER)
+		VectorCopy (pos, tr->endpos);
+	else
+		*tr = gi.trace (pos, NULL, NULL, water_start, tr->ent, MASK_WATER);
+
+	VectorAdd (water_start, tr->endpos, pos);
+	VectorScale (pos, 0.5, pos);
+
+	gi.WriteByte (svc_temp_entity);
+	gi.WriteByte (TE_BUBBLETRAIL);
+	gi.WritePosition (water_start);
+	gi.WritePosition (tr->endpos);
+	gi.multicast (pos, MULTICAST_PVS);
+}
+
+/*
+=================
+fire_lead
+
+This is an internal support routine used for bullet/pellet based weapons.
+=================
+*/
+void fire_lead (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int te_impact, int hspread, int vspread, int mod)
+{
+	trace_t		tr;
+	vec3_t		dir;
+	vec3_t		forward, right, up;
+	vec3_t		water_start;
+	qboolean	water = false;
+
+	G_LagRewind (self);
+	tr = gi.trace (self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+	if (!(tr.fraction < 1.0))
+	{
+		vectoangles (aimdir, dir);
+		AngleVectors (dir, forward, right, up);
+		water = fire_lead_trace (self, start, forward, right, up, (gi.pointcontents (start) & MASK_WATER) != 0,
+			hspread, vspread, &tr, water_start);
+	}
+	G_LagRestore ();
+
 	// send gun puff / flash
 	if (!((tr.surface) && (tr.surface->flags & SURF_SKY)))
 	{
@@ -236,14 +470,7 @@ void fire_lead (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick
 			{
 				if (strncmp (tr.surface->name, "sky", 3) != 0)
 				{
-					gi.WriteByte (svc_temp_entity);
-					gi.WriteByte (te_impact);
-					gi.WritePosition (tr.endpos);
-					gi.WriteDir (tr.plane.normal);
-					gi.multicast (tr.endpos, MULTICAST_PVS);
-
-					if(level.num_reflectors)
-						ReflectSparks(te_impact,tr.endpos,tr.plane.normal);
+					fire_lead_impact (&tr, te_impact);
 
 					if (self->client)
 						PlayerNoise(self, tr.endpos, PNOISE_IMPACT);
@@ -254,26 +481,7 @@ void fire_lead (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick
 
 	// if went through water, determine where the end and make a bubble trail
 	if (water)
-	{
-		vec3_t	pos;
-
-		VectorSubtract (tr.endpos, water_start, dir);
-		VectorNormalize (dir);
-		VectorMA (tr.endpos, -2, dir, pos);
-		if (gi.pointcontents (pos) & MASK_WATER)
-			VectorCopy (pos, tr.endpos);
-		else
-			tr = gi.trace (pos, NULL, NULL, water_start, tr.ent, MASK_WATER);
-
-		VectorAdd (water_start, tr.endpos, pos);
-		VectorScale (pos, 0.5, pos);
-
-		gi.WriteByte (svc_temp_entity);
-		gi.WriteByte (TE_BUBBLETRAIL);
-		gi.WritePosition (water_start);
-		gi.WritePosition (tr.endpos);
-		gi.multicast (pos, MULTICAST_PVS);
-	}
+		fire_lead_bubbles (&tr, water_start);
 }
 
 
@@ -296,14 +504,100 @@ void fire_bullet (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int ki
 fire_shotgun
 
 Shoots shotgun pellets.  Used by shotgun and super shotgun.
+
+Works like count calls to fire_lead, but the muzzle check, the aim
+vectors and the water test at start are done once for all pellets, and
+the pellets are one damage batch, so those that hit the same target add
+up to one T_Damage. Only the last impact makes a player noise.
+
+The pellets are aimed first and traced together with G_TraceBatch;
+only those that enter water trace again on their own.
 =================
 */
+#define	MAX_PELLET_BATCH	32
+
 void fire_shotgun (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int hspread, int vspread, int count, int mod)
 {
-	int		i;
+	trace_t		tr;
+	trace_t		muzzle;
+	trace_t		pellets[MAX_PELLET_BATCH];
+	tracerequest_t	requests[MAX_PELLET_BATCH];
+	vec3_t		ends[MAX_PELLET_BATCH];
+	vec3_t		dir;
+	vec3_t		forward, right, up;
+	vec3_t		water_start;
+	vec3_t		noise;
+	qboolean	start_in_water = false;
+	qboolean	blocked;
+	qboolean	water;
+	qboolean	make_noise = false;
+	int			i, n;
 
-	for (i = 0; i < count; i++)
-		fire_lead (self, start, aimdir, damage, kick, TE_SHOTGUN, hspread, vspread, mod);
+	if (count < 1)
+		return;
+
+	// damage is batched, so it lands after the restore
+	T_DamageBatchBegin ();
+	G_LagRewind (self);
+
+	// every pellet starts with the same check for something between
+	// the shooter and the muzzle, so it only needs doing once
+	muzzle = gi.trace (self->s.origin, NULL, NULL, start, self, MASK_SHOT);
+	blocked = (muzzle.fraction < 1.0);
+	if (!blocked)
+	{
+		vectoangles (aimdir, dir);
+		AngleVectors (dir, forward, right, up);
+		start_in_water = (gi.pointcontents (start) & MASK_WATER) != 0;
+	}
+
+	for (i = 0, n = 0; i < count; i++, n++)
+	{
+		if (!blocked && (n == MAX_PELLET_BATCH || i == 0))
+		{
+			// aim and trace the next batch of pellets
+			for (n = 0; n < MAX_PELLET_BATCH && i + n < count; n++)
+			{
+				requests[n].contentmask = fire_lead_aim (start, forward, right, up, start_in_water, hspread, vspread, ends[n]);
+				requests[n].start = start;
+				requests[n].mins = NULL;
+				requests[n].maxs = NULL;
+				requests[n].end = ends[n];
+				requests[n].passent = self;
+			}
+			G_TraceBatch (requests, pellets, n);
+			n = 0;
+		}
+
+		water = false;
+		if (blocked)
+			tr = muzzle;
+		else
+		{
+			tr = pellets[n];
+			water = fire_lead_water (self, start, ends[n], start_in_water, hspread, vspread, &tr, water_start);
+		}
+
+		if (!((tr.surface) && (tr.surface->flags & SURF_SKY)) && (tr.fraction < 1.0))
+		{
+			if (tr.ent->takedamage)
+				T_Damage (tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, DAMAGE_BULLET, mod);
+			else if (strncmp (tr.surface->name, "sky", 3) != 0)
+			{
+				fire_lead_impact (&tr, TE_SHOTGUN);
+				make_noise = true;
+				VectorCopy (tr.endpos, noise);
+			}
+		}
+
+		if (water)
+			fire_lead_bubbles (&tr, water_start);
+	}
+
+	G_LagRestore ();
+	if (make_noise && self->client)
+		PlayerNoise(self, noise, PNOISE_IMPACT);
+	T_DamageBatchEnd ();
 }
 
 
@@ -356,15 +650,7 @@ void blaster_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *
 		else //standard yellow
 			tempevent = TE_BLASTER;
 
-		gi.WriteByte (svc_temp_entity);
-		gi.WriteByte (tempevent);
-		gi.WritePosition (self->s.origin);
-		if (!plane)
-			gi.WriteDir (vec3_origin);
-		else
-			gi.WriteDir (plane->normal);
-
-		gi.multicast (self->s.origin, MULTICAST_PVS);
+		G_TempImpact (tempevent, self->s.origin, plane ? plane->normal : vec3_origin);
 
 		if(level.num_reflectors)
 		{
@@ -390,7 +676,7 @@ void fire_blaster (edict_t *self, vec3_t start, vec3_t dir, int damage, int spee
 
 	VectorNormalize (dir);
 
-	bolt = G_Spawn();
+	bolt = G_SpawnTagged("fire_blaster");
 	bolt->svflags = SVF_DEADMONSTER;
 	// yes, I know it looks weird that projectiles are deadmonsters
 	// what this means is that when prediction is used against the object
@@ -430,6 +716,7 @@ void fire_blaster (edict_t *self, vec3_t start, vec3_t dir, int damage, int spee
 	if (hyper)
 		bolt->spawnflags = 1;
 	gi.linkentity (bolt);
+	G_AddProjectile (bolt);
 
 	if (self->client)
 		check_dodge (self, bolt->s.origin, dir, speed);
@@ -694,7 +981,7 @@ void fire_grenade (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int s
 	vectoangles (aimdir, dir);
 	AngleVectors (dir, forward, right, up);
 
-	grenade = G_Spawn();
+	grenade = G_SpawnTagged("fire_grenade");
 	VectorCopy (start, grenade->s.origin);
 	VectorScale (aimdir, speed, grenade->velocity);
 	// Lazarus - keep same vertical boost for players, but monsters do a better job
@@ -750,7 +1037,7 @@ void fire_grenade2 (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int
 	vectoangles (aimdir, dir);
 	AngleVectors (dir, forward, right, up);
 
-	grenade = G_Spawn();
+	grenade = G_SpawnTagged("fire_grenade2");
 	VectorCopy (start, grenade->s.origin);
 	VectorScale (aimdir, speed, grenade->velocity);
 	VectorMA (grenade->velocity, 200 + crandom() * 10.0, up, grenade->velocity);
@@ -1125,7 +1412,7 @@ void fire_rocket (edict_t *self, vec3_t start, vec3_t dir, int damage, int speed
 {
 	edict_t	*rocket;
 
-	rocket = G_Spawn();
+	rocket = G_SpawnTagged("fire_rocket");
 	VectorCopy (start, rocket->s.origin);
 	VectorCopy (dir, rocket->movedir);
 	vectoangles (dir, rocket->s.angles);
@@ -1196,6 +1483,7 @@ void fire_rocket (edict_t *self, vec3_t start, vec3_t dir, int damage, int speed
 	}
 
 	gi.linkentity (rocket);
+	G_AddProjectile (rocket);
 }
 
 // NOTE: SP_rocket should ONLY be used to spawn rockets that change maps
@@ -1244,52 +1532,89 @@ void SP_rocket (edict_t *rocket)
 
 /*
 =================
-fire_rail
+fire_rail_slug
+
+What fire_rail and fire_rail_alt share. The slug goes through monsters,
+players and anything else with a bounding box, so the world and brush
+models are traced on their own first, ignoring boxes, to find where it
+stops. G_SegmentHits then gives every box along the way, nearest first,
+instead of tracing again from each one. A brush model monster is gone
+through with another world trace.
 =================
 */
-void fire_rail (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
-{
-	vec3_t		from;
-	vec3_t		end;
-	trace_t		tr;
-	edict_t		*ignore;
-	int			mask;
-	qboolean	water;
-	int			tempevent, i=0;
+#define	MAX_RAIL_HITS	64
 
-	tempevent = TE_RAILTRAIL;
+static void fire_rail_slug (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick, int tempevent)
+{
+	vec3_t			from;
+	vec3_t			end;
+	vec3_t			dir;
+	trace_t			tr;
+	segmenthit_t	hits[MAX_RAIL_HITS];
+	segmenthit_t	pierced[MAX_RAIL_HITS];		// brush model monsters
+	segmenthit_t	*hit;
+	edict_t			*ignore;
+	float			length;
+	int				mask;
+	qboolean		water;
+	int				i, j, num, count;
 
 	VectorMA (start, 8192, aimdir, end);
 	VectorCopy (start, from);
 	ignore = self;
 	water = false;
 	mask = MASK_SHOT|CONTENTS_SLIME|CONTENTS_LAVA;
-	while (ignore && i<256)
+	num = 0;
+	// damage is batched, so it lands after the restore
+	T_DamageBatchBegin ();
+	G_LagRewind (self);
+	for (i=0 ; i<256 ; i++)
 	{
-		tr = gi.trace (from, NULL, NULL, end, ignore, mask);
+		tr = gi.trace (from, NULL, NULL, end, ignore, mask & ~(CONTENTS_MONSTER|CONTENTS_DEADMONSTER));
+		VectorCopy (tr.endpos, from);
 
 		if (tr.contents & (CONTENTS_SLIME|CONTENTS_LAVA))
 		{
 			mask &= ~(CONTENTS_SLIME|CONTENTS_LAVA);
 			water = true;
+			continue;
 		}
-		else
-		{
-			//ZOID--added so rail goes through SOLID_BBOX entities (gibs, etc)
-			if ((tr.ent->svflags & SVF_MONSTER) || (tr.ent->client) ||
-				(tr.ent->solid == SOLID_BBOX))
-				ignore = tr.ent;
-			else
-				ignore = NULL;
+		if (tr.fraction == 1.0 || !((tr.ent->svflags & SVF_MONSTER) || tr.ent->client))
+			break;
 
-			if ((tr.ent != self) && (tr.ent->takedamage))
-				T_Damage (tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
+		if (num < MAX_RAIL_HITS)
+		{
+			pierced[num].ent = tr.ent;
+			VectorSubtract (tr.endpos, start, dir);
+			pierced[num].fraction = VectorLength (dir);
+			VectorCopy (tr.endpos, pierced[num].endpos);
+			VectorCopy (tr.plane.normal, pierced[num].normal);
+			num++;
 		}
+		ignore = tr.ent;
+	}
 
-		VectorCopy (tr.endpos, from);
-		i++;
+	// everything with a box between the muzzle and where it stopped,
+	// merged by distance with the brush models gone through
+	count = G_SegmentHits (start, tr.endpos, self, mask, hits, MAX_RAIL_HITS);
+	VectorSubtract (tr.endpos, start, dir);
+	length = VectorLength (dir);
+	for (i = j = 0; i < count || j < num; )
+	{
+		if (j == num || (i < count && hits[i].fraction * length <= pierced[j].fraction))
+			hit = &hits[i++];
+		else
+			hit = &pierced[j++];
+		if ((hit->ent != self) && hit->ent->inuse && (hit->ent->takedamage))
+			T_Damage (hit->ent, self, self, aimdir, hit->endpos, hit->normal, damage, kick, 0, MOD_RAILGUN);
 	}
 
+	// and whatever stopped it
+	if ((tr.fraction < 1.0) && (tr.ent != self) && (tr.ent->takedamage))
+		T_Damage (tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
+	G_LagRestore ();
+	T_DamageBatchEnd ();
+
 	// send gun puff / flash
 	gi.WriteByte (svc_temp_entity);
 	gi.WriteByte (tempevent);
@@ -1313,6 +1638,16 @@ void fire_rail (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick
 		PlayerNoise(self, tr.endpos, PNOISE_IMPACT);
 }
 
+/*
+=================
+fire_rail
+=================
+*/
+void fire_rail (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
+{
+	fire_rail_slug (self, start, aimdir, damage, kick, TE_RAILTRAIL);
+}
+
 /*
 =================
 fire_rail_alt
@@ -1320,68 +1655,7 @@ fire_rail_alt
 */
 void fire_rail_alt (edict_t *self, vec3_t start, vec3_t aimdir, int damage, int kick)
 {
-	vec3_t		from;
-	vec3_t		end;
-	trace_t		tr;
-	edict_t		*ignore;
-	int			mask;
-	qboolean	water;
-	int			tempevent, i=0;
-
-	tempevent = TE_RAILTRAIL2;
-
-	VectorMA (start, 8192, aimdir, end);
-	VectorCopy (start, from);
-	ignore = self;
-	water = false;
-	mask = MASK_SHOT|CONTENTS_SLIME|CONTENTS_LAVA;
-	while (ignore && i<256)
-	{
-		tr = gi.trace (from, NULL, NULL, end, ignore, mask);
-
-		if (tr.contents & (CONTENTS_SLIME|CONTENTS_LAVA))
-		{
-			mask &= ~(CONTENTS_SLIME|CONTENTS_LAVA);
-			water = true;
-		}
-		else
-		{
-			//ZOID--added so rail goes through SOLID_BBOX entities (gibs, etc)
-			if ((tr.ent->svflags & SVF_MONSTER) || (tr.ent->client) ||
-				(tr.ent->solid == SOLID_BBOX))
-				ignore = tr.ent;
-			else
-				ignore = NULL;
-
-			if ((tr.ent != self) && (tr.ent->takedamage))
-				T_Damage (tr.ent, self, self, aimdir, tr.endpos, tr.plane.normal, damage, kick, 0, MOD_RAILGUN);
-		}
-
-		VectorCopy (tr.endpos, from);
-		i++;
-	}
-
-	// send gun puff / flash
-	gi.WriteByte (svc_temp_entity);
-	gi.WriteByte (tempevent);
-	gi.WritePosition (start);
-	gi.WritePosition (tr.endpos);
-	gi.multicast (self->s.origin, MULTICAST_PHS);
-
-	if (level.num_reflectors)
-		ReflectTrail(tempevent,start,tr.endpos);
-
-	if (water)
-	{
-		gi.WriteByte (svc_temp_entity);
-		gi.WriteByte (tempevent);
-		gi.WritePosition (start);
-		gi.WritePosition (tr.endpos);
-		gi.multicast (tr.endpos, MULTICAST_PHS);
-	}
-
-	if (self->client)
-		PlayerNoise(self, tr.endpos, PNOISE_IMPACT);
+	fire_rail_slug (self, start, aimdir, damage, kick, TE_RAILTRAIL2);
 }
 
 /*
@@ -1392,6 +1666,8 @@ fire_bfg
 void bfg_explode (edict_t *self)
 {
 	edict_t	*ent;
+	edict_t	*list[MAX_EDICTS];
+	int		i, num;
 	float	points;
 	vec3_t	v;
 	float	dist;
@@ -1399,9 +1675,12 @@ void bfg_explode (edict_t *self)
 	if (self->s.frame == 0)
 	{
 		// the BFG effect
-		ent = NULL;
-		while ((ent = findradius(ent, self->s.origin, self->dmg_radius)) != NULL)
+		num = G_FindRadiusBatch (self->s.origin, self->dmg_radius, list, MAX_EDICTS);
+		for (i=0 ; i<num ; i++)
 		{
+			ent = list[i];
+			if (!ent->inuse)
+				continue;
 			if (!ent->takedamage)
 				continue;
 			if (ent == self->owner)
@@ -1453,8 +1732,8 @@ void bfg_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf
 
 	// core explosion - prevents firing it into the wall/floor
 	if (other->takedamage)
-		T_Damage (other, self, self->owner, self->velocity, self->s.origin, plane->normal, bfg_rdamage->value, 0, 0, MOD_BFG_BLAST);
-	T_RadiusDamage(self, self->owner, bfg_rdamage->value, other, 100, MOD_BFG_BLAST, -0.5);
+		T_Damage (other, self, self->owner, self->velocity, self->s.origin, plane->normal, km_values.bfg_rdamage, 0, 0, MOD_BFG_BLAST);
+	T_RadiusDamage(self, self->owner, km_values.bfg_rdamage, other, 100, MOD_BFG_BLAST, -0.5);
 
 	gi.sound (self, CHAN_VOICE, gi.soundindex ("weapons/bfg__x1b.wav"), 1, ATTN_NORM, 0);
 	self->solid = SOLID_NOT;
@@ -1482,6 +1761,8 @@ void bfg_touch (edict_t *self, edict_t *other, cplane_t *plane, csurface_t *surf
 void bfg_think (edict_t *self)
 {
 	edict_t	*ent;
+	edict_t	*list[MAX_EDICTS];
+	int		i, num;
 	edict_t	*ignore;
 	vec3_t	point;
 	vec3_t	dir;
@@ -1491,13 +1772,16 @@ void bfg_think (edict_t *self)
 	trace_t	tr;
 
 	if (deathmatch->value)
-		dmg = bfg_damage2->value; //was 5
+		dmg = km_values.bfg_damage2; //was 5
 	else
-		dmg = bfg_damage2->value; //was 10
+		dmg = km_values.bfg_damage2; //was 10
 
-	ent = NULL;
-	while ((ent = findradius(ent, self->s.origin, 256)) != NULL)
+	num = G_FindRadiusBatch (self->s.origin, 256, list, MAX_EDICTS);
+	for (i=0 ; i<num ; i++)
 	{
+		ent = list[i];
+		if (!ent->inuse)
+			continue;
 		if (ent == self)
 			continue;
 
@@ -1573,7 +1857,7 @@ void fire_bfg (edict_t *self, vec3_t start, vec3_t dir, int damage, int speed, f
 {
 	edict_t	*bfg;
 
-	bfg = G_Spawn();
+	bfg = G_SpawnTagged("fire_bfg");
 	VectorCopy (start, bfg->s.origin);
 	VectorCopy (dir, bfg->movedir);
 	vectoangles (dir, bfg->s.angles);
@@ -364,4 +364,98 @@ void lithium_defaults(void)
 	tech_vampire = gi.cvar("tech_vampire", "0.5", 0);
 	tech_vampiremax = gi.cvar("tech_vampiremax", "200", 0);
 	// end CTF Tech stuff
+
+	KM_RefreshCvars (true);
+}
+
+
+typedef struct
+{
+	cvar_t	**cvar;
+	int		ofs;
+	qboolean	isint;
+} kmfield_t;
+
+#define	KMOFS(x)	(int)&(((kmvalues_t *)0)->x)
+#define	KM_INT(x)	{&x, KMOFS(x), true}
+#define	KM_FLOAT(x)	{&x, KMOFS(x), false}
+
+kmvalues_t	km_values;
+
+static kmfield_t km_fields[] =
+{
+	KM_FLOAT(player_max_speed),
+	KM_FLOAT(player_crouch_speed),
+	KM_FLOAT(player_accel),
+	KM_FLOAT(player_stopspeed),
+	KM_INT(blaster_damage),
+	KM_INT(blaster_damage_dm),
+	KM_FLOAT(blaster_speed),
+	KM_FLOAT(blaster_color),
+	KM_INT(shotgun_damage),
+	KM_INT(shotgun_count),
+	KM_INT(shotgun_hspread),
+	KM_INT(shotgun_vspread),
+	KM_INT(sshotgun_damage),
+	KM_INT(sshotgun_count),
+	KM_INT(sshotgun_hspread),
+	KM_INT(sshotgun_vspread),
+	KM_INT(machinegun_damage),
+	KM_INT(machinegun_hspread),
+	KM_INT(machinegun_vspread),
+	KM_INT(chaingun_damage),
+	KM_INT(chaingun_damage_dm),
+	KM_INT(chaingun_hspread),
+	KM_INT(chaingun_vspread),
+	KM_INT(grenade_damage),
+	KM_FLOAT(grenade_radius),
+	KM_FLOAT(grenade_speed),
+	KM_INT(hand_grenade_damage),
+	KM_FLOAT(hand_grenade_radius),
+	KM_FLOAT(rocket_damage),
+	KM_FLOAT(rocket_damage2),
+	KM_FLOAT(rocket_rdamage),
+	KM_FLOAT(rocket_radius),
+	KM_FLOAT(rocket_speed),
+	KM_INT(hyperblaster_damage),
+	KM_INT(hyperblaster_damage_dm),
+	KM_FLOAT(hyperblaster_speed),
+	KM_FLOAT(hyperblaster_color),
+	KM_INT(railgun_damage),
+	KM_INT(railgun_damage_dm),
+	KM_INT(bfg_damage),
+	KM_INT(bfg_damage_dm),
+	KM_INT(bfg_damage2),
+	KM_FLOAT(bfg_rdamage),
+	KM_FLOAT(bfg_radius),
+	KM_FLOAT(bfg_speed),
+	KM_INT(jump_kick_damage),
+	{NULL, 0, false}
+};
+
+/*
+=================
+KM_RefreshCvars
+
+Copies the weapon and movement cvars into km_values. Called with all
+set once the cvars are registered, then from G_RunFrame, where only
+those whose modified flag the engine set since are copied again.
+=================
+*/
+void KM_RefreshCvars (qboolean all)
+{
+	kmfield_t	*f;
+	cvar_t		*var;
+
+	for (f = km_fields; f->cvar; f++)
+	{
+		var = *f->cvar;
+		if (!var || (!all && !var->modified))
+			continue;
+		var->modified = false;
+		if (f->isint)
+			*(int *)((byte *)&km_values + f->ofs) = var->value;
+		else
+			*(float *)((byte *)&km_values + f->ofs) = var->value;
+	}
 }
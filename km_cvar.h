@@ -190,3 +190,69 @@ extern	cvar_t	*tech_regen_armor_always;      // sets whether armor should be reg
 extern	cvar_t	*tech_vampire;       // sets percentage of health gained from damage inflicted
 extern	cvar_t	*tech_vampiremax;    // sets maximum health that can be gained from vampire rune
 // end CTF stuff
+
+// Values of the weapon and movement cvars above, taken once per frame
+// by KM_RefreshCvars instead of read through the cvar at every shot
+typedef struct
+{
+	float	player_max_speed;
+	float	player_crouch_speed;
+	float	player_accel;
+	float	player_stopspeed;
+
+	int		blaster_damage;
+	int		blaster_damage_dm;
+	float	blaster_speed;
+	float	blaster_color;
+
+	int		shotgun_damage;
+	int		shotgun_count;
+	int		shotgun_hspread;
+	int		shotgun_vspread;
+
+	int		sshotgun_damage;
+	int		sshotgun_count;
+	int		sshotgun_hspread;
+	int		sshotgun_vspread;
+
+	int		machinegun_damage;
+	int		machinegun_hspread;
+	int		machinegun_vspread;
+
+	int		chaingun_damage;
+	int		chaingun_damage_dm;
+	int		chaingun_hspread;
+	int		chaingun_vspread;
+
+	int		grenade_damage;
+	float	grenade_radius;
+	float	grenade_speed;
+
+	int		hand_grenade_damage;
+	float	hand_grenade_radius;
+
+	float	rocket_damage;
+	float	rocket_damage2;
+	float	rocket_rdamage;
+	float	rocket_radius;
+	float	rocket_speed;
+
+	int		hyperblaster_damage;
+	int		hyperblaster_damage_dm;
+	float	hyperblaster_speed;
+	float	hyperblaster_color;
+
+	int		railgun_damage;
+	int		railgun_damage_dm;
+
+	int		bfg_damage;
+	int		bfg_damage_dm;
+	int		bfg_damage2;
+	float	bfg_rdamage;
+	float	bfg_radius;
+	float	bfg_speed;
+
+	int		jump_kick_damage;
+} kmvalues_t;
+
+extern	kmvalues_t	km_values;
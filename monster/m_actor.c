@@ -25,7 +25,6 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 //
 #include "../g_local.h"
 #include "m_actor.h"
-#include "../pak.h"
 
 static char wavname[NUM_ACTOR_SOUNDS][32] = 
 { "jump1.wav",
@@ -617,7 +616,7 @@ void actor_dead (edict_t *self)
 	if(world->effects & FX_WORLDSPAWN_CORPSEFADE)
 	{
 		self->think=FadeDieSink;
-		self->nextthink=level.time+corpse_fadetime->value;
+		self->nextthink=level.time+Gov_Lifetime(corpse_fadetime->value);
 	}
 }
 
@@ -1000,7 +999,7 @@ void actor_use (edict_t *self, edict_t *other, edict_t *activator)
 {
 	vec3_t	v;
 
-	self->goalentity = self->movetarget = G_PickTarget(self->target);
+	self->goalentity = self->movetarget = G_PickRoute(self);
 	if ((!self->movetarget) || (strcmp(self->movetarget->classname, "target_actor") != 0))
 	{
 		gi.dprintf ("%s has bad target %s at %s\n", self->classname, self->target, vtos(self->s.origin));
@@ -1681,7 +1680,7 @@ void target_actor_touch (edict_t *self, edict_t *other, cplane_t *plane, csurfac
 
 	// DWH: Allow blank target field
 	if(self->target)
-		other->movetarget = G_PickTarget(self->target);
+		other->movetarget = G_PickRoute(self);
 	else
 		other->movetarget = NULL;
 
@@ -1751,13 +1750,7 @@ void SP_target_actor (edict_t *self)
 
 qboolean InPak(const char *basedir, const char *gamedir, const char *filename)
 {
-	char			pakfile[256];
-	int				k, kk;
-	int				num, numitems;
-	FILE			*f;
-	pak_header_t	pakheader;
-	pak_item_t		pakitem;
-	qboolean		found = false;
+	char			pakpath[MAX_OSPATH];
 	
 #ifdef KMQUAKE2_ENGINE_MOD // *.pak/pk3 support
 	char	*file_data;
@@ -1773,39 +1766,13 @@ qboolean InPak(const char *basedir, const char *gamedir, const char *filename)
 #endif
 
 	// Search paks in game folder
-	for(k=9; k>=0 && !found; k--)
+	strcpy(pakpath,basedir);
+	if(strlen(gamedir))
 	{
-		strcpy(pakfile,basedir);
-		if(strlen(gamedir))
-		{
-			strcat(pakfile,"/");
-			strcat(pakfile,gamedir);
-		}
-		strcat(pakfile,va("/pak%d.pak",k));
-		if (NULL != (f = fopen(pakfile, "rb")))
-		{
-			num=fread(&pakheader,1,sizeof(pak_header_t),f);
-			if(num >= sizeof(pak_header_t))
-			{
-				if( pakheader.id[0] == 'P' &&
-					pakheader.id[1] == 'A' &&
-					pakheader.id[2] == 'C' &&
-					pakheader.id[3] == 'K'     )
-				{
-					numitems = pakheader.dsize/sizeof(pak_item_t);
-					fseek(f,pakheader.dstart,SEEK_SET);
-					for(kk=0; kk<numitems && !found; kk++)
-					{
-						fread(&pakitem,1,sizeof(pak_item_t),f);
-						if(!Q_strcasecmp(pakitem.name,filename))
-							found = true;
-					}
-				}
-			}
-			fclose(f);
-		}
+		strcat(pakpath,"/");
+		strcat(pakpath,gamedir);
 	}
-	return found;
+	return Pak_FindFile(pakpath, filename, NULL);
 }
 
 typedef struct
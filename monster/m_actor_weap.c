@@ -131,11 +131,11 @@ void actorBlaster (edict_t *self)
 		return;
 
 	// Knightmare- select color and effect
-	if (blaster_color->value == 2) { //green
+	if (km_values.blaster_color == 2) { //green
 		color = BLASTER_GREEN;
 		effect = (EF_BLASTER|EF_TRACKER);
 	}
-	else if (blaster_color->value == 3) { //blue
+	else if (km_values.blaster_color == 3) { //blue
 		color = BLASTER_BLUE;
 #ifdef KMQUAKE2_ENGINE_MOD
 		effect = EF_BLASTER|EF_BLUEHYPERBLASTER;
@@ -144,7 +144,7 @@ void actorBlaster (edict_t *self)
 #endif
 	}
 #ifdef KMQUAKE2_ENGINE_MOD
-	else if (blaster_color->value == 4) {//red
+	else if (km_values.blaster_color == 4) {//red
 		color = BLASTER_RED;
 		effect = EF_BLASTER|EF_IONRIPPER;
 	}
@@ -659,12 +659,12 @@ void actorHyperblaster (edict_t *self)
 	else
 	{
 		// Knightmare- select color
-		if (hyperblaster_color->value == 2) //green
+		if (km_values.hyperblaster_color == 2) //green
 			color = BLASTER_GREEN;
-		else if (hyperblaster_color->value == 3) //blue
+		else if (km_values.hyperblaster_color == 3) //blue
 			color = BLASTER_BLUE;
 	#ifdef KMQUAKE2_ENGINE_MOD
-		else if (hyperblaster_color->value == 4) //red
+		else if (km_values.hyperblaster_color == 4) //red
 			color = BLASTER_RED;
 	#endif
 		else //standard yellow
@@ -677,12 +677,12 @@ void actorHyperblaster (edict_t *self)
 		VectorNormalize (forward);
 		if ((random() * 3) < 1)
 		{
-			if (hyperblaster_color->value == 2) //green
+			if (km_values.hyperblaster_color == 2) //green
 				effect = (EF_HYPERBLASTER|EF_TRACKER);
-			else if (hyperblaster_color->value == 3) //blue
+			else if (km_values.hyperblaster_color == 3) //blue
 				effect = EF_BLUEHYPERBLASTER;
 	#ifdef KMQUAKE2_ENGINE_MOD
-			else if (hyperblaster_color->value == 4) //red
+			else if (km_values.hyperblaster_color == 4) //red
 				effect = EF_HYPERBLASTER|EF_IONRIPPER;
 	#endif
 			else //standard yellow
@@ -711,12 +711,12 @@ void actorHyperblaster (edict_t *self)
 			VectorNormalize (forward);
 			if ((random() * 3) < 1)
 			{
-				if (hyperblaster_color->value == 2) //green
+				if (km_values.hyperblaster_color == 2) //green
 					effect = (EF_HYPERBLASTER|EF_TRACKER);
-				else if (hyperblaster_color->value == 3) //blue
+				else if (km_values.hyperblaster_color == 3) //blue
 					effect = EF_BLUEHYPERBLASTER;
 	#ifdef KMQUAKE2_ENGINE_MOD
-				else if (hyperblaster_color->value == 4) //red
+				else if (km_values.hyperblaster_color == 4) //red
 					effect = EF_HYPERBLASTER|EF_IONRIPPER;
 	#endif
 				else //standard yellow
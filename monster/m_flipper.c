@@ -280,7 +280,7 @@ void flipper_dead (edict_t *self)
 	if(world->effects & FX_WORLDSPAWN_CORPSEFADE)
 	{
 		self->think=FadeDieSink;
-		self->nextthink=level.time+corpse_fadetime->value;
+		self->nextthink=level.time+Gov_Lifetime(corpse_fadetime->value);
 	}
 }
 
@@ -164,15 +164,56 @@ qboolean embedded (edict_t *ent)
 		return false;
 }
 
+typedef struct
+{
+	edict_t	*ent;
+	float	dist;
+} medic_candidate_t;
+
+static medic_candidate_t	medic_candidates[MAX_EDICTS];
+
+static int medic_CompareCandidates (const void *a, const void *b)
+{
+	const medic_candidate_t	*ca = (const medic_candidate_t *)a;
+	const medic_candidate_t	*cb = (const medic_candidate_t *)b;
+
+	if (ca->ent->max_health != cb->ent->max_health)
+		return cb->ent->max_health - ca->ent->max_health;
+	if (ca->dist < cb->dist)
+		return -1;
+	return (ca->dist > cb->dist);
+}
+
+/*
+=================
+medic_FindDeadMonster
+
+Lazarus: Walks the corpse list (see M_Corpses) instead of everything
+within 1024 units. The corpses that pass the cheap tests are ranked by
+max_health and then distance, and only then traced, best first, so the
+search stops at the first one the medic can see and reach.
+=================
+*/
 edict_t *medic_FindDeadMonster (edict_t *self)
 {
-	edict_t	*ent = NULL;
+	edict_t	**list;
+	edict_t	*ent;
 	edict_t	*best = NULL;
+	vec3_t	v;
+	float	dist;
+	int		count, num, i, j;
 
-	while ((ent = findradius(ent, self->s.origin, 1024)) != NULL)
+	count = M_Corpses (&list);
+	num = 0;
+	for (i = 0; i < count; i++)
 	{
+		ent = list[i];
 		if (ent == self)
 			continue;
+		if (!ent->inuse)
+			continue;
+		if (ent->solid == SOLID_NOT)
+			continue;
 		if (!(ent->svflags & SVF_MONSTER))
 			continue;
 		if (ent->monsterinfo.aiflags & AI_GOOD_GUY)
@@ -186,20 +227,31 @@ edict_t *medic_FindDeadMonster (edict_t *self)
 		// check to make sure we haven't bailed on this guy already
 		if ((ent->monsterinfo.badMedic1 == self) || (ent->monsterinfo.badMedic2 == self))
 			continue;
+		// same distance findradius measured
+		for (j = 0; j < 3; j++)
+			v[j] = self->s.origin[j] - (ent->s.origin[j] + (ent->mins[j] + ent->maxs[j])*0.5);
+		dist = DotProduct (v, v);
+		if (dist > 1024*1024)
+			continue;
+		medic_candidates[num].ent = ent;
+		medic_candidates[num].dist = dist;
+		num++;
+	}
+
+	if (num > 1)
+		qsort (medic_candidates, num, sizeof(medic_candidates[0]), medic_CompareCandidates);
+
+	for (i = 0; i < num; i++)
+	{
+		ent = medic_candidates[i].ent;
 		if (!visible(self, ent))
 			continue;
 		if (embedded(ent))
 			continue;
 		if (!canReach(self,ent))
 			continue;
-		if (!best)
-		{
-			best = ent;
-			continue;
-		}
-		if (ent->max_health <= best->max_health)
-			continue;
 		best = ent;
+		break;
 	}
 
 	if(best)
@@ -691,7 +743,7 @@ void medic_dead (edict_t *self)
 	if(world->effects & FX_WORLDSPAWN_CORPSEFADE)
 	{
 		self->think=FadeDieSink;
-		self->nextthink=level.time+corpse_fadetime->value;
+		self->nextthink=level.time+Gov_Lifetime(corpse_fadetime->value);
 	}
 }
 
@@ -25,10 +25,127 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #define	STEPSIZE	18
 
+/*
+==============================================================================
+
+MOVE CACHE
+
+A monster that is stuck, or a corpse lying still, asks the same
+questions every frame from the same spot: SV_NewChaseDir tries up to
+ten directions with SV_StepDirection and then M_CheckBottom, and each
+failed step costs several traces. For each edict the cache keeps
+
+- the last M_CheckBottom answer, reused while the edict is at exactly
+  the same origin on the same ground entity, and that has not moved
+  (its linkcount is unchanged)
+- which of the eight 45 degree directions failed a step from the
+  current origin, and at what distance
+
+Both are good for MOVE_CACHE_FRAMES frames only, so a door opening or
+a monster stepping out of the way is noticed soon enough. Monsters
+that can jump never have their steps remembered, since whether they
+jump depends on where their enemy is and which way they face. Like the sight cache, this is
+allocated the first time it is used.
+==============================================================================
+*/
+
+#define	MOVE_CACHE_FRAMES	3
+
+typedef struct
+{
+	int			framenum;		// frame + 1 the answer was found in, 0 if none
+	vec3_t		origin;
+	edict_t		*ground;
+	int			ground_linkcount;
+	qboolean	bottom;
+	int			blocked_frame[8];	// same, per direction
+	float		blocked_yaw[8];
+	float		blocked_dist[8];
+	vec3_t		blocked_origin;
+} movecache_t;
+
+static movecache_t	*move_cache;
+
+/*
+=============
+M_InitMoveCache
+
+Called from InitGame. The first monster to move allocates the cache.
+=============
+*/
+void M_InitMoveCache (void)
+{
+	move_cache = NULL;
+}
+
+/*
+=============
+M_ClearMoveCache
+
+Called when a level is spawned or loaded
+=============
+*/
+void M_ClearMoveCache (void)
+{
+	if (move_cache)
+		memset (move_cache, 0, game.maxentities * sizeof(movecache_t));
+}
+
+static movecache_t *M_MoveCache (edict_t *ent)
+{
+	int		n;
+
+	n = ent - g_edicts;
+	if (n < 0 || n >= game.maxentities)
+		return NULL;
+	if (!move_cache)
+		move_cache = (movecache_t *)gi.TagMalloc (game.maxentities * sizeof(movecache_t), TAG_GAME);
+	return &move_cache[n];
+}
+
+static qboolean M_MoveCacheFresh (int framenum)
+{
+	return (framenum && level.framenum + 1 >= framenum && level.framenum + 1 - framenum < MOVE_CACHE_FRAMES);
+}
+
+static qboolean M_CheckBottomReal (edict_t *ent);
+
 /*
 =============
 M_CheckBottom
 
+M_CheckBottomReal's answer, from the move cache if the edict hasn't
+moved since it was last asked
+=============
+*/
+qboolean M_CheckBottom (edict_t *ent)
+{
+	movecache_t	*mc;
+	edict_t		*ground;
+
+	mc = M_MoveCache (ent);
+	if (!mc)
+		return M_CheckBottomReal (ent);
+
+	ground = ent->groundentity;
+	if (M_MoveCacheFresh (mc->framenum)
+		&& VectorCompare (ent->s.origin, mc->origin)
+		&& mc->ground == ground
+		&& (!ground || ground->linkcount == mc->ground_linkcount))
+		return mc->bottom;
+
+	mc->bottom = M_CheckBottomReal (ent);
+	mc->framenum = level.framenum + 1;
+	VectorCopy (ent->s.origin, mc->origin);
+	mc->ground = ground;
+	mc->ground_linkcount = ground ? ground->linkcount : 0;
+	return mc->bottom;
+}
+
+/*
+=============
+M_CheckBottomReal
+
 Returns false if any part of the bottom of the entity is off an edge that
 is not a staircase.
 
@@ -36,7 +153,7 @@ is not a staircase.
 */
 int c_yes, c_no;
 
-qboolean M_CheckBottom (edict_t *ent)
+static qboolean M_CheckBottomReal (edict_t *ent)
 {
 	vec3_t	mins, maxs, start, stop;
 	trace_t	trace;
@@ -616,9 +733,23 @@ qboolean SV_StepDirection (edict_t *ent, float yaw, float dist)
 {
 	vec3_t		move, oldorigin;
 	float		delta;
+	movecache_t	*mc;
+	int			d;
 
 	ent->ideal_yaw = yaw;
 	M_ChangeYaw (ent);
+
+	// a step that just failed from here is not tried again straight away
+	mc = ent->monsterinfo.jump ? NULL : M_MoveCache (ent);
+	d = (int)floor(anglemod(yaw) / 45 + 0.5) & 7;
+	if (mc && M_MoveCacheFresh (mc->blocked_frame[d])
+		&& VectorCompare (ent->s.origin, mc->blocked_origin)
+		&& mc->blocked_yaw[d] == yaw && mc->blocked_dist[d] == dist)
+	{
+		gi.linkentity (ent);
+		G_TouchTriggers (ent);
+		return false;
+	}
 	
 	yaw = yaw*M_PI*2 / 360;
 	move[0] = cos(yaw)*dist;
@@ -637,6 +768,19 @@ qboolean SV_StepDirection (edict_t *ent, float yaw, float dist)
 		G_TouchTriggers (ent);
 		return true;
 	}
+
+	if (mc)
+	{
+		if (!VectorCompare (ent->s.origin, mc->blocked_origin))
+		{
+			// directions blocked from somewhere else don't count here
+			memset (mc->blocked_frame, 0, sizeof(mc->blocked_frame));
+			VectorCopy (ent->s.origin, mc->blocked_origin);
+		}
+		mc->blocked_frame[d] = level.framenum + 1;
+		mc->blocked_yaw[d] = ent->ideal_yaw;
+		mc->blocked_dist[d] = dist;
+	}
 	gi.linkentity (ent);
 	G_TouchTriggers (ent);
 	return false;
@@ -62,6 +62,7 @@ void SP_FixCoopSpots (edict_t *self)
 			{
 //				gi.dprintf("FixCoopSpots changed %s at %s targetname from %s to %s\n", self->classname, vtos(self->s.origin), self->targetname, spot->targetname);
 				self->targetname = spot->targetname;
+				G_IndexEdict(self);
 			}
 			return;
 		}
@@ -85,6 +86,7 @@ void SP_CreateCoopSpots (edict_t *self)
 		spot->s.origin[2] = 80;
 		spot->targetname = "jail3";
 		spot->s.angles[1] = 90;
+		G_IndexEdict(spot);
 
 		spot = G_Spawn();
 		spot->classname = "info_player_coop";
@@ -93,6 +95,7 @@ void SP_CreateCoopSpots (edict_t *self)
 		spot->s.origin[2] = 80;
 		spot->targetname = "jail3";
 		spot->s.angles[1] = 90;
+		G_IndexEdict(spot);
 
 		spot = G_Spawn();
 		spot->classname = "info_player_coop";
@@ -101,6 +104,7 @@ void SP_CreateCoopSpots (edict_t *self)
 		spot->s.origin[2] = 80;
 		spot->targetname = "jail3";
 		spot->s.angles[1] = 90;
+		G_IndexEdict(spot);
 
 		return;
 	}
@@ -673,7 +677,7 @@ void TossClientWeapon (edict_t *self)
 		item = NULL;
 	// Knightmare- don't drop homing missile launcher (null model error), drop rocket launcher instead
 	if (item && (strcmp (item->pickup_name, "Homing Missile Launcher") == 0))
-		item = FindItem("Rocket Launcher");
+		item = &itemlist[rl_index];
 
 	if (!((int)(dmflags->value) & DF_QUAD_DROP))
 		quad = false;
@@ -949,47 +953,47 @@ void SwitchToBestStartWeapon (gclient_t *client)
 		return;
 
 	if ( client->pers.inventory[slugs_index]
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("railgun"))] )
+		&&  client->pers.inventory[railgun_index] )
 	{
-		client->pers.weapon = FindItem ("railgun");
+		client->pers.weapon = &itemlist[railgun_index];
 		return;
 	}
 	if ( client->pers.inventory[cells_index]
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("hyperblaster"))] )
+		&&  client->pers.inventory[hyperblaster_index] )
 	{
-		client->pers.weapon = FindItem ("hyperblaster");
+		client->pers.weapon = &itemlist[hyperblaster_index];
 		return;
 	}
 	if ( client->pers.inventory[bullets_index]
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("chaingun"))] )
+		&&  client->pers.inventory[chaingun_index] )
 	{
-		client->pers.weapon = FindItem ("chaingun");
+		client->pers.weapon = &itemlist[chaingun_index];
 		return;
 	}
 	if ( client->pers.inventory[bullets_index]
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("machinegun"))] )
+		&&  client->pers.inventory[machinegun_index] )
 	{
-		client->pers.weapon = FindItem ("machinegun");
+		client->pers.weapon = &itemlist[machinegun_index];
 		return;
 	}
 	if ( client->pers.inventory[shells_index] > 1
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("super shotgun"))] )
+		&&  client->pers.inventory[sshotgun_index] )
 	{
-		client->pers.weapon = FindItem ("super shotgun");
+		client->pers.weapon = &itemlist[sshotgun_index];
 		return;
 	}
 	if ( client->pers.inventory[shells_index]
-		&&  client->pers.inventory[ITEM_INDEX(FindItem("shotgun"))] )
+		&&  client->pers.inventory[shotgun_index] )
 	{
-		client->pers.weapon = FindItem ("shotgun");
+		client->pers.weapon = &itemlist[shotgun_index];
 		return;
 	}
 	// DWH: Dude may not HAVE a blaster
 	//ent->client->newweapon = FindItem ("blaster");
-	if ( client->pers.inventory[ITEM_INDEX(FindItem("blaster"))] )
-		client->pers.weapon = FindItem ("blaster");
+	if ( client->pers.inventory[blaster_index] )
+		client->pers.weapon = &itemlist[blaster_index];
 	else
-		client->pers.weapon = FindItem ("No Weapon");
+		client->pers.weapon = &itemlist[noweapon_index];
 }
 
 void SelectStartWeapon (gclient_t *client, int style)
@@ -1021,46 +1025,46 @@ void SelectStartWeapon (gclient_t *client, int style)
 	switch(style)
 	{
 	case -1:
-		item = FindItem("No Weapon");
+		item = &itemlist[noweapon_index];
 		break;
 	case -2:
 	case  2:
-		item = FindItem("Shotgun");
+		item = &itemlist[shotgun_index];
 		break;
 	case -3:
 	case  3:
-		item = FindItem("Super Shotgun");
+		item = &itemlist[sshotgun_index];
 		break;
 	case -4:
 	case  4:
-		item = FindItem("Machinegun");
+		item = &itemlist[machinegun_index];
 		break;
 	case -5:
 	case  5:
-		item = FindItem("Chaingun");
+		item = &itemlist[chaingun_index];
 		break;
 	case -6:
 	case  6:
-		item = FindItem("Grenade Launcher");
+		item = &itemlist[gl_index];
 		break;
 	case -7:
 	case  7:
-		item = FindItem("Rocket Launcher");
+		item = &itemlist[rl_index];
 		break;
 	case -8:
 	case  8:
-		item = FindItem("HyperBlaster");
+		item = &itemlist[hyperblaster_index];
 		break;
 	case -9:
 	case  9:
-		item = FindItem("Railgun");
+		item = &itemlist[railgun_index];
 		break;
 	case -10:
 	case  10:
-		item = FindItem("BFG10K");
+		item = &itemlist[bfg_index];
 		break;
 	default:
-		item = FindItem("Blaster");
+		item = &itemlist[blaster_index];
 		break;
 	}
 	client->pers.selected_item = ITEM_INDEX(item);
@@ -1071,7 +1075,7 @@ void SelectStartWeapon (gclient_t *client, int style)
 	if (ctf->value)
 	{
 		client->pers.lastweapon = item;
-		item = FindItem("Grapple");
+		item = &itemlist[grapple_index];
 		client->pers.inventory[ITEM_INDEX(item)] = 1;
 	}
 //ZOID
@@ -1079,10 +1083,10 @@ void SelectStartWeapon (gclient_t *client, int style)
 	// Lazarus: If default weapon is NOT "No Weapon", then give player
 	//          a blaster
 	if(style > 1)
-		client->pers.inventory[ITEM_INDEX(FindItem("Blaster"))] = 1;
+		client->pers.inventory[blaster_index] = 1;
 
 	//Knightmare- player always has null weapon to allow holstering
-	client->pers.inventory[ITEM_INDEX(FindItem("No Weapon"))] = 1;
+	client->pers.inventory[noweapon_index] = 1;
 
 	// and give him standard ammo
 	if (item->ammo)
@@ -1098,24 +1102,24 @@ void SelectStartWeapon (gclient_t *client, int style)
 	// Knightmare- DM start values
 	if (deathmatch->value)
 	{
-		client->pers.inventory[ITEM_INDEX(FindItem("Shells"))] = dm_start_shells->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Bullets"))] = dm_start_bullets->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Rockets"))] = dm_start_rockets->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Homing Missiles"))] = dm_start_homing->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Grenades"))] = dm_start_grenades->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Cells"))] = dm_start_cells->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Slugs"))] = dm_start_slugs->value;
-
-		client->pers.inventory[ITEM_INDEX(FindItem("Shotgun"))] = dm_start_shotgun->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Super Shotgun"))] = dm_start_sshotgun->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Machinegun"))] = dm_start_machinegun->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Chaingun"))] = dm_start_chaingun->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Grenade Launcher"))] = dm_start_grenadelauncher->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Rocket Launcher"))] = dm_start_rocketlauncher->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Homing Missile Launcher"))] = dm_start_rocketlauncher->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("HyperBlaster"))] = dm_start_hyperblaster->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("Railgun"))] = dm_start_railgun->value;
-		client->pers.inventory[ITEM_INDEX(FindItem("BFG10K"))] = dm_start_bfg->value;
+		client->pers.inventory[shells_index] = dm_start_shells->value;
+		client->pers.inventory[bullets_index] = dm_start_bullets->value;
+		client->pers.inventory[rockets_index] = dm_start_rockets->value;
+		client->pers.inventory[homing_index] = dm_start_homing->value;
+		client->pers.inventory[grenades_index] = dm_start_grenades->value;
+		client->pers.inventory[cells_index] = dm_start_cells->value;
+		client->pers.inventory[slugs_index] = dm_start_slugs->value;
+
+		client->pers.inventory[shotgun_index] = dm_start_shotgun->value;
+		client->pers.inventory[sshotgun_index] = dm_start_sshotgun->value;
+		client->pers.inventory[machinegun_index] = dm_start_machinegun->value;
+		client->pers.inventory[chaingun_index] = dm_start_chaingun->value;
+		client->pers.inventory[gl_index] = dm_start_grenadelauncher->value;
+		client->pers.inventory[rl_index] = dm_start_rocketlauncher->value;
+		client->pers.inventory[hml_index] = dm_start_rocketlauncher->value;
+		client->pers.inventory[hyperblaster_index] = dm_start_hyperblaster->value;
+		client->pers.inventory[railgun_index] = dm_start_railgun->value;
+		client->pers.inventory[bfg_index] = dm_start_bfg->value;
 		SwitchToBestStartWeapon (client);
 	}
 }
@@ -1130,6 +1134,7 @@ but is called after each death and level change in deathmatch
 */
 void InitClientPersistant (gclient_t *client, int style)
 {
+	CTFForgetTechs (client);
 	memset (&client->pers, 0, sizeof(client->pers));
 
 	client->homing_rocket = NULL;
@@ -1242,6 +1247,116 @@ void FetchClientEntData (edict_t *ent)
 =======================================================================
 */
 
+/*
+================
+G_SpawnSpots
+
+The info_player_deathmatch (SPAWNSPOT_DEATHMATCH) or info_player_team#
+(CTF_TEAM#) spots of the level in edict order, with the distance from
+each to the nearest live player as PlayersRangeFromSpot returns it.
+The spots are found once a level and the distances once a frame. A
+spot handed to a player is marked with G_SpawnSpotTaken, so a second
+player spawning in the same frame sees the first one standing on it.
+================
+*/
+#define	MAX_SPAWN_SPOTS		256
+
+static char		*spawnspot_classnames[SPAWNSPOT_TYPES] =
+{
+	"info_player_deathmatch",
+	"info_player_team1",
+	"info_player_team2",
+	"info_player_team3"
+};
+
+static edict_t	*spawnspots[SPAWNSPOT_TYPES][MAX_SPAWN_SPOTS];
+static float	spawnspot_range[SPAWNSPOT_TYPES][MAX_SPAWN_SPOTS];
+static int		num_spawnspots[SPAWNSPOT_TYPES];
+static qboolean	spawnspots_found;
+static int		spawnspot_range_frame = -1;
+
+void G_ResetSpawnSpots (void)
+{
+	spawnspots_found = false;
+	spawnspot_range_frame = -1;
+}
+
+static void G_FindSpawnSpots (void)
+{
+	edict_t	*spot;
+	int		type;
+
+	for (type = 0; type < SPAWNSPOT_TYPES; type++)
+	{
+		num_spawnspots[type] = 0;
+		spot = NULL;
+		while ((spot = G_Find (spot, FOFS(classname), spawnspot_classnames[type])) != NULL)
+		{
+			if (num_spawnspots[type] == MAX_SPAWN_SPOTS)
+			{
+				gi.dprintf ("More than %i %s, ignoring the rest\n", MAX_SPAWN_SPOTS, spawnspot_classnames[type]);
+				break;
+			}
+			spawnspots[type][num_spawnspots[type]++] = spot;
+		}
+	}
+	spawnspots_found = true;
+	spawnspot_range_frame = -1;
+}
+
+int G_SpawnSpots (int type, edict_t ***spots, float **ranges)
+{
+	edict_t	*spot;
+	int		i, t;
+
+	if (spawnspots_found)
+	{
+		// a spot freed or reused since the level spawned means starting over
+		for (i = 0; i < num_spawnspots[type]; i++)
+		{
+			spot = spawnspots[type][i];
+			if (!spot->inuse || !spot->classname || strcmp (spot->classname, spawnspot_classnames[type]))
+			{
+				spawnspots_found = false;
+				break;
+			}
+		}
+	}
+	if (!spawnspots_found)
+		G_FindSpawnSpots ();
+
+	if (spawnspot_range_frame != level.framenum)
+	{
+		for (t = 0; t < SPAWNSPOT_TYPES; t++)
+			for (i = 0; i < num_spawnspots[t]; i++)
+				spawnspot_range[t][i] = PlayersRangeFromSpot (spawnspots[t][i]);
+		spawnspot_range_frame = level.framenum;
+	}
+
+	*spots = spawnspots[type];
+	*ranges = spawnspot_range[type];
+	return num_spawnspots[type];
+}
+
+void G_SpawnSpotTaken (edict_t *taken)
+{
+	vec3_t	v;
+	float	dist;
+	int		i, t;
+
+	if (!taken || spawnspot_range_frame != level.framenum)
+		return;
+
+	for (t = 0; t < SPAWNSPOT_TYPES; t++)
+		for (i = 0; i < num_spawnspots[t]; i++)
+		{
+			VectorSubtract (spawnspots[t][i]->s.origin, taken->s.origin, v);
+			dist = VectorLength (v);
+			if (dist < spawnspot_range[t][i])
+				spawnspot_range[t][i] = dist;
+		}
+}
+
 /*
 ================
 PlayersRangeFromSpot
@@ -1290,28 +1405,28 @@ to other players
 */
 edict_t *SelectRandomDeathmatchSpawnPoint (void)
 {
-	edict_t	*spot, *spot1, *spot2;
-	int		count = 0;
+	edict_t	**spots;
+	float	*ranges;
+	int		i, spot1, spot2;
+	int		count;
 	int		selection;
-	float	range, range1, range2;
+	float	range1, range2;
 
-	spot = NULL;
 	range1 = range2 = 99999;
-	spot1 = spot2 = NULL;
+	spot1 = spot2 = -1;
 
-	while ((spot = G_Find (spot, FOFS(classname), "info_player_deathmatch")) != NULL)
+	count = G_SpawnSpots (SPAWNSPOT_DEATHMATCH, &spots, &ranges);
+	for (i = 0; i < count; i++)
 	{
-		count++;
-		range = PlayersRangeFromSpot(spot);
-		if (range < range1)
+		if (ranges[i] < range1)
 		{
-			range1 = range;
-			spot1 = spot;
+			range1 = ranges[i];
+			spot1 = i;
 		}
-		else if (range < range2)
+		else if (ranges[i] < range2)
 		{
-			range2 = range;
-			spot2 = spot;
+			range2 = ranges[i];
+			spot2 = i;
 		}
 	}
 
@@ -1320,7 +1435,7 @@ edict_t *SelectRandomDeathmatchSpawnPoint (void)
 
 	if (count <= 2)
 	{
-		spot1 = spot2 = NULL;
+		spot1 = spot2 = -1;
 	}
 	// Lazarus: This is wrong. If there is no spot1 or spot2, all spots should
 	// be valid.
@@ -1328,21 +1443,22 @@ edict_t *SelectRandomDeathmatchSpawnPoint (void)
 //		count -= 2;
 	else
 	{
-		if(spot1) count--;
-		if(spot2) count--;
+		if(spot1 >= 0) count--;
+		if(spot2 >= 0) count--;
 	}
 
 	selection = rand() % count;
 
-	spot = NULL;
-	do
+	for (i = 0; ; i++)
 	{
-		spot = G_Find (spot, FOFS(classname), "info_player_deathmatch");
-		if (spot == spot1 || spot == spot2)
-			selection++;
-	} while(selection--);
+		if (i == spot1 || i == spot2)
+			continue;
+		if (!selection--)
+			break;
+	}
 
-	return spot;
+	G_SpawnSpotTaken (spots[i]);
+	return spots[i];
 }
 
 /*
@@ -1353,35 +1469,31 @@ SelectFarthestDeathmatchSpawnPoint
 */
 edict_t *SelectFarthestDeathmatchSpawnPoint (void)
 {
+	edict_t	**spots;
+	float	*ranges;
 	edict_t	*bestspot;
-	float	bestdistance, bestplayerdistance;
-	edict_t	*spot;
-
+	float	bestdistance;
+	int		i, count;
 
-	spot = NULL;
 	bestspot = NULL;
 	bestdistance = 0;
-	while ((spot = G_Find (spot, FOFS(classname), "info_player_deathmatch")) != NULL)
+	count = G_SpawnSpots (SPAWNSPOT_DEATHMATCH, &spots, &ranges);
+	for (i = 0; i < count; i++)
 	{
-		bestplayerdistance = PlayersRangeFromSpot (spot);
-
-		if (bestplayerdistance > bestdistance)
+		if (ranges[i] > bestdistance)
 		{
-			bestspot = spot;
-			bestdistance = bestplayerdistance;
+			bestspot = spots[i];
+			bestdistance = ranges[i];
 		}
 	}
 
-	if (bestspot)
-	{
-		return bestspot;
-	}
-
 	// if there is a player just spawned on each and every start spot
 	// we have no choice to turn one into a telefrag meltdown
-	spot = G_Find (NULL, FOFS(classname), "info_player_deathmatch");
+	if (!bestspot && count)
+		bestspot = spots[0];
 
-	return spot;
+	G_SpawnSpotTaken (bestspot);
+	return bestspot;
 }
 
 edict_t *SelectDeathmatchSpawnPoint (void)
@@ -1504,7 +1616,12 @@ void InitBodyQue (void)
 		edict_t	*ent;
 
 		level.body_que = 0;
-		for (i=0; i<BODY_QUEUE_SIZE; i++)
+		level.body_que_size = (int)sv_bodyque->value;
+		if (level.body_que_size < 1)
+			level.body_que_size = 1;
+		if (level.body_que_size > MAX_BODY_QUEUE)
+			level.body_que_size = MAX_BODY_QUEUE;
+		for (i=0; i<level.body_que_size; i++)
 		{
 			ent = G_Spawn();
 			ent->classname = "bodyque";
@@ -1542,13 +1659,70 @@ void body_die (edict_t *self, edict_t *inflictor, edict_t *attacker, int damage,
 	}
 }
 
+/*
+==============
+BodyQueSlot
+
+Picks the body to reuse for a new corpse. Going round from the oldest,
+the first unused body wins, then the first no client has in its PVS,
+and failing those the one whose nearest client is furthest, so the bodies
+that vanish are the ones least likely to be seen going.
+==============
+*/
+static int BodyQueSlot (void)
+{
+	edict_t	*body, *cl;
+	vec3_t	v;
+	float	d, nearest, best_dist;
+	int		i, j, n, best;
+	qboolean	seen;
+
+	best = level.body_que;
+	best_dist = -1;
+	for (i=0; i<level.body_que_size; i++)
+	{
+		n = (level.body_que + i) % level.body_que_size;
+		body = &g_edicts[(int)maxclients->value + n + 1];
+		if (!body->s.modelindex)
+			return n;
+
+		seen = false;
+		nearest = -1;
+		for (j=1; j<=game.maxclients; j++)
+		{
+			cl = &g_edicts[j];
+			if (!cl->inuse || !cl->client)
+				continue;
+			if (G_ClientSeesEntity (body, j))
+				seen = true;
+			VectorSubtract (cl->s.origin, body->s.origin, v);
+			d = DotProduct (v, v);
+			if (nearest < 0 || d < nearest)
+				nearest = d;
+		}
+		if (!seen)
+			return n;
+		if (nearest > best_dist)
+		{
+			best_dist = nearest;
+			best = n;
+		}
+	}
+	return best;
+}
+
 void CopyToBodyQue (edict_t *ent)
 {
 	edict_t		*body;
+	int			n;
+
+	if (level.body_que_size < 1)
+		return;		// bodies weren't reserved (single player)
 
-	// grab a body que and cycle to the next one
-	body = &g_edicts[(int)maxclients->value + level.body_que + 1];
-	level.body_que = (level.body_que + 1) % BODY_QUEUE_SIZE;
+	// grab a body que and cycle to the one after it
+	n = BodyQueSlot ();
+	body = &g_edicts[(int)maxclients->value + n + 1];
+	level.body_que = (n + 1) % level.body_que_size;
 
 	// FIXME: send an effect on the removed body
 
@@ -1893,10 +2067,10 @@ void PutClientInServer (edict_t *ent)
 
 	// Server-side speed control stuff
 #ifdef KMQUAKE2_ENGINE_MOD
-	client->ps.maxspeed = player_max_speed->value;
-	client->ps.duckspeed = player_crouch_speed->value;
-	client->ps.accel = player_accel->value;
-	client->ps.stopspeed = player_stopspeed->value;
+	client->ps.maxspeed = km_values.player_max_speed;
+	client->ps.duckspeed = km_values.player_crouch_speed;
+	client->ps.accel = km_values.player_accel;
+	client->ps.stopspeed = km_values.player_stopspeed;
 #endif
 
 	// clear entity state values
@@ -1965,6 +2139,9 @@ void PutClientInServer (edict_t *ent)
 
 	gi.linkentity (ent);
 
+	// monsters shouldn't follow where this player was before spawning
+	PlayerTrail_New (ent, ent->s.origin);
+
 	// tpp
 	client->chasetoggle = 0;
 	// If chasetoggle set then turn on (delayed start of 5 frames - 0.5s)
@@ -1983,7 +2160,7 @@ void PutClientInServer (edict_t *ent)
 		i = ((client->pers.weapon->weapmodel & 0xff) << 8);
 		ent->s.skinnum = (ent - g_edicts - 1) | i;
 		if (client->pers.weapon->ammo)
-			client->ammo_index = ITEM_INDEX(FindItem(client->pers.weapon->ammo));
+			client->ammo_index = ItemAmmoIndex(client->pers.weapon);
 		else
 			client->ammo_index = 0;
 		client->weaponstate = WEAPON_READY;
@@ -2204,6 +2381,7 @@ void ClientUserinfoChanged (edict_t *ent, char *userinfo)
 
 	// set skin
 	s = Info_ValueForKey (userinfo, "skin");
+	ClientSetTeams (ent, userinfo);
 
 	playernum = ent-g_edicts-1;
 
@@ -2267,6 +2445,11 @@ qboolean ClientConnect (edict_t *ent, char *userinfo)
 {
 	char	*value;
 
+	if (CmdLog_Replaying ()) {
+		Info_SetValueForKey(userinfo, "rejmsg", "Server is replaying a usercmd log.");
+		return false;
+	}
+
 	// check to see if they are on the banned IP list
 	value = Info_ValueForKey (userinfo, "ip");
 	if (SV_FilterPacket(value)) {
@@ -2353,6 +2536,8 @@ void ClientDisconnect (edict_t *ent)
 	if (!ent->client)
 		return;
 
+	CmdLog_ClientDisconnect (ent);
+
 	// tpp
 	if(ent->client->chasetoggle)
 		ChasecamRemove(ent,OPTION_OFF);
@@ -2837,6 +3022,415 @@ void ClientSpycam(edict_t *ent)
 	G_TouchTriggers (ent); // we'll only allow touching trigger_look with "Cam Owner" SF
 	
 }
+/*
+==============
+ClientThink_MudLevel
+
+Sets in_mud from the func_water volumes with SVF_MUD. Those are listed
+once a frame instead of walking every edict for every usercmd.
+==============
+*/
+#define	MAX_MUD_PUDDLES	64
+
+static edict_t	*mud_puddles[MAX_MUD_PUDDLES];
+static int		num_mud_puddles;		// -1 if there are too many to list
+static int		mud_framenum = -1;
+
+static void ClientThink_InMud (edict_t *ent, edict_t *mud)
+{
+	if(!mud->inuse) return;
+	if(!(mud->svflags & SVF_MUD)) return;
+	if(ent->absmin[0] > mud->absmax[0]) return;
+	if(ent->absmin[1] > mud->absmax[1]) return;
+	if(ent->absmin[2] > mud->absmax[2]) return;
+	if(ent->absmax[0] < mud->absmin[0]) return;
+	if(ent->absmax[1] < mud->absmin[1]) return;
+	if(ent->absmax[2] < mud->absmin[2]) return;
+	ent->in_mud = 1;
+	if(ent->s.origin[2] < mud->absmax[2])
+		ent->in_mud = 2;
+	if(ent->s.origin[2] + ent->viewheight < mud->absmax[2])
+		ent->in_mud = 3;
+}
+
+static void ClientThink_MudLevel (edict_t *ent)
+{
+	edict_t	*mud;
+	int		i;
+
+	if (mud_framenum != level.framenum)
+	{
+		mud_framenum = level.framenum;
+		num_mud_puddles = 0;
+		for(i=game.maxclients+1; i<globals.num_edicts; i++)
+		{
+			mud = &g_edicts[i];
+			if(!mud->inuse || !(mud->svflags & SVF_MUD))
+				continue;
+			if(num_mud_puddles == MAX_MUD_PUDDLES)
+			{
+				num_mud_puddles = -1;
+				break;
+			}
+			mud_puddles[num_mud_puddles++] = mud;
+		}
+	}
+
+	ent->in_mud = 0;
+	if (num_mud_puddles < 0)
+	{
+		for(i=game.maxclients+1; i<globals.num_edicts && !ent->in_mud; i++)
+			ClientThink_InMud (ent, &g_edicts[i]);
+	}
+	else
+	{
+		for(i=0; i<num_mud_puddles && !ent->in_mud; i++)
+			ClientThink_InMud (ent, mud_puddles[i]);
+	}
+}
+
+#ifdef JETPACK_MOD
+/*
+==============
+ClientThink_Jetpack
+
+Thrust, fuel and gravity while the jetpack is on
+==============
+*/
+static void ClientThink_Jetpack (edict_t *ent, usercmd_t *ucmd)
+{
+	gclient_t	*client = ent->client;
+
+	if( (ucmd->upmove != 0) || (ucmd->forwardmove != 0) || (ucmd->sidemove != 0) )
+	{
+		if(ucmd->upmove > 0 || !ent->groundentity)
+		{
+			if(!client->jetpack_thrusting)
+			{
+				gi.sound (ent, CHAN_AUTO, gi.soundindex("jetpack/rev.wav"), 1, ATTN_NORM, 0);
+				client->jetpack_start_thrust = level.framenum;
+			}
+			client->jetpack_thrusting = true;
+		}
+		else
+			client->jetpack_thrusting = false;
+	}
+	else
+		client->jetpack_thrusting = false;
+
+	if(client->jetpack_framenum + client->pers.inventory[fuel_index] > level.framenum)
+	{
+		if(jetpack_weenie->value)
+		{
+			Jet_ApplyJet( ent, ucmd );
+			if(client->jetpack_framenum < level.framenum)
+			{
+				if(!client->jetpack_infinite)
+					client->pers.inventory[fuel_index] -= 10;
+				client->jetpack_framenum = level.framenum + 10;
+			}
+		}
+		else
+		{
+			if(client->jetpack_thrusting)
+				Jet_ApplyJet( ent, ucmd );
+			if(client->jetpack_framenum <= level.framenum)
+			{
+				if(client->jetpack_thrusting)
+				{
+					if(!client->jetpack_infinite)
+						client->pers.inventory[fuel_index] -= 11;
+					client->jetpack_framenum = level.framenum + 10;
+				}
+				else
+				{
+					if(!client->jetpack_infinite)
+						client->pers.inventory[fuel_index]--;
+					client->jetpack_framenum = level.framenum + 10;
+				}
+			}
+			if(ucmd->upmove == 0)
+			{
+				// accelerate to 75% gravity in 2 seconds
+				float	gravity;
+				float	g_max = 0.75 * sv_gravity->value;
+
+				gravity = g_max * (level.framenum - client->jetpack_last_thrust)/20;
+				if(gravity > g_max) gravity = g_max;
+				client->ps.pmove.gravity = (int16_t)gravity;
+			}
+			else
+				client->jetpack_last_thrust = level.framenum;
+		}
+	}
+	else
+	{
+		client->jetpack = false;
+		ent->s.frame = FRAME_jump2;	// reset from stand to avoid goofiness
+	}
+}
+#endif
+
+/*
+==============
+ClientThink_MudMove
+
+MUD - "correct" Pmove physics
+==============
+*/
+static void ClientThink_MudMove (edict_t *ent, pmove_t *pm, vec3_t oldorigin, vec3_t oldvelocity)
+{
+	if(pm->waterlevel && ent->in_mud)
+	{
+		vec3_t	point;
+		vec3_t	end;
+		
+		vec3_t	deltapos, deltavel;
+		float	frac;
+
+		pm->watertype |= CONTENTS_MUD;
+		ent->in_mud  = pm->waterlevel;
+		VectorSubtract(ent->s.origin,oldorigin,deltapos);
+		VectorSubtract(ent->velocity,oldvelocity,deltavel);
+		if(pm->waterlevel == 1)
+		{
+			frac = MUD1BASE + MUD1AMP*sin( (float)(level.framenum%10)/10.*2*M_PI);
+			ent->s.origin[0] = oldorigin[0]   + frac*deltapos[0];
+			ent->s.origin[1] = oldorigin[1]   + frac*deltapos[1];
+			ent->s.origin[2] = oldorigin[2]   + 0.75*deltapos[2];
+			ent->velocity[0] = oldvelocity[0] + frac*deltavel[0];
+			ent->velocity[1] = oldvelocity[1] + frac*deltavel[1];
+			ent->velocity[2] = oldvelocity[2] + 0.75*deltavel[2];
+		}
+		else if(pm->waterlevel == 2)
+		{
+			trace_t	tr;
+			float	dist;
+			
+			VectorCopy(oldorigin,point);
+			point[2] += ent->maxs[2];
+			end[0] = point[0]; end[1] = point[1]; end[2] = oldorigin[2] + ent->mins[2];
+			tr = gi.trace(point,NULL,NULL,end,ent,CONTENTS_WATER);
+			dist = point[2] - tr.endpos[2];
+			// frac = waterlevel 1 frac at dist=32 or more,
+			//      = waterlevel 3 frac at dist=10 or less
+			if(dist <= 10)
+				frac = MUD3;
+			else
+				frac = MUD3 + (dist-10)/22.*(MUD1BASE-MUD3);
+			ent->s.origin[0] = oldorigin[0]   + frac*deltapos[0];
+			ent->s.origin[1] = oldorigin[1]   + frac*deltapos[1];
+			ent->s.origin[2] = oldorigin[2]   + frac*deltapos[2];
+			ent->velocity[0] = oldvelocity[0] + frac*deltavel[0];
+			ent->velocity[1] = oldvelocity[1] + frac*deltavel[1];
+			ent->velocity[2] = oldvelocity[2] + frac*deltavel[2];
+			if(!ent->groundentity)
+			{
+				// Player can't possibly move up
+				ent->s.origin[2] = min(oldorigin[2], ent->s.origin[2]);
+				ent->velocity[2] = min(oldvelocity[2],ent->velocity[2]);
+				ent->velocity[2] = min(-10,ent->velocity[2]);
+			}
+		}
+		else
+		{
+			ent->s.origin[0] = oldorigin[0]   + MUD3*deltapos[0];
+			ent->s.origin[1] = oldorigin[1]   + MUD3*deltapos[1];
+			ent->velocity[0] = oldvelocity[0] + MUD3*deltavel[0];
+			ent->velocity[1] = oldvelocity[1] + MUD3*deltavel[1];
+			if(ent->groundentity)
+			{
+				ent->s.origin[2] = oldorigin[2]   + MUD3*deltapos[2];
+				ent->velocity[2] = oldvelocity[2] + MUD3*deltavel[2];
+			}
+			else
+			{
+				ent->s.origin[2] = min(oldorigin[2],ent->s.origin[2]);
+				ent->velocity[2] = min(oldvelocity[2], 0);
+			}
+		}
+	}
+	else
+		ent->in_mud = 0;
+}
+
+/*
+==============
+ClientThink_Move
+
+Runs pmove for a client that isn't chasing someone or looking through
+a camera, then touches what it ran into
+==============
+*/
+static void ClientThink_Move (edict_t *ent, usercmd_t *ucmd, vec3_t oldorigin, vec3_t oldvelocity)
+{
+	gclient_t	*client = ent->client;
+	edict_t		*other;
+	pmove_t		pm;
+	int			i, j;
+
+	// set up for pmove
+	memset (&pm, 0, sizeof(pm));
+
+	if (ent->movetype == MOVETYPE_NOCLIP)
+		client->ps.pmove.pm_type = PM_SPECTATOR;
+	else if (ent->s.modelindex != MAX_MODELS-1)
+		client->ps.pmove.pm_type = PM_GIB;
+	else if (ent->deadflag)
+		client->ps.pmove.pm_type = PM_DEAD;
+	else
+		client->ps.pmove.pm_type = PM_NORMAL;
+
+	if(level.time > ent->gravity_debounce_time)
+		client->ps.pmove.gravity = sv_gravity->value;
+	else
+		client->ps.pmove.gravity = 0;
+
+#ifdef JETPACK_MOD
+	if ( client->jetpack )
+		ClientThink_Jetpack (ent, ucmd);
+#endif
+
+	pm.s = client->ps.pmove;
+
+	for (i=0 ; i<3 ; i++)
+	{
+		pm.s.origin[i] = ent->s.origin[i]*8;
+		pm.s.velocity[i] = ent->velocity[i]*8;
+	}
+
+	if (memcmp(&client->old_pmove, &pm.s, sizeof(pm.s)))
+	{
+		pm.snapinitial = true;
+//		gi.dprintf ("pmove changed!\n");
+	}
+
+	pm.cmd = *ucmd;
+
+	pm.trace = PM_trace;	// adds default parms
+	pm.pointcontents = gi.pointcontents;
+
+	if(ent->vehicle)
+		pm.s.pm_flags |= PMF_ON_GROUND;
+
+	// perform a pmove
+	gi.Pmove (&pm);
+
+	// save results of pmove
+	client->ps.pmove = pm.s;
+	client->old_pmove = pm.s;
+
+	for (i=0 ; i<3 ; i++)
+	{
+		ent->s.origin[i] = pm.s.origin[i]*0.125;
+		ent->velocity[i] = pm.s.velocity[i]*0.125;
+	}
+	VectorCopy (pm.mins, ent->mins);
+	VectorCopy (pm.maxs, ent->maxs);
+
+	client->resp.cmd_angles[0] = SHORT2ANGLE(ucmd->angles[0]);
+	client->resp.cmd_angles[1] = SHORT2ANGLE(ucmd->angles[1]);
+	client->resp.cmd_angles[2] = SHORT2ANGLE(ucmd->angles[2]);
+
+#ifdef JETPACK_MOD
+	if ( client->jetpack && jetpack_weenie->value )
+	{
+		if( pm.groundentity )		// are we on ground
+			if ( Jet_AvoidGround(ent) )	// then lift us if possible
+				pm.groundentity = NULL;		// now we are no longer on ground
+	}
+#endif
+
+	ClientThink_MudMove (ent, &pm, oldorigin, oldvelocity);
+
+	if (ent->groundentity && !pm.groundentity && (pm.cmd.upmove >= 10) && (pm.waterlevel == 0) && !client->jetpack)
+	{	// Knightmare- allow disabling of STUPID grunting when jumping
+		if ((deathmatch->value || player_jump_sounds->value) && !ent->vehicle)
+		{
+			gi.sound(ent, CHAN_VOICE, gi.soundindex("*jump1.wav"), 1, ATTN_NORM, 0);
+			PlayerNoise(ent, ent->s.origin, PNOISE_SELF);
+		}
+		// Paril's vehicle targeting
+		if (ent->vehicle)
+			G_UseTargets (ent->vehicle, ent);
+		// Lazarus: temporarily match velocities with entity we just
+		//          jumped from
+		VectorAdd (ent->groundentity->velocity, ent->velocity, ent->velocity);
+	}
+
+	if (ent->groundentity && !pm.groundentity && (pm.cmd.upmove >= 10) && (pm.waterlevel == 0))
+		ent->client->jumping = 1;
+
+	if (ent->deadflag != DEAD_FROZEN)
+		ent->viewheight = pm.viewheight;
+	ent->waterlevel = pm.waterlevel;
+	ent->watertype = pm.watertype;
+	ent->groundentity = pm.groundentity;
+	if (pm.groundentity)
+		ent->groundentity_linkcount = pm.groundentity->linkcount;
+
+	// Lazarus - lie about ground when driving a vehicle.
+	//           Pmove apparently doesn't think the ground
+	//           can be "owned"
+	if (ent->vehicle && !ent->groundentity)
+	{
+		ent->groundentity = ent->vehicle;
+		ent->groundentity_linkcount = ent->vehicle->linkcount;
+	}
+
+
+	if (ent->deadflag)
+	{
+		if (ent->deadflag != DEAD_FROZEN)
+		{
+			client->ps.viewangles[ROLL] = 40;
+			client->ps.viewangles[PITCH] = -15;
+			client->ps.viewangles[YAW] = client->killer_yaw;
+		}
+	}
+	else
+	{
+		VectorCopy (pm.viewangles, client->v_angle);
+		VectorCopy (pm.viewangles, client->ps.viewangles);
+	}
+
+#ifdef JETPACK_MOD
+	if ( client->jetpack && !(ucmd->buttons & BUTTONS_ATTACK))
+		ent->s.frame = FRAME_stand20;
+#endif
+
+//ZOID
+	if (client->ctf_grapple)
+		CTFGrapplePull((edict_t*)client->ctf_grapple);
+//ZOID
+
+	gi.linkentity (ent);
+
+	if (ent->movetype != MOVETYPE_NOCLIP)
+		G_ClientTouchTriggers (ent);
+
+	if( (world->effects & FX_WORLDSPAWN_JUMPKICK) && (ent->client->jumping) && (ent->solid != SOLID_NOT))
+		kick_attack(ent);
+
+	// touch other objects
+	// Lazarus: but NOT if game is frozen
+	if(!level.freeze)
+	{
+		for (i=0 ; i<pm.numtouch ; i++)
+		{
+			other = pm.touchents[i];
+			for (j=0 ; j<i ; j++)
+				if (pm.touchents[j] == other)
+					break;
+				if (j != i)
+					continue;	// duplicated
+				if (!other->touch)
+					continue;
+				other->touch (other, ent, NULL, NULL);
+		}
+	}
+}
+
 /*
 ==============
 ClientThink
@@ -2845,16 +3439,27 @@ This will be called once for each client frame, which will
 usually be a couple times for each server frame.
 ==============
 */
+static void RunClientThink (edict_t *ent, usercmd_t *ucmd);
+
 void ClientThink (edict_t *ent, usercmd_t *ucmd)
+{
+	if (CmdLog_ClientThink (ent, ucmd))
+		return;		// a replay is driving the clients
+
+	Prof_Begin (PROF_CLIENTTHINK);
+	RunClientThink (ent, ucmd);
+	Prof_End (PROF_CLIENTTHINK);
+}
+
+static void RunClientThink (edict_t *ent, usercmd_t *ucmd)
 {
 	gclient_t	*client;
 	edict_t		*other;
 	edict_t		*ground;
-	pmove_t		pm;
 	vec_t		t;
 	//vec3_t		view;
 	vec3_t		oldorigin, oldvelocity;
-	int			i, j;
+	int			i;
 	float		ground_speed;
 //	short		save_forwardmove;
 
@@ -2893,10 +3498,10 @@ void ClientThink (edict_t *ent, usercmd_t *ucmd)
 
 	// Server-side speed control stuff
 #ifdef KMQUAKE2_ENGINE_MOD
-	client->ps.maxspeed = player_max_speed->value;
-	client->ps.duckspeed = player_crouch_speed->value;
-	client->ps.accel = player_accel->value;
-	client->ps.stopspeed = player_stopspeed->value;
+	client->ps.maxspeed = km_values.player_max_speed;
+	client->ps.duckspeed = km_values.player_crouch_speed;
+	client->ps.accel = km_values.player_accel;
+	client->ps.stopspeed = km_values.player_stopspeed;
 #endif
 
 	if(client->startframe == 0)
@@ -2915,28 +3520,7 @@ void ClientThink (edict_t *ent, usercmd_t *ucmd)
 
 // MUD - get mud level
 	if(level.mud_puddles)
-	{
-		edict_t	*mud;
-
-		ent->in_mud = 0;
-		for(i=game.maxclients+1; i<globals.num_edicts && !ent->in_mud; i++)
-		{
-			mud = &g_edicts[i];
-			if(!mud->inuse) continue;
-			if(!(mud->svflags & SVF_MUD)) continue;
-			if(ent->absmin[0] > mud->absmax[0]) continue;
-			if(ent->absmin[1] > mud->absmax[1]) continue;
-			if(ent->absmin[2] > mud->absmax[2]) continue;
-			if(ent->absmax[0] < mud->absmin[0]) continue;
-			if(ent->absmax[1] < mud->absmin[1]) continue;
-			if(ent->absmax[2] < mud->absmin[2]) continue;
-			ent->in_mud = 1;
-			if(ent->s.origin[2] < mud->absmax[2])
-				ent->in_mud = 2;
-			if(ent->s.origin[2] + ent->viewheight < mud->absmax[2])
-				ent->in_mud = 3;
-		}
-	}
+		ClientThink_MudLevel (ent);
 
 // USE - special actions taken when +use is pressed
 	if(!client->use && (ucmd->buttons & BUTTON_USE))
@@ -3156,308 +3740,7 @@ void ClientThink (edict_t *ent, usercmd_t *ucmd)
 		client->resp.cmd_angles[2] = SHORT2ANGLE(ucmd->angles[2]);
 
 	} else {
-
-		// set up for pmove
-		memset (&pm, 0, sizeof(pm));
-
-		if (ent->movetype == MOVETYPE_NOCLIP)
-			client->ps.pmove.pm_type = PM_SPECTATOR;
-		else if (ent->s.modelindex != MAX_MODELS-1)
-			client->ps.pmove.pm_type = PM_GIB;
-		else if (ent->deadflag)
-			client->ps.pmove.pm_type = PM_DEAD;
-		else
-			client->ps.pmove.pm_type = PM_NORMAL;
-
-		if(level.time > ent->gravity_debounce_time)
-			client->ps.pmove.gravity = sv_gravity->value;
-		else
-			client->ps.pmove.gravity = 0;
-
-#ifdef JETPACK_MOD
-		if ( client->jetpack )
-		{
-			if( (ucmd->upmove != 0) || (ucmd->forwardmove != 0) || (ucmd->sidemove != 0) )
-			{
-				if(ucmd->upmove > 0 || !ent->groundentity)
-				{
-					if(!client->jetpack_thrusting)
-					{
-						gi.sound (ent, CHAN_AUTO, gi.soundindex("jetpack/rev.wav"), 1, ATTN_NORM, 0);
-						client->jetpack_start_thrust = level.framenum;
-					}
-					client->jetpack_thrusting = true;
-				}
-				else
-					client->jetpack_thrusting = false;
-			}
-			else
-				client->jetpack_thrusting = false;
-
-			if(client->jetpack_framenum + client->pers.inventory[fuel_index] > level.framenum)
-			{
-				if(jetpack_weenie->value)
-				{
-					Jet_ApplyJet( ent, ucmd );
-					if(client->jetpack_framenum < level.framenum)
-					{
-						if(!client->jetpack_infinite)
-							client->pers.inventory[fuel_index] -= 10;
-						client->jetpack_framenum = level.framenum + 10;
-					}
-				}
-				else
-				{
-					if(client->jetpack_thrusting)
-						Jet_ApplyJet( ent, ucmd );
-					if(client->jetpack_framenum <= level.framenum)
-					{
-						if(client->jetpack_thrusting)
-						{
-							if(!client->jetpack_infinite)
-								client->pers.inventory[fuel_index] -= 11;
-							client->jetpack_framenum = level.framenum + 10;
-						}
-						else
-						{
-							if(!client->jetpack_infinite)
-								client->pers.inventory[fuel_index]--;
-							client->jetpack_framenum = level.framenum + 10;
-						}
-					}
-					if(ucmd->upmove == 0)
-					{
-						// accelerate to 75% gravity in 2 seconds
-						float	gravity;
-						float	g_max = 0.75 * sv_gravity->value;
-
-						gravity = g_max * (level.framenum - client->jetpack_last_thrust)/20;
-						if(gravity > g_max) gravity = g_max;
-						client->ps.pmove.gravity = (int16_t)gravity;
-					}
-					else
-						client->jetpack_last_thrust = level.framenum;
-				}
-			}
-			else
-			{
-				client->jetpack = false;
-				ent->s.frame = FRAME_jump2;	// reset from stand to avoid goofiness
-			}
-		}
-#endif    // #ifdef JETPACK_MOD
-
-		pm.s = client->ps.pmove;
-
-		for (i=0 ; i<3 ; i++)
-		{
-			pm.s.origin[i] = ent->s.origin[i]*8;
-			pm.s.velocity[i] = ent->velocity[i]*8;
-		}
-
-		if (memcmp(&client->old_pmove, &pm.s, sizeof(pm.s)))
-		{
-			pm.snapinitial = true;
-	//		gi.dprintf ("pmove changed!\n");
-		}
-
-		pm.cmd = *ucmd;
-
-		pm.trace = PM_trace;	// adds default parms
-		pm.pointcontents = gi.pointcontents;
-
-		if(ent->vehicle)
-			pm.s.pm_flags |= PMF_ON_GROUND;
-
-		// perform a pmove
-		gi.Pmove (&pm);
-
-		// save results of pmove
-		client->ps.pmove = pm.s;
-		client->old_pmove = pm.s;
-
-		for (i=0 ; i<3 ; i++)
-		{
-			ent->s.origin[i] = pm.s.origin[i]*0.125;
-			ent->velocity[i] = pm.s.velocity[i]*0.125;
-		}
-		VectorCopy (pm.mins, ent->mins);
-		VectorCopy (pm.maxs, ent->maxs);
-
-		client->resp.cmd_angles[0] = SHORT2ANGLE(ucmd->angles[0]);
-		client->resp.cmd_angles[1] = SHORT2ANGLE(ucmd->angles[1]);
-		client->resp.cmd_angles[2] = SHORT2ANGLE(ucmd->angles[2]);
-
-#ifdef JETPACK_MOD
-		if ( client->jetpack && jetpack_weenie->value )
-		{
-			if( pm.groundentity )		// are we on ground
-				if ( Jet_AvoidGround(ent) )	// then lift us if possible
-					pm.groundentity = NULL;		// now we are no longer on ground
-		}
-#endif
-
-// MUD - "correct" Pmove physics
-		if(pm.waterlevel && ent->in_mud)
-		{
-			vec3_t	point;
-			vec3_t	end;
-			
-			vec3_t	deltapos, deltavel;
-			float	frac;
-
-			pm.watertype |= CONTENTS_MUD;
-			ent->in_mud  = pm.waterlevel;
-			VectorSubtract(ent->s.origin,oldorigin,deltapos);
-			VectorSubtract(ent->velocity,oldvelocity,deltavel);
-			if(pm.waterlevel == 1)
-			{
-				frac = MUD1BASE + MUD1AMP*sin( (float)(level.framenum%10)/10.*2*M_PI);
-				ent->s.origin[0] = oldorigin[0]   + frac*deltapos[0];
-				ent->s.origin[1] = oldorigin[1]   + frac*deltapos[1];
-				ent->s.origin[2] = oldorigin[2]   + 0.75*deltapos[2];
-				ent->velocity[0] = oldvelocity[0] + frac*deltavel[0];
-				ent->velocity[1] = oldvelocity[1] + frac*deltavel[1];
-				ent->velocity[2] = oldvelocity[2] + 0.75*deltavel[2];
-			}
-			else if(pm.waterlevel == 2)
-			{
-				trace_t	tr;
-				float	dist;
-				
-				VectorCopy(oldorigin,point);
-				point[2] += ent->maxs[2];
-				end[0] = point[0]; end[1] = point[1]; end[2] = oldorigin[2] + ent->mins[2];
-				tr = gi.trace(point,NULL,NULL,end,ent,CONTENTS_WATER);
-				dist = point[2] - tr.endpos[2];
-				// frac = waterlevel 1 frac at dist=32 or more,
-				//      = waterlevel 3 frac at dist=10 or less
-				if(dist <= 10)
-					frac = MUD3;
-				else
-					frac = MUD3 + (dist-10)/22.*(MUD1BASE-MUD3);
-				ent->s.origin[0] = oldorigin[0]   + frac*deltapos[0];
-				ent->s.origin[1] = oldorigin[1]   + frac*deltapos[1];
-				ent->s.origin[2] = oldorigin[2]   + frac*deltapos[2];
-				ent->velocity[0] = oldvelocity[0] + frac*deltavel[0];
-				ent->velocity[1] = oldvelocity[1] + frac*deltavel[1];
-				ent->velocity[2] = oldvelocity[2] + frac*deltavel[2];
-				if(!ent->groundentity)
-				{
-					// Player can't possibly move up
-					ent->s.origin[2] = min(oldorigin[2], ent->s.origin[2]);
-					ent->velocity[2] = min(oldvelocity[2],ent->velocity[2]);
-					ent->velocity[2] = min(-10,ent->velocity[2]);
-				}
-			}
-			else
-			{
-				ent->s.origin[0] = oldorigin[0]   + MUD3*deltapos[0];
-				ent->s.origin[1] = oldorigin[1]   + MUD3*deltapos[1];
-				ent->velocity[0] = oldvelocity[0] + MUD3*deltavel[0];
-				ent->velocity[1] = oldvelocity[1] + MUD3*deltavel[1];
-				if(ent->groundentity)
-				{
-					ent->s.origin[2] = oldorigin[2]   + MUD3*deltapos[2];
-					ent->velocity[2] = oldvelocity[2] + MUD3*deltavel[2];
-				}
-				else
-				{
-					ent->s.origin[2] = min(oldorigin[2],ent->s.origin[2]);
-					ent->velocity[2] = min(oldvelocity[2], 0);
-				}
-			}
-		}
-		else
-			ent->in_mud = 0;
-// end MUD
-
-		if (ent->groundentity && !pm.groundentity && (pm.cmd.upmove >= 10) && (pm.waterlevel == 0) && !client->jetpack)
-		{	// Knightmare- allow disabling of STUPID grunting when jumping
-			if ((deathmatch->value || player_jump_sounds->value) && !ent->vehicle)
-			{
-				gi.sound(ent, CHAN_VOICE, gi.soundindex("*jump1.wav"), 1, ATTN_NORM, 0);
-				PlayerNoise(ent, ent->s.origin, PNOISE_SELF);
-			}
-			// Paril's vehicle targeting
-			if (ent->vehicle)
-				G_UseTargets (ent->vehicle, ent);
-			// Lazarus: temporarily match velocities with entity we just
-			//          jumped from
-			VectorAdd (ent->groundentity->velocity, ent->velocity, ent->velocity);
-		}
-
-		if (ent->groundentity && !pm.groundentity && (pm.cmd.upmove >= 10) && (pm.waterlevel == 0))
-			ent->client->jumping = 1;
-
-		if (ent->deadflag != DEAD_FROZEN)
-			ent->viewheight = pm.viewheight;
-		ent->waterlevel = pm.waterlevel;
-		ent->watertype = pm.watertype;
-		ent->groundentity = pm.groundentity;
-		if (pm.groundentity)
-			ent->groundentity_linkcount = pm.groundentity->linkcount;
-
-		// Lazarus - lie about ground when driving a vehicle.
-		//           Pmove apparently doesn't think the ground
-		//           can be "owned"
-		if (ent->vehicle && !ent->groundentity)
-		{
-			ent->groundentity = ent->vehicle;
-			ent->groundentity_linkcount = ent->vehicle->linkcount;
-		}
-
-
-		if (ent->deadflag)
-		{
-			if (ent->deadflag != DEAD_FROZEN)
-			{
-				client->ps.viewangles[ROLL] = 40;
-				client->ps.viewangles[PITCH] = -15;
-				client->ps.viewangles[YAW] = client->killer_yaw;
-			}
-		}
-		else
-		{
-			VectorCopy (pm.viewangles, client->v_angle);
-			VectorCopy (pm.viewangles, client->ps.viewangles);
-		}
-
-#ifdef JETPACK_MOD
-		if ( client->jetpack && !(ucmd->buttons & BUTTONS_ATTACK))
-			ent->s.frame = FRAME_stand20;
-#endif
-
-//ZOID
-	if (client->ctf_grapple)
-		CTFGrapplePull((edict_t*)client->ctf_grapple);
-//ZOID
-
-		gi.linkentity (ent);
-
-		if (ent->movetype != MOVETYPE_NOCLIP)
-			G_TouchTriggers (ent);
-
-		if( (world->effects & FX_WORLDSPAWN_JUMPKICK) && (ent->client->jumping) && (ent->solid != SOLID_NOT))
-			kick_attack(ent);
-
-		// touch other objects
-		// Lazarus: but NOT if game is frozen
-		if(!level.freeze)
-		{
-			for (i=0 ; i<pm.numtouch ; i++)
-			{
-				other = pm.touchents[i];
-				for (j=0 ; j<i ; j++)
-					if (pm.touchents[j] == other)
-						break;
-					if (j != i)
-						continue;	// duplicated
-					if (!other->touch)
-						continue;
-					other->touch (other, ent, NULL, NULL);
-			}
-		}
+		ClientThink_Move (ent, ucmd, oldorigin, oldvelocity);
 	}
 
 	client->oldbuttons = client->buttons;
@@ -3501,7 +3784,11 @@ void ClientThink (edict_t *ent, usercmd_t *ucmd)
 
 // ACEBOT_ADD
 	if (!ent->is_bot && !ent->deadflag && !ent->client->resp.spectator)
+	{
+		Prof_Begin (PROF_BOTNODES);
 		ACEND_PathMap(ent);
+		Prof_End (PROF_BOTNODES);
+	}
 // ACEBOT_END
 
 	if (client->resp.spectator) {
@@ -3623,8 +3910,7 @@ void ClientBeginServerFrame (edict_t *ent)
 	// add player trail so monsters can follow
 	// DWH: Don't add player trail for players in camera
 	if (!deathmatch->value && !client->spycam)
-		if (!visible (ent, PlayerTrail_LastSpot() ) )
-			PlayerTrail_Add (ent->s.old_origin);
+		PlayerTrail_Update (ent);
 
 	client->latched_buttons = 0;
 }
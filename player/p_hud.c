@@ -188,12 +188,29 @@ void BeginIntermission (edict_t *targ)
 ==================
 DeathmatchScoreboardMessage
 
+The layout only depends on who is playing and their score, ping and
+time, so it is built once into dm_scoreboard and reused until one of
+those changes. Only the dogtags for the viewer and the killer are added
+for each viewer.
 ==================
 */
-void DeathmatchScoreboardMessage (edict_t *ent, edict_t *killer)
+typedef struct
+{
+	int		playing;
+	int		score;
+	int		ping;
+	int		minutes;
+} dmsbkey_t;
+
+static dmsbkey_t	dm_scoreboard_key[MAX_CLIENTS];
+static qboolean		dm_scoreboard_valid;
+static char			dm_scoreboard[1024];
+static int			dm_scoreboard_sorted[12];	// client shown in each slot
+static int			dm_scoreboard_total;
+
+static void DeathmatchBuildScoreboard (void)
 {
 	char	entry[1024];
-	char	string[1400];
 	int		stringlength;
 	int		i, j, k;
 	int		sorted[MAX_CLIENTS];
@@ -202,27 +219,12 @@ void DeathmatchScoreboardMessage (edict_t *ent, edict_t *killer)
 	int		picnum;
 	int		x, y;
 	gclient_t	*cl;
-	edict_t		*cl_ent;
-	char	*tag;
-
-// ACEBOT_ADD
-	if (ent->is_bot)
-		return;
-// ACEBOT_END
-
-//ZOID
-	if (ctf->value) {
-		CTFScoreboardMessage (ent, killer);
-		return;
-	}
-//ZOID
 
 	// sort the clients by score
 	total = 0;
 	for (i=0 ; i<game.maxclients ; i++)
 	{
-		cl_ent = g_edicts + 1 + i;
-		if (!cl_ent->inuse || game.clients[i].resp.spectator)
+		if (!dm_scoreboard_key[i].playing)
 			continue;
 		score = game.clients[i].resp.score;
 		for (j=0 ; j<total ; j++)
@@ -240,10 +242,8 @@ void DeathmatchScoreboardMessage (edict_t *ent, edict_t *killer)
 		total++;
 	}
 
-	// print level name and exit rules
-	string[0] = 0;
-
-	stringlength = strlen(string);
+	dm_scoreboard[0] = 0;
+	stringlength = 0;
 
 	// add the clients in sorted order
 	if (total > 12)
@@ -252,41 +252,84 @@ void DeathmatchScoreboardMessage (edict_t *ent, edict_t *killer)
 	for (i=0 ; i<total ; i++)
 	{
 		cl = &game.clients[sorted[i]];
-		cl_ent = g_edicts + 1 + sorted[i];
 
 		picnum = gi.imageindex ("i_fixme");
 		x = (i>=6) ? 160 : 0;
 		y = 32 + 32 * (i%6);
 
-		// add a dogtag
-		if (cl_ent == ent)
-			tag = "tag1";
-		else if (cl_ent == killer)
-			tag = "tag2";
-		else
-			tag = NULL;
-		if (tag)
-		{
-			Com_sprintf (entry, sizeof(entry),
-				"xv %i yv %i picn %s ",x+32, y, tag);
-			j = strlen(entry);
-			if (stringlength + j > 1024)
-				break;
-			strcpy (string + stringlength, entry);
-			stringlength += j;
-		}
-
 		// send the layout
 		Com_sprintf (entry, sizeof(entry),
 			"client %i %i %i %i %i %i ",
 			x, y, sorted[i], cl->resp.score, cl->ping, (level.framenum - cl->resp.enterframe)/600);
 		j = strlen(entry);
-		if (stringlength + j > 1024)
+		if (stringlength + j > 1024 - 1)
 			break;
-		strcpy (string + stringlength, entry);
+		strcpy (dm_scoreboard + stringlength, entry);
 		stringlength += j;
+		dm_scoreboard_sorted[i] = sorted[i];
+	}
+	dm_scoreboard_total = i;
+}
+
+void DeathmatchScoreboardMessage (edict_t *ent, edict_t *killer)
+{
+	char	string[1400];
+	int		stringlength;
+	int		i, x, y;
+	dmsbkey_t	key[MAX_CLIENTS];
+	edict_t		*cl_ent;
+	char	*tag;
+
+// ACEBOT_ADD
+	if (ent->is_bot)
+		return;
+// ACEBOT_END
+
+//ZOID
+	if (ctf->value) {
+		CTFScoreboardMessage (ent, killer);
+		return;
+	}
+//ZOID
+
+	memset (key, 0, game.maxclients * sizeof(key[0]));
+	for (i=0 ; i<game.maxclients ; i++)
+	{
+		cl_ent = g_edicts + 1 + i;
+		if (!cl_ent->inuse || game.clients[i].resp.spectator)
+			continue;
+		key[i].playing = 1;
+		key[i].score = game.clients[i].resp.score;
+		key[i].ping = game.clients[i].ping;
+		key[i].minutes = (level.framenum - game.clients[i].resp.enterframe)/600;
+	}
+	if (!dm_scoreboard_valid || memcmp(key, dm_scoreboard_key, game.maxclients * sizeof(key[0])))
+	{
+		memcpy (dm_scoreboard_key, key, game.maxclients * sizeof(key[0]));
+		DeathmatchBuildScoreboard ();
+		dm_scoreboard_valid = true;
 	}
 
+	// add a dogtag for the viewer and the killer
+	string[0] = 0;
+	stringlength = 0;
+	for (i=0 ; i<dm_scoreboard_total ; i++)
+	{
+		cl_ent = g_edicts + 1 + dm_scoreboard_sorted[i];
+		if (cl_ent == ent)
+			tag = "tag1";
+		else if (cl_ent == killer)
+			tag = "tag2";
+		else
+			continue;
+		x = (i>=6) ? 160 : 0;
+		y = 32 + 32 * (i%6);
+		Com_sprintf (string + stringlength, sizeof(string) - stringlength,
+			"xv %i yv %i picn %s ",x+32, y, tag);
+		stringlength += strlen(string + stringlength);
+	}
+	strcpy (string + stringlength, dm_scoreboard);
+
 	gi.WriteByte (svc_layout);
 	gi.WriteString (string);
 }
@@ -486,11 +529,6 @@ void WhatIsIt (edict_t *ent)
 	}
 }
 
-static char *tnames[] = {
-	"item_tech1", "item_tech2", "item_tech3", "item_tech4", "item_tech5", "item_tech6",
-	NULL
-};
-
 /*
 ===============
 G_SetStats
@@ -532,7 +570,7 @@ void G_SetStats (edict_t *ent)
 	power_armor_type = PowerArmorType (ent);
 	if (power_armor_type)
 	{
-		cells = ent->client->pers.inventory[ITEM_INDEX(FindItem ("cells"))];
+		cells = ent->client->pers.inventory[cells_index];
 		if (cells == 0)
 		{	// ran out of cells for power armor
 			ent->flags &= ~(FL_POWER_SHIELD|FL_POWER_SCREEN);
@@ -737,19 +775,10 @@ void G_SetStats (edict_t *ent)
 	// Knightmare- show tech icon if in DM
 	if (deathmatch->value && !ctf->value)
 	{
-		int i = 0;
 		gitem_t *tech;
 
-		ent->client->ps.stats[STAT_CTF_TECH] = 0;
-		while (tnames[i]) {
-			if ((tech = FindItemByClassname(tnames[i])) != NULL &&
-				ent->client->pers.inventory[ITEM_INDEX(tech)])
-			{
-				ent->client->ps.stats[STAT_CTF_TECH] = gi.imageindex(tech->icon);
-				break;
-			}
-			i++;
-		}
+		tech = CTFWhat_Tech (ent);
+		ent->client->ps.stats[STAT_CTF_TECH] = tech ? gi.imageindex(tech->icon) : 0;
 	}
 	// end Knightmare
 }
@@ -21,6 +21,11 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "../g_local.h"
 
+// hash of the last menu layout sent to each client, 0 for none
+static unsigned int pmenu_sent[MAX_CLIENTS];
+
+static gpool_t pmenu_pool = { "menu handles", sizeof(pmenuhnd_t), 16 };
+
 // Note that the pmenu entries are duplicated
 // this is so that a static set of pmenu entries can be used
 // for multiple clients and changed without interference
@@ -39,7 +44,7 @@ pmenuhnd_t *PMenu_Open(edict_t *ent, pmenu_t *entries, int cur, int num, void *a
 		PMenu_Close(ent);
 	}
 
-	hnd = (pmenuhnd_t*)G_Malloc(sizeof(*hnd));
+	hnd = (pmenuhnd_t*)G_PoolAlloc(&pmenu_pool);
 
 	hnd->arg = arg;
 	hnd->entries = (struct pmenu_s*)G_Malloc(sizeof(pmenu_t) * num);
@@ -100,7 +105,7 @@ void PMenu_Close(edict_t *ent)
         hnd->arg = NULL;
     }
     
-    G_Free(ent->client->menu);
+    G_PoolFree(&pmenu_pool, ent->client->menu);
 	ent->client->menu = NULL;
 	ent->client->showscores = false;
 }
@@ -116,23 +121,19 @@ void PMenu_UpdateEntry(pmenu_t *entry, const char *text, int align, SelectFunc_t
 }
 
 
-void PMenu_Do_Update(edict_t *ent)
+/*
+=================
+PMenu_BuildLayout
+=================
+*/
+static void PMenu_BuildLayout(pmenuhnd_t *hnd, char *string)
 {
-	char string[1400];
 	int i;
 	pmenu_t *p;
 	int x;
-	pmenuhnd_t *hnd;
 	char *t;
 	qboolean alt = false;
 
-	if (!ent->client->menu) {
-		gi.dprintf("warning:  ent has no menu\n");
-		return;
-	}
-
-	hnd = ent->client->menu;
-
 	strcpy(string, "xv 32 yv 8 picn inventory ");
 
 	for (i = 0, p = hnd->entries; i < hnd->num; i++, p++) {
@@ -162,78 +163,81 @@ void PMenu_Do_Update(edict_t *ent)
 			sprintf(string + strlen(string), "string \"%s\" ", t);
 		alt = false;
 	}
+}
+
+#define PMENU_RESEND	5.0		// resend an unchanged menu this often, in seconds
+
+static unsigned int PMenu_LayoutHash(char *string)
+{
+	unsigned int hash = 2166136261u;
+
+	while (*string)
+		hash = (hash ^ *(unsigned char *)string++) * 16777619u;
+	return hash ? hash : 1;
+}
+
+static void PMenu_SendLayout(edict_t *ent, char *string)
+{
+	int n = ent - g_edicts - 1;
+
+	if (n >= 0 && n < MAX_CLIENTS)
+		pmenu_sent[n] = PMenu_LayoutHash(string);
+	ent->client->menutime = level.time;
 
 	gi.WriteByte (svc_layout);
 	gi.WriteString (string);
 }
 
-/*void PMenu_Update(edict_t *ent)
+/*
+=================
+PMenu_Do_Update
+
+The periodic refresh from ClientEndServerFrame. Writes the layout only
+if it differs from the last one sent, or that one is PMENU_RESEND
+seconds old, since the refresh goes out unreliably and something else
+may have replaced the layout meanwhile. Returns true if anything was
+written for the caller to unicast.
+=================
+*/
+qboolean PMenu_Do_Update(edict_t *ent)
 {
+	char string[1400];
+	int n;
+
 	if (!ent->client->menu) {
 		gi.dprintf("warning:  ent has no menu\n");
-		return;
+		return false;
 	}
 
-	if (level.time - ent->client->menutime >= 1.0) {
-		// been a second or more since last update, update now
-		PMenu_Do_Update(ent);
-		gi.unicast (ent, true);
-		ent->client->menutime = level.time;
-		ent->client->menudirty = false;
-	}
-	ent->client->menutime = level.time + 0.2;
-	ent->client->menudirty = true;
-}*/
+	PMenu_BuildLayout(ent->client->menu, string);
 
+	n = ent - g_edicts - 1;
+	if (n >= 0 && n < MAX_CLIENTS && pmenu_sent[n] == PMenu_LayoutHash(string)
+		&& level.time >= ent->client->menutime && level.time - ent->client->menutime < PMENU_RESEND)
+		return false;
+
+	PMenu_SendLayout(ent, string);
+	return true;
+}
+
+/*
+=================
+PMenu_Update
+
+Writes the layout unconditionally, for the caller to unicast
+=================
+*/
 void PMenu_Update(edict_t *ent)
 {
 	char string[1400];
-	int i;
-	pmenu_t *p;
-	int x;
-	pmenuhnd_t *hnd;
-	char *t;
-	qboolean alt = false;
 
 	if (!ent->client->menu) {
 		gi.dprintf("warning:  ent has no menu\n");
 		return;
 	}
 
-	hnd = ent->client->menu;
-
-	strcpy(string, "xv 32 yv 8 picn inventory ");
-
-	for (i = 0, p = hnd->entries; i < hnd->num; i++, p++) {
-		if (!p->text || !*(p->text))
-			continue; // blank line
-		t = p->text;
-		if (*t == '*') {
-			alt = true;
-			t++;
-		}
-		sprintf(string + strlen(string), "yv %d ", 32 + i * 8);
-		if (p->align == PMENU_ALIGN_CENTER)
-			x = 196/2 - strlen(t)*4 + 64;
-		else if (p->align == PMENU_ALIGN_RIGHT)
-			x = 64 + (196 - strlen(t)*8);
-		else
-			x = 64;
-
-		sprintf(string + strlen(string), "xv %d ",
-			x - ((hnd->cur == i) ? 8 : 0));
-
-		if (hnd->cur == i)
-			sprintf(string + strlen(string), "string2 \"\x0d%s\" ", t);
-		else if (alt)
-			sprintf(string + strlen(string), "string2 \"%s\" ", t);
-		else
-			sprintf(string + strlen(string), "string \"%s\" ", t);
-		alt = false;
-	}
-
-	gi.WriteByte (svc_layout);
-	gi.WriteString (string);
+	PMenu_BuildLayout(ent->client->menu, string);
+	PMenu_SendLayout(ent, string);
 }
 
 void PMenu_Next(edict_t *ent)
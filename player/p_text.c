@@ -20,12 +20,94 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "../g_local.h"
-#include "../pak.h"
 
 #define MAX_LINES 24
 #define MAX_LINE_LENGTH 35
 
-text_t text[MAX_LINES];
+/*
+==============================================================================
+
+TEXT DOCUMENTS
+
+A target_text file is read, broken into lines and indexed once per
+level, into a textdoc_t kept by file name and shared by every client
+that reads it. The layout string of each page is built the first time
+any client turns to it, so a page turn or a refresh is a lookup and one
+svc_layout.
+
+A message (target_text without spawnflag 1, target_lock) is laid out
+the same way but belongs to the one handle showing it, and is freed
+with it.
+
+==============================================================================
+*/
+
+static gpool_t text_pool = { "text handles", sizeof(texthnd_t), 8 };
+
+static textdoc_t	*text_docs;		// documents read from files this level
+
+/*
+=================
+Text_ResetCache
+
+Called at level start. The documents went away with TAG_LEVEL.
+=================
+*/
+void Text_ResetCache (void)
+{
+	text_docs = NULL;
+}
+
+static void Text_FreeDoc (textdoc_t *doc)
+{
+	int		i;
+
+	if (doc->pages)
+	{
+		for (i = 0; i < doc->numpages; i++)
+			if (doc->pages[i])
+				G_Free(doc->pages[i]);
+		G_Free(doc->pages);
+	}
+	if (doc->line_start)
+		G_Free(doc->line_start);
+	if (doc->buffer)
+		G_Free(doc->buffer);
+	if (doc->name)
+		G_Free(doc->name);
+	G_Free(doc);
+}
+
+/*
+=================
+Text_IndexDoc
+
+Records where each line starts and makes room for the page layouts
+=================
+*/
+static void Text_IndexDoc (textdoc_t *doc)
+{
+	byte	*p, *end;
+	int		n, step;
+
+	end = doc->buffer + doc->size - 1;
+	n = 1;
+	for (p = doc->buffer + doc->start_char; p < end; p++)
+		if (*p == 0)
+			n++;
+
+	doc->line_start = (int *)G_Malloc(n * sizeof(int));
+	doc->line_start[0] = doc->start_char;
+	doc->numstarts = 1;
+	for (p = doc->buffer + doc->start_char; p < end; p++)
+		if (*p == 0)
+			doc->line_start[doc->numstarts++] = p + 1 - doc->buffer;
+
+	// Text_Next and Text_Prev move a page less one line at a time
+	step = doc->page_length - 1;
+	doc->numpages = (step > 0) ? doc->numstarts / step + 1 : 1;
+	doc->pages = (char **)G_Malloc(doc->numpages * sizeof(char *));
+}
 
 void Text_Open(edict_t *ent)
 {
@@ -41,100 +123,68 @@ void Text_Close(edict_t *ent)
 {
 	if(!ent->client) return;
 	if(!ent->client->textdisplay) return;
-	if(ent->client->textdisplay->buffer)
-	{
-		G_Free(ent->client->textdisplay->buffer);
-		ent->client->textdisplay->buffer = NULL;
-	}
-	G_Free(ent->client->textdisplay);
+	if(ent->client->textdisplay->doc && !ent->client->textdisplay->doc->name)
+		Text_FreeDoc(ent->client->textdisplay->doc);
+	G_PoolFree(&text_pool, ent->client->textdisplay);
 	ent->client->textdisplay = NULL;
 	ent->client->showscores = false;
 }
 
-void Text_BuildDisplay(texthnd_t *hnd)
-{
-	int i, imax, n;
-	byte *p1, *p2, *p3;
+/*
+=================
+Text_BuildDisplay
 
-	for(i=0; i<hnd->page_length+2; i++)
-		text[i].text = NULL;
+Lays out the page starting at hnd->curline
+=================
+*/
+char *Text_BuildDisplay(texthnd_t *hnd)
+{
+	textdoc_t *doc = hnd->doc;
+	text_t	lines[MAX_LINES];
+	int		align;
+	int		i, imax;
+	int		x0, y0;
+	text_t	*p;
+	int		x, xlast;
+	char	*t, *tnext;
+	qboolean alt = false;
+	char	string[2048];
 
-	if(!(hnd->flags & 2))
-	{
-		text[hnd->page_length+1].text = "Esc to quit";
-		if(hnd->nlines > hnd->page_length)
-			text[hnd->page_length].text = "Use [ and ] to scroll";
-	}
+	for(i=0; i<doc->page_length+2; i++)
+		lines[i].text = NULL;
 
-	p1 = hnd->buffer+hnd->start_char;
-	p3 = hnd->buffer+hnd->size-1;
-	if(hnd->curline > 0)
+	if(!(doc->flags & 2))
 	{
-		// Scan for hnd->curline'th 0 byte, point to following character
-		n  = hnd->curline;
-		while(p1 < p3 && n)
-		{
-			if(*p1==0) n--;
-			p1++;
-		}
+		lines[doc->page_length+1].text = "Esc to quit";
+		if(doc->nlines > doc->page_length)
+			lines[doc->page_length].text = "Use [ and ] to scroll";
 	}
 
-	i = 0;
-	p2 = p1;
-	text[i].text = (char *) p2;
-	if(hnd->nlines > hnd->page_length)
-		imax = hnd->page_length-2;
+	if(doc->nlines > doc->page_length)
+		imax = doc->page_length-2;
 	else
-		imax = hnd->page_length-1;
-	while(p2 <= p3 && i < imax)
+		imax = doc->page_length-1;
+	if(hnd->curline < doc->numstarts)
 	{
-		if(*p2 == 0 && p2 < p3)
-		{
-			i++;
-			p2++;
-			text[i].text = (char *)p2;
-		}
-		else
-			p2++;
+		for(i=0; i<=imax && hnd->curline+i < doc->numstarts; i++)
+			lines[i].text = (char *)doc->buffer + doc->line_start[hnd->curline+i];
 	}
-}
-
-void Text_Update(edict_t *ent)
-{
-	int align;
-	int i;
-	int	x0, y0;
-	text_t *p;
-	int x, xlast;
-	char *t, *tnext;
-	qboolean alt = false;
-	char string[2048];
-	texthnd_t *hnd;
-
-
-	if (!ent->client->textdisplay) {
-		gi.dprintf("warning:  ent has no text display\n");
-		return;
-	}
-
-	hnd = ent->client->textdisplay;
-	if(hnd->last_update + 2*FRAMETIME > level.time) return;
-	hnd->last_update = level.time;
-
+	else
+		lines[0].text = (char *)doc->buffer + doc->size - 1;
 
-	x0 = (35 - hnd->page_width)*4;
-	y0 = (22 - hnd->page_length)*4;
+	x0 = (35 - doc->page_width)*4;
+	y0 = (22 - doc->page_length)*4;
 
-	if(!(hnd->flags & 2))
+	if(!(doc->flags & 2))
 	{
 		sprintf(string,"xv %d yv %d picn %s ",
-			x0, y0, hnd->background_image);
+			x0, y0, doc->background_image);
 	}
 	else // Knightmare- we NEED to have a placeholder image here
 		sprintf(string,"xv %d yv %d picn blank ", x0, y0);
 	xlast = 9999;
 
-	for (i = 0, p = hnd->lines; i < hnd->page_length+2; i++, p++)
+	for (i = 0, p = lines; i < doc->page_length+2; i++, p++)
 	{
 		if (!p->text || !*(p->text)) // crashes here on load
 			continue; // blank line
@@ -165,9 +215,9 @@ void Text_Update(edict_t *ent)
 		{
 			sprintf(string + strlen(string), "yv %d ", y0 + 24 + i * 8);
 			if (align == TEXT_CENTER)
-				x = x0 + 20 + (hnd->page_width-1-strlen(t))*4;
+				x = x0 + 20 + (doc->page_width-1-strlen(t))*4;
 			else if (align == TEXT_RIGHT)
-				x = x0 + 20 + (hnd->page_width-1-strlen(t))*8;
+				x = x0 + 20 + (doc->page_width-1-strlen(t))*8;
 			else
 				x = x0 + 20;
 			if(x != xlast)
@@ -186,8 +236,47 @@ void Text_Update(edict_t *ent)
 //	if(strlen(string) > 1000)
 //		gi.dprintf("WARNING: formatted string length (%d) > 1000\n",strlen(string));
 
+	return G_CopyString(string);
+}
+
+void Text_Update(edict_t *ent)
+{
+	texthnd_t *hnd;
+	textdoc_t *doc;
+	char	*layout;
+	int		step, page;
+
+
+	if (!ent->client->textdisplay) {
+		gi.dprintf("warning:  ent has no text display\n");
+		return;
+	}
+
+	hnd = ent->client->textdisplay;
+	if(hnd->last_update + 2*FRAMETIME > level.time) return;
+	hnd->last_update = level.time;
+
+	doc = hnd->doc;
+	step = doc->page_length - 1;
+	page = (step > 0) ? hnd->curline / step : 0;
+	if(page < doc->numpages && hnd->curline == page*max(step,0))
+	{
+		if(!doc->pages[page])
+			doc->pages[page] = Text_BuildDisplay(hnd);
+		layout = doc->pages[page];
+	}
+	else
+		layout = NULL;
+
 	gi.WriteByte (svc_layout);
-	gi.WriteString (string);
+	if(layout)
+		gi.WriteString (layout);
+	else
+	{
+		layout = Text_BuildDisplay(hnd);
+		gi.WriteString (layout);
+		G_Free(layout);
+	}
 	gi.unicast (ent, true);
 }
 
@@ -204,16 +293,16 @@ void Text_Next(edict_t *ent)
 
 	hnd = ent->client->textdisplay;
 
-	displayed_lines = hnd->page_length;
-	if(hnd->nlines > hnd->page_length) displayed_lines--;
-	if(hnd->curline+displayed_lines+1 < hnd->nlines)
+	displayed_lines = hnd->doc->page_length;
+	if(hnd->doc->nlines > hnd->doc->page_length) displayed_lines--;
+	if(hnd->curline+displayed_lines+1 < hnd->doc->nlines)
 	{
 		current = hnd->curline;
 	//	hnd->curline = min(hnd->curline+MAX_LINES/2,hnd->nlines-displayed_lines-1);
-		hnd->curline = hnd->curline+hnd->page_length-1;
+		hnd->curline = hnd->curline+hnd->doc->page_length-1;
 		if(hnd->curline > current)
 		{
-			Text_BuildDisplay(hnd);
+			hnd->last_update = 0;
 			Text_Update(ent);
 		}
 	}
@@ -233,19 +322,25 @@ void Text_Prev(edict_t *ent)
 	if(hnd->curline > 0)
 	{
 	//	hnd->curline = max(0, hnd->curline-MAX_LINES/2);
-		hnd->curline = max(0, hnd->curline-hnd->page_length+1);
-		Text_BuildDisplay(hnd);
+		hnd->curline = max(0, hnd->curline-hnd->doc->page_length+1);
+		hnd->last_update = 0;
 		Text_Update(ent);
 	}
 }
 
+/*
+=================
+Text_LoadDoc
 
-void Do_Text_Display(edict_t *activator, int flags, char *message)
+Reads and lays out a document. Everything but playing the \\a sound is
+done once per file per level.
+=================
+*/
+static textdoc_t *Text_LoadDoc(int flags, char *message)
 {
 	int			L;
 	byte		*p1, *p2, *p3;
-	char		sound[64];
-	texthnd_t	*hnd;
+	textdoc_t	*doc;
 	byte		*temp_buffer;
 	int			line_length;
 	int			new_line_length;
@@ -253,7 +348,16 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 	qboolean	linebreak;
 	qboolean	do_linebreaks;
 
-	hnd = (texthnd_t*)G_Malloc(sizeof(*hnd));
+	if(flags & 1)
+	{
+		for(doc = text_docs; doc; doc = doc->next)
+			if(doc->flags == flags && !Q_strcasecmp(doc->name, message))
+				return doc;
+	}
+
+	doc = (textdoc_t*)G_Malloc(sizeof(*doc));
+	memset(doc,0,sizeof(*doc));
+	doc->flags = flags;
 	// If a file, open and read it
 	if(flags & 1)
 	{
@@ -268,31 +372,29 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 		if (textsize < 2) // file not found
 		{
 			gi.dprintf("File not found: %s\n",textname);
-			return;
+			Text_FreeDoc(doc);
+			return NULL;
 		}
-		hnd->allocated = textsize + 128; // add some slop for additional control characters
-		hnd->buffer = (byte*)G_Malloc(hnd->allocated);
-		if(!hnd->buffer)
+		doc->allocated = textsize + 128; // add some slop for additional control characters
+		doc->buffer = (byte*)G_Malloc(doc->allocated);
+		if(!doc->buffer)
 		{
 			gi.dprintf("Memory allocation failure on target_text\n");
-			Text_Close(activator);
-			return;
+			Text_FreeDoc(doc);
+			return NULL;
 		}
-		memset(hnd->buffer,0,hnd->allocated);
-		memcpy(hnd->buffer, readbuffer, textsize);
-		hnd->buffer[textsize] = 0;
+		memset(doc->buffer,0,doc->allocated);
+		memcpy(doc->buffer, readbuffer, textsize);
+		doc->buffer[textsize] = 0;
 		gi.FreeFile(readbuffer);
 #else
 		cvar_t			*basedir, *gamedir;
 		char			filename[256];
-		char			pakfile[256];
+		char			pakpath[MAX_OSPATH];
 		char			textname[128];
-		int				k, num, numitems;
+		int				textsize;
 		qboolean		in_pak;
 		FILE			*f;
-		pak_header_t	pakheader;
-		pak_item_t		pakitem;
-		int i;
         
 		basedir = gi.cvar("basedir", "", 0);
 		gamedir = gi.cvar("gamedir", "", 0);
@@ -303,49 +405,12 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 			strcat(filename,gamedir->string);
 		}
 		// First check for existence of text file in pak0.pak -> pak9.pak
-		in_pak = false;
-		for(i=0; i<=9 && !in_pak; i++)
-		{
-			sprintf(pakfile,"%s\\pak%d.pak",filename,i);
-			if (NULL != (f = fopen(pakfile, "rb")))
-			{
-				num=fread(&pakheader,1,sizeof(pak_header_t),f);
-				if(num >= sizeof(pak_header_t))
-				{
-					if( pakheader.id[0] == 'P' &&
-						pakheader.id[1] == 'A' &&
-						pakheader.id[2] == 'C' &&
-						pakheader.id[3] == 'K'     )
-					{
-						numitems = pakheader.dsize/sizeof(pak_item_t);
-						sprintf(textname,"maps/%s",message);
-						fseek(f,pakheader.dstart,SEEK_SET);
-						for(k=0; k<numitems && !in_pak; k++)
-						{
-							fread(&pakitem,1,sizeof(pak_item_t),f);
-							if(!Q_strcasecmp(pakitem.name,textname))
-							{
-								in_pak = true;
-								fseek(f,pakitem.start,SEEK_SET);
-								hnd->allocated = pakitem.size + 128;  // add some slop for additional control characters
-								hnd->buffer = G_Malloc(hnd->allocated);
-								if(!hnd->buffer)
-								{
-									fclose(f);
-									gi.dprintf("Memory allocation failure on target_text\n");
-									Text_Close(activator);
-									return;
-								}
-								memset(hnd->buffer,0,hnd->allocated);
-								fread(hnd->buffer,1,pakitem.size,f);
-								hnd->buffer[pakitem.size] = 0;
-							}
-						}
-					}
-				}
-				fclose(f);
-			}
-		}
+		sprintf(textname,"maps/%s",message);
+		Pak_GameDir (pakpath, sizeof(pakpath));
+		doc->buffer = Pak_LoadFile (pakpath, textname, &textsize, 128); // add some slop for additional control characters
+		in_pak = (doc->buffer != NULL);
+		if(in_pak)
+			doc->allocated = textsize + 128;
 		if(!in_pak)
 		{
 			strcat(filename,"\\maps\\");
@@ -354,109 +419,112 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 			if(!f)
 			{
 				gi.dprintf("File not found:%s\n",filename);
-				return;
+				Text_FreeDoc(doc);
+				return NULL;
 			}
 			fseek(f,0,SEEK_END);
 			L = ftell (f);
 			fseek(f,0,SEEK_SET);
-			hnd->allocated = L+128;
-			hnd->buffer = G_Malloc(hnd->allocated);
-			if(!hnd->buffer)
+			doc->allocated = L+128;
+			doc->buffer = G_Malloc(doc->allocated);
+			if(!doc->buffer)
 			{
 				gi.dprintf("Memory allocation failure on target_text\n");
-				Text_Close(activator);
-				return;
+				Text_FreeDoc(doc);
+				return NULL;
 			}
-			memset(hnd->buffer,0,hnd->allocated);
-			fread(hnd->buffer,1,L,f);
+			memset(doc->buffer,0,doc->allocated);
+			fread(doc->buffer,1,L,f);
 			fclose(f);
 		}
 #endif // KMQUAKE2_ENGINE_MOD
 
-		if(!hnd->buffer)
+		if(!doc->buffer)
 		{
 			gi.dprintf("Umm... how'd you get here?\n");
-			Text_Close(activator);
-			return;
+			Text_FreeDoc(doc);
+			return NULL;
 		}
 	}
 	else
 	{
 		L = strlen(message);
-		hnd->allocated = L+128;
-		hnd->buffer = (byte*)G_Malloc(hnd->allocated);
-		if(!hnd->buffer)
+		doc->allocated = L+128;
+		doc->buffer = (byte*)G_Malloc(doc->allocated);
+		if(!doc->buffer)
 		{
 			gi.dprintf("Memory allocation failure\n");
-			Text_Close(activator);
-			return;
+			Text_FreeDoc(doc);
+			return NULL;
 		}
-		memset(hnd->buffer,0,hnd->allocated);
-		memcpy(hnd->buffer,message,L);
+		memset(doc->buffer,0,doc->allocated);
+		memcpy(doc->buffer,message,L);
 	}
 	
-	hnd->size = strlen((char *)hnd->buffer) + 1;
+	doc->size = strlen((char *)doc->buffer) + 1;
 
 	// Default page length:
-	hnd->page_length = MAX_LINES-2;
-	hnd->page_width  = MAX_LINE_LENGTH;
-	strcpy(hnd->background_image,"textdisplay");
-	hnd->start_char = 0;
+	doc->page_length = MAX_LINES-2;
+	doc->page_width  = MAX_LINE_LENGTH;
+	strcpy(doc->background_image,"textdisplay");
+	doc->start_char = 0;
 	do_linebreaks = true;
 
 	// If 1st line starts with $, read page length, width, and image name
-	p1 = hnd->buffer;
+	p1 = doc->buffer;
 	if(*p1 == '$')
 	{
 		p3 = p1;
-		while((p3 < hnd->buffer+hnd->size) && (*p3 != 13))
+		while((p3 < doc->buffer+doc->size) && (*p3 != 13))
 			p3++;
 
 		p2 = (byte *)strstr((char *)p1,"L=");
 		if(p2 && (p2 < p3))
 		{
 			p2 += 2;
-			sscanf((char *)p2,"%d",&hnd->page_length);
-			hnd->page_length += 1;
+			sscanf((char *)p2,"%d",&doc->page_length);
+			doc->page_length += 1;
 		}
 		p2 = (byte *) strstr((char *)p1,"W=");
 		if(p2 && (p2 < p3))
 		{
 			p2 += 2;
-			sscanf((char *)p2,"%d",&hnd->page_width);
+			sscanf((char *)p2,"%d",&doc->page_width);
 		}
 		p2 = (byte *)strstr((char *)p1,"I=");
 		if(p2 && (p2 < p3))
 		{
 			p2 += 2;
-			sscanf((char *)p2,"%s",hnd->background_image);
+			sscanf((char *)p2,"%s",doc->background_image);
 		}
 		p3++;
 		if(*p3 == 10) p3++;
-		hnd->start_char = p3-p1;
+		doc->start_char = p3-p1;
 		do_linebreaks = false;
 	}
+	// the layout holds at most MAX_LINES lines
+	doc->page_length = max(1, min(doc->page_length, MAX_LINES-2));
 
 	// Eliminate all <CR>'s so lines are delineated with <LF>'s only
-	p1 = hnd->buffer+hnd->start_char;
-	while(p1 < hnd->buffer+hnd->size)
+	p1 = doc->buffer+doc->start_char;
+	while(p1 < doc->buffer+doc->size)
 	{
 		if(*p1 == 13)
 		{
-			for(p2=p1, p3=p1+1; p2<hnd->buffer+hnd->size; p2++, p3++)
+			for(p2=p1, p3=p1+1; p2<doc->buffer+doc->size; p2++, p3++)
 				*p2 = *p3;
-			hnd->size--;
+			doc->size--;
 		}
 		else
 			p1++;
 	}
 	// Count number of lines and replace all line feeds with 0's
-	hnd->nlines = 1;
-	for(p1 = hnd->buffer+hnd->start_char; p1 < hnd->buffer+hnd->size; p1++)
+	doc->nlines = 1;
+	for(p1 = doc->buffer+doc->start_char; p1 < doc->buffer+doc->size; p1++)
 	{
 		if(*p1 == 10)
 		{
-			hnd->nlines++;
+			doc->nlines++;
 			*p1 = 0;
 		}
 	}
@@ -465,11 +533,11 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 		goto done_linebreaks;
 
 	line_length = 0;
-	p1 = hnd->buffer+hnd->start_char;
+	p1 = doc->buffer+doc->start_char;
 	alt = false;
 	centered = false;
 	right_justified = false;
-	while(p1 < hnd->buffer+hnd->size)
+	while(p1 < doc->buffer+doc->size)
 	{
 		// Don't count control characters
 		if(line_length == 0) {
@@ -501,14 +569,14 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 		if((line_length == 0) && (*p1 == '\\')) p1 += 2;
 		if(*p1 != 0) line_length++;
 		linebreak = false;
-		if(line_length > hnd->page_width)
+		if(line_length > doc->page_width)
 		{
 			if(*p1 == 32)
 			{
 				// We're at a space... good deal, just replace space with 
 				// a line-break 0 and move on
 				*p1 = 0;
-				hnd->nlines++;
+				doc->nlines++;
 				linebreak = true;
 			}
 			else
@@ -516,12 +584,12 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 				// back up from current position to last space character and
 				// replace with a 0 (but don't go past previous 0)
 				p2 = p1;
-				while(p1 > hnd->buffer+hnd->start_char && *p1 != 0)
+				while(p1 > doc->buffer+doc->start_char && *p1 != 0)
 				{
 					if(*p1 == 32)
 					{
 						*p1 = 0;
-						hnd->nlines++;
+						doc->nlines++;
 						linebreak = true;
 					}
 					else
@@ -531,25 +599,25 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 					// Must be an ugly Mad Dog test trying my patience - say
 					// a 40-character line with no spaces. Back up one space,
 					// add a hyphen then a 0.
-					hnd->size += 2;
-					if(hnd->size >= hnd->allocated) {
-						hnd->allocated += 128;
-						temp_buffer = hnd->buffer;
-						hnd->buffer = (byte*)G_Malloc(hnd->allocated);
-						if(!hnd->buffer)
+					doc->size += 2;
+					if(doc->size >= doc->allocated) {
+						doc->allocated += 128;
+						temp_buffer = doc->buffer;
+						doc->buffer = (byte*)G_Malloc(doc->allocated);
+						if(!doc->buffer)
 						{
 							gi.dprintf("Memory allocation failure\n");
-							Text_Close(activator);
-							return;
+							Text_FreeDoc(doc);
+							return NULL;
 						}
-						memset(hnd->buffer,0,hnd->allocated);
-						memcpy(hnd->buffer,temp_buffer,hnd->size);
-						p1 = hnd->buffer + (p2-temp_buffer);
+						memset(doc->buffer,0,doc->allocated);
+						memcpy(doc->buffer,temp_buffer,doc->size);
+						p1 = doc->buffer + (p2-temp_buffer);
 						p2 = p1;
 						G_Free(temp_buffer);
 					}
 					p1 = p2-1;
-					p2 = hnd->buffer + hnd->size;
+					p2 = doc->buffer + doc->size;
 					p3 = p2 - 2;
 					while(p3 >= p1) {
 						*p2 = *p3;
@@ -559,7 +627,7 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 					*p1 = '-';
 					p1++;
 					*p1 = 0;
-					hnd->nlines++;
+					doc->nlines++;
 					linebreak = true;
 				}
 			}
@@ -567,24 +635,24 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 		if(linebreak && alt) {
 			// We broke a line and the line was green text. Insert another
 			// '*' at beginning of next line
-			hnd->size += 1;
-			if(hnd->size > hnd->allocated) {
-				hnd->allocated += 128;
-				temp_buffer = hnd->buffer;
-				hnd->buffer = (byte*)G_Malloc(hnd->allocated);
-				if(!hnd->buffer)
+			doc->size += 1;
+			if(doc->size > doc->allocated) {
+				doc->allocated += 128;
+				temp_buffer = doc->buffer;
+				doc->buffer = (byte*)G_Malloc(doc->allocated);
+				if(!doc->buffer)
 				{
 					gi.dprintf("Memory allocation failure\n");
-					Text_Close(activator);
-					return;
+					Text_FreeDoc(doc);
+					return NULL;
 				}
-				memset(hnd->buffer,0,hnd->allocated);
-				memcpy(hnd->buffer,temp_buffer,hnd->size);
+				memset(doc->buffer,0,doc->allocated);
+				memcpy(doc->buffer,temp_buffer,doc->size);
 				p2 = p1;
-				p1 = hnd->buffer + (p2-temp_buffer);
+				p1 = doc->buffer + (p2-temp_buffer);
 				G_Free(temp_buffer);
 			}
-			p2 = hnd->buffer + hnd->size;
+			p2 = doc->buffer + doc->size;
 			p3 = p2 - 1;
 			while(p3 >= p1) {
 				*p2 = *p3;
@@ -597,24 +665,24 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 		if(linebreak && (centered || right_justified)) {
 			// We broke a line and the line had other than left justification. Insert another
 			// '\c' or '\r' at beginning of next line
-			hnd->size += 2;
-			if(hnd->size > hnd->allocated) {
-				hnd->allocated += 128;
-				temp_buffer = hnd->buffer;
-				hnd->buffer = (byte*)G_Malloc(hnd->allocated);
-				if(!hnd->buffer)
+			doc->size += 2;
+			if(doc->size > doc->allocated) {
+				doc->allocated += 128;
+				temp_buffer = doc->buffer;
+				doc->buffer = (byte*)G_Malloc(doc->allocated);
+				if(!doc->buffer)
 				{
 					gi.dprintf("Memory allocation failure\n");
-					Text_Close(activator);
-					return;
+					Text_FreeDoc(doc);
+					return NULL;
 				}
-				memset(hnd->buffer,0,hnd->allocated);
-				memcpy(hnd->buffer,temp_buffer,hnd->size);
+				memset(doc->buffer,0,doc->allocated);
+				memcpy(doc->buffer,temp_buffer,doc->size);
 				p2 = p1;
-				p1 = hnd->buffer + (p2-temp_buffer);
+				p1 = doc->buffer + (p2-temp_buffer);
 				G_Free(temp_buffer);
 			}
-			p2 = hnd->buffer + hnd->size;
+			p2 = doc->buffer + doc->size;
 			p3 = p2 - 2;
 			while(p3 >= p1) {
 				*p2 = *p3;
@@ -635,12 +703,12 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 			if(*p2=='n') {
 				*p1 = 0;
 				p3 = p2 + 1;
-				while(p3 < hnd->buffer + hnd->size) {
+				while(p3 < doc->buffer + doc->size) {
 					*p2 = *p3;
 					p2++;
 					p3++;
 				}
-				hnd->nlines++;
+				doc->nlines++;
 				linebreak = true;
 				centered = false;
 				right_justified = false;
@@ -648,8 +716,8 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 			}
 		}
 		// If we're at a 0, check to see if subsequent words will fit on this line
-		if((!linebreak) && (*p1 == 0) && (p1 < hnd->buffer+hnd->size-1) &&
-			(line_length < hnd->page_width) )
+		if((!linebreak) && (*p1 == 0) && (p1 < doc->buffer+doc->size-1) &&
+			(line_length < doc->page_width) )
 		{
 			// Don't do this if 2 consecutive 0's are found (end of paragraph)
 			// or if 1st character in next line is '*' or '\'
@@ -659,19 +727,19 @@ void Do_Text_Display(edict_t *activator, int flags, char *message)
 			{
 				p2++;
 				p2++;
-				if(*p2 != 0 && *p2 != '*' && *p2 != '\\' && p2 < hnd->buffer+hnd->size)
+				if(*p2 != 0 && *p2 != '*' && *p2 != '\\' && p2 < doc->buffer+doc->size)
 				{
 					new_line_length = line_length+2;
-					while(p2 < hnd->buffer+hnd->size && *p2 != 32 && *p2 != 0)
+					while(p2 < doc->buffer+doc->size && *p2 != 32 && *p2 != 0)
 					{
 						new_line_length++;
 						p2++;
 					}
-					if(new_line_length <= hnd->page_width)
+					if(new_line_length <= doc->page_width)
 					{
 						*p1 = 32;
 						line_length++; // include the space that was a 0
-						hnd->nlines--;
+						doc->nlines--;
 					}
 				}
 			}
@@ -684,10 +752,10 @@ done_linebreaks:
 
 	// Finally, scan for a \a code (embedded audio). If present remove that line
 	// and play the sound
-	p1 = hnd->buffer+hnd->start_char;
-	while(p1 < hnd->buffer+hnd->size)
+	p1 = doc->buffer+doc->start_char;
+	while(p1 < doc->buffer+doc->size)
 	{
-		if((*p1 == 0) || (p1 == hnd->buffer+hnd->start_char))
+		if((*p1 == 0) || (p1 == doc->buffer+doc->start_char))
 		{
 			if(*p1 == 0)
 				p1++;
@@ -696,31 +764,49 @@ done_linebreaks:
 				p1++;
 				if(*p1 == 'a')
 				{
-					strcpy(sound,(char *)p1+1);
+					Q_strncpyz(doc->sound,(char *)p1+1,sizeof(doc->sound));
 					p1--;
 					p2=p1;
 					while(*p2 != 0)
 						p2++;
 					p2++;
-					memcpy(p1,p2,hnd->size + (hnd->buffer - p2) + 1);
-					hnd->nlines--;
+					memcpy(p1,p2,doc->size + (doc->buffer - p2) + 1);
+					doc->nlines--;
 					// Found one (only one is allowed)
-					gi.sound (activator, CHAN_AUTO, gi.soundindex (sound), 1, ATTN_NORM, 0);
 				}
 			}
 		}
 		p1++;
 	}
 
+	Text_IndexDoc(doc);
+	if(flags & 1)
+	{
+		doc->name = G_CopyString(message);
+		doc->next = text_docs;
+		text_docs = doc;
+	}
+	return doc;
+}
+
+void Do_Text_Display(edict_t *activator, int flags, char *message)
+{
+	textdoc_t	*doc;
+	texthnd_t	*hnd;
+
+	if(!(doc = Text_LoadDoc(flags, message)))
+		return;
+	if(doc->sound[0])
+		gi.sound (activator, CHAN_AUTO, gi.soundindex (doc->sound), 1, ATTN_NORM, 0);
+
+	hnd = (texthnd_t*)G_PoolAlloc(&text_pool);
+	hnd->doc = doc;
 	hnd->curline = 0;
-	hnd->flags = flags;
-	Text_BuildDisplay(hnd);
-	hnd->lines  = text;
 	activator->client->textdisplay = hnd;
 	Text_Open(activator);
-	
 }
 
+
 void Use_Target_Text(edict_t *self, edict_t *other, edict_t *activator)
 {
 	
@@ -26,19 +26,30 @@ enum {
 	TEXT_RIGHT
 };
 
-typedef struct texthnd_s {
-	struct text_s *lines;
-	int		nlines;
-	int		curline;
-	int		size;
+// a text file or message laid out once, see p_text.c
+typedef struct textdoc_s {
+	struct textdoc_s *next;
+	char	*name;			// file the document was read from, NULL for a message
 	int		flags;
+	byte	*buffer;
+	int		size;
 	int		allocated;
+	int		nlines;
 	int		page_length;
 	int		page_width;
-	float	last_update;
 	char	background_image[32];
 	int		start_char;
-	byte	*buffer;
+	char	sound[64];		// \a sound, played on every activation
+	int		*line_start;	// offset of each line in buffer
+	int		numstarts;
+	char	**pages;		// layout of each page, built when first shown
+	int		numpages;
+} textdoc_t;
+
+typedef struct texthnd_s {
+	textdoc_t	*doc;
+	int		curline;
+	float	last_update;
 } texthnd_t;
 
 typedef struct text_s {
@@ -50,4 +61,5 @@ void Text_Close(edict_t *ent);
 void Text_Update(edict_t *ent);
 void Text_Next(edict_t *ent);
 void Text_Prev(edict_t *ent);
+void Text_ResetCache(void);
 
@@ -29,120 +29,231 @@ PLAYER TRAIL
 
 ==============================================================================
 
-This is a circular list containing the a list of points of where
-the player has been recently.  It is used by monsters for pursuit.
+Each client has a circular list of points where the player has been
+recently.  It is used by monsters for pursuit.
 
-.origin		the spot
-.owner		forward link
-.aiment		backward link
+A spot is added whenever the player can no longer see the last one, so
+each spot can see the one before it. The lists are plain TAG_LEVEL
+arrays, not edicts, and WriteLevel/ReadLevel store the spots in use.
 */
 
 
-#define	TRAIL_LENGTH	8
+typedef struct
+{
+	trailspot_t	spots[TRAIL_LENGTH];
+	int			head;		// slot the next spot goes in
+	int			count;		// spots in use
+} playertrail_t;
 
-edict_t		*trail[TRAIL_LENGTH];
-int			trail_head;
-qboolean	trail_active = false;
+static playertrail_t	*trails;	// one per client, NULL in deathmatch
 
 #define NEXT(n)		(((n) + 1) & (TRAIL_LENGTH - 1))
 #define PREV(n)		(((n) - 1) & (TRAIL_LENGTH - 1))
 
 
+/*
+=================
+PlayerTrail_Init
+
+Called from SpawnEntities and ReadLevel, after the TAG_LEVEL memory of
+the previous level is gone
+=================
+*/
 void PlayerTrail_Init (void)
 {
-	int		n;
+	trails = NULL;
 
 	if (deathmatch->value /* FIXME || coop */)
 		return;
 
-	for (n = 0; n < TRAIL_LENGTH; n++)
-	{
-		trail[n] = G_Spawn();
-		trail[n]->classname = "player_trail";
-	}
+	trails = (playertrail_t *)gi.TagMalloc (game.maxclients * sizeof(playertrail_t), TAG_LEVEL);
+	memset (trails, 0, game.maxclients * sizeof(playertrail_t));
+}
 
-	trail_head = 0;
-	trail_active = true;
+static playertrail_t *PlayerTrail_Get (edict_t *ent)
+{
+	int		n;
+
+	if (!trails || !ent)
+		return NULL;
+
+	n = ent - g_edicts - 1;
+	if (n < 0 || n >= game.maxclients)
+		return NULL;
+	return &trails[n];
 }
 
 
-void PlayerTrail_Add (vec3_t spot)
+void PlayerTrail_Add (edict_t *ent, vec3_t spot)
 {
-	vec3_t	temp;
+	playertrail_t	*trail;
+	trailspot_t		*last;
+	vec3_t			temp;
 
-	if (!trail_active)
+	if (!(trail = PlayerTrail_Get (ent)))
 		return;
 
-	VectorCopy (spot, trail[trail_head]->s.origin);
+	VectorCopy (spot, trail->spots[trail->head].origin);
 
-	trail[trail_head]->timestamp = level.time;
+	trail->spots[trail->head].timestamp = level.time;
 
-	VectorSubtract (spot, trail[PREV(trail_head)]->s.origin, temp);
-	trail[trail_head]->s.angles[1] = vectoyaw (temp);
+	last = &trail->spots[PREV(trail->head)];
+	VectorSubtract (spot, last->origin, temp);
+	trail->spots[trail->head].yaw = vectoyaw (temp);
 
-	trail_head = NEXT(trail_head);
+	trail->head = NEXT(trail->head);
+	if (trail->count < TRAIL_LENGTH)
+		trail->count++;
 }
 
 
-void PlayerTrail_New (vec3_t spot)
+void PlayerTrail_New (edict_t *ent, vec3_t spot)
 {
-	if (!trail_active)
+	playertrail_t	*trail;
+
+	if (!(trail = PlayerTrail_Get (ent)))
 		return;
 
-	PlayerTrail_Init ();
-	PlayerTrail_Add (spot);
+	trail->head = trail->count = 0;
+	PlayerTrail_Add (ent, spot);
 }
 
 
-edict_t *PlayerTrail_PickFirst (edict_t *self)
+/*
+=================
+PlayerTrail_Update
+
+Called every frame for each player. Drops a spot where the player was
+last frame if the last spot went out of sight.
+=================
+*/
+void PlayerTrail_Update (edict_t *ent)
 {
-	int		marker;
-	int		n;
+	playertrail_t	*trail;
+	vec3_t			spot;
+	trace_t			tr;
 
-	if (!trail_active)
-		return NULL;
+	if (!(trail = PlayerTrail_Get (ent)))
+		return;
 
-	for (marker = trail_head, n = TRAIL_LENGTH; n; n--)
+	if (trail->count)
 	{
-		if(trail[marker]->timestamp <= self->monsterinfo.trail_time)
-			marker = NEXT(marker);
-		else
-			break;
+		VectorCopy (ent->s.origin, spot);
+		spot[2] += ent->viewheight;
+		tr = gi.trace (spot, vec3_origin, vec3_origin, trail->spots[PREV(trail->head)].origin, ent, MASK_OPAQUE);
+		if (tr.fraction == 1.0)
+			return;
 	}
 
-	if (visible(self, trail[marker]))
-	{
-		return trail[marker];
-	}
+	PlayerTrail_Add (ent, ent->s.old_origin);
+}
 
-	if (visible(self, trail[PREV(marker)]))
-	{
-		return trail[PREV(marker)];
-	}
 
-	return trail[marker];
-}
+/*
+=================
+PlayerTrail_Pick
 
-edict_t *PlayerTrail_PickNext (edict_t *self)
+Returns the oldest spot on the trail of self's enemy that is newer than
+self->monsterinfo.trail_time, going back from the newest one. NULL if
+self is already caught up or is not after a player.
+=================
+*/
+static trailspot_t *PlayerTrail_Pick (edict_t *self, trailspot_t **prev)
 {
-	int		marker;
-	int		n;
+	playertrail_t	*trail;
+	int				marker;
+	int				n;
 
-	if (!trail_active)
+	*prev = NULL;
+	if (!(trail = PlayerTrail_Get (self->enemy)))
 		return NULL;
 
-	for (marker = trail_head, n = TRAIL_LENGTH; n; n--)
+	for (marker = PREV(trail->head), n = 0; n < trail->count; n++, marker = PREV(marker))
 	{
-		if(trail[marker]->timestamp <= self->monsterinfo.trail_time)
-			marker = NEXT(marker);
-		else
+		if (trail->spots[marker].timestamp <= self->monsterinfo.trail_time)
 			break;
 	}
+	if (!n)
+		return NULL;	// nothing newer
+
+	if (n < trail->count)
+		*prev = &trail->spots[marker];
+	return &trail->spots[NEXT(marker)];
+}
+
+
+/*
+=================
+PlayerTrail_PickFirst
+
+Used when a monster has just lost sight of the player. If the monster
+can't see the first spot, it heads for the one before that instead,
+which can see it, rather than tracing again.
+=================
+*/
+trailspot_t *PlayerTrail_PickFirst (edict_t *self)
+{
+	trailspot_t	*marker, *prev;
+	vec3_t		spot;
+	trace_t		tr;
+
+	if (!(marker = PlayerTrail_Pick (self, &prev)))
+		return NULL;
+
+	VectorCopy (self->s.origin, spot);
+	spot[2] += self->viewheight;
+	tr = gi.trace (spot, vec3_origin, vec3_origin, marker->origin, self, MASK_OPAQUE);
+	if (tr.fraction == 1.0 || !prev)
+		return marker;
+
+	return prev;
+}
+
+trailspot_t *PlayerTrail_PickNext (edict_t *self)
+{
+	trailspot_t	*prev;
 
-	return trail[marker];
+	return PlayerTrail_Pick (self, &prev);
 }
 
-edict_t *PlayerTrail_LastSpot (void)
+
+/*
+=================
+PlayerTrail_Save
+
+Copies the spots of client n into spots, oldest first, and returns how
+many there are
+=================
+*/
+int PlayerTrail_Save (int n, trailspot_t *spots)
 {
-	return trail[PREV(trail_head)];
+	playertrail_t	*trail;
+	int				i, marker;
+
+	if (!trails || n < 0 || n >= game.maxclients)
+		return 0;
+
+	trail = &trails[n];
+	marker = (trail->head - trail->count) & (TRAIL_LENGTH - 1);
+	for (i = 0; i < trail->count; i++, marker = NEXT(marker))
+		spots[i] = trail->spots[marker];
+	return trail->count;
+}
+
+void PlayerTrail_Restore (int n, trailspot_t *spots, int count)
+{
+	playertrail_t	*trail;
+
+	if (!trails || n < 0 || n >= game.maxclients)
+		return;
+
+	trail = &trails[n];
+	if (count > TRAIL_LENGTH)
+	{
+		spots += count - TRAIL_LENGTH;
+		count = TRAIL_LENGTH;
+	}
+	memcpy (trail->spots, spots, count * sizeof(trailspot_t));
+	trail->count = count;
+	trail->head = count & (TRAIL_LENGTH - 1);
 }
@@ -448,7 +448,7 @@ void SV_CalcBlend (edict_t *ent)
 	else
 		VectorAdd (ent->s.origin, ent->client->ps.viewoffset, vieworg);
 
-	contents = gi.pointcontents (vieworg);
+	contents = G_EnvContents (vieworg);
 	if (contents & (CONTENTS_LAVA|CONTENTS_SLIME|CONTENTS_WATER) )
 		ent->client->ps.rdflags |= RDF_UNDERWATER;
 	else
@@ -614,7 +614,7 @@ void P_SlamDamage (edict_t *ent)
 		return;
 //ZOID
 
-	if (delta > 40*(player_max_speed->value/300)) // Knightmare changed
+	if (delta > 40*(km_values.player_max_speed/300)) // Knightmare changed
 	{
 		if (ent->health > 0)
 		{
@@ -623,13 +623,13 @@ void P_SlamDamage (edict_t *ent)
 			else
 				ent->s.event = EV_FALL;*/
 			//play correct PPM sounds while in third person mode
-			if (delta >= 65*(player_max_speed->value/300)) // Knightmare changed
+			if (delta >= 65*(km_values.player_max_speed/300)) // Knightmare changed
 				gi.sound(ent,CHAN_VOICE,gi.soundindex("*fall1.wav"),1.0,ATTN_NORM,0);
 			else
 				gi.sound(ent,CHAN_VOICE,gi.soundindex("*fall2.wav"),1.0,ATTN_NORM,0);
 		}
 		ent->pain_debounce_time = level.time;	// no normal pain sound
-		damage = (delta-40*(player_max_speed->value/300))/2; // Knightmare changed
+		damage = (delta-40*(km_values.player_max_speed/300))/2; // Knightmare changed
 		if (damage < 1)
 			damage = 1;
 		VectorCopy(deltav,dir);
@@ -851,7 +851,7 @@ void P_WorldEffects (void)
 				T_Damage (current_player, world, world, vec3_origin, current_player->s.origin, vec3_origin, current_player->health+1, 0, DAMAGE_NO_ARMOR, 0);
 			else
 			{
-				gitem_t	*jetpack = FindItem("jetpack");
+				gitem_t	*jetpack = &itemlist[jetpack_index];
 				Use_Jet (current_player, jetpack);			// shut down in water
 			}
 		}
@@ -1006,10 +1006,10 @@ void G_SetClientEffects (edict_t *ent)
 
 		if(level.flashlight_cost > 0) {
 			if(!Q_strcasecmp(FLASHLIGHT_ITEM,"health") || 
-					(ent->client->pers.inventory[ITEM_INDEX(FindItem(FLASHLIGHT_ITEM))]>=level.flashlight_cost) ) {
+					(ent->client->pers.inventory[flashlight_index]>=level.flashlight_cost) ) {
 				// Player has items remaining
 				if(ent->client->flashlight_time <= level.time) {
-					ent->client->pers.inventory[ITEM_INDEX(FindItem(FLASHLIGHT_ITEM))]-=level.flashlight_cost;
+					ent->client->pers.inventory[flashlight_index]-=level.flashlight_cost;
 					ent->client->flashlight_time = level.time + FLASHLIGHT_DRAIN;
 				}
 			} else {
@@ -1454,16 +1454,18 @@ void ClientEndServerFrame (edict_t *ent)
 		{
 			if (ent->client->menu)
 			{
-			//	PMenu_Update(ent);
-				PMenu_Do_Update(ent);
-				ent->client->menudirty = false;
-				ent->client->menutime = level.time;
+				// only resend it if it changed
+				if (PMenu_Do_Update(ent))
+					gi.unicast (ent, false);
 			}
-			else if (ent->client->textdisplay)
-				Text_Update(ent);
 			else
-				DeathmatchScoreboardMessage (ent, ent->enemy);
-			gi.unicast (ent, false);
+			{
+				if (ent->client->textdisplay)
+					Text_Update(ent);
+				else
+					DeathmatchScoreboardMessage (ent, ent->enemy);
+				gi.unicast (ent, false);
+			}
 		}
 		else if(ent->client->whatsit)
 			WhatsIt(ent);
@@ -156,7 +156,7 @@ qboolean Pickup_Weapon (edict_t *ent, edict_t *other)
 		// Lazarus: blaster doesn't use ammo
 		if (ent->item->ammo)
 		{
-			ammo = FindItem (ent->item->ammo);
+			ammo = GetItemByIndex (ItemAmmoIndex(ent->item));
 			if ( (int)dmflags->value & DF_INFINITE_AMMO )
 				Add_Ammo (other, ammo, 1000);
 			else
@@ -179,8 +179,8 @@ qboolean Pickup_Weapon (edict_t *ent, edict_t *other)
 
 	if (other->client->pers.weapon != ent->item && 
 		(other->client->pers.inventory[index] == 1) &&
-		( !deathmatch->value || other->client->pers.weapon == FindItem("blaster") ||
-		other->client->pers.weapon == FindItem("No weapon") ) )
+		( !deathmatch->value || other->client->pers.weapon == &itemlist[blaster_index] ||
+		other->client->pers.weapon == &itemlist[noweapon_index] ) )
 		other->client->newweapon = ent->item;
 
 	// If rocket launcher, give the HML (but no ammo).
@@ -226,7 +226,7 @@ void ChangeWeapon (edict_t *ent)
 	}
 
 	if (ent->client->pers.weapon && ent->client->pers.weapon->ammo)
-		ent->client->ammo_index = ITEM_INDEX(FindItem(ent->client->pers.weapon->ammo));
+		ent->client->ammo_index = ItemAmmoIndex(ent->client->pers.weapon);
 	else
 		ent->client->ammo_index = 0;
 
@@ -271,47 +271,47 @@ NoAmmoWeaponChange
 void NoAmmoWeaponChange (edict_t *ent)
 {
 	if ( ent->client->pers.inventory[slugs_index]
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("railgun"))] )
+		&&  ent->client->pers.inventory[railgun_index] )
 	{
-		ent->client->newweapon = FindItem ("railgun");
+		ent->client->newweapon = &itemlist[railgun_index];
 		return;
 	}
 	if ( ent->client->pers.inventory[cells_index]
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("hyperblaster"))] )
+		&&  ent->client->pers.inventory[hyperblaster_index] )
 	{
-		ent->client->newweapon = FindItem ("hyperblaster");
+		ent->client->newweapon = &itemlist[hyperblaster_index];
 		return;
 	}
 	if ( ent->client->pers.inventory[bullets_index]
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("chaingun"))] )
+		&&  ent->client->pers.inventory[chaingun_index] )
 	{
-		ent->client->newweapon = FindItem ("chaingun");
+		ent->client->newweapon = &itemlist[chaingun_index];
 		return;
 	}
 	if ( ent->client->pers.inventory[bullets_index]
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("machinegun"))] )
+		&&  ent->client->pers.inventory[machinegun_index] )
 	{
-		ent->client->newweapon = FindItem ("machinegun");
+		ent->client->newweapon = &itemlist[machinegun_index];
 		return;
 	}
 	if ( ent->client->pers.inventory[shells_index] > 1
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("super shotgun"))] )
+		&&  ent->client->pers.inventory[sshotgun_index] )
 	{
-		ent->client->newweapon = FindItem ("super shotgun");
+		ent->client->newweapon = &itemlist[sshotgun_index];
 		return;
 	}
 	if ( ent->client->pers.inventory[shells_index]
-		&&  ent->client->pers.inventory[ITEM_INDEX(FindItem("shotgun"))] )
+		&&  ent->client->pers.inventory[shotgun_index] )
 	{
-		ent->client->newweapon = FindItem ("shotgun");
+		ent->client->newweapon = &itemlist[shotgun_index];
 		return;
 	}
 	// DWH: Dude may not HAVE a blaster
 	//ent->client->newweapon = FindItem ("blaster");
-	if ( ent->client->pers.inventory[ITEM_INDEX(FindItem("blaster"))] )
-		ent->client->newweapon = FindItem ("blaster");
+	if ( ent->client->pers.inventory[blaster_index] )
+		ent->client->newweapon = &itemlist[blaster_index];
 	else
-		ent->client->newweapon = FindItem ("No Weapon");
+		ent->client->newweapon = &itemlist[noweapon_index];
 }
 
 /*
@@ -385,7 +385,7 @@ void Use_Weapon (edict_t *ent, gitem_t *in_item)
 		{
 			if(ent->client->pers.inventory[homing_index] > 0)
 			{
-				item = FindItem("homing missile launcher");
+				item = &itemlist[hml_index];
 				index = hml_index;
 			}
 			else
@@ -395,7 +395,7 @@ void Use_Weapon (edict_t *ent, gitem_t *in_item)
 		{
 			if(ent->client->pers.inventory[rockets_index] > 0)
 			{
-				item = FindItem("rocket launcher");
+				item = &itemlist[rl_index];
 				index = rl_index;
 			}
 			else
@@ -407,8 +407,8 @@ void Use_Weapon (edict_t *ent, gitem_t *in_item)
 
 	if (item->ammo && !g_select_empty->value && !(item->flags & IT_AMMO))
 	{
-		ammo_item = FindItem(item->ammo);
-		ammo_index = ITEM_INDEX(ammo_item);
+		ammo_index = ItemAmmoIndex(item);
+		ammo_item = &itemlist[ammo_index];
 
 		if (!ent->client->pers.inventory[ammo_index])
 		{
@@ -419,7 +419,7 @@ void Use_Weapon (edict_t *ent, gitem_t *in_item)
 				if( (ent->client->pers.inventory[homing_index] > 0) &&
 					(ent->client->pers.inventory[hml_index]    > 0)    )
 				{
-					ent->client->newweapon = FindItem("homing missile launcher");
+					ent->client->newweapon = &itemlist[hml_index];
 					return;
 				}
 			}
@@ -481,6 +481,81 @@ void Drop_Weapon (edict_t *ent, gitem_t *item)
 }
 
 
+/*
+================
+WEAPON FRAME TABLE
+
+Every weapon's think hands Weapon_Generic a list of fire frames and one
+of pause frames, which used to be scanned for the current gunframe
+every frame, for every client, twice when hasted. The first time a
+weapon runs, its lists are turned into bitmasks kept per item, so
+telling what a gunframe is takes one lookup. A descriptor remembers
+which lists it was built from, so a weapon handing in different ones
+just gets rebuilt.
+================
+*/
+#define	WEAPON_MAX_FRAMES	256		// gunframe goes out as a byte
+#define	WEAPON_FRAME_WORDS	(WEAPON_MAX_FRAMES/32)
+
+typedef struct
+{
+	int			*pause_frames;		// what the masks were built from
+	int			*fire_frames;
+	unsigned	pause[WEAPON_FRAME_WORDS];
+	unsigned	fire[WEAPON_FRAME_WORDS];
+} weaponframes_t;
+
+static weaponframes_t	*weapon_frames;		// per item
+
+/*
+================
+Weapon_InitFrames
+
+Called by InitItems. The table from the last game went with its
+TAG_GAME memory.
+================
+*/
+void Weapon_InitFrames (void)
+{
+	weapon_frames = gi.TagMalloc (game.num_items * sizeof(weaponframes_t), TAG_GAME);
+}
+
+static void Weapon_MaskFrames (unsigned *mask, int *frames)
+{
+	int		n;
+
+	if (!frames)
+		return;
+	for (n = 0; frames[n]; n++)
+	{
+		if (frames[n] > 0 && frames[n] < WEAPON_MAX_FRAMES)
+			mask[frames[n] >> 5] |= 1u << (frames[n] & 31);
+	}
+}
+
+static weaponframes_t *Weapon_Frames (edict_t *ent, int *pause_frames, int *fire_frames)
+{
+	weaponframes_t	*wf;
+
+	wf = weapon_frames + ITEM_INDEX(ent->client->pers.weapon);
+	if (wf->pause_frames == pause_frames && wf->fire_frames == fire_frames)
+		return wf;
+
+	memset (wf, 0, sizeof(*wf));
+	wf->pause_frames = pause_frames;
+	wf->fire_frames = fire_frames;
+	Weapon_MaskFrames (wf->pause, pause_frames);
+	Weapon_MaskFrames (wf->fire, fire_frames);
+	return wf;
+}
+
+static qboolean Weapon_FrameIn (unsigned *mask, int frame)
+{
+	if (frame < 0 || frame >= WEAPON_MAX_FRAMES)
+		return false;
+	return (mask[frame >> 5] & (1u << (frame & 31))) != 0;
+}
+
 /*
 ================
 Weapon_Generic
@@ -494,7 +569,7 @@ A generic function to handle the basics of weapon thinking
 
 void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST, int FRAME_IDLE_LAST, int FRAME_DEACTIVATE_LAST, int *pause_frames, int *fire_frames, void (*fire)(edict_t *ent, qboolean altfire))
 {
-	int		n;
+	weaponframes_t	*wf;
 //	int oldstate = ent->client->weaponstate;
 //	qboolean haste_applied = false;
 
@@ -503,6 +578,8 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 		return;
 	}
 
+	wf = Weapon_Frames (ent, pause_frames, fire_frames);
+
 	if (ent->client->weaponstate == WEAPON_DROPPING)
 	{
 		if (ent->client->ps.gunframe == FRAME_DEACTIVATE_LAST)
@@ -589,7 +666,7 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 			if (current_weapon_index == rl_index) // homing rocket switch
 			{
 				if (ent->client->pers.inventory[homing_index] > 0)
-					Use_Weapon (ent, FindItem("homing missile launcher"));
+					Use_Weapon (ent, &itemlist[hml_index]);
 				ent->client->latched_buttons &= ~BUTTONS_ATTACK;
 				ent->client->buttons &= ~BUTTONS_ATTACK;
 				return;
@@ -597,7 +674,7 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 			else if (current_weapon_index == hml_index)
 			{
 				if (ent->client->pers.inventory[rockets_index] > 0)
-					Use_Weapon (ent, FindItem("rocket launcher"));
+					Use_Weapon (ent, &itemlist[rl_index]);
 				ent->client->latched_buttons &= ~BUTTONS_ATTACK;
 				ent->client->buttons &= ~BUTTONS_ATTACK;
 				return;
@@ -644,16 +721,10 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 				return;
 			}
 
-			if (pause_frames)
+			if (Weapon_FrameIn (wf->pause, ent->client->ps.gunframe))
 			{
-				for (n = 0; pause_frames[n]; n++)
-				{
-					if (ent->client->ps.gunframe == pause_frames[n])
-					{
-						if (rand()&15)
-							return;
-					}
-				}
+				if (rand()&15)
+					return;
 			}
 
 			ent->client->ps.gunframe++;
@@ -663,25 +734,20 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 
 	if (ent->client->weaponstate == WEAPON_FIRING)
 	{
-		for (n = 0; fire_frames[n]; n++)
+		if (Weapon_FrameIn (wf->fire, ent->client->ps.gunframe))
 		{
-			if (ent->client->ps.gunframe == fire_frames[n])
-			{
 //ZOID
-				if (!CTFApplyStrengthSound(ent))
+			if (!CTFApplyStrengthSound(ent))
 //ZOID
-				if (ent->client->quad_framenum > level.framenum)
-					gi.sound(ent, CHAN_ITEM, gi.soundindex("items/damage3.wav"), 1, ATTN_NORM, 0);
+			if (ent->client->quad_framenum > level.framenum)
+				gi.sound(ent, CHAN_ITEM, gi.soundindex("items/damage3.wav"), 1, ATTN_NORM, 0);
 
 //ZOID
-				CTFApplyHasteSound(ent);
+			CTFApplyHasteSound(ent);
 //ZOID
-				fire (ent, ((ent->client->latched_buttons|ent->client->buttons) & BUTTON_ATTACK2) );
-				break;
-			}
+			fire (ent, ((ent->client->latched_buttons|ent->client->buttons) & BUTTON_ATTACK2) );
 		}
-
-		if (!fire_frames[n])
+		else
 			ent->client->ps.gunframe++;
 
 		if (ent->client->ps.gunframe == FRAME_IDLE_FIRST+1)
@@ -694,19 +760,19 @@ void Weapon_Generic2 (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST
 void Weapon_Generic (edict_t *ent, int FRAME_ACTIVATE_LAST, int FRAME_FIRE_LAST, int FRAME_IDLE_LAST, int FRAME_DEACTIVATE_LAST, int *pause_frames, int *fire_frames, void (*fire)(edict_t *ent, qboolean altfire))
 {
 	int oldstate = ent->client->weaponstate;
+	qboolean grapple;
 
 	Weapon_Generic2 (ent, FRAME_ACTIVATE_LAST, FRAME_FIRE_LAST, 
 		FRAME_IDLE_LAST, FRAME_DEACTIVATE_LAST, pause_frames, 
 		fire_frames, fire);
 
 	// run the weapon frame again if hasted
-	if (Q_strcasecmp(ent->client->pers.weapon->pickup_name, "Grapple") == 0 &&
-		ent->client->weaponstate == WEAPON_FIRING)
+	grapple = (grapple_index && ent->client->pers.weapon == &itemlist[grapple_index]);
+	if (grapple && ent->client->weaponstate == WEAPON_FIRING)
 		return;
 
 	if ((CTFApplyHaste(ent) ||
-		(Q_strcasecmp(ent->client->pers.weapon->pickup_name, "Grapple") == 0 &&
-		ent->client->weaponstate != WEAPON_FIRING))
+		(grapple && ent->client->weaponstate != WEAPON_FIRING))
 		&& oldstate == ent->client->weaponstate)
 	{
 		Weapon_Generic2 (ent, FRAME_ACTIVATE_LAST, FRAME_FIRE_LAST, 
@@ -732,12 +798,12 @@ void weapon_grenade_fire (edict_t *ent, qboolean held)
 	vec3_t	offset;
 	vec3_t	forward, right;
 	vec3_t	start;
-	int		damage = hand_grenade_damage->value;
+	int		damage = km_values.hand_grenade_damage;
 	float	timer;
 	int		speed;
 	float	radius;
 
-	radius = hand_grenade_radius->value; //was damage + 40
+	radius = km_values.hand_grenade_radius; //was damage + 40
 	radius = damage+40;
 	if (is_quad)
 		damage *= 4;
@@ -896,10 +962,10 @@ void weapon_grenadelauncher_fire (edict_t *ent, qboolean altfire)
 	vec3_t	offset;
 	vec3_t	forward, right;
 	vec3_t	start;
-	int		damage = grenade_damage->value;
+	int		damage = km_values.grenade_damage;
 	float	radius;
 
-	radius = grenade_radius->value; // damage+40;
+	radius = km_values.grenade_radius; // damage+40;
 	if (is_quad)
 		damage *= 4;
 
@@ -910,7 +976,7 @@ void weapon_grenadelauncher_fire (edict_t *ent, qboolean altfire)
 	VectorScale (forward, -2, ent->client->kick_origin);
 	ent->client->kick_angles[0] = -1;
 
-	fire_grenade (ent, start, forward, damage, grenade_speed->value, 2.5, radius, altfire);
+	fire_grenade (ent, start, forward, damage, km_values.grenade_speed, 2.5, radius, altfire);
 	// temporary crap to test grenade bounce
 //	fire_grenade (ent, start, forward, damage, grenade_speed->value, 25, radius);
 
@@ -942,13 +1008,49 @@ ROCKET
 
 ======================================================================
 */
+/*
+=================
+rocket_target
+
+Picks what a homing rocket goes after: whatever is straight ahead if it
+takes damage, else the visible damageable entity nearest the line of
+fire, if it is within about 25 degrees (a dot of 0.9).
+
+Only entities whose middle can be in that cone are looked at. They come
+from the area tree inside the bounds of the cone out to the edge of the
+world, are sorted by how far off the line of fire they are, and are
+traced in that order until one is in sight.
+=================
+*/
+#define	ROCKET_TARGET_DOT	0.90
+#define	ROCKET_TARGET_WORLD	4096	// as far as positions can be sent
+
+typedef struct
+{
+	edict_t		*ent;
+	float		dot;
+} rocketcand_t;
+
+static int rocket_target_order (const void *a, const void *b)
+{
+	const rocketcand_t	*ca = (const rocketcand_t *)a;
+	const rocketcand_t	*cb = (const rocketcand_t *)b;
+
+	if (ca->dot != cb->dot)
+		return (ca->dot < cb->dot) ? 1 : -1;
+	return (int)(ca->ent - cb->ent);		// ties go to the lower edict
+}
+
 edict_t	*rocket_target(edict_t *self, vec3_t start, vec3_t forward)
 {
-	float       bd, d;
-	int			i;
-	edict_t	    *who, *best;
+	float       d, length, radius;
+	int			i, j, num, count;
+	edict_t	    *who;
+	edict_t		*list[MAX_EDICTS];
+	rocketcand_t	cands[MAX_EDICTS];
 	trace_t     tr;
 	vec3_t      dir, end;
+	vec3_t		mins, maxs;
 
 	VectorMA(start, 8192, forward, end);
 
@@ -957,10 +1059,29 @@ edict_t	*rocket_target(edict_t *self, vec3_t start, vec3_t forward)
 	if ((tr.ent->takedamage != DAMAGE_NO) && (tr.ent->solid != SOLID_NOT))
 		return tr.ent;
 
+	/* Bounds of the cone from self out to the farthest corner of the world */
+	length = 0;
+	for (j=0 ; j<3 ; j++)
+	{
+		d = ROCKET_TARGET_WORLD + fabs(self->s.origin[j]);
+		length += d * d;
+	}
+	length = sqrt(length);
+	radius = length * sqrt(1.0 - ROCKET_TARGET_DOT*ROCKET_TARGET_DOT) / ROCKET_TARGET_DOT;
+	for (j=0 ; j<3 ; j++)
+	{
+		d = self->s.origin[j] + length * forward[j];
+		end[j] = radius * sqrt(max(0, 1.0 - forward[j]*forward[j]));
+		mins[j] = max(min(self->s.origin[j], d - end[j]), -ROCKET_TARGET_WORLD);
+		maxs[j] = min(max(self->s.origin[j], d + end[j]), ROCKET_TARGET_WORLD);
+	}
+	num  = gi.BoxEdicts (mins, maxs, list, MAX_EDICTS, AREA_SOLID);
+	num += gi.BoxEdicts (mins, maxs, list + num, MAX_EDICTS - num, AREA_TRIGGERS);
+
 	/* Check for damageable entity within a tolerance of view angle */
-	bd = 0;
-	best = NULL;
-	for (i=1, who=g_edicts+1; i<globals.num_edicts; i++, who++)	{
+	count = 0;
+	for (i=0 ; i<num ; i++)	{
+		who = list[i];
 		if (!who->inuse)
 			continue;
 		if (who == self)
@@ -970,19 +1091,25 @@ edict_t	*rocket_target(edict_t *self, vec3_t start, vec3_t forward)
 		if (who->solid == SOLID_NOT)
 			continue;
 		VectorMA(who->absmin,0.5,who->size,end);
-		tr = gi.trace (start, vec3_origin, vec3_origin, end, self, MASK_OPAQUE);
-		if(tr.fraction < 1.0)
-			continue;
 		VectorSubtract(end, self->s.origin, dir);
 		VectorNormalize(dir);
 		d = DotProduct(forward, dir);
-		if (d > bd) {
-			bd = d;
-			best = who;
-		}
+		if (d <= ROCKET_TARGET_DOT)
+			continue;
+		cands[count].ent = who;
+		cands[count].dot = d;
+		count++;
+	}
+	if (count > 1)
+		qsort (cands, count, sizeof(cands[0]), rocket_target_order);
+
+	for (i=0 ; i<count ; i++) {
+		who = cands[i].ent;
+		VectorMA(who->absmin,0.5,who->size,end);
+		tr = gi.trace (start, vec3_origin, vec3_origin, end, self, MASK_OPAQUE);
+		if(tr.fraction == 1.0)
+			return who;
 	}
-	if (bd > 0.90)
-		return best;
 
 	return NULL;
 }
@@ -995,9 +1122,9 @@ void Weapon_RocketLauncher_Fire (edict_t *ent, qboolean altfire)
 	float	damage_radius;
 	int		radius_damage;
 
-	damage = rocket_damage->value + (int)(random() * rocket_damage2->value);
-	radius_damage = rocket_rdamage->value;
-	damage_radius = rocket_radius->value;
+	damage = km_values.rocket_damage + (int)(random() * km_values.rocket_damage2);
+	radius_damage = km_values.rocket_rdamage;
+	damage_radius = km_values.rocket_radius;
 	if (is_quad)
 	{
 		damage *= 4;
@@ -1023,10 +1150,10 @@ void Weapon_RocketLauncher_Fire (edict_t *ent, qboolean altfire)
 		}
 		
 		target = rocket_target(ent, start, forward);
-		fire_rocket (ent, start, forward, damage, rocket_speed->value, damage_radius, radius_damage, target);
+		fire_rocket (ent, start, forward, damage, km_values.rocket_speed, damage_radius, radius_damage, target);
 	}
 	else
-		fire_rocket (ent, start, forward, damage, rocket_speed->value, damage_radius, radius_damage, NULL);
+		fire_rocket (ent, start, forward, damage, km_values.rocket_speed, damage_radius, radius_damage, NULL);
 
 	// send muzzle flash
 	gi.WriteByte (svc_muzzleflash);
@@ -1090,9 +1217,9 @@ void Blaster_Fire (edict_t *ent, vec3_t g_offset, int damage, qboolean hyper, in
 	ent->client->kick_angles[0] = -1;
 
 	if (!hyper)
-		fire_blaster (ent, start, forward, damage, blaster_speed->value, effect, hyper, color);
+		fire_blaster (ent, start, forward, damage, km_values.blaster_speed, effect, hyper, color);
 	else
-		fire_blaster (ent, start, forward, damage, hyperblaster_speed->value, effect, hyper, color);
+		fire_blaster (ent, start, forward, damage, km_values.hyperblaster_speed, effect, hyper, color);
 
 	// Knightmare- select muzzle flash
 	if (hyper)
@@ -1159,14 +1286,14 @@ void Weapon_Blaster_Fire (edict_t *ent, qboolean altfire)
 	int		color;
 
 	if (deathmatch->value)
-		damage = blaster_damage_dm->value;
+		damage = km_values.blaster_damage_dm;
 	else
-		damage = blaster_damage->value;
+		damage = km_values.blaster_damage;
 
 	// select color
-	color = blaster_color->value;
+	color = km_values.blaster_color;
 	// blaster_color could be any other value, so clamp it
-	if (blaster_color->value < 2 || blaster_color->value > 5)
+	if (km_values.blaster_color < 2 || km_values.blaster_color > 5)
 		color = BLASTER_ORANGE; 
 	if (color == BLASTER_RANDOM)
 		color = rand()%4 + 1;
@@ -1236,9 +1363,9 @@ void Weapon_HyperBlaster_Fire (edict_t *ent, qboolean altfire)
 			offset[2] = 4 * cos(rotation);
 
 			// Knightmare- select color
-			color = hyperblaster_color->value;
+			color = km_values.hyperblaster_color;
 			// hyperblaster_color could be any other value, so clamp this
-			if (hyperblaster_color->value < 2 || hyperblaster_color->value > 5)
+			if (km_values.hyperblaster_color < 2 || km_values.hyperblaster_color > 5)
 				color = BLASTER_ORANGE;
 			if (color == BLASTER_RANDOM)
 				color = rand()%4 + 1;
@@ -1264,9 +1391,9 @@ void Weapon_HyperBlaster_Fire (edict_t *ent, qboolean altfire)
 
 
 			if (deathmatch->value)
-				damage = hyperblaster_damage_dm->value;
+				damage = km_values.hyperblaster_damage_dm;
 			else
-				damage = hyperblaster_damage->value;
+				damage = km_values.hyperblaster_damage;
 			Blaster_Fire (ent, offset, damage, true, effect, color);
 			if (! ( (int)dmflags->value & DF_INFINITE_AMMO ) )
 				ent->client->pers.inventory[ent->client->ammo_index]--;
@@ -1319,7 +1446,7 @@ void Machinegun_Fire (edict_t *ent, qboolean altfire)
 	vec3_t		start;
 	vec3_t		forward, right;
 	vec3_t		angles;
-	int			damage = machinegun_damage->value;
+	int			damage = km_values.machinegun_damage;
 	int			kick = 2;
 	vec3_t		offset;
 
@@ -1374,7 +1501,7 @@ void Machinegun_Fire (edict_t *ent, qboolean altfire)
 	AngleVectors (angles, forward, right, NULL);
 	VectorSet(offset, 0, 8, ent->viewheight-8);
 	P_ProjectSource (ent->client, ent->s.origin, offset, forward, right, start);
-	fire_bullet (ent, start, forward, damage, kick, machinegun_hspread->value, machinegun_vspread->value, MOD_MACHINEGUN);
+	fire_bullet (ent, start, forward, damage, kick, km_values.machinegun_hspread, km_values.machinegun_vspread, MOD_MACHINEGUN);
 
 	gi.WriteByte (svc_muzzleflash);
 	gi.WriteShort (ent-g_edicts);
@@ -1419,9 +1546,9 @@ void Chaingun_Fire (edict_t *ent, qboolean altfire)
 	int			kick = 2;
 
 	if (deathmatch->value)
-		damage = chaingun_damage_dm->value;
+		damage = km_values.chaingun_damage_dm;
 	else
-		damage = chaingun_damage->value;
+		damage = km_values.chaingun_damage;
 
 	if (ent->client->ps.gunframe == 5)
 		gi.sound(ent, CHAN_AUTO, gi.soundindex("weapons/chngnu1a.wav"), 1, ATTN_IDLE, 0);
@@ -1502,6 +1629,8 @@ void Chaingun_Fire (edict_t *ent, qboolean altfire)
 		ent->client->kick_angles[i] = crandom() * 0.7;
 	}
 
+	// the shots of a frame are one hit on each target they find
+	T_DamageBatchBegin ();
 	for (i=0 ; i<shots ; i++)
 	{
 		// get start / end positions
@@ -1511,8 +1640,9 @@ void Chaingun_Fire (edict_t *ent, qboolean altfire)
 		VectorSet(offset, 0, r, u + ent->viewheight-8);
 		P_ProjectSource (ent->client, ent->s.origin, offset, forward, right, start);
 
-		fire_bullet (ent, start, forward, damage, kick, chaingun_hspread->value, chaingun_vspread->value, MOD_CHAINGUN);
+		fire_bullet (ent, start, forward, damage, kick, km_values.chaingun_hspread, km_values.chaingun_vspread, MOD_CHAINGUN);
 	}
+	T_DamageBatchEnd ();
 
 	// send muzzle flash
 	gi.WriteByte (svc_muzzleflash);
@@ -1549,7 +1679,7 @@ void weapon_shotgun_fire (edict_t *ent, qboolean altfire)
 	vec3_t		start;
 	vec3_t		forward, right;
 	vec3_t		offset;
-	int			damage = shotgun_damage->value;
+	int			damage = km_values.shotgun_damage;
 	int			kick = 8;
 
 	if (ent->client->ps.gunframe == 9)
@@ -1573,9 +1703,9 @@ void weapon_shotgun_fire (edict_t *ent, qboolean altfire)
 	}
 
 	if (deathmatch->value)
-		fire_shotgun (ent, start, forward, damage, kick, shotgun_hspread->value, shotgun_vspread->value, shotgun_count->value, MOD_SHOTGUN);
+		fire_shotgun (ent, start, forward, damage, kick, km_values.shotgun_hspread, km_values.shotgun_vspread, km_values.shotgun_count, MOD_SHOTGUN);
 	else
-		fire_shotgun (ent, start, forward, damage, kick, shotgun_hspread->value, shotgun_vspread->value, shotgun_count->value, MOD_SHOTGUN);
+		fire_shotgun (ent, start, forward, damage, kick, km_values.shotgun_hspread, km_values.shotgun_vspread, km_values.shotgun_count, MOD_SHOTGUN);
 
 	// send muzzle flash
 	gi.WriteByte (svc_muzzleflash);
@@ -1605,7 +1735,7 @@ void weapon_supershotgun_fire (edict_t *ent, qboolean altfire)
 	vec3_t		forward, right;
 	vec3_t		offset;
 	vec3_t		v;
-	int			damage = sshotgun_damage->value;
+	int			damage = km_values.sshotgun_damage;
 	int			kick = 12;
 
 	AngleVectors (ent->client->v_angle, forward, right, NULL);
@@ -1626,10 +1756,10 @@ void weapon_supershotgun_fire (edict_t *ent, qboolean altfire)
 	v[YAW]   = ent->client->v_angle[YAW] - 5;
 	v[ROLL]  = ent->client->v_angle[ROLL];
 	AngleVectors (v, forward, NULL, NULL);
-	fire_shotgun (ent, start, forward, damage, kick, sshotgun_hspread->value, sshotgun_vspread->value, sshotgun_count->value/2, MOD_SSHOTGUN);
+	fire_shotgun (ent, start, forward, damage, kick, km_values.sshotgun_hspread, km_values.sshotgun_vspread, km_values.sshotgun_count/2, MOD_SSHOTGUN);
 	v[YAW]   = ent->client->v_angle[YAW] + 5;
 	AngleVectors (v, forward, NULL, NULL);
-	fire_shotgun (ent, start, forward, damage, kick, sshotgun_hspread->value, sshotgun_vspread->value, sshotgun_count->value/2, MOD_SSHOTGUN);
+	fire_shotgun (ent, start, forward, damage, kick, km_values.sshotgun_hspread, km_values.sshotgun_vspread, km_values.sshotgun_count/2, MOD_SSHOTGUN);
 
 	// send muzzle flash
 	gi.WriteByte (svc_muzzleflash);
@@ -1672,12 +1802,12 @@ void weapon_railgun_fire (edict_t *ent, qboolean altfire)
 
 	if (deathmatch->value)
 	{	// normal damage is too extreme in dm
-		damage = railgun_damage_dm->value;
+		damage = km_values.railgun_damage_dm;
 		kick = 200;
 	}
 	else
 	{
-		damage = railgun_damage->value;
+		damage = km_values.railgun_damage;
 		kick = 250;
 	}
 
@@ -1732,12 +1862,12 @@ void weapon_bfg_fire (edict_t *ent, qboolean altfire)
 	vec3_t	offset, start;
 	vec3_t	forward, right;
 	int		damage;
-	float	damage_radius = bfg_radius->value;
+	float	damage_radius = km_values.bfg_radius;
 
 	if (deathmatch->value)
-		damage = bfg_damage_dm->value;
+		damage = km_values.bfg_damage_dm;
 	else
-		damage = bfg_damage->value;
+		damage = km_values.bfg_damage;
 
 	if (ent->client->ps.gunframe == 9)
 	{
@@ -1775,7 +1905,7 @@ void weapon_bfg_fire (edict_t *ent, qboolean altfire)
 
 	VectorSet(offset, 8, 8, ent->viewheight-8);
 	P_ProjectSource (ent->client, ent->s.origin, offset, forward, right, start);
-	fire_bfg (ent, start, forward, damage, bfg_speed->value, damage_radius);
+	fire_bfg (ent, start, forward, damage, km_values.bfg_speed, damage_radius);
 
 	ent->client->ps.gunframe++;
 
@@ -1806,7 +1936,7 @@ void kick_attack (edict_t *ent)
 	vec3_t		start;
 	vec3_t		forward, right;
 	vec3_t		offset;
-	int			damage = jump_kick_damage->value;
+	int			damage = km_values.jump_kick_damage;
 	int			kick = 300;
 	trace_t		tr;
 	vec3_t		end;
@@ -29,12 +29,16 @@
 char *CTFOtherTeamName(int team);
 char *CTFOtherTeamName2(int team);
 char *CTFTeamName(int team);
-char *ClientTeam(edict_t *ent);
+char *ED_InternString(const char *s);
 char *ED_NewString(char *string);
 char *ED_ParseEdict(char *data,edict_t *ent);
 char *G_CopyString(const char *in);
+char *G_LevelString(const char *in);
+char *G_LightStyle(int style);
+char *Text_BuildDisplay(texthnd_t *hnd);
 char *vtos(vec3_t v);
 edict_t *ACESP_FindFreeClient(void);
+edict_t *ACESP_SpawnBot(char *team,char *name,char *skin,char *userinfo);
 edict_t *CrateOnTop(edict_t *from,edict_t *ent);
 edict_t *CreateTargetChangeLevel(char *map);
 edict_t *Drop_Item(edict_t *ent,gitem_t *item);
@@ -43,13 +47,13 @@ edict_t *G_Find(edict_t *from,int fieldofs,char *match);
 edict_t *G_FindNextCamera(edict_t *camera,edict_t *monitor);
 edict_t *G_FindPrevCamera(edict_t *camera,edict_t *monitor);
 edict_t *G_PickDestination (char *targetname);
+edict_t *G_PickRoute(edict_t *ent);
 edict_t *G_PickTarget(char *targetname);
 edict_t *G_Spawn(void);
+edict_t *G_SpawnTagged(char *site);
+edict_t *GetCamPlayer(edict_t *player);
 edict_t *LookingAt(edict_t *ent,int filter,vec3_t endpos,float *range);
 edict_t *NextPathTrack(edict_t *train,edict_t *path);
-edict_t *PlayerTrail_LastSpot(void);
-edict_t *PlayerTrail_PickFirst(edict_t *self);
-edict_t *PlayerTrail_PickNext(edict_t *self);
 edict_t *SV_TestEntityPosition(edict_t *ent);
 edict_t *SelectCTFSpawnPoint(edict_t *ent);
 edict_t *SelectCoopSpawnPoint(edict_t *ent);
@@ -63,7 +67,11 @@ edict_t *medic_FindDeadMonster(edict_t *self);
 edict_t *rocket_target(edict_t *self,vec3_t start,vec3_t forward);
 float *tv(float x,float y,float z);
 float ACEIT_ItemNeed(edict_t *self,int item);
+float ACEIT_ItemRespawnWait(int);
 float AtLeast(float x,float dx);
+float Gov_Interval(float time);
+float Gov_Lifetime(float time);
+float Gov_Scale(void);
 float PM_CmdScale(usercmd_t *cmd);
 float PlayersRangeFromSpot(edict_t *spot);
 float RiderMass(edict_t *platform);
@@ -101,14 +109,24 @@ int Debug_Modelindex(char *name);
 int Debug_Soundindex(char *name);
 int Decode(char *filename,uint8_t *buffer,int bufsize);
 int Encode(char *filename,uint8_t *buffer,int bufsize,int version);
+int G_ClientsInPVS(edict_t *ent,byte *mask);
+int G_DelayedUses(delayeduse_t **list);
+int G_EdictSerial(void);
+int G_EnvContents(vec3_t p);
+int G_SpawnSpots(int type,edict_t ***spots,float **ranges);
+int G_TraceTotal(void);
 int HintTestStart(edict_t *self);
+int ItemAmmoIndex(gitem_t *item);
+int M_Corpses(edict_t ***list);
 int NumOfTech(int index);
 int PatchDeadSoldier(void);
 int PatchMonsterModel(char *modelname);
 int PatchPlayerModels(char *modelname);
 int PlayerSort(void const *a,void const *b);
+int PlayerTrail_Save(int n,trailspot_t *spots);
 int PlayersOnCTFTeam(int checkteam);
 int PowerArmorType(edict_t *ent);
+int Prof_PhysSection(int movetype);
 int SV_FlyMove(edict_t *ent,float time,int mask);
 int SV_PushableMove(edict_t *ent,float time,int mask);
 int SV_VehicleMove(edict_t *ent,float time,int mask);
@@ -149,10 +167,16 @@ qboolean CanDamage(edict_t *targ,edict_t *inflictor);
 qboolean CheckFlood(edict_t *ent);
 qboolean CheckTeamDamage(edict_t *targ,edict_t *attacker);
 qboolean ClientConnect(edict_t *ent,char *userinfo);
+qboolean CmdLog_ClientThink(edict_t*,usercmd_t*);
+qboolean CmdLog_Replaying(void);
 qboolean Crane_Hook_Bonk(edict_t *hook,int axis,int dir,vec3_t bonk);
 qboolean ED_ParseEntityAlias(char *data,edict_t *ent);
 qboolean FacingIdeal(edict_t *self);
 qboolean FindTarget(edict_t *self);
+qboolean G_ClientSeesEntity(edict_t *ent,int n);
+qboolean G_TraceBatchAvailable(void);
+qboolean G_WaterLevelKnown(edict_t *ent,int kind);
+qboolean Gov_SkipFrame(void);
 qboolean HasSpawnFunction(edict_t *ent);
 qboolean InPak(const char *basedir,const char *gamedir,const char *filename);
 qboolean IsFemale(edict_t *ent);
@@ -167,6 +191,11 @@ qboolean M_SetDeath(edict_t *self,mmove_t **deathmoves);
 qboolean M_walkmove(edict_t *ent,float yaw,float dist);
 qboolean Makron_CheckAttack(edict_t *self);
 qboolean OnSameTeam(edict_t *ent1,edict_t *ent2);
+qboolean OpenTransitionEdicts(void);
+qboolean PMenu_Do_Update(edict_t *ent);
+qboolean PatchedModel_Checked(char *outfilename);
+qboolean PatchedModel_Valid(char *outfilename,int numskins,char *skins,int skinsize);
+qboolean PatchedModel_Write(char *outfilename,dmdl_t *model,char *skins,int skinsize,byte *data,int datasize);
 qboolean Pickup_Adrenaline(edict_t *ent,edict_t *other);
 qboolean Pickup_Ammo(edict_t *ent,edict_t *other);
 qboolean Pickup_AmmogenPack(edict_t *ent,edict_t *other);
@@ -217,25 +246,38 @@ qboolean visible(edict_t *self,edict_t *other);
 trace_t PM_trace(vec3_t start,vec3_t mins,vec3_t maxs,vec3_t end);
 trace_t SV_DebrisEntity(edict_t *ent,vec3_t push);
 trace_t SV_PushEntity(edict_t *ent,vec3_t push);
+trailspot_t *PlayerTrail_PickFirst(edict_t *self);
+trailspot_t *PlayerTrail_PickNext(edict_t *self);
+unsigned int ED_StringHash(const char *s);
 uint32_t CheckBlock(void *b,int c);
+void *G_LevelAlloc(int size);
+void *G_PoolAlloc(gpool_t *pool);
 void ACEAI_ChooseWeapon(edict_t *self);
+void ACEAI_InitWeaponPicks(void);
 void ACEAI_PickLongRangeGoal(edict_t *self);
 void ACEAI_PickShortRangeGoal(edict_t *self);
 void ACEAI_Think(edict_t *self);
 void ACECM_Store(void);
 void ACEIT_BuildItemNodeTable(qboolean rebuild);
+void ACEIT_ItemRespawned(edict_t*);
+void ACEIT_ItemTaken(edict_t*,float);
 void ACEIT_PlayerAdded(edict_t *ent);
 void ACEIT_PlayerRemoved(edict_t *ent);
 void ACEMV_Attack(edict_t *self,usercmd_t *ucmd);
 void ACEMV_ChangeBotAngle(edict_t *ent);
+void ACEMV_InitProbes(void);
 void ACEMV_Move(edict_t *self,usercmd_t *ucmd);
 void ACEMV_MoveToGoal(edict_t *self,usercmd_t *ucmd);
 void ACEMV_Wander(edict_t *self,usercmd_t *ucmd);
+void ACEND_ClearLinkQueue(void);
 void ACEND_DrawPath(void);
+void ACEND_FoldLinks(int count);
+void ACEND_GenerateNodes(void);
 void ACEND_GrapFired(edict_t *self);
 void ACEND_InitNodes(void);
 void ACEND_LoadNodes(void);
 void ACEND_PathMap(edict_t *self);
+void ACEND_QueueNodeEdge(int from,int to);
 void ACEND_RemoveNodeEdge(edict_t *self,int from,int to);
 void ACEND_ResolveAllPaths(void);
 void ACEND_SaveNodes(void);
@@ -243,13 +285,14 @@ void ACEND_SetGoal(edict_t *self,int goal_node);
 void ACEND_ShowNode(int node);
 void ACEND_ShowPath(edict_t *self,int goal_node);
 void ACEND_UpdateNodeEdge(int from,int to);
+void ACEND_WaitForNodeSave(char *filename);
+void ACESP_AutoFill(void);
 void ACESP_HoldSpawn(edict_t *self);
 void ACESP_LoadBotInfo(void);
 void ACESP_PutClientInServer(edict_t *bot,qboolean respawn,int team);
 void ACESP_RemoveBot(char *name);
 void ACESP_Respawn(edict_t *self);
 void ACESP_SetName(edict_t *bot,char *name,char *skin,char *team);
-void ACESP_SpawnBot(char *team,char *name,char *skin,char *userinfo);
 void AI_SetSightClient(void);
 void ActorTarget(edict_t *self,vec3_t target);
 void AddReflection(edict_t *ent);
@@ -264,6 +307,7 @@ void BecomeExplosion1(edict_t *self);
 void BecomeExplosion2(edict_t *self);
 void BecomeExplosion3(edict_t *self);
 void BeginIntermission(edict_t *targ);
+void BeginTransitionEdicts(void);
 void Blaster_Fire(edict_t *ent,vec3_t g_offset,int damage,qboolean hyper,int effect,int color);
 void Boss2MachineGun(edict_t *self);
 void Boss2Rocket(edict_t *self);
@@ -298,6 +342,7 @@ void CTFBoot(edict_t *ent);
 void CTFCalcScores(void);
 void CTFChaseCam(edict_t *ent,pmenuhnd_t *p);
 void CTFCheckHurtCarrier(edict_t *targ,edict_t *attacker);
+void CTFCountTechs(void);
 void CTFCredits(edict_t *ent,pmenuhnd_t *p);
 void CTFDeadDropFlag(edict_t *self);
 void CTFDeadDropTech(edict_t *ent);
@@ -308,7 +353,9 @@ void CTFEffects(edict_t *player);
 void CTFEndMatch(void);
 void CTFFireGrapple(edict_t *self,vec3_t start,vec3_t dir,int damage,int speed,int effect);
 void CTFFlagSetup(edict_t *ent);
+void CTFFlagsChanged(void);
 void CTFFlagThink(edict_t *ent);
+void CTFForgetTechs(gclient_t *client);
 void CTFFragBonuses(edict_t *targ,edict_t *inflictor,edict_t *attacker);
 void CTFGhost(edict_t *ent);
 void CTFGrappleDrawCable(edict_t *self);
@@ -335,6 +382,7 @@ void CTFResetAllPlayers(void);
 void CTFResetFlag(int ctf_team);
 void CTFResetFlags(void);
 void CTFResetGrapple(edict_t *self);
+void CTFResetLocations(void);
 void CTFResetTech(void);
 void CTFRespawnTech(edict_t *ent);
 void CTFReturnToMain(edict_t *ent,pmenuhnd_t *p);
@@ -354,7 +402,10 @@ void CTFSpawn(void);
 void CTFStartMatch(void);
 void CTFStats(edict_t *ent);
 void CTFTeam_f(edict_t *ent);
+void CTFTechAdded(edict_t *ent);
+void CTFTechRemoved(edict_t *ent);
 void CTFTechTouch(edict_t *ent,edict_t *other,cplane_t *plane,csurface_t *surf);
+void CTFUpdateFlagPics(void);
 void CTFVoteNo(edict_t *ent);
 void CTFVoteYes(edict_t *ent);
 void CTFWarp(edict_t *ent);
@@ -391,10 +442,16 @@ void ClientEndServerFrame(edict_t *ent);
 void ClientEndServerFrames(void);
 void ClientObituary(edict_t *self,edict_t *inflictor,edict_t *attacker);
 void ClientPushPushable(edict_t *ent);
+void ClientSetTeams(edict_t *ent,char *userinfo);
 void ClientSpycam(edict_t *ent);
 void ClientThink(edict_t *ent,usercmd_t *ucmd);
 void ClientUserinfoChanged(edict_t *ent,char *userinfo);
 void ClipGibVelocity(edict_t *ent);
+void CloseTransitionEdicts(void);
+void CmdLog_ClientDisconnect(edict_t*);
+void CmdLog_LevelStart(char*);
+void CmdLog_RunFrame(void);
+void CmdLog_Shutdown(void);
 void Cmd_Bbox_f(edict_t *ent);
 void Cmd_Chasecam_Toggle(edict_t *ent);
 void Cmd_Drop_f(edict_t *ent);
@@ -433,7 +490,6 @@ void DeathmatchScoreboard(edict_t *ent);
 void DeathmatchScoreboardMessage(edict_t *ent,edict_t *killer);
 void DefendMyFriend(edict_t *self,edict_t *enemy);
 void DeleteBadMedic(edict_t *self);
-void DeleteNode(int p);
 void DeleteReflection(edict_t *ent,int index);
 void DoRespawn(edict_t *ent);
 void Do_Text_Display(edict_t *activator,int flags,char *message);
@@ -445,6 +501,9 @@ void Drop_PowerArmor(edict_t *ent,gitem_t *item);
 void Drop_Weapon(edict_t *ent,gitem_t *item);
 void ED_CallSpawn(edict_t *ent);
 void ED_ParseField(char *key,char *value,edict_t *ent);
+void ED_ResetSpawnPrototypes(void);
+void ED_ResetStrings(void);
+void ED_SpawnPrototype(edict_t *ent);
 void EndDMLevel(void);
 void ExitLevel(void);
 void FadeDieSink(edict_t *ent);
@@ -455,31 +514,90 @@ void Fog_Init(void);
 //void Fog_Off(edict_t *player_ent);
 void Fog_Off(void);
 void ForcewallOff(edict_t *player);
+void FreeThing(edict_t *self);
 void FoundTarget(edict_t *self);
+void G_AddProjectile(edict_t *ent);
+void G_ArenaStats(void);
+void G_AttachSpeaker(edict_t *speaker);
+void G_BeginLightStyles(void);
+void G_BeginMirroredTemps(void);
+void G_BeginTempEvents(void);
 void G_CheckChaseStats(edict_t *ent);
+void G_ClearContentsCache(void);
+void G_ClearFrameTouches(void);
+void G_ClearIndexCache(void);
+void G_ClearLinkCache(void);
+void G_ClearTraceCache(void);
+void G_ClientTouchTriggers(edict_t *ent);
+void G_DelayUse(int kind,edict_t *ent,edict_t *activator,edict_t *target);
+void G_EndMirroredTemps(void);
 void G_FindCraneParts(void);
 void G_FindTeams(void);
+void G_FlushLightStyles(void);
+void G_FlushTempEvents(void);
 void G_FreeEdict(edict_t *e);
+void G_InitAttachedSounds(void);
+void G_InitClientCommands(void);
 void G_InitEdict(edict_t *e);
+void G_InitLagComp(void);
+void G_InitProjectiles(void);
+void G_InitTraceHooks(void);
+void G_LagRecord(void);
+void G_LagReset(void);
+void G_LagRestore(void);
+void G_LagRewind(edict_t *shooter);
+void G_MessageStats(int *bytes,int *sends);
+void G_PoolFree(gpool_t *pool,void *p);
 void G_ProjectSource(vec3_t point,vec3_t distance,vec3_t forward,vec3_t right,vec3_t result);
 void G_ProjectSource2(vec3_t point,vec3_t distance,vec3_t forward,vec3_t right,vec3_t up,vec3_t result);
+void G_ResetAttachedSounds(void);
+void G_ResetClientPVS(void);
+void G_ResetDelayedUses(void);
+void G_ResetLevelArena(void);
+void G_ResetLevelCaches(void);
+void G_ResetLightStyles(void);
+void G_ResetPathTracks(void);
+void G_ResetProjectiles(void);
+void G_ResetRespawns(void);
+void G_ResetSpawnSpots(void);
+void G_ResetTriggerWatches(void);
+void G_RestoreDelayedUse(delayeduse_t *d);
+void G_RestoreSpawnLightStyles(void);
+void G_RunDelayedUses(void);
 void G_RunEntity(edict_t *ent);
 void G_RunFrame(void);
+void G_RunProjectiles(void);
+void G_RunRespawns(void);
+void G_SaveSpawnLightStyles(void);
 void G_SetClientEffects(edict_t *ent);
 void G_SetClientEvent(edict_t *ent);
 void G_SetClientFrame(edict_t *ent);
 void G_SetClientSound(edict_t *ent);
+void G_SetLightStyle(int style,char *value);
 void G_SetMovedir(vec3_t angles,vec3_t movedir);
 void G_SetSpectatorStats(edict_t *ent);
 void G_SetStats(edict_t *ent);
+void G_SetTraceBatch(void (*batch) (tracerequest_t *requests,trace_t *results,int count));
+void G_SpawnSpotTaken(edict_t *taken);
+void G_StoreWaterLevel(edict_t *ent,int kind);
+void G_TempImpact(int type,vec3_t origin,vec3_t dir);
+void G_TempPoint(int type,vec3_t origin,multicast_t to);
+void G_TempSplash(int type,int count,vec3_t origin,vec3_t dir,int color);
+void G_TempTrail(int type,vec3_t start,vec3_t end,vec3_t origin,multicast_t to);
 void G_TouchSolids(edict_t *ent);
 void G_TouchTriggers(edict_t *ent);
+void G_TraceBatch(tracerequest_t *requests,trace_t *results,int count);
+void G_TriggerLinkEvent(edict_t *ent);
+void G_UpdateAttachedSounds(void);
 void G_UseTarget(edict_t *ent,edict_t *activator,edict_t *target);
 void G_UseTargets(edict_t *ent,edict_t *activator);
 void GaldiatorMelee(edict_t *self);
 void GameDirRelativePath(char *filename,char *output);
 void GetChaseTarget(edict_t *ent);
 void GladiatorGun(edict_t *self);
+void Gov_BeginFrame(void);
+void Gov_EndFrame(void);
+void Gov_Reset(void);
 void Grenade_Evade(edict_t *monster);
 void Grenade_Explode (edict_t *ent);
 void Grenade_Touch (edict_t *ent, edict_t *other, cplane_t *plane, csurface_t *surf);
@@ -496,14 +614,14 @@ void InitClientPersistant(gclient_t *client,int style);
 void InitClientResp(gclient_t *client);
 void InitGame(void);
 void InitItems(void);
-void InitTree(void);
+void InitReflections(void);
 void InitTrigger(edict_t *self);
 void InitiallyDead(edict_t *self);
-void InsertNode(int r);
 void Jet_ApplyJet(edict_t *ent,usercmd_t *ucmd);
 void Jet_ApplyLifting(edict_t *ent);
 void Jet_ApplySparks(edict_t *ent);
 void Jet_BecomeExplosion(edict_t *ent,int damage);
+void KM_RefreshCvars(qboolean all);
 void Killed(edict_t *targ,edict_t *inflictor,edict_t *attacker,int damage,vec3_t point);
 void Lights(void);
 void LoadAliasData(void);
@@ -513,12 +631,16 @@ void LookAtKiller(edict_t *self,edict_t *inflictor,edict_t *attacker);
 void M_CatagorizePosition(edict_t *ent);
 void M_ChangeYaw(edict_t *ent);
 void M_CheckGround(edict_t *ent);
+void M_ClearMoveCache(void);
 void M_FliesOff(edict_t *self);
 void M_FliesOn(edict_t *self);
 void M_FlyCheck(edict_t *self);
+void M_InitMoveCache(void);
 void M_MoveFrame(edict_t *self);
 void M_MoveToGoal(edict_t *ent,float dist);
 void M_ReactToDamage(edict_t *targ,edict_t *attacker);
+void M_RemoveCorpse(edict_t *self);
+void M_ResetCorpses(void);
 void M_SetEffects(edict_t *ent);
 void M_WorldEffects(edict_t *ent);
 void M_droptofloor(edict_t *ent);
@@ -539,7 +661,6 @@ void Move_Final(edict_t *ent);
 void Moving_Speaker_Think(edict_t *speaker);
 void NoAmmoWeaponChange(edict_t *ent);
 void PMenu_Close(edict_t *ent);
-void PMenu_Do_Update(edict_t *ent);
 void PMenu_Next(edict_t *ent);
 void PMenu_Prev(edict_t *ent);
 void PMenu_Select(edict_t *ent);
@@ -551,19 +672,32 @@ void P_ProjectSource(gclient_t *client,vec3_t point,vec3_t distance,vec3_t forwa
 void P_SlamDamage(edict_t *ent);
 void P_WorldEffects(void);
 void PlayerNoise(edict_t *who,vec3_t where,int type);
-void PlayerTrail_Add(vec3_t spot);
+void PlayerTrail_Add(edict_t *ent,vec3_t spot);
 void PlayerTrail_Init(void);
-void PlayerTrail_New(vec3_t spot);
+void PlayerTrail_New(edict_t *ent,vec3_t spot);
+void PlayerTrail_Restore(int n,trailspot_t *spots,int count);
+void PlayerTrail_Update(edict_t *ent);
+void PoolCamPlayer(edict_t *player,edict_t *faker);
 void PrecacheDebris(int type);
 void PrecacheItem(gitem_t *it);
 void PrintPmove(pmove_t *pm);
+void Prof_Begin(int section);
+void Prof_BeginFrame(void);
+void Prof_CountAlloc(void);
+void Prof_CountFree(void);
+void Prof_CountLink(void);
+void Prof_CountLinkSkip(void);
+void Prof_CountMulticast(void);
+void Prof_CountTrace(void);
+void Prof_End(int section);
+void Prof_Shutdown(void);
 void PutClientInServer(edict_t *ent);
-void ReadClient(FILE *f,gclient_t *client);
-void ReadEdict(FILE *f,edict_t *ent);
-void ReadField(FILE *f,field_t *field,byte *base);
+void ReadClient(loadbuf_t *buf,gclient_t *client);
+void ReadField(loadbuf_t *buf,field_t *field,byte *base);
 void ReadGame(const char *filename);
 void ReadLevel(const char *filename);
-void ReadLevelLocals(FILE *f);
+void ReadLevelLocals(loadbuf_t *buf);
+void ReadTransitionEdict(edict_t *ent);
 void RealBoundingBox(edict_t *ent,vec3_t mins,vec3_t maxs);
 void ReflectExplosion(int type,vec3_t origin);
 void ReflectSparks(int type,vec3_t origin,vec3_t movedir);
@@ -571,6 +705,13 @@ void ReflectSteam(vec3_t origin,vec3_t movedir,int count,int sounds,int speed,in
 void ReflectTrail(int type,vec3_t start,vec3_t end);
 void RemovePush(edict_t *ent);
 void RemoveTechs(int oldtechcount,int newtechcount,int numtechtypes);
+void Rep_BeginLevel(float msec,qboolean loaded);
+void Rep_CountSave(int msec);
+void Rep_EndLevel(void);
+void Rep_Think(edict_t *ent);
+void RestoreCamPlayers(void);
+void RestoreHintPaths(void);
+void RestoreReflections(void);
 void Rocket_Evade(edict_t *rocket,vec3_t dir,float speed);
 void RotateAngles(vec3_t in,vec3_t delta,vec3_t out);
 void SP_CreateCoopSpots (edict_t *self);
@@ -769,6 +910,7 @@ void SP_viewthing(edict_t *ent);
 void SP_worldspawn(edict_t *ent);
 void SVCmd_AddIP_f(void);
 void SVCmd_ListIP_f(void);
+void SVCmd_LoadIP_f(void);
 void SVCmd_RemoveIP_f(void);
 void SVCmd_WriteIP_f(void);
 void SV_AddBlend(float r,float g,float b,float a,float *v_blend);
@@ -783,6 +925,7 @@ void SV_Impact(edict_t *e1,trace_t *trace);
 void SV_NewChaseDir(edict_t *actor,edict_t *enemy,float dist);
 void SV_Physics_Conveyor(edict_t *ent);
 void SV_Physics_Debris(edict_t *ent);
+void SV_Physics_Missile(edict_t *ent);
 void SV_Physics_Noclip(edict_t *ent);
 void SV_Physics_None(edict_t *ent);
 void SV_Physics_Pusher(edict_t *ent);
@@ -815,23 +958,31 @@ void SpawnItem(edict_t *ent,gitem_t *item);
 void SpawnMoreTechs(int oldtechcount,int newtechcount,int numtechtypes);
 void SpawnTech(gitem_t *item, edict_t *spot);
 void SpawnTechs (edict_t *ent);
+void Svcmd_CmdLog_f(void);
+void Svcmd_Edicts_f(void);
 void Svcmd_Test_f(void);
 void SwitchToBestStartWeapon(gclient_t *client);
 void Sys_Error(char *error,...);
 void TH_viewthing(edict_t *ent);
 void TTCTFOpenJoinMenu(edict_t *ent);
 void T_Damage(edict_t *targ,edict_t *inflictor,edict_t *attacker,vec3_t dir,vec3_t point,vec3_t normal,int damage,int knockback,int dflags,int mod);
+void T_DamageBatchBegin(void);
+void T_DamageBatchEnd(void);
 void T_RadiusDamage(edict_t *inflictor,edict_t *attacker,float damage,edict_t *ignore,float radius,int mod,double dmg_slope);
 void TankBlaster(edict_t *self);
 void TankMachineGun(edict_t *self);
 void TankRocket(edict_t *self);
 void TankStrike(edict_t *self);
 void TechThink(edict_t *tech);
-void Text_BuildDisplay(texthnd_t *hnd);
+void Tel_BeginFrame(void);
+void Tel_CountSave(int msec);
+void Tel_EndFrame(void);
+void Tel_Shutdown(void);
 void Text_Close(edict_t *ent);
 void Text_Next(edict_t *ent);
 void Text_Open(edict_t *ent);
 void Text_Prev(edict_t *ent);
+void Text_ResetCache(void);
 void Text_Update(edict_t *ent);
 void Think_AccelMove(edict_t *ent);
 void Think_Boss3Stand(edict_t *ent);
@@ -854,6 +1005,7 @@ void Touch_Plat_Center(edict_t *ent,edict_t *other,cplane_t *plane,csurface_t *s
 void TraceAimPoint(vec3_t start,vec3_t target);
 void TreadSound(edict_t *self);
 void UpdateChaseCam(edict_t *ent);
+void UpdateReflectGrid(void);
 void Use_Areaportal(edict_t *ent,edict_t *other,edict_t *activator);
 void Use_Boss3(edict_t *ent,edict_t *other,edict_t *activator);
 void Use_Breather(edict_t *ent,gitem_t *item);
@@ -889,6 +1041,7 @@ void Weapon_HomingMissileLauncher(edict_t *ent);
 void Weapon_HomingMissileLauncher_Fire(edict_t *ent,qboolean altfire);
 void Weapon_HyperBlaster(edict_t *ent);
 void Weapon_HyperBlaster_Fire(edict_t *ent,qboolean altfire);
+void Weapon_InitFrames(void);
 void Weapon_Machinegun(edict_t *ent);
 void Weapon_Null(edict_t *ent);
 void Weapon_Railgun(edict_t *ent);
@@ -898,14 +1051,14 @@ void Weapon_Shotgun(edict_t *ent);
 void Weapon_SuperShotgun(edict_t *ent);
 void WhatIsIt(edict_t *ent);
 void WhatsIt(edict_t *ent);
-void WriteClient(FILE *f,gclient_t *client);
-void WriteEdict(FILE *f,edict_t *ent);
+void WriteClient(savebuf_t *buf,gclient_t *client);
 void WriteField1(FILE *f,field_t *field,byte *base);
-void WriteField2(FILE *f,field_t *field,byte *base);
+void WriteField2(savebuf_t *buf,field_t *field,byte *base);
 void WriteGame(const char *filename, qboolean autosave);
 void WriteLevel(const char *filename);
-void WriteLevelLocals(FILE *f);
-void WriteTransitionEdict(FILE *f,edict_t *changelevel,edict_t *ent);
+void WriteLevelLocals(savebuf_t *buf);
+void WriteTransitionEdict(edict_t *changelevel,edict_t *ent);
+void WriteTransitionImage(edict_t *ent);
 void abortHeal(edict_t *self,qboolean mark);
 void actorBFG(edict_t *self);
 void actorBlaster(edict_t *self);
@@ -1189,6 +1342,7 @@ void gib_delayed_start(edict_t *gib);
 void gib_die(edict_t *self,edict_t *inflictor,edict_t *attacker,int damage,vec3_t point);
 void gib_fade(edict_t *self);
 void gib_fade2(edict_t *self);
+void gib_pool_reset(void);
 void gib_think(edict_t *self);
 void gib_touch(edict_t *self,edict_t *other,cplane_t *plane,csurface_t *surf);
 void gladiator_attack(edict_t *self);
@@ -1387,6 +1541,10 @@ void monster_triggered_start(edict_t *self);
 void monster_use(edict_t *self,edict_t *other,edict_t *activator);
 void movewith_detach(edict_t *child);
 void movewith_init(edict_t *ent);
+void movewith_initgame(void);
+void movewith_link(edict_t *prev,edict_t *next);
+void movewith_reset(void);
+void movewith_unlink(edict_t *ent);
 void movewith_update(edict_t *self);
 void multi_trigger(edict_t *ent);
 void multi_wait(edict_t *ent);
@@ -1458,6 +1616,7 @@ void plat_spawn_inside_trigger(edict_t *ent);
 void player_die(edict_t *self,edict_t *inflictor,edict_t *attacker,int damage,vec3_t point);
 void player_pain(edict_t *self,edict_t *other,float kick,int damage);
 void point_combat_touch(edict_t *self,edict_t *other,cplane_t *plane,csurface_t *surf);
+void precipitation_emit(edict_t *self,vec3_t center,int r);
 void respawn(edict_t *self);
 void rocket_delayed_start(edict_t *rocket);
 void rocket_die (edict_t *self, edict_t *inflictor, edict_t *attacker, int damage, vec3_t point);
@@ -1589,10 +1748,13 @@ void target_monitor_off(edict_t *self);
 void target_precipitation_delayed_use(edict_t *self);
 void target_precipitation_think(edict_t *self);
 void target_precipitation_use(edict_t *ent,edict_t *other,edict_t *activator);
+void target_string_initgame(void);
+void target_string_reset(void);
 void target_string_use(edict_t *self,edict_t *other,edict_t *activator);
 void teleport_transition_ents(edict_t *transition,edict_t *teleporter,edict_t *destination);
 void teleporter_touch(edict_t *self,edict_t *other,cplane_t *plane,csurface_t *surf);
 void thing_grenade_boom(edict_t *self);
+void thing_pool_reset(void);
 void thing_restore_leader(edict_t *self);
 void thing_think(edict_t *self);
 void thing_think_pause(edict_t *self);
@@ -1631,7 +1793,6 @@ void trainbutton_return(edict_t *self);
 void trainbutton_touch(edict_t *self,edict_t *other,cplane_t *plane,csurface_t *surf);
 void trainbutton_use(edict_t *self,edict_t *other,edict_t *activator);
 void trainbutton_wait(edict_t *self);
-void trans_ent_filename(char *);
 void trans_ent_filename(char *filename);
 void tremor_trigger_enable(edict_t *self,edict_t *other,edict_t *activator);
 void trigger_bbox_die(edict_t *self,edict_t *inflictor,edict_t *attacker,int damage,vec3_t point);
@@ -1676,6 +1837,7 @@ void turret_disengage(edict_t *self);
 void turret_driver_die(edict_t *self,edict_t *inflictor,edict_t *attacker,int damage,vec3_t point);
 void turret_driver_link(edict_t *self);
 void turret_driver_think(edict_t *self);
+void turret_reset_targets(void);
 void turret_turn(edict_t *self);
 void use_camera(edict_t *ent,edict_t *other,edict_t *activator);
 void use_camera(edict_t *self,edict_t *other,edict_t *activator);
@@ -30,6 +30,7 @@
 {"ACEAI_CheckShot", (byte *)ACEAI_CheckShot},
 {"ACEAI_ChooseWeapon", (byte *)ACEAI_ChooseWeapon},
 {"ACEAI_FindEnemy", (byte *)ACEAI_FindEnemy},
+{"ACEAI_InitWeaponPicks", (byte *)ACEAI_InitWeaponPicks},
 {"ACEAI_PickLongRangeGoal", (byte *)ACEAI_PickLongRangeGoal},
 {"ACEAI_PickShortRangeGoal", (byte *)ACEAI_PickShortRangeGoal},
 {"ACEAI_Think", (byte *)ACEAI_Think},
@@ -42,27 +43,35 @@
 {"ACEIT_IsReachable", (byte *)ACEIT_IsReachable},
 {"ACEIT_IsVisible", (byte *)ACEIT_IsVisible},
 {"ACEIT_ItemNeed", (byte *)ACEIT_ItemNeed},
+{"ACEIT_ItemRespawned", (byte *)ACEIT_ItemRespawned},
+{"ACEIT_ItemRespawnWait", (byte *)ACEIT_ItemRespawnWait},
+{"ACEIT_ItemTaken", (byte *)ACEIT_ItemTaken},
 {"ACEIT_PlayerAdded", (byte *)ACEIT_PlayerAdded},
 {"ACEIT_PlayerRemoved", (byte *)ACEIT_PlayerRemoved},
 {"ACEMV_Attack", (byte *)ACEMV_Attack},
 {"ACEMV_CanMove", (byte *)ACEMV_CanMove},
 {"ACEMV_ChangeBotAngle", (byte *)ACEMV_ChangeBotAngle},
 {"ACEMV_CheckEyes", (byte *)ACEMV_CheckEyes},
+{"ACEMV_InitProbes", (byte *)ACEMV_InitProbes},
 {"ACEMV_Move", (byte *)ACEMV_Move},
 {"ACEMV_MoveToGoal", (byte *)ACEMV_MoveToGoal},
 {"ACEMV_SpecialMove", (byte *)ACEMV_SpecialMove},
 {"ACEMV_Wander", (byte *)ACEMV_Wander},
 {"ACEND_AddNode", (byte *)ACEND_AddNode},
 {"ACEND_CheckForLadder", (byte *)ACEND_CheckForLadder},
+{"ACEND_ClearLinkQueue", (byte *)ACEND_ClearLinkQueue},
 {"ACEND_DrawPath", (byte *)ACEND_DrawPath},
 {"ACEND_FindCloseReachableNode", (byte *)ACEND_FindCloseReachableNode},
 {"ACEND_FindClosestReachableNode", (byte *)ACEND_FindClosestReachableNode},
 {"ACEND_FindCost", (byte *)ACEND_FindCost},
+{"ACEND_FoldLinks", (byte *)ACEND_FoldLinks},
 {"ACEND_FollowPath", (byte *)ACEND_FollowPath},
+{"ACEND_GenerateNodes", (byte *)ACEND_GenerateNodes},
 {"ACEND_GrapFired", (byte *)ACEND_GrapFired},
 {"ACEND_InitNodes", (byte *)ACEND_InitNodes},
 {"ACEND_LoadNodes", (byte *)ACEND_LoadNodes},
 {"ACEND_PathMap", (byte *)ACEND_PathMap},
+{"ACEND_QueueNodeEdge", (byte *)ACEND_QueueNodeEdge},
 {"ACEND_RemoveNodeEdge", (byte *)ACEND_RemoveNodeEdge},
 {"ACEND_ResolveAllPaths", (byte *)ACEND_ResolveAllPaths},
 {"ACEND_SaveNodes", (byte *)ACEND_SaveNodes},
@@ -70,6 +79,8 @@
 {"ACEND_ShowNode", (byte *)ACEND_ShowNode},
 {"ACEND_ShowPath", (byte *)ACEND_ShowPath},
 {"ACEND_UpdateNodeEdge", (byte *)ACEND_UpdateNodeEdge},
+{"ACEND_WaitForNodeSave", (byte *)ACEND_WaitForNodeSave},
+{"ACESP_AutoFill", (byte *)ACESP_AutoFill},
 {"ACESP_FindFreeClient", (byte *)ACESP_FindFreeClient},
 {"ACESP_HoldSpawn", (byte *)ACESP_HoldSpawn},
 {"ACESP_LoadBotInfo", (byte *)ACESP_LoadBotInfo},
@@ -142,6 +153,7 @@
 {"BecomeExplosion2", (byte *)BecomeExplosion2},
 {"BecomeExplosion3", (byte *)BecomeExplosion3},
 {"BeginIntermission", (byte *)BeginIntermission},
+{"BeginTransitionEdicts", (byte *)BeginTransitionEdicts},
 {"berserk_attack_club", (byte *)berserk_attack_club},
 {"berserk_attack_spike", (byte *)berserk_attack_spike},
 {"berserk_dead", (byte *)berserk_dead},
@@ -284,13 +296,14 @@
 {"ClientEndServerFrames", (byte *)ClientEndServerFrames},
 {"ClientObituary", (byte *)ClientObituary},
 {"ClientPushPushable", (byte *)ClientPushPushable},
+{"ClientSetTeams", (byte *)ClientSetTeams},
 {"ClientSpycam", (byte *)ClientSpycam},
-{"ClientTeam", (byte *)ClientTeam},
 {"ClientThink", (byte *)ClientThink},
 {"ClientUserinfoChanged", (byte *)ClientUserinfoChanged},
 {"ClipGibVelocity", (byte *)ClipGibVelocity},
 {"ClipVelocity", (byte *)ClipVelocity},
 {"clone", (byte *)clone},
+{"CloseTransitionEdicts", (byte *)CloseTransitionEdicts},
 {"Cmd_Bbox_f", (byte *)Cmd_Bbox_f},
 {"Cmd_Chasecam_Toggle", (byte *)Cmd_Chasecam_Toggle},
 {"Cmd_Drop_f", (byte *)Cmd_Drop_f},
@@ -316,6 +329,12 @@
 {"Cmd_WeapLast_f", (byte *)Cmd_WeapLast_f},
 {"Cmd_WeapNext_f", (byte *)Cmd_WeapNext_f},
 {"Cmd_WeapPrev_f", (byte *)Cmd_WeapPrev_f},
+{"CmdLog_ClientDisconnect", (byte *)CmdLog_ClientDisconnect},
+{"CmdLog_ClientThink", (byte *)CmdLog_ClientThink},
+{"CmdLog_LevelStart", (byte *)CmdLog_LevelStart},
+{"CmdLog_Replaying", (byte *)CmdLog_Replaying},
+{"CmdLog_RunFrame", (byte *)CmdLog_RunFrame},
+{"CmdLog_Shutdown", (byte *)CmdLog_Shutdown},
 {"Com_Printf", (byte *)Com_Printf},
 {"commander_body_drop", (byte *)commander_body_drop},
 {"commander_body_think", (byte *)commander_body_think},
@@ -370,6 +389,7 @@
 {"CTFChaseCam", (byte *)CTFChaseCam},
 {"CTFCheckHurtCarrier", (byte *)CTFCheckHurtCarrier},
 {"CTFCheckRules", (byte *)CTFCheckRules},
+{"CTFCountTechs", (byte *)CTFCountTechs},
 {"CTFCredits", (byte *)CTFCredits},
 {"CTFDeadDropFlag", (byte *)CTFDeadDropFlag},
 {"CTFDeadDropTech", (byte *)CTFDeadDropTech},
@@ -381,8 +401,10 @@
 {"CTFEndMatch", (byte *)CTFEndMatch},
 {"CTFFireGrapple", (byte *)CTFFireGrapple},
 {"CTFFlagSetup", (byte *)CTFFlagSetup},
+{"CTFFlagsChanged", (byte *)CTFFlagsChanged},
 {"CTFFlagTeam", (byte *)CTFFlagTeam},
 {"CTFFlagThink", (byte *)CTFFlagThink},
+{"CTFForgetTechs", (byte *)CTFForgetTechs},
 {"CTFFragBonuses", (byte *)CTFFragBonuses},
 {"CTFGhost", (byte *)CTFGhost},
 {"CTFGrappleDrawCable", (byte *)CTFGrappleDrawCable},
@@ -420,6 +442,7 @@
 {"CTFResetFlag", (byte *)CTFResetFlag},
 {"CTFResetFlags", (byte *)CTFResetFlags},
 {"CTFResetGrapple", (byte *)CTFResetGrapple},
+{"CTFResetLocations", (byte *)CTFResetLocations},
 {"CTFResetTech", (byte *)CTFResetTech},
 {"CTFRespawnTech", (byte *)CTFRespawnTech},
 {"CTFReturnToMain", (byte *)CTFReturnToMain},
@@ -441,7 +464,10 @@
 {"CTFStats", (byte *)CTFStats},
 {"CTFTeam_f", (byte *)CTFTeam_f},
 {"CTFTeamName", (byte *)CTFTeamName},
+{"CTFTechAdded", (byte *)CTFTechAdded},
+{"CTFTechRemoved", (byte *)CTFTechRemoved},
 {"CTFTechTouch", (byte *)CTFTechTouch},
+{"CTFUpdateFlagPics", (byte *)CTFUpdateFlagPics},
 {"CTFUpdateJoinMenu", (byte *)CTFUpdateJoinMenu},
 {"CTFVoteNo", (byte *)CTFVoteNo},
 {"CTFVoteYes", (byte *)CTFVoteYes},
@@ -464,7 +490,6 @@
 {"decoy_think", (byte *)decoy_think},
 {"DefendMyFriend", (byte *)DefendMyFriend},
 {"DeleteBadMedic", (byte *)DeleteBadMedic},
-{"DeleteNode", (byte *)DeleteNode},
 {"DeleteReflection", (byte *)DeleteReflection},
 {"directed_debris_die", (byte *)directed_debris_die},
 {"Do_Text_Display", (byte *)Do_Text_Display},
@@ -503,10 +528,15 @@
 {"Drop_Weapon", (byte *)Drop_Weapon},
 {"droptofloor", (byte *)droptofloor},
 {"ED_CallSpawn", (byte *)ED_CallSpawn},
+{"ED_InternString", (byte *)ED_InternString},
 {"ED_NewString", (byte *)ED_NewString},
 {"ED_ParseEdict", (byte *)ED_ParseEdict},
 {"ED_ParseEntityAlias", (byte *)ED_ParseEntityAlias},
 {"ED_ParseField", (byte *)ED_ParseField},
+{"ED_ResetSpawnPrototypes", (byte *)ED_ResetSpawnPrototypes},
+{"ED_ResetStrings", (byte *)ED_ResetStrings},
+{"ED_SpawnPrototype", (byte *)ED_SpawnPrototype},
+{"ED_StringHash", (byte *)ED_StringHash},
 {"embedded", (byte *)embedded},
 {"Encode", (byte *)Encode},
 {"EndDMLevel", (byte *)EndDMLevel},
@@ -593,6 +623,7 @@
 {"forcewall_think", (byte *)forcewall_think},
 {"ForcewallOff", (byte *)ForcewallOff},
 {"FoundTarget", (byte *)FoundTarget},
+{"FreeThing", (byte *)FreeThing},
 {"func_breakaway_activate", (byte *)func_breakaway_activate},
 {"func_breakaway_die", (byte *)func_breakaway_die},
 {"func_breakaway_fall", (byte *)func_breakaway_fall},
@@ -629,41 +660,113 @@
 {"func_train_find", (byte *)func_train_find},
 {"func_vehicle_explode", (byte *)func_vehicle_explode},
 {"func_wall_use", (byte *)func_wall_use},
+{"G_AddProjectile", (byte *)G_AddProjectile},
+{"G_ArenaStats", (byte *)G_ArenaStats},
+{"G_AttachSpeaker", (byte *)G_AttachSpeaker},
+{"G_BeginLightStyles", (byte *)G_BeginLightStyles},
+{"G_BeginMirroredTemps", (byte *)G_BeginMirroredTemps},
+{"G_BeginTempEvents", (byte *)G_BeginTempEvents},
 {"G_CheckChaseStats", (byte *)G_CheckChaseStats},
+{"G_ClearContentsCache", (byte *)G_ClearContentsCache},
+{"G_ClearFrameTouches", (byte *)G_ClearFrameTouches},
+{"G_ClearIndexCache", (byte *)G_ClearIndexCache},
+{"G_ClearLinkCache", (byte *)G_ClearLinkCache},
+{"G_ClearTraceCache", (byte *)G_ClearTraceCache},
+{"G_ClientSeesEntity", (byte *)G_ClientSeesEntity},
+{"G_ClientsInPVS", (byte *)G_ClientsInPVS},
+{"G_ClientTouchTriggers", (byte *)G_ClientTouchTriggers},
 {"G_CopyString", (byte *)G_CopyString},
+{"G_DelayedUses", (byte *)G_DelayedUses},
+{"G_DelayUse", (byte *)G_DelayUse},
+{"G_EdictSerial", (byte *)G_EdictSerial},
+{"G_EndMirroredTemps", (byte *)G_EndMirroredTemps},
+{"G_EnvContents", (byte *)G_EnvContents},
 {"G_Find", (byte *)G_Find},
 {"G_FindCraneParts", (byte *)G_FindCraneParts},
 {"G_FindNextCamera", (byte *)G_FindNextCamera},
 {"G_FindPrevCamera", (byte *)G_FindPrevCamera},
 {"G_FindTeams", (byte *)G_FindTeams},
+{"G_FlushLightStyles", (byte *)G_FlushLightStyles},
+{"G_FlushTempEvents", (byte *)G_FlushTempEvents},
 {"G_FreeEdict", (byte *)G_FreeEdict},
+{"G_InitAttachedSounds", (byte *)G_InitAttachedSounds},
+{"G_InitClientCommands", (byte *)G_InitClientCommands},
 {"G_InitEdict", (byte *)G_InitEdict},
+{"G_InitLagComp", (byte *)G_InitLagComp},
+{"G_InitProjectiles", (byte *)G_InitProjectiles},
+{"G_InitTraceHooks", (byte *)G_InitTraceHooks},
+{"G_LagRecord", (byte *)G_LagRecord},
+{"G_LagReset", (byte *)G_LagReset},
+{"G_LagRestore", (byte *)G_LagRestore},
+{"G_LagRewind", (byte *)G_LagRewind},
+{"G_LevelAlloc", (byte *)G_LevelAlloc},
+{"G_LevelString", (byte *)G_LevelString},
+{"G_LightStyle", (byte *)G_LightStyle},
+{"G_MessageStats", (byte *)G_MessageStats},
 {"G_PickDestination", (byte *)G_PickDestination},
+{"G_PickRoute", (byte *)G_PickRoute},
 {"G_PickTarget", (byte *)G_PickTarget},
+{"G_PoolAlloc", (byte *)G_PoolAlloc},
+{"G_PoolFree", (byte *)G_PoolFree},
 {"G_ProjectSource", (byte *)G_ProjectSource},
 {"G_ProjectSource2", (byte *)G_ProjectSource2},
+{"G_ResetAttachedSounds", (byte *)G_ResetAttachedSounds},
+{"G_ResetClientPVS", (byte *)G_ResetClientPVS},
+{"G_ResetDelayedUses", (byte *)G_ResetDelayedUses},
+{"G_ResetLevelArena", (byte *)G_ResetLevelArena},
+{"G_ResetLevelCaches", (byte *)G_ResetLevelCaches},
+{"G_ResetLightStyles", (byte *)G_ResetLightStyles},
+{"G_ResetPathTracks", (byte *)G_ResetPathTracks},
+{"G_ResetProjectiles", (byte *)G_ResetProjectiles},
+{"G_ResetRespawns", (byte *)G_ResetRespawns},
+{"G_ResetSpawnSpots", (byte *)G_ResetSpawnSpots},
+{"G_ResetTriggerWatches", (byte *)G_ResetTriggerWatches},
+{"G_RestoreDelayedUse", (byte *)G_RestoreDelayedUse},
+{"G_RestoreSpawnLightStyles", (byte *)G_RestoreSpawnLightStyles},
+{"G_RunDelayedUses", (byte *)G_RunDelayedUses},
 {"G_RunEntity", (byte *)G_RunEntity},
 {"G_RunFrame", (byte *)G_RunFrame},
+{"G_RunProjectiles", (byte *)G_RunProjectiles},
+{"G_RunRespawns", (byte *)G_RunRespawns},
+{"G_SaveSpawnLightStyles", (byte *)G_SaveSpawnLightStyles},
 {"G_SetClientEffects", (byte *)G_SetClientEffects},
 {"G_SetClientEvent", (byte *)G_SetClientEvent},
 {"G_SetClientFrame", (byte *)G_SetClientFrame},
 {"G_SetClientSound", (byte *)G_SetClientSound},
+{"G_SetLightStyle", (byte *)G_SetLightStyle},
 {"G_SetMovedir", (byte *)G_SetMovedir},
 {"G_SetSpectatorStats", (byte *)G_SetSpectatorStats},
 {"G_SetStats", (byte *)G_SetStats},
+{"G_SetTraceBatch", (byte *)G_SetTraceBatch},
 {"G_Spawn", (byte *)G_Spawn},
+{"G_SpawnSpots", (byte *)G_SpawnSpots},
+{"G_SpawnSpotTaken", (byte *)G_SpawnSpotTaken},
+{"G_SpawnTagged", (byte *)G_SpawnTagged},
+{"G_StoreWaterLevel", (byte *)G_StoreWaterLevel},
+{"G_TempImpact", (byte *)G_TempImpact},
+{"G_TempPoint", (byte *)G_TempPoint},
+{"G_TempSplash", (byte *)G_TempSplash},
+{"G_TempTrail", (byte *)G_TempTrail},
 {"G_TouchSolids", (byte *)G_TouchSolids},
 {"G_TouchTriggers", (byte *)G_TouchTriggers},
+{"G_TraceBatch", (byte *)G_TraceBatch},
+{"G_TraceBatchAvailable", (byte *)G_TraceBatchAvailable},
+{"G_TraceTotal", (byte *)G_TraceTotal},
+{"G_TriggerLinkEvent", (byte *)G_TriggerLinkEvent},
+{"G_UpdateAttachedSounds", (byte *)G_UpdateAttachedSounds},
 {"G_UseTarget", (byte *)G_UseTarget},
 {"G_UseTargets", (byte *)G_UseTargets},
+{"G_WaterLevelKnown", (byte *)G_WaterLevelKnown},
 {"GaldiatorMelee", (byte *)GaldiatorMelee},
 {"GameDirRelativePath", (byte *)GameDirRelativePath},
+{"GetCamPlayer", (byte *)GetCamPlayer},
 {"GetChaseTarget", (byte *)GetChaseTarget},
 {"GetItemByIndex", (byte *)GetItemByIndex},
 {"gib_delayed_start", (byte *)gib_delayed_start},
 {"gib_die", (byte *)gib_die},
 {"gib_fade", (byte *)gib_fade},
 {"gib_fade2", (byte *)gib_fade2},
+{"gib_pool_reset", (byte *)gib_pool_reset},
 {"gib_think", (byte *)gib_think},
 {"gib_touch", (byte *)gib_touch},
 {"gladiator_attack", (byte *)gladiator_attack},
@@ -680,6 +783,13 @@
 {"gladiator_stand", (byte *)gladiator_stand},
 {"gladiator_walk", (byte *)gladiator_walk},
 {"GladiatorGun", (byte *)GladiatorGun},
+{"Gov_BeginFrame", (byte *)Gov_BeginFrame},
+{"Gov_EndFrame", (byte *)Gov_EndFrame},
+{"Gov_Interval", (byte *)Gov_Interval},
+{"Gov_Lifetime", (byte *)Gov_Lifetime},
+{"Gov_Reset", (byte *)Gov_Reset},
+{"Gov_Scale", (byte *)Gov_Scale},
+{"Gov_SkipFrame", (byte *)Gov_SkipFrame},
 {"grenade_delayed_start", (byte *)grenade_delayed_start},
 {"Grenade_Evade", (byte *)Grenade_Evade},
 {"Grenade_Explode", (byte *)Grenade_Explode},
@@ -762,7 +872,7 @@
 {"InitGame", (byte *)InitGame},
 {"InitiallyDead", (byte *)InitiallyDead},
 {"InitItems", (byte *)InitItems},
-{"InitTree", (byte *)InitTree},
+{"InitReflections", (byte *)InitReflections},
 {"InitTrigger", (byte *)InitTrigger},
 {"InPak", (byte *)InPak},
 {"insane_checkdown", (byte *)insane_checkdown},
@@ -779,12 +889,12 @@
 {"insane_shake", (byte *)insane_shake},
 {"insane_stand", (byte *)insane_stand},
 {"insane_walk", (byte *)insane_walk},
-{"InsertNode", (byte *)InsertNode},
 {"is_backing_up", (byte *)is_backing_up},
 {"IsFemale", (byte *)IsFemale},
 {"IsIdMap", (byte *)IsIdMap},
 {"IsNeutral", (byte *)IsNeutral},
 {"item_die", (byte *)item_die},
+{"ItemAmmoIndex", (byte *)ItemAmmoIndex},
 {"Jet_ApplyJet", (byte *)Jet_ApplyJet},
 {"Jet_ApplyLifting", (byte *)Jet_ApplyLifting},
 {"Jet_ApplySparks", (byte *)Jet_ApplySparks},
@@ -812,6 +922,7 @@
 {"kick_attack", (byte *)kick_attack},
 {"KillBox", (byte *)KillBox},
 {"Killed", (byte *)Killed},
+{"KM_RefreshCvars", (byte *)KM_RefreshCvars},
 {"laser_sight_think", (byte *)laser_sight_think},
 {"leaf_fade", (byte *)leaf_fade},
 {"leaf_fade2", (byte *)leaf_fade2},
@@ -835,13 +946,18 @@
 {"M_CheckAttack", (byte *)M_CheckAttack},
 {"M_CheckBottom", (byte *)M_CheckBottom},
 {"M_CheckGround", (byte *)M_CheckGround},
+{"M_ClearMoveCache", (byte *)M_ClearMoveCache},
+{"M_Corpses", (byte *)M_Corpses},
 {"M_droptofloor", (byte *)M_droptofloor},
 {"M_FliesOff", (byte *)M_FliesOff},
 {"M_FliesOn", (byte *)M_FliesOn},
 {"M_FlyCheck", (byte *)M_FlyCheck},
+{"M_InitMoveCache", (byte *)M_InitMoveCache},
 {"M_MoveFrame", (byte *)M_MoveFrame},
 {"M_MoveToGoal", (byte *)M_MoveToGoal},
 {"M_ReactToDamage", (byte *)M_ReactToDamage},
+{"M_RemoveCorpse", (byte *)M_RemoveCorpse},
+{"M_ResetCorpses", (byte *)M_ResetCorpses},
 {"M_SetDeath", (byte *)M_SetDeath},
 {"M_SetEffects", (byte *)M_SetEffects},
 {"M_walkmove", (byte *)M_walkmove},
@@ -944,6 +1060,10 @@
 {"MoveRiders", (byte *)MoveRiders},
 {"movewith_detach", (byte *)movewith_detach},
 {"movewith_init", (byte *)movewith_init},
+{"movewith_initgame", (byte *)movewith_initgame},
+{"movewith_link", (byte *)movewith_link},
+{"movewith_reset", (byte *)movewith_reset},
+{"movewith_unlink", (byte *)movewith_unlink},
 {"movewith_update", (byte *)movewith_update},
 {"Moving_Speaker_Think", (byte *)Moving_Speaker_Think},
 {"multi_trigger", (byte *)multi_trigger},
@@ -980,6 +1100,7 @@
 {"NumOfTech", (byte *)NumOfTech},
 {"old_teleporter_touch", (byte *)old_teleporter_touch},
 {"OnSameTeam", (byte *)OnSameTeam},
+{"OpenTransitionEdicts", (byte *)OpenTransitionEdicts},
 {"other_FallingDamage", (byte *)other_FallingDamage},
 {"P_DamageFeedback", (byte *)P_DamageFeedback},
 {"P_FallingDamage", (byte *)P_FallingDamage},
@@ -1010,6 +1131,9 @@
 {"parasite_tap", (byte *)parasite_tap},
 {"parasite_walk", (byte *)parasite_walk},
 {"PatchDeadSoldier", (byte *)PatchDeadSoldier},
+{"PatchedModel_Checked", (byte *)PatchedModel_Checked},
+{"PatchedModel_Valid", (byte *)PatchedModel_Valid},
+{"PatchedModel_Write", (byte *)PatchedModel_Write},
 {"PatchMonsterModel", (byte *)PatchMonsterModel},
 {"PatchPlayerModels", (byte *)PatchPlayerModels},
 {"path_corner_touch", (byte *)path_corner_touch},
@@ -1051,10 +1175,12 @@
 {"PlayersRangeFromSpot", (byte *)PlayersRangeFromSpot},
 {"PlayerTrail_Add", (byte *)PlayerTrail_Add},
 {"PlayerTrail_Init", (byte *)PlayerTrail_Init},
-{"PlayerTrail_LastSpot", (byte *)PlayerTrail_LastSpot},
 {"PlayerTrail_New", (byte *)PlayerTrail_New},
 {"PlayerTrail_PickFirst", (byte *)PlayerTrail_PickFirst},
 {"PlayerTrail_PickNext", (byte *)PlayerTrail_PickNext},
+{"PlayerTrail_Restore", (byte *)PlayerTrail_Restore},
+{"PlayerTrail_Save", (byte *)PlayerTrail_Save},
+{"PlayerTrail_Update", (byte *)PlayerTrail_Update},
 {"PM_CmdScale", (byte *)PM_CmdScale},
 {"PM_trace", (byte *)PM_trace},
 {"PMenu_Close", (byte *)PMenu_Close},
@@ -1067,18 +1193,31 @@
 {"PMenu_UpdateEntry", (byte *)PMenu_UpdateEntry},
 {"point_combat_touch", (byte *)point_combat_touch},
 {"point_infront", (byte *)point_infront},
+{"PoolCamPlayer", (byte *)PoolCamPlayer},
 {"PowerArmorType", (byte *)PowerArmorType},
 {"PrecacheDebris", (byte *)PrecacheDebris},
 {"PrecacheItem", (byte *)PrecacheItem},
+{"precipitation_emit", (byte *)precipitation_emit},
 {"PrintPmove", (byte *)PrintPmove},
+{"Prof_Begin", (byte *)Prof_Begin},
+{"Prof_BeginFrame", (byte *)Prof_BeginFrame},
+{"Prof_CountAlloc", (byte *)Prof_CountAlloc},
+{"Prof_CountFree", (byte *)Prof_CountFree},
+{"Prof_CountLink", (byte *)Prof_CountLink},
+{"Prof_CountLinkSkip", (byte *)Prof_CountLinkSkip},
+{"Prof_CountMulticast", (byte *)Prof_CountMulticast},
+{"Prof_CountTrace", (byte *)Prof_CountTrace},
+{"Prof_End", (byte *)Prof_End},
+{"Prof_PhysSection", (byte *)Prof_PhysSection},
+{"Prof_Shutdown", (byte *)Prof_Shutdown},
 {"PutClientInServer", (byte *)PutClientInServer},
 {"range", (byte *)range},
 {"ReadClient", (byte *)ReadClient},
-{"ReadEdict", (byte *)ReadEdict},
 {"ReadField", (byte *)ReadField},
 {"ReadGame", (byte *)ReadGame},
 {"ReadLevel", (byte *)ReadLevel},
 {"ReadLevelLocals", (byte *)ReadLevelLocals},
+{"ReadTransitionEdict", (byte *)ReadTransitionEdict},
 {"RealBoundingBox", (byte *)RealBoundingBox},
 {"realrange", (byte *)realrange},
 {"ReflectExplosion", (byte *)ReflectExplosion},
@@ -1087,7 +1226,14 @@
 {"ReflectTrail", (byte *)ReflectTrail},
 {"RemovePush", (byte *)RemovePush},
 {"RemoveTechs", (byte *)RemoveTechs},
+{"Rep_BeginLevel", (byte *)Rep_BeginLevel},
+{"Rep_CountSave", (byte *)Rep_CountSave},
+{"Rep_EndLevel", (byte *)Rep_EndLevel},
+{"Rep_Think", (byte *)Rep_Think},
 {"respawn", (byte *)respawn},
+{"RestoreCamPlayers", (byte *)RestoreCamPlayers},
+{"RestoreHintPaths", (byte *)RestoreHintPaths},
+{"RestoreReflections", (byte *)RestoreReflections},
 {"RiderMass", (byte *)RiderMass},
 {"rocket_delayed_start", (byte *)rocket_delayed_start},
 {"rocket_die", (byte *)rocket_die},
@@ -1395,6 +1541,7 @@
 {"SV_NewChaseDir", (byte *)SV_NewChaseDir},
 {"SV_Physics_Conveyor", (byte *)SV_Physics_Conveyor},
 {"SV_Physics_Debris", (byte *)SV_Physics_Debris},
+{"SV_Physics_Missile", (byte *)SV_Physics_Missile},
 {"SV_Physics_Noclip", (byte *)SV_Physics_Noclip},
 {"SV_Physics_None", (byte *)SV_Physics_None},
 {"SV_Physics_Pusher", (byte *)SV_Physics_Pusher},
@@ -1409,7 +1556,10 @@
 {"SV_TestEntityPosition", (byte *)SV_TestEntityPosition},
 {"SV_VehicleMove", (byte *)SV_VehicleMove},
 {"SVCmd_AddIP_f", (byte *)SVCmd_AddIP_f},
+{"Svcmd_CmdLog_f", (byte *)Svcmd_CmdLog_f},
+{"Svcmd_Edicts_f", (byte *)Svcmd_Edicts_f},
 {"SVCmd_ListIP_f", (byte *)SVCmd_ListIP_f},
+{"SVCmd_LoadIP_f", (byte *)SVCmd_LoadIP_f},
 {"SVCmd_RemoveIP_f", (byte *)SVCmd_RemoveIP_f},
 {"Svcmd_Test_f", (byte *)Svcmd_Test_f},
 {"SVCmd_WriteIP_f", (byte *)SVCmd_WriteIP_f},
@@ -1420,6 +1570,8 @@
 {"SwitchToBestStartWeapon", (byte *)SwitchToBestStartWeapon},
 {"Sys_Error", (byte *)Sys_Error},
 {"T_Damage", (byte *)T_Damage},
+{"T_DamageBatchBegin", (byte *)T_DamageBatchBegin},
+{"T_DamageBatchEnd", (byte *)T_DamageBatchEnd},
 {"T_RadiusDamage", (byte *)T_RadiusDamage},
 {"tank_attack", (byte *)tank_attack},
 {"tank_dead", (byte *)tank_dead},
@@ -1491,9 +1643,15 @@
 {"target_precipitation_delayed_use", (byte *)target_precipitation_delayed_use},
 {"target_precipitation_think", (byte *)target_precipitation_think},
 {"target_precipitation_use", (byte *)target_precipitation_use},
+{"target_string_initgame", (byte *)target_string_initgame},
+{"target_string_reset", (byte *)target_string_reset},
 {"target_string_use", (byte *)target_string_use},
 {"TechCount", (byte *)TechCount},
 {"TechThink", (byte *)TechThink},
+{"Tel_BeginFrame", (byte *)Tel_BeginFrame},
+{"Tel_CountSave", (byte *)Tel_CountSave},
+{"Tel_EndFrame", (byte *)Tel_EndFrame},
+{"Tel_Shutdown", (byte *)Tel_Shutdown},
 {"teleport_transition_ents", (byte *)teleport_transition_ents},
 {"teleporter_touch", (byte *)teleporter_touch},
 {"Text_BuildDisplay", (byte *)Text_BuildDisplay},
@@ -1501,9 +1659,11 @@
 {"Text_Next", (byte *)Text_Next},
 {"Text_Open", (byte *)Text_Open},
 {"Text_Prev", (byte *)Text_Prev},
+{"Text_ResetCache", (byte *)Text_ResetCache},
 {"Text_Update", (byte *)Text_Update},
 {"TH_viewthing", (byte *)TH_viewthing},
 {"thing_grenade_boom", (byte *)thing_grenade_boom},
+{"thing_pool_reset", (byte *)thing_pool_reset},
 {"thing_restore_leader", (byte *)thing_restore_leader},
 {"thing_think_pause", (byte *)thing_think_pause},
 {"thing_think", (byte *)thing_think},
@@ -1607,10 +1767,12 @@
 {"turret_driver_die", (byte *)turret_driver_die},
 {"turret_driver_link", (byte *)turret_driver_link},
 {"turret_driver_think", (byte *)turret_driver_think},
+{"turret_reset_targets", (byte *)turret_reset_targets},
 {"turret_turn", (byte *)turret_turn},
 {"TurretTarget", (byte *)TurretTarget},
 {"tv", (byte *)tv},
 {"UpdateChaseCam", (byte *)UpdateChaseCam},
+{"UpdateReflectGrid", (byte *)UpdateReflectGrid},
 {"Use_Areaportal", (byte *)Use_Areaportal},
 {"Use_Boss3", (byte *)Use_Boss3},
 {"Use_Breather", (byte *)Use_Breather},
@@ -1696,6 +1858,7 @@
 {"Weapon_HomingMissileLauncher", (byte *)Weapon_HomingMissileLauncher},
 {"Weapon_HyperBlaster_Fire", (byte *)Weapon_HyperBlaster_Fire},
 {"Weapon_HyperBlaster", (byte *)Weapon_HyperBlaster},
+{"Weapon_InitFrames", (byte *)Weapon_InitFrames},
 {"Weapon_Machinegun", (byte *)Weapon_Machinegun},
 {"Weapon_Null", (byte *)Weapon_Null},
 {"weapon_railgun_fire", (byte *)weapon_railgun_fire},
@@ -1710,11 +1873,11 @@
 {"WhatIsIt", (byte *)WhatIsIt},
 {"WhatsIt", (byte *)WhatsIt},
 {"WriteClient", (byte *)WriteClient},
-{"WriteEdict", (byte *)WriteEdict},
 {"WriteField1", (byte *)WriteField1},
 {"WriteField2", (byte *)WriteField2},
 {"WriteGame", (byte *)WriteGame},
 {"WriteLevel", (byte *)WriteLevel},
 {"WriteLevelLocals", (byte *)WriteLevelLocals},
 {"WriteTransitionEdict", (byte *)WriteTransitionEdict},
+{"WriteTransitionImage", (byte *)WriteTransitionImage},
 {0, 0}